@@ -0,0 +1,68 @@
+/**
+ * Bounding volumes store axis aligned bounding boxes as structure of arrays of centers and half
+ * extents, so that many of them can be culled against a frustum at once.
+ *
+ * Culling writes a visibility bitset with one bit per volume, which is set unless the volume lies
+ * entirely outside one of the frustum planes. The test is conservative: boxes near frustum corners
+ * can be reported visible even though they don't intersect the frustum. On SSE2 and NEON targets,
+ * four volumes are tested per iteration.
+ */
+
+#ifndef SHOVELER_BOUNDING_VOLUMES_H
+#define SHOVELER_BOUNDING_VOLUMES_H
+
+#include <glib.h>
+#include <shoveler/frustum.h>
+#include <shoveler/types.h>
+#include <stdbool.h> // bool
+
+/** Half extent of volumes that should never be culled, such as unbounded or screenspace ones. */
+#define SHOVELER_BOUNDING_VOLUMES_UNBOUNDED_EXTENT 1e30f
+
+typedef struct {
+  /* private */ float* centerX;
+  /* private */ float* centerY;
+  /* private */ float* centerZ;
+  /* private */ float* extentX;
+  /* private */ float* extentY;
+  /* private */ float* extentZ;
+  guint size;
+  /* private */ guint capacity;
+} ShovelerBoundingVolumes;
+
+ShovelerBoundingVolumes* shovelerBoundingVolumesCreate();
+/** Adds a volume for the passed box, returning its index. */
+guint shovelerBoundingVolumesAdd(ShovelerBoundingVolumes* volumes, ShovelerBoundingBox3 box);
+void shovelerBoundingVolumesUpdate(
+    ShovelerBoundingVolumes* volumes, guint index, ShovelerBoundingBox3 box);
+/** Removes all volumes, keeping the allocated storage. */
+void shovelerBoundingVolumesClear(ShovelerBoundingVolumes* volumes);
+/**
+ * Culls all volumes against the frustum, writing their visibility to the passed bitset, which must
+ * hold at least shovelerBoundingVolumesGetNumVisibilityWords(volumes->size) words.
+ */
+void shovelerBoundingVolumesCullFrustum(
+    const ShovelerBoundingVolumes* volumes, const ShovelerFrustum* frustum, guint32* visibility);
+void shovelerBoundingVolumesFree(ShovelerBoundingVolumes* volumes);
+
+static inline guint shovelerBoundingVolumesGetNumVisibilityWords(guint size) {
+  return (size + 31) / 32;
+}
+
+static inline bool shovelerBoundingVolumesIsVisible(const guint32* visibility, guint index) {
+  return (visibility[index / 32] >> (index % 32)) & 1;
+}
+
+static inline ShovelerBoundingBox3 shovelerBoundingVolumesUnboundedBox() {
+  return shovelerBoundingBox3(
+      shovelerVector3(
+          -SHOVELER_BOUNDING_VOLUMES_UNBOUNDED_EXTENT,
+          -SHOVELER_BOUNDING_VOLUMES_UNBOUNDED_EXTENT,
+          -SHOVELER_BOUNDING_VOLUMES_UNBOUNDED_EXTENT),
+      shovelerVector3(
+          SHOVELER_BOUNDING_VOLUMES_UNBOUNDED_EXTENT,
+          SHOVELER_BOUNDING_VOLUMES_UNBOUNDED_EXTENT,
+          SHOVELER_BOUNDING_VOLUMES_UNBOUNDED_EXTENT));
+}
+
+#endif
@@ -24,15 +24,54 @@ typedef const ShovelerCollider3*(ShovelerCollider3IntersectFunction)(
     ShovelerCollider3FilterCandidateFunction* filterCandidate,
     void* filterCandidateUserData);
 
+/** Result of sweeping a moving bounding box against a collider. */
+typedef struct {
+  const ShovelerCollider2* collider;
+  /** fraction of the displacement in [0, 1] after which the moving object first touches */
+  float time;
+  /** unit contact normal pointing towards the moving object, zero if it was overlapping at start */
+  ShovelerVector2 normal;
+} ShovelerCollider2Contact;
+
+typedef struct {
+  const ShovelerCollider3* collider;
+  /** fraction of the displacement in [0, 1] after which the moving object first touches */
+  float time;
+  /** unit contact normal pointing towards the moving object, zero if it was overlapping at start */
+  ShovelerVector3 normal;
+} ShovelerCollider3Contact;
+
+/** Sweeps an object along a displacement against a collider whose bounding box overlaps the swept
+ * region, returning whether there is a contact and writing the earliest one to the output. If
+ * there are several, contacts with a normal are preferred, see shovelerCollider2ContactPrecedes. */
+typedef bool(ShovelerCollider2SweepFunction)(
+    const ShovelerCollider2* collider,
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    ShovelerCollider2FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider2Contact* outputContact);
+typedef bool(ShovelerCollider3SweepFunction)(
+    const ShovelerCollider3* collider,
+    const ShovelerBoundingBox3* object,
+    ShovelerVector3 displacement,
+    ShovelerCollider3FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider3Contact* outputContact);
+
 typedef struct ShovelerCollider2Struct {
   ShovelerBoundingBox2 boundingBox;
   ShovelerCollider2IntersectFunction* intersect;
+  /** If NULL, colliders with an intersect function are only checked at the end of the sweep. */
+  ShovelerCollider2SweepFunction* sweep;
   void* data;
 } ShovelerCollider2;
 
 typedef struct ShovelerCollider3Struct {
   ShovelerBoundingBox3 boundingBox;
   ShovelerCollider3IntersectFunction* intersect;
+  /** If NULL, colliders with an intersect function are only checked at the end of the sweep. */
+  ShovelerCollider3SweepFunction* sweep;
   void* data;
 } ShovelerCollider3;
 
@@ -47,6 +86,88 @@ const ShovelerCollider3* shovelerCollider3IntersectFiltered(
     ShovelerCollider3FilterCandidateFunction* filterCandidate,
     void* filterCandidateUserData);
 
+bool shovelerCollider2SweepFiltered(
+    const ShovelerCollider2* collider,
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    ShovelerCollider2FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider2Contact* outputContact);
+bool shovelerCollider3SweepFiltered(
+    const ShovelerCollider3* collider,
+    const ShovelerBoundingBox3* object,
+    ShovelerVector3 displacement,
+    ShovelerCollider3FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider3Contact* outputContact);
+/** Computes the time of impact and contact normal of a box moving along a displacement against a
+ * static obstacle box, returning false if they don't touch within the displacement. */
+bool shovelerBoundingBox2Sweep(
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    const ShovelerBoundingBox2* obstacle,
+    float* outputTime,
+    ShovelerVector2* outputNormal);
+bool shovelerBoundingBox3Sweep(
+    const ShovelerBoundingBox3* object,
+    ShovelerVector3 displacement,
+    const ShovelerBoundingBox3* obstacle,
+    float* outputTime,
+    ShovelerVector3* outputNormal);
+
+static inline ShovelerBoundingBox2 shovelerBoundingBox2Swept(
+    const ShovelerBoundingBox2* object, ShovelerVector2 displacement) {
+  ShovelerBoundingBox2 swept = *object;
+  for (int i = 0; i < 2; i++) {
+    if (displacement.values[i] < 0.0f) {
+      swept.min.values[i] += displacement.values[i];
+    } else {
+      swept.max.values[i] += displacement.values[i];
+    }
+  }
+  return swept;
+}
+
+static inline ShovelerBoundingBox3 shovelerBoundingBox3Swept(
+    const ShovelerBoundingBox3* object, ShovelerVector3 displacement) {
+  ShovelerBoundingBox3 swept = *object;
+  for (int i = 0; i < 3; i++) {
+    if (displacement.values[i] < 0.0f) {
+      swept.min.values[i] += displacement.values[i];
+    } else {
+      swept.max.values[i] += displacement.values[i];
+    }
+  }
+  return swept;
+}
+
+/**
+ * Returns whether a sweep contact given by its time and normal takes precedence over another one.
+ * Contacts with a normal come first, since an overlap without a normal is reported at time 0 and
+ * would otherwise hide a real contact further along the sweep. Otherwise the earlier one wins.
+ */
+static inline bool shovelerCollider2ContactPrecedes(
+    float time, ShovelerVector2 normal, float otherTime, ShovelerVector2 otherNormal) {
+  bool hasNormal = normal.values[0] != 0.0f || normal.values[1] != 0.0f;
+  bool otherHasNormal = otherNormal.values[0] != 0.0f || otherNormal.values[1] != 0.0f;
+  if (hasNormal != otherHasNormal) {
+    return hasNormal;
+  }
+  return time < otherTime;
+}
+
+static inline bool shovelerCollider3ContactPrecedes(
+    float time, ShovelerVector3 normal, float otherTime, ShovelerVector3 otherNormal) {
+  bool hasNormal =
+      normal.values[0] != 0.0f || normal.values[1] != 0.0f || normal.values[2] != 0.0f;
+  bool otherHasNormal = otherNormal.values[0] != 0.0f || otherNormal.values[1] != 0.0f ||
+      otherNormal.values[2] != 0.0f;
+  if (hasNormal != otherHasNormal) {
+    return hasNormal;
+  }
+  return time < otherTime;
+}
+
 static inline const ShovelerCollider2* shovelerCollider2Intersect(
     const ShovelerCollider2* collider, const ShovelerBoundingBox2* object) {
   return shovelerCollider2IntersectFiltered(
@@ -59,4 +180,32 @@ static inline const ShovelerCollider3* shovelerCollider3Intersect(
       collider, object, /* filterCandidate */ NULL, /* filterCandidateUserData */ NULL);
 }
 
+static inline bool shovelerCollider2Sweep(
+    const ShovelerCollider2* collider,
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    ShovelerCollider2Contact* outputContact) {
+  return shovelerCollider2SweepFiltered(
+      collider,
+      object,
+      displacement,
+      /* filterCandidate */ NULL,
+      /* filterCandidateUserData */ NULL,
+      outputContact);
+}
+
+static inline bool shovelerCollider3Sweep(
+    const ShovelerCollider3* collider,
+    const ShovelerBoundingBox3* object,
+    ShovelerVector3 displacement,
+    ShovelerCollider3Contact* outputContact) {
+  return shovelerCollider3SweepFiltered(
+      collider,
+      object,
+      displacement,
+      /* filterCandidate */ NULL,
+      /* filterCandidateUserData */ NULL,
+      outputContact);
+}
+
 #endif
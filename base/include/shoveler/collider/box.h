@@ -9,6 +9,7 @@ static inline ShovelerCollider2 shovelerColliderBox2(ShovelerBoundingBox2 boundi
   collider.boundingBox = boundingBox;
   collider.data = NULL;
   collider.intersect = NULL;
+  collider.sweep = NULL;
 
   return collider;
 }
@@ -18,6 +19,7 @@ static inline ShovelerCollider3 shovelerColliderBox3(ShovelerBoundingBox3 boundi
   collider.boundingBox = boundingBox;
   collider.data = NULL;
   collider.intersect = NULL;
+  collider.sweep = NULL;
 
   return collider;
 }
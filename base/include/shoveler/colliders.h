@@ -1,3 +1,17 @@
+/**
+ * Colliders maintain a dynamic broadphase over all added colliders so that intersection queries
+ * only need to run narrowphase checks against colliders close to the query.
+ *
+ * 2d colliders are stored in a sparse uniform grid keyed by cell coordinates, where each collider
+ * is referenced from every cell its bounding box overlaps. 3d colliders are kept in a
+ * sweep-and-prune array sorted by the minimum x coordinate of their bounding box. Colliders whose
+ * bounding boxes are not finite or would span too many grid cells (e.g. canvases covering the
+ * whole world) are kept in a separate unbounded list that is checked on every query.
+ *
+ * Since the broadphase caches bounding boxes, changes to the bounding box of an added collider
+ * must be announced using shovelerCollidersUpdateCollider2 or shovelerCollidersUpdateCollider3.
+ */
+
 #ifndef SHOVELER_COLLIDERS_H
 #define SHOVELER_COLLIDERS_H
 
@@ -5,34 +19,133 @@
 #include <shoveler/collider.h>
 #include <shoveler/types.h>
 
+#define SHOVELER_COLLIDERS_DEFAULT_CELL_SIZE 1.0f
+#define SHOVELER_COLLIDERS_MAX_CELLS_PER_COLLIDER 256
+#define SHOVELER_COLLIDERS_MAX_CELLS_PER_QUERY 4096
+
+typedef struct ShovelerCollidersEntry2Struct {
+  ShovelerCollider2* collider;
+  /** whether the collider is stored in the unbounded list instead of the grid */
+  bool unbounded;
+  /** inclusive range of grid cells the collider is referenced from if not unbounded */
+  int minCellX;
+  int minCellY;
+  int maxCellX;
+  int maxCellY;
+  /** id of the last query that visited this entry, used to deduplicate across cells */
+  unsigned int lastQueryId;
+} ShovelerCollidersEntry2;
+
+typedef struct ShovelerCollidersCell2Struct {
+  gint64 key;
+  /** list of (ShovelerCollidersEntry2 *) */
+  GQueue* entries;
+} ShovelerCollidersCell2;
+
+typedef struct ShovelerCollidersEntry3Struct {
+  ShovelerCollider3* collider;
+  /** whether the collider is stored in the unbounded list instead of the sweep array */
+  bool unbounded;
+  /** bounding box at the time the collider was last indexed */
+  ShovelerBoundingBox3 indexedBoundingBox;
+} ShovelerCollidersEntry3;
+
 typedef struct ShovelerCollidersStruct {
-  /** Hash set of (ShovelerCollider2 *) */
+  float cellSize2;
+  unsigned int queryId;
+  /** map from (ShovelerCollider2 *) to (ShovelerCollidersEntry2 *) */
   /* private */ GHashTable* colliders2;
-  /** Hash set of (ShovelerCollider3 *) */
+  /** map from cell key to (ShovelerCollidersCell2 *) */
+  /* private */ GHashTable* cells2;
+  /** list of (ShovelerCollidersEntry2 *) */
+  /* private */ GQueue* unboundedColliders2;
+  /** map from (ShovelerCollider3 *) to (ShovelerCollidersEntry3 *) */
   /* private */ GHashTable* colliders3;
+  /** array of (ShovelerCollidersEntry3 *) sorted by the minimum x coordinate */
+  /* private */ GArray* sweepColliders3;
+  /** upper bound for the x extent of all colliders in the sweep array */
+  /* private */ float maxSweepExtent3;
+  /* private */ bool maxSweepExtent3Dirty;
+  /** list of (ShovelerCollidersEntry3 *) */
+  /* private */ GQueue* unboundedColliders3;
 } ShovelerColliders;
 
+/** Creates colliders using a 2d grid with the default cell size. */
 ShovelerColliders* shovelerCollidersCreate();
-/** Adds a 2d collider to the colliders, with the caller retaining ownership over it and changes to
- * it being reflected live. */
+/** Creates colliders using a 2d grid with the given cell size, which should roughly match the size
+ * of typical colliders and queries. */
+ShovelerColliders* shovelerCollidersCreateWithCellSize(float cellSize2);
+/** Adds a 2d collider to the colliders, with the caller retaining ownership over it. Its bounding
+ * box is indexed once here, so changes to it aren't picked up by queries until they are announced
+ * with shovelerCollidersUpdateCollider2. */
 bool shovelerCollidersAddCollider2(ShovelerColliders* colliders, ShovelerCollider2* collider);
-/** Adds a 3d collider to the colliders, with the caller retaining ownership over it and changes to
- * it being reflected live. */
+/** Adds a 3d collider to the colliders, with the caller retaining ownership over it. Its bounding
+ * box is indexed once here, so changes to it aren't picked up by queries until they are announced
+ * with shovelerCollidersUpdateCollider3. */
 bool shovelerCollidersAddCollider3(ShovelerColliders* colliders, ShovelerCollider3* collider);
+/** Reindexes a previously added 2d collider after its bounding box has changed. Until then,
+ * queries still find it at its previously indexed bounding box. */
+bool shovelerCollidersUpdateCollider2(ShovelerColliders* colliders, ShovelerCollider2* collider);
+/** Reindexes a previously added 3d collider after its bounding box has changed. Until then,
+ * queries still find it at its previously indexed bounding box. */
+bool shovelerCollidersUpdateCollider3(ShovelerColliders* colliders, ShovelerCollider3* collider);
 bool shovelerCollidersRemoveCollider2(ShovelerColliders* colliders, ShovelerCollider2* collider);
 bool shovelerCollidersRemoveCollider3(ShovelerColliders* colliders, ShovelerCollider3* collider);
-/** Intersects a 2d bounding box with colliders, returning the first intersecting collider. */
+/** Intersects a 2d bounding box with colliders, returning the first intersecting collider. Only
+ * candidates found at their last added or updated bounding box are checked. */
 const ShovelerCollider2* shovelerCollidersIntersect2Filtered(
     ShovelerColliders* colliders,
     const ShovelerBoundingBox2* boundingBox,
     ShovelerCollider2FilterCandidateFunction* filterCandidate,
     void* filterCandidateUserData);
-/** Intersects a 3d bounding box with colliders, returning the first intersecting collider. */
+/** Intersects a 3d bounding box with colliders, returning the first intersecting collider. Only
+ * candidates found at their last added or updated bounding box are checked. */
 const ShovelerCollider3* shovelerCollidersIntersect3Filtered(
     ShovelerColliders* colliders,
     const ShovelerBoundingBox3* boundingBox,
     ShovelerCollider3FilterCandidateFunction* filterCandidate,
     void* filterCandidateUserData);
+/** Intersects a 2d bounding box with colliders, writing all intersecting colliders into the given
+ * array of (const ShovelerCollider2 *). Like shovelerCollidersIntersect2Filtered, this doesn't see
+ * bounding box changes that weren't announced yet. */
+void shovelerCollidersIntersectAll2Filtered(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox2* boundingBox,
+    ShovelerCollider2FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    GArray* outputArray);
+/** Intersects a 3d bounding box with colliders, writing all intersecting colliders into the given
+ * array of (const ShovelerCollider3 *). Like shovelerCollidersIntersect3Filtered, this doesn't see
+ * bounding box changes that weren't announced yet. */
+void shovelerCollidersIntersectAll3Filtered(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox3* boundingBox,
+    ShovelerCollider3FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    GArray* outputArray);
+/** Sweeps a 2d bounding box along the given displacement, writing the earliest contact with any
+ * collider and returning whether there was one. All candidates are gathered in a single broadphase
+ * pass over the swept region, so fast movers can't tunnel through thin colliders. Overlaps without
+ * a normal are only reported if there is no contact with a normal. Colliders that moved without
+ * being updated are gathered at their previously indexed bounding box. */
+bool shovelerCollidersSweep2Filtered(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    ShovelerCollider2FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider2Contact* outputContact);
+/** Sweeps a 3d bounding box along the given displacement, writing the earliest contact with any
+ * collider and returning whether there was one. Overlaps without a normal are only reported if
+ * there is no contact with a normal. Colliders that moved without being updated are gathered at
+ * their previously indexed bounding box. */
+bool shovelerCollidersSweep3Filtered(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox3* object,
+    ShovelerVector3 displacement,
+    ShovelerCollider3FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider3Contact* outputContact);
 void shovelerCollidersFree(ShovelerColliders* colliders);
 
 static inline const ShovelerCollider2* shovelerCollidersIntersect2(
@@ -47,4 +160,52 @@ static inline const ShovelerCollider3* shovelerCollidersIntersect3(
       colliders, boundingBox, /* filterCandidate */ NULL, /* filterCandidateUserData */ NULL);
 }
 
+static inline void shovelerCollidersIntersectAll2(
+    ShovelerColliders* colliders, const ShovelerBoundingBox2* boundingBox, GArray* outputArray) {
+  shovelerCollidersIntersectAll2Filtered(
+      colliders,
+      boundingBox,
+      /* filterCandidate */ NULL,
+      /* filterCandidateUserData */ NULL,
+      outputArray);
+}
+
+static inline void shovelerCollidersIntersectAll3(
+    ShovelerColliders* colliders, const ShovelerBoundingBox3* boundingBox, GArray* outputArray) {
+  shovelerCollidersIntersectAll3Filtered(
+      colliders,
+      boundingBox,
+      /* filterCandidate */ NULL,
+      /* filterCandidateUserData */ NULL,
+      outputArray);
+}
+
+static inline bool shovelerCollidersSweep2(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    ShovelerCollider2Contact* outputContact) {
+  return shovelerCollidersSweep2Filtered(
+      colliders,
+      object,
+      displacement,
+      /* filterCandidate */ NULL,
+      /* filterCandidateUserData */ NULL,
+      outputContact);
+}
+
+static inline bool shovelerCollidersSweep3(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox3* object,
+    ShovelerVector3 displacement,
+    ShovelerCollider3Contact* outputContact) {
+  return shovelerCollidersSweep3Filtered(
+      colliders,
+      object,
+      displacement,
+      /* filterCandidate */ NULL,
+      /* filterCandidateUserData */ NULL,
+      outputContact);
+}
+
 #endif
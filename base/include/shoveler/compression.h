@@ -1,8 +1,20 @@
+/**
+ * Compression of buffers using zlib, either as one-off calls or through reusable contexts.
+ *
+ * A compression context keeps its deflate stream and output buffer alive across calls, so that
+ * compressing many small buffers doesn't pay for stream setup and allocations each time. Input can
+ * be fed incrementally and flushed at message boundaries, with the shared history window letting
+ * later messages reference earlier ones. An optional dictionary preset primes that window for the
+ * first message, and must match between the compressing and decompressing side.
+ */
+
 #ifndef SHOVELER_COMPRESSION_H
 #define SHOVELER_COMPRESSION_H
 
+#include <glib.h>
 #include <stdbool.h> // bool
 #include <stddef.h> // size_t
+#include <zlib.h> // z_stream
 
 typedef enum {
   SHOVELER_COMPRESSION_FORMAT_DEFLATE,
@@ -10,6 +22,30 @@ typedef enum {
   SHOVELER_COMPRESSION_FORMAT_GZIP
 } ShovelerCompressionFormat;
 
+typedef struct ShovelerCompressionContextStruct {
+  ShovelerCompressionFormat format;
+  /** zlib compression level between 0 and 9, or Z_DEFAULT_COMPRESSION */
+  int level;
+  /** compressed data produced so far, to be consumed and cleared by the caller */
+  GString* output;
+  /** dictionary preset applied whenever the stream starts, or NULL */
+  GString* dictionary;
+  /* private */ z_stream stream;
+  /** whether the stream was finished and must be reset before more input is fed */
+  /* private */ bool finished;
+} ShovelerCompressionContext;
+
+typedef struct ShovelerDecompressionContextStruct {
+  ShovelerCompressionFormat format;
+  /** decompressed data produced so far, to be consumed and cleared by the caller */
+  GString* output;
+  /** dictionary preset the compressing side used, or NULL */
+  GString* dictionary;
+  /* private */ z_stream stream;
+  /** whether the end of the stream was reached */
+  /* private */ bool finished;
+} ShovelerDecompressionContext;
+
 bool shovelerCompressionCompress(
     ShovelerCompressionFormat format,
     const unsigned char* input,
@@ -23,4 +59,44 @@ bool shovelerCompressionDecompress(
     unsigned char** outputPointer,
     size_t* outputSizePointer);
 
+ShovelerCompressionContext* shovelerCompressionContextCreate(
+    ShovelerCompressionFormat format, int level);
+/** Sets the dictionary preset and resets the stream, which is not supported for gzip. */
+bool shovelerCompressionContextSetDictionary(
+    ShovelerCompressionContext* context, const unsigned char* dictionary, size_t dictionarySize);
+/** Changes the compression level for input fed from now on, keeping the history. */
+bool shovelerCompressionContextSetLevel(ShovelerCompressionContext* context, int level);
+/** Compresses input into the output buffer, which might hold it back until the next flush. */
+bool shovelerCompressionContextFeed(
+    ShovelerCompressionContext* context, const unsigned char* input, size_t inputSize);
+/** Flushes all input fed so far to the output buffer on a byte boundary, keeping the history. */
+bool shovelerCompressionContextFlush(ShovelerCompressionContext* context);
+/** Finishes the stream, after which the next feed starts a new one. */
+bool shovelerCompressionContextFinish(ShovelerCompressionContext* context);
+/** Compresses input as a complete stream, replacing the contents of the output buffer. */
+bool shovelerCompressionContextCompress(
+    ShovelerCompressionContext* context, const unsigned char* input, size_t inputSize);
+/** Discards the stream state and starts a new stream, keeping the output buffer. */
+bool shovelerCompressionContextReset(ShovelerCompressionContext* context);
+void shovelerCompressionContextFree(ShovelerCompressionContext* context);
+
+ShovelerDecompressionContext* shovelerDecompressionContextCreate(ShovelerCompressionFormat format);
+/** Sets the dictionary preset and resets the stream, which is not supported for gzip. */
+bool shovelerDecompressionContextSetDictionary(
+    ShovelerDecompressionContext* context, const unsigned char* dictionary, size_t dictionarySize);
+/** Decompresses input into the output buffer, starting a new stream if the previous one ended. */
+bool shovelerDecompressionContextFeed(
+    ShovelerDecompressionContext* context, const unsigned char* input, size_t inputSize);
+/** Discards the stream state and starts a new stream, keeping the output buffer. */
+bool shovelerDecompressionContextReset(ShovelerDecompressionContext* context);
+void shovelerDecompressionContextFree(ShovelerDecompressionContext* context);
+
+static inline void shovelerCompressionContextClearOutput(ShovelerCompressionContext* context) {
+  g_string_truncate(context->output, 0);
+}
+
+static inline void shovelerDecompressionContextClearOutput(ShovelerDecompressionContext* context) {
+  g_string_truncate(context->output, 0);
+}
+
 #endif
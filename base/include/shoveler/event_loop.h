@@ -1,26 +1,94 @@
+/**
+ * The event loop runs a tick function at a fixed rate.
+ *
+ * Ticks are scheduled on an absolute timeline, so that time lost to late wakeups is compensated
+ * on the following ticks instead of accumulating as drift. The tick function and the executor are
+ * passed the scheduled time between ticks rather than the measured wall time, which keeps
+ * simulations deterministic regardless of scheduling jitter.
+ *
+ * Between ticks, the loop sleeps until the next tick is due. Sleeps usually overshoot by up to a
+ * scheduler time slice, so callers that need precise tick starts can opt into spinning with
+ * shovelerEventLoopSetSpinThreshold. The loop then sleeps until spinThresholdUs before the next
+ * tick and busy waits for the rest, which keeps a core fully busy for that long on every tick. This
+ * is off by default since it wastes CPU time on servers running many loops and battery on clients.
+ * If a tick overruns by more than a full period, the loop either skips the missed ticks or runs
+ * them back to back in a burst, depending on its catch-up policy.
+ */
+
 #ifndef SHOVELER_EVENT_LOOP_H
 #define SHOVELER_EVENT_LOOP_H
 
 #include <glib.h>
 
+/** Default time before a tick is due from which the loop spins instead of sleeping, i.e. never. */
+#define SHOVELER_EVENT_LOOP_DEFAULT_SPIN_THRESHOLD_US 0
+/** Default maximum number of missed ticks run back to back with the burst catch-up policy. */
+#define SHOVELER_EVENT_LOOP_DEFAULT_MAX_BURST_TICKS 5
+
 typedef struct ShovelerEventLoopStruct ShovelerEventLoop;
 typedef struct ShovelerExecutorStruct ShovelerExecutor;
 
 typedef void(ShovelerEventLoopTickFunction)(
     ShovelerEventLoop* eventLoop, gint64 dtUs, void* userData);
 
+typedef enum {
+  /** drop missed ticks, passing their time to the next tick's dt */
+  SHOVELER_EVENT_LOOP_CATCH_UP_SKIP,
+  /** run missed ticks without waiting, up to maxBurstTicks, and skip the rest */
+  SHOVELER_EVENT_LOOP_CATCH_UP_BURST,
+} ShovelerEventLoopCatchUpPolicy;
+
+typedef struct ShovelerEventLoopStatsStruct {
+  gint64 numTicks;
+  gint64 numSkippedTicks;
+  gint64 numBurstTicks;
+  /** time spent in the tick function and executor */
+  gint64 minTickTimeUs;
+  gint64 maxTickTimeUs;
+  gint64 totalTickTimeUs;
+  /** difference between the scheduled and the actual start of a tick */
+  gint64 maxJitterUs;
+  gint64 totalJitterUs;
+} ShovelerEventLoopStats;
+
 typedef struct ShovelerEventLoopStruct {
   ShovelerExecutor* executor;
   gint64 tickPeriodUs;
   ShovelerEventLoopTickFunction* tick;
   void* userData;
-  gint64 tickStartTime;
+  gint64 spinThresholdUs;
+  ShovelerEventLoopCatchUpPolicy catchUpPolicy;
+  int maxBurstTicks;
+  ShovelerEventLoopStats stats;
+  /** scheduled start time of the previous tick */
   gint64 lastTickTime;
+  /** scheduled start time of the next tick */
+  gint64 nextTickTime;
+  /** number of upcoming ticks that are part of a burst */
+  /* private */ int remainingBurstTicks;
 } ShovelerEventLoop;
 
 ShovelerEventLoop* shovelerEventLoopCreate(
     gint64 tickRateHz, ShovelerEventLoopTickFunction* tick, void* userData);
+/**
+ * Sets the time before a tick is due from which the loop spins, or zero to only sleep. Around a
+ * millisecond is usually enough to hide sleep overshoot, and burns as much CPU time per tick.
+ */
+void shovelerEventLoopSetSpinThreshold(ShovelerEventLoop* eventLoop, gint64 spinThresholdUs);
+void shovelerEventLoopSetCatchUpPolicy(
+    ShovelerEventLoop* eventLoop, ShovelerEventLoopCatchUpPolicy catchUpPolicy, int maxBurstTicks);
+/** Runs a single tick and then waits until the next one is due. */
 void shovelerEventLoopTick(ShovelerEventLoop* eventLoop);
+void shovelerEventLoopResetStats(ShovelerEventLoop* eventLoop);
+void shovelerEventLoopLogStats(ShovelerEventLoop* eventLoop);
 void shovelerEventLoopFree(ShovelerEventLoop* eventLoop);
 
+static inline double shovelerEventLoopStatsGetMeanTickTimeUs(const ShovelerEventLoopStats* stats) {
+  return stats->numTicks > 0 ? (double) stats->totalTickTimeUs / stats->numTicks : 0.0;
+}
+
+static inline double shovelerEventLoopStatsGetMeanJitterUs(const ShovelerEventLoopStats* stats) {
+  return stats->numTicks > 0 ? (double) stats->totalJitterUs / stats->numTicks : 0.0;
+}
+
 #endif
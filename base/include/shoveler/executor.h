@@ -1,25 +1,133 @@
+/**
+ * The executor runs callbacks after a timeout, optionally repeating them periodically.
+ *
+ * Scheduled callbacks are kept in a hierarchical timing wheel with millisecond ticks, so that
+ * scheduling, removal and expiry are constant time regardless of how many callbacks are scheduled.
+ * Each level of the wheel covers SHOVELER_EXECUTOR_WHEEL_SLOTS times the range of the level below,
+ * and callbacks cascade down a level whenever the level below wraps around. Callbacks due in the
+ * same update are run ordered by expiry, and by scheduling order for equal expiries.
+ *
+ * Callbacks are allocated from a pool owned by the executor, so a callback pointer must not be used
+ * after the callback was removed or, for callbacks without an interval, after it ran.
+ *
+ * Jobs can be submitted to run heavy work off the main thread. A thread pool executor runs them on
+ * worker threads, each with its own job queue that idle workers steal from. Finished jobs are
+ * pushed onto a lock-free completion stack, and their completion callbacks are run by the next
+ * shovelerExecutorUpdate, so that they can safely touch state owned by the updating thread. A
+ * direct executor runs submitted jobs inline during the next update instead.
+ */
+
 #ifndef SHOVELER_EXECUTOR_H
 #define SHOVELER_EXECUTOR_H
 
 #include <glib.h>
 #include <stdbool.h> // bool
 
+#define SHOVELER_EXECUTOR_WHEEL_LEVELS 4
+#define SHOVELER_EXECUTOR_WHEEL_SLOT_BITS 8
+#define SHOVELER_EXECUTOR_WHEEL_SLOTS (1 << SHOVELER_EXECUTOR_WHEEL_SLOT_BITS)
+#define SHOVELER_EXECUTOR_CALLBACK_BLOCK_SIZE 256
+
 typedef void(ShovelerExecutorCallbackFunction)(void* userData);
 
+typedef struct ShovelerExecutorJobStruct ShovelerExecutorJob; // forward declaration: below
+/** Runs the work of a job, on a worker thread for thread pool executors. Long running jobs should
+ * regularly check shovelerExecutorJobIsCancelled and return early. */
+typedef void(ShovelerExecutorJobFunction)(ShovelerExecutorJob* job, void* userData);
+/** Runs on the updating thread after a job has finished or was cancelled before it started. */
+typedef void(ShovelerExecutorJobCompleteFunction)(
+    ShovelerExecutorJob* job, bool cancelled, void* userData);
+
+typedef enum {
+  SHOVELER_EXECUTOR_CALLBACK_STATE_FREE,
+  SHOVELER_EXECUTOR_CALLBACK_STATE_SCHEDULED,
+  /** collected to run in the current update */
+  SHOVELER_EXECUTOR_CALLBACK_STATE_DUE,
+  /** removed while due in the current update, released once the update is done */
+  SHOVELER_EXECUTOR_CALLBACK_STATE_CANCELLED,
+} ShovelerExecutorCallbackState;
+
 typedef struct ShovelerExecutorCallbackStruct {
   gint64 expiry;
   int intervalMs;
   ShovelerExecutorCallbackFunction* callbackFunction;
   void* userData;
+  /* private */ ShovelerExecutorCallbackState state;
+  /** scheduling order, used to run callbacks with equal expiry deterministically */
+  /* private */ guint64 sequence;
+  /** head of the wheel slot list the callback is linked into while scheduled */
+  /* private */ struct ShovelerExecutorCallbackStruct** slot;
+  /* private */ struct ShovelerExecutorCallbackStruct* previous;
+  /** also links free callbacks in the pool */
+  /* private */ struct ShovelerExecutorCallbackStruct* next;
 } ShovelerExecutorCallback;
 
+typedef struct ShovelerExecutorJobStruct {
+  ShovelerExecutorJobFunction* run;
+  ShovelerExecutorJobCompleteFunction* complete;
+  void* userData;
+  /** cancellation token, set from the updating thread and polled by the job */
+  volatile gint cancelled;
+  /** links the job into the completion stack */
+  /* private */ struct ShovelerExecutorJobStruct* nextCompleted;
+} ShovelerExecutorJob;
+
+typedef struct ShovelerExecutorWorkerStruct {
+  struct ShovelerExecutorThreadPoolStruct* threadPool;
+  GThread* thread;
+  /** protects jobs, which is also accessed by stealing workers */
+  GMutex mutex;
+  /** queue of (ShovelerExecutorJob *), popped from the head and stolen from the tail */
+  GQueue* jobs;
+} ShovelerExecutorWorker;
+
+typedef struct ShovelerExecutorThreadPoolStruct {
+  int numWorkers;
+  /** array of size numWorkers */
+  ShovelerExecutorWorker* workers;
+  /** index of the worker the next job is submitted to */
+  int nextWorker;
+  /** protects idle workers from missing wakeups */
+  GMutex mutex;
+  GCond condition;
+  /** number of submitted jobs not yet popped by a worker, counted before they are pushed */
+  volatile gint numQueuedJobs;
+  volatile gint shutdown;
+  /** lock-free stack of finished (ShovelerExecutorJob *) linked through nextCompleted */
+  gpointer completedJobs;
+} ShovelerExecutorThreadPool;
+
 typedef struct ShovelerExecutorStruct {
   gint64 lastUpdate;
-  /** set of (ShovelerExecutorCallback *) */
-  GHashTable* callbacks;
+  /** time of tick zero */
+  /* private */ gint64 epoch;
+  /** current tick in milliseconds since epoch, all earlier ticks have been processed */
+  /* private */ gint64 tick;
+  /* private */ guint64 nextSequence;
+  /* private */ unsigned int numScheduled;
+  /** lists of (ShovelerExecutorCallback *) linked through their next pointers */
+  /* private */ ShovelerExecutorCallback* wheel[SHOVELER_EXECUTOR_WHEEL_LEVELS]
+                                               [SHOVELER_EXECUTOR_WHEEL_SLOTS];
+  /** list of callbacks too far in the future to fit into the wheel */
+  /* private */ ShovelerExecutorCallback* overflow;
+  /** array of (ShovelerExecutorCallback *) blocks of SHOVELER_EXECUTOR_CALLBACK_BLOCK_SIZE */
+  /* private */ GArray* callbackBlocks;
+  /** list of unused callbacks linked through their next pointers */
+  /* private */ ShovelerExecutorCallback* freeCallbacks;
+  /** array of (ShovelerExecutorCallback *) due in the current update */
+  /* private */ GArray* dueCallbacks;
+  /** number of submitted jobs whose completion hasn't run yet */
+  unsigned int numPendingJobs;
+  /** runs submitted jobs, or NULL to run them inline during updates */
+  /* private */ ShovelerExecutorThreadPool* threadPool;
+  /** queue of (ShovelerExecutorJob *) submitted to an executor without thread pool */
+  /* private */ GQueue* directJobs;
 } ShovelerExecutor;
 
 ShovelerExecutor* shovelerExecutorCreateDirect();
+/** Creates an executor running submitted jobs on the given number of worker threads, or one less
+ * than the number of processors if numWorkers is not positive. */
+ShovelerExecutor* shovelerExecutorCreateThreadPool(int numWorkers);
 void shovelerExecutorUpdate(ShovelerExecutor* executor, gint64 elapsedUs);
 void shovelerExecutorUpdateNow(ShovelerExecutor* executor);
 ShovelerExecutorCallback* shovelerExecutorSchedulePeriodic(
@@ -28,9 +136,25 @@ ShovelerExecutorCallback* shovelerExecutorSchedulePeriodic(
     int intervalMs,
     ShovelerExecutorCallbackFunction* callbackFunction,
     void* userData);
+/** Removes a scheduled callback, which is safe to call from within any callback of the executor,
+ * including the one being removed. */
 bool shovelerExecutorRemoveCallback(ShovelerExecutor* executor, ShovelerExecutorCallback* callback);
+/** Submits a job, which is owned by the executor and freed after its completion callback ran. */
+ShovelerExecutorJob* shovelerExecutorSubmit(
+    ShovelerExecutor* executor,
+    ShovelerExecutorJobFunction* run,
+    ShovelerExecutorJobCompleteFunction* complete,
+    void* userData);
+/** Requests cancellation of a job whose completion hasn't run yet. Jobs that haven't started are
+ * skipped, while running jobs can stop early by polling their cancellation token. */
+void shovelerExecutorCancelJob(ShovelerExecutorJob* job);
+/** Frees the executor, stopping its workers and dropping pending jobs without completing them. */
 void shovelerExecutorFree(ShovelerExecutor* executor);
 
+static inline bool shovelerExecutorJobIsCancelled(ShovelerExecutorJob* job) {
+  return g_atomic_int_get(&job->cancelled) != 0;
+}
+
 static inline ShovelerExecutorCallback* shovelerExecutorSchedule(
     ShovelerExecutor* executor,
     int timeoutMs,
@@ -4,9 +4,29 @@
 #include <stdbool.h>
 #include <stddef.h> // size_t
 
+/**
+ * Read-only view of a file's contents.
+ *
+ * Regular files are memory mapped, so their pages are only loaded from the page cache as they are
+ * accessed instead of being copied into a heap buffer up front. Files that can't be mapped, like
+ * empty files or pipes, are read into a buffer owned by the mapping instead. In both cases the
+ * contents are not zero terminated.
+ */
+typedef struct ShovelerFileMappingStruct {
+  const unsigned char* contents;
+  size_t contentsSize;
+  /** start of the memory mapping, or NULL if the contents were read into a buffer */
+  /* private */ void* mapping;
+  /* private */ size_t mappingSize;
+} ShovelerFileMapping;
+
+/** Reads a file into a newly allocated, zero terminated buffer, sized upfront for regular files. */
 bool shovelerFileRead(
     const char* filename, unsigned char** contentsPointer, size_t* contentsSizePointer);
 char* shovelerFileReadString(const char* filename);
+/** Maps a file's contents, which remain valid until shovelerFileUnmap is called. */
+ShovelerFileMapping* shovelerFileMap(const char* filename);
+void shovelerFileUnmap(ShovelerFileMapping* fileMapping);
 bool shovelerFileWrite(const char* filename, unsigned char* contents, size_t contentsSize);
 bool shovelerFileWriteString(const char* filename, const char* string);
 
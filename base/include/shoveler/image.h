@@ -22,6 +22,27 @@ void shovelerImageSet(ShovelerImage* image, ShovelerColor color, unsigned char a
 void shovelerImageAddFrame(ShovelerImage* image, unsigned int size, ShovelerColor color);
 void shovelerImageAddSubImage(
     ShovelerImage* image, int xOffset, int yOffset, ShovelerImage* subImage);
+/** Writes the given region of a three channel image from three planes of bytes, one per channel.
+ * Each plane covers the whole image with one byte per pixel, stored row by row. */
+void shovelerImageInterleave3(
+    ShovelerImage* image,
+    unsigned int x,
+    unsigned int y,
+    unsigned int width,
+    unsigned int height,
+    const unsigned char* plane0,
+    const unsigned char* plane1,
+    const unsigned char* plane2);
+/** Reference implementation of shovelerImageInterleave3 that doesn't use SIMD instructions. */
+void shovelerImageInterleave3Scalar(
+    ShovelerImage* image,
+    unsigned int x,
+    unsigned int y,
+    unsigned int width,
+    unsigned int height,
+    const unsigned char* plane0,
+    const unsigned char* plane1,
+    const unsigned char* plane2);
 void shovelerImageFree(ShovelerImage* image);
 
 #define shovelerImageGet(image, x, y, c) \
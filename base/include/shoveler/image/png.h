@@ -1,12 +1,69 @@
+/**
+ * Reading and writing of PNG images.
+ *
+ * Reading decodes rows straight into the data of the destination image, without intermediate row
+ * buffers. Each reader recycles the memory libpng and zlib allocate for their decoding state, so
+ * decoding many images in a row doesn't keep hitting the allocator. Readers aren't thread safe,
+ * but the plain read functions use a separate reader per thread, so that images can be decoded
+ * concurrently on the worker threads of an executor.
+ */
+
 #ifndef SHOVELER_IMAGE_PNG_H
 #define SHOVELER_IMAGE_PNG_H
 
+#include <glib.h>
 #include <shoveler/image.h>
 #include <stdbool.h> // bool
 #include <stddef.h> // size_t
 
+#define SHOVELER_IMAGE_PNG_READER_MAX_FREE_BLOCKS 64
+
+typedef struct ShovelerExecutorStruct ShovelerExecutor; // forward declaration: executor.h
+typedef struct ShovelerExecutorJobStruct ShovelerExecutorJob; // forward declaration: executor.h
+
+/** Receives a decoded image owned by the callee, or NULL if decoding failed or was cancelled. */
+typedef void(ShovelerImagePngReadCompleteFunction)(ShovelerImage* image, void* userData);
+
+typedef struct ShovelerImagePngReaderStruct {
+  /** array of (unsigned char *) pointing libpng at the rows of the image being decoded */
+  GArray* rowPointers;
+  /** array of (void *) blocks released by libpng, handed out again by later allocations */
+  /* private */ GArray* freeBlocks;
+} ShovelerImagePngReader;
+
 ShovelerImage* shovelerImagePngReadFile(const char* filename);
 ShovelerImage* shovelerImagePngReadBuffer(const unsigned char* buffer, int bufferSize);
+/**
+ * Decodes a PNG buffer on a worker of the executor, running the completion callback during a
+ * later update of the executor. The buffer must remain valid until then.
+ */
+ShovelerExecutorJob* shovelerImagePngReadBufferAsync(
+    ShovelerExecutor* executor,
+    const unsigned char* buffer,
+    int bufferSize,
+    ShovelerImagePngReadCompleteFunction* complete,
+    void* userData);
+/** Reads the dimensions of a PNG image and the channels it decodes to from its header. */
+bool shovelerImagePngReadBufferSize(
+    const unsigned char* buffer,
+    int bufferSize,
+    unsigned int* width,
+    unsigned int* height,
+    unsigned int* channels);
 bool shovelerImagePngWriteFile(ShovelerImage* image, const char* filename);
+/** Appends the encoded image to output. */
+bool shovelerImagePngWrite(ShovelerImage* image, GString* output);
+
+ShovelerImagePngReader* shovelerImagePngReaderCreate();
+ShovelerImage* shovelerImagePngReaderReadFile(ShovelerImagePngReader* reader, const char* filename);
+ShovelerImage* shovelerImagePngReaderReadBuffer(
+    ShovelerImagePngReader* reader, const unsigned char* buffer, int bufferSize);
+/** Decodes into a preallocated image, which must match the dimensions and channels of the PNG. */
+bool shovelerImagePngReaderReadBufferInto(
+    ShovelerImagePngReader* reader,
+    const unsigned char* buffer,
+    int bufferSize,
+    ShovelerImage* image);
+void shovelerImagePngReaderFree(ShovelerImagePngReader* reader);
 
 #endif
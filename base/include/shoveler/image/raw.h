@@ -0,0 +1,35 @@
+/**
+ * A simple raw image format meant for shipping textures, which avoids the cost of PNG filtering
+ * and decoding on the receiving side.
+ *
+ * A raw image consists of a 16 byte header followed by the pixel data in ShovelerImage layout,
+ * optionally zlib compressed. The header holds the magic "SHVR", a version byte, a compression
+ * byte, a channels byte and a reserved byte, followed by the width and height as little endian 32
+ * bit integers. Since the header fully determines the decoded size, the decoder allocates the
+ * image once and inflates straight into its data.
+ */
+
+#ifndef SHOVELER_IMAGE_RAW_H
+#define SHOVELER_IMAGE_RAW_H
+
+#include <glib.h>
+#include <shoveler/image.h>
+#include <stdbool.h> // bool
+
+#define SHOVELER_IMAGE_RAW_HEADER_SIZE 16
+#define SHOVELER_IMAGE_RAW_VERSION 1
+
+typedef enum {
+  SHOVELER_IMAGE_RAW_COMPRESSION_NONE,
+  SHOVELER_IMAGE_RAW_COMPRESSION_DEFLATE,
+} ShovelerImageRawCompression;
+
+ShovelerImage* shovelerImageRawReadBuffer(const unsigned char* buffer, int bufferSize);
+/** Decodes into a preallocated image, which must match the dimensions and channels of the data. */
+bool shovelerImageRawReadBufferInto(
+    const unsigned char* buffer, int bufferSize, ShovelerImage* image);
+/** Appends the encoded image to output, with level being the zlib level used for compression. */
+bool shovelerImageRawWrite(
+    ShovelerImage* image, ShovelerImageRawCompression compression, int level, GString* output);
+
+#endif
@@ -1,8 +1,19 @@
+/**
+ * Input streams read from a contiguous buffer, which is either passed in by the caller or holds a
+ * file's contents mapped with shovelerFileMap.
+ *
+ * Besides the byte-wise getc and ungetc functions, streams expose their remaining contents through
+ * shovelerInputStreamPeek, so that parsers can scan directly over the buffer and then consume what
+ * they parsed with shovelerInputStreamSkip, instead of paying for a function call per byte.
+ */
+
 #ifndef SHOVELER_INPUT_STREAM_H
 #define SHOVELER_INPUT_STREAM_H
 
 #include <glib.h>
-#include <stdio.h> // FILE
+#include <stdio.h> // EOF
+
+typedef struct ShovelerFileMappingStruct ShovelerFileMapping; // forward declaration: file.h
 
 typedef enum {
   SHOVELER_INPUT_STREAM_TYPE_FILE,
@@ -11,25 +22,15 @@ typedef enum {
 
 typedef struct {
   ShovelerInputStreamType type;
-  union {
-    struct {
-      FILE* file;
-      const char* filename;
-    } fileSource;
-    struct {
-      const unsigned char* buffer;
-      int size;
-      int index;
-    } memorySource;
-  };
+  const unsigned char* buffer;
+  int size;
+  int index;
+  /** mapped contents of file input streams, or NULL for memory input streams */
+  /* private */ ShovelerFileMapping* fileMapping;
   GString* description;
 } ShovelerInputStream;
 
-/**
- * Creates a file input stream, with the caller retaining ownership over the passed filename.
- *
- * The filename must remain valid until the input stream is freed.
- */
+/** Creates a file input stream reading from the memory mapped contents of the given file. */
 ShovelerInputStream* shovelerInputStreamCreateFile(const char* filename);
 /**
  * Creates a memory input stream, with the caller retaining ownership over the passed buffer.
@@ -40,8 +41,32 @@ ShovelerInputStream* shovelerInputStreamCreateMemory(const unsigned char* buffer
 const char* shovelerInputStreamGetDescription(ShovelerInputStream* inputStream);
 int shovelerInputStreamGetc(ShovelerInputStream* inputStream);
 int shovelerInputStreamRead(ShovelerInputStream* inputStream, unsigned char* target, int size);
+/**
+ * Returns a span of up to size bytes without copying and consumes it, with the returned pointer
+ * remaining valid until the input stream is freed.
+ */
+int shovelerInputStreamReadSpan(
+    ShovelerInputStream* inputStream, int size, const unsigned char** dataPointer);
+/** Parses an optionally signed decimal integer after skipping whitespace, or returns zero. */
 int shovelerInputStreamReadInt(ShovelerInputStream* inputStream);
 int shovelerInputStreamUngetc(ShovelerInputStream* inputStream, int c);
+/** Consumes up to size bytes and returns how many were skipped. */
+int shovelerInputStreamSkip(ShovelerInputStream* inputStream, int size);
+/**
+ * Parses an integer like shovelerInputStreamReadInt from the start of the given data, returning
+ * the number of bytes consumed, or zero if no integer could be parsed.
+ */
+int shovelerInputStreamParseInt(const unsigned char* data, int size, int* outputValue);
 void shovelerInputStreamFree(ShovelerInputStream* inputStream);
 
+/**
+ * Returns the number of bytes remaining in the stream, pointing the passed data pointer at them
+ * without consuming them.
+ */
+static inline int shovelerInputStreamPeek(
+    ShovelerInputStream* inputStream, const unsigned char** dataPointer) {
+  *dataPointer = inputStream->buffer + inputStream->index;
+  return inputStream->size - inputStream->index;
+}
+
 #endif
@@ -1,8 +1,36 @@
+/**
+ * Logging either happens synchronously on the calling thread, or asynchronously after
+ * shovelerLogStartAsync was called.
+ *
+ * In asynchronous mode, call sites only format the message body into their thread's bounded ring
+ * buffer, without taking any locks or allocating unless the message is too long to fit into a slot.
+ * A background thread prefixes the messages with their timestamp and location, and passes them to
+ * the log channel or callback. If a thread logs faster than the background thread can keep up and
+ * its ring buffer is full, further messages are dropped and counted instead of blocking the caller.
+ * Only errors are never dropped, blocking the caller until they are written instead. A thread's ring
+ * buffer is freed once the thread exited and its remaining messages were written.
+ *
+ * Levels can also be filtered at compile time by defining SHOVELER_LOG_MIN_LEVEL to the value of
+ * the least severe level that should be compiled in, in which case calls for less severe levels
+ * don't even evaluate their arguments.
+ */
+
 #ifndef SHOVELER_LOG_H
 #define SHOVELER_LOG_H
 
 #include <stdio.h> // FILE
 
+/** Default number of messages each thread can have pending before further messages are dropped. */
+#define SHOVELER_LOG_DEFAULT_ASYNC_CAPACITY 1024
+
+#ifndef SHOVELER_LOG_MIN_LEVEL
+#ifdef SHOVELER_DISABLE_TRACE_LOGGING
+#define SHOVELER_LOG_MIN_LEVEL 2
+#else
+#define SHOVELER_LOG_MIN_LEVEL 1
+#endif
+#endif
+
 /**
  * Log level enum describing possible logging modes
  */
@@ -33,24 +61,49 @@ typedef void(ShovelerLogMessageCallbackFunction)(
 void shovelerLogInit(const char* locationPrefix, ShovelerLogLevel level, FILE* channel);
 void shovelerLogInitWithCallback(
     ShovelerLogLevel level, ShovelerLogMessageCallbackFunction* callbackFunction);
-
+/**
+ * Starts a background thread writing messages, after which the channel or callback is only used
+ * from that thread. Each logging thread can have up to capacity messages pending.
+ */
+void shovelerLogStartAsync(int capacity);
+/** Blocks until all messages logged before the call were written. */
+void shovelerLogFlush();
+/** Returns the number of messages dropped because a thread's ring buffer was full. */
+int shovelerLogGetNumDropped();
+/** Returns the number of threads' ring buffers currently allocated by asynchronous logging. */
+int shovelerLogGetNumThreadRings();
+/** Stops asynchronous logging after writing all pending messages. */
 void shovelerLogTerminate();
 
 void shovelerLogMessage(
     const char* file, int line, ShovelerLogLevel level, const char* message, ...);
 
-#ifdef SHOVELER_DISABLE_TRACE_LOGGING
+#if SHOVELER_LOG_MIN_LEVEL > 1
 #define shovelerLogTrace(...) ((void) 0)
 #else
 #define shovelerLogTrace(...) \
   shovelerLogMessage(__FILE__, __LINE__, SHOVELER_LOG_LEVEL_TRACE, __VA_ARGS__)
 #endif
 
+#if SHOVELER_LOG_MIN_LEVEL > 2
+#define shovelerLogInfo(...) ((void) 0)
+#else
 #define shovelerLogInfo(...) \
   shovelerLogMessage(__FILE__, __LINE__, SHOVELER_LOG_LEVEL_INFO, __VA_ARGS__)
+#endif
+
+#if SHOVELER_LOG_MIN_LEVEL > 4
+#define shovelerLogWarning(...) ((void) 0)
+#else
 #define shovelerLogWarning(...) \
   shovelerLogMessage(__FILE__, __LINE__, SHOVELER_LOG_LEVEL_WARNING, __VA_ARGS__)
+#endif
+
+#if SHOVELER_LOG_MIN_LEVEL > 8
+#define shovelerLogError(...) ((void) 0)
+#else
 #define shovelerLogError(...) \
   shovelerLogMessage(__FILE__, __LINE__, SHOVELER_LOG_LEVEL_ERROR, __VA_ARGS__)
+#endif
 
 #endif
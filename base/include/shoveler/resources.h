@@ -1,12 +1,64 @@
+/**
+ * Resources are requested by id and hold their type loader's default data until they are loaded.
+ *
+ * Getting an unloaded resource queues a request for its contents, ordered by priority and
+ * deduplicated by resource id, and at most maxInFlightRequests requests are outstanding at a time.
+ * Contents are delivered through shovelerResourcesSet. With an executor, they are copied and
+ * queued for decoding on its worker threads, with at most maxInFlightLoads decodes running at a
+ * time. Decoded data is swapped in on the thread updating the executor, which then notifies the
+ * resource's callbacks. Contents delivered for a resource that is still being decoded supersede
+ * the pending decode. Without an executor, contents are decoded inline instead.
+ *
+ * Getting a resource acquires a reference to it, which must be released with
+ * shovelerResourceRelease once the resource is no longer used. Resources without references are
+ * kept in a least recently used order per type. Whenever the data resident for a type exceeds its
+ * memory budget, as reported by its type loader, the least recently used unreferenced resources are
+ * evicted until it fits again. Evicted resources are freed, so they are requested again the next
+ * time they are needed.
+ *
+ * All functions must be called from the thread updating the executor.
+ */
+
 #ifndef SHOVELER_RESOURCES_H
 #define SHOVELER_RESOURCES_H
 
 #include <glib.h>
+#include <stdbool.h> // bool
+#include <stddef.h> // size_t
+
+#define SHOVELER_RESOURCES_DEFAULT_PRIORITY 0
 
+typedef struct ShovelerExecutorStruct ShovelerExecutor; // forward declaration: executor.h
+typedef struct ShovelerExecutorJobStruct ShovelerExecutorJob; // forward declaration: executor.h
+
+struct ShovelerResourceStruct; // forward declaration
+struct ShovelerResourcesLoadStruct; // forward declaration
 struct ShovelerResourcesTypeLoaderStruct; // forward declaration
 struct ShovelerResourcesStruct; // forward declaration
 
+typedef enum {
+  /** waiting for an in-flight slot before its contents are requested */
+  SHOVELER_RESOURCE_STATE_REQUEST_QUEUED,
+  /** contents were requested but not delivered yet */
+  SHOVELER_RESOURCE_STATE_REQUESTED,
+  /** contents were delivered and are waiting for a decoding slot */
+  SHOVELER_RESOURCE_STATE_LOAD_QUEUED,
+  /** contents are being decoded */
+  SHOVELER_RESOURCE_STATE_LOADING,
+  SHOVELER_RESOURCE_STATE_LOADED,
+  /** the last delivered contents failed to decode, keeping the previous data */
+  SHOVELER_RESOURCE_STATE_FAILED,
+} ShovelerResourceState;
+
+typedef void(ShovelerResourceCallbackFunction)(
+    struct ShovelerResourceStruct* resource, void* userData);
+
 typedef struct {
+  ShovelerResourceCallbackFunction* function;
+  void* userData;
+} ShovelerResourceCallback;
+
+typedef struct ShovelerResourceStruct {
   struct ShovelerResourcesStruct* resources;
   /** unique resource id owned by the object */
   char* id;
@@ -14,17 +66,43 @@ typedef struct {
   const char* typeId;
   /** type specific resource data */
   void* data;
+  ShovelerResourceState state;
+  /** priority of the pending request or load, where higher priorities are processed first */
+  int priority;
+  /** set of (ShovelerResourceCallback *) run after new data was swapped in */
+  GHashTable* callbacks;
+  /** number of acquired references, the resource may be evicted when this drops to zero */
+  unsigned int referenceCount;
+  /** size of the data as reported by the type loader, or zero for the default data */
+  size_t size;
+  /** link in the type loader's unreferenced resources while the reference count is zero */
+  /* private */ GList* unreferencedLink;
+  /** queued or running load of the most recently delivered contents, or NULL */
+  /* private */ struct ShovelerResourcesLoadStruct* load;
 } ShovelerResource;
 
+/** Decodes resource data, on the executor's worker threads if the resources have an executor. */
 typedef void*(ShovelerResourcesTypeLoaderLoadFunction)(
     struct ShovelerResourcesTypeLoaderStruct* typeLoader,
     const unsigned char* buffer,
     int bufferSize);
+/** Returns the memory used by resource data, counted against the type loader's memory budget. */
+typedef size_t(ShovelerResourcesTypeLoaderGetResourceSizeFunction)(
+    struct ShovelerResourcesTypeLoaderStruct* typeLoader, void* resourceData);
 typedef void(ShovelerResourcesTypeLoaderFreeResourceFunction)(
     struct ShovelerResourcesTypeLoaderStruct* typeLoader, void* resourceData);
 typedef void(ShovelerResourcesTypeLoaderFreeFunction)(
     struct ShovelerResourcesTypeLoaderStruct* typeLoader);
 
+typedef struct {
+  /** number of gets of resources that were already known */
+  gint64 numHits;
+  /** number of gets that had to create and request a resource */
+  gint64 numMisses;
+  gint64 numEvictions;
+  size_t residentBytes;
+} ShovelerResourcesStats;
+
 typedef struct ShovelerResourcesTypeLoaderStruct {
   const char* typeId;
   /** the default resource gets freed automatically using freeResourceData on freeing of the
@@ -32,10 +110,31 @@ typedef struct ShovelerResourcesTypeLoaderStruct {
   void* defaultResourceData;
   void* data;
   ShovelerResourcesTypeLoaderLoadFunction* load;
+  /** may be NULL if resources of this type shouldn't count against the memory budget */
+  ShovelerResourcesTypeLoaderGetResourceSizeFunction* getResourceSize;
   ShovelerResourcesTypeLoaderFreeResourceFunction* freeResourceData;
   ShovelerResourcesTypeLoaderFreeFunction* free;
+  /** maximum number of bytes resident for this type before evicting, or zero for no limit */
+  size_t memoryBudget;
+  /* private */ ShovelerResourcesStats stats;
+  /** queue of unreferenced (ShovelerResource *), from least to most recently used */
+  /* private */ GQueue* unreferencedResources;
 } ShovelerResourcesTypeLoader;
 
+typedef struct ShovelerResourcesLoadStruct {
+  struct ShovelerResourcesStruct* resources;
+  /** resource to swap the decoded data into, or NULL if the load was superseded */
+  ShovelerResource* resource;
+  ShovelerResourcesTypeLoader* typeLoader;
+  /** copy of the delivered contents owned by the load */
+  unsigned char* buffer;
+  int bufferSize;
+  /** decoded data, written by the worker thread */
+  void* data;
+  /** running decode job, or NULL while the load is queued */
+  ShovelerExecutorJob* job;
+} ShovelerResourcesLoad;
+
 typedef void(ShovelerResourcesRequestFunction)(
     struct ShovelerResourcesStruct* resources,
     const char* typeId,
@@ -45,24 +144,73 @@ typedef void(ShovelerResourcesRequestFunction)(
 typedef struct ShovelerResourcesStruct {
   ShovelerResourcesRequestFunction* request;
   void* requestUserData;
+  /** executor decoding resources, or NULL to decode them inline when they are set */
+  ShovelerExecutor* executor;
+  /** maximum number of outstanding requests, or zero for no limit */
+  int maxInFlightRequests;
+  /** maximum number of concurrently running decodes, or zero for no limit */
+  int maxInFlightLoads;
+  int numInFlightRequests;
+  int numInFlightLoads;
   /** map from (const char *) resource type id to (ShovelerResourcesTypeLoader *) */
   GHashTable* typeLoaders;
   /** map from (char *) resource id to (ShovelerResource *) */
   GHashTable* resources;
+  /** queue of (ShovelerResource *) waiting to be requested, ordered by descending priority */
+  /* private */ GQueue* queuedRequests;
+  /** queue of (ShovelerResourcesLoad *) waiting to be decoded, ordered by descending priority */
+  /* private */ GQueue* queuedLoads;
 } ShovelerResources;
 
 ShovelerResources* shovelerResourcesCreate(
     ShovelerResourcesRequestFunction* request, void* userData);
+/** Sets the executor to decode resources on, which must outlive the resources. */
+void shovelerResourcesSetExecutor(ShovelerResources* resources, ShovelerExecutor* executor);
+void shovelerResourcesSetInFlightLimits(
+    ShovelerResources* resources, int maxInFlightRequests, int maxInFlightLoads);
 bool shovelerResourcesRegisterTypeLoader(
     ShovelerResources* resources, ShovelerResourcesTypeLoader typeLoader);
-ShovelerResource* shovelerResourcesGet(
-    ShovelerResources* resources, const char* typeId, const char* resourceId);
+/** Sets the memory budget of a type, evicting unreferenced resources if it is exceeded. */
+bool shovelerResourcesSetMemoryBudget(
+    ShovelerResources* resources, const char* typeId, size_t memoryBudget);
+const ShovelerResourcesStats* shovelerResourcesGetStats(
+    ShovelerResources* resources, const char* typeId);
+void shovelerResourcesLogStats(ShovelerResources* resources);
+/**
+ * Acquires a reference to the resource with the given id, queueing a request for it if it wasn't
+ * requested yet. Getting a queued resource again with a higher priority moves its request up the
+ * queue.
+ */
+ShovelerResource* shovelerResourcesGetWithPriority(
+    ShovelerResources* resources, const char* typeId, const char* resourceId, int priority);
+/**
+ * Delivers the contents of a resource, with the caller retaining ownership over the buffer.
+ *
+ * With an executor, returns whether the contents were queued for decoding, and otherwise whether
+ * they were decoded successfully.
+ */
 bool shovelerResourcesSet(
     ShovelerResources* resources,
     const char* typeId,
     const char* resourceId,
     const unsigned char* buffer,
     int bufferSize);
+/** Frees the resources, waiting for running decodes to finish. */
 void shovelerResourcesFree(ShovelerResources* resources);
 
+/** Acquires an additional reference to the resource, e.g. to share it with another dependent. */
+void shovelerResourceAcquire(ShovelerResource* resource);
+/** Releases a reference to the resource, which must not be used afterwards by the releaser. */
+void shovelerResourceRelease(ShovelerResource* resource);
+ShovelerResourceCallback* shovelerResourceAddCallback(
+    ShovelerResource* resource, ShovelerResourceCallbackFunction* function, void* userData);
+bool shovelerResourceRemoveCallback(
+    ShovelerResource* resource, ShovelerResourceCallback* callback);
+
+static inline ShovelerResource* shovelerResourcesGet(
+    ShovelerResources* resources, const char* typeId, const char* resourceId) {
+  return shovelerResourcesGetWithPriority(
+      resources, typeId, resourceId, SHOVELER_RESOURCES_DEFAULT_PRIORITY);
+}
+
 #endif
@@ -0,0 +1,262 @@
+#include "shoveler/bounding_volumes.h"
+
+#include <assert.h> // assert
+#include <math.h> // fabsf
+#include <stdlib.h> // malloc, realloc, free
+#include <string.h> // memset
+
+#ifdef __SSE2__
+#include <emmintrin.h> // SSE2 intrinsics
+#endif
+#ifdef __ARM_NEON
+#include <arm_neon.h> // NEON intrinsics
+#endif
+
+#define NUM_PLANES 6
+#define INITIAL_CAPACITY 64
+
+static const float eps = 1e-6f;
+
+/** Plane coefficients prepared for testing boxes given as center and half extents. */
+typedef struct {
+  float normal[3];
+  float absNormal[3];
+  /** plane offset scaled to match shovelerPlaneVectorDistance for non-normalized normals */
+  float offset;
+} CullPlane;
+
+static void grow(ShovelerBoundingVolumes* volumes);
+static void preparePlanes(const ShovelerFrustum* frustum, CullPlane* planes);
+static void cullScalar(
+    const ShovelerBoundingVolumes* volumes,
+    const CullPlane* planes,
+    guint start,
+    guint32* visibility);
+#ifdef __SSE2__
+static guint cullSse2(
+    const ShovelerBoundingVolumes* volumes, const CullPlane* planes, guint32* visibility);
+#endif
+#ifdef __ARM_NEON
+static guint cullNeon(
+    const ShovelerBoundingVolumes* volumes, const CullPlane* planes, guint32* visibility);
+#endif
+
+ShovelerBoundingVolumes* shovelerBoundingVolumesCreate() {
+  ShovelerBoundingVolumes* volumes = malloc(sizeof(ShovelerBoundingVolumes));
+  volumes->centerX = NULL;
+  volumes->centerY = NULL;
+  volumes->centerZ = NULL;
+  volumes->extentX = NULL;
+  volumes->extentY = NULL;
+  volumes->extentZ = NULL;
+  volumes->size = 0;
+  volumes->capacity = 0;
+  return volumes;
+}
+
+guint shovelerBoundingVolumesAdd(ShovelerBoundingVolumes* volumes, ShovelerBoundingBox3 box) {
+  if (volumes->size == volumes->capacity) {
+    grow(volumes);
+  }
+
+  guint index = volumes->size++;
+  shovelerBoundingVolumesUpdate(volumes, index, box);
+  return index;
+}
+
+void shovelerBoundingVolumesUpdate(
+    ShovelerBoundingVolumes* volumes, guint index, ShovelerBoundingBox3 box) {
+  assert(index < volumes->size);
+
+  volumes->centerX[index] = 0.5f * (box.min.values[0] + box.max.values[0]);
+  volumes->centerY[index] = 0.5f * (box.min.values[1] + box.max.values[1]);
+  volumes->centerZ[index] = 0.5f * (box.min.values[2] + box.max.values[2]);
+  volumes->extentX[index] = 0.5f * (box.max.values[0] - box.min.values[0]);
+  volumes->extentY[index] = 0.5f * (box.max.values[1] - box.min.values[1]);
+  volumes->extentZ[index] = 0.5f * (box.max.values[2] - box.min.values[2]);
+}
+
+void shovelerBoundingVolumesClear(ShovelerBoundingVolumes* volumes) { volumes->size = 0; }
+
+void shovelerBoundingVolumesCullFrustum(
+    const ShovelerBoundingVolumes* volumes, const ShovelerFrustum* frustum, guint32* visibility) {
+  memset(visibility, 0, shovelerBoundingVolumesGetNumVisibilityWords(volumes->size) * 4);
+
+  CullPlane planes[NUM_PLANES];
+  preparePlanes(frustum, planes);
+
+  guint done = 0;
+#ifdef __SSE2__
+  done = cullSse2(volumes, planes, visibility);
+#elif defined(__ARM_NEON)
+  done = cullNeon(volumes, planes, visibility);
+#endif
+  cullScalar(volumes, planes, done, visibility);
+}
+
+void shovelerBoundingVolumesFree(ShovelerBoundingVolumes* volumes) {
+  if (volumes == NULL) {
+    return;
+  }
+
+  free(volumes->centerX);
+  free(volumes->centerY);
+  free(volumes->centerZ);
+  free(volumes->extentX);
+  free(volumes->extentY);
+  free(volumes->extentZ);
+  free(volumes);
+}
+
+static void grow(ShovelerBoundingVolumes* volumes) {
+  volumes->capacity = volumes->capacity == 0 ? INITIAL_CAPACITY : 2 * volumes->capacity;
+  size_t arraySize = volumes->capacity * sizeof(float);
+  volumes->centerX = realloc(volumes->centerX, arraySize);
+  volumes->centerY = realloc(volumes->centerY, arraySize);
+  volumes->centerZ = realloc(volumes->centerZ, arraySize);
+  volumes->extentX = realloc(volumes->extentX, arraySize);
+  volumes->extentY = realloc(volumes->extentY, arraySize);
+  volumes->extentZ = realloc(volumes->extentZ, arraySize);
+}
+
+static void preparePlanes(const ShovelerFrustum* frustum, CullPlane* planes) {
+  const ShovelerPlane* frustumPlanes[NUM_PLANES] = {
+      &frustum->nearPlane,
+      &frustum->farPlane,
+      &frustum->leftPlane,
+      &frustum->bottomPlane,
+      &frustum->rightPlane,
+      &frustum->topPlane,
+  };
+
+  for (int i = 0; i < NUM_PLANES; i++) {
+    const ShovelerPlane* plane = frustumPlanes[i];
+    for (int j = 0; j < 3; j++) {
+      planes[i].normal[j] = plane->normal.values[j];
+      planes[i].absNormal[j] = fabsf(plane->normal.values[j]);
+    }
+    planes[i].offset = plane->offset * shovelerVector3Dot(plane->normal, plane->normal);
+  }
+}
+
+/**
+ * A box lies outside a plane if its corner closest to the inside, at the distance of its center
+ * minus its extents projected onto the normal, is still outside.
+ */
+static void cullScalar(
+    const ShovelerBoundingVolumes* volumes,
+    const CullPlane* planes,
+    guint start,
+    guint32* visibility) {
+  for (guint i = start; i < volumes->size; i++) {
+    bool outside = false;
+    for (int p = 0; p < NUM_PLANES && !outside; p++) {
+      const CullPlane* plane = &planes[p];
+      float distance = volumes->centerX[i] * plane->normal[0] +
+          volumes->centerY[i] * plane->normal[1] + volumes->centerZ[i] * plane->normal[2] -
+          plane->offset;
+      float radius = volumes->extentX[i] * plane->absNormal[0] +
+          volumes->extentY[i] * plane->absNormal[1] + volumes->extentZ[i] * plane->absNormal[2];
+      outside = distance - radius > eps;
+    }
+
+    if (!outside) {
+      visibility[i / 32] |= 1u << (i % 32);
+    }
+  }
+}
+
+#ifdef __SSE2__
+/** Culls four volumes at a time, returning the number of volumes processed. */
+static guint cullSse2(
+    const ShovelerBoundingVolumes* volumes, const CullPlane* planes, guint32* visibility) {
+  __m128 epsilon = _mm_set1_ps(eps);
+  __m128 normalX[NUM_PLANES], normalY[NUM_PLANES], normalZ[NUM_PLANES], offset[NUM_PLANES];
+  __m128 absNormalX[NUM_PLANES], absNormalY[NUM_PLANES], absNormalZ[NUM_PLANES];
+  for (int p = 0; p < NUM_PLANES; p++) {
+    normalX[p] = _mm_set1_ps(planes[p].normal[0]);
+    normalY[p] = _mm_set1_ps(planes[p].normal[1]);
+    normalZ[p] = _mm_set1_ps(planes[p].normal[2]);
+    absNormalX[p] = _mm_set1_ps(planes[p].absNormal[0]);
+    absNormalY[p] = _mm_set1_ps(planes[p].absNormal[1]);
+    absNormalZ[p] = _mm_set1_ps(planes[p].absNormal[2]);
+    offset[p] = _mm_set1_ps(planes[p].offset);
+  }
+
+  guint i = 0;
+  for (; i + 4 <= volumes->size; i += 4) {
+    __m128 centerX = _mm_loadu_ps(volumes->centerX + i);
+    __m128 centerY = _mm_loadu_ps(volumes->centerY + i);
+    __m128 centerZ = _mm_loadu_ps(volumes->centerZ + i);
+    __m128 extentX = _mm_loadu_ps(volumes->extentX + i);
+    __m128 extentY = _mm_loadu_ps(volumes->extentY + i);
+    __m128 extentZ = _mm_loadu_ps(volumes->extentZ + i);
+
+    __m128 outside = _mm_setzero_ps();
+    for (int p = 0; p < NUM_PLANES; p++) {
+      // same operation order as the scalar version, so that both agree exactly
+      __m128 distance = _mm_sub_ps(
+          _mm_add_ps(
+              _mm_add_ps(_mm_mul_ps(centerX, normalX[p]), _mm_mul_ps(centerY, normalY[p])),
+              _mm_mul_ps(centerZ, normalZ[p])),
+          offset[p]);
+      __m128 radius = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(extentX, absNormalX[p]), _mm_mul_ps(extentY, absNormalY[p])),
+          _mm_mul_ps(extentZ, absNormalZ[p]));
+      outside = _mm_or_ps(outside, _mm_cmpgt_ps(_mm_sub_ps(distance, radius), epsilon));
+    }
+
+    // i is a multiple of four, so the four bits never straddle two words
+    guint32 visible = ~(guint32) _mm_movemask_ps(outside) & 0xF;
+    visibility[i / 32] |= visible << (i % 32);
+  }
+
+  return i;
+}
+#endif
+
+#ifdef __ARM_NEON
+/** Culls four volumes at a time, returning the number of volumes processed. */
+static guint cullNeon(
+    const ShovelerBoundingVolumes* volumes, const CullPlane* planes, guint32* visibility) {
+  float32x4_t epsilon = vdupq_n_f32(eps);
+  static const uint32_t laneBits[4] = {1, 2, 4, 8};
+  uint32x4_t laneMask = vld1q_u32(laneBits);
+
+  guint i = 0;
+  for (; i + 4 <= volumes->size; i += 4) {
+    float32x4_t centerX = vld1q_f32(volumes->centerX + i);
+    float32x4_t centerY = vld1q_f32(volumes->centerY + i);
+    float32x4_t centerZ = vld1q_f32(volumes->centerZ + i);
+    float32x4_t extentX = vld1q_f32(volumes->extentX + i);
+    float32x4_t extentY = vld1q_f32(volumes->extentY + i);
+    float32x4_t extentZ = vld1q_f32(volumes->extentZ + i);
+
+    uint32x4_t outside = vdupq_n_u32(0);
+    for (int p = 0; p < NUM_PLANES; p++) {
+      const CullPlane* plane = &planes[p];
+      // separate multiplies and adds instead of fused ones, so that the scalar version agrees
+      float32x4_t distance = vsubq_f32(
+          vaddq_f32(
+              vaddq_f32(
+                  vmulq_n_f32(centerX, plane->normal[0]), vmulq_n_f32(centerY, plane->normal[1])),
+              vmulq_n_f32(centerZ, plane->normal[2])),
+          vdupq_n_f32(plane->offset));
+      float32x4_t radius = vaddq_f32(
+          vaddq_f32(
+              vmulq_n_f32(extentX, plane->absNormal[0]),
+              vmulq_n_f32(extentY, plane->absNormal[1])),
+          vmulq_n_f32(extentZ, plane->absNormal[2]));
+      outside = vorrq_u32(outside, vcgtq_f32(vsubq_f32(distance, radius), epsilon));
+    }
+
+    uint32x4_t outsideBits = vandq_u32(outside, laneMask);
+    uint32x2_t pairs = vorr_u32(vget_low_u32(outsideBits), vget_high_u32(outsideBits));
+    guint32 outsideMask = vget_lane_u32(pairs, 0) | vget_lane_u32(pairs, 1);
+    guint32 visible = ~outsideMask & 0xF;
+    visibility[i / 32] |= visible << (i % 32);
+  }
+
+  return i;
+}
+#endif
@@ -0,0 +1,124 @@
+#include <shoveler/bounding_volumes.h>
+#include <shoveler/constants.h>
+#include <shoveler/log.h>
+#include <shoveler/projection.h>
+#include <shoveler/types.h>
+#include <stdlib.h> // EXIT_SUCCESS, malloc, free, rand
+
+#define NUM_VOLUMES 100000
+#define NUM_ITERATIONS 100
+#define WORLD_SIZE 1000.0f
+#define MAX_HALF_SIZE 2.0f
+
+static bool isOutsideCorners(const ShovelerFrustum* frustum, const ShovelerBoundingBox3* box);
+static float randomFloat(float scale);
+
+int main(int argc, char* argv[]) {
+  shovelerLogInit("shoveler/", SHOVELER_LOG_LEVEL_INFO_UP, stdout);
+  srand(0);
+
+  ShovelerProjectionPerspective projection;
+  projection.fieldOfViewY = SHOVELER_PI / 2.0f;
+  projection.aspectRatio = 16.0f / 9.0f;
+  projection.nearClippingPlane = 0.1f;
+  projection.farClippingPlane = 0.5f * WORLD_SIZE;
+  ShovelerReferenceFrame frame = shovelerReferenceFrame(
+      shovelerVector3(0.0f, 0.0f, 0.0f),
+      shovelerVector3(1.0f, 0.0f, 0.0f),
+      shovelerVector3(0.0f, 0.0f, 1.0f));
+  ShovelerFrustum frustum;
+  shovelerProjectionPerspectiveComputeFrustum(&projection, &frame, &frustum);
+
+  ShovelerBoundingBox3* boxes = malloc(NUM_VOLUMES * sizeof(ShovelerBoundingBox3));
+  ShovelerBoundingVolumes* volumes = shovelerBoundingVolumesCreate();
+  for (int i = 0; i < NUM_VOLUMES; i++) {
+    ShovelerVector3 center =
+        shovelerVector3(randomFloat(WORLD_SIZE), randomFloat(WORLD_SIZE), randomFloat(WORLD_SIZE));
+    ShovelerVector3 halfSize = shovelerVector3(
+        randomFloat(MAX_HALF_SIZE) + MAX_HALF_SIZE,
+        randomFloat(MAX_HALF_SIZE) + MAX_HALF_SIZE,
+        randomFloat(MAX_HALF_SIZE) + MAX_HALF_SIZE);
+    boxes[i] = shovelerBoundingBox3(
+        shovelerVector3LinearCombination(1.0f, center, -1.0f, halfSize),
+        shovelerVector3LinearCombination(1.0f, center, 1.0f, halfSize));
+    shovelerBoundingVolumesAdd(volumes, boxes[i]);
+  }
+
+  guint32* visibility =
+      malloc(shovelerBoundingVolumesGetNumVisibilityWords(NUM_VOLUMES) * sizeof(guint32));
+  gint64 startTime = g_get_monotonic_time();
+  for (int iteration = 0; iteration < NUM_ITERATIONS; iteration++) {
+    shovelerBoundingVolumesCullFrustum(volumes, &frustum, visibility);
+  }
+  gint64 batchedTimeUs = g_get_monotonic_time() - startTime;
+
+  int numVisible = 0;
+  for (int i = 0; i < NUM_VOLUMES; i++) {
+    numVisible += shovelerBoundingVolumesIsVisible(visibility, i) ? 1 : 0;
+  }
+
+  shovelerLogInfo(
+      "Batched: culled %d bounding boxes in %.3fms per frustum (%.1fns per box, %d visible).",
+      NUM_VOLUMES,
+      (double) batchedTimeUs / NUM_ITERATIONS / 1000.0,
+      (double) batchedTimeUs * 1000.0 / NUM_ITERATIONS / NUM_VOLUMES,
+      numVisible);
+
+  // The baseline tests the eight corners of each box against each plane, the way
+  // shovelerFrustumIntersectFrustum tests frustum vertices.
+  int numVisibleCorners = 0;
+  startTime = g_get_monotonic_time();
+  for (int iteration = 0; iteration < NUM_ITERATIONS; iteration++) {
+    numVisibleCorners = 0;
+    for (int i = 0; i < NUM_VOLUMES; i++) {
+      numVisibleCorners += isOutsideCorners(&frustum, &boxes[i]) ? 0 : 1;
+    }
+  }
+  gint64 cornersTimeUs = g_get_monotonic_time() - startTime;
+
+  shovelerLogInfo(
+      "Corners: culled %d bounding boxes in %.3fms per frustum (%.1fns per box, %d visible).",
+      NUM_VOLUMES,
+      (double) cornersTimeUs / NUM_ITERATIONS / 1000.0,
+      (double) cornersTimeUs * 1000.0 / NUM_ITERATIONS / NUM_VOLUMES,
+      numVisibleCorners);
+
+  free(visibility);
+  shovelerBoundingVolumesFree(volumes);
+  free(boxes);
+  shovelerLogTerminate();
+
+  return EXIT_SUCCESS;
+}
+
+static bool isOutsideCorners(const ShovelerFrustum* frustum, const ShovelerBoundingBox3* box) {
+  const ShovelerPlane* planes[] = {
+      &frustum->nearPlane,
+      &frustum->farPlane,
+      &frustum->leftPlane,
+      &frustum->bottomPlane,
+      &frustum->rightPlane,
+      &frustum->topPlane,
+  };
+
+  for (int i = 0; i < 6; i++) {
+    int numCornersOutside = 0;
+    for (int corner = 0; corner < 8; corner++) {
+      ShovelerVector3 vertex = shovelerVector3(
+          (corner & 1) ? box->max.values[0] : box->min.values[0],
+          (corner & 2) ? box->max.values[1] : box->min.values[1],
+          (corner & 4) ? box->max.values[2] : box->min.values[2]);
+      if (shovelerPlaneVectorDistance(*planes[i], vertex) > 1e-6f) {
+        numCornersOutside++;
+      }
+    }
+
+    if (numCornersOutside == 8) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static float randomFloat(float scale) { return scale * ((float) rand() / RAND_MAX - 0.5f); }
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+extern "C" {
+#include "shoveler/bounding_volumes.h"
+#include "shoveler/constants.h"
+#include "shoveler/projection.h"
+#include "shoveler/types.h"
+}
+
+static const float eps = 1e-6f;
+
+class ShovelerBoundingVolumesTest : public ::testing::Test {
+public:
+  virtual void SetUp() {
+    ShovelerProjectionPerspective projection;
+    projection.fieldOfViewY = SHOVELER_PI / 2.0f;
+    projection.aspectRatio = 1.0f;
+    projection.nearClippingPlane = 1.0f;
+    projection.farClippingPlane = 10.0f;
+
+    ShovelerReferenceFrame frame;
+    frame.position = shovelerVector3(0, 0, 0);
+    frame.direction = shovelerVector3(0, 0, 1);
+    frame.up = shovelerVector3(0, 1, 0);
+
+    shovelerProjectionPerspectiveComputeFrustum(&projection, &frame, &frustum);
+    volumes = shovelerBoundingVolumesCreate();
+  }
+
+  virtual void TearDown() { shovelerBoundingVolumesFree(volumes); }
+
+  std::vector<guint32> cull() {
+    std::vector<guint32> visibility(
+        shovelerBoundingVolumesGetNumVisibilityWords(volumes->size), 0xFFFFFFFF);
+    shovelerBoundingVolumesCullFrustum(volumes, &frustum, visibility.data());
+    return visibility;
+  }
+
+  ShovelerFrustum frustum;
+  ShovelerBoundingVolumes* volumes;
+};
+
+static ShovelerBoundingBox3 cube(ShovelerVector3 center, float halfSize) {
+  return shovelerBoundingBox3(
+      shovelerVector3LinearCombination(1.0f, center, -halfSize, shovelerVector3(1, 1, 1)),
+      shovelerVector3LinearCombination(1.0f, center, halfSize, shovelerVector3(1, 1, 1)));
+}
+
+/** Reference test checking whether all corners of the box lie outside one of the planes. */
+static bool isOutside(const ShovelerFrustum* frustum, ShovelerBoundingBox3 box) {
+  ShovelerPlane planes[] = {
+      frustum->nearPlane,
+      frustum->farPlane,
+      frustum->leftPlane,
+      frustum->bottomPlane,
+      frustum->rightPlane,
+      frustum->topPlane,
+  };
+
+  for (const ShovelerPlane& plane : planes) {
+    int numCornersOutside = 0;
+    for (int corner = 0; corner < 8; corner++) {
+      ShovelerVector3 vertex = shovelerVector3(
+          (corner & 1) ? box.max.values[0] : box.min.values[0],
+          (corner & 2) ? box.max.values[1] : box.min.values[1],
+          (corner & 4) ? box.max.values[2] : box.min.values[2]);
+      if (shovelerPlaneVectorDistance(plane, vertex) > eps) {
+        numCornersOutside++;
+      }
+    }
+
+    if (numCornersOutside == 8) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+TEST_F(ShovelerBoundingVolumesTest, cullSimpleCases) {
+  guint inside = shovelerBoundingVolumesAdd(volumes, cube(shovelerVector3(0, 0, 5), 0.5f));
+  guint behind = shovelerBoundingVolumesAdd(volumes, cube(shovelerVector3(0, 0, -5), 0.5f));
+  guint tooFar = shovelerBoundingVolumesAdd(volumes, cube(shovelerVector3(0, 0, 20), 0.5f));
+  guint left = shovelerBoundingVolumesAdd(volumes, cube(shovelerVector3(-10, 0, 5), 0.5f));
+  guint straddling = shovelerBoundingVolumesAdd(volumes, cube(shovelerVector3(0, 0, 10), 1.0f));
+  guint unbounded = shovelerBoundingVolumesAdd(volumes, shovelerBoundingVolumesUnboundedBox());
+
+  std::vector<guint32> visibility = cull();
+  ASSERT_TRUE(shovelerBoundingVolumesIsVisible(visibility.data(), inside));
+  ASSERT_FALSE(shovelerBoundingVolumesIsVisible(visibility.data(), behind));
+  ASSERT_FALSE(shovelerBoundingVolumesIsVisible(visibility.data(), tooFar));
+  ASSERT_FALSE(shovelerBoundingVolumesIsVisible(visibility.data(), left));
+  ASSERT_TRUE(shovelerBoundingVolumesIsVisible(visibility.data(), straddling));
+  ASSERT_TRUE(shovelerBoundingVolumesIsVisible(visibility.data(), unbounded));
+  ASSERT_EQ(visibility[0] >> volumes->size, 0) << "bits past the last volume should be cleared";
+}
+
+TEST_F(ShovelerBoundingVolumesTest, update) {
+  guint index = shovelerBoundingVolumesAdd(volumes, cube(shovelerVector3(0, 0, 5), 0.5f));
+  ASSERT_TRUE(shovelerBoundingVolumesIsVisible(cull().data(), index));
+
+  shovelerBoundingVolumesUpdate(volumes, index, cube(shovelerVector3(0, 0, -5), 0.5f));
+  ASSERT_FALSE(shovelerBoundingVolumesIsVisible(cull().data(), index));
+
+  shovelerBoundingVolumesClear(volumes);
+  ASSERT_EQ(volumes->size, 0);
+}
+
+TEST_F(ShovelerBoundingVolumesTest, matchesCornerTest) {
+  static const int numVolumes = 1003; // not a multiple of four to also cover the scalar tail
+
+  srand(0);
+  std::vector<ShovelerBoundingBox3> boxes;
+  for (int i = 0; i < numVolumes; i++) {
+    ShovelerVector3 center = shovelerVector3(
+        30.0f * ((float) rand() / RAND_MAX - 0.5f),
+        30.0f * ((float) rand() / RAND_MAX - 0.5f),
+        30.0f * ((float) rand() / RAND_MAX - 0.5f));
+    ShovelerVector3 halfSize = shovelerVector3(
+        2.0f * (float) rand() / RAND_MAX,
+        2.0f * (float) rand() / RAND_MAX,
+        2.0f * (float) rand() / RAND_MAX);
+    ShovelerBoundingBox3 box = shovelerBoundingBox3(
+        shovelerVector3LinearCombination(1.0f, center, -1.0f, halfSize),
+        shovelerVector3LinearCombination(1.0f, center, 1.0f, halfSize));
+    boxes.push_back(box);
+    shovelerBoundingVolumesAdd(volumes, box);
+  }
+
+  std::vector<guint32> visibility = cull();
+  int numVisible = 0;
+  for (int i = 0; i < numVolumes; i++) {
+    bool visible = shovelerBoundingVolumesIsVisible(visibility.data(), i);
+    ASSERT_EQ(visible, !isOutside(&frustum, boxes[i])) << "volume " << i;
+    numVisible += visible ? 1 : 0;
+  }
+  ASSERT_GT(numVisible, 0);
+  ASSERT_LT(numVisible, numVolumes);
+}
@@ -1,5 +1,17 @@
 #include "shoveler/collider.h"
 
+#include <math.h> // INFINITY
+
+static bool sweepAxes(
+    int numAxes,
+    const float* objectMin,
+    const float* objectMax,
+    const float* displacement,
+    const float* obstacleMin,
+    const float* obstacleMax,
+    float* outputTime,
+    int* outputAxis);
+
 const ShovelerCollider2* shovelerCollider2IntersectFiltered(
     const ShovelerCollider2* collider,
     const ShovelerBoundingBox2* object,
@@ -39,3 +51,209 @@ const ShovelerCollider3* shovelerCollider3IntersectFiltered(
   }
   return NULL;
 }
+
+bool shovelerCollider2SweepFiltered(
+    const ShovelerCollider2* collider,
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    ShovelerCollider2FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider2Contact* outputContact) {
+  ShovelerBoundingBox2 sweptObject = shovelerBoundingBox2Swept(object, displacement);
+  if (!shovelerBoundingBox2Intersect(&collider->boundingBox, &sweptObject)) {
+    return false;
+  }
+
+  ShovelerCollider2Contact contact;
+  if (collider->sweep != NULL) {
+    if (!collider->sweep(
+            collider, object, displacement, filterCandidate, filterCandidateUserData, &contact)) {
+      return false;
+    }
+  } else if (collider->intersect != NULL) {
+    // Without a sweep function, we can only tell whether the target position is blocked.
+    ShovelerBoundingBox2 target = shovelerBoundingBox2(
+        shovelerVector2LinearCombination(1.0f, object->min, 1.0f, displacement),
+        shovelerVector2LinearCombination(1.0f, object->max, 1.0f, displacement));
+    contact.collider =
+        collider->intersect(collider, &target, filterCandidate, filterCandidateUserData);
+    if (contact.collider == NULL) {
+      return false;
+    }
+    contact.time = 0.0f;
+    contact.normal = shovelerVector2(0.0f, 0.0f);
+  } else {
+    if (!shovelerBoundingBox2Sweep(
+            object, displacement, &collider->boundingBox, &contact.time, &contact.normal)) {
+      return false;
+    }
+    contact.collider = collider;
+  }
+
+  if (filterCandidate != NULL && !filterCandidate(contact.collider, filterCandidateUserData)) {
+    return false;
+  }
+
+  *outputContact = contact;
+  return true;
+}
+
+bool shovelerCollider3SweepFiltered(
+    const ShovelerCollider3* collider,
+    const ShovelerBoundingBox3* object,
+    ShovelerVector3 displacement,
+    ShovelerCollider3FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider3Contact* outputContact) {
+  ShovelerBoundingBox3 sweptObject = shovelerBoundingBox3Swept(object, displacement);
+  if (!shovelerBoundingBox3Intersect(&collider->boundingBox, &sweptObject)) {
+    return false;
+  }
+
+  ShovelerCollider3Contact contact;
+  if (collider->sweep != NULL) {
+    if (!collider->sweep(
+            collider, object, displacement, filterCandidate, filterCandidateUserData, &contact)) {
+      return false;
+    }
+  } else if (collider->intersect != NULL) {
+    // Without a sweep function, we can only tell whether the target position is blocked.
+    ShovelerBoundingBox3 target = shovelerBoundingBox3(
+        shovelerVector3LinearCombination(1.0f, object->min, 1.0f, displacement),
+        shovelerVector3LinearCombination(1.0f, object->max, 1.0f, displacement));
+    contact.collider =
+        collider->intersect(collider, &target, filterCandidate, filterCandidateUserData);
+    if (contact.collider == NULL) {
+      return false;
+    }
+    contact.time = 0.0f;
+    contact.normal = shovelerVector3(0.0f, 0.0f, 0.0f);
+  } else {
+    if (!shovelerBoundingBox3Sweep(
+            object, displacement, &collider->boundingBox, &contact.time, &contact.normal)) {
+      return false;
+    }
+    contact.collider = collider;
+  }
+
+  if (filterCandidate != NULL && !filterCandidate(contact.collider, filterCandidateUserData)) {
+    return false;
+  }
+
+  *outputContact = contact;
+  return true;
+}
+
+bool shovelerBoundingBox2Sweep(
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    const ShovelerBoundingBox2* obstacle,
+    float* outputTime,
+    ShovelerVector2* outputNormal) {
+  int axis;
+  if (!sweepAxes(
+          /* numAxes */ 2,
+          object->min.values,
+          object->max.values,
+          displacement.values,
+          obstacle->min.values,
+          obstacle->max.values,
+          outputTime,
+          &axis)) {
+    return false;
+  }
+
+  *outputNormal = shovelerVector2(0.0f, 0.0f);
+  if (axis >= 0) {
+    outputNormal->values[axis] = displacement.values[axis] > 0.0f ? -1.0f : 1.0f;
+  }
+
+  return true;
+}
+
+bool shovelerBoundingBox3Sweep(
+    const ShovelerBoundingBox3* object,
+    ShovelerVector3 displacement,
+    const ShovelerBoundingBox3* obstacle,
+    float* outputTime,
+    ShovelerVector3* outputNormal) {
+  int axis;
+  if (!sweepAxes(
+          /* numAxes */ 3,
+          object->min.values,
+          object->max.values,
+          displacement.values,
+          obstacle->min.values,
+          obstacle->max.values,
+          outputTime,
+          &axis)) {
+    return false;
+  }
+
+  *outputNormal = shovelerVector3(0.0f, 0.0f, 0.0f);
+  if (axis >= 0) {
+    outputNormal->values[axis] = displacement.values[axis] > 0.0f ? -1.0f : 1.0f;
+  }
+
+  return true;
+}
+
+/**
+ * Slab test of a moving box against a static one, writing the axis along which contact is made
+ * or -1 if the boxes are already overlapping at the start.
+ */
+static bool sweepAxes(
+    int numAxes,
+    const float* objectMin,
+    const float* objectMax,
+    const float* displacement,
+    const float* obstacleMin,
+    const float* obstacleMax,
+    float* outputTime,
+    int* outputAxis) {
+  float entryTime = -INFINITY;
+  float exitTime = INFINITY;
+  int entryAxis = -1;
+
+  for (int i = 0; i < numAxes; i++) {
+    if (displacement[i] == 0.0f) {
+      if (objectMax[i] <= obstacleMin[i] || objectMin[i] >= obstacleMax[i]) {
+        return false;
+      }
+      continue;
+    }
+
+    float axisEntryTime;
+    float axisExitTime;
+    if (displacement[i] > 0.0f) {
+      axisEntryTime = (obstacleMin[i] - objectMax[i]) / displacement[i];
+      axisExitTime = (obstacleMax[i] - objectMin[i]) / displacement[i];
+    } else {
+      axisEntryTime = (obstacleMax[i] - objectMin[i]) / displacement[i];
+      axisExitTime = (obstacleMin[i] - objectMax[i]) / displacement[i];
+    }
+
+    if (axisEntryTime > entryTime) {
+      entryTime = axisEntryTime;
+      entryAxis = i;
+    }
+
+    if (axisExitTime < exitTime) {
+      exitTime = axisExitTime;
+    }
+  }
+
+  if (entryTime >= exitTime || entryTime >= 1.0f || exitTime <= 0.0f) {
+    return false;
+  }
+
+  if (entryTime < 0.0f) {
+    *outputTime = 0.0f;
+    *outputAxis = -1;
+    return true;
+  }
+
+  *outputTime = entryTime;
+  *outputAxis = entryAxis;
+  return true;
+}
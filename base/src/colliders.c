@@ -1,30 +1,182 @@
 #include "shoveler/colliders.h"
 
+#include <limits.h> // INT_MIN, INT_MAX
+#include <math.h> // floorf, isfinite
 #include <stdlib.h> // malloc free
+#include <string.h> // memmove
 
 #include "shoveler/collider.h"
+#include "shoveler/hash.h"
+
+#define CELL_KEY(X, Y) ((gint64) (((guint64) (guint32) (X) << 32) | (guint64) (guint32) (Y)))
+
+typedef bool(VisitEntry2Function)(ShovelerCollidersEntry2* entry, void* userData);
+typedef bool(VisitEntry3Function)(ShovelerCollidersEntry3* entry, void* userData);
+
+typedef struct {
+  const ShovelerBoundingBox2* boundingBox;
+  ShovelerCollider2FilterCandidateFunction* filterCandidate;
+  void* filterCandidateUserData;
+  GArray* outputArray;
+  const ShovelerCollider2* firstIntersectingCollider;
+} IntersectContext2;
+
+typedef struct {
+  const ShovelerBoundingBox3* boundingBox;
+  ShovelerCollider3FilterCandidateFunction* filterCandidate;
+  void* filterCandidateUserData;
+  GArray* outputArray;
+  const ShovelerCollider3* firstIntersectingCollider;
+} IntersectContext3;
+
+typedef struct {
+  const ShovelerBoundingBox2* object;
+  ShovelerVector2 displacement;
+  ShovelerCollider2FilterCandidateFunction* filterCandidate;
+  void* filterCandidateUserData;
+  bool hit;
+  ShovelerCollider2Contact contact;
+} SweepContext2;
+
+typedef struct {
+  const ShovelerBoundingBox3* object;
+  ShovelerVector3 displacement;
+  ShovelerCollider3FilterCandidateFunction* filterCandidate;
+  void* filterCandidateUserData;
+  bool hit;
+  ShovelerCollider3Contact contact;
+} SweepContext3;
+
+static bool computeCellRange2(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox2* boundingBox,
+    int* outputMinCellX,
+    int* outputMinCellY,
+    int* outputMaxCellX,
+    int* outputMaxCellY);
+static gint64 countCells(int minCellX, int minCellY, int maxCellX, int maxCellY);
+static void indexCollider2(ShovelerColliders* colliders, ShovelerCollidersEntry2* entry);
+static void unindexCollider2(ShovelerColliders* colliders, ShovelerCollidersEntry2* entry);
+static bool visitEntries2(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox2* region,
+    VisitEntry2Function* visitEntry,
+    void* userData);
+static bool intersectEntry2(ShovelerCollidersEntry2* entry, void* intersectContextPointer);
+static bool sweepEntry2(ShovelerCollidersEntry2* entry, void* sweepContextPointer);
+static void indexCollider3(ShovelerColliders* colliders, ShovelerCollidersEntry3* entry);
+static void unindexCollider3(ShovelerColliders* colliders, ShovelerCollidersEntry3* entry);
+static guint findSweepIndex3(ShovelerColliders* colliders, float minX);
+static void updateMaxSweepExtent3(ShovelerColliders* colliders);
+static bool visitEntries3(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox3* region,
+    VisitEntry3Function* visitEntry,
+    void* userData);
+static bool intersectEntry3(ShovelerCollidersEntry3* entry, void* intersectContextPointer);
+static bool sweepEntry3(ShovelerCollidersEntry3* entry, void* sweepContextPointer);
+static bool isBoundingBox3Finite(const ShovelerBoundingBox3* boundingBox);
+static guint hashCellKey(gconstpointer cellKeyPointer);
+static gboolean equalCellKeys(gconstpointer firstKeyPointer, gconstpointer secondKeyPointer);
+static void freeCell2(void* cellPointer);
 
 ShovelerColliders* shovelerCollidersCreate() {
+  return shovelerCollidersCreateWithCellSize(SHOVELER_COLLIDERS_DEFAULT_CELL_SIZE);
+}
+
+ShovelerColliders* shovelerCollidersCreateWithCellSize(float cellSize2) {
   ShovelerColliders* colliders = malloc(sizeof(ShovelerColliders));
-  colliders->colliders2 = g_hash_table_new(g_direct_hash, g_direct_equal);
-  colliders->colliders3 = g_hash_table_new(g_direct_hash, g_direct_equal);
+  colliders->cellSize2 = cellSize2;
+  colliders->queryId = 0;
+  colliders->colliders2 = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free);
+  colliders->cells2 =
+      g_hash_table_new_full(hashCellKey, equalCellKeys, /* keyDestroyFunc */ NULL, freeCell2);
+  colliders->unboundedColliders2 = g_queue_new();
+  colliders->colliders3 = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free);
+  colliders->sweepColliders3 = g_array_new(
+      /* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerCollidersEntry3*));
+  colliders->maxSweepExtent3 = 0.0f;
+  colliders->maxSweepExtent3Dirty = false;
+  colliders->unboundedColliders3 = g_queue_new();
   return colliders;
 }
 
 bool shovelerCollidersAddCollider2(ShovelerColliders* colliders, ShovelerCollider2* collider) {
-  return g_hash_table_add(colliders->colliders2, (gpointer) collider);
+  if (g_hash_table_contains(colliders->colliders2, collider)) {
+    return false;
+  }
+
+  ShovelerCollidersEntry2* entry = malloc(sizeof(ShovelerCollidersEntry2));
+  entry->collider = collider;
+  entry->lastQueryId = colliders->queryId;
+  indexCollider2(colliders, entry);
+
+  g_hash_table_insert(colliders->colliders2, collider, entry);
+  return true;
 }
 
 bool shovelerCollidersAddCollider3(ShovelerColliders* colliders, ShovelerCollider3* collider) {
-  return g_hash_table_add(colliders->colliders3, (gpointer) collider);
+  if (g_hash_table_contains(colliders->colliders3, collider)) {
+    return false;
+  }
+
+  ShovelerCollidersEntry3* entry = malloc(sizeof(ShovelerCollidersEntry3));
+  entry->collider = collider;
+  indexCollider3(colliders, entry);
+
+  g_hash_table_insert(colliders->colliders3, collider, entry);
+  return true;
+}
+
+bool shovelerCollidersUpdateCollider2(ShovelerColliders* colliders, ShovelerCollider2* collider) {
+  ShovelerCollidersEntry2* entry = g_hash_table_lookup(colliders->colliders2, collider);
+  if (entry == NULL) {
+    return false;
+  }
+
+  int minCellX, minCellY, maxCellX, maxCellY;
+  bool finite = computeCellRange2(
+      colliders, &collider->boundingBox, &minCellX, &minCellY, &maxCellX, &maxCellY);
+  if (finite && !entry->unbounded && minCellX == entry->minCellX &&
+      minCellY == entry->minCellY && maxCellX == entry->maxCellX && maxCellY == entry->maxCellY) {
+    // still overlapping the same cells, nothing to do
+    return true;
+  }
+
+  unindexCollider2(colliders, entry);
+  indexCollider2(colliders, entry);
+  return true;
+}
+
+bool shovelerCollidersUpdateCollider3(ShovelerColliders* colliders, ShovelerCollider3* collider) {
+  ShovelerCollidersEntry3* entry = g_hash_table_lookup(colliders->colliders3, collider);
+  if (entry == NULL) {
+    return false;
+  }
+
+  unindexCollider3(colliders, entry);
+  indexCollider3(colliders, entry);
+  return true;
 }
 
 bool shovelerCollidersRemoveCollider2(ShovelerColliders* colliders, ShovelerCollider2* collider) {
-  return g_hash_table_remove(colliders->colliders2, (gpointer) collider);
+  ShovelerCollidersEntry2* entry = g_hash_table_lookup(colliders->colliders2, collider);
+  if (entry == NULL) {
+    return false;
+  }
+
+  unindexCollider2(colliders, entry);
+  return g_hash_table_remove(colliders->colliders2, collider);
 }
 
 bool shovelerCollidersRemoveCollider3(ShovelerColliders* colliders, ShovelerCollider3* collider) {
-  return g_hash_table_remove(colliders->colliders3, (gpointer) collider);
+  ShovelerCollidersEntry3* entry = g_hash_table_lookup(colliders->colliders3, collider);
+  if (entry == NULL) {
+    return false;
+  }
+
+  unindexCollider3(colliders, entry);
+  return g_hash_table_remove(colliders->colliders3, collider);
 }
 
 const ShovelerCollider2* shovelerCollidersIntersect2Filtered(
@@ -32,18 +184,10 @@ const ShovelerCollider2* shovelerCollidersIntersect2Filtered(
     const ShovelerBoundingBox2* boundingBox,
     ShovelerCollider2FilterCandidateFunction* filterCandidate,
     void* filterCandidateUserData) {
-  GHashTableIter iter;
-  g_hash_table_iter_init(&iter, colliders->colliders2);
-  ShovelerCollider2* collider;
-  while (g_hash_table_iter_next(&iter, (gpointer*) &collider, NULL)) {
-    const ShovelerCollider2* intersectingCollider = shovelerCollider2IntersectFiltered(
-        collider, boundingBox, filterCandidate, filterCandidateUserData);
-    if (intersectingCollider != NULL) {
-      return intersectingCollider;
-    }
-  }
-
-  return NULL;
+  IntersectContext2 context = {
+      boundingBox, filterCandidate, filterCandidateUserData, /* outputArray */ NULL, NULL};
+  visitEntries2(colliders, boundingBox, intersectEntry2, &context);
+  return context.firstIntersectingCollider;
 }
 
 const ShovelerCollider3* shovelerCollidersIntersect3Filtered(
@@ -51,22 +195,474 @@ const ShovelerCollider3* shovelerCollidersIntersect3Filtered(
     const ShovelerBoundingBox3* boundingBox,
     ShovelerCollider3FilterCandidateFunction* filterCandidate,
     void* filterCandidateUserData) {
-  GHashTableIter iter;
-  g_hash_table_iter_init(&iter, colliders->colliders3);
-  ShovelerCollider3* collider;
-  while (g_hash_table_iter_next(&iter, (gpointer*) &collider, NULL)) {
-    const ShovelerCollider3* intersectingCollider = shovelerCollider3IntersectFiltered(
-        collider, boundingBox, filterCandidate, filterCandidateUserData);
-    if (intersectingCollider != NULL) {
-      return intersectingCollider;
-    }
+  IntersectContext3 context = {
+      boundingBox, filterCandidate, filterCandidateUserData, /* outputArray */ NULL, NULL};
+  visitEntries3(colliders, boundingBox, intersectEntry3, &context);
+  return context.firstIntersectingCollider;
+}
+
+void shovelerCollidersIntersectAll2Filtered(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox2* boundingBox,
+    ShovelerCollider2FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    GArray* outputArray) {
+  g_array_set_size(outputArray, 0);
+  IntersectContext2 context = {
+      boundingBox, filterCandidate, filterCandidateUserData, outputArray, NULL};
+  visitEntries2(colliders, boundingBox, intersectEntry2, &context);
+}
+
+void shovelerCollidersIntersectAll3Filtered(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox3* boundingBox,
+    ShovelerCollider3FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    GArray* outputArray) {
+  g_array_set_size(outputArray, 0);
+  IntersectContext3 context = {
+      boundingBox, filterCandidate, filterCandidateUserData, outputArray, NULL};
+  visitEntries3(colliders, boundingBox, intersectEntry3, &context);
+}
+
+bool shovelerCollidersSweep2Filtered(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    ShovelerCollider2FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider2Contact* outputContact) {
+  SweepContext2 context;
+  context.object = object;
+  context.displacement = displacement;
+  context.filterCandidate = filterCandidate;
+  context.filterCandidateUserData = filterCandidateUserData;
+  context.hit = false;
+
+  ShovelerBoundingBox2 sweptObject = shovelerBoundingBox2Swept(object, displacement);
+  visitEntries2(colliders, &sweptObject, sweepEntry2, &context);
+  if (context.hit) {
+    *outputContact = context.contact;
+  }
+
+  return context.hit;
+}
+
+bool shovelerCollidersSweep3Filtered(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox3* object,
+    ShovelerVector3 displacement,
+    ShovelerCollider3FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider3Contact* outputContact) {
+  SweepContext3 context;
+  context.object = object;
+  context.displacement = displacement;
+  context.filterCandidate = filterCandidate;
+  context.filterCandidateUserData = filterCandidateUserData;
+  context.hit = false;
+
+  ShovelerBoundingBox3 sweptObject = shovelerBoundingBox3Swept(object, displacement);
+  visitEntries3(colliders, &sweptObject, sweepEntry3, &context);
+  if (context.hit) {
+    *outputContact = context.contact;
   }
 
-  return NULL;
+  return context.hit;
 }
 
 void shovelerCollidersFree(ShovelerColliders* colliders) {
-  g_hash_table_destroy(colliders->colliders2);
+  g_queue_free(colliders->unboundedColliders3);
+  g_array_free(colliders->sweepColliders3, /* freeSegment */ true);
   g_hash_table_destroy(colliders->colliders3);
+  g_queue_free(colliders->unboundedColliders2);
+  g_hash_table_destroy(colliders->cells2);
+  g_hash_table_destroy(colliders->colliders2);
   free(colliders);
 }
+
+/** Computes the cell range of the given bounding box, returning false if it isn't finite. */
+static bool computeCellRange2(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox2* boundingBox,
+    int* outputMinCellX,
+    int* outputMinCellY,
+    int* outputMaxCellX,
+    int* outputMaxCellY) {
+  float minCellX = floorf(boundingBox->min.values[0] / colliders->cellSize2);
+  float minCellY = floorf(boundingBox->min.values[1] / colliders->cellSize2);
+  float maxCellX = floorf(boundingBox->max.values[0] / colliders->cellSize2);
+  float maxCellY = floorf(boundingBox->max.values[1] / colliders->cellSize2);
+  if (!isfinite(minCellX) || !isfinite(minCellY) || !isfinite(maxCellX) || !isfinite(maxCellY) ||
+      minCellX <= (float) INT_MIN || maxCellX >= (float) INT_MAX || minCellY <= (float) INT_MIN ||
+      maxCellY >= (float) INT_MAX) {
+    return false;
+  }
+
+  *outputMinCellX = (int) minCellX;
+  *outputMinCellY = (int) minCellY;
+  *outputMaxCellX = (int) maxCellX;
+  *outputMaxCellY = (int) maxCellY;
+  return true;
+}
+
+static gint64 countCells(int minCellX, int minCellY, int maxCellX, int maxCellY) {
+  return ((gint64) maxCellX - minCellX + 1) * ((gint64) maxCellY - minCellY + 1);
+}
+
+static void indexCollider2(ShovelerColliders* colliders, ShovelerCollidersEntry2* entry) {
+  bool finite = computeCellRange2(
+      colliders,
+      &entry->collider->boundingBox,
+      &entry->minCellX,
+      &entry->minCellY,
+      &entry->maxCellX,
+      &entry->maxCellY);
+  entry->unbounded = !finite ||
+      countCells(entry->minCellX, entry->minCellY, entry->maxCellX, entry->maxCellY) >
+          SHOVELER_COLLIDERS_MAX_CELLS_PER_COLLIDER;
+  if (entry->unbounded) {
+    g_queue_push_tail(colliders->unboundedColliders2, entry);
+    return;
+  }
+
+  for (int cellX = entry->minCellX; cellX <= entry->maxCellX; cellX++) {
+    for (int cellY = entry->minCellY; cellY <= entry->maxCellY; cellY++) {
+      gint64 key = CELL_KEY(cellX, cellY);
+      ShovelerCollidersCell2* cell = g_hash_table_lookup(colliders->cells2, &key);
+      if (cell == NULL) {
+        cell = malloc(sizeof(ShovelerCollidersCell2));
+        cell->key = key;
+        cell->entries = g_queue_new();
+        g_hash_table_insert(colliders->cells2, &cell->key, cell);
+      }
+
+      g_queue_push_tail(cell->entries, entry);
+    }
+  }
+}
+
+/** Removes an entry from the index using the cell range stored in it. */
+static void unindexCollider2(ShovelerColliders* colliders, ShovelerCollidersEntry2* entry) {
+  if (entry->unbounded) {
+    g_queue_remove(colliders->unboundedColliders2, entry);
+    return;
+  }
+
+  for (int cellX = entry->minCellX; cellX <= entry->maxCellX; cellX++) {
+    for (int cellY = entry->minCellY; cellY <= entry->maxCellY; cellY++) {
+      gint64 key = CELL_KEY(cellX, cellY);
+      ShovelerCollidersCell2* cell = g_hash_table_lookup(colliders->cells2, &key);
+      if (cell == NULL) {
+        continue;
+      }
+
+      g_queue_remove(cell->entries, entry);
+      if (g_queue_get_length(cell->entries) == 0) {
+        g_hash_table_remove(colliders->cells2, &key);
+      }
+    }
+  }
+}
+
+/** Visits all entries in the region, stopping early if the visitor returns true. */
+static bool visitEntries2(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox2* region,
+    VisitEntry2Function* visitEntry,
+    void* userData) {
+  colliders->queryId++;
+
+  for (GList* iter = colliders->unboundedColliders2->head; iter != NULL; iter = iter->next) {
+    ShovelerCollidersEntry2* entry = iter->data;
+    entry->lastQueryId = colliders->queryId;
+    if (visitEntry(entry, userData)) {
+      return true;
+    }
+  }
+
+  int minCellX, minCellY, maxCellX, maxCellY;
+  bool finite = computeCellRange2(colliders, region, &minCellX, &minCellY, &maxCellX, &maxCellY);
+  gint64 numCells = finite ? countCells(minCellX, minCellY, maxCellX, maxCellY) : 0;
+  if (!finite ||
+      (numCells > SHOVELER_COLLIDERS_MAX_CELLS_PER_QUERY &&
+       numCells > (gint64) g_hash_table_size(colliders->colliders2))) {
+    // The query covers more cells than there are colliders, so it is cheaper to check them all.
+    // Smaller queries always walk the grid so that the first hit is found in a deterministic order.
+    GHashTableIter entryIter;
+    ShovelerCollidersEntry2* entry;
+    g_hash_table_iter_init(&entryIter, colliders->colliders2);
+    while (g_hash_table_iter_next(&entryIter, NULL, (gpointer*) &entry)) {
+      if (entry->lastQueryId == colliders->queryId) {
+        continue;
+      }
+      entry->lastQueryId = colliders->queryId;
+
+      if (visitEntry(entry, userData)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  for (int cellX = minCellX; cellX <= maxCellX; cellX++) {
+    for (int cellY = minCellY; cellY <= maxCellY; cellY++) {
+      gint64 key = CELL_KEY(cellX, cellY);
+      ShovelerCollidersCell2* cell = g_hash_table_lookup(colliders->cells2, &key);
+      if (cell == NULL) {
+        continue;
+      }
+
+      for (GList* iter = cell->entries->head; iter != NULL; iter = iter->next) {
+        ShovelerCollidersEntry2* entry = iter->data;
+        if (entry->lastQueryId == colliders->queryId) {
+          continue;
+        }
+        entry->lastQueryId = colliders->queryId;
+
+        if (visitEntry(entry, userData)) {
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+static bool intersectEntry2(ShovelerCollidersEntry2* entry, void* intersectContextPointer) {
+  IntersectContext2* context = intersectContextPointer;
+
+  const ShovelerCollider2* intersectingCollider = shovelerCollider2IntersectFiltered(
+      entry->collider,
+      context->boundingBox,
+      context->filterCandidate,
+      context->filterCandidateUserData);
+  if (intersectingCollider == NULL) {
+    return false;
+  }
+
+  if (context->firstIntersectingCollider == NULL) {
+    context->firstIntersectingCollider = intersectingCollider;
+  }
+
+  if (context->outputArray == NULL) {
+    return true;
+  }
+
+  g_array_append_val(context->outputArray, intersectingCollider);
+  return false;
+}
+
+static bool sweepEntry2(ShovelerCollidersEntry2* entry, void* sweepContextPointer) {
+  SweepContext2* context = sweepContextPointer;
+
+  ShovelerCollider2Contact contact;
+  if (shovelerCollider2SweepFiltered(
+          entry->collider,
+          context->object,
+          context->displacement,
+          context->filterCandidate,
+          context->filterCandidateUserData,
+          &contact) &&
+      (!context->hit ||
+       shovelerCollider2ContactPrecedes(
+           contact.time, contact.normal, context->contact.time, context->contact.normal))) {
+    context->hit = true;
+    context->contact = contact;
+  }
+
+  return false;
+}
+
+static void indexCollider3(ShovelerColliders* colliders, ShovelerCollidersEntry3* entry) {
+  entry->indexedBoundingBox = entry->collider->boundingBox;
+  entry->unbounded = !isBoundingBox3Finite(&entry->indexedBoundingBox);
+  if (entry->unbounded) {
+    g_queue_push_tail(colliders->unboundedColliders3, entry);
+    return;
+  }
+
+  float minX = entry->indexedBoundingBox.min.values[0];
+  float extentX = entry->indexedBoundingBox.max.values[0] - minX;
+  if (extentX > colliders->maxSweepExtent3) {
+    colliders->maxSweepExtent3 = extentX;
+  }
+
+  guint index = findSweepIndex3(colliders, minX);
+  GArray* sweepColliders = colliders->sweepColliders3;
+  g_array_set_size(sweepColliders, sweepColliders->len + 1);
+  ShovelerCollidersEntry3** sweepEntries = (ShovelerCollidersEntry3**) sweepColliders->data;
+  memmove(
+      &sweepEntries[index + 1],
+      &sweepEntries[index],
+      (sweepColliders->len - 1 - index) * sizeof(ShovelerCollidersEntry3*));
+  sweepEntries[index] = entry;
+}
+
+static void unindexCollider3(ShovelerColliders* colliders, ShovelerCollidersEntry3* entry) {
+  if (entry->unbounded) {
+    g_queue_remove(colliders->unboundedColliders3, entry);
+    return;
+  }
+
+  float minX = entry->indexedBoundingBox.min.values[0];
+  GArray* sweepColliders = colliders->sweepColliders3;
+  ShovelerCollidersEntry3** sweepEntries = (ShovelerCollidersEntry3**) sweepColliders->data;
+  for (guint i = findSweepIndex3(colliders, minX); i < sweepColliders->len; i++) {
+    if (sweepEntries[i] == entry) {
+      memmove(
+          &sweepEntries[i],
+          &sweepEntries[i + 1],
+          (sweepColliders->len - 1 - i) * sizeof(ShovelerCollidersEntry3*));
+      g_array_set_size(sweepColliders, sweepColliders->len - 1);
+      break;
+    }
+  }
+
+  float extentX = entry->indexedBoundingBox.max.values[0] - minX;
+  if (extentX >= colliders->maxSweepExtent3) {
+    colliders->maxSweepExtent3Dirty = true;
+  }
+}
+
+/** Returns the first index in the sweep array whose minimum x coordinate is not less than minX. */
+static guint findSweepIndex3(ShovelerColliders* colliders, float minX) {
+  guint low = 0;
+  guint high = colliders->sweepColliders3->len;
+  while (low < high) {
+    guint middle = low + (high - low) / 2;
+    ShovelerCollidersEntry3* entry =
+        g_array_index(colliders->sweepColliders3, ShovelerCollidersEntry3*, middle);
+    if (entry->indexedBoundingBox.min.values[0] < minX) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  return low;
+}
+
+static void updateMaxSweepExtent3(ShovelerColliders* colliders) {
+  if (!colliders->maxSweepExtent3Dirty) {
+    return;
+  }
+
+  colliders->maxSweepExtent3 = 0.0f;
+  for (guint i = 0; i < colliders->sweepColliders3->len; i++) {
+    ShovelerCollidersEntry3* entry =
+        g_array_index(colliders->sweepColliders3, ShovelerCollidersEntry3*, i);
+    float extentX =
+        entry->indexedBoundingBox.max.values[0] - entry->indexedBoundingBox.min.values[0];
+    if (extentX > colliders->maxSweepExtent3) {
+      colliders->maxSweepExtent3 = extentX;
+    }
+  }
+
+  colliders->maxSweepExtent3Dirty = false;
+}
+
+/** Visits all entries in the region, stopping early if the visitor returns true. */
+static bool visitEntries3(
+    ShovelerColliders* colliders,
+    const ShovelerBoundingBox3* region,
+    VisitEntry3Function* visitEntry,
+    void* userData) {
+  for (GList* iter = colliders->unboundedColliders3->head; iter != NULL; iter = iter->next) {
+    if (visitEntry(iter->data, userData)) {
+      return true;
+    }
+  }
+
+  updateMaxSweepExtent3(colliders);
+
+  // Any collider starting before this can't reach into the query box along the x axis.
+  float sweepStartX = region->min.values[0] - colliders->maxSweepExtent3;
+  for (guint i = findSweepIndex3(colliders, sweepStartX); i < colliders->sweepColliders3->len;
+       i++) {
+    ShovelerCollidersEntry3* entry =
+        g_array_index(colliders->sweepColliders3, ShovelerCollidersEntry3*, i);
+    if (entry->indexedBoundingBox.min.values[0] >= region->max.values[0]) {
+      break;
+    }
+
+    if (visitEntry(entry, userData)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static bool intersectEntry3(ShovelerCollidersEntry3* entry, void* intersectContextPointer) {
+  IntersectContext3* context = intersectContextPointer;
+
+  const ShovelerCollider3* intersectingCollider = shovelerCollider3IntersectFiltered(
+      entry->collider,
+      context->boundingBox,
+      context->filterCandidate,
+      context->filterCandidateUserData);
+  if (intersectingCollider == NULL) {
+    return false;
+  }
+
+  if (context->firstIntersectingCollider == NULL) {
+    context->firstIntersectingCollider = intersectingCollider;
+  }
+
+  if (context->outputArray == NULL) {
+    return true;
+  }
+
+  g_array_append_val(context->outputArray, intersectingCollider);
+  return false;
+}
+
+static bool sweepEntry3(ShovelerCollidersEntry3* entry, void* sweepContextPointer) {
+  SweepContext3* context = sweepContextPointer;
+
+  ShovelerCollider3Contact contact;
+  if (shovelerCollider3SweepFiltered(
+          entry->collider,
+          context->object,
+          context->displacement,
+          context->filterCandidate,
+          context->filterCandidateUserData,
+          &contact) &&
+      (!context->hit ||
+       shovelerCollider3ContactPrecedes(
+           contact.time, contact.normal, context->contact.time, context->contact.normal))) {
+    context->hit = true;
+    context->contact = contact;
+  }
+
+  return false;
+}
+
+static bool isBoundingBox3Finite(const ShovelerBoundingBox3* boundingBox) {
+  for (int i = 0; i < 3; i++) {
+    if (!isfinite(boundingBox->min.values[i]) || !isfinite(boundingBox->max.values[i])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static guint hashCellKey(gconstpointer cellKeyPointer) {
+  // g_int64_hash folds the upper into the lower half, which would collide for nearby cells
+  guint64 cellKey = (guint64) *(const gint64*) cellKeyPointer;
+  return shovelerHashCombine((guint) (cellKey >> 32), (guint) cellKey);
+}
+
+static gboolean equalCellKeys(gconstpointer firstKeyPointer, gconstpointer secondKeyPointer) {
+  return *(const gint64*) firstKeyPointer == *(const gint64*) secondKeyPointer;
+}
+
+static void freeCell2(void* cellPointer) {
+  ShovelerCollidersCell2* cell = cellPointer;
+  g_queue_free(cell->entries);
+  free(cell);
+}
@@ -0,0 +1,193 @@
+#include <shoveler/collider.h>
+#include <shoveler/collider/box.h>
+#include <shoveler/colliders.h>
+#include <shoveler/log.h>
+#include <shoveler/types.h>
+#include <stdlib.h> // EXIT_SUCCESS, malloc, free, rand
+#include <string.h> // memcpy
+
+#define NUM_TILE_COLUMNS 250
+#define NUM_TILE_ROWS 200
+#define NUM_MOVERS 1000
+#define NUM_FRAMES 20
+#define MOVER_SIZE 0.8f
+#define MOVER_SPEED 0.05f
+
+typedef struct {
+  ShovelerCollider2 collider;
+  ShovelerVector2 position;
+  ShovelerVector2 velocity;
+} Mover;
+
+static bool filterSelf(const ShovelerCollider2* candidate, void* moverPointer);
+static ShovelerBoundingBox2 computeMoverBoundingBox(ShovelerVector2 position);
+static gint64 runBroadphase(ShovelerColliders* colliders, Mover* movers, int* outputNumHits);
+static gint64 runLinear(
+    ShovelerCollider2** allColliders, int numColliders, Mover* movers, int* outputNumHits);
+
+int main(int argc, char* argv[]) {
+  shovelerLogInit("shoveler/", SHOVELER_LOG_LEVEL_INFO_UP, stdout);
+  srand(0);
+
+  // Tiles are laid out in a checkerboard pattern so that movers have free space to move around in.
+  int numTiles = NUM_TILE_COLUMNS * NUM_TILE_ROWS;
+  ShovelerCollider2* tiles = malloc(numTiles * sizeof(ShovelerCollider2));
+  for (int row = 0; row < NUM_TILE_ROWS; row++) {
+    for (int column = 0; column < NUM_TILE_COLUMNS; column++) {
+      float x = (float) (2 * column + row % 2);
+      float y = (float) row;
+      tiles[row * NUM_TILE_COLUMNS + column] = shovelerColliderBox2(
+          shovelerBoundingBox2(shovelerVector2(x, y), shovelerVector2(x + 1.0f, y + 1.0f)));
+    }
+  }
+
+  Mover* movers = malloc(NUM_MOVERS * sizeof(Mover));
+  for (int i = 0; i < NUM_MOVERS; i++) {
+    Mover* mover = &movers[i];
+    // spawn each mover in the center of a free checkerboard cell
+    int row = rand() % NUM_TILE_ROWS;
+    int column = rand() % NUM_TILE_COLUMNS;
+    mover->position = shovelerVector2(
+        (float) (2 * column + (row + 1) % 2) + 0.5f, (float) row + 0.5f);
+    mover->velocity = shovelerVector2(
+        MOVER_SPEED * ((float) rand() / RAND_MAX - 0.5f),
+        MOVER_SPEED * ((float) rand() / RAND_MAX - 0.5f));
+    mover->collider = shovelerColliderBox2(computeMoverBoundingBox(mover->position));
+    mover->collider.data = mover;
+  }
+
+  // both runs start from the same mover state, so that they simulate exactly the same frames
+  Mover* initialMovers = malloc(NUM_MOVERS * sizeof(Mover));
+  memcpy(initialMovers, movers, NUM_MOVERS * sizeof(Mover));
+
+  ShovelerColliders* colliders = shovelerCollidersCreate();
+  gint64 insertStartTime = g_get_monotonic_time();
+  for (int i = 0; i < numTiles; i++) {
+    shovelerCollidersAddCollider2(colliders, &tiles[i]);
+  }
+  for (int i = 0; i < NUM_MOVERS; i++) {
+    shovelerCollidersAddCollider2(colliders, &movers[i].collider);
+  }
+  gint64 insertTimeUs = g_get_monotonic_time() - insertStartTime;
+  shovelerLogInfo(
+      "Inserted %d static tiles and %d movers in %.2fms.",
+      numTiles,
+      NUM_MOVERS,
+      (double) insertTimeUs / 1000.0);
+
+  int numBroadphaseHits = 0;
+  gint64 broadphaseTimeUs = runBroadphase(colliders, movers, &numBroadphaseHits);
+  shovelerLogInfo(
+      "Broadphase: %d frames of %d movers took %.3fms per frame (%d hits).",
+      NUM_FRAMES,
+      NUM_MOVERS,
+      (double) broadphaseTimeUs / NUM_FRAMES / 1000.0,
+      numBroadphaseHits);
+
+  // The linear baseline checks every mover against all tiles and other movers.
+  int numColliders = numTiles + NUM_MOVERS;
+  ShovelerCollider2** allColliders = malloc(numColliders * sizeof(ShovelerCollider2*));
+  for (int i = 0; i < numTiles; i++) {
+    allColliders[i] = &tiles[i];
+  }
+  for (int i = 0; i < NUM_MOVERS; i++) {
+    allColliders[numTiles + i] = &movers[i].collider;
+  }
+
+  memcpy(movers, initialMovers, NUM_MOVERS * sizeof(Mover));
+  int numLinearHits = 0;
+  gint64 linearTimeUs = runLinear(allColliders, numColliders, movers, &numLinearHits);
+  shovelerLogInfo(
+      "Linear scan: %d frames of %d movers took %.3fms per frame (%d hits).",
+      NUM_FRAMES,
+      NUM_MOVERS,
+      (double) linearTimeUs / NUM_FRAMES / 1000.0,
+      numLinearHits);
+
+  if (numLinearHits != numBroadphaseHits) {
+    shovelerLogWarning(
+        "Broadphase and linear scan disagree on the number of hits (%d != %d).",
+        numBroadphaseHits,
+        numLinearHits);
+  }
+
+  shovelerCollidersFree(colliders);
+  free(allColliders);
+  free(initialMovers);
+  free(movers);
+  free(tiles);
+  shovelerLogTerminate();
+
+  return EXIT_SUCCESS;
+}
+
+static bool filterSelf(const ShovelerCollider2* candidate, void* moverPointer) {
+  Mover* mover = moverPointer;
+  return candidate != &mover->collider;
+}
+
+static ShovelerBoundingBox2 computeMoverBoundingBox(ShovelerVector2 position) {
+  return shovelerBoundingBox2(
+      shovelerVector2LinearCombination(
+          1.0f, position, -0.5f * MOVER_SIZE, shovelerVector2(1.0f, 1.0f)),
+      shovelerVector2LinearCombination(
+          1.0f, position, 0.5f * MOVER_SIZE, shovelerVector2(1.0f, 1.0f)));
+}
+
+static gint64 runBroadphase(ShovelerColliders* colliders, Mover* movers, int* outputNumHits) {
+  gint64 startTime = g_get_monotonic_time();
+  for (int frame = 0; frame < NUM_FRAMES; frame++) {
+    for (int i = 0; i < NUM_MOVERS; i++) {
+      Mover* mover = &movers[i];
+      ShovelerVector2 targetPosition =
+          shovelerVector2LinearCombination(1.0f, mover->position, 1.0f, mover->velocity);
+      ShovelerBoundingBox2 targetBoundingBox = computeMoverBoundingBox(targetPosition);
+
+      if (shovelerCollidersIntersect2Filtered(colliders, &targetBoundingBox, filterSelf, mover) !=
+          NULL) {
+        mover->velocity = shovelerVector2(-mover->velocity.values[1], mover->velocity.values[0]);
+        (*outputNumHits)++;
+        continue;
+      }
+
+      mover->position = targetPosition;
+      mover->collider.boundingBox = targetBoundingBox;
+      shovelerCollidersUpdateCollider2(colliders, &mover->collider);
+    }
+  }
+
+  return g_get_monotonic_time() - startTime;
+}
+
+static gint64 runLinear(
+    ShovelerCollider2** allColliders, int numColliders, Mover* movers, int* outputNumHits) {
+  gint64 startTime = g_get_monotonic_time();
+  for (int frame = 0; frame < NUM_FRAMES; frame++) {
+    for (int i = 0; i < NUM_MOVERS; i++) {
+      Mover* mover = &movers[i];
+      ShovelerVector2 targetPosition =
+          shovelerVector2LinearCombination(1.0f, mover->position, 1.0f, mover->velocity);
+      ShovelerBoundingBox2 targetBoundingBox = computeMoverBoundingBox(targetPosition);
+
+      bool hit = false;
+      for (int j = 0; j < numColliders; j++) {
+        if (allColliders[j] != &mover->collider &&
+            shovelerCollider2Intersect(allColliders[j], &targetBoundingBox) != NULL) {
+          hit = true;
+          break;
+        }
+      }
+
+      if (hit) {
+        mover->velocity = shovelerVector2(-mover->velocity.values[1], mover->velocity.values[0]);
+        (*outputNumHits)++;
+        continue;
+      }
+
+      mover->position = targetPosition;
+      mover->collider.boundingBox = targetBoundingBox;
+    }
+  }
+
+  return g_get_monotonic_time() - startTime;
+}
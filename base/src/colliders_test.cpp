@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
 #include <string>
 
 extern "C" {
@@ -81,3 +82,251 @@ TEST_F(ShovelerCollidersTest, intersect3) {
       shovelerCollidersIntersect3(colliders, &notIntersectingBox);
   ASSERT_TRUE(notIntersectingCollider == NULL);
 }
+
+TEST_F(ShovelerCollidersTest, intersectAll2) {
+  ShovelerCollider2 collider = shovelerColliderBox2(
+      shovelerBoundingBox2(shovelerVector2(0.0f, 0.0f), shovelerVector2(5.0f, 5.0f)));
+  ShovelerCollider2 collider2 = shovelerColliderBox2(
+      shovelerBoundingBox2(shovelerVector2(-5.0f, -5.0f), shovelerVector2(0.0f, 0.0f)));
+  ShovelerCollider2 collider3 = shovelerColliderBox2(
+      shovelerBoundingBox2(shovelerVector2(10.0f, 10.0f), shovelerVector2(15.0f, 15.0f)));
+  shovelerCollidersAddCollider2(colliders, &collider);
+  shovelerCollidersAddCollider2(colliders, &collider2);
+  shovelerCollidersAddCollider2(colliders, &collider3);
+
+  GArray* intersectingColliders =
+      g_array_new(/* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerCollider2*));
+
+  ShovelerBoundingBox2 bothIntersectingBox =
+      shovelerBoundingBox2(shovelerVector2(-2.5f, -2.5f), shovelerVector2(2.5f, 2.5f));
+  shovelerCollidersIntersectAll2(colliders, &bothIntersectingBox, intersectingColliders);
+  ASSERT_EQ(intersectingColliders->len, 2);
+  const ShovelerCollider2* first =
+      g_array_index(intersectingColliders, const ShovelerCollider2*, 0);
+  const ShovelerCollider2* second =
+      g_array_index(intersectingColliders, const ShovelerCollider2*, 1);
+  ASSERT_TRUE(first == &collider || first == &collider2);
+  ASSERT_TRUE(second == &collider || second == &collider2);
+  ASSERT_NE(first, second);
+
+  ShovelerBoundingBox2 notIntersectingBox =
+      shovelerBoundingBox2(shovelerVector2(-7.5f, 2.5f), shovelerVector2(-2.5f, 7.5f));
+  shovelerCollidersIntersectAll2(colliders, &notIntersectingBox, intersectingColliders);
+  ASSERT_EQ(intersectingColliders->len, 0);
+
+  g_array_free(intersectingColliders, /* freeSegment */ true);
+}
+
+TEST_F(ShovelerCollidersTest, update2) {
+  ShovelerCollider2 collider = shovelerColliderBox2(
+      shovelerBoundingBox2(shovelerVector2(0.0f, 0.0f), shovelerVector2(5.0f, 5.0f)));
+  shovelerCollidersAddCollider2(colliders, &collider);
+
+  ShovelerBoundingBox2 previousBox =
+      shovelerBoundingBox2(shovelerVector2(1.0f, 1.0f), shovelerVector2(2.0f, 2.0f));
+  ShovelerBoundingBox2 movedBox =
+      shovelerBoundingBox2(shovelerVector2(101.0f, 101.0f), shovelerVector2(102.0f, 102.0f));
+  ASSERT_EQ(shovelerCollidersIntersect2(colliders, &previousBox), &collider);
+  ASSERT_TRUE(shovelerCollidersIntersect2(colliders, &movedBox) == NULL);
+
+  collider.boundingBox =
+      shovelerBoundingBox2(shovelerVector2(100.0f, 100.0f), shovelerVector2(105.0f, 105.0f));
+  bool updated = shovelerCollidersUpdateCollider2(colliders, &collider);
+  ASSERT_TRUE(updated);
+  ASSERT_TRUE(shovelerCollidersIntersect2(colliders, &previousBox) == NULL);
+  ASSERT_EQ(shovelerCollidersIntersect2(colliders, &movedBox), &collider);
+
+  bool removed = shovelerCollidersRemoveCollider2(colliders, &collider);
+  ASSERT_TRUE(removed);
+  ASSERT_TRUE(shovelerCollidersIntersect2(colliders, &movedBox) == NULL);
+  ASSERT_FALSE(shovelerCollidersUpdateCollider2(colliders, &collider));
+}
+
+TEST_F(ShovelerCollidersTest, intersectUnbounded2) {
+  ShovelerCollider2 unboundedCollider = shovelerColliderBox2(shovelerBoundingBox2(
+      shovelerVector2(-INFINITY, -INFINITY), shovelerVector2(INFINITY, INFINITY)));
+  ShovelerCollider2 largeCollider = shovelerColliderBox2(
+      shovelerBoundingBox2(shovelerVector2(0.0f, 0.0f), shovelerVector2(1000.0f, 1000.0f)));
+  shovelerCollidersAddCollider2(colliders, &unboundedCollider);
+  shovelerCollidersAddCollider2(colliders, &largeCollider);
+
+  GArray* intersectingColliders =
+      g_array_new(/* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerCollider2*));
+
+  ShovelerBoundingBox2 farBox =
+      shovelerBoundingBox2(shovelerVector2(-5000.0f, 5000.0f), shovelerVector2(-4000.0f, 6000.0f));
+  shovelerCollidersIntersectAll2(colliders, &farBox, intersectingColliders);
+  ASSERT_EQ(intersectingColliders->len, 1);
+  ASSERT_EQ(g_array_index(intersectingColliders, const ShovelerCollider2*, 0), &unboundedCollider);
+
+  ShovelerBoundingBox2 insideBox =
+      shovelerBoundingBox2(shovelerVector2(500.0f, 500.0f), shovelerVector2(501.0f, 501.0f));
+  shovelerCollidersIntersectAll2(colliders, &insideBox, intersectingColliders);
+  ASSERT_EQ(intersectingColliders->len, 2);
+
+  g_array_free(intersectingColliders, /* freeSegment */ true);
+}
+
+TEST_F(ShovelerCollidersTest, intersectAll3) {
+  ShovelerCollider3 collider = shovelerColliderBox3(
+      shovelerBoundingBox3(shovelerVector3(0.0f, 0.0f, 0.0f), shovelerVector3(5.0f, 5.0f, 5.0f)));
+  ShovelerCollider3 collider2 = shovelerColliderBox3(shovelerBoundingBox3(
+      shovelerVector3(-5.0f, -5.0f, -5.0f), shovelerVector3(0.0f, 0.0f, 0.0f)));
+  ShovelerCollider3 wideCollider = shovelerColliderBox3(shovelerBoundingBox3(
+      shovelerVector3(-100.0f, -5.0f, -5.0f), shovelerVector3(100.0f, -4.0f, -4.0f)));
+  shovelerCollidersAddCollider3(colliders, &collider);
+  shovelerCollidersAddCollider3(colliders, &collider2);
+  shovelerCollidersAddCollider3(colliders, &wideCollider);
+
+  GArray* intersectingColliders =
+      g_array_new(/* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerCollider3*));
+
+  ShovelerBoundingBox3 bothIntersectingBox =
+      shovelerBoundingBox3(shovelerVector3(-2.5f, -2.5f, -2.5f), shovelerVector3(2.5f, 2.5f, 2.5f));
+  shovelerCollidersIntersectAll3(colliders, &bothIntersectingBox, intersectingColliders);
+  ASSERT_EQ(intersectingColliders->len, 2);
+
+  ShovelerBoundingBox3 wideIntersectingBox = shovelerBoundingBox3(
+      shovelerVector3(90.0f, -4.5f, -4.5f), shovelerVector3(91.0f, -3.5f, -3.5f));
+  shovelerCollidersIntersectAll3(colliders, &wideIntersectingBox, intersectingColliders);
+  ASSERT_EQ(intersectingColliders->len, 1);
+  ASSERT_EQ(g_array_index(intersectingColliders, const ShovelerCollider3*, 0), &wideCollider);
+
+  g_array_free(intersectingColliders, /* freeSegment */ true);
+}
+
+TEST_F(ShovelerCollidersTest, update3) {
+  ShovelerCollider3 collider = shovelerColliderBox3(
+      shovelerBoundingBox3(shovelerVector3(0.0f, 0.0f, 0.0f), shovelerVector3(5.0f, 5.0f, 5.0f)));
+  shovelerCollidersAddCollider3(colliders, &collider);
+
+  ShovelerBoundingBox3 previousBox =
+      shovelerBoundingBox3(shovelerVector3(1.0f, 1.0f, 1.0f), shovelerVector3(2.0f, 2.0f, 2.0f));
+  ShovelerBoundingBox3 movedBox = shovelerBoundingBox3(
+      shovelerVector3(-99.0f, 1.0f, 1.0f), shovelerVector3(-98.0f, 2.0f, 2.0f));
+  ASSERT_EQ(shovelerCollidersIntersect3(colliders, &previousBox), &collider);
+  ASSERT_TRUE(shovelerCollidersIntersect3(colliders, &movedBox) == NULL);
+
+  collider.boundingBox = shovelerBoundingBox3(
+      shovelerVector3(-100.0f, 0.0f, 0.0f), shovelerVector3(-95.0f, 5.0f, 5.0f));
+  bool updated = shovelerCollidersUpdateCollider3(colliders, &collider);
+  ASSERT_TRUE(updated);
+  ASSERT_TRUE(shovelerCollidersIntersect3(colliders, &previousBox) == NULL);
+  ASSERT_EQ(shovelerCollidersIntersect3(colliders, &movedBox), &collider);
+
+  bool removed = shovelerCollidersRemoveCollider3(colliders, &collider);
+  ASSERT_TRUE(removed);
+  ASSERT_TRUE(shovelerCollidersIntersect3(colliders, &movedBox) == NULL);
+}
+
+TEST_F(ShovelerCollidersTest, sweep2) {
+  ShovelerCollider2 thinWall = shovelerColliderBox2(
+      shovelerBoundingBox2(shovelerVector2(5.0f, 0.0f), shovelerVector2(5.1f, 1.0f)));
+  ShovelerCollider2 farWall = shovelerColliderBox2(
+      shovelerBoundingBox2(shovelerVector2(8.0f, 0.0f), shovelerVector2(9.0f, 1.0f)));
+  shovelerCollidersAddCollider2(colliders, &farWall);
+  shovelerCollidersAddCollider2(colliders, &thinWall);
+
+  // moving far enough to end up behind both walls, which a destination check would miss
+  ShovelerBoundingBox2 object =
+      shovelerBoundingBox2(shovelerVector2(0.0f, 0.25f), shovelerVector2(0.5f, 0.75f));
+  ShovelerVector2 displacement = shovelerVector2(10.0f, 0.0f);
+  ShovelerBoundingBox2 target =
+      shovelerBoundingBox2(shovelerVector2(10.0f, 0.25f), shovelerVector2(10.5f, 0.75f));
+  ASSERT_EQ(shovelerCollidersIntersect2(colliders, &target), nullptr);
+
+  ShovelerCollider2Contact contact;
+  bool hit = shovelerCollidersSweep2(colliders, &object, displacement, &contact);
+  ASSERT_TRUE(hit);
+  ASSERT_EQ(contact.collider, &thinWall);
+  ASSERT_FLOAT_EQ(contact.time, 0.45f);
+  ASSERT_EQ(contact.normal.values[0], -1.0f);
+  ASSERT_EQ(contact.normal.values[1], 0.0f);
+
+  ShovelerVector2 missingDisplacement = shovelerVector2(10.0f, 1.0f);
+  ShovelerBoundingBox2 missingObject =
+      shovelerBoundingBox2(shovelerVector2(0.0f, 1.0f), shovelerVector2(0.5f, 1.5f));
+  bool missingHit =
+      shovelerCollidersSweep2(colliders, &missingObject, missingDisplacement, &contact);
+  ASSERT_FALSE(missingHit);
+}
+
+TEST_F(ShovelerCollidersTest, sweep3) {
+  ShovelerCollider3 thinWall = shovelerColliderBox3(shovelerBoundingBox3(
+      shovelerVector3(0.0f, 0.0f, -5.1f), shovelerVector3(1.0f, 1.0f, -5.0f)));
+  shovelerCollidersAddCollider3(colliders, &thinWall);
+
+  ShovelerBoundingBox3 object = shovelerBoundingBox3(
+      shovelerVector3(0.25f, 0.25f, 0.0f), shovelerVector3(0.75f, 0.75f, 0.5f));
+  ShovelerCollider3Contact contact;
+  bool hit =
+      shovelerCollidersSweep3(colliders, &object, shovelerVector3(0.0f, 0.0f, -10.0f), &contact);
+  ASSERT_TRUE(hit);
+  ASSERT_EQ(contact.collider, &thinWall);
+  ASSERT_FLOAT_EQ(contact.time, 0.5f);
+  ASSERT_EQ(contact.normal.values[2], 1.0f);
+
+  // already overlapping at the start
+  ShovelerBoundingBox3 overlappingObject = shovelerBoundingBox3(
+      shovelerVector3(0.25f, 0.25f, -5.5f), shovelerVector3(0.75f, 0.75f, -4.5f));
+  bool overlappingHit = shovelerCollidersSweep3(
+      colliders, &overlappingObject, shovelerVector3(1.0f, 0.0f, 0.0f), &contact);
+  ASSERT_TRUE(overlappingHit);
+  ASSERT_EQ(contact.time, 0.0f);
+  ASSERT_EQ(contact.normal.values[0], 0.0f);
+}
+
+static const ShovelerCollider2* intersectTrigger(
+    const ShovelerCollider2* collider,
+    const ShovelerBoundingBox2* object,
+    ShovelerCollider2FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData) {
+  return collider;
+}
+
+TEST_F(ShovelerCollidersTest, sweep2PrefersContactsWithNormal) {
+  // an intersect-only trigger the object is standing in, which can't be swept
+  ShovelerCollider2 trigger = shovelerColliderBox2(
+      shovelerBoundingBox2(shovelerVector2(-1.0f, 0.0f), shovelerVector2(3.0f, 1.0f)));
+  trigger.intersect = intersectTrigger;
+  ShovelerCollider2 wall = shovelerColliderBox2(
+      shovelerBoundingBox2(shovelerVector2(5.0f, 0.0f), shovelerVector2(5.1f, 1.0f)));
+  shovelerCollidersAddCollider2(colliders, &trigger);
+  shovelerCollidersAddCollider2(colliders, &wall);
+
+  ShovelerBoundingBox2 object =
+      shovelerBoundingBox2(shovelerVector2(0.0f, 0.25f), shovelerVector2(0.5f, 0.75f));
+  ShovelerCollider2Contact contact;
+  bool hit = shovelerCollidersSweep2(colliders, &object, shovelerVector2(10.0f, 0.0f), &contact);
+  ASSERT_TRUE(hit);
+  ASSERT_EQ(contact.collider, &wall) << "the trigger overlap must not hide the wall behind it";
+  ASSERT_FLOAT_EQ(contact.time, 0.45f);
+  ASSERT_EQ(contact.normal.values[0], -1.0f);
+
+  // without the wall in the way, the overlap is still reported
+  bool triggerHit =
+      shovelerCollidersSweep2(colliders, &object, shovelerVector2(1.0f, 0.0f), &contact);
+  ASSERT_TRUE(triggerHit);
+  ASSERT_EQ(contact.collider, &trigger);
+  ASSERT_EQ(contact.time, 0.0f);
+  ASSERT_EQ(contact.normal.values[0], 0.0f);
+}
+
+TEST_F(ShovelerCollidersTest, sweep3PrefersContactsWithNormal) {
+  ShovelerCollider3 overlapping = shovelerColliderBox3(shovelerBoundingBox3(
+      shovelerVector3(0.0f, 0.0f, -1.0f), shovelerVector3(1.0f, 1.0f, 1.0f)));
+  ShovelerCollider3 wall = shovelerColliderBox3(shovelerBoundingBox3(
+      shovelerVector3(0.0f, 0.0f, -5.1f), shovelerVector3(1.0f, 1.0f, -5.0f)));
+  shovelerCollidersAddCollider3(colliders, &overlapping);
+  shovelerCollidersAddCollider3(colliders, &wall);
+
+  ShovelerBoundingBox3 object = shovelerBoundingBox3(
+      shovelerVector3(0.25f, 0.25f, 0.0f), shovelerVector3(0.75f, 0.75f, 0.5f));
+  ShovelerCollider3Contact contact;
+  bool hit =
+      shovelerCollidersSweep3(colliders, &object, shovelerVector3(0.0f, 0.0f, -10.0f), &contact);
+  ASSERT_TRUE(hit);
+  ASSERT_EQ(contact.collider, &wall);
+  ASSERT_FLOAT_EQ(contact.time, 0.5f);
+  ASSERT_EQ(contact.normal.values[2], 1.0f);
+}
@@ -7,10 +7,16 @@
 
 #include "shoveler/log.h"
 
+static bool deflateIntoOutput(ShovelerCompressionContext* context, int flush);
+static bool applyDeflateDictionary(ShovelerCompressionContext* context);
+static bool applyInflateDictionary(ShovelerDecompressionContext* context);
+static size_t reserveOutput(GString* output, size_t minimumSpare);
+static void setDictionary(GString** dictionaryPointer, const unsigned char* data, size_t size);
 static const char* getFormatName(ShovelerCompressionFormat format);
 static int getWindowBitsForFormat(ShovelerCompressionFormat format);
 
-static int inflateChunkSize = 512000;
+static const size_t deflateMinimumSpare = 64;
+static const size_t inflateMinimumSpare = 4096;
 
 bool shovelerCompressionCompress(
     ShovelerCompressionFormat format,
@@ -18,130 +24,439 @@ bool shovelerCompressionCompress(
     size_t inputSize,
     unsigned char** outputPointer,
     size_t* outputSizePointer) {
-  z_stream stream;
-  stream.avail_in = 0;
-  stream.next_in = Z_NULL;
-  stream.zalloc = Z_NULL;
-  stream.zfree = Z_NULL;
-  stream.opaque = Z_NULL;
+  ShovelerCompressionContext* context =
+      shovelerCompressionContextCreate(format, Z_DEFAULT_COMPRESSION);
+  if (context == NULL) {
+    return false;
+  }
+
+  if (!shovelerCompressionContextCompress(context, input, inputSize)) {
+    shovelerCompressionContextFree(context);
+    return false;
+  }
+
+  *outputSizePointer = context->output->len;
+  *outputPointer = malloc(*outputSizePointer * sizeof(unsigned char));
+  memcpy(*outputPointer, context->output->str, *outputSizePointer);
+  shovelerCompressionContextFree(context);
+
+  shovelerLogTrace(
+      "Compressed buffer from %zu bytes to %zu bytes using %s.",
+      inputSize,
+      *outputSizePointer,
+      getFormatName(format));
+  return true;
+}
+
+bool shovelerCompressionDecompress(
+    ShovelerCompressionFormat format,
+    const unsigned char* input,
+    size_t inputSize,
+    unsigned char** outputPointer,
+    size_t* outputSizePointer) {
+  ShovelerDecompressionContext* context = shovelerDecompressionContextCreate(format);
+  if (context == NULL) {
+    return false;
+  }
+
+  if (!shovelerDecompressionContextFeed(context, input, inputSize)) {
+    shovelerDecompressionContextFree(context);
+    return false;
+  }
+
+  if (!context->finished) {
+    shovelerLogError(
+        "Failed to decompress buffer (%zu bytes) using %s: unexpected end of input.",
+        inputSize,
+        getFormatName(format));
+    shovelerDecompressionContextFree(context);
+    return false;
+  }
+
+  *outputSizePointer = context->output->len;
+  *outputPointer = malloc(*outputSizePointer * sizeof(unsigned char));
+  memcpy(*outputPointer, context->output->str, *outputSizePointer);
+  shovelerDecompressionContextFree(context);
+
+  shovelerLogTrace(
+      "Decompressed buffer from %zu bytes to %zu bytes using %s.",
+      inputSize,
+      *outputSizePointer,
+      getFormatName(format));
+  return true;
+}
+
+ShovelerCompressionContext* shovelerCompressionContextCreate(
+    ShovelerCompressionFormat format, int level) {
+  ShovelerCompressionContext* context = malloc(sizeof(ShovelerCompressionContext));
+  context->format = format;
+  context->level = level;
+  context->output = g_string_new("");
+  context->dictionary = NULL;
+  context->stream.avail_in = 0;
+  context->stream.next_in = Z_NULL;
+  context->stream.zalloc = Z_NULL;
+  context->stream.zfree = Z_NULL;
+  context->stream.opaque = Z_NULL;
+  context->finished = false;
 
   int ret = deflateInit2(
-      &stream,
-      Z_DEFAULT_COMPRESSION,
+      &context->stream,
+      level,
       Z_DEFLATED,
       getWindowBitsForFormat(format),
       8,
       Z_DEFAULT_STRATEGY);
   if (ret != Z_OK) {
     shovelerLogError(
-        "Failed to initialize deflate when trying to compress buffer (%zu bytes) using %s: %s",
-        inputSize,
+        "Failed to initialize deflate with level %d using %s: %s",
+        level,
         getFormatName(format),
         zError(ret));
+    g_string_free(context->output, true);
+    free(context);
+    return NULL;
+  }
+
+  return context;
+}
+
+bool shovelerCompressionContextSetDictionary(
+    ShovelerCompressionContext* context, const unsigned char* dictionary, size_t dictionarySize) {
+  if (context->format == SHOVELER_COMPRESSION_FORMAT_GZIP) {
+    shovelerLogError("Failed to set compression dictionary: not supported using gzip.");
     return false;
   }
 
-  stream.avail_in = inputSize;
-  stream.next_in = (Bytef*) input;
+  setDictionary(&context->dictionary, dictionary, dictionarySize);
+  return shovelerCompressionContextReset(context);
+}
 
-  uLong outputBufferSize = deflateBound(&stream, inputSize);
-  unsigned char* outputBuffer = malloc(outputBufferSize * sizeof(unsigned char));
-  stream.avail_out = outputBufferSize;
-  stream.next_out = outputBuffer;
+bool shovelerCompressionContextSetLevel(ShovelerCompressionContext* context, int level) {
+  if (level == context->level) {
+    return true;
+  }
 
-  ret = deflate(&stream, Z_FINISH);
-  if (ret != Z_STREAM_END) {
-    deflateEnd(&stream);
+  // Changing parameters mid stream compresses the input fed so far into a block first, which can
+  // need more output space than reserved. deflateParams then fails with Z_BUF_ERROR without
+  // changing anything, so it is retried with more space until the block is emitted.
+  size_t minimumSpare = deflateMinimumSpare;
+  int ret;
+  do {
+    size_t length = context->output->len;
+    size_t spare = reserveOutput(context->output, minimumSpare);
+    context->stream.next_out = (Bytef*) context->output->str + length;
+    context->stream.avail_out = spare;
+
+    ret = deflateParams(&context->stream, level, Z_DEFAULT_STRATEGY);
+    g_string_truncate(context->output, length + spare - context->stream.avail_out);
+    minimumSpare = 2 * spare;
+  } while (ret == Z_BUF_ERROR && context->stream.avail_out == 0);
+
+  if (ret != Z_OK) {
     shovelerLogError(
-        "Failed to compress buffer (%zu bytes) using %s: %s",
-        inputSize,
-        getFormatName(format),
+        "Failed to change deflate level from %d to %d using %s: %s",
+        context->level,
+        level,
+        getFormatName(context->format),
         zError(ret));
     return false;
   }
 
-  *outputSizePointer = outputBufferSize - stream.avail_out;
-  *outputPointer = malloc(*outputSizePointer * sizeof(unsigned char));
-  memcpy(*outputPointer, outputBuffer, *outputSizePointer);
-  free(outputBuffer);
+  context->level = level;
+  return true;
+}
 
-  deflateEnd(&stream);
+bool shovelerCompressionContextFeed(
+    ShovelerCompressionContext* context, const unsigned char* input, size_t inputSize) {
+  if (context->finished && !shovelerCompressionContextReset(context)) {
+    return false;
+  }
 
-  shovelerLogInfo(
-      "Successfully compressed buffer from %zu bytes to %zu bytes using %s.",
-      inputSize,
-      *outputSizePointer,
-      getFormatName(format));
+  context->stream.next_in = (Bytef*) input;
+  context->stream.avail_in = inputSize;
+  return deflateIntoOutput(context, Z_NO_FLUSH);
+}
+
+bool shovelerCompressionContextFlush(ShovelerCompressionContext* context) {
+  if (context->finished) {
+    return true;
+  }
+
+  return deflateIntoOutput(context, Z_SYNC_FLUSH);
+}
+
+bool shovelerCompressionContextFinish(ShovelerCompressionContext* context) {
+  if (context->finished) {
+    return true;
+  }
+
+  if (!deflateIntoOutput(context, Z_FINISH)) {
+    return false;
+  }
+
+  context->finished = true;
   return true;
 }
 
-bool shovelerCompressionDecompress(
-    ShovelerCompressionFormat format,
-    const unsigned char* input,
-    size_t inputSize,
-    unsigned char** outputPointer,
-    size_t* outputSizePointer) {
-  z_stream stream;
-  stream.avail_in = 0;
-  stream.next_in = Z_NULL;
-  stream.zalloc = Z_NULL;
-  stream.zfree = Z_NULL;
-  stream.opaque = Z_NULL;
-
-  int ret = inflateInit2(&stream, getWindowBitsForFormat(format));
+bool shovelerCompressionContextCompress(
+    ShovelerCompressionContext* context, const unsigned char* input, size_t inputSize) {
+  shovelerCompressionContextClearOutput(context);
+  if (!shovelerCompressionContextReset(context)) {
+    return false;
+  }
+
+  context->stream.next_in = (Bytef*) input;
+  context->stream.avail_in = inputSize;
+  if (!deflateIntoOutput(context, Z_FINISH)) {
+    return false;
+  }
+
+  context->finished = true;
+  return true;
+}
+
+bool shovelerCompressionContextReset(ShovelerCompressionContext* context) {
+  int ret = deflateReset(&context->stream);
   if (ret != Z_OK) {
     shovelerLogError(
-        "Failed to initialize inflate when trying to decompress buffer (%zu bytes) using %s: %s",
-        inputSize,
-        getFormatName(format),
-        zError(ret));
+        "Failed to reset deflate using %s: %s", getFormatName(context->format), zError(ret));
+    return false;
+  }
+
+  context->finished = false;
+  return applyDeflateDictionary(context);
+}
+
+void shovelerCompressionContextFree(ShovelerCompressionContext* context) {
+  deflateEnd(&context->stream);
+  if (context->dictionary != NULL) {
+    g_string_free(context->dictionary, true);
+  }
+  g_string_free(context->output, true);
+  free(context);
+}
+
+ShovelerDecompressionContext* shovelerDecompressionContextCreate(ShovelerCompressionFormat format) {
+  ShovelerDecompressionContext* context = malloc(sizeof(ShovelerDecompressionContext));
+  context->format = format;
+  context->output = g_string_new("");
+  context->dictionary = NULL;
+  context->stream.avail_in = 0;
+  context->stream.next_in = Z_NULL;
+  context->stream.zalloc = Z_NULL;
+  context->stream.zfree = Z_NULL;
+  context->stream.opaque = Z_NULL;
+  context->finished = false;
+
+  int ret = inflateInit2(&context->stream, getWindowBitsForFormat(format));
+  if (ret != Z_OK) {
+    shovelerLogError(
+        "Failed to initialize inflate using %s: %s", getFormatName(format), zError(ret));
+    g_string_free(context->output, true);
+    free(context);
+    return NULL;
+  }
+
+  return context;
+}
+
+bool shovelerDecompressionContextSetDictionary(
+    ShovelerDecompressionContext* context, const unsigned char* dictionary, size_t dictionarySize) {
+  if (context->format == SHOVELER_COMPRESSION_FORMAT_GZIP) {
+    shovelerLogError("Failed to set decompression dictionary: not supported using gzip.");
     return false;
   }
 
-  stream.avail_in = inputSize;
-  stream.next_in = (Bytef*) input;
+  setDictionary(&context->dictionary, dictionary, dictionarySize);
+  return shovelerDecompressionContextReset(context);
+}
+
+bool shovelerDecompressionContextFeed(
+    ShovelerDecompressionContext* context, const unsigned char* input, size_t inputSize) {
+  if (context->finished && !shovelerDecompressionContextReset(context)) {
+    return false;
+  }
 
-  unsigned char* outputBuffer = malloc(inflateChunkSize * sizeof(unsigned char));
+  context->stream.next_in = (Bytef*) input;
+  context->stream.avail_in = inputSize;
 
-  GString* outputString = g_string_new("");
+  while (true) {
+    size_t length = context->output->len;
+    size_t spare = reserveOutput(context->output, MAX(inflateMinimumSpare, 4 * inputSize));
+    context->stream.next_out = (Bytef*) context->output->str + length;
+    context->stream.avail_out = spare;
 
-  do {
-    stream.avail_out = inflateChunkSize;
-    stream.next_out = outputBuffer;
-
-    ret = inflate(&stream, Z_NO_FLUSH);
-    if (ret != Z_OK && ret != Z_STREAM_END) {
-      free(outputBuffer);
-      g_string_free(outputString, true);
-      inflateEnd(&stream);
+    int ret = inflate(&context->stream, Z_NO_FLUSH);
+    g_string_truncate(context->output, length + spare - context->stream.avail_out);
+
+    if (ret == Z_NEED_DICT) {
+      if (!applyInflateDictionary(context)) {
+        return false;
+      }
+      continue;
+    }
+
+    if (ret == Z_STREAM_END) {
+      context->finished = true;
+      if (context->stream.avail_in == 0) {
+        break;
+      }
+
+      // Concatenated streams are decompressed one after another into the same output.
+      if (!shovelerDecompressionContextReset(context)) {
+        return false;
+      }
+      continue;
+    }
+
+    if (ret != Z_OK && ret != Z_BUF_ERROR) {
       shovelerLogError(
           "Failed to decompress buffer (%zu bytes) using %s: %s",
           inputSize,
-          getFormatName(format),
+          getFormatName(context->format),
           zError(ret));
+      shovelerDecompressionContextReset(context);
       return false;
     }
 
-    uLong bytesRead = inflateChunkSize - stream.avail_out;
-    g_string_append_len(outputString, (const char*) outputBuffer, bytesRead);
-  } while (ret != Z_STREAM_END);
+    if (context->stream.avail_out != 0) {
+      // all input consumed and no more output pending
+      break;
+    }
+  }
 
-  free(outputBuffer);
-  inflateEnd(&stream);
+  return true;
+}
 
-  *outputSizePointer = outputString->len;
-  *outputPointer = malloc(*outputSizePointer * sizeof(unsigned char));
-  memcpy(*outputPointer, outputString->str, *outputSizePointer);
-  g_string_free(outputString, true);
+bool shovelerDecompressionContextReset(ShovelerDecompressionContext* context) {
+  int ret = inflateReset(&context->stream);
+  if (ret != Z_OK) {
+    shovelerLogError(
+        "Failed to reset inflate using %s: %s", getFormatName(context->format), zError(ret));
+    return false;
+  }
+
+  context->finished = false;
+
+  // Raw deflate streams don't ask for their dictionary, so it has to be set upfront.
+  if (context->format == SHOVELER_COMPRESSION_FORMAT_DEFLATE && context->dictionary != NULL) {
+    return applyInflateDictionary(context);
+  }
 
-  shovelerLogInfo(
-      "Successfully decompressed buffer from %zu bytes to %zu bytes using %s.",
-      inputSize,
-      *outputSizePointer,
-      getFormatName(format));
   return true;
 }
 
+void shovelerDecompressionContextFree(ShovelerDecompressionContext* context) {
+  inflateEnd(&context->stream);
+  if (context->dictionary != NULL) {
+    g_string_free(context->dictionary, true);
+  }
+  g_string_free(context->output, true);
+  free(context);
+}
+
+static bool deflateIntoOutput(ShovelerCompressionContext* context, int flush) {
+  int ret;
+  do {
+    size_t length = context->output->len;
+    size_t spare = reserveOutput(
+        context->output,
+        MAX(deflateMinimumSpare, deflateBound(&context->stream, context->stream.avail_in)));
+    context->stream.next_out = (Bytef*) context->output->str + length;
+    context->stream.avail_out = spare;
+
+    ret = deflate(&context->stream, flush);
+    g_string_truncate(context->output, length + spare - context->stream.avail_out);
+
+    if (ret == Z_STREAM_ERROR) {
+      shovelerLogError(
+          "Failed to compress buffer using %s: %s",
+          getFormatName(context->format),
+          zError(ret));
+      shovelerCompressionContextReset(context);
+      return false;
+    }
+  } while (context->stream.avail_out == 0);
+
+  if (flush == Z_FINISH && ret != Z_STREAM_END) {
+    shovelerLogError(
+        "Failed to finish compressed stream using %s: %s",
+        getFormatName(context->format),
+        zError(ret));
+    shovelerCompressionContextReset(context);
+    return false;
+  }
+
+  return true;
+}
+
+static bool applyDeflateDictionary(ShovelerCompressionContext* context) {
+  if (context->dictionary == NULL) {
+    return true;
+  }
+
+  int ret = deflateSetDictionary(
+      &context->stream, (const Bytef*) context->dictionary->str, context->dictionary->len);
+  if (ret != Z_OK) {
+    shovelerLogError(
+        "Failed to set deflate dictionary (%zu bytes) using %s: %s",
+        context->dictionary->len,
+        getFormatName(context->format),
+        zError(ret));
+    return false;
+  }
+
+  return true;
+}
+
+static bool applyInflateDictionary(ShovelerDecompressionContext* context) {
+  if (context->dictionary == NULL) {
+    shovelerLogError(
+        "Failed to decompress stream using %s: stream requires a dictionary but none was set.",
+        getFormatName(context->format));
+    return false;
+  }
+
+  int ret = inflateSetDictionary(
+      &context->stream, (const Bytef*) context->dictionary->str, context->dictionary->len);
+  if (ret != Z_OK) {
+    shovelerLogError(
+        "Failed to set inflate dictionary (%zu bytes) using %s: %s",
+        context->dictionary->len,
+        getFormatName(context->format),
+        zError(ret));
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Extends the output by at least minimumSpare uninitialized bytes, preferring to use up capacity
+ * that is already allocated, and returns the number of bytes added.
+ */
+static size_t reserveOutput(GString* output, size_t minimumSpare) {
+  size_t spare = output->allocated_len - output->len - 1;
+  if (spare < minimumSpare) {
+    spare = minimumSpare;
+  }
+
+  g_string_set_size(output, output->len + spare);
+  return spare;
+}
+
+static void setDictionary(GString** dictionaryPointer, const unsigned char* data, size_t size) {
+  if (*dictionaryPointer != NULL) {
+    g_string_free(*dictionaryPointer, true);
+    *dictionaryPointer = NULL;
+  }
+
+  if (data != NULL && size > 0) {
+    *dictionaryPointer = g_string_new_len((const char*) data, size);
+  }
+}
+
 static const char* getFormatName(ShovelerCompressionFormat format) {
   switch (format) {
   case SHOVELER_COMPRESSION_FORMAT_DEFLATE:
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <algorithm> // min
 #include <cstdlib> // free
 #include <cstring> // strlen memcmp
 #include <map>
@@ -82,3 +83,187 @@ TEST(compression, decompressInvalid) {
     ASSERT_FALSE(compressed) << testCaseName << " compression should fail";
   }
 }
+
+TEST(compression, contextReuse) {
+  ShovelerCompressionContext* context =
+      shovelerCompressionContextCreate(SHOVELER_COMPRESSION_FORMAT_ZLIB, Z_DEFAULT_COMPRESSION);
+  ASSERT_TRUE(context != NULL);
+
+  for (int i = 0; i < 10; i++) {
+    std::string testInput;
+    for (int j = 0; j <= i * 100; j++) {
+      testInput += "entity " + std::to_string(j) + " component position ";
+    }
+
+    bool compressed = shovelerCompressionContextCompress(
+        context, (const unsigned char*) testInput.data(), testInput.size());
+    ASSERT_TRUE(compressed) << "compression " << i << " should succeed";
+
+    unsigned char* testReconstructedInput;
+    size_t testReconstructedInputSize;
+    bool decompressed = shovelerCompressionDecompress(
+        SHOVELER_COMPRESSION_FORMAT_ZLIB,
+        (const unsigned char*) context->output->str,
+        context->output->len,
+        &testReconstructedInput,
+        &testReconstructedInputSize);
+    ASSERT_TRUE(decompressed) << "decompression " << i << " should succeed";
+    ASSERT_EQ(
+        std::string((const char*) testReconstructedInput, testReconstructedInputSize), testInput);
+    free(testReconstructedInput);
+  }
+
+  shovelerCompressionContextFree(context);
+}
+
+TEST(compression, streamFlushedMessages) {
+  std::map<std::string, ShovelerCompressionFormat> testCases = {
+      {"deflate", SHOVELER_COMPRESSION_FORMAT_DEFLATE},
+      {"zlib", SHOVELER_COMPRESSION_FORMAT_ZLIB},
+      {"gzip", SHOVELER_COMPRESSION_FORMAT_GZIP}};
+
+  for (const auto& testCase : testCases) {
+    const std::string& testCaseName = testCase.first;
+    ShovelerCompressionContext* compressionContext =
+        shovelerCompressionContextCreate(testCase.second, /* level */ 1);
+    ShovelerDecompressionContext* decompressionContext =
+        shovelerDecompressionContextCreate(testCase.second);
+
+    size_t firstMessageCompressedSize = 0;
+    size_t lastMessageCompressedSize = 0;
+    for (int i = 0; i < 20; i++) {
+      std::string testMessage = "update entity 42 component position field coordinates to " +
+          std::to_string(i) + ", " + std::to_string(2 * i);
+      // feed each message in two parts to check that partial input is held back until the flush
+      size_t half = testMessage.size() / 2;
+      ASSERT_TRUE(shovelerCompressionContextFeed(
+          compressionContext, (const unsigned char*) testMessage.data(), half));
+      ASSERT_TRUE(shovelerCompressionContextFeed(
+          compressionContext,
+          (const unsigned char*) testMessage.data() + half,
+          testMessage.size() - half));
+      ASSERT_TRUE(shovelerCompressionContextFlush(compressionContext));
+
+      if (i == 0) {
+        firstMessageCompressedSize = compressionContext->output->len;
+      }
+      lastMessageCompressedSize = compressionContext->output->len;
+
+      bool decompressed = shovelerDecompressionContextFeed(
+          decompressionContext,
+          (const unsigned char*) compressionContext->output->str,
+          compressionContext->output->len);
+      ASSERT_TRUE(decompressed) << testCaseName << " message " << i << " should decompress";
+      ASSERT_EQ(
+          std::string(decompressionContext->output->str, decompressionContext->output->len),
+          testMessage)
+          << testCaseName << " message " << i << " should be complete after flushing";
+
+      shovelerCompressionContextClearOutput(compressionContext);
+      shovelerDecompressionContextClearOutput(decompressionContext);
+    }
+
+    ASSERT_LT(lastMessageCompressedSize, firstMessageCompressedSize)
+        << testCaseName << " later messages should compress against the shared history";
+
+    ASSERT_TRUE(shovelerCompressionContextFinish(compressionContext));
+    ASSERT_TRUE(shovelerDecompressionContextFeed(
+        decompressionContext,
+        (const unsigned char*) compressionContext->output->str,
+        compressionContext->output->len));
+    ASSERT_TRUE(decompressionContext->finished) << testCaseName << " stream should have ended";
+    ASSERT_EQ(decompressionContext->output->len, 0);
+
+    shovelerDecompressionContextFree(decompressionContext);
+    shovelerCompressionContextFree(compressionContext);
+  }
+}
+
+TEST(compression, changeLevelWithPendingInput) {
+  // pseudo random input that compresses poorly, so that the pending block doesn't fit a few bytes
+  std::string testInput;
+  unsigned int state = 1;
+  for (int i = 0; i < 8 * 1024; i++) {
+    state = state * 1103515245 + 12345;
+    testInput.push_back((char) (state >> 16));
+  }
+
+  ShovelerCompressionContext* compressionContext =
+      shovelerCompressionContextCreate(SHOVELER_COMPRESSION_FORMAT_DEFLATE, /* level */ 1);
+  // small feeds only reserve little output space at a time, while deflate holds back their input
+  static const size_t feedSize = 100;
+  for (size_t offset = 0; offset < testInput.size(); offset += feedSize) {
+    ASSERT_TRUE(shovelerCompressionContextFeed(
+        compressionContext,
+        (const unsigned char*) testInput.data() + offset,
+        std::min(feedSize, testInput.size() - offset)));
+  }
+  ASSERT_TRUE(shovelerCompressionContextSetLevel(compressionContext, /* level */ 9));
+  ASSERT_EQ(compressionContext->level, 9);
+  ASSERT_TRUE(shovelerCompressionContextFinish(compressionContext));
+
+  ShovelerDecompressionContext* decompressionContext =
+      shovelerDecompressionContextCreate(SHOVELER_COMPRESSION_FORMAT_DEFLATE);
+  ASSERT_TRUE(shovelerDecompressionContextFeed(
+      decompressionContext,
+      (const unsigned char*) compressionContext->output->str,
+      compressionContext->output->len));
+  ASSERT_TRUE(decompressionContext->finished);
+  ASSERT_EQ(
+      std::string(decompressionContext->output->str, decompressionContext->output->len),
+      testInput);
+
+  shovelerDecompressionContextFree(decompressionContext);
+  shovelerCompressionContextFree(compressionContext);
+}
+
+TEST(compression, dictionary) {
+  const char* testDictionary = "update entity component position field coordinates";
+  size_t testDictionarySize = strlen(testDictionary);
+  const char* testInput = "update entity 7 component position field coordinates";
+  size_t testInputSize = strlen(testInput);
+
+  std::map<std::string, ShovelerCompressionFormat> testCases = {
+      {"deflate", SHOVELER_COMPRESSION_FORMAT_DEFLATE},
+      {"zlib", SHOVELER_COMPRESSION_FORMAT_ZLIB}};
+
+  for (const auto& testCase : testCases) {
+    const std::string& testCaseName = testCase.first;
+    ShovelerCompressionContext* compressionContext =
+        shovelerCompressionContextCreate(testCase.second, Z_DEFAULT_COMPRESSION);
+    ASSERT_TRUE(shovelerCompressionContextCompress(
+        compressionContext, (const unsigned char*) testInput, testInputSize));
+    size_t compressedSizeWithoutDictionary = compressionContext->output->len;
+
+    ASSERT_TRUE(shovelerCompressionContextSetDictionary(
+        compressionContext, (const unsigned char*) testDictionary, testDictionarySize));
+    ASSERT_TRUE(shovelerCompressionContextCompress(
+        compressionContext, (const unsigned char*) testInput, testInputSize));
+    ASSERT_LT(compressionContext->output->len, compressedSizeWithoutDictionary)
+        << testCaseName << " dictionary should improve compression";
+
+    ShovelerDecompressionContext* decompressionContext =
+        shovelerDecompressionContextCreate(testCase.second);
+    ASSERT_TRUE(shovelerDecompressionContextSetDictionary(
+        decompressionContext, (const unsigned char*) testDictionary, testDictionarySize));
+    ASSERT_TRUE(shovelerDecompressionContextFeed(
+        decompressionContext,
+        (const unsigned char*) compressionContext->output->str,
+        compressionContext->output->len))
+        << testCaseName << " decompression with dictionary should succeed";
+    ASSERT_TRUE(decompressionContext->finished);
+    ASSERT_EQ(
+        std::string(decompressionContext->output->str, decompressionContext->output->len),
+        testInput);
+
+    shovelerDecompressionContextFree(decompressionContext);
+    shovelerCompressionContextFree(compressionContext);
+  }
+
+  ShovelerCompressionContext* gzipContext =
+      shovelerCompressionContextCreate(SHOVELER_COMPRESSION_FORMAT_GZIP, Z_DEFAULT_COMPRESSION);
+  ASSERT_FALSE(shovelerCompressionContextSetDictionary(
+      gzipContext, (const unsigned char*) testDictionary, testDictionarySize))
+      << "gzip should not support dictionaries";
+  shovelerCompressionContextFree(gzipContext);
+}
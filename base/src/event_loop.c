@@ -4,6 +4,11 @@
 #include <stdlib.h>
 
 #include "shoveler/executor.h"
+#include "shoveler/log.h"
+
+static void waitUntil(ShovelerEventLoop* eventLoop, gint64 time);
+static void catchUp(ShovelerEventLoop* eventLoop, gint64 now);
+static void recordTick(ShovelerEventLoop* eventLoop, gint64 jitterUs, gint64 tickTimeUs);
 
 ShovelerEventLoop* shovelerEventLoopCreate(
     gint64 tickRateHz, ShovelerEventLoopTickFunction* tick, void* userData) {
@@ -12,30 +17,127 @@ ShovelerEventLoop* shovelerEventLoopCreate(
   eventLoop->tickPeriodUs = 1000 * 1000 / tickRateHz;
   eventLoop->tick = tick;
   eventLoop->userData = userData;
-  eventLoop->tickStartTime = g_get_monotonic_time();
-  eventLoop->lastTickTime = eventLoop->tickStartTime;
+  eventLoop->spinThresholdUs = SHOVELER_EVENT_LOOP_DEFAULT_SPIN_THRESHOLD_US;
+  eventLoop->catchUpPolicy = SHOVELER_EVENT_LOOP_CATCH_UP_SKIP;
+  eventLoop->maxBurstTicks = SHOVELER_EVENT_LOOP_DEFAULT_MAX_BURST_TICKS;
+  shovelerEventLoopResetStats(eventLoop);
+  eventLoop->nextTickTime = g_get_monotonic_time();
+  eventLoop->lastTickTime = eventLoop->nextTickTime;
+  eventLoop->remainingBurstTicks = 0;
   return eventLoop;
 }
 
+void shovelerEventLoopSetSpinThreshold(ShovelerEventLoop* eventLoop, gint64 spinThresholdUs) {
+  eventLoop->spinThresholdUs = spinThresholdUs;
+}
+
+void shovelerEventLoopSetCatchUpPolicy(
+    ShovelerEventLoop* eventLoop, ShovelerEventLoopCatchUpPolicy catchUpPolicy, int maxBurstTicks) {
+  eventLoop->catchUpPolicy = catchUpPolicy;
+  eventLoop->maxBurstTicks = maxBurstTicks;
+}
+
 void shovelerEventLoopTick(ShovelerEventLoop* eventLoop) {
-  gint64 dtUs = eventLoop->tickStartTime - eventLoop->lastTickTime;
+  gint64 tickStartTime = g_get_monotonic_time();
+  gint64 dtUs = eventLoop->nextTickTime - eventLoop->lastTickTime;
 
   eventLoop->tick(eventLoop, dtUs, eventLoop->userData);
   shovelerExecutorUpdate(eventLoop->executor, dtUs);
 
   gint64 tickEndTime = g_get_monotonic_time();
-  gint64 tickTimeUs = tickEndTime - eventLoop->tickStartTime;
-  gint64 remainingTimeUs = eventLoop->tickPeriodUs - tickTimeUs;
-  if (remainingTimeUs > 0) {
-    g_usleep(remainingTimeUs);
-    tickEndTime = g_get_monotonic_time(); // readjust after sleeping
+  recordTick(eventLoop, tickStartTime - eventLoop->nextTickTime, tickEndTime - tickStartTime);
+
+  // Scheduling relative to the previous schedule rather than the actual start time compensates
+  // for late wakeups instead of accumulating them.
+  eventLoop->lastTickTime = eventLoop->nextTickTime;
+  eventLoop->nextTickTime += eventLoop->tickPeriodUs;
+
+  if (eventLoop->remainingBurstTicks > 0) {
+    eventLoop->remainingBurstTicks--;
+    eventLoop->stats.numBurstTicks++;
+  } else {
+    catchUp(eventLoop, tickEndTime);
   }
 
-  eventLoop->lastTickTime = eventLoop->tickStartTime;
-  eventLoop->tickStartTime = tickEndTime;
+  waitUntil(eventLoop, eventLoop->nextTickTime);
+}
+
+void shovelerEventLoopResetStats(ShovelerEventLoop* eventLoop) {
+  eventLoop->stats.numTicks = 0;
+  eventLoop->stats.numSkippedTicks = 0;
+  eventLoop->stats.numBurstTicks = 0;
+  eventLoop->stats.minTickTimeUs = G_MAXINT64;
+  eventLoop->stats.maxTickTimeUs = 0;
+  eventLoop->stats.totalTickTimeUs = 0;
+  eventLoop->stats.maxJitterUs = 0;
+  eventLoop->stats.totalJitterUs = 0;
+}
+
+void shovelerEventLoopLogStats(ShovelerEventLoop* eventLoop) {
+  const ShovelerEventLoopStats* stats = &eventLoop->stats;
+  shovelerLogInfo(
+      "Event loop ran %lld ticks (%lld skipped, %lld in bursts) taking %.1fus on average (min "
+      "%lldus, max %lldus), starting %.1fus late on average (max %lldus).",
+      (long long) stats->numTicks,
+      (long long) stats->numSkippedTicks,
+      (long long) stats->numBurstTicks,
+      shovelerEventLoopStatsGetMeanTickTimeUs(stats),
+      (long long) (stats->numTicks > 0 ? stats->minTickTimeUs : 0),
+      (long long) stats->maxTickTimeUs,
+      shovelerEventLoopStatsGetMeanJitterUs(stats),
+      (long long) stats->maxJitterUs);
 }
 
 void shovelerEventLoopFree(ShovelerEventLoop* eventLoop) {
   shovelerExecutorFree(eventLoop->executor);
   free(eventLoop);
 }
+
+static void waitUntil(ShovelerEventLoop* eventLoop, gint64 time) {
+  gint64 remainingTimeUs = time - g_get_monotonic_time();
+  if (remainingTimeUs > eventLoop->spinThresholdUs) {
+    g_usleep(remainingTimeUs - eventLoop->spinThresholdUs);
+  }
+
+  if (eventLoop->spinThresholdUs > 0) {
+    while (g_get_monotonic_time() < time) {
+      // spin
+    }
+  }
+}
+
+/** Handles overruns of more than a full tick period by skipping or bursting missed ticks. */
+static void catchUp(ShovelerEventLoop* eventLoop, gint64 now) {
+  if (now <= eventLoop->nextTickTime) {
+    return;
+  }
+
+  int numMissedTicks = (int) ((now - eventLoop->nextTickTime) / eventLoop->tickPeriodUs);
+  if (numMissedTicks == 0) {
+    return;
+  }
+
+  int numSkippedTicks = numMissedTicks;
+  if (eventLoop->catchUpPolicy == SHOVELER_EVENT_LOOP_CATCH_UP_BURST) {
+    // the next tick is due immediately anyway, the missed ones after it are run as a burst
+    int numBurstTicks = MIN(numMissedTicks, eventLoop->maxBurstTicks);
+    eventLoop->remainingBurstTicks = numBurstTicks;
+    numSkippedTicks -= numBurstTicks;
+  }
+
+  if (numSkippedTicks > 0) {
+    // Skipped ticks aren't run, but their time is still passed on through the next tick's dt.
+    eventLoop->nextTickTime += numSkippedTicks * eventLoop->tickPeriodUs;
+    eventLoop->stats.numSkippedTicks += numSkippedTicks;
+  }
+}
+
+static void recordTick(ShovelerEventLoop* eventLoop, gint64 jitterUs, gint64 tickTimeUs) {
+  ShovelerEventLoopStats* stats = &eventLoop->stats;
+  stats->numTicks++;
+  stats->minTickTimeUs = MIN(stats->minTickTimeUs, tickTimeUs);
+  stats->maxTickTimeUs = MAX(stats->maxTickTimeUs, tickTimeUs);
+  stats->totalTickTimeUs += tickTimeUs;
+  stats->maxJitterUs = MAX(stats->maxJitterUs, jitterUs);
+  stats->totalJitterUs += jitterUs;
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+extern "C" {
+#include "shoveler/event_loop.h"
+}
+
+static const gint64 testTickRateHz = 100;
+static const gint64 testTickPeriodUs = 10000;
+
+class ShovelerEventLoopTest : public ::testing::Test {
+public:
+  virtual void SetUp() {
+    eventLoop = shovelerEventLoopCreate(testTickRateHz, tick, this);
+    overrunTick = -1;
+    overrunUs = 0;
+  }
+
+  virtual void TearDown() { shovelerEventLoopFree(eventLoop); }
+
+  static void tick(ShovelerEventLoop* eventLoop, gint64 dtUs, void* testPointer) {
+    ShovelerEventLoopTest* test = (ShovelerEventLoopTest*) testPointer;
+    if ((int) test->dts.size() == test->overrunTick) {
+      g_usleep(test->overrunUs);
+    }
+    test->dts.push_back(dtUs);
+  }
+
+  ShovelerEventLoop* eventLoop;
+  std::vector<gint64> dts;
+  int overrunTick;
+  gint64 overrunUs;
+};
+
+TEST_F(ShovelerEventLoopTest, fixedDt) {
+  for (int i = 0; i < 5; i++) {
+    shovelerEventLoopTick(eventLoop);
+  }
+
+  ASSERT_EQ(dts.size(), 5);
+  ASSERT_EQ(dts[0], 0) << "first tick must not have elapsed time";
+  for (int i = 1; i < 5; i++) {
+    ASSERT_EQ(dts[i], testTickPeriodUs) << "ticks must be passed the scheduled period";
+  }
+  ASSERT_EQ(eventLoop->stats.numTicks, 5);
+  ASSERT_EQ(eventLoop->stats.numSkippedTicks, 0);
+  ASSERT_EQ(eventLoop->stats.numBurstTicks, 0);
+}
+
+TEST_F(ShovelerEventLoopTest, skipMissedTicks) {
+  overrunTick = 1;
+  overrunUs = 3 * testTickPeriodUs + testTickPeriodUs / 2;
+  for (int i = 0; i < 4; i++) {
+    shovelerEventLoopTick(eventLoop);
+  }
+
+  gint64 numSkippedTicks = eventLoop->stats.numSkippedTicks;
+  ASSERT_GE(numSkippedTicks, 2);
+  ASSERT_EQ(eventLoop->stats.numBurstTicks, 0);
+  ASSERT_EQ(dts[2], (1 + numSkippedTicks) * testTickPeriodUs)
+      << "skipped time must be passed on to the next tick";
+}
+
+TEST_F(ShovelerEventLoopTest, burstMissedTicks) {
+  shovelerEventLoopSetCatchUpPolicy(
+      eventLoop, SHOVELER_EVENT_LOOP_CATCH_UP_BURST, /* maxBurstTicks */ 10);
+  overrunTick = 1;
+  overrunUs = 3 * testTickPeriodUs + testTickPeriodUs / 2;
+  for (int i = 0; i < 6; i++) {
+    shovelerEventLoopTick(eventLoop);
+  }
+
+  ASSERT_GE(eventLoop->stats.numBurstTicks, 2);
+  ASSERT_EQ(eventLoop->stats.numSkippedTicks, 0);
+  for (size_t i = 1; i < dts.size(); i++) {
+    ASSERT_EQ(dts[i], testTickPeriodUs) << "burst ticks must be passed the scheduled period";
+  }
+}
+
+TEST_F(ShovelerEventLoopTest, limitBurst) {
+  shovelerEventLoopSetCatchUpPolicy(
+      eventLoop, SHOVELER_EVENT_LOOP_CATCH_UP_BURST, /* maxBurstTicks */ 1);
+  overrunTick = 1;
+  overrunUs = 4 * testTickPeriodUs + testTickPeriodUs / 2;
+  for (int i = 0; i < 4; i++) {
+    shovelerEventLoopTick(eventLoop);
+  }
+
+  ASSERT_EQ(eventLoop->stats.numBurstTicks, 1);
+  ASSERT_GE(eventLoop->stats.numSkippedTicks, 2);
+}
+
+TEST_F(ShovelerEventLoopTest, spinUntilDue) {
+  ASSERT_EQ(eventLoop->spinThresholdUs, 0) << "spinning must be opt-in";
+
+  shovelerEventLoopSetSpinThreshold(eventLoop, testTickPeriodUs / 10);
+  gint64 firstTickTime = eventLoop->nextTickTime;
+  for (int i = 0; i < 3; i++) {
+    shovelerEventLoopTick(eventLoop);
+  }
+
+  ASSERT_GE(g_get_monotonic_time(), firstTickTime + 3 * testTickPeriodUs)
+      << "spinning must not start ticks early";
+  ASSERT_EQ(dts.size(), 3);
+  ASSERT_EQ(dts[2], testTickPeriodUs);
+}
@@ -5,32 +5,110 @@
 
 #include "shoveler/log.h"
 
-static void freeCallback(void* callbackPointer);
+#define SLOT_MASK (SHOVELER_EXECUTOR_WHEEL_SLOTS - 1)
+#define WHEEL_TICKS \
+  ((gint64) 1 << (SHOVELER_EXECUTOR_WHEEL_LEVELS * SHOVELER_EXECUTOR_WHEEL_SLOT_BITS))
+
+static ShovelerExecutorCallback* allocateCallback(ShovelerExecutor* executor);
+static void releaseCallback(ShovelerExecutor* executor, ShovelerExecutorCallback* callback);
+static void insertCallback(ShovelerExecutor* executor, ShovelerExecutorCallback* callback);
+static void unlinkCallback(ShovelerExecutor* executor, ShovelerExecutorCallback* callback);
+static void advanceTick(ShovelerExecutor* executor);
+static void cascadeSlot(ShovelerExecutor* executor, ShovelerExecutorCallback** slot);
+static void collectSlot(ShovelerExecutor* executor, ShovelerExecutorCallback** slot, bool all);
+static gint64 getExpiryTick(ShovelerExecutor* executor, gint64 expiry);
+static gint compareDueCallbacks(gconstpointer firstPointer, gconstpointer secondPointer);
+static void updateJobs(ShovelerExecutor* executor);
+static void completeJob(ShovelerExecutor* executor, ShovelerExecutorJob* job);
+static ShovelerExecutorThreadPool* createThreadPool(int numWorkers);
+static void submitThreadPoolJob(ShovelerExecutorThreadPool* threadPool, ShovelerExecutorJob* job);
+static ShovelerExecutorJob* takeCompletedJobs(ShovelerExecutorThreadPool* threadPool);
+static void freeThreadPool(ShovelerExecutorThreadPool* threadPool);
+static gpointer runWorker(gpointer workerPointer);
+static ShovelerExecutorJob* popJob(ShovelerExecutorWorker* worker, bool steal);
+static void pushCompletedJob(ShovelerExecutorThreadPool* threadPool, ShovelerExecutorJob* job);
 
 ShovelerExecutor* shovelerExecutorCreateDirect() {
   ShovelerExecutor* executor = malloc(sizeof(ShovelerExecutor));
   executor->lastUpdate = g_get_monotonic_time();
-  executor->callbacks = g_hash_table_new_full(g_direct_hash, g_direct_equal, freeCallback, NULL);
+  executor->epoch = executor->lastUpdate;
+  executor->tick = 0;
+  executor->nextSequence = 0;
+  executor->numScheduled = 0;
+  for (int level = 0; level < SHOVELER_EXECUTOR_WHEEL_LEVELS; level++) {
+    for (int slot = 0; slot < SHOVELER_EXECUTOR_WHEEL_SLOTS; slot++) {
+      executor->wheel[level][slot] = NULL;
+    }
+  }
+  executor->overflow = NULL;
+  executor->callbackBlocks = g_array_new(
+      /* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerExecutorCallback*));
+  executor->freeCallbacks = NULL;
+  executor->dueCallbacks = g_array_new(
+      /* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerExecutorCallback*));
+  executor->numPendingJobs = 0;
+  executor->threadPool = NULL;
+  executor->directJobs = g_queue_new();
+  return executor;
+}
+
+ShovelerExecutor* shovelerExecutorCreateThreadPool(int numWorkers) {
+  if (numWorkers <= 0) {
+    numWorkers = (int) g_get_num_processors() - 1;
+    if (numWorkers < 1) {
+      numWorkers = 1;
+    }
+  }
+
+  ShovelerExecutor* executor = shovelerExecutorCreateDirect();
+  executor->threadPool = createThreadPool(numWorkers);
+  shovelerLogInfo("Created thread pool executor with %d workers.", numWorkers);
   return executor;
 }
 
 void shovelerExecutorUpdate(ShovelerExecutor* executor, gint64 elapsedUs) {
   executor->lastUpdate += elapsedUs;
+  gint64 nowTick = getExpiryTick(executor, executor->lastUpdate);
+
+  if (executor->numPendingJobs > 0) {
+    updateJobs(executor);
+  }
+
+  if (executor->numScheduled == 0) {
+    // nothing to cascade or collect, so we can skip ahead directly
+    if (nowTick > executor->tick) {
+      executor->tick = nowTick;
+    }
+    return;
+  }
+
+  g_array_set_size(executor->dueCallbacks, 0);
+  while (executor->tick < nowTick) {
+    advanceTick(executor);
+  }
+
+  // The current tick is only partially elapsed, so only some of its callbacks might have expired.
+  collectSlot(executor, &executor->wheel[0][executor->tick & SLOT_MASK], /* all */ false);
 
-  GHashTableIter iter;
-  ShovelerExecutorCallback* callback;
-  g_hash_table_iter_init(&iter, executor->callbacks);
-  while (g_hash_table_iter_next(&iter, (gpointer*) &callback, NULL)) {
-    if (executor->lastUpdate >= callback->expiry) {
+  GArray* dueCallbacks = executor->dueCallbacks;
+  g_array_sort(dueCallbacks, compareDueCallbacks);
+
+  for (guint i = 0; i < dueCallbacks->len; i++) {
+    ShovelerExecutorCallback* callback = g_array_index(dueCallbacks, ShovelerExecutorCallback*, i);
+    if (callback->state == SHOVELER_EXECUTOR_CALLBACK_STATE_DUE) {
       callback->callbackFunction(callback->userData);
+    }
 
-      if (callback->intervalMs > 0) {
-        callback->expiry = executor->lastUpdate + callback->intervalMs * 1000;
-      } else {
-        g_hash_table_iter_remove(&iter);
-      }
+    // the callback might have removed itself while running
+    if (callback->state == SHOVELER_EXECUTOR_CALLBACK_STATE_DUE && callback->intervalMs > 0) {
+      callback->expiry = executor->lastUpdate + (gint64) callback->intervalMs * 1000;
+      insertCallback(executor, callback);
+    } else {
+      releaseCallback(executor, callback);
     }
   }
+
+  g_array_set_size(dueCallbacks, 0);
 }
 
 void shovelerExecutorUpdateNow(ShovelerExecutor* executor) {
@@ -43,24 +121,386 @@ ShovelerExecutorCallback* shovelerExecutorSchedulePeriodic(
     int intervalMs,
     ShovelerExecutorCallbackFunction* callbackFunction,
     void* userData) {
-  ShovelerExecutorCallback* callback = malloc(sizeof(ShovelerExecutorCallback));
-  callback->expiry = executor->lastUpdate + timeoutMs * 1000;
+  ShovelerExecutorCallback* callback = allocateCallback(executor);
+  callback->expiry = executor->lastUpdate + (gint64) timeoutMs * 1000;
   callback->intervalMs = intervalMs;
   callback->callbackFunction = callbackFunction;
   callback->userData = userData;
+  callback->sequence = executor->nextSequence++;
 
-  g_hash_table_add(executor->callbacks, callback);
+  insertCallback(executor, callback);
   return callback;
 }
 
 bool shovelerExecutorRemoveCallback(
     ShovelerExecutor* executor, ShovelerExecutorCallback* callback) {
-  return g_hash_table_remove(executor->callbacks, callback);
+  switch (callback->state) {
+  case SHOVELER_EXECUTOR_CALLBACK_STATE_SCHEDULED:
+    unlinkCallback(executor, callback);
+    releaseCallback(executor, callback);
+    return true;
+  case SHOVELER_EXECUTOR_CALLBACK_STATE_DUE:
+    // still referenced from the due array, so it is released after the update
+    callback->state = SHOVELER_EXECUTOR_CALLBACK_STATE_CANCELLED;
+    return true;
+  default:
+    return false;
+  }
 }
 
+ShovelerExecutorJob* shovelerExecutorSubmit(
+    ShovelerExecutor* executor,
+    ShovelerExecutorJobFunction* run,
+    ShovelerExecutorJobCompleteFunction* complete,
+    void* userData) {
+  ShovelerExecutorJob* job = malloc(sizeof(ShovelerExecutorJob));
+  job->run = run;
+  job->complete = complete;
+  job->userData = userData;
+  job->cancelled = 0;
+  job->nextCompleted = NULL;
+  executor->numPendingJobs++;
+
+  if (executor->threadPool != NULL) {
+    submitThreadPoolJob(executor->threadPool, job);
+  } else {
+    g_queue_push_tail(executor->directJobs, job);
+  }
+
+  return job;
+}
+
+void shovelerExecutorCancelJob(ShovelerExecutorJob* job) { g_atomic_int_set(&job->cancelled, 1); }
+
 void shovelerExecutorFree(ShovelerExecutor* executor) {
-  g_hash_table_destroy(executor->callbacks);
+  if (executor->threadPool != NULL) {
+    freeThreadPool(executor->threadPool);
+  }
+  g_queue_free_full(executor->directJobs, free);
+
+  g_array_free(executor->dueCallbacks, /* freeSegment */ true);
+  for (guint i = 0; i < executor->callbackBlocks->len; i++) {
+    free(g_array_index(executor->callbackBlocks, ShovelerExecutorCallback*, i));
+  }
+  g_array_free(executor->callbackBlocks, /* freeSegment */ true);
   free(executor);
 }
 
-static void freeCallback(void* callbackPointer) { free(callbackPointer); }
+static ShovelerExecutorCallback* allocateCallback(ShovelerExecutor* executor) {
+  if (executor->freeCallbacks == NULL) {
+    ShovelerExecutorCallback* block =
+        malloc(SHOVELER_EXECUTOR_CALLBACK_BLOCK_SIZE * sizeof(ShovelerExecutorCallback));
+    g_array_append_val(executor->callbackBlocks, block);
+
+    for (int i = SHOVELER_EXECUTOR_CALLBACK_BLOCK_SIZE - 1; i >= 0; i--) {
+      block[i].state = SHOVELER_EXECUTOR_CALLBACK_STATE_FREE;
+      block[i].next = executor->freeCallbacks;
+      executor->freeCallbacks = &block[i];
+    }
+  }
+
+  ShovelerExecutorCallback* callback = executor->freeCallbacks;
+  executor->freeCallbacks = callback->next;
+  return callback;
+}
+
+static void releaseCallback(ShovelerExecutor* executor, ShovelerExecutorCallback* callback) {
+  callback->state = SHOVELER_EXECUTOR_CALLBACK_STATE_FREE;
+  callback->slot = NULL;
+  callback->previous = NULL;
+  callback->next = executor->freeCallbacks;
+  executor->freeCallbacks = callback;
+}
+
+static void insertCallback(ShovelerExecutor* executor, ShovelerExecutorCallback* callback) {
+  gint64 expiryTick = getExpiryTick(executor, callback->expiry);
+  if (expiryTick < executor->tick) {
+    // already expired, so collect it together with the current tick
+    expiryTick = executor->tick;
+  }
+
+  // Pick the lowest level whose range covers the distance to the expiry tick. Within that level,
+  // the slot is chosen by the absolute tick so that it is reached exactly when it cascades down.
+  gint64 delta = expiryTick - executor->tick;
+  ShovelerExecutorCallback** slot = &executor->overflow;
+  for (int level = 0; level < SHOVELER_EXECUTOR_WHEEL_LEVELS; level++) {
+    int shift = level * SHOVELER_EXECUTOR_WHEEL_SLOT_BITS;
+    if (delta < ((gint64) SHOVELER_EXECUTOR_WHEEL_SLOTS << shift)) {
+      slot = &executor->wheel[level][(expiryTick >> shift) & SLOT_MASK];
+      break;
+    }
+  }
+
+  callback->state = SHOVELER_EXECUTOR_CALLBACK_STATE_SCHEDULED;
+  callback->slot = slot;
+  callback->previous = NULL;
+  callback->next = *slot;
+  if (*slot != NULL) {
+    (*slot)->previous = callback;
+  }
+  *slot = callback;
+  executor->numScheduled++;
+}
+
+static void unlinkCallback(ShovelerExecutor* executor, ShovelerExecutorCallback* callback) {
+  if (callback->previous != NULL) {
+    callback->previous->next = callback->next;
+  } else {
+    *callback->slot = callback->next;
+  }
+
+  if (callback->next != NULL) {
+    callback->next->previous = callback->previous;
+  }
+
+  callback->slot = NULL;
+  callback->previous = NULL;
+  callback->next = NULL;
+  executor->numScheduled--;
+}
+
+/** Collects all callbacks of the current tick and moves on to the next one, cascading down the
+ * slots of higher levels that now fall within the range of the level below. */
+static void advanceTick(ShovelerExecutor* executor) {
+  collectSlot(executor, &executor->wheel[0][executor->tick & SLOT_MASK], /* all */ true);
+  executor->tick++;
+
+  for (int level = 1; level < SHOVELER_EXECUTOR_WHEEL_LEVELS; level++) {
+    int shift = level * SHOVELER_EXECUTOR_WHEEL_SLOT_BITS;
+    if ((executor->tick & (((gint64) 1 << shift) - 1)) != 0) {
+      break;
+    }
+
+    cascadeSlot(executor, &executor->wheel[level][(executor->tick >> shift) & SLOT_MASK]);
+  }
+
+  if ((executor->tick & (WHEEL_TICKS - 1)) == 0) {
+    cascadeSlot(executor, &executor->overflow);
+  }
+}
+
+static void cascadeSlot(ShovelerExecutor* executor, ShovelerExecutorCallback** slot) {
+  ShovelerExecutorCallback* callback = *slot;
+  *slot = NULL;
+
+  while (callback != NULL) {
+    ShovelerExecutorCallback* next = callback->next;
+    executor->numScheduled--;
+    insertCallback(executor, callback);
+    callback = next;
+  }
+}
+
+static void collectSlot(ShovelerExecutor* executor, ShovelerExecutorCallback** slot, bool all) {
+  ShovelerExecutorCallback* callback = *slot;
+  while (callback != NULL) {
+    ShovelerExecutorCallback* next = callback->next;
+    if (all || callback->expiry <= executor->lastUpdate) {
+      unlinkCallback(executor, callback);
+      callback->state = SHOVELER_EXECUTOR_CALLBACK_STATE_DUE;
+      g_array_append_val(executor->dueCallbacks, callback);
+    }
+    callback = next;
+  }
+}
+
+static gint64 getExpiryTick(ShovelerExecutor* executor, gint64 expiry) {
+  if (expiry < executor->epoch) {
+    return 0;
+  }
+
+  return (expiry - executor->epoch) / 1000;
+}
+
+static gint compareDueCallbacks(gconstpointer firstPointer, gconstpointer secondPointer) {
+  const ShovelerExecutorCallback* first = *(ShovelerExecutorCallback* const*) firstPointer;
+  const ShovelerExecutorCallback* second = *(ShovelerExecutorCallback* const*) secondPointer;
+
+  if (first->expiry != second->expiry) {
+    return first->expiry < second->expiry ? -1 : 1;
+  }
+
+  if (first->sequence != second->sequence) {
+    return first->sequence < second->sequence ? -1 : 1;
+  }
+
+  return 0;
+}
+
+static void updateJobs(ShovelerExecutor* executor) {
+  if (executor->threadPool == NULL) {
+    // only run jobs submitted before this update, not those submitted by completion callbacks
+    guint numJobs = g_queue_get_length(executor->directJobs);
+    for (guint i = 0; i < numJobs; i++) {
+      ShovelerExecutorJob* job = g_queue_pop_head(executor->directJobs);
+      if (!shovelerExecutorJobIsCancelled(job)) {
+        job->run(job, job->userData);
+      }
+      completeJob(executor, job);
+    }
+    return;
+  }
+
+  ShovelerExecutorJob* job = takeCompletedJobs(executor->threadPool);
+  while (job != NULL) {
+    ShovelerExecutorJob* next = job->nextCompleted;
+    completeJob(executor, job);
+    job = next;
+  }
+}
+
+static void completeJob(ShovelerExecutor* executor, ShovelerExecutorJob* job) {
+  executor->numPendingJobs--;
+  if (job->complete != NULL) {
+    job->complete(job, shovelerExecutorJobIsCancelled(job), job->userData);
+  }
+  free(job);
+}
+
+static ShovelerExecutorThreadPool* createThreadPool(int numWorkers) {
+  ShovelerExecutorThreadPool* threadPool = malloc(sizeof(ShovelerExecutorThreadPool));
+  threadPool->numWorkers = numWorkers;
+  threadPool->workers = malloc((size_t) numWorkers * sizeof(ShovelerExecutorWorker));
+  threadPool->nextWorker = 0;
+  g_mutex_init(&threadPool->mutex);
+  g_cond_init(&threadPool->condition);
+  threadPool->numQueuedJobs = 0;
+  threadPool->shutdown = 0;
+  threadPool->completedJobs = NULL;
+
+  // Initialize all workers before starting any thread, since workers steal from each other.
+  for (int i = 0; i < numWorkers; i++) {
+    ShovelerExecutorWorker* worker = &threadPool->workers[i];
+    worker->threadPool = threadPool;
+    worker->thread = NULL;
+    g_mutex_init(&worker->mutex);
+    worker->jobs = g_queue_new();
+  }
+
+  for (int i = 0; i < numWorkers; i++) {
+    threadPool->workers[i].thread =
+        g_thread_new("shoveler-executor-worker", runWorker, &threadPool->workers[i]);
+  }
+
+  return threadPool;
+}
+
+static void submitThreadPoolJob(ShovelerExecutorThreadPool* threadPool, ShovelerExecutorJob* job) {
+  ShovelerExecutorWorker* worker = &threadPool->workers[threadPool->nextWorker];
+  threadPool->nextWorker = (threadPool->nextWorker + 1) % threadPool->numWorkers;
+
+  // Counting the job before it can be popped keeps workers from decrementing below zero, which
+  // would make idle workers see a nonzero count and spin instead of going to sleep.
+  g_atomic_int_inc(&threadPool->numQueuedJobs);
+
+  g_mutex_lock(&worker->mutex);
+  g_queue_push_tail(worker->jobs, job);
+  g_mutex_unlock(&worker->mutex);
+
+  // Signaling under the pool mutex guarantees that an idle worker either sees the new job before
+  // going to sleep or is woken up by the signal.
+  g_mutex_lock(&threadPool->mutex);
+  g_cond_signal(&threadPool->condition);
+  g_mutex_unlock(&threadPool->mutex);
+}
+
+/** Atomically takes all completed jobs, returning them as a list in completion order. */
+static ShovelerExecutorJob* takeCompletedJobs(ShovelerExecutorThreadPool* threadPool) {
+  ShovelerExecutorJob* stack;
+  do {
+    stack = g_atomic_pointer_get(&threadPool->completedJobs);
+  } while (stack != NULL &&
+           !g_atomic_pointer_compare_and_exchange(&threadPool->completedJobs, stack, NULL));
+
+  // the stack holds the most recently completed job first
+  ShovelerExecutorJob* list = NULL;
+  while (stack != NULL) {
+    ShovelerExecutorJob* next = stack->nextCompleted;
+    stack->nextCompleted = list;
+    list = stack;
+    stack = next;
+  }
+
+  return list;
+}
+
+static void freeThreadPool(ShovelerExecutorThreadPool* threadPool) {
+  g_mutex_lock(&threadPool->mutex);
+  g_atomic_int_set(&threadPool->shutdown, 1);
+  g_cond_broadcast(&threadPool->condition);
+  g_mutex_unlock(&threadPool->mutex);
+
+  for (int i = 0; i < threadPool->numWorkers; i++) {
+    g_thread_join(threadPool->workers[i].thread);
+  }
+
+  for (int i = 0; i < threadPool->numWorkers; i++) {
+    ShovelerExecutorWorker* worker = &threadPool->workers[i];
+    g_queue_free_full(worker->jobs, free);
+    g_mutex_clear(&worker->mutex);
+  }
+
+  ShovelerExecutorJob* job = takeCompletedJobs(threadPool);
+  while (job != NULL) {
+    ShovelerExecutorJob* next = job->nextCompleted;
+    free(job);
+    job = next;
+  }
+
+  g_cond_clear(&threadPool->condition);
+  g_mutex_clear(&threadPool->mutex);
+  free(threadPool->workers);
+  free(threadPool);
+}
+
+static gpointer runWorker(gpointer workerPointer) {
+  ShovelerExecutorWorker* worker = workerPointer;
+  ShovelerExecutorThreadPool* threadPool = worker->threadPool;
+  int workerIndex = (int) (worker - threadPool->workers);
+
+  while (!g_atomic_int_get(&threadPool->shutdown)) {
+    ShovelerExecutorJob* job = popJob(worker, /* steal */ false);
+
+    // When out of work, try to steal from the other workers, starting with the next one so that
+    // thieves spread out over the victims.
+    for (int i = 1; job == NULL && i < threadPool->numWorkers; i++) {
+      ShovelerExecutorWorker* victim =
+          &threadPool->workers[(workerIndex + i) % threadPool->numWorkers];
+      job = popJob(victim, /* steal */ true);
+    }
+
+    if (job != NULL) {
+      g_atomic_int_add(&threadPool->numQueuedJobs, -1);
+      if (!shovelerExecutorJobIsCancelled(job)) {
+        job->run(job, job->userData);
+      }
+      pushCompletedJob(threadPool, job);
+      continue;
+    }
+
+    g_mutex_lock(&threadPool->mutex);
+    while (g_atomic_int_get(&threadPool->numQueuedJobs) == 0 &&
+           !g_atomic_int_get(&threadPool->shutdown)) {
+      g_cond_wait(&threadPool->condition, &threadPool->mutex);
+    }
+    g_mutex_unlock(&threadPool->mutex);
+  }
+
+  return NULL;
+}
+
+static ShovelerExecutorJob* popJob(ShovelerExecutorWorker* worker, bool steal) {
+  g_mutex_lock(&worker->mutex);
+  ShovelerExecutorJob* job =
+      steal ? g_queue_pop_tail(worker->jobs) : g_queue_pop_head(worker->jobs);
+  g_mutex_unlock(&worker->mutex);
+  return job;
+}
+
+static void pushCompletedJob(ShovelerExecutorThreadPool* threadPool, ShovelerExecutorJob* job) {
+  ShovelerExecutorJob* head;
+  do {
+    head = g_atomic_pointer_get(&threadPool->completedJobs);
+    job->nextCompleted = head;
+  } while (!g_atomic_pointer_compare_and_exchange(&threadPool->completedJobs, head, job));
+}
@@ -0,0 +1,131 @@
+#include <glib.h>
+#include <shoveler/executor.h>
+#include <shoveler/log.h>
+#include <stdlib.h> // EXIT_SUCCESS, malloc, free, rand
+
+#define NUM_TIMERS 1000000
+#define MAX_TIMEOUT_MS 60000
+#define UPDATE_INTERVAL_US 16667
+#define NUM_UPDATES 3600
+#define NUM_LINEAR_UPDATES 20
+
+/** The previous executor design that checks every callback on each update, kept as a baseline. */
+typedef struct {
+  gint64 lastUpdate;
+  GHashTable* callbacks;
+} LinearExecutor;
+
+static void countCall(void* numCallsPointer);
+static void scheduleLinear(LinearExecutor* executor, int timeoutMs, int* numCalls);
+static void updateLinear(LinearExecutor* executor, gint64 elapsedUs);
+
+int main(int argc, char* argv[]) {
+  shovelerLogInit("shoveler/", SHOVELER_LOG_LEVEL_INFO_UP, stdout);
+  srand(0);
+
+  int* timeoutsMs = malloc(NUM_TIMERS * sizeof(int));
+  for (int i = 0; i < NUM_TIMERS; i++) {
+    timeoutsMs[i] = rand() % MAX_TIMEOUT_MS;
+  }
+
+  ShovelerExecutor* executor = shovelerExecutorCreateDirect();
+  ShovelerExecutorCallback** callbacks = malloc(NUM_TIMERS * sizeof(ShovelerExecutorCallback*));
+  int numCalls = 0;
+
+  gint64 startTime = g_get_monotonic_time();
+  for (int i = 0; i < NUM_TIMERS; i++) {
+    callbacks[i] = shovelerExecutorSchedule(executor, timeoutsMs[i], countCall, &numCalls);
+  }
+  gint64 scheduleTimeUs = g_get_monotonic_time() - startTime;
+
+  // cancel every fourth timer, as if its entity was removed before the timer fired
+  startTime = g_get_monotonic_time();
+  int numRemoved = 0;
+  for (int i = 0; i < NUM_TIMERS; i += 4) {
+    if (shovelerExecutorRemoveCallback(executor, callbacks[i])) {
+      numRemoved++;
+    }
+  }
+  gint64 removeTimeUs = g_get_monotonic_time() - startTime;
+
+  startTime = g_get_monotonic_time();
+  for (int i = 0; i < NUM_UPDATES; i++) {
+    shovelerExecutorUpdate(executor, UPDATE_INTERVAL_US);
+  }
+  gint64 updateTimeUs = g_get_monotonic_time() - startTime;
+
+  shovelerLogInfo(
+      "Timing wheel: scheduled %d timers in %.2fms, removed %d in %.2fms, %d updates running %d "
+      "callbacks took %.3fms per update.",
+      NUM_TIMERS,
+      (double) scheduleTimeUs / 1000.0,
+      numRemoved,
+      (double) removeTimeUs / 1000.0,
+      NUM_UPDATES,
+      numCalls,
+      (double) updateTimeUs / NUM_UPDATES / 1000.0);
+
+  shovelerExecutorFree(executor);
+  free(callbacks);
+
+  // The linear baseline only runs a few updates, since each of them visits every timer.
+  LinearExecutor linearExecutor;
+  linearExecutor.lastUpdate = 0;
+  linearExecutor.callbacks = g_hash_table_new_full(g_direct_hash, g_direct_equal, free, NULL);
+  int numLinearCalls = 0;
+
+  startTime = g_get_monotonic_time();
+  for (int i = 0; i < NUM_TIMERS; i++) {
+    scheduleLinear(&linearExecutor, timeoutsMs[i], &numLinearCalls);
+  }
+  gint64 linearScheduleTimeUs = g_get_monotonic_time() - startTime;
+
+  startTime = g_get_monotonic_time();
+  for (int i = 0; i < NUM_LINEAR_UPDATES; i++) {
+    updateLinear(&linearExecutor, UPDATE_INTERVAL_US);
+  }
+  gint64 linearUpdateTimeUs = g_get_monotonic_time() - startTime;
+
+  shovelerLogInfo(
+      "Linear scan: scheduled %d timers in %.2fms, %d updates running %d callbacks took %.3fms "
+      "per update.",
+      NUM_TIMERS,
+      (double) linearScheduleTimeUs / 1000.0,
+      NUM_LINEAR_UPDATES,
+      numLinearCalls,
+      (double) linearUpdateTimeUs / NUM_LINEAR_UPDATES / 1000.0);
+
+  g_hash_table_destroy(linearExecutor.callbacks);
+  free(timeoutsMs);
+  shovelerLogTerminate();
+
+  return EXIT_SUCCESS;
+}
+
+static void countCall(void* numCallsPointer) {
+  int* numCalls = numCallsPointer;
+  (*numCalls)++;
+}
+
+static void scheduleLinear(LinearExecutor* executor, int timeoutMs, int* numCalls) {
+  ShovelerExecutorCallback* callback = malloc(sizeof(ShovelerExecutorCallback));
+  callback->expiry = executor->lastUpdate + (gint64) timeoutMs * 1000;
+  callback->intervalMs = 0;
+  callback->callbackFunction = countCall;
+  callback->userData = numCalls;
+  g_hash_table_add(executor->callbacks, callback);
+}
+
+static void updateLinear(LinearExecutor* executor, gint64 elapsedUs) {
+  executor->lastUpdate += elapsedUs;
+
+  GHashTableIter iter;
+  ShovelerExecutorCallback* callback;
+  g_hash_table_iter_init(&iter, executor->callbacks);
+  while (g_hash_table_iter_next(&iter, (gpointer*) &callback, NULL)) {
+    if (executor->lastUpdate >= callback->expiry) {
+      callback->callbackFunction(callback->userData);
+      g_hash_table_iter_remove(&iter);
+    }
+  }
+}
@@ -3,6 +3,7 @@
 #include <cmath>
 #include <iostream>
 #include <type_traits>
+#include <vector>
 
 extern "C" {
 #include "shoveler/executor.h"
@@ -81,3 +82,210 @@ TEST_F(ShovelerExecutorTest, scheduleRemove) {
   shovelerExecutorUpdate(executor, 1000);
   ASSERT_FALSE(callbackCalled) << "callback should still not have been called";
 }
+
+struct OrderTestContext {
+  std::vector<int>* order;
+  int id;
+};
+
+static void recordOrder(void* contextPointer) {
+  OrderTestContext* context = (OrderTestContext*) contextPointer;
+  context->order->push_back(context->id);
+}
+
+TEST_F(ShovelerExecutorTest, deterministicOrder) {
+  std::vector<int> order;
+  std::vector<OrderTestContext> contexts;
+  for (int i = 0; i < 6; i++) {
+    contexts.push_back(OrderTestContext{&order, i});
+  }
+
+  // scheduled out of expiry order, with ties broken by scheduling order
+  shovelerExecutorSchedule(executor, 5, recordOrder, &contexts[0]);
+  shovelerExecutorSchedule(executor, 3, recordOrder, &contexts[1]);
+  shovelerExecutorSchedule(executor, 5, recordOrder, &contexts[2]);
+  shovelerExecutorSchedule(executor, 300, recordOrder, &contexts[3]);
+  shovelerExecutorSchedule(executor, 3, recordOrder, &contexts[4]);
+  shovelerExecutorSchedule(executor, 300, recordOrder, &contexts[5]);
+
+  shovelerExecutorUpdate(executor, 1000 * 1000);
+  ASSERT_EQ(order, (std::vector<int>{1, 4, 0, 2, 3, 5}));
+}
+
+TEST_F(ShovelerExecutorTest, cascade) {
+  // The timeouts are chosen to land in each level of the wheel.
+  const int timeoutsMs[] = {1, 255, 256, 1000, 65535, 65536, 100000, 16777216, 20000000};
+  for (int timeoutMs : timeoutsMs) {
+    ShovelerExecutor* cascadeExecutor = shovelerExecutorCreateDirect();
+    callbackCalled = false;
+    shovelerExecutorSchedule(cascadeExecutor, timeoutMs, testCallback, this);
+
+    // advance in irregular steps so that updates don't line up with slot boundaries
+    gint64 elapsedUs = 0;
+    gint64 timeoutUs = (gint64) timeoutMs * 1000;
+    while (elapsedUs + 777777 < timeoutUs) {
+      shovelerExecutorUpdate(cascadeExecutor, 777777);
+      elapsedUs += 777777;
+    }
+    if (elapsedUs < timeoutUs - 1) {
+      shovelerExecutorUpdate(cascadeExecutor, timeoutUs - 1 - elapsedUs);
+    }
+    ASSERT_FALSE(callbackCalled) << "callback with timeout " << timeoutMs << "ms ran too early";
+
+    shovelerExecutorUpdate(cascadeExecutor, 1);
+    ASSERT_TRUE(callbackCalled) << "callback with timeout " << timeoutMs << "ms must have run";
+    shovelerExecutorFree(cascadeExecutor);
+  }
+}
+
+struct RemoveTestContext {
+  ShovelerExecutor* executor;
+  ShovelerExecutorCallback* callbackToRemove;
+  int numCalls;
+};
+
+static void removeCallback(void* contextPointer) {
+  RemoveTestContext* context = (RemoveTestContext*) contextPointer;
+  context->numCalls++;
+  shovelerExecutorRemoveCallback(context->executor, context->callbackToRemove);
+}
+
+TEST_F(ShovelerExecutorTest, removeFromCallback) {
+  RemoveTestContext context{executor, NULL, 0};
+  ShovelerExecutorCallback* callback =
+      shovelerExecutorSchedulePeriodic(executor, 1, 1, removeCallback, &context);
+  context.callbackToRemove = callback;
+
+  shovelerExecutorUpdate(executor, 1000);
+  ASSERT_EQ(context.numCalls, 1);
+
+  shovelerExecutorUpdate(executor, 10000);
+  ASSERT_EQ(context.numCalls, 1) << "periodic callback must not run again after removing itself";
+}
+
+TEST_F(ShovelerExecutorTest, removeDueFromCallback) {
+  ShovelerExecutorCallback* removed = shovelerExecutorSchedule(executor, 2, testCallback, this);
+  RemoveTestContext context{executor, removed, 0};
+  shovelerExecutorSchedule(executor, 1, removeCallback, &context);
+
+  // both callbacks are due in the same update, but the first one removes the second
+  shovelerExecutorUpdate(executor, 5000);
+  ASSERT_EQ(context.numCalls, 1);
+  ASSERT_FALSE(callbackCalled) << "removed callback must not run";
+}
+
+TEST_F(ShovelerExecutorTest, manyCallbacks) {
+  int numCalls = 0;
+  std::vector<ShovelerExecutorCallback*> callbacks;
+  for (int i = 0; i < 10000; i++) {
+    callbacks.push_back(shovelerExecutorSchedule(
+        executor, i % 5000, [](void* numCallsPointer) { (*(int*) numCallsPointer)++; }, &numCalls));
+  }
+
+  for (int i = 0; i < 10000; i += 2) {
+    ASSERT_TRUE(shovelerExecutorRemoveCallback(executor, callbacks[i]));
+  }
+
+  shovelerExecutorUpdate(executor, 2500 * 1000);
+  ASSERT_EQ(numCalls, 2500);
+  shovelerExecutorUpdate(executor, 2500 * 1000);
+  ASSERT_EQ(numCalls, 5000);
+}
+
+struct JobTestContext {
+  GThread* completeThread;
+  volatile gint numRuns;
+  int numCompletions;
+  int numCancelled;
+};
+
+static void runTestJob(ShovelerExecutorJob* job, void* contextPointer) {
+  JobTestContext* context = (JobTestContext*) contextPointer;
+  g_atomic_int_inc(&context->numRuns);
+}
+
+static void completeTestJob(ShovelerExecutorJob* job, bool cancelled, void* contextPointer) {
+  JobTestContext* context = (JobTestContext*) contextPointer;
+  context->completeThread = g_thread_self();
+  context->numCompletions++;
+  if (cancelled) {
+    context->numCancelled++;
+  }
+}
+
+static void updateUntilJobsCompleted(ShovelerExecutor* executor) {
+  gint64 deadline = g_get_monotonic_time() + 10 * G_USEC_PER_SEC;
+  while (executor->numPendingJobs > 0 && g_get_monotonic_time() < deadline) {
+    shovelerExecutorUpdate(executor, 0);
+    g_usleep(100);
+  }
+}
+
+TEST_F(ShovelerExecutorTest, directJobs) {
+  JobTestContext context{NULL, 0, 0, 0};
+  shovelerExecutorSubmit(executor, runTestJob, completeTestJob, &context);
+  ASSERT_EQ(context.numRuns, 0) << "direct jobs must only run during update";
+
+  shovelerExecutorUpdate(executor, 0);
+  ASSERT_EQ(context.numRuns, 1);
+  ASSERT_EQ(context.numCompletions, 1);
+  ASSERT_EQ(executor->numPendingJobs, 0);
+}
+
+TEST_F(ShovelerExecutorTest, threadPoolJobs) {
+  ShovelerExecutor* threadPoolExecutor = shovelerExecutorCreateThreadPool(/* numWorkers */ 4);
+
+  JobTestContext context{NULL, 0, 0, 0};
+  for (int i = 0; i < 1000; i++) {
+    shovelerExecutorSubmit(threadPoolExecutor, runTestJob, completeTestJob, &context);
+  }
+  updateUntilJobsCompleted(threadPoolExecutor);
+
+  ASSERT_EQ(g_atomic_int_get(&context.numRuns), 1000);
+  ASSERT_EQ(context.numCompletions, 1000);
+  ASSERT_EQ(context.numCancelled, 0);
+  ASSERT_EQ(context.completeThread, g_thread_self())
+      << "completions must run on the updating thread";
+  ASSERT_EQ(g_atomic_int_get(&threadPoolExecutor->threadPool->numQueuedJobs), 0)
+      << "idle workers must not see any queued jobs";
+
+  shovelerExecutorFree(threadPoolExecutor);
+}
+
+TEST_F(ShovelerExecutorTest, cancelJob) {
+  JobTestContext context{NULL, 0, 0, 0};
+  ShovelerExecutorJob* job =
+      shovelerExecutorSubmit(executor, runTestJob, completeTestJob, &context);
+  shovelerExecutorCancelJob(job);
+
+  shovelerExecutorUpdate(executor, 0);
+  ASSERT_EQ(context.numRuns, 0) << "cancelled job must not run";
+  ASSERT_EQ(context.numCompletions, 1) << "cancelled job must still complete";
+  ASSERT_EQ(context.numCancelled, 1);
+}
+
+static void runCancellableJob(ShovelerExecutorJob* job, void* contextPointer) {
+  JobTestContext* context = (JobTestContext*) contextPointer;
+  g_atomic_int_inc(&context->numRuns);
+  while (!shovelerExecutorJobIsCancelled(job)) {
+    g_usleep(100);
+  }
+}
+
+TEST_F(ShovelerExecutorTest, cancelRunningJob) {
+  ShovelerExecutor* threadPoolExecutor = shovelerExecutorCreateThreadPool(/* numWorkers */ 1);
+
+  JobTestContext context{NULL, 0, 0, 0};
+  ShovelerExecutorJob* job =
+      shovelerExecutorSubmit(threadPoolExecutor, runCancellableJob, completeTestJob, &context);
+  while (g_atomic_int_get(&context.numRuns) == 0) {
+    g_usleep(100);
+  }
+
+  shovelerExecutorCancelJob(job);
+  updateUntilJobsCompleted(threadPoolExecutor);
+  ASSERT_EQ(context.numCompletions, 1);
+  ASSERT_EQ(context.numCancelled, 1);
+
+  shovelerExecutorFree(threadPoolExecutor);
+}
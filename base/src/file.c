@@ -1,15 +1,26 @@
 #include "shoveler/file.h"
 
 #include <errno.h> // errno
-#include <glib.h>
-#include <stdio.h> // FILE, fopen, feof, fread, fclose
-#include <stdlib.h> // NULL stdlib
+#include <stdio.h> // FILE, fopen, fileno, fread, ferror, fclose
+#include <stdlib.h> // NULL malloc realloc free
 #include <string.h> // strdup strerror
+#include <sys/stat.h> // fstat S_ISREG
+
+#ifndef _WIN32
+#include <sys/mman.h> // mmap munmap
+#endif
 
 #include "shoveler/log.h"
 
 #define READ_BUFFER_SIZE 4096
 
+static bool readFile(
+    FILE* file,
+    const char* filename,
+    size_t sizeHint,
+    unsigned char** contentsPointer,
+    size_t* contentsSizePointer);
+
 bool shovelerFileRead(
     const char* filename, unsigned char** contentsPointer, size_t* contentsSizePointer) {
   FILE* file = fopen(filename, "rb");
@@ -18,36 +29,21 @@ bool shovelerFileRead(
     return false;
   }
 
-  GString* contents = g_string_new("");
-  unsigned char buffer[READ_BUFFER_SIZE];
-
-  while (!feof(file)) {
-    size_t numBytesRead = fread(buffer, 1, READ_BUFFER_SIZE, file);
-
-    if (ferror(file)) {
-      shovelerLogError(
-          "Error when read file from '%s' after %lu bytes: %s.",
-          filename,
-          contents->len,
-          strerror(errno));
-      g_string_free(contents, true);
-      fclose(file);
-      return false;
-    }
-
-    g_string_append_len(contents, (gchar*) buffer, numBytesRead);
-
-    if (numBytesRead < READ_BUFFER_SIZE) {
-      break;
-    }
+  // Sizing the buffer upfront reads regular files with a single call instead of growing the buffer
+  // chunk by chunk, while streams of unknown size fall back to geometric growth.
+  size_t sizeHint = 0;
+  struct stat fileStat;
+  if (fstat(fileno(file), &fileStat) == 0 && S_ISREG(fileStat.st_mode)) {
+    sizeHint = (size_t) fileStat.st_size;
   }
-  fclose(file);
 
-  *contentsPointer = (unsigned char*) contents->str;
-  *contentsSizePointer = contents->len;
+  bool read = readFile(file, filename, sizeHint, contentsPointer, contentsSizePointer);
+  fclose(file);
+  if (!read) {
+    return false;
+  }
 
-  shovelerLogInfo("Successfully read %lu bytes from '%s'.", contents->len, filename);
-  g_string_free(contents, false);
+  shovelerLogInfo("Successfully read %zu bytes from '%s'.", *contentsSizePointer, filename);
   return true;
 }
 
@@ -61,6 +57,78 @@ char* shovelerFileReadString(const char* filename) {
   return (char*) contents;
 }
 
+ShovelerFileMapping* shovelerFileMap(const char* filename) {
+  FILE* file = fopen(filename, "rb");
+  if (file == NULL) {
+    shovelerLogError("Failed to map file from '%s': %s.", filename, strerror(errno));
+    return NULL;
+  }
+
+  ShovelerFileMapping* fileMapping = malloc(sizeof(ShovelerFileMapping));
+  fileMapping->contents = NULL;
+  fileMapping->contentsSize = 0;
+  fileMapping->mapping = NULL;
+  fileMapping->mappingSize = 0;
+
+  struct stat fileStat;
+  bool isRegular = fstat(fileno(file), &fileStat) == 0 && S_ISREG(fileStat.st_mode);
+
+#ifndef _WIN32
+  if (isRegular && fileStat.st_size > 0) {
+    size_t mappingSize = (size_t) fileStat.st_size;
+    void* mapping = mmap(NULL, mappingSize, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if (mapping != MAP_FAILED) {
+      // the mapping stays valid after the file is closed
+      fclose(file);
+      fileMapping->contents = mapping;
+      fileMapping->contentsSize = mappingSize;
+      fileMapping->mapping = mapping;
+      fileMapping->mappingSize = mappingSize;
+
+      shovelerLogTrace("Mapped %zu bytes from '%s'.", mappingSize, filename);
+      return fileMapping;
+    }
+
+    shovelerLogWarning(
+        "Failed to map file from '%s', falling back to reading it: %s.",
+        filename,
+        strerror(errno));
+  }
+#endif
+
+  unsigned char* contents;
+  size_t contentsSize;
+  bool read = readFile(
+      file, filename, isRegular ? (size_t) fileStat.st_size : 0, &contents, &contentsSize);
+  fclose(file);
+  if (!read) {
+    free(fileMapping);
+    return NULL;
+  }
+
+  fileMapping->contents = contents;
+  fileMapping->contentsSize = contentsSize;
+
+  shovelerLogTrace("Read %zu bytes from '%s' into file mapping.", contentsSize, filename);
+  return fileMapping;
+}
+
+void shovelerFileUnmap(ShovelerFileMapping* fileMapping) {
+  if (fileMapping == NULL) {
+    return;
+  }
+
+  if (fileMapping->mapping != NULL) {
+#ifndef _WIN32
+    munmap(fileMapping->mapping, fileMapping->mappingSize);
+#endif
+  } else {
+    free((unsigned char*) fileMapping->contents);
+  }
+
+  free(fileMapping);
+}
+
 bool shovelerFileWrite(const char* filename, unsigned char* contents, size_t contentsSize) {
   FILE* file = fopen(filename, "wb+");
   if (file == NULL) {
@@ -84,3 +152,52 @@ bool shovelerFileWrite(const char* filename, unsigned char* contents, size_t con
 bool shovelerFileWriteString(const char* filename, const char* string) {
   return shovelerFileWrite(filename, (unsigned char*) string, strlen(string));
 }
+
+/**
+ * Reads the remaining file contents into a newly allocated buffer with a trailing zero byte that
+ * isn't counted in the returned size. The buffer starts out one byte larger than the size hint, so
+ * that reading a file of exactly the hinted size never needs to grow it.
+ */
+static bool readFile(
+    FILE* file,
+    const char* filename,
+    size_t sizeHint,
+    unsigned char** contentsPointer,
+    size_t* contentsSizePointer) {
+  size_t capacity = sizeHint > 0 ? sizeHint + 1 : READ_BUFFER_SIZE;
+  unsigned char* contents = malloc(capacity);
+  size_t contentsSize = 0;
+
+  while (true) {
+    if (contentsSize == capacity) {
+      capacity *= 2;
+      contents = realloc(contents, capacity);
+    }
+
+    size_t numBytesRead = fread(contents + contentsSize, 1, capacity - contentsSize, file);
+    contentsSize += numBytesRead;
+
+    if (ferror(file)) {
+      shovelerLogError(
+          "Error when read file from '%s' after %zu bytes: %s.",
+          filename,
+          contentsSize,
+          strerror(errno));
+      free(contents);
+      return false;
+    }
+
+    if (feof(file)) {
+      break;
+    }
+  }
+
+  if (contentsSize == capacity) {
+    contents = realloc(contents, capacity + 1);
+  }
+  contents[contentsSize] = '\0';
+
+  *contentsPointer = contents;
+  *contentsSizePointer = contentsSize;
+  return true;
+}
@@ -2,12 +2,68 @@
 
 #include <assert.h> // assert
 #include <limits.h> // UINT_MAX
+#include <stdbool.h> // bool
 #include <stdlib.h> // malloc, free
 #include <string.h> // memcpy, memset
 
-static unsigned int getBorderDistance(
-    unsigned int width, unsigned int height, unsigned int i, unsigned int j);
+#ifdef __SSE2__
+#include <emmintrin.h> // SSE2 intrinsics
+#endif
+#ifdef __ARM_NEON
+#include <arm_neon.h> // NEON intrinsics
+#endif
+
+#define ROTATION_BLOCK_SIZE 32
+
+static void rotate(ShovelerImage* image, ShovelerImage* input, bool clockwise);
+static void rotateBlock(
+    ShovelerImage* image,
+    ShovelerImage* input,
+    bool clockwise,
+    unsigned int xStart,
+    unsigned int yStart,
+    unsigned int xEnd,
+    unsigned int yEnd);
+static void rotatePixel(
+    ShovelerImage* image, ShovelerImage* input, bool clockwise, unsigned int x, unsigned int y);
+static unsigned char* getRotatedPixel(
+    ShovelerImage* image, ShovelerImage* input, bool clockwise, unsigned int x, unsigned int y);
+static void repeatPrefix(unsigned char* data, size_t size, size_t prefixSize);
+static void addFramePixel(
+    ShovelerImage* image,
+    unsigned int x,
+    unsigned int y,
+    ShovelerColor color,
+    const unsigned char* alphas);
 static unsigned int minInt(unsigned int a, unsigned int b);
+static void interleave3RowScalar(
+    unsigned char* output,
+    const unsigned char* input0,
+    const unsigned char* input1,
+    const unsigned char* input2,
+    unsigned int length);
+#ifdef __SSE2__
+static unsigned int interleave3RowSse2(
+    unsigned char* output,
+    const unsigned char* input0,
+    const unsigned char* input1,
+    const unsigned char* input2,
+    unsigned int length);
+static __m128i packPixels(__m128i pixels);
+#endif
+#if defined(__SSE2__) || defined(__ARM_NEON)
+static unsigned int flipRow4Simd(
+    unsigned char* output, const unsigned char* input, unsigned int width);
+static void transposeBlock4Simd(
+    const unsigned char* input0,
+    const unsigned char* input1,
+    const unsigned char* input2,
+    const unsigned char* input3,
+    unsigned char* output0,
+    unsigned char* output1,
+    unsigned char* output2,
+    unsigned char* output3);
+#endif
 
 ShovelerImage* shovelerImageCreate(unsigned int width, unsigned int height, unsigned int channels) {
   assert(width > 0);
@@ -36,11 +92,22 @@ ShovelerImage* shovelerImageCreateCopy(ShovelerImage* input) {
 ShovelerImage* shovelerImageCreateFlippedX(ShovelerImage* input) {
   ShovelerImage* image = shovelerImageCreate(input->width, input->height, input->channels);
 
-  for (unsigned int i = 0; i < image->width; i++) {
-    for (unsigned int j = 0; j < image->height; j++) {
-      for (unsigned int c = 0; c < image->channels; c++) {
-        shovelerImageGet(image, i, j, c) = shovelerImageGet(input, image->width - i - 1, j, c);
-      }
+  size_t rowSize = (size_t) input->width * input->channels;
+  for (unsigned int y = 0; y < image->height; y++) {
+    const unsigned char* inputRow = input->data + y * rowSize;
+    unsigned char* outputRow = image->data + y * rowSize;
+
+    unsigned int done = 0;
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    if (image->channels == 4) {
+      done = flipRow4Simd(outputRow, inputRow, image->width);
+    }
+#endif
+    for (unsigned int x = done; x < image->width; x++) {
+      memcpy(
+          outputRow + x * image->channels,
+          inputRow + (image->width - x - 1) * image->channels,
+          image->channels);
     }
   }
 
@@ -50,12 +117,9 @@ ShovelerImage* shovelerImageCreateFlippedX(ShovelerImage* input) {
 ShovelerImage* shovelerImageCreateFlippedY(ShovelerImage* input) {
   ShovelerImage* image = shovelerImageCreate(input->width, input->height, input->channels);
 
-  for (unsigned int i = 0; i < image->width; i++) {
-    for (unsigned int j = 0; j < image->height; j++) {
-      for (unsigned int c = 0; c < image->channels; c++) {
-        shovelerImageGet(image, i, j, c) = shovelerImageGet(input, i, image->height - j - 1, c);
-      }
-    }
+  size_t rowSize = (size_t) input->width * input->channels;
+  for (unsigned int y = 0; y < image->height; y++) {
+    memcpy(image->data + y * rowSize, input->data + (image->height - y - 1) * rowSize, rowSize);
   }
 
   return image;
@@ -63,29 +127,13 @@ ShovelerImage* shovelerImageCreateFlippedY(ShovelerImage* input) {
 
 ShovelerImage* shovelerImageCreateRotatedClockwise(ShovelerImage* input) {
   ShovelerImage* image = shovelerImageCreate(input->height, input->width, input->channels);
-
-  for (unsigned int i = 0; i < image->width; i++) {
-    for (unsigned int j = 0; j < image->height; j++) {
-      for (unsigned int c = 0; c < image->channels; c++) {
-        shovelerImageGet(image, j, image->width - i - 1, c) = shovelerImageGet(input, i, j, c);
-      }
-    }
-  }
-
+  rotate(image, input, /* clockwise */ true);
   return image;
 }
 
 ShovelerImage* shovelerImageCreateRotatedCounterClockwise(ShovelerImage* input) {
   ShovelerImage* image = shovelerImageCreate(input->height, input->width, input->channels);
-
-  for (unsigned int i = 0; i < image->width; i++) {
-    for (unsigned int j = 0; j < image->height; j++) {
-      for (unsigned int c = 0; c < image->channels; c++) {
-        shovelerImageGet(image, image->height - j - 1, i, c) = shovelerImageGet(input, i, j, c);
-      }
-    }
-  }
-
+  rotate(image, input, /* clockwise */ false);
   return image;
 }
 
@@ -148,40 +196,62 @@ void shovelerImageClear(ShovelerImage* image) {
 }
 
 void shovelerImageSet(ShovelerImage* image, ShovelerColor color, unsigned char alpha) {
-  for (unsigned int i = 0; i < image->width; i++) {
-    for (unsigned int j = 0; j < image->height; j++) {
-      for (unsigned int c = 0; c < image->channels; c++) {
-        unsigned char value;
-        if (c == 0) {
-          value = color.r;
-        } else if (c == 1) {
-          value = color.g;
-        } else if (c == 2) {
-          value = color.b;
-        } else {
-          value = alpha;
-        }
-        shovelerImageGet(image, i, j, c) = value;
-      }
+  // write the first pixel and then replicate it over the whole image with a few large copies
+  for (unsigned int c = 0; c < image->channels; c++) {
+    unsigned char value;
+    if (c == 0) {
+      value = color.r;
+    } else if (c == 1) {
+      value = color.g;
+    } else if (c == 2) {
+      value = color.b;
+    } else {
+      value = alpha;
     }
+    image->data[c] = value;
   }
+
+  repeatPrefix(
+      image->data, (size_t) image->width * image->height * image->channels, image->channels);
 }
 
 void shovelerImageAddFrame(ShovelerImage* image, unsigned int size, ShovelerColor color) {
   assert(image->channels == 4);
 
-  for (unsigned int i = 0; i < image->width; i++) {
-    for (unsigned int j = 0; j < image->height; j++) {
-      unsigned int borderDistance = getBorderDistance(image->width, image->height, i, j);
-      if (borderDistance < size) {
-        unsigned char alpha = 255.0 * ((double) (size - borderDistance) / size);
-        shovelerImageGet(image, i, j, 0) = color.r;
-        shovelerImageGet(image, i, j, 1) = color.r;
-        shovelerImageGet(image, i, j, 2) = color.r;
-        shovelerImageGet(image, i, j, 3) = alpha;
+  if (size == 0) {
+    return;
+  }
+
+  // only pixels within size of the border are touched, so the interior is skipped entirely
+  unsigned int numAlphas = minInt(size, (minInt(image->width, image->height) + 1) / 2);
+  unsigned char* alphas = malloc(numAlphas * sizeof(unsigned char));
+  for (unsigned int distance = 0; distance < numAlphas; distance++) {
+    alphas[distance] = 255.0 * ((double) (size - distance) / size);
+  }
+
+  unsigned int leftEnd = minInt(size, image->width);
+  unsigned int rightStart = image->width > size ? image->width - size : 0;
+  if (rightStart < leftEnd) {
+    rightStart = leftEnd;
+  }
+
+  for (unsigned int y = 0; y < image->height; y++) {
+    unsigned int yDistance = minInt(y, image->height - 1 - y);
+    if (yDistance < size) {
+      for (unsigned int x = 0; x < image->width; x++) {
+        addFramePixel(image, x, y, color, alphas);
+      }
+    } else {
+      for (unsigned int x = 0; x < leftEnd; x++) {
+        addFramePixel(image, x, y, color, alphas);
+      }
+      for (unsigned int x = rightStart; x < image->width; x++) {
+        addFramePixel(image, x, y, color, alphas);
       }
     }
   }
+
+  free(alphas);
 }
 
 void shovelerImageAddSubImage(
@@ -196,30 +266,80 @@ void shovelerImageAddSubImage(
           subImage->height); // adding yOffset to subImage->height will never overflow
   assert(image->channels == subImage->channels);
 
-  for (unsigned int i = 0; i < subImage->width; i++) {
-    if (xOffset < 0 && (unsigned int) -xOffset > i) {
-      continue; // would result in negative imageI
-    }
+  // clip the sub image against the image once and then copy the overlap row by row
+  unsigned int xStart = xOffset < 0 ? (unsigned int) -(long long) xOffset : 0;
+  unsigned int yStart = yOffset < 0 ? (unsigned int) -(long long) yOffset : 0;
+  if (xStart >= subImage->width || yStart >= subImage->height) {
+    return;
+  }
 
-    unsigned int imageI = xOffset + i;
-    if (imageI >= image->width) {
-      continue;
-    }
+  unsigned int imageXStart = xOffset < 0 ? 0 : (unsigned int) xOffset;
+  unsigned int imageYStart = yOffset < 0 ? 0 : (unsigned int) yOffset;
+  if (imageXStart >= image->width || imageYStart >= image->height) {
+    return;
+  }
 
-    for (unsigned int j = 0; j < subImage->height; j++) {
-      if (yOffset < 0 && (unsigned int) -yOffset > j) {
-        continue; // would result in negative imageJ
-      }
+  unsigned int width = minInt(subImage->width - xStart, image->width - imageXStart);
+  unsigned int height = minInt(subImage->height - yStart, image->height - imageYStart);
+  for (unsigned int j = 0; j < height; j++) {
+    memcpy(
+        &shovelerImageGet(image, imageXStart, imageYStart + j, 0),
+        &shovelerImageGet(subImage, xStart, yStart + j, 0),
+        (size_t) width * image->channels);
+  }
+}
 
-      unsigned int imageJ = yOffset + j;
-      if (imageJ >= image->height) {
-        continue;
-      }
+void shovelerImageInterleave3(
+    ShovelerImage* image,
+    unsigned int x,
+    unsigned int y,
+    unsigned int width,
+    unsigned int height,
+    const unsigned char* plane0,
+    const unsigned char* plane1,
+    const unsigned char* plane2) {
+  assert(image->channels == 3);
+  assert(x + width <= image->width);
+  assert(y + height <= image->height);
+
+  for (unsigned int row = y; row < y + height; row++) {
+    size_t planeIndex = (size_t) row * image->width + x;
+    unsigned char* output = &shovelerImageGet(image, x, row, 0);
+    unsigned int done = 0;
+#ifdef __SSE2__
+    done = interleave3RowSse2(
+        output, plane0 + planeIndex, plane1 + planeIndex, plane2 + planeIndex, width);
+#endif
+    interleave3RowScalar(
+        output + 3 * done,
+        plane0 + planeIndex + done,
+        plane1 + planeIndex + done,
+        plane2 + planeIndex + done,
+        width - done);
+  }
+}
 
-      for (unsigned int c = 0; c < subImage->channels; c++) {
-        shovelerImageGet(image, imageI, imageJ, c) = shovelerImageGet(subImage, i, j, c);
-      }
-    }
+void shovelerImageInterleave3Scalar(
+    ShovelerImage* image,
+    unsigned int x,
+    unsigned int y,
+    unsigned int width,
+    unsigned int height,
+    const unsigned char* plane0,
+    const unsigned char* plane1,
+    const unsigned char* plane2) {
+  assert(image->channels == 3);
+  assert(x + width <= image->width);
+  assert(y + height <= image->height);
+
+  for (unsigned int row = y; row < y + height; row++) {
+    size_t planeIndex = (size_t) row * image->width + x;
+    interleave3RowScalar(
+        &shovelerImageGet(image, x, row, 0),
+        plane0 + planeIndex,
+        plane1 + planeIndex,
+        plane2 + planeIndex,
+        width);
   }
 }
 
@@ -232,16 +352,119 @@ void shovelerImageFree(ShovelerImage* image) {
   free(image);
 }
 
-static unsigned int getBorderDistance(
-    unsigned int width, unsigned int height, unsigned int i, unsigned int j) {
-  assert(i < width);
-  assert(j < height);
+/**
+ * Rotates the input in square blocks, so that both the rows read from the input and the columns
+ * written to the output stay in cache while a block is processed.
+ */
+static void rotate(ShovelerImage* image, ShovelerImage* input, bool clockwise) {
+  for (unsigned int y = 0; y < input->height; y += ROTATION_BLOCK_SIZE) {
+    unsigned int yEnd = minInt(y + ROTATION_BLOCK_SIZE, input->height);
+    for (unsigned int x = 0; x < input->width; x += ROTATION_BLOCK_SIZE) {
+      unsigned int xEnd = minInt(x + ROTATION_BLOCK_SIZE, input->width);
+      rotateBlock(image, input, clockwise, x, y, xEnd, yEnd);
+    }
+  }
+}
+
+/** Rotates the given input block, transposing four by four pixel tiles with SIMD if possible. */
+static void rotateBlock(
+    ShovelerImage* image,
+    ShovelerImage* input,
+    bool clockwise,
+    unsigned int xStart,
+    unsigned int yStart,
+    unsigned int xEnd,
+    unsigned int yEnd) {
+  unsigned int xTileEnd = xStart;
+  unsigned int yTileEnd = yStart;
+#if defined(__SSE2__) || defined(__ARM_NEON)
+  if (input->channels == 4) {
+    xTileEnd = xStart + (xEnd - xStart) / 4 * 4;
+    yTileEnd = yStart + (yEnd - yStart) / 4 * 4;
+
+    for (unsigned int y = yStart; y < yTileEnd; y += 4) {
+      for (unsigned int x = xStart; x < xTileEnd; x += 4) {
+        if (clockwise) {
+          // input row y + k becomes output column y + k, and input column x + m becomes output
+          // row x + m counted from the top
+          transposeBlock4Simd(
+              &shovelerImageGet(input, x, y, 0),
+              &shovelerImageGet(input, x, y + 1, 0),
+              &shovelerImageGet(input, x, y + 2, 0),
+              &shovelerImageGet(input, x, y + 3, 0),
+              &shovelerImageGet(image, y, input->width - 1 - x, 0),
+              &shovelerImageGet(image, y, input->width - 2 - x, 0),
+              &shovelerImageGet(image, y, input->width - 3 - x, 0),
+              &shovelerImageGet(image, y, input->width - 4 - x, 0));
+        } else {
+          // feeding the input rows in reverse order reverses the transposed output rows
+          unsigned int outputX = input->height - 4 - y;
+          transposeBlock4Simd(
+              &shovelerImageGet(input, x, y + 3, 0),
+              &shovelerImageGet(input, x, y + 2, 0),
+              &shovelerImageGet(input, x, y + 1, 0),
+              &shovelerImageGet(input, x, y, 0),
+              &shovelerImageGet(image, outputX, x, 0),
+              &shovelerImageGet(image, outputX, x + 1, 0),
+              &shovelerImageGet(image, outputX, x + 2, 0),
+              &shovelerImageGet(image, outputX, x + 3, 0));
+        }
+      }
+    }
+  }
+#endif
+
+  for (unsigned int y = yStart; y < yEnd; y++) {
+    unsigned int x = y < yTileEnd ? xTileEnd : xStart;
+    for (; x < xEnd; x++) {
+      rotatePixel(image, input, clockwise, x, y);
+    }
+  }
+}
+
+static void rotatePixel(
+    ShovelerImage* image, ShovelerImage* input, bool clockwise, unsigned int x, unsigned int y) {
+  memcpy(
+      getRotatedPixel(image, input, clockwise, x, y),
+      &shovelerImageGet(input, x, y, 0),
+      input->channels);
+}
+
+/** Returns the output pixel that the given input pixel is rotated to. */
+static unsigned char* getRotatedPixel(
+    ShovelerImage* image, ShovelerImage* input, bool clockwise, unsigned int x, unsigned int y) {
+  if (clockwise) {
+    return &shovelerImageGet(image, y, input->width - 1 - x, 0);
+  } else {
+    return &shovelerImageGet(image, input->height - 1 - y, x, 0);
+  }
+}
+
+/** Fills data by repeating its first prefixSize bytes, doubling the filled part with each copy. */
+static void repeatPrefix(unsigned char* data, size_t size, size_t prefixSize) {
+  size_t filled = prefixSize;
+  while (filled < size) {
+    size_t copySize = filled < size - filled ? filled : size - filled;
+    memcpy(data + filled, data, copySize);
+    filled += copySize;
+  }
+}
 
-  unsigned int xLow = i;
-  unsigned int xHigh = width - 1 - i;
-  unsigned int yLow = j;
-  unsigned int yHigh = height - 1 - j;
-  return minInt(xLow, minInt(xHigh, minInt(yLow, yHigh)));
+static void addFramePixel(
+    ShovelerImage* image,
+    unsigned int x,
+    unsigned int y,
+    ShovelerColor color,
+    const unsigned char* alphas) {
+  unsigned int xDistance = minInt(x, image->width - 1 - x);
+  unsigned int yDistance = minInt(y, image->height - 1 - y);
+  unsigned int borderDistance = minInt(xDistance, yDistance);
+
+  unsigned char* pixel = &shovelerImageGet(image, x, y, 0);
+  pixel[0] = color.r;
+  pixel[1] = color.r;
+  pixel[2] = color.r;
+  pixel[3] = alphas[borderDistance];
 }
 
 static unsigned int minInt(unsigned int a, unsigned int b) {
@@ -251,3 +474,149 @@ static unsigned int minInt(unsigned int a, unsigned int b) {
     return b;
   }
 }
+
+static void interleave3RowScalar(
+    unsigned char* output,
+    const unsigned char* input0,
+    const unsigned char* input1,
+    const unsigned char* input2,
+    unsigned int length) {
+  for (unsigned int i = 0; i < length; i++) {
+    output[3 * i] = input0[i];
+    output[3 * i + 1] = input1[i];
+    output[3 * i + 2] = input2[i];
+  }
+}
+
+#ifdef __SSE2__
+/**
+ * Interleaves blocks of 16 pixels and returns the number of pixels written, leaving the remainder
+ * to the scalar loop. SSE2 has no byte shuffle, so the pixels are first widened to four bytes by
+ * unpacking with a zero plane and then packed back to three bytes using shifts.
+ */
+static unsigned int interleave3RowSse2(
+    unsigned char* output,
+    const unsigned char* input0,
+    const unsigned char* input1,
+    const unsigned char* input2,
+    unsigned int length) {
+  __m128i zero = _mm_setzero_si128();
+
+  unsigned int i = 0;
+  for (; i + 16 <= length; i += 16) {
+    __m128i values0 = _mm_loadu_si128((const __m128i*) (input0 + i));
+    __m128i values1 = _mm_loadu_si128((const __m128i*) (input1 + i));
+    __m128i values2 = _mm_loadu_si128((const __m128i*) (input2 + i));
+
+    __m128i values01Low = _mm_unpacklo_epi8(values0, values1);
+    __m128i values01High = _mm_unpackhi_epi8(values0, values1);
+    __m128i values2Low = _mm_unpacklo_epi8(values2, zero);
+    __m128i values2High = _mm_unpackhi_epi8(values2, zero);
+
+    // four vectors of four pixels with the layout 0 1 2 _, each packed into their low 12 bytes
+    __m128i pixels0 = packPixels(_mm_unpacklo_epi16(values01Low, values2Low));
+    __m128i pixels1 = packPixels(_mm_unpackhi_epi16(values01Low, values2Low));
+    __m128i pixels2 = packPixels(_mm_unpacklo_epi16(values01High, values2High));
+    __m128i pixels3 = packPixels(_mm_unpackhi_epi16(values01High, values2High));
+
+    __m128i* outputBlock = (__m128i*) (output + 3 * i);
+    _mm_storeu_si128(outputBlock, _mm_or_si128(pixels0, _mm_slli_si128(pixels1, 12)));
+    _mm_storeu_si128(
+        outputBlock + 1, _mm_or_si128(_mm_srli_si128(pixels1, 4), _mm_slli_si128(pixels2, 8)));
+    _mm_storeu_si128(
+        outputBlock + 2, _mm_or_si128(_mm_srli_si128(pixels2, 8), _mm_slli_si128(pixels3, 4)));
+  }
+
+  return i;
+}
+
+/** Packs four pixels of four bytes each with a zero last byte into the low 12 bytes. */
+static __m128i packPixels(__m128i pixels) {
+  // within each 64 bit lane, move the second pixel down to directly follow the first one
+  __m128i lowPixels = _mm_and_si128(pixels, _mm_set_epi32(0, -1, 0, -1));
+  __m128i highPixels = _mm_slli_epi64(_mm_srli_epi64(pixels, 32), 24);
+  __m128i lanes = _mm_or_si128(lowPixels, highPixels);
+
+  // move the six bytes of the upper lane down to directly follow the six bytes of the lower lane
+  __m128i lowLane = _mm_and_si128(lanes, _mm_set_epi32(0, 0, -1, -1));
+  __m128i highLane =
+      _mm_and_si128(_mm_srli_si128(lanes, 2), _mm_set_epi32(-1, -1, (int) 0xFFFF0000, 0));
+  return _mm_or_si128(lowLane, highLane);
+}
+#endif
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+/**
+ * Mirrors blocks of four RGBA pixels, reading them from the end of the input row, and returns the
+ * number of pixels written, leaving the remainder to the scalar loop.
+ */
+static unsigned int flipRow4Simd(
+    unsigned char* output, const unsigned char* input, unsigned int width) {
+  unsigned int x = 0;
+  for (; x + 4 <= width; x += 4) {
+    const unsigned char* inputBlock = input + 4 * (width - x - 4);
+#ifdef __SSE2__
+    __m128i pixels = _mm_loadu_si128((const __m128i*) inputBlock);
+    _mm_storeu_si128(
+        (__m128i*) (output + 4 * x), _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 1, 2, 3)));
+#else
+    uint32x4_t pixels = vreinterpretq_u32_u8(vld1q_u8(inputBlock));
+    uint32x4_t swapped = vrev64q_u32(pixels);
+    vst1q_u8(output + 4 * x, vreinterpretq_u8_u32(vextq_u32(swapped, swapped, 2)));
+#endif
+  }
+
+  return x;
+}
+
+/**
+ * Transposes a tile of four by four RGBA pixels, so that output row m holds pixel m of each input
+ * row. Pixels are treated as 32 bit lanes, so channels are never separated.
+ */
+static void transposeBlock4Simd(
+    const unsigned char* input0,
+    const unsigned char* input1,
+    const unsigned char* input2,
+    const unsigned char* input3,
+    unsigned char* output0,
+    unsigned char* output1,
+    unsigned char* output2,
+    unsigned char* output3) {
+#ifdef __SSE2__
+  __m128i row0 = _mm_loadu_si128((const __m128i*) input0);
+  __m128i row1 = _mm_loadu_si128((const __m128i*) input1);
+  __m128i row2 = _mm_loadu_si128((const __m128i*) input2);
+  __m128i row3 = _mm_loadu_si128((const __m128i*) input3);
+
+  __m128i rows01Low = _mm_unpacklo_epi32(row0, row1);
+  __m128i rows23Low = _mm_unpacklo_epi32(row2, row3);
+  __m128i rows01High = _mm_unpackhi_epi32(row0, row1);
+  __m128i rows23High = _mm_unpackhi_epi32(row2, row3);
+
+  _mm_storeu_si128((__m128i*) output0, _mm_unpacklo_epi64(rows01Low, rows23Low));
+  _mm_storeu_si128((__m128i*) output1, _mm_unpackhi_epi64(rows01Low, rows23Low));
+  _mm_storeu_si128((__m128i*) output2, _mm_unpacklo_epi64(rows01High, rows23High));
+  _mm_storeu_si128((__m128i*) output3, _mm_unpackhi_epi64(rows01High, rows23High));
+#else
+  uint32x4x2_t rows01 = vtrnq_u32(
+      vreinterpretq_u32_u8(vld1q_u8(input0)), vreinterpretq_u32_u8(vld1q_u8(input1)));
+  uint32x4x2_t rows23 = vtrnq_u32(
+      vreinterpretq_u32_u8(vld1q_u8(input2)), vreinterpretq_u32_u8(vld1q_u8(input3)));
+
+  vst1q_u8(
+      output0,
+      vreinterpretq_u8_u32(vcombine_u32(vget_low_u32(rows01.val[0]), vget_low_u32(rows23.val[0]))));
+  vst1q_u8(
+      output1,
+      vreinterpretq_u8_u32(vcombine_u32(vget_low_u32(rows01.val[1]), vget_low_u32(rows23.val[1]))));
+  vst1q_u8(
+      output2,
+      vreinterpretq_u8_u32(
+          vcombine_u32(vget_high_u32(rows01.val[0]), vget_high_u32(rows23.val[0]))));
+  vst1q_u8(
+      output3,
+      vreinterpretq_u8_u32(
+          vcombine_u32(vget_high_u32(rows01.val[1]), vget_high_u32(rows23.val[1]))));
+#endif
+}
+#endif
@@ -9,197 +9,224 @@
 #include <stdlib.h> // malloc, free
 #include <string.h> // memcpy
 
+#include "shoveler/executor.h"
 #include "shoveler/input_stream.h"
 #include "shoveler/log.h"
 
 #define PNG_HEADER_CHECK_BYTES 8
-
-static ShovelerImage* readPng(ShovelerInputStream* inputStream);
+#define PNG_IHDR_END 26
+/** Keeps the payload of recycled blocks aligned like malloc would. */
+#define BLOCK_HEADER_SIZE 16
+
+typedef struct {
+  const unsigned char* buffer;
+  int bufferSize;
+  ShovelerImage* image;
+  ShovelerImagePngReadCompleteFunction* complete;
+  void* userData;
+} ReadJob;
+
+static ShovelerImagePngReader* getThreadReader();
+static void freeThreadReader(void* readerPointer);
+static bool readPng(
+    ShovelerImagePngReader* reader,
+    ShovelerInputStream* inputStream,
+    ShovelerImage* targetImage,
+    ShovelerImage** outputImage);
 static bool readPngData(
+    ShovelerImagePngReader* reader,
     png_structp png,
     png_infop info,
-    png_infop endInfo,
-    png_uint_32* width,
-    volatile png_uint_32* height,
-    png_uint_32* channels,
-    png_byte* bitDepth,
-    png_bytep* volatile* rowPointers);
+    ShovelerInputStream* inputStream,
+    ShovelerImage* targetImage,
+    ShovelerImage* volatile* createdImage,
+    png_byte* bitDepth);
+static int getChannelsForColorType(png_byte colorType);
 static void readInputStream(png_structp png, png_bytep outBytes, png_size_t bytesToRead);
-static ShovelerImage* createImageFromRowPointers(
-    png_uint_32 width, png_uint_32 height, png_uint_32 channels, png_bytep* rowPointers);
+static png_voidp allocateBlock(png_structp png, png_alloc_size_t size);
+static void releaseBlock(png_structp png, png_voidp pointer);
+static void runReadJob(ShovelerExecutorJob* job, void* readJobPointer);
+static void completeReadJob(ShovelerExecutorJob* job, bool cancelled, void* readJobPointer);
+static bool writePng(ShovelerImage* image, const char* target, FILE* file, GString* output);
+static void appendOutput(png_structp png, png_bytep bytes, png_size_t numBytes);
 static void handlePngReadError(png_structp png, png_const_charp error);
 static void handlePngReadWarning(png_structp png, png_const_charp warning);
-static void freeRowPointers(png_uint_32 height, png_bytep* rowPointers);
+
+static GPrivate threadReader = G_PRIVATE_INIT(freeThreadReader);
 
 ShovelerImage* shovelerImagePngReadFile(const char* filename) {
+  return shovelerImagePngReaderReadFile(getThreadReader(), filename);
+}
+
+ShovelerImage* shovelerImagePngReadBuffer(const unsigned char* buffer, int bufferSize) {
+  return shovelerImagePngReaderReadBuffer(getThreadReader(), buffer, bufferSize);
+}
+
+ShovelerExecutorJob* shovelerImagePngReadBufferAsync(
+    ShovelerExecutor* executor,
+    const unsigned char* buffer,
+    int bufferSize,
+    ShovelerImagePngReadCompleteFunction* complete,
+    void* userData) {
+  ReadJob* readJob = malloc(sizeof(ReadJob));
+  readJob->buffer = buffer;
+  readJob->bufferSize = bufferSize;
+  readJob->image = NULL;
+  readJob->complete = complete;
+  readJob->userData = userData;
+  return shovelerExecutorSubmit(executor, runReadJob, completeReadJob, readJob);
+}
+
+bool shovelerImagePngReadBufferSize(
+    const unsigned char* buffer,
+    int bufferSize,
+    unsigned int* width,
+    unsigned int* height,
+    unsigned int* channels) {
+  if (bufferSize < PNG_IHDR_END || png_sig_cmp(buffer, 0, PNG_HEADER_CHECK_BYTES) ||
+      memcmp(buffer + 12, "IHDR", 4) != 0) {
+    return false;
+  }
+
+  *width = png_get_uint_32(buffer + 16);
+  *height = png_get_uint_32(buffer + 20);
+  int colorTypeChannels = getChannelsForColorType(buffer[25]);
+  if (colorTypeChannels == 0) {
+    return false;
+  }
+
+  *channels = (unsigned int) colorTypeChannels;
+  return true;
+}
+
+ShovelerImagePngReader* shovelerImagePngReaderCreate() {
+  ShovelerImagePngReader* reader = malloc(sizeof(ShovelerImagePngReader));
+  reader->rowPointers =
+      g_array_new(/* zeroTerminated */ false, /* clear */ false, sizeof(unsigned char*));
+  reader->freeBlocks = g_array_new(/* zeroTerminated */ false, /* clear */ false, sizeof(void*));
+  return reader;
+}
+
+ShovelerImage* shovelerImagePngReaderReadFile(
+    ShovelerImagePngReader* reader, const char* filename) {
   ShovelerInputStream* inputStream = shovelerInputStreamCreateFile(filename);
   if (inputStream == NULL) {
     return NULL;
   }
 
-  ShovelerImage* image = readPng(inputStream);
+  ShovelerImage* image = NULL;
+  readPng(reader, inputStream, /* targetImage */ NULL, &image);
 
   shovelerInputStreamFree(inputStream);
 
   return image;
 }
 
-ShovelerImage* shovelerImagePngReadBuffer(const unsigned char* buffer, int bufferSize) {
+ShovelerImage* shovelerImagePngReaderReadBuffer(
+    ShovelerImagePngReader* reader, const unsigned char* buffer, int bufferSize) {
   ShovelerInputStream* inputStream = shovelerInputStreamCreateMemory(buffer, bufferSize);
   if (inputStream == NULL) {
     return NULL;
   }
 
-  ShovelerImage* image = readPng(inputStream);
+  ShovelerImage* image = NULL;
+  readPng(reader, inputStream, /* targetImage */ NULL, &image);
 
   shovelerInputStreamFree(inputStream);
 
   return image;
 }
 
-bool shovelerImagePngWriteFile(ShovelerImage* image, const char* filename) {
-  assert(
-      image->height <=
-      UINT_MAX / sizeof(png_bytep)); // image->height * sizeof(png_bytep) won't overflow
-
-  if (image->channels > 4) {
-    shovelerLogError(
-        "Failed to write PNG image to '%s': can only write image with up to 4 channels.", filename);
-    return false;
-  }
-
-  FILE* file = fopen(filename, "wb+");
-  if (file == NULL) {
-    shovelerLogError("Failed to write PNG image to '%s': fopen failed.", filename);
-    return false;
-  }
-
-  png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-  if (png_ptr == NULL) {
-    shovelerLogError(
-        "Failed to write PNG image to '%s': failed to create libpng write struct.", filename);
-    fclose(file);
-    return false;
-  }
-
-  png_infop info_ptr = png_create_info_struct(png_ptr);
-  if (info_ptr == NULL) {
-    shovelerLogError(
-        "Failed to write PNG image to '%s': failed to create libpng info struct.", filename);
-    fclose(file);
-    png_destroy_write_struct(&png_ptr, NULL);
+bool shovelerImagePngReaderReadBufferInto(
+    ShovelerImagePngReader* reader,
+    const unsigned char* buffer,
+    int bufferSize,
+    ShovelerImage* image) {
+  ShovelerInputStream* inputStream = shovelerInputStreamCreateMemory(buffer, bufferSize);
+  if (inputStream == NULL) {
     return false;
   }
 
-  png_byte colorType = 0;
-  switch (image->channels) {
-  case 1:
-    colorType = PNG_COLOR_TYPE_GRAY;
-    break;
-  case 2:
-    colorType = PNG_COLOR_TYPE_GRAY_ALPHA;
-    break;
-  case 3:
-    colorType = PNG_COLOR_TYPE_RGB;
-    break;
-  case 4:
-    colorType = PNG_COLOR_TYPE_RGB_ALPHA;
-    break;
-  default:
-    shovelerLogError(
-        "Failed to write PNG image to '%s': unsupported number of channels.", filename);
-    png_destroy_write_struct(&png_ptr, &info_ptr);
-    fclose(file);
-    return NULL;
-    break;
-  }
+  bool read = readPng(reader, inputStream, image, /* outputImage */ NULL);
 
-  png_bytep* row_pointers = malloc(image->height * sizeof(png_bytep));
+  shovelerInputStreamFree(inputStream);
 
-  for (unsigned int y = 0; y < image->height; y++) {
-    row_pointers[y] = malloc(image->width * image->channels * sizeof(png_byte));
+  return read;
+}
 
-    for (unsigned int x = 0; x < image->width; x++) {
-      for (unsigned int c = 0; c < image->channels; c++) {
-        row_pointers[y][image->channels * x + c] =
-            shovelerImageGet(image, x, image->height - y - 1, c);
-      }
-    }
+void shovelerImagePngReaderFree(ShovelerImagePngReader* reader) {
+  for (guint i = 0; i < reader->freeBlocks->len; i++) {
+    free(g_array_index(reader->freeBlocks, void*, i));
   }
+  g_array_free(reader->freeBlocks, /* freeSegment */ true);
+  g_array_free(reader->rowPointers, /* freeSegment */ true);
+  free(reader);
+}
 
-  if (setjmp(png_jmpbuf(png_ptr))) {
-    shovelerLogError("Failed to write PNG image to '%s': libpng called longjmp.", filename);
-    fclose(file);
-    png_destroy_write_struct(&png_ptr, &info_ptr);
-
-    // cleanup memory
-    for (unsigned int y = 0; y < image->height; y++) {
-      free(row_pointers[y]);
-    }
-    free(row_pointers);
-
+bool shovelerImagePngWriteFile(ShovelerImage* image, const char* filename) {
+  FILE* file = fopen(filename, "wb+");
+  if (file == NULL) {
+    shovelerLogError("Failed to write PNG image to '%s': fopen failed.", filename);
     return false;
   }
 
-  // set up writing
-  png_init_io(png_ptr, file);
-
-  // prepare header
-  png_set_IHDR(
-      png_ptr,
-      info_ptr,
-      image->width,
-      image->height,
-      8,
-      colorType,
-      PNG_INTERLACE_NONE,
-      PNG_COMPRESSION_TYPE_DEFAULT,
-      PNG_FILTER_TYPE_DEFAULT);
-
-  // prepare image contents
-  png_set_rows(png_ptr, info_ptr, row_pointers);
-
-  // write it to disk
-  png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
-
-  // free the libpng context
-  png_destroy_write_struct(&png_ptr, &info_ptr);
-
+  bool written = writePng(image, filename, file, /* output */ NULL);
   fclose(file);
+  return written;
+}
 
-  // Cceanup memory
-  for (unsigned int y = 0; y < image->height; y++) {
-    free(row_pointers[y]);
+bool shovelerImagePngWrite(ShovelerImage* image, GString* output) {
+  return writePng(image, "<memory>", /* file */ NULL, output);
+}
+
+static ShovelerImagePngReader* getThreadReader() {
+  ShovelerImagePngReader* reader = g_private_get(&threadReader);
+  if (reader == NULL) {
+    reader = shovelerImagePngReaderCreate();
+    g_private_set(&threadReader, reader);
   }
-  free(row_pointers);
 
-  shovelerLogInfo(
-      "Successfully wrote PNG image of size (%d, %d) with %d channels to '%s'.",
-      image->width,
-      image->height,
-      image->channels,
-      filename);
-  return true;
+  return reader;
+}
+
+static void freeThreadReader(void* readerPointer) {
+  ShovelerImagePngReader* reader = readerPointer;
+  shovelerImagePngReaderFree(reader);
 }
 
-static ShovelerImage* readPng(ShovelerInputStream* inputStream) {
+/**
+ * Decodes a PNG from the input stream either into the target image if it is not NULL, or into a
+ * newly created image returned through outputImage otherwise.
+ */
+static bool readPng(
+    ShovelerImagePngReader* reader,
+    ShovelerInputStream* inputStream,
+    ShovelerImage* targetImage,
+    ShovelerImage** outputImage) {
   png_byte header[PNG_HEADER_CHECK_BYTES];
   if (shovelerInputStreamRead(inputStream, header, PNG_HEADER_CHECK_BYTES) <
       PNG_HEADER_CHECK_BYTES) {
     shovelerLogError(
         "Failed to read PNG image from %s: failed to read PNG header.",
         shovelerInputStreamGetDescription(inputStream));
-    return NULL;
+    return false;
   }
 
   if (png_sig_cmp(header, 0, 8)) {
     shovelerLogError(
         "Failed to read PNG image from %s: libpng header signature mismatch.",
         shovelerInputStreamGetDescription(inputStream));
-    return NULL;
+    return false;
   }
 
-  png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  png_structp png = png_create_read_struct_2(
+      PNG_LIBPNG_VER_STRING,
+      inputStream,
+      handlePngReadError,
+      handlePngReadWarning,
+      reader,
+      allocateBlock,
+      releaseBlock);
   if (png == NULL) {
     shovelerLogError(
         "Failed to read PNG image from %s: failed to create libpng read struct.",
@@ -212,142 +239,216 @@ static ShovelerImage* readPng(ShovelerInputStream* inputStream) {
     shovelerLogError(
         "Failed to read PNG image from %s: failed to create libpng info struct.",
         shovelerInputStreamGetDescription(inputStream));
+    png_destroy_read_struct(&png, NULL, NULL);
     return false;
   }
 
-  png_infop endInfo = png_create_info_struct(png);
-  if (endInfo == NULL) {
-    shovelerLogError(
-        "Failed to read PNG image from %s: failed to create libpng end info struct.",
-        shovelerInputStreamGetDescription(inputStream));
-    return false;
-  }
-
-  png_uint_32 width = 0;
-  png_uint_32 channels = 0;
-  png_byte bitDepth = 0;
-
-  // the following variables are volatile because they are modified after setjmp, and accessed
-  // within the setjmp
-  volatile png_uint_32 height = 0;
-  png_bytep* volatile rowPointers = NULL;
+  // modified after setjmp and accessed within the setjmp, so it must be volatile
+  ShovelerImage* volatile createdImage = NULL;
 
   if (setjmp(png_jmpbuf(png))) {
-    png_destroy_read_struct(&png, &info, &endInfo);
-    freeRowPointers(height, rowPointers);
-    return NULL;
+    png_destroy_read_struct(&png, &info, NULL);
+    if (createdImage != NULL) {
+      shovelerImageFree(createdImage);
+    }
+    return false;
   }
 
-  png_set_error_fn(png, inputStream, handlePngReadError, handlePngReadWarning);
   png_set_sig_bytes(png, 8);
 
-  if (inputStream->type == SHOVELER_INPUT_STREAM_TYPE_FILE) {
-    png_init_io(png, inputStream->fileSource.file);
-  } else {
-    png_set_read_fn(png, inputStream, readInputStream);
-  }
+  png_set_read_fn(png, inputStream, readInputStream);
 
-  bool read = readPngData(png, info, endInfo, &width, &height, &channels, &bitDepth, &rowPointers);
-  png_destroy_read_struct(&png, &info, &endInfo);
+  png_byte bitDepth = 0;
+  bool read =
+      readPngData(reader, png, info, inputStream, targetImage, &createdImage, &bitDepth);
+  png_destroy_read_struct(&png, &info, NULL);
   if (!read) {
-    return NULL;
+    if (createdImage != NULL) {
+      shovelerImageFree(createdImage);
+    }
+    return false;
   }
 
-  ShovelerImage* image = createImageFromRowPointers(width, height, channels, rowPointers);
-  freeRowPointers(height, rowPointers);
+  ShovelerImage* image = targetImage != NULL ? targetImage : createdImage;
+  if (outputImage != NULL) {
+    *outputImage = image;
+  }
 
   shovelerLogInfo(
       "Successfully read %d-bit PNG image of size (%d, %d) with %d channels from %s.",
       bitDepth,
-      width,
-      height,
-      channels,
+      image->width,
+      image->height,
+      image->channels,
       shovelerInputStreamGetDescription(inputStream));
-  return image;
+  return true;
 }
 
 static bool readPngData(
+    ShovelerImagePngReader* reader,
     png_structp png,
     png_infop info,
-    png_infop endInfo,
-    png_uint_32* width,
-    volatile png_uint_32* height,
-    png_uint_32* channels,
-    png_byte* bitDepth,
-    png_bytep* volatile* rowPointersPointer) {
+    ShovelerInputStream* inputStream,
+    ShovelerImage* targetImage,
+    ShovelerImage* volatile* createdImage,
+    png_byte* bitDepthPointer) {
   png_read_info(png, info);
-  *width = png_get_image_width(png, info);
-  *height = png_get_image_height(png, info);
-  *bitDepth = png_get_bit_depth(png, info);
+  png_uint_32 width = png_get_image_width(png, info);
+  png_uint_32 height = png_get_image_height(png, info);
+  png_byte bitDepth = png_get_bit_depth(png, info);
   png_byte colorType = png_get_color_type(png, info);
-  png_size_t rowbytes = png_get_rowbytes(png, info);
+  *bitDepthPointer = bitDepth;
 
-  if (*bitDepth < 8) {
+  if (bitDepth < 8) {
     png_set_packing(png); // make sure bit depths below 8 bit are expanded to a char
-  } else if (*bitDepth == 16) {
+  } else if (bitDepth == 16) {
     png_set_scale_16(png); // make sure 16 bit gets truncated to 8 bit
   }
 
-  *channels = 0;
+  if (colorType == PNG_COLOR_TYPE_PALETTE) {
+    png_set_palette_to_rgb(png);
+  }
+
+  int channels = getChannelsForColorType(colorType);
+  if (channels == 0) {
+    shovelerLogError(
+        "Failed to read PNG image from %s: unsupported color type %d.",
+        shovelerInputStreamGetDescription(inputStream),
+        colorType);
+    return false;
+  }
+
+  png_read_update_info(png, info);
+  png_size_t rowbytes = png_get_rowbytes(png, info);
+  if (rowbytes != (png_size_t) width * channels) {
+    shovelerLogError(
+        "Failed to read PNG image from %s: decoded rows have %zu bytes instead of %zu.",
+        shovelerInputStreamGetDescription(inputStream),
+        rowbytes,
+        (png_size_t) width * channels);
+    return false;
+  }
+
+  ShovelerImage* image = targetImage;
+  if (image == NULL) {
+    image = shovelerImageCreate(width, height, channels);
+    *createdImage = image;
+  } else if (image->width != width || image->height != height || image->channels != channels) {
+    shovelerLogError(
+        "Failed to read PNG image of size (%d, %d) with %d channels from %s into image of size "
+        "(%d, %d) with %d channels.",
+        width,
+        height,
+        channels,
+        shovelerInputStreamGetDescription(inputStream),
+        image->width,
+        image->height,
+        image->channels);
+    return false;
+  }
+
+  // PNG rows are stored top to bottom, while images are stored bottom to top, so point libpng at
+  // the image rows in reverse.
+  g_array_set_size(reader->rowPointers, height);
+  unsigned char** rowPointers = (unsigned char**) reader->rowPointers->data;
+  for (png_uint_32 y = 0; y < height; y++) {
+    rowPointers[y] = &shovelerImageGet(image, 0, height - y - 1, 0);
+  }
 
+  png_read_image(png, rowPointers);
+  return true;
+}
+
+static int getChannelsForColorType(png_byte colorType) {
   switch (colorType) {
   case PNG_COLOR_TYPE_GRAY:
-    *channels = 1;
-    break;
+    return 1;
   case PNG_COLOR_TYPE_GRAY_ALPHA:
-    *channels = 2;
-    break;
+    return 2;
   case PNG_COLOR_TYPE_PALETTE:
-    *channels = 3;
-    png_set_palette_to_rgb(png);
-    break;
+    return 3;
   case PNG_COLOR_TYPE_RGB:
-    *channels = 3;
-    break;
+    return 3;
   case PNG_COLOR_TYPE_RGB_ALPHA:
-    *channels = 4;
-    break;
+    return 4;
   default:
-    shovelerLogError("Failed to read PNG image: unsupported color type %d.", colorType);
-    png_destroy_read_struct(&png, &info, &endInfo);
-    return false;
-    break;
+    return 0;
   }
-
-  *rowPointersPointer = malloc(*height * sizeof(png_bytep));
-  for (png_uint_32 y = 0; y < *height; y++) {
-    (*rowPointersPointer)[y] = malloc(rowbytes * sizeof(png_byte));
-  }
-
-  png_read_image(png, *rowPointersPointer);
-  return true;
 }
 
 static void readInputStream(png_structp png, png_bytep outBytes, png_size_t bytesToReadSize) {
   if (bytesToReadSize > INT_MAX) {
     shovelerLogWarning(
-        "Integer overflow when trying to read %zu bytes from memory stream.", bytesToReadSize);
+        "Integer overflow when trying to read %zu bytes from input stream.", bytesToReadSize);
     return;
   }
   int bytesToRead = (int) bytesToReadSize;
 
   ShovelerInputStream* inputStream = (ShovelerInputStream*) png_get_io_ptr(png);
-  shovelerInputStreamRead(inputStream, outBytes, bytesToRead);
+  if (shovelerInputStreamRead(inputStream, outBytes, bytesToRead) < bytesToRead) {
+    png_error(png, "unexpected end of input");
+  }
 }
 
-static ShovelerImage* createImageFromRowPointers(
-    png_uint_32 width, png_uint_32 height, png_uint_32 channels, png_bytep* rowPointers) {
-  ShovelerImage* image = shovelerImageCreate(width, height, channels);
-  for (unsigned int y = 0; y < height; y++) {
-    png_byte* row = rowPointers[y];
-    for (unsigned int x = 0; x < width; x++) {
-      unsigned char* ptr = &(row[x * channels]);
-      for (unsigned int c = 0; c < channels; c++) {
-        shovelerImageGet(image, x, height - y - 1, c) = ptr[c];
-      }
+/**
+ * Allocates memory for libpng, preferring a recycled block of at least the requested size. Each
+ * block starts with a header holding its capacity.
+ */
+static png_voidp allocateBlock(png_structp png, png_alloc_size_t size) {
+  ShovelerImagePngReader* reader = png_get_mem_ptr(png);
+
+  for (guint i = 0; i < reader->freeBlocks->len; i++) {
+    unsigned char* block = g_array_index(reader->freeBlocks, unsigned char*, i);
+    size_t capacity = *(size_t*) block;
+    // don't hand out blocks that are much larger than needed, to keep those for large requests
+    if (capacity >= size && capacity / 2 <= size) {
+      g_array_remove_index_fast(reader->freeBlocks, i);
+      return block + BLOCK_HEADER_SIZE;
     }
   }
-  return image;
+
+  unsigned char* block = malloc(BLOCK_HEADER_SIZE + size);
+  if (block == NULL) {
+    return NULL;
+  }
+
+  *(size_t*) block = size;
+  return block + BLOCK_HEADER_SIZE;
+}
+
+static void releaseBlock(png_structp png, png_voidp pointer) {
+  if (pointer == NULL) {
+    return;
+  }
+
+  ShovelerImagePngReader* reader = png_get_mem_ptr(png);
+  unsigned char* block = (unsigned char*) pointer - BLOCK_HEADER_SIZE;
+  if (reader->freeBlocks->len >= SHOVELER_IMAGE_PNG_READER_MAX_FREE_BLOCKS) {
+    free(block);
+    return;
+  }
+
+  g_array_append_val(reader->freeBlocks, block);
+}
+
+static void runReadJob(ShovelerExecutorJob* job, void* readJobPointer) {
+  ReadJob* readJob = readJobPointer;
+  if (shovelerExecutorJobIsCancelled(job)) {
+    return;
+  }
+
+  readJob->image = shovelerImagePngReadBuffer(readJob->buffer, readJob->bufferSize);
+}
+
+static void completeReadJob(ShovelerExecutorJob* job, bool cancelled, void* readJobPointer) {
+  ReadJob* readJob = readJobPointer;
+  if (cancelled && readJob->image != NULL) {
+    shovelerImageFree(readJob->image);
+    readJob->image = NULL;
+  }
+
+  readJob->complete(readJob->image, readJob->userData);
+  free(readJob);
 }
 
 static void handlePngReadError(png_structp png, png_const_charp error) {
@@ -367,12 +468,125 @@ static void handlePngReadWarning(png_structp png, png_const_charp warning) {
       warning);
 }
 
-static void freeRowPointers(png_uint_32 height, png_bytep* rowPointers) {
-  // Cleanup memory if already allocated
-  if (rowPointers != NULL) {
-    for (png_uint_32 y = 0; y < height; y++) {
-      free(rowPointers[y]);
+/** Encodes the image into either the file or the output string, with target used for logging. */
+static bool writePng(ShovelerImage* image, const char* target, FILE* file, GString* output) {
+  assert(
+      image->height <=
+      UINT_MAX / sizeof(png_bytep)); // image->height * sizeof(png_bytep) won't overflow
+
+  if (image->channels > 4) {
+    shovelerLogError(
+        "Failed to write PNG image to '%s': can only write image with up to 4 channels.", target);
+    return false;
+  }
+
+  png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (png_ptr == NULL) {
+    shovelerLogError(
+        "Failed to write PNG image to '%s': failed to create libpng write struct.", target);
+    return false;
+  }
+
+  png_infop info_ptr = png_create_info_struct(png_ptr);
+  if (info_ptr == NULL) {
+    shovelerLogError(
+        "Failed to write PNG image to '%s': failed to create libpng info struct.", target);
+    png_destroy_write_struct(&png_ptr, NULL);
+    return false;
+  }
+
+  png_byte colorType = 0;
+  switch (image->channels) {
+  case 1:
+    colorType = PNG_COLOR_TYPE_GRAY;
+    break;
+  case 2:
+    colorType = PNG_COLOR_TYPE_GRAY_ALPHA;
+    break;
+  case 3:
+    colorType = PNG_COLOR_TYPE_RGB;
+    break;
+  case 4:
+    colorType = PNG_COLOR_TYPE_RGB_ALPHA;
+    break;
+  default:
+    shovelerLogError(
+        "Failed to write PNG image to '%s': unsupported number of channels.", target);
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+    return false;
+    break;
+  }
+
+  png_bytep* row_pointers = malloc(image->height * sizeof(png_bytep));
+
+  for (unsigned int y = 0; y < image->height; y++) {
+    row_pointers[y] = malloc(image->width * image->channels * sizeof(png_byte));
+
+    for (unsigned int x = 0; x < image->width; x++) {
+      for (unsigned int c = 0; c < image->channels; c++) {
+        row_pointers[y][image->channels * x + c] =
+            shovelerImageGet(image, x, image->height - y - 1, c);
+      }
+    }
+  }
+
+  if (setjmp(png_jmpbuf(png_ptr))) {
+    shovelerLogError("Failed to write PNG image to '%s': libpng called longjmp.", target);
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+
+    // cleanup memory
+    for (unsigned int y = 0; y < image->height; y++) {
+      free(row_pointers[y]);
     }
-    free(rowPointers);
+    free(row_pointers);
+
+    return false;
   }
+
+  // set up writing
+  if (file != NULL) {
+    png_init_io(png_ptr, file);
+  } else {
+    png_set_write_fn(png_ptr, output, appendOutput, /* output_flush_fn */ NULL);
+  }
+
+  // prepare header
+  png_set_IHDR(
+      png_ptr,
+      info_ptr,
+      image->width,
+      image->height,
+      8,
+      colorType,
+      PNG_INTERLACE_NONE,
+      PNG_COMPRESSION_TYPE_DEFAULT,
+      PNG_FILTER_TYPE_DEFAULT);
+
+  // prepare image contents
+  png_set_rows(png_ptr, info_ptr, row_pointers);
+
+  // write it out
+  png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
+
+  // free the libpng context
+  png_destroy_write_struct(&png_ptr, &info_ptr);
+
+  // Cceanup memory
+  for (unsigned int y = 0; y < image->height; y++) {
+    free(row_pointers[y]);
+  }
+  free(row_pointers);
+
+  shovelerLogInfo(
+      "Successfully wrote PNG image of size (%d, %d) with %d channels to '%s'.",
+      image->width,
+      image->height,
+      image->channels,
+      target);
+  return true;
+}
+
+static void appendOutput(png_structp png, png_bytep bytes, png_size_t numBytes) {
+  GString* output = png_get_io_ptr(png);
+  g_string_append_len(output, (const gchar*) bytes, (gssize) numBytes);
 }
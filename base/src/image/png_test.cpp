@@ -11,10 +11,15 @@
 #include <type_traits>
 
 extern "C" {
+#include "shoveler/executor.h"
 #include "shoveler/image.h"
 #include "shoveler/image/png.h"
 }
 
+static void storeReadImage(ShovelerImage* image, void* imagePointer) {
+  *static_cast<ShovelerImage**>(imagePointer) = image;
+}
+
 class ShovelerImagePngTest : public ::testing::Test {
 public:
   virtual void SetUp() {
@@ -34,6 +39,16 @@ public:
     remove(testFilename);
   }
 
+  std::string WriteAndReadContents(ShovelerImage* image) {
+    bool written = shovelerImagePngWriteFile(image, testFilename);
+    EXPECT_TRUE(written) << "png should be written successfully";
+
+    std::ifstream file(testFilename, std::ios::binary);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+  }
+
   const char* testFilename = "test.png";
   ShovelerImage* testImage;
 };
@@ -65,3 +80,128 @@ TEST_F(ShovelerImagePngTest, writeReadMemory) {
 
   shovelerImageFree(image);
 }
+
+TEST_F(ShovelerImagePngTest, writeReadBuffer) {
+  GString* output = g_string_new("");
+  bool written = shovelerImagePngWrite(testImage, output);
+  ASSERT_TRUE(written) << "png should be written successfully";
+  ASSERT_EQ(std::string(output->str, output->len), WriteAndReadContents(testImage))
+      << "png written to memory should be equal to png written to file";
+
+  ShovelerImage* image =
+      shovelerImagePngReadBuffer(reinterpret_cast<const unsigned char*>(output->str), output->len);
+  ASSERT_TRUE(image != NULL) << "png should be read successfully";
+  ASSERT_EQ(*image, *testImage) << "read image should be equal to test image";
+
+  shovelerImageFree(image);
+  g_string_free(output, true);
+}
+
+TEST_F(ShovelerImagePngTest, readBufferSize) {
+  std::string contents = WriteAndReadContents(testImage);
+
+  unsigned int width = 0;
+  unsigned int height = 0;
+  unsigned int channels = 0;
+  bool read = shovelerImagePngReadBufferSize(
+      reinterpret_cast<const unsigned char*>(contents.c_str()),
+      contents.size(),
+      &width,
+      &height,
+      &channels);
+  ASSERT_TRUE(read);
+  ASSERT_EQ(width, testImage->width);
+  ASSERT_EQ(height, testImage->height);
+  ASSERT_EQ(channels, testImage->channels);
+
+  bool readTruncated = shovelerImagePngReadBufferSize(
+      reinterpret_cast<const unsigned char*>(contents.c_str()), 20, &width, &height, &channels);
+  ASSERT_FALSE(readTruncated);
+}
+
+TEST_F(ShovelerImagePngTest, readBufferInto) {
+  std::string contents = WriteAndReadContents(testImage);
+  const auto* buffer = reinterpret_cast<const unsigned char*>(contents.c_str());
+  ShovelerImagePngReader* reader = shovelerImagePngReaderCreate();
+
+  ShovelerImage* image = shovelerImageCreate(2, 2, 3);
+  bool read = shovelerImagePngReaderReadBufferInto(reader, buffer, contents.size(), image);
+  ASSERT_TRUE(read) << "png should be read into matching image";
+  ASSERT_EQ(*image, *testImage) << "read image should be equal to test image";
+
+  ShovelerImage* mismatchingImage = shovelerImageCreate(2, 2, 4);
+  bool readMismatching =
+      shovelerImagePngReaderReadBufferInto(reader, buffer, contents.size(), mismatchingImage);
+  ASSERT_FALSE(readMismatching) << "png should not be read into image with other channels";
+
+  shovelerImageFree(mismatchingImage);
+  shovelerImageFree(image);
+  shovelerImagePngReaderFree(reader);
+}
+
+TEST_F(ShovelerImagePngTest, readerReuse) {
+  ShovelerImage* largeImage = shovelerImageCreate(67, 31, 4);
+  for (unsigned int i = 0; i < largeImage->width * largeImage->height * largeImage->channels; i++) {
+    largeImage->data[i] = static_cast<unsigned char>((i * 7919) >> 3);
+  }
+  std::string largeContents = WriteAndReadContents(largeImage);
+  std::string smallContents = WriteAndReadContents(testImage);
+  ShovelerImagePngReader* reader = shovelerImagePngReaderCreate();
+
+  for (int i = 0; i < 5; i++) {
+    ShovelerImage* image = shovelerImagePngReaderReadBuffer(
+        reader,
+        reinterpret_cast<const unsigned char*>(largeContents.c_str()),
+        largeContents.size());
+    ASSERT_TRUE(image != NULL);
+    ASSERT_EQ(*image, *largeImage) << "large image should match in iteration " << i;
+    shovelerImageFree(image);
+
+    image = shovelerImagePngReaderReadBuffer(
+        reader,
+        reinterpret_cast<const unsigned char*>(smallContents.c_str()),
+        smallContents.size());
+    ASSERT_TRUE(image != NULL);
+    ASSERT_EQ(*image, *testImage) << "small image should match in iteration " << i;
+    shovelerImageFree(image);
+  }
+  ASSERT_GT(reader->freeBlocks->len, 0) << "libpng allocations should be kept for reuse";
+
+  ShovelerImage* truncatedImage = shovelerImagePngReaderReadBuffer(
+      reader,
+      reinterpret_cast<const unsigned char*>(largeContents.c_str()),
+      largeContents.size() / 2);
+  ASSERT_TRUE(truncatedImage == NULL) << "truncated png should fail to read";
+
+  shovelerImagePngReaderFree(reader);
+  shovelerImageFree(largeImage);
+}
+
+TEST_F(ShovelerImagePngTest, readBufferAsync) {
+  static const int numImages = 16;
+  std::string contents = WriteAndReadContents(testImage);
+  ShovelerExecutor* executor = shovelerExecutorCreateThreadPool(/* numWorkers */ 4);
+
+  ShovelerImage* images[numImages];
+  for (int i = 0; i < numImages; i++) {
+    images[i] = NULL;
+    shovelerImagePngReadBufferAsync(
+        executor,
+        reinterpret_cast<const unsigned char*>(contents.c_str()),
+        contents.size(),
+        storeReadImage,
+        &images[i]);
+  }
+
+  while (executor->numPendingJobs > 0) {
+    shovelerExecutorUpdate(executor, 0);
+  }
+
+  for (int i = 0; i < numImages; i++) {
+    ASSERT_TRUE(images[i] != NULL) << "image " << i << " should be read";
+    ASSERT_EQ(*images[i], *testImage) << "image " << i << " should be equal to test image";
+    shovelerImageFree(images[i]);
+  }
+
+  shovelerExecutorFree(executor);
+}
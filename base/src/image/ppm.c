@@ -2,7 +2,7 @@
 
 #include <limits.h> // UCHAR_MAX
 #include <stddef.h> // NULL
-#include <stdio.h> // FILE, fopen, fgets, getc, ungetc, fscanf, fclose
+#include <stdio.h> // FILE, fopen, fprintf, fclose
 #include <string.h> // strncmp
 
 #include "shoveler/input_stream.h"
@@ -131,11 +131,33 @@ static ShovelerImage* readPpm(ShovelerInputStream* inputStream) {
 
   ShovelerImage* image = shovelerImageCreate(width, height, 3);
 
+  // scan the pixel values directly from the stream's buffer rather than reading them one by one
+  const unsigned char* data;
+  int bytesLeft = shovelerInputStreamPeek(inputStream, &data);
+  int index = 0;
+
   for (unsigned int y = 0; y < height; y++) {
     for (unsigned int x = 0; x < width; x++) {
-      int r = shovelerInputStreamReadInt(inputStream);
-      int g = shovelerInputStreamReadInt(inputStream);
-      int b = shovelerInputStreamReadInt(inputStream);
+      int values[3];
+      for (int channel = 0; channel < 3; channel++) {
+        int bytesParsed =
+            shovelerInputStreamParseInt(data + index, bytesLeft - index, &values[channel]);
+        if (bytesParsed == 0) {
+          shovelerLogError(
+              "Failed to read PPM image from %s: unexpected end of file when parsing pixel (%d, "
+              "%d).",
+              shovelerInputStreamGetDescription(inputStream),
+              x,
+              y);
+          shovelerImageFree(image);
+          return NULL;
+        }
+        index += bytesParsed;
+      }
+
+      int r = values[0];
+      int g = values[1];
+      int b = values[2];
       if (r < 0 || r > maxValue || g < 0 || g > maxValue || b < 0 || b > maxValue) {
         shovelerLogError(
             "Failed to read PPM image from %s: invalid pixel (%d, %d) value of (%d, %d, %d).",
@@ -153,6 +175,7 @@ static ShovelerImage* readPpm(ShovelerInputStream* inputStream) {
       shovelerImageGet(image, x, y, 2) = (unsigned char) ((double) UCHAR_MAX * b / maxValue);
     }
   }
+  shovelerInputStreamSkip(inputStream, index);
 
   shovelerLogInfo(
       "Successfully read PPM image of size (%d, %d) from %s.",
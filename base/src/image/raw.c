@@ -0,0 +1,226 @@
+#include "shoveler/image/raw.h"
+
+#include <glib.h>
+#include <limits.h> // INT_MAX UCHAR_MAX
+#include <stdlib.h> // NULL
+#include <string.h> // memcmp memcpy
+#include <zlib.h>
+
+#include "shoveler/log.h"
+
+static bool readHeader(
+    const unsigned char* buffer,
+    int bufferSize,
+    ShovelerImageRawCompression* compression,
+    unsigned int* width,
+    unsigned int* height,
+    unsigned int* channels);
+static bool readData(
+    const unsigned char* buffer,
+    int bufferSize,
+    ShovelerImageRawCompression compression,
+    ShovelerImage* image);
+static void appendUint32(GString* output, guint32 value);
+static guint32 readUint32(const unsigned char* buffer);
+
+static const char rawMagic[4] = {'S', 'H', 'V', 'R'};
+
+ShovelerImage* shovelerImageRawReadBuffer(const unsigned char* buffer, int bufferSize) {
+  ShovelerImageRawCompression compression;
+  unsigned int width;
+  unsigned int height;
+  unsigned int channels;
+  if (!readHeader(buffer, bufferSize, &compression, &width, &height, &channels)) {
+    return NULL;
+  }
+
+  ShovelerImage* image = shovelerImageCreate(width, height, channels);
+  if (!readData(buffer, bufferSize, compression, image)) {
+    shovelerImageFree(image);
+    return NULL;
+  }
+
+  shovelerLogTrace(
+      "Read raw image of size (%u, %u) with %u channels from buffer (%d bytes).",
+      width,
+      height,
+      channels,
+      bufferSize);
+  return image;
+}
+
+bool shovelerImageRawReadBufferInto(
+    const unsigned char* buffer, int bufferSize, ShovelerImage* image) {
+  ShovelerImageRawCompression compression;
+  unsigned int width;
+  unsigned int height;
+  unsigned int channels;
+  if (!readHeader(buffer, bufferSize, &compression, &width, &height, &channels)) {
+    return false;
+  }
+
+  if (image->width != width || image->height != height || image->channels != channels) {
+    shovelerLogError(
+        "Failed to read raw image of size (%u, %u) with %u channels into image of size (%u, %u) "
+        "with %u channels.",
+        width,
+        height,
+        channels,
+        image->width,
+        image->height,
+        image->channels);
+    return false;
+  }
+
+  return readData(buffer, bufferSize, compression, image);
+}
+
+bool shovelerImageRawWrite(
+    ShovelerImage* image, ShovelerImageRawCompression compression, int level, GString* output) {
+  if (image->channels > UCHAR_MAX) {
+    shovelerLogError(
+        "Failed to write raw image: can only write images with up to %d channels.", UCHAR_MAX);
+    return false;
+  }
+
+  size_t initialLength = output->len;
+  g_string_append_len(output, rawMagic, sizeof(rawMagic));
+  g_string_append_c(output, SHOVELER_IMAGE_RAW_VERSION);
+  g_string_append_c(output, (gchar) compression);
+  g_string_append_c(output, (gchar) image->channels);
+  g_string_append_c(output, 0);
+  appendUint32(output, image->width);
+  appendUint32(output, image->height);
+
+  size_t dataSize = (size_t) image->width * image->height * image->channels;
+  switch (compression) {
+  case SHOVELER_IMAGE_RAW_COMPRESSION_NONE:
+    g_string_append_len(output, (const gchar*) image->data, (gssize) dataSize);
+    break;
+  case SHOVELER_IMAGE_RAW_COMPRESSION_DEFLATE: {
+    size_t headerEnd = output->len;
+    uLongf compressedSize = compressBound(dataSize);
+    g_string_set_size(output, headerEnd + compressedSize);
+
+    int ret = compress2(
+        (Bytef*) output->str + headerEnd, &compressedSize, image->data, dataSize, level);
+    if (ret != Z_OK) {
+      shovelerLogError("Failed to write raw image: failed to compress data: %s", zError(ret));
+      g_string_truncate(output, initialLength);
+      return false;
+    }
+
+    g_string_truncate(output, headerEnd + compressedSize);
+    break;
+  }
+  default:
+    shovelerLogError("Failed to write raw image: unknown compression %d.", compression);
+    g_string_truncate(output, initialLength);
+    return false;
+  }
+
+  return true;
+}
+
+static bool readHeader(
+    const unsigned char* buffer,
+    int bufferSize,
+    ShovelerImageRawCompression* compression,
+    unsigned int* width,
+    unsigned int* height,
+    unsigned int* channels) {
+  if (bufferSize < SHOVELER_IMAGE_RAW_HEADER_SIZE) {
+    shovelerLogError(
+        "Failed to read raw image from buffer (%d bytes): buffer too small for header.",
+        bufferSize);
+    return false;
+  }
+
+  if (memcmp(buffer, rawMagic, sizeof(rawMagic)) != 0) {
+    shovelerLogError(
+        "Failed to read raw image from buffer (%d bytes): magic mismatch.", bufferSize);
+    return false;
+  }
+
+  if (buffer[4] != SHOVELER_IMAGE_RAW_VERSION) {
+    shovelerLogError(
+        "Failed to read raw image from buffer (%d bytes): unsupported version %d.",
+        bufferSize,
+        buffer[4]);
+    return false;
+  }
+
+  *compression = (ShovelerImageRawCompression) buffer[5];
+  *channels = buffer[6];
+  *width = readUint32(buffer + 8);
+  *height = readUint32(buffer + 12);
+
+  if (*channels == 0 || *width == 0 || *height == 0 ||
+      (guint64) *width * *height * *channels > INT_MAX) {
+    shovelerLogError(
+        "Failed to read raw image from buffer (%d bytes): invalid size (%u, %u) with %u channels.",
+        bufferSize,
+        *width,
+        *height,
+        *channels);
+    return false;
+  }
+
+  return true;
+}
+
+static bool readData(
+    const unsigned char* buffer,
+    int bufferSize,
+    ShovelerImageRawCompression compression,
+    ShovelerImage* image) {
+  const unsigned char* data = buffer + SHOVELER_IMAGE_RAW_HEADER_SIZE;
+  size_t dataSize = (size_t) (bufferSize - SHOVELER_IMAGE_RAW_HEADER_SIZE);
+  size_t imageSize = (size_t) image->width * image->height * image->channels;
+
+  switch (compression) {
+  case SHOVELER_IMAGE_RAW_COMPRESSION_NONE:
+    if (dataSize != imageSize) {
+      shovelerLogError(
+          "Failed to read raw image from buffer (%d bytes): expected %zu bytes of data but got "
+          "%zu.",
+          bufferSize,
+          imageSize,
+          dataSize);
+      return false;
+    }
+
+    memcpy(image->data, data, imageSize);
+    return true;
+  case SHOVELER_IMAGE_RAW_COMPRESSION_DEFLATE: {
+    uLongf decompressedSize = imageSize;
+    int ret = uncompress(image->data, &decompressedSize, data, dataSize);
+    if (ret != Z_OK || decompressedSize != imageSize) {
+      shovelerLogError(
+          "Failed to read raw image from buffer (%d bytes): failed to decompress data: %s",
+          bufferSize,
+          ret != Z_OK ? zError(ret) : "size mismatch");
+      return false;
+    }
+
+    return true;
+  }
+  default:
+    shovelerLogError(
+        "Failed to read raw image from buffer (%d bytes): unknown compression %d.",
+        bufferSize,
+        compression);
+    return false;
+  }
+}
+
+static void appendUint32(GString* output, guint32 value) {
+  for (int i = 0; i < 4; i++) {
+    g_string_append_c(output, (gchar) ((value >> (8 * i)) & 0xff));
+  }
+}
+
+static guint32 readUint32(const unsigned char* buffer) {
+  return (guint32) buffer[0] | (guint32) buffer[1] << 8 | (guint32) buffer[2] << 16 |
+      (guint32) buffer[3] << 24;
+}
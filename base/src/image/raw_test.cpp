@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "image_testing.h"
+#include <cstring>
+#include <map>
+#include <string>
+
+extern "C" {
+#include "shoveler/image.h"
+#include "shoveler/image/raw.h"
+#include <zlib.h>
+}
+
+class ShovelerImageRawTest : public ::testing::Test {
+public:
+  virtual void SetUp() {
+    testImage = shovelerImageCreate(37, 19, 4);
+    for (unsigned int y = 0; y < testImage->height; y++) {
+      for (unsigned int x = 0; x < testImage->width; x++) {
+        shovelerImageGet(testImage, x, y, 0) = static_cast<unsigned char>(x * 7);
+        shovelerImageGet(testImage, x, y, 1) = static_cast<unsigned char>(y * 13);
+        shovelerImageGet(testImage, x, y, 2) = static_cast<unsigned char>((x / 4) * 40);
+        shovelerImageGet(testImage, x, y, 3) = 255;
+      }
+    }
+  }
+
+  virtual void TearDown() { shovelerImageFree(testImage); }
+
+  ShovelerImage* testImage;
+};
+
+TEST_F(ShovelerImageRawTest, writeRead) {
+  std::map<std::string, ShovelerImageRawCompression> testCases = {
+      {"none", SHOVELER_IMAGE_RAW_COMPRESSION_NONE},
+      {"deflate", SHOVELER_IMAGE_RAW_COMPRESSION_DEFLATE}};
+
+  for (const auto& testCase : testCases) {
+    const std::string& testCaseName = testCase.first;
+    GString* data = g_string_new("prefix");
+    bool written = shovelerImageRawWrite(testImage, testCase.second, Z_BEST_SPEED, data);
+    ASSERT_TRUE(written) << testCaseName << " raw image should be written successfully";
+
+    const auto* buffer = reinterpret_cast<const unsigned char*>(data->str) + strlen("prefix");
+    int bufferSize = static_cast<int>(data->len - strlen("prefix"));
+    ShovelerImage* image = shovelerImageRawReadBuffer(buffer, bufferSize);
+    ASSERT_TRUE(image != NULL) << testCaseName << " raw image should be read successfully";
+    ASSERT_EQ(*image, *testImage) << testCaseName << " read image should equal test image";
+    shovelerImageFree(image);
+
+    ShovelerImage* truncatedImage = shovelerImageRawReadBuffer(buffer, bufferSize - 1);
+    ASSERT_TRUE(truncatedImage == NULL) << testCaseName << " truncated image should fail to read";
+
+    g_string_free(data, true);
+  }
+}
+
+TEST_F(ShovelerImageRawTest, readInto) {
+  GString* data = g_string_new("");
+  shovelerImageRawWrite(testImage, SHOVELER_IMAGE_RAW_COMPRESSION_DEFLATE, Z_BEST_SPEED, data);
+  const auto* buffer = reinterpret_cast<const unsigned char*>(data->str);
+
+  ShovelerImage* image = shovelerImageCreate(testImage->width, testImage->height, 4);
+  bool read = shovelerImageRawReadBufferInto(buffer, static_cast<int>(data->len), image);
+  ASSERT_TRUE(read) << "raw image should be read into matching image";
+  ASSERT_EQ(*image, *testImage);
+
+  ShovelerImage* mismatchingImage = shovelerImageCreate(testImage->width, testImage->height, 3);
+  bool readMismatching =
+      shovelerImageRawReadBufferInto(buffer, static_cast<int>(data->len), mismatchingImage);
+  ASSERT_FALSE(readMismatching) << "raw image should not be read into image with other channels";
+
+  shovelerImageFree(mismatchingImage);
+  shovelerImageFree(image);
+  g_string_free(data, true);
+}
+
+TEST_F(ShovelerImageRawTest, readInvalid) {
+  const char* testInput = "the bird is the word";
+  ShovelerImage* image = shovelerImageRawReadBuffer(
+      reinterpret_cast<const unsigned char*>(testInput), static_cast<int>(strlen(testInput)));
+  ASSERT_TRUE(image == NULL) << "invalid raw image should fail to read";
+}
@@ -0,0 +1,208 @@
+#include <glib.h>
+#include <shoveler/image.h>
+#include <shoveler/log.h>
+#include <stdlib.h> // EXIT_SUCCESS, rand
+
+#define IMAGE_WIDTH 3840
+#define IMAGE_HEIGHT 2160
+#define IMAGE_CHANNELS 4
+#define NUM_ITERATIONS 10
+
+typedef ShovelerImage*(TransformFunction)(ShovelerImage* input);
+
+static void benchmarkTransform(
+    const char* name,
+    ShovelerImage* input,
+    TransformFunction* transform,
+    TransformFunction* referenceTransform);
+static gint64 timeTransform(ShovelerImage* input, TransformFunction* transform);
+static ShovelerImage* createFlippedXReference(ShovelerImage* input);
+static ShovelerImage* createFlippedYReference(ShovelerImage* input);
+static ShovelerImage* createRotatedClockwiseReference(ShovelerImage* input);
+static ShovelerImage* createRotatedCounterClockwiseReference(ShovelerImage* input);
+static void addSubImageReference(
+    ShovelerImage* image, int xOffset, int yOffset, ShovelerImage* subImage);
+
+int main(int argc, char* argv[]) {
+  shovelerLogInit("shoveler/", SHOVELER_LOG_LEVEL_INFO_UP, stdout);
+  srand(0);
+
+  ShovelerImage* input = shovelerImageCreate(IMAGE_WIDTH, IMAGE_HEIGHT, IMAGE_CHANNELS);
+  for (unsigned int i = 0; i < IMAGE_WIDTH * IMAGE_HEIGHT * IMAGE_CHANNELS; i++) {
+    input->data[i] = (unsigned char) (rand() % 256);
+  }
+
+  benchmarkTransform("Flip x", input, shovelerImageCreateFlippedX, createFlippedXReference);
+  benchmarkTransform("Flip y", input, shovelerImageCreateFlippedY, createFlippedYReference);
+  benchmarkTransform(
+      "Rotate clockwise",
+      input,
+      shovelerImageCreateRotatedClockwise,
+      createRotatedClockwiseReference);
+  benchmarkTransform(
+      "Rotate counter clockwise",
+      input,
+      shovelerImageCreateRotatedCounterClockwise,
+      createRotatedCounterClockwiseReference);
+
+  // sub images are offset so that they are clipped against the image on two sides
+  ShovelerImage* image = shovelerImageCreate(IMAGE_WIDTH, IMAGE_HEIGHT, IMAGE_CHANNELS);
+  gint64 startTime = g_get_monotonic_time();
+  for (int i = 0; i < NUM_ITERATIONS; i++) {
+    shovelerImageAddSubImage(image, -17, 33, input);
+  }
+  gint64 subImageTimeUs = g_get_monotonic_time() - startTime;
+
+  startTime = g_get_monotonic_time();
+  for (int i = 0; i < NUM_ITERATIONS; i++) {
+    addSubImageReference(image, -17, 33, input);
+  }
+  gint64 referenceSubImageTimeUs = g_get_monotonic_time() - startTime;
+
+  shovelerLogInfo(
+      "Add sub image: %.2fms per %dx%d image, %.2fms with per pixel loops.",
+      (double) subImageTimeUs / NUM_ITERATIONS / 1000.0,
+      IMAGE_WIDTH,
+      IMAGE_HEIGHT,
+      (double) referenceSubImageTimeUs / NUM_ITERATIONS / 1000.0);
+
+  startTime = g_get_monotonic_time();
+  for (int i = 0; i < NUM_ITERATIONS; i++) {
+    shovelerImageSet(image, shovelerColor(10, 20, 30), /* alpha */ 255);
+    shovelerImageAddFrame(image, /* size */ 8, shovelerColor(255, 255, 255));
+  }
+  gint64 setFrameTimeUs = g_get_monotonic_time() - startTime;
+
+  shovelerLogInfo(
+      "Set and add frame: %.2fms per %dx%d image.",
+      (double) setFrameTimeUs / NUM_ITERATIONS / 1000.0,
+      IMAGE_WIDTH,
+      IMAGE_HEIGHT);
+
+  // a tileset of 1024 pixel tiles spans 4096x3072 pixels, about the size of a 4K image
+  ShovelerImage* tile = shovelerImageCreate(1024, 1024, IMAGE_CHANNELS);
+  shovelerImageAddSubImage(tile, 0, 0, input);
+  startTime = g_get_monotonic_time();
+  for (int i = 0; i < NUM_ITERATIONS; i++) {
+    ShovelerImage* tileset = shovelerImageCreateAnimationTileset(tile, /* shiftAmount */ 64);
+    shovelerImageFree(tileset);
+  }
+  gint64 tilesetTimeUs = g_get_monotonic_time() - startTime;
+
+  shovelerLogInfo(
+      "Animation tileset: %.2fms per tileset of %dx%d tiles.",
+      (double) tilesetTimeUs / NUM_ITERATIONS / 1000.0,
+      tile->width,
+      tile->height);
+
+  shovelerImageFree(tile);
+  shovelerImageFree(image);
+  shovelerImageFree(input);
+  shovelerLogTerminate();
+
+  return EXIT_SUCCESS;
+}
+
+static void benchmarkTransform(
+    const char* name,
+    ShovelerImage* input,
+    TransformFunction* transform,
+    TransformFunction* referenceTransform) {
+  gint64 timeUs = timeTransform(input, transform);
+  gint64 referenceTimeUs = timeTransform(input, referenceTransform);
+
+  shovelerLogInfo(
+      "%s: %.2fms per %dx%d image, %.2fms with per pixel loops (%.1fx).",
+      name,
+      (double) timeUs / NUM_ITERATIONS / 1000.0,
+      input->width,
+      input->height,
+      (double) referenceTimeUs / NUM_ITERATIONS / 1000.0,
+      (double) referenceTimeUs / timeUs);
+}
+
+static gint64 timeTransform(ShovelerImage* input, TransformFunction* transform) {
+  gint64 startTime = g_get_monotonic_time();
+  for (int i = 0; i < NUM_ITERATIONS; i++) {
+    ShovelerImage* output = transform(input);
+    shovelerImageFree(output);
+  }
+  return g_get_monotonic_time() - startTime;
+}
+
+// The previous per pixel implementations of the image transforms, kept as a baseline.
+
+static ShovelerImage* createFlippedXReference(ShovelerImage* input) {
+  ShovelerImage* image = shovelerImageCreate(input->width, input->height, input->channels);
+  for (unsigned int i = 0; i < image->width; i++) {
+    for (unsigned int j = 0; j < image->height; j++) {
+      for (unsigned int c = 0; c < image->channels; c++) {
+        shovelerImageGet(image, i, j, c) = shovelerImageGet(input, image->width - i - 1, j, c);
+      }
+    }
+  }
+  return image;
+}
+
+static ShovelerImage* createFlippedYReference(ShovelerImage* input) {
+  ShovelerImage* image = shovelerImageCreate(input->width, input->height, input->channels);
+  for (unsigned int i = 0; i < image->width; i++) {
+    for (unsigned int j = 0; j < image->height; j++) {
+      for (unsigned int c = 0; c < image->channels; c++) {
+        shovelerImageGet(image, i, j, c) = shovelerImageGet(input, i, image->height - j - 1, c);
+      }
+    }
+  }
+  return image;
+}
+
+/** The previous rotation loops, indexed by the input dimensions so that they also handle the
+ * non-square benchmark image. */
+static ShovelerImage* createRotatedClockwiseReference(ShovelerImage* input) {
+  ShovelerImage* image = shovelerImageCreate(input->height, input->width, input->channels);
+  for (unsigned int i = 0; i < input->width; i++) {
+    for (unsigned int j = 0; j < input->height; j++) {
+      for (unsigned int c = 0; c < image->channels; c++) {
+        shovelerImageGet(image, j, input->width - i - 1, c) = shovelerImageGet(input, i, j, c);
+      }
+    }
+  }
+  return image;
+}
+
+static ShovelerImage* createRotatedCounterClockwiseReference(ShovelerImage* input) {
+  ShovelerImage* image = shovelerImageCreate(input->height, input->width, input->channels);
+  for (unsigned int i = 0; i < input->width; i++) {
+    for (unsigned int j = 0; j < input->height; j++) {
+      for (unsigned int c = 0; c < image->channels; c++) {
+        shovelerImageGet(image, input->height - j - 1, i, c) = shovelerImageGet(input, i, j, c);
+      }
+    }
+  }
+  return image;
+}
+
+static void addSubImageReference(
+    ShovelerImage* image, int xOffset, int yOffset, ShovelerImage* subImage) {
+  for (unsigned int i = 0; i < subImage->width; i++) {
+    if (xOffset < 0 && (unsigned int) -xOffset > i) {
+      continue;
+    }
+    unsigned int imageI = xOffset + i;
+    if (imageI >= image->width) {
+      continue;
+    }
+    for (unsigned int j = 0; j < subImage->height; j++) {
+      if (yOffset < 0 && (unsigned int) -yOffset > j) {
+        continue;
+      }
+      unsigned int imageJ = yOffset + j;
+      if (imageJ >= image->height) {
+        continue;
+      }
+      for (unsigned int c = 0; c < subImage->channels; c++) {
+        shovelerImageGet(image, imageI, imageJ, c) = shovelerImageGet(subImage, i, j, c);
+      }
+    }
+  }
+}
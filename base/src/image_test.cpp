@@ -0,0 +1,379 @@
+#include <gtest/gtest.h>
+
+#include "image_testing.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "shoveler/image.h"
+}
+
+static std::vector<unsigned char> createPlane(unsigned int size) {
+  std::vector<unsigned char> plane(size);
+  for (unsigned int i = 0; i < size; i++) {
+    plane[i] = (unsigned char) (rand() % 256);
+  }
+  return plane;
+}
+
+static ShovelerImage* createRandomImage(
+    unsigned int width, unsigned int height, unsigned int channels) {
+  ShovelerImage* image = shovelerImageCreate(width, height, channels);
+  for (unsigned int i = 0; i < width * height * channels; i++) {
+    image->data[i] = (unsigned char) (rand() % 256);
+  }
+  return image;
+}
+
+// The previous per pixel implementations of the image transforms, used as reference.
+
+static ShovelerImage* createFlippedXReference(ShovelerImage* input) {
+  ShovelerImage* image = shovelerImageCreate(input->width, input->height, input->channels);
+  for (unsigned int i = 0; i < image->width; i++) {
+    for (unsigned int j = 0; j < image->height; j++) {
+      for (unsigned int c = 0; c < image->channels; c++) {
+        shovelerImageGet(image, i, j, c) = shovelerImageGet(input, image->width - i - 1, j, c);
+      }
+    }
+  }
+  return image;
+}
+
+static ShovelerImage* createFlippedYReference(ShovelerImage* input) {
+  ShovelerImage* image = shovelerImageCreate(input->width, input->height, input->channels);
+  for (unsigned int i = 0; i < image->width; i++) {
+    for (unsigned int j = 0; j < image->height; j++) {
+      for (unsigned int c = 0; c < image->channels; c++) {
+        shovelerImageGet(image, i, j, c) = shovelerImageGet(input, i, image->height - j - 1, c);
+      }
+    }
+  }
+  return image;
+}
+
+static ShovelerImage* createRotatedClockwiseReference(ShovelerImage* input) {
+  ShovelerImage* image = shovelerImageCreate(input->height, input->width, input->channels);
+  for (unsigned int i = 0; i < image->width; i++) {
+    for (unsigned int j = 0; j < image->height; j++) {
+      for (unsigned int c = 0; c < image->channels; c++) {
+        shovelerImageGet(image, j, image->width - i - 1, c) = shovelerImageGet(input, i, j, c);
+      }
+    }
+  }
+  return image;
+}
+
+static ShovelerImage* createRotatedCounterClockwiseReference(ShovelerImage* input) {
+  ShovelerImage* image = shovelerImageCreate(input->height, input->width, input->channels);
+  for (unsigned int i = 0; i < image->width; i++) {
+    for (unsigned int j = 0; j < image->height; j++) {
+      for (unsigned int c = 0; c < image->channels; c++) {
+        shovelerImageGet(image, image->height - j - 1, i, c) = shovelerImageGet(input, i, j, c);
+      }
+    }
+  }
+  return image;
+}
+
+static void setReference(ShovelerImage* image, ShovelerColor color, unsigned char alpha) {
+  for (unsigned int i = 0; i < image->width; i++) {
+    for (unsigned int j = 0; j < image->height; j++) {
+      for (unsigned int c = 0; c < image->channels; c++) {
+        unsigned char value = c == 0 ? color.r : c == 1 ? color.g : c == 2 ? color.b : alpha;
+        shovelerImageGet(image, i, j, c) = value;
+      }
+    }
+  }
+}
+
+static void addFrameReference(ShovelerImage* image, unsigned int size, ShovelerColor color) {
+  for (unsigned int i = 0; i < image->width; i++) {
+    for (unsigned int j = 0; j < image->height; j++) {
+      unsigned int borderDistance = std::min(
+          std::min(i, image->width - 1 - i), std::min(j, image->height - 1 - j));
+      if (borderDistance < size) {
+        unsigned char alpha = 255.0 * ((double) (size - borderDistance) / size);
+        shovelerImageGet(image, i, j, 0) = color.r;
+        shovelerImageGet(image, i, j, 1) = color.r;
+        shovelerImageGet(image, i, j, 2) = color.r;
+        shovelerImageGet(image, i, j, 3) = alpha;
+      }
+    }
+  }
+}
+
+static void addSubImageReference(
+    ShovelerImage* image, int xOffset, int yOffset, ShovelerImage* subImage) {
+  for (unsigned int i = 0; i < subImage->width; i++) {
+    if (xOffset < 0 && (unsigned int) -xOffset > i) {
+      continue;
+    }
+    unsigned int imageI = xOffset + i;
+    if (imageI >= image->width) {
+      continue;
+    }
+    for (unsigned int j = 0; j < subImage->height; j++) {
+      if (yOffset < 0 && (unsigned int) -yOffset > j) {
+        continue;
+      }
+      unsigned int imageJ = yOffset + j;
+      if (imageJ >= image->height) {
+        continue;
+      }
+      for (unsigned int c = 0; c < subImage->channels; c++) {
+        shovelerImageGet(image, imageI, imageJ, c) = shovelerImageGet(subImage, i, j, c);
+      }
+    }
+  }
+}
+
+TEST(image, interleave3) {
+  ShovelerImage* image = shovelerImageCreate(/* width */ 2, /* height */ 2, /* channels */ 3);
+  const unsigned char plane0[] = {0, 1, 2, 3};
+  const unsigned char plane1[] = {10, 11, 12, 13};
+  const unsigned char plane2[] = {20, 21, 22, 23};
+
+  shovelerImageInterleave3(image, 0, 0, 2, 2, plane0, plane1, plane2);
+
+  const unsigned char expected[] = {0, 10, 20, 1, 11, 21, 2, 12, 22, 3, 13, 23};
+  ASSERT_EQ(memcmp(image->data, expected, sizeof(expected)), 0);
+  shovelerImageFree(image);
+}
+
+TEST(image, interleave3MatchesScalar) {
+  srand(0);
+
+  // Widths are chosen to cover the vectorized blocks as well as the scalar remainder.
+  const unsigned int widths[] = {1, 15, 16, 17, 33, 64, 100};
+  for (unsigned int width : widths) {
+    unsigned int height = 7;
+    std::vector<unsigned char> plane0 = createPlane(width * height);
+    std::vector<unsigned char> plane1 = createPlane(width * height);
+    std::vector<unsigned char> plane2 = createPlane(width * height);
+
+    ShovelerImage* expected = shovelerImageCreate(width, height, /* channels */ 3);
+    ShovelerImage* actual = shovelerImageCreate(width, height, /* channels */ 3);
+    shovelerImageClear(expected);
+    shovelerImageClear(actual);
+
+    shovelerImageInterleave3Scalar(
+        expected, 0, 0, width, height, plane0.data(), plane1.data(), plane2.data());
+    shovelerImageInterleave3(
+        actual, 0, 0, width, height, plane0.data(), plane1.data(), plane2.data());
+    ASSERT_EQ(memcmp(expected->data, actual->data, width * height * 3), 0) << "width " << width;
+
+    shovelerImageFree(actual);
+    shovelerImageFree(expected);
+  }
+}
+
+TEST(image, interleave3Region) {
+  srand(0);
+  unsigned int width = 50;
+  unsigned int height = 20;
+  std::vector<unsigned char> plane0 = createPlane(width * height);
+  std::vector<unsigned char> plane1 = createPlane(width * height);
+  std::vector<unsigned char> plane2 = createPlane(width * height);
+
+  ShovelerImage* expected = shovelerImageCreate(width, height, /* channels */ 3);
+  ShovelerImage* actual = shovelerImageCreate(width, height, /* channels */ 3);
+  shovelerImageClear(expected);
+  shovelerImageClear(actual);
+
+  shovelerImageInterleave3Scalar(
+      expected, 3, 5, 40, 10, plane0.data(), plane1.data(), plane2.data());
+  shovelerImageInterleave3(actual, 3, 5, 40, 10, plane0.data(), plane1.data(), plane2.data());
+  ASSERT_EQ(memcmp(expected->data, actual->data, width * height * 3), 0);
+
+  // pixels outside the region are untouched
+  ASSERT_EQ(shovelerImageGet(actual, 2, 5, 0), 0);
+  ASSERT_EQ(shovelerImageGet(actual, 43, 5, 0), 0);
+  ASSERT_EQ(shovelerImageGet(actual, 3, 4, 0), 0);
+  ASSERT_EQ(shovelerImageGet(actual, 3, 5, 0), plane0[5 * width + 3]);
+  ASSERT_EQ(shovelerImageGet(actual, 42, 14, 2), plane2[14 * width + 42]);
+
+  shovelerImageFree(actual);
+  shovelerImageFree(expected);
+}
+
+TEST(image, transformsMatchReference) {
+  srand(0);
+
+  // Sizes are chosen to cover the SIMD tiles and rotation blocks as well as their remainders.
+  const unsigned int sizes[] = {1, 3, 4, 5, 31, 32, 33, 67};
+  const unsigned int channelCounts[] = {1, 3, 4};
+  for (unsigned int size : sizes) {
+    for (unsigned int channels : channelCounts) {
+      ShovelerImage* input = createRandomImage(size, size, channels);
+
+      ShovelerImage* expected = createFlippedXReference(input);
+      ShovelerImage* actual = shovelerImageCreateFlippedX(input);
+      ASSERT_EQ(*actual, *expected) << "flip x size " << size << " channels " << channels;
+      shovelerImageFree(actual);
+      shovelerImageFree(expected);
+
+      expected = createFlippedYReference(input);
+      actual = shovelerImageCreateFlippedY(input);
+      ASSERT_EQ(*actual, *expected) << "flip y size " << size << " channels " << channels;
+      shovelerImageFree(actual);
+      shovelerImageFree(expected);
+
+      expected = createRotatedClockwiseReference(input);
+      actual = shovelerImageCreateRotatedClockwise(input);
+      ASSERT_EQ(*actual, *expected) << "clockwise size " << size << " channels " << channels;
+      shovelerImageFree(actual);
+      shovelerImageFree(expected);
+
+      expected = createRotatedCounterClockwiseReference(input);
+      actual = shovelerImageCreateRotatedCounterClockwise(input);
+      ASSERT_EQ(*actual, *expected)
+          << "counter clockwise size " << size << " channels " << channels;
+      shovelerImageFree(actual);
+      shovelerImageFree(expected);
+
+      shovelerImageFree(input);
+    }
+  }
+}
+
+TEST(image, flipNonSquare) {
+  srand(0);
+  ShovelerImage* input = createRandomImage(/* width */ 37, /* height */ 10, /* channels */ 4);
+
+  ShovelerImage* expected = createFlippedXReference(input);
+  ShovelerImage* actual = shovelerImageCreateFlippedX(input);
+  ASSERT_EQ(*actual, *expected);
+  shovelerImageFree(actual);
+  shovelerImageFree(expected);
+
+  expected = createFlippedYReference(input);
+  actual = shovelerImageCreateFlippedY(input);
+  ASSERT_EQ(*actual, *expected);
+  shovelerImageFree(actual);
+  shovelerImageFree(expected);
+
+  shovelerImageFree(input);
+}
+
+TEST(image, rotateNonSquare) {
+  srand(0);
+  unsigned int width = 37;
+  unsigned int height = 10;
+  ShovelerImage* input = createRandomImage(width, height, /* channels */ 4);
+
+  ShovelerImage* clockwise = shovelerImageCreateRotatedClockwise(input);
+  ASSERT_EQ(clockwise->width, height);
+  ASSERT_EQ(clockwise->height, width);
+  for (unsigned int c = 0; c < 4; c++) {
+    ASSERT_EQ(shovelerImageGet(clockwise, 0, width - 1, c), shovelerImageGet(input, 0, 0, c));
+    ASSERT_EQ(shovelerImageGet(clockwise, 3, width - 6, c), shovelerImageGet(input, 5, 3, c));
+  }
+
+  ShovelerImage* restored = shovelerImageCreateRotatedCounterClockwise(clockwise);
+  ASSERT_EQ(*restored, *input) << "counter clockwise rotation should undo clockwise rotation";
+
+  shovelerImageFree(restored);
+  shovelerImageFree(clockwise);
+  shovelerImageFree(input);
+}
+
+TEST(image, setMatchesReference) {
+  const unsigned int channelCounts[] = {1, 2, 3, 4, 5};
+  for (unsigned int channels : channelCounts) {
+    ShovelerImage* expected = shovelerImageCreate(/* width */ 13, /* height */ 7, channels);
+    ShovelerImage* actual = shovelerImageCreate(/* width */ 13, /* height */ 7, channels);
+
+    setReference(expected, shovelerColor(10, 20, 30), /* alpha */ 40);
+    shovelerImageSet(actual, shovelerColor(10, 20, 30), /* alpha */ 40);
+    ASSERT_EQ(*actual, *expected) << "channels " << channels;
+
+    shovelerImageFree(actual);
+    shovelerImageFree(expected);
+  }
+}
+
+TEST(image, addFrameMatchesReference) {
+  srand(0);
+
+  const unsigned int widths[] = {1, 2, 9, 40};
+  const unsigned int heights[] = {1, 5, 40};
+  const unsigned int frameSizes[] = {0, 1, 3, 30};
+  for (unsigned int width : widths) {
+    for (unsigned int height : heights) {
+      for (unsigned int frameSize : frameSizes) {
+        ShovelerImage* expected = createRandomImage(width, height, /* channels */ 4);
+        ShovelerImage* actual = shovelerImageCreateCopy(expected);
+
+        addFrameReference(expected, frameSize, shovelerColor(200, 100, 50));
+        shovelerImageAddFrame(actual, frameSize, shovelerColor(200, 100, 50));
+        ASSERT_EQ(*actual, *expected)
+            << "width " << width << " height " << height << " frame size " << frameSize;
+
+        shovelerImageFree(actual);
+        shovelerImageFree(expected);
+      }
+    }
+  }
+}
+
+TEST(image, addSubImageMatchesReference) {
+  srand(0);
+  ShovelerImage* subImage = createRandomImage(/* width */ 7, /* height */ 5, /* channels */ 3);
+
+  const int offsets[] = {-10, -7, -3, 0, 2, 15, 20};
+  for (int xOffset : offsets) {
+    for (int yOffset : offsets) {
+      ShovelerImage* expected =
+          createRandomImage(/* width */ 20, /* height */ 16, /* channels */ 3);
+      ShovelerImage* actual = shovelerImageCreateCopy(expected);
+
+      addSubImageReference(expected, xOffset, yOffset, subImage);
+      shovelerImageAddSubImage(actual, xOffset, yOffset, subImage);
+      ASSERT_EQ(*actual, *expected) << "offset (" << xOffset << ", " << yOffset << ")";
+
+      shovelerImageFree(actual);
+      shovelerImageFree(expected);
+    }
+  }
+
+  shovelerImageFree(subImage);
+}
+
+TEST(image, animationTilesetMatchesReference) {
+  srand(0);
+  ShovelerImage* input = createRandomImage(/* width */ 18, /* height */ 18, /* channels */ 4);
+  unsigned int size = input->width;
+  int shiftAmount = 2;
+
+  ShovelerImage* moveImage = shovelerImageCreate(size, size, 4);
+  shovelerImageClear(moveImage);
+  addSubImageReference(moveImage, shiftAmount, 0, input);
+  ShovelerImage* moveImage2 = createFlippedXReference(moveImage);
+  ShovelerImage* frames[] = {input, moveImage, moveImage2};
+
+  ShovelerImage* expected = shovelerImageCreate(4 * size, 3 * size, 4);
+  shovelerImageClear(expected);
+  for (int i = 0; i < 3; i++) {
+    ShovelerImage* down = createFlippedYReference(frames[i]);
+    ShovelerImage* left = createRotatedCounterClockwiseReference(frames[i]);
+    ShovelerImage* right = createRotatedClockwiseReference(frames[i]);
+    addSubImageReference(expected, 0, i * size, frames[i]);
+    addSubImageReference(expected, size, i * size, down);
+    addSubImageReference(expected, 2 * size, i * size, left);
+    addSubImageReference(expected, 3 * size, i * size, right);
+    shovelerImageFree(down);
+    shovelerImageFree(left);
+    shovelerImageFree(right);
+  }
+
+  ShovelerImage* actual = shovelerImageCreateAnimationTileset(input, shiftAmount);
+  ASSERT_EQ(*actual, *expected);
+
+  shovelerImageFree(actual);
+  shovelerImageFree(expected);
+  shovelerImageFree(moveImage2);
+  shovelerImageFree(moveImage);
+  shovelerImageFree(input);
+}
@@ -1,28 +1,37 @@
 #include "shoveler/input_stream.h"
 
 #include <assert.h> // assert
-#include <errno.h> // errno
-#include <limits.h> // INT_MAX
-#include <stdarg.h> // va_list va_start
+#include <limits.h> // INT_MAX INT_MIN
+#include <stdbool.h> // bool
 #include <stdlib.h> // malloc free
-#include <string.h> // strerror
+#include <string.h> // memcpy
 
+#include "shoveler/file.h"
 #include "shoveler/log.h"
 
-static int scanInputStream(
-    ShovelerInputStream* inputStream, const char* extendedFormatString, void* output);
+static bool isWhitespace(unsigned char c);
 
 ShovelerInputStream* shovelerInputStreamCreateFile(const char* filename) {
-  FILE* file = fopen(filename, "rb");
-  if (file == NULL) {
-    shovelerLogError("Failed to open file '%s': %s.", filename, strerror(errno));
+  ShovelerFileMapping* fileMapping = shovelerFileMap(filename);
+  if (fileMapping == NULL) {
+    return NULL;
+  }
+
+  if (fileMapping->contentsSize > INT_MAX) {
+    shovelerLogError(
+        "Failed to open file '%s': size of %zu bytes exceeds the input stream limit.",
+        filename,
+        fileMapping->contentsSize);
+    shovelerFileUnmap(fileMapping);
     return NULL;
   }
 
   ShovelerInputStream* inputStream = malloc(sizeof(ShovelerInputStream));
   inputStream->type = SHOVELER_INPUT_STREAM_TYPE_FILE;
-  inputStream->fileSource.file = file;
-  inputStream->fileSource.filename = filename;
+  inputStream->buffer = fileMapping->contents;
+  inputStream->size = (int) fileMapping->contentsSize;
+  inputStream->index = 0;
+  inputStream->fileMapping = fileMapping;
   inputStream->description = g_string_new("");
   g_string_append_printf(inputStream->description, "file '%s'", filename);
 
@@ -32,9 +41,10 @@ ShovelerInputStream* shovelerInputStreamCreateFile(const char* filename) {
 ShovelerInputStream* shovelerInputStreamCreateMemory(const unsigned char* buffer, int size) {
   ShovelerInputStream* inputStream = malloc(sizeof(ShovelerInputStream));
   inputStream->type = SHOVELER_INPUT_STREAM_TYPE_MEMORY;
-  inputStream->memorySource.buffer = buffer;
-  inputStream->memorySource.size = size;
-  inputStream->memorySource.index = 0;
+  inputStream->buffer = buffer;
+  inputStream->size = size;
+  inputStream->index = 0;
+  inputStream->fileMapping = NULL;
   inputStream->description = g_string_new("");
   g_string_append_printf(inputStream->description, "buffer (%d bytes)", size);
 
@@ -46,65 +56,95 @@ const char* shovelerInputStreamGetDescription(ShovelerInputStream* inputStream)
 }
 
 int shovelerInputStreamGetc(ShovelerInputStream* inputStream) {
-  if (inputStream->type == SHOVELER_INPUT_STREAM_TYPE_FILE) {
-    return fgetc(inputStream->fileSource.file);
-  } else {
-    if (inputStream->memorySource.index >= inputStream->memorySource.size) {
-      return EOF;
-    }
-
-    return inputStream->memorySource.buffer[inputStream->memorySource.index++];
+  if (inputStream->index >= inputStream->size) {
+    return EOF;
   }
+
+  return inputStream->buffer[inputStream->index++];
 }
 
 int shovelerInputStreamRead(ShovelerInputStream* inputStream, unsigned char* target, int size) {
   assert(size > 0);
 
-  if (inputStream->type == SHOVELER_INPUT_STREAM_TYPE_FILE) {
-    size_t read = fread(target, /* byte size */ 1, (size_t) size, inputStream->fileSource.file);
-
-    if (read > INT_MAX) {
-      return 0;
-    }
-
-    return (int) read;
-  } else {
-    int bytesToRead = size;
-    int bytesLeft = inputStream->memorySource.size - inputStream->memorySource.index;
-    if (bytesToRead > bytesLeft) {
-      bytesToRead = bytesLeft;
-    }
+  const unsigned char* data;
+  int bytesRead = shovelerInputStreamReadSpan(inputStream, size, &data);
+  memcpy(target, data, (size_t) bytesRead);
+  return bytesRead;
+}
 
-    memcpy(
-        target,
-        inputStream->memorySource.buffer + inputStream->memorySource.index,
-        (size_t) bytesToRead);
-    inputStream->memorySource.index += bytesToRead;
-    return bytesToRead;
-  }
+int shovelerInputStreamReadSpan(
+    ShovelerInputStream* inputStream, int size, const unsigned char** dataPointer) {
+  int bytesLeft = shovelerInputStreamPeek(inputStream, dataPointer);
+  int bytesToRead = size < bytesLeft ? size : bytesLeft;
+  inputStream->index += bytesToRead;
+  return bytesToRead;
 }
 
 int shovelerInputStreamReadInt(ShovelerInputStream* inputStream) {
+  const unsigned char* data;
+  int bytesLeft = shovelerInputStreamPeek(inputStream, &data);
+
   int value = 0;
-  scanInputStream(inputStream, "%d%n", &value);
+  inputStream->index += shovelerInputStreamParseInt(data, bytesLeft, &value);
   return value;
 }
 
 int shovelerInputStreamUngetc(ShovelerInputStream* inputStream, int c) {
-  if (inputStream->type == SHOVELER_INPUT_STREAM_TYPE_FILE) {
-    return ungetc(c, inputStream->fileSource.file);
-  } else {
-    if (inputStream->memorySource.index <= 0) {
-      return EOF;
-    }
+  if (inputStream->index <= 0) {
+    return EOF;
+  }
+
+  unsigned char previous = inputStream->buffer[--inputStream->index];
+  if (previous != c) {
+    return EOF;
+  }
 
-    unsigned char previous = inputStream->memorySource.buffer[--inputStream->memorySource.index];
-    if (previous != c) {
-      return EOF;
+  return c;
+}
+
+int shovelerInputStreamSkip(ShovelerInputStream* inputStream, int size) {
+  const unsigned char* data;
+  return shovelerInputStreamReadSpan(inputStream, size, &data);
+}
+
+int shovelerInputStreamParseInt(const unsigned char* data, int size, int* outputValue) {
+  int index = 0;
+  while (index < size && isWhitespace(data[index])) {
+    index++;
+  }
+
+  bool negative = false;
+  if (index < size && (data[index] == '-' || data[index] == '+')) {
+    negative = data[index] == '-';
+    index++;
+  }
+
+  int digitsStart = index;
+  // accumulated as a negative number so that INT_MIN can be represented
+  long long value = 0;
+  while (index < size && data[index] >= '0' && data[index] <= '9') {
+    if (value > (long long) INT_MIN - 1) {
+      value = value * 10 - (data[index] - '0');
     }
+    index++;
+  }
 
-    return c;
+  if (index == digitsStart) {
+    return 0;
   }
+
+  if (!negative) {
+    value = -value;
+  }
+
+  if (value > INT_MAX) {
+    value = INT_MAX;
+  } else if (value < INT_MIN) {
+    value = INT_MIN;
+  }
+
+  *outputValue = (int) value;
+  return index;
 }
 
 void shovelerInputStreamFree(ShovelerInputStream* inputStream) {
@@ -112,26 +152,11 @@ void shovelerInputStreamFree(ShovelerInputStream* inputStream) {
     return;
   }
 
-  if (inputStream->type == SHOVELER_INPUT_STREAM_TYPE_FILE) {
-    fclose(inputStream->fileSource.file);
-  }
-
+  shovelerFileUnmap(inputStream->fileMapping);
   g_string_free(inputStream->description, /* freeSegment */ true);
   free(inputStream);
 }
 
-static int scanInputStream(
-    ShovelerInputStream* inputStream, const char* extendedFormatString, void* output) {
-  int bytesRead;
-  if (inputStream->type == SHOVELER_INPUT_STREAM_TYPE_FILE) {
-    return fscanf(inputStream->fileSource.file, extendedFormatString, output, &bytesRead);
-  } else {
-    int ret = sscanf(
-        (const char*) inputStream->memorySource.buffer + inputStream->memorySource.index,
-        extendedFormatString,
-        output,
-        &bytesRead);
-    inputStream->memorySource.index += bytesRead;
-    return ret;
-  }
+static bool isWhitespace(unsigned char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
 }
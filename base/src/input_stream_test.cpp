@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+extern "C" {
+#include "shoveler/file.h"
+#include "shoveler/input_stream.h"
+}
+
+static const char* testContents = "P3\n# comment\n  12 -34\t+56 2147483648x";
+
+class ShovelerInputStreamTest : public ::testing::Test {
+public:
+  virtual void SetUp() {
+    remove(testFilename);
+    shovelerFileWriteString(testFilename, testContents);
+  }
+
+  virtual void TearDown() { remove(testFilename); }
+
+  const char* testFilename = "test_input_stream.txt";
+};
+
+TEST_F(ShovelerInputStreamTest, peekSkip) {
+  ShovelerInputStream* inputStream = shovelerInputStreamCreateMemory(
+      reinterpret_cast<const unsigned char*>(testContents), strlen(testContents));
+
+  const unsigned char* data;
+  int bytesLeft = shovelerInputStreamPeek(inputStream, &data);
+  ASSERT_EQ(bytesLeft, strlen(testContents));
+  ASSERT_EQ(data, reinterpret_cast<const unsigned char*>(testContents))
+      << "peek should point into the underlying buffer";
+
+  int skipped = shovelerInputStreamSkip(inputStream, 3);
+  ASSERT_EQ(skipped, 3);
+  bytesLeft = shovelerInputStreamPeek(inputStream, &data);
+  ASSERT_EQ(bytesLeft, strlen(testContents) - 3);
+  ASSERT_EQ(*data, '#');
+
+  const unsigned char* span;
+  int spanSize = shovelerInputStreamReadSpan(inputStream, 9, &span);
+  ASSERT_EQ(spanSize, 9);
+  ASSERT_EQ(std::string(reinterpret_cast<const char*>(span), spanSize), "# comment");
+
+  skipped = shovelerInputStreamSkip(inputStream, 1000);
+  ASSERT_EQ(skipped, strlen(testContents) - 12) << "skip should stop at the end of the stream";
+  ASSERT_EQ(shovelerInputStreamPeek(inputStream, &data), 0);
+  ASSERT_EQ(shovelerInputStreamGetc(inputStream), EOF);
+
+  shovelerInputStreamFree(inputStream);
+}
+
+TEST_F(ShovelerInputStreamTest, readInt) {
+  ShovelerInputStream* inputStream = shovelerInputStreamCreateFile(testFilename);
+  ASSERT_TRUE(inputStream != NULL);
+  shovelerInputStreamSkip(inputStream, 12);
+
+  ASSERT_EQ(shovelerInputStreamReadInt(inputStream), 12);
+  ASSERT_EQ(shovelerInputStreamReadInt(inputStream), -34);
+  ASSERT_EQ(shovelerInputStreamReadInt(inputStream), 56);
+  ASSERT_EQ(shovelerInputStreamReadInt(inputStream), 2147483647) << "overflow should clamp";
+  ASSERT_EQ(shovelerInputStreamReadInt(inputStream), 0) << "non-digits should not parse";
+  ASSERT_EQ(shovelerInputStreamGetc(inputStream), 'x') << "failed parse should not consume";
+  ASSERT_EQ(shovelerInputStreamReadInt(inputStream), 0) << "end of stream should not parse";
+
+  shovelerInputStreamFree(inputStream);
+}
+
+TEST_F(ShovelerInputStreamTest, parseIntBounded) {
+  const unsigned char data[] = {'1', '2', '3', '4'};
+
+  int value = 0;
+  int bytesParsed = shovelerInputStreamParseInt(data, 2, &value);
+  ASSERT_EQ(bytesParsed, 2) << "parsing should stop at the given size";
+  ASSERT_EQ(value, 12);
+}
+
+TEST_F(ShovelerInputStreamTest, fileMapping) {
+  ShovelerFileMapping* fileMapping = shovelerFileMap(testFilename);
+  ASSERT_TRUE(fileMapping != NULL);
+  ASSERT_EQ(fileMapping->contentsSize, strlen(testContents));
+  ASSERT_EQ(
+      std::string(
+          reinterpret_cast<const char*>(fileMapping->contents), fileMapping->contentsSize),
+      testContents);
+  shovelerFileUnmap(fileMapping);
+
+  unsigned char* contents;
+  size_t contentsSize;
+  bool read = shovelerFileRead(testFilename, &contents, &contentsSize);
+  ASSERT_TRUE(read);
+  ASSERT_EQ(contentsSize, strlen(testContents));
+  ASSERT_STREQ(reinterpret_cast<const char*>(contents), testContents)
+      << "read contents should be zero terminated";
+  free(contents);
+}
+
+TEST_F(ShovelerInputStreamTest, emptyFile) {
+  shovelerFileWriteString(testFilename, "");
+
+  ShovelerInputStream* inputStream = shovelerInputStreamCreateFile(testFilename);
+  ASSERT_TRUE(inputStream != NULL) << "empty files should fall back to a read buffer";
+  ASSERT_EQ(shovelerInputStreamGetc(inputStream), EOF);
+  shovelerInputStreamFree(inputStream);
+}
@@ -4,13 +4,58 @@
 #include <stdbool.h> // bool
 #include <stddef.h> // NULL
 #include <stdio.h> // FILE, fprintf, fflush
-#include <stdlib.h> // free
+#include <stdlib.h> // malloc, free
 #include <string.h> // strdup, strstr
 
+#define LOG_ENTRY_MESSAGE_SIZE 256
+#define ASYNC_POLL_INTERVAL_US 10000
+#define ASYNC_TERMINATE_POLL_INTERVAL_US 100
+
+typedef struct {
+  ShovelerLogLevel level;
+  const char* file;
+  int line;
+  gint64 time;
+  /** heap allocated message if it didn't fit into the slot, or NULL */
+  char* longMessage;
+  char message[LOG_ENTRY_MESSAGE_SIZE];
+} LogEntry;
+
+/** Single producer, single consumer ring buffer of the messages logged by one thread. */
+typedef struct {
+  /** ring of numSlots entries, one of which is always kept free to tell a full ring from an empty
+   * one */
+  LogEntry* entries;
+  int numSlots;
+  /** index of the next entry to push, only written by the logging thread */
+  volatile gint tail;
+  /** index of the next entry to pop, only written by the logger thread */
+  volatile gint head;
+  /** async logging run the ring was created in */
+  int generation;
+  /** set once the logging thread exited, after which the logger frees the ring once drained */
+  bool threadExited;
+  /** set once async logging terminated, after which the logging thread frees the ring on exit */
+  bool detached;
+} LogRing;
+
 static void logHandler(const char* file, int line, ShovelerLogLevel level, const char* message);
 static bool shouldLog(ShovelerLogLevel level);
-static char* formatLogMessage(
-    const char* file, int line, ShovelerLogLevel level, const char* message);
+static void dispatchMessage(
+    const char* file, int line, ShovelerLogLevel level, gint64 time, const char* message);
+static void writeMessage(
+    const char* file, int line, ShovelerLogLevel level, gint64 time, const char* message);
+static void pushMessage(
+    const char* file, int line, ShovelerLogLevel level, const char* message, va_list va);
+static void waitForFlush();
+static bool beginAsyncAccess();
+static void endAsyncAccess();
+static LogRing* getThreadRing();
+static void releaseThreadRing(void* ringPointer);
+static gpointer runLogger(gpointer unused);
+static void drainRings();
+static void detachRing(void* ringPointer);
+static void freeRing(LogRing* ring);
 static const char* getStaticLogLevelName(ShovelerLogLevel level);
 
 static char* logLocationPrefix = NULL;
@@ -18,10 +63,37 @@ static ShovelerLogLevel logLevel;
 static FILE* logChannel;
 static ShovelerLogMessageCallbackFunction* logCallbackFunction = &logHandler;
 
+static volatile gint asyncRunning = 0;
+/** number of threads currently using the async state, which terminating waits to drop to zero */
+static volatile gint numAsyncAccesses = 0;
+static int asyncCapacity;
+/** incremented on every start so that threads can tell that their ring is from a previous run */
+static int asyncGeneration = 0;
+static GThread* loggerThread;
+static GMutex asyncMutex;
+static GCond asyncCondition;
+static GCond flushedCondition;
+static bool asyncShutdown;
+static int numFlushRequests;
+static int numCompletedFlushes;
+/** number of messages dropped by any thread, only touched when a ring is already full */
+static volatile gint numDropped;
+/** number of drops already reported by the logger thread */
+static int numReportedDropped;
+/** queue of (LogRing *) of all live threads that logged since async logging was started */
+static GQueue* rings;
+/** guards the rings queue and their ownership flags, statically allocated to outlive every run */
+static GMutex ringsMutex;
+/** (LogRing *) of the calling thread, released when the thread exits */
+static GPrivate threadRing = G_PRIVATE_INIT(releaseThreadRing);
+
+static _Thread_local bool isLoggerThread = false;
+
 void shovelerLogInit(const char* locationPrefix, ShovelerLogLevel level, FILE* channel) {
   logLocationPrefix = strdup(locationPrefix);
   logLevel = level;
   logChannel = channel;
+  logCallbackFunction = &logHandler;
 }
 
 void shovelerLogInitWithCallback(
@@ -31,57 +103,365 @@ void shovelerLogInitWithCallback(
   logCallbackFunction = callbackFunction;
 }
 
-void shovelerLogTerminate() { free(logLocationPrefix); }
+void shovelerLogStartAsync(int capacity) {
+  if (g_atomic_int_get(&asyncRunning)) {
+    return;
+  }
+
+  asyncCapacity = capacity;
+  asyncGeneration++;
+  g_mutex_init(&asyncMutex);
+  g_cond_init(&asyncCondition);
+  g_cond_init(&flushedCondition);
+  asyncShutdown = false;
+  numFlushRequests = 0;
+  numCompletedFlushes = 0;
+  numDropped = 0;
+  numReportedDropped = 0;
+  rings = g_queue_new();
+
+  loggerThread = g_thread_new("shoveler-logger", runLogger, NULL);
+  g_atomic_int_set(&asyncRunning, 1);
+}
+
+void shovelerLogFlush() {
+  if (isLoggerThread || !beginAsyncAccess()) {
+    return;
+  }
+
+  waitForFlush();
+  endAsyncAccess();
+}
+
+int shovelerLogGetNumDropped() { return g_atomic_int_get(&numDropped); }
+
+int shovelerLogGetNumThreadRings() {
+  g_mutex_lock(&ringsMutex);
+  int numThreadRings = rings != NULL ? (int) rings->length : 0;
+  g_mutex_unlock(&ringsMutex);
+
+  return numThreadRings;
+}
+
+void shovelerLogTerminate() {
+  if (g_atomic_int_get(&asyncRunning)) {
+    // Messages logged from now on are written synchronously, while the logger thread drains the
+    // pending ones before it exits. Threads that are still pushing a message or flushing might
+    // have seen async logging as running, so wait for them before tearing down what they use.
+    g_atomic_int_set(&asyncRunning, 0);
+    while (g_atomic_int_get(&numAsyncAccesses) > 0) {
+      g_usleep(ASYNC_TERMINATE_POLL_INTERVAL_US);
+    }
+
+    g_mutex_lock(&asyncMutex);
+    asyncShutdown = true;
+    g_cond_signal(&asyncCondition);
+    g_mutex_unlock(&asyncMutex);
+    g_thread_join(loggerThread);
+
+    // Rings of threads that are still alive are freed by those threads when they exit.
+    g_mutex_lock(&ringsMutex);
+    g_queue_free_full(rings, detachRing);
+    rings = NULL;
+    g_mutex_unlock(&ringsMutex);
+    g_cond_clear(&flushedCondition);
+    g_cond_clear(&asyncCondition);
+    g_mutex_clear(&asyncMutex);
+  }
+
+  free(logLocationPrefix);
+  logLocationPrefix = NULL;
+}
 
 void shovelerLogMessage(
     const char* file, int line, ShovelerLogLevel level, const char* message, ...) {
   if (shouldLog(level)) {
     va_list va;
     va_start(va, message);
-    GString* assembled = g_string_new("");
-    g_string_append_vprintf(assembled, message, va);
-    logCallbackFunction(file, line, level, assembled->str);
-    g_string_free(assembled, true);
+
+    // messages logged from the callback on the logger thread itself are written right away
+    if (!isLoggerThread && beginAsyncAccess()) {
+      pushMessage(file, line, level, message, va);
+      endAsyncAccess();
+    } else {
+      GString* assembled = g_string_new("");
+      g_string_append_vprintf(assembled, message, va);
+      dispatchMessage(file, line, level, g_get_real_time(), assembled->str);
+      g_string_free(assembled, true);
+    }
+
+    va_end(va);
   }
 }
 
 static void logHandler(const char* file, int line, ShovelerLogLevel level, const char* message) {
   if (logChannel != NULL) {
-    char* formatted = formatLogMessage(file, line, level, message);
-    fprintf(logChannel, "%s\n", formatted);
-    g_free(formatted);
+    writeMessage(file, line, level, g_get_real_time(), message);
     fflush(logChannel);
   }
 }
 
 static bool shouldLog(ShovelerLogLevel level) { return logLevel & level; }
 
-static char* formatLogMessage(
-    const char* file, int line, ShovelerLogLevel level, const char* message) {
-  const char* strippedLocation = strstr(file, logLocationPrefix);
+/** Passes a message to the callback, or writes it with its original timestamp to the channel. */
+static void dispatchMessage(
+    const char* file, int line, ShovelerLogLevel level, gint64 time, const char* message) {
+  if (logCallbackFunction != &logHandler) {
+    logCallbackFunction(file, line, level, message);
+    return;
+  }
+
+  if (logChannel != NULL) {
+    writeMessage(file, line, level, time, message);
+    if (!isLoggerThread) {
+      fflush(logChannel);
+    }
+  }
+}
+
+static void writeMessage(
+    const char* file, int line, ShovelerLogLevel level, gint64 time, const char* message) {
+  const char* strippedLocation =
+      logLocationPrefix != NULL ? strstr(file, logLocationPrefix) : NULL;
   if (strippedLocation != NULL) {
     strippedLocation += strlen(logLocationPrefix);
   } else {
     strippedLocation = file;
   }
 
-  GDateTime* now = g_date_time_new_now_local();
-  GString* result = g_string_new("");
+  GDateTime* dateTime = g_date_time_new_from_unix_local(time / G_USEC_PER_SEC);
 
-  g_string_append_printf(
-      result,
-      "[%02d:%02d:%02d.%03d] (%s:%s:%d) %s",
-      g_date_time_get_hour(now),
-      g_date_time_get_minute(now),
-      g_date_time_get_second(now),
-      g_date_time_get_microsecond(now) / 1000,
+  fprintf(
+      logChannel,
+      "[%02d:%02d:%02d.%03d] (%s:%s:%d) %s\n",
+      g_date_time_get_hour(dateTime),
+      g_date_time_get_minute(dateTime),
+      g_date_time_get_second(dateTime),
+      (int) (time % G_USEC_PER_SEC) / 1000,
       getStaticLogLevelName(level),
       strippedLocation,
       line,
       message);
 
-  g_date_time_unref(now);
-  return g_string_free(result, false);
+  g_date_time_unref(dateTime);
+}
+
+/**
+ * Formats the message body straight into the next slot of the calling thread's ring. If the ring is
+ * full, the message is dropped unless it is an error, which is instead written synchronously by
+ * waiting for the logger thread to make room and then to write it.
+ */
+static void pushMessage(
+    const char* file, int line, ShovelerLogLevel level, const char* message, va_list va) {
+  LogRing* ring = getThreadRing();
+
+  int tail = ring->tail;
+  int nextTail = (tail + 1) % ring->numSlots;
+  int head = g_atomic_int_get(&ring->head);
+  bool writeSynchronously = false;
+  if (nextTail == head) {
+    if (!(level & SHOVELER_LOG_LEVEL_ERROR)) {
+      g_atomic_int_inc(&numDropped);
+      return;
+    }
+
+    // a flush drains the whole ring since this thread isn't pushing anything meanwhile
+    waitForFlush();
+    head = g_atomic_int_get(&ring->head);
+    writeSynchronously = true;
+  }
+
+  LogEntry* entry = &ring->entries[tail];
+  entry->level = level;
+  entry->file = file;
+  entry->line = line;
+  entry->time = g_get_real_time();
+
+  va_list vaCopy;
+  va_copy(vaCopy, va);
+  int length = g_vsnprintf(entry->message, LOG_ENTRY_MESSAGE_SIZE, message, va);
+  entry->longMessage =
+      length >= LOG_ENTRY_MESSAGE_SIZE ? g_strdup_vprintf(message, vaCopy) : NULL;
+  va_end(vaCopy);
+
+  // publishes the entry to the logger thread
+  g_atomic_int_set(&ring->tail, nextTail);
+
+  // Wake up the logger thread once the ring is half full instead of waiting for its next poll,
+  // which only takes the lock once per half ring.
+  int numPending = (nextTail - head + ring->numSlots) % ring->numSlots;
+  if (numPending == (ring->numSlots - 1) / 2) {
+    g_mutex_lock(&asyncMutex);
+    g_cond_signal(&asyncCondition);
+    g_mutex_unlock(&asyncMutex);
+  }
+
+  if (writeSynchronously) {
+    waitForFlush();
+  }
+}
+
+/** Blocks until the logger thread drained all rings, which requires async access. */
+static void waitForFlush() {
+  g_mutex_lock(&asyncMutex);
+  int flushRequest = ++numFlushRequests;
+  g_cond_signal(&asyncCondition);
+  while (numCompletedFlushes < flushRequest) {
+    g_cond_wait(&flushedCondition, &asyncMutex);
+  }
+  g_mutex_unlock(&asyncMutex);
+}
+
+/**
+ * Registers the calling thread as using the async state if async logging is running, which keeps
+ * shovelerLogTerminate from tearing it down until the matching endAsyncAccess.
+ */
+static bool beginAsyncAccess() {
+  // Incrementing before checking pairs with terminating clearing asyncRunning before waiting for
+  // the count to drop, so that either this thread sees it cleared or terminating sees the count.
+  g_atomic_int_inc(&numAsyncAccesses);
+  if (!g_atomic_int_get(&asyncRunning)) {
+    endAsyncAccess();
+    return false;
+  }
+
+  return true;
+}
+
+static void endAsyncAccess() { g_atomic_int_dec_and_test(&numAsyncAccesses); }
+
+static LogRing* getThreadRing() {
+  LogRing* previousRing = g_private_get(&threadRing);
+  if (previousRing != NULL && previousRing->generation == asyncGeneration) {
+    return previousRing;
+  }
+
+  if (previousRing != NULL) {
+    releaseThreadRing(previousRing);
+  }
+
+  LogRing* ring = malloc(sizeof(LogRing));
+  ring->numSlots = asyncCapacity + 1;
+  ring->entries = malloc((size_t) ring->numSlots * sizeof(LogEntry));
+  ring->tail = 0;
+  ring->head = 0;
+  ring->generation = asyncGeneration;
+  ring->threadExited = false;
+  ring->detached = false;
+
+  g_mutex_lock(&ringsMutex);
+  g_queue_push_tail(rings, ring);
+  g_mutex_unlock(&ringsMutex);
+
+  g_private_set(&threadRing, ring);
+  return ring;
+}
+
+/**
+ * Gives up the logging thread's ownership of its ring when it exits or moves on to a ring of a
+ * later run. The ring is freed right away if async logging already let go of it, and otherwise
+ * by the logger thread once it drained the remaining messages.
+ */
+static void releaseThreadRing(void* ringPointer) {
+  LogRing* ring = ringPointer;
+
+  g_mutex_lock(&ringsMutex);
+  ring->threadExited = true;
+  bool detached = ring->detached;
+  g_mutex_unlock(&ringsMutex);
+
+  if (detached) {
+    freeRing(ring);
+  }
+}
+
+static gpointer runLogger(gpointer unused) {
+  isLoggerThread = true;
+
+  g_mutex_lock(&asyncMutex);
+  while (true) {
+    int flushRequest = numFlushRequests;
+    bool shutdown = asyncShutdown;
+    g_mutex_unlock(&asyncMutex);
+
+    drainRings();
+
+    g_mutex_lock(&asyncMutex);
+    numCompletedFlushes = flushRequest;
+    g_cond_broadcast(&flushedCondition);
+
+    if (shutdown) {
+      break;
+    }
+
+    if (numFlushRequests == flushRequest && !asyncShutdown) {
+      g_cond_wait_until(
+          &asyncCondition, &asyncMutex, g_get_monotonic_time() + ASYNC_POLL_INTERVAL_US);
+    }
+  }
+  g_mutex_unlock(&asyncMutex);
+
+  return NULL;
+}
+
+static void drainRings() {
+  g_mutex_lock(&ringsMutex);
+  GList* next;
+  for (GList* iter = rings->head; iter != NULL; iter = next) {
+    LogRing* ring = iter->data;
+    next = iter->next;
+
+    // Entries pushed while draining are picked up as well, but at most a full ring per pass so that
+    // a busy thread can't starve the others.
+    int head = ring->head;
+    for (int i = 0; i < ring->numSlots && head != g_atomic_int_get(&ring->tail); i++) {
+      LogEntry* entry = &ring->entries[head];
+      const char* message = entry->longMessage != NULL ? entry->longMessage : entry->message;
+      dispatchMessage(entry->file, entry->line, entry->level, entry->time, message);
+      g_free(entry->longMessage);
+
+      head = (head + 1) % ring->numSlots;
+      g_atomic_int_set(&ring->head, head);
+    }
+
+    // rings of exited threads don't receive any more messages, so they can go once drained
+    if (ring->threadExited && head == ring->tail) {
+      g_queue_delete_link(rings, iter);
+      freeRing(ring);
+    }
+  }
+  g_mutex_unlock(&ringsMutex);
+
+  int currentNumDropped = g_atomic_int_get(&numDropped);
+  if (currentNumDropped > numReportedDropped) {
+    GString* warning = g_string_new("");
+    g_string_append_printf(
+        warning,
+        "Dropped %d log messages because the logging threads' buffers were full.",
+        currentNumDropped - numReportedDropped);
+    dispatchMessage(
+        __FILE__, __LINE__, SHOVELER_LOG_LEVEL_WARNING, g_get_real_time(), warning->str);
+    g_string_free(warning, true);
+    numReportedDropped = currentNumDropped;
+  }
+
+  if (logCallbackFunction == &logHandler && logChannel != NULL) {
+    fflush(logChannel);
+  }
+}
+
+/** Gives up async logging's ownership of a ring, freeing it if its thread already exited. */
+static void detachRing(void* ringPointer) {
+  LogRing* ring = ringPointer;
+  ring->detached = true;
+  if (ring->threadExited) {
+    freeRing(ring);
+  }
+}
+
+static void freeRing(LogRing* ring) {
+  free(ring->entries);
+  free(ring);
 }
 
 static const char* getStaticLogLevelName(ShovelerLogLevel level) {
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "shoveler/log.h"
+}
+
+static void logMessage(const char* file, int line, ShovelerLogLevel level, const char* message);
+
+struct LoggedMessage {
+  int line;
+  ShovelerLogLevel level;
+  std::string message;
+};
+
+static std::mutex loggedMutex;
+static std::condition_variable loggedCondition;
+static std::vector<LoggedMessage> loggedMessages;
+static bool blockCallback;
+
+class ShovelerLogTest : public ::testing::Test {
+public:
+  virtual void SetUp() {
+    loggedMessages.clear();
+    blockCallback = false;
+    shovelerLogTerminate();
+    shovelerLogInitWithCallback(SHOVELER_LOG_LEVEL_ALL, logMessage);
+  }
+
+  virtual void TearDown() {
+    shovelerLogTerminate();
+    shovelerLogInit("shoveler/", SHOVELER_LOG_LEVEL_ALL, stdout);
+  }
+};
+
+TEST_F(ShovelerLogTest, async) {
+  shovelerLogStartAsync(SHOVELER_LOG_DEFAULT_ASYNC_CAPACITY);
+
+  std::string longMessage(1000, 'x');
+  shovelerLogInfo("first %d", 1);
+  int secondLine = __LINE__ + 1;
+  shovelerLogError("second %s", "message");
+  shovelerLogWarning("%s", longMessage.c_str());
+  shovelerLogFlush();
+
+  std::lock_guard<std::mutex> lock{loggedMutex};
+  ASSERT_EQ(loggedMessages.size(), 3);
+  ASSERT_EQ(loggedMessages[0].message, "first 1");
+  ASSERT_EQ(loggedMessages[0].level, SHOVELER_LOG_LEVEL_INFO);
+  ASSERT_EQ(loggedMessages[1].message, "second message");
+  ASSERT_EQ(loggedMessages[1].level, SHOVELER_LOG_LEVEL_ERROR);
+  ASSERT_EQ(loggedMessages[1].line, secondLine);
+  ASSERT_EQ(loggedMessages[2].message, longMessage)
+      << "messages too long for a ring slot should be written in full";
+}
+
+TEST_F(ShovelerLogTest, asyncMultipleThreads) {
+  static const int numThreads = 4;
+  static const int numMessagesPerThread = 100;
+
+  shovelerLogStartAsync(SHOVELER_LOG_DEFAULT_ASYNC_CAPACITY);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numThreads; i++) {
+    threads.emplace_back([i]() {
+      for (int j = 0; j < numMessagesPerThread; j++) {
+        shovelerLogInfo("thread %d message %d", i, j);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  shovelerLogFlush();
+
+  std::lock_guard<std::mutex> lock{loggedMutex};
+  ASSERT_EQ(loggedMessages.size(), numThreads * numMessagesPerThread);
+  ASSERT_EQ(shovelerLogGetNumDropped(), 0);
+}
+
+TEST_F(ShovelerLogTest, asyncDropWhenFull) {
+  static const int capacity = 4;
+  static const int numMessages = 10;
+
+  shovelerLogStartAsync(capacity);
+
+  // block the logger thread in the callback of the first message, which still occupies its slot
+  {
+    std::lock_guard<std::mutex> lock{loggedMutex};
+    blockCallback = true;
+  }
+  shovelerLogInfo("blocking");
+  {
+    std::unique_lock<std::mutex> lock{loggedMutex};
+    loggedCondition.wait(lock, []() { return !loggedMessages.empty(); });
+  }
+
+  for (int i = 0; i < numMessages; i++) {
+    shovelerLogInfo("message %d", i);
+  }
+  ASSERT_EQ(shovelerLogGetNumDropped(), numMessages - (capacity - 1));
+
+  {
+    std::lock_guard<std::mutex> lock{loggedMutex};
+    blockCallback = false;
+  }
+  loggedCondition.notify_all();
+  shovelerLogFlush();
+
+  std::lock_guard<std::mutex> lock{loggedMutex};
+  ASSERT_EQ(loggedMessages.size(), 1 + (capacity - 1) + 1)
+      << "accepted messages should be written followed by a drop warning";
+  ASSERT_EQ(loggedMessages[1].message, "message 0");
+  ASSERT_EQ(loggedMessages[capacity - 1].message, "message 2");
+  ASSERT_EQ(loggedMessages.rbegin()->level, SHOVELER_LOG_LEVEL_WARNING);
+}
+
+TEST_F(ShovelerLogTest, asyncWriteErrorsWhenFull) {
+  static const int capacity = 4;
+  static const int numMessages = 10;
+
+  shovelerLogStartAsync(capacity);
+
+  {
+    std::lock_guard<std::mutex> lock{loggedMutex};
+    blockCallback = true;
+  }
+
+  // The thread needs to log before the logger thread blocks, since that blocks while holding on to
+  // all rings, including the registration of new ones.
+  std::mutex filledMutex;
+  std::condition_variable filledCondition;
+  bool filled = false;
+  std::thread thread{[&]() {
+    shovelerLogInfo("blocking");
+    {
+      std::unique_lock<std::mutex> lock{loggedMutex};
+      loggedCondition.wait(lock, []() { return !loggedMessages.empty(); });
+    }
+
+    for (int i = 0; i < numMessages; i++) {
+      shovelerLogInfo("message %d", i);
+    }
+    {
+      std::lock_guard<std::mutex> lock{filledMutex};
+      filled = true;
+    }
+    filledCondition.notify_all();
+    shovelerLogError("error");
+  }};
+
+  {
+    std::unique_lock<std::mutex> lock{filledMutex};
+    filledCondition.wait(lock, [&]() { return filled; });
+  }
+  {
+    std::lock_guard<std::mutex> lock{loggedMutex};
+    blockCallback = false;
+  }
+  loggedCondition.notify_all();
+  thread.join();
+
+  // the error call only returns once the error was written
+  std::lock_guard<std::mutex> lock{loggedMutex};
+  ASSERT_EQ(shovelerLogGetNumDropped(), numMessages - (capacity - 1));
+  ASSERT_EQ(loggedMessages.rbegin()->message, "error");
+  ASSERT_EQ(loggedMessages.rbegin()->level, SHOVELER_LOG_LEVEL_ERROR);
+}
+
+TEST_F(ShovelerLogTest, asyncFreeRingsOfExitedThreads) {
+  static const int numThreads = 16;
+
+  shovelerLogStartAsync(SHOVELER_LOG_DEFAULT_ASYNC_CAPACITY);
+
+  for (int i = 0; i < numThreads; i++) {
+    std::thread thread{[i]() { shovelerLogInfo("thread %d", i); }};
+    thread.join();
+  }
+  shovelerLogFlush();
+
+  {
+    std::lock_guard<std::mutex> lock{loggedMutex};
+    ASSERT_EQ(loggedMessages.size(), numThreads) << "messages of exited threads should be written";
+  }
+  ASSERT_EQ(shovelerLogGetNumThreadRings(), 0);
+}
+
+TEST_F(ShovelerLogTest, terminateWhileLogging) {
+  static const int numThreads = 4;
+  static const int numMessagesPerThread = 1000;
+
+  shovelerLogStartAsync(SHOVELER_LOG_DEFAULT_ASYNC_CAPACITY);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numThreads; i++) {
+    threads.emplace_back([i]() {
+      for (int j = 0; j < numMessagesPerThread; j++) {
+        shovelerLogInfo("thread %d message %d", i, j);
+        if (j % 100 == 0) {
+          shovelerLogFlush();
+        }
+      }
+    });
+  }
+  // messages pushed concurrently must neither touch freed state nor get lost
+  shovelerLogTerminate();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  std::lock_guard<std::mutex> lock{loggedMutex};
+  ASSERT_EQ(loggedMessages.size(), numThreads * numMessagesPerThread);
+  ASSERT_EQ(shovelerLogGetNumDropped(), 0);
+}
+
+static void logMessage(const char* file, int line, ShovelerLogLevel level, const char* message) {
+  std::unique_lock<std::mutex> lock{loggedMutex};
+  loggedMessages.push_back(LoggedMessage{line, level, message});
+  loggedCondition.notify_all();
+  loggedCondition.wait(lock, []() { return !blockCallback; });
+}
@@ -4,8 +4,38 @@
 #include <stdlib.h> // malloc, free
 #include <string.h> // memcpy, strcmp, strdup
 
+#include "shoveler/executor.h"
 #include "shoveler/log.h"
 
+#define FREE_POLL_INTERVAL_US 1000
+
+static ShovelerResource* createResource(
+    ShovelerResources* resources,
+    ShovelerResourcesTypeLoader* typeLoader,
+    const char* resourceId,
+    int priority);
+static void prioritize(ShovelerResources* resources, ShovelerResource* resource, int priority);
+static void queueRequest(ShovelerResources* resources, ShovelerResource* resource);
+static void queueLoad(ShovelerResources* resources, ShovelerResourcesLoad* load);
+static void dispatchRequests(ShovelerResources* resources);
+static void dispatchLoads(ShovelerResources* resources);
+static ShovelerResourcesLoad* createLoad(
+    ShovelerResources* resources,
+    ShovelerResourcesTypeLoader* typeLoader,
+    ShovelerResource* resource,
+    const unsigned char* buffer,
+    int bufferSize);
+static void runLoad(ShovelerExecutorJob* job, void* loadPointer);
+static void completeLoad(ShovelerExecutorJob* job, bool cancelled, void* loadPointer);
+static void freeLoad(ShovelerResourcesLoad* load);
+static bool swapResourceData(
+    ShovelerResourcesTypeLoader* typeLoader,
+    ShovelerResource* resource,
+    void* data,
+    int bufferSize);
+static ShovelerResourcesTypeLoader* getTypeLoader(ShovelerResource* resource);
+static void enforceMemoryBudget(
+    ShovelerResources* resources, ShovelerResourcesTypeLoader* typeLoader);
 static void freeTypeLoader(void* typeLoaderPointer);
 static void freeResource(void* resourcePointer);
 static void freeResourceData(ShovelerResourcesTypeLoader* typeLoader, ShovelerResource* resource);
@@ -15,12 +45,32 @@ ShovelerResources* shovelerResourcesCreate(
   ShovelerResources* resources = malloc(sizeof(ShovelerResources));
   resources->request = request;
   resources->requestUserData = userData;
+  resources->executor = NULL;
+  resources->maxInFlightRequests = 0;
+  resources->maxInFlightLoads = 0;
+  resources->numInFlightRequests = 0;
+  resources->numInFlightLoads = 0;
   resources->typeLoaders = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, freeTypeLoader);
   resources->resources = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, freeResource);
+  resources->queuedRequests = g_queue_new();
+  resources->queuedLoads = g_queue_new();
 
   return resources;
 }
 
+void shovelerResourcesSetExecutor(ShovelerResources* resources, ShovelerExecutor* executor) {
+  resources->executor = executor;
+}
+
+void shovelerResourcesSetInFlightLimits(
+    ShovelerResources* resources, int maxInFlightRequests, int maxInFlightLoads) {
+  resources->maxInFlightRequests = maxInFlightRequests;
+  resources->maxInFlightLoads = maxInFlightLoads;
+
+  dispatchLoads(resources);
+  dispatchRequests(resources);
+}
+
 bool shovelerResourcesRegisterTypeLoader(
     ShovelerResources* resources, ShovelerResourcesTypeLoader typeLoader) {
   if (g_hash_table_lookup(resources->typeLoaders, typeLoader.typeId) != NULL) {
@@ -33,11 +83,59 @@ bool shovelerResourcesRegisterTypeLoader(
 
   ShovelerResourcesTypeLoader* typeLoaderCopy = malloc(sizeof(ShovelerResourcesTypeLoader));
   memcpy(typeLoaderCopy, &typeLoader, sizeof(ShovelerResourcesTypeLoader));
+  typeLoaderCopy->stats.numHits = 0;
+  typeLoaderCopy->stats.numMisses = 0;
+  typeLoaderCopy->stats.numEvictions = 0;
+  typeLoaderCopy->stats.residentBytes = 0;
+  typeLoaderCopy->unreferencedResources = g_queue_new();
   return g_hash_table_insert(resources->typeLoaders, (void*) typeLoader.typeId, typeLoaderCopy);
 }
 
-ShovelerResource* shovelerResourcesGet(
-    ShovelerResources* resources, const char* typeId, const char* resourceId) {
+bool shovelerResourcesSetMemoryBudget(
+    ShovelerResources* resources, const char* typeId, size_t memoryBudget) {
+  ShovelerResourcesTypeLoader* typeLoader =
+      (ShovelerResourcesTypeLoader*) g_hash_table_lookup(resources->typeLoaders, typeId);
+  if (typeLoader == NULL) {
+    shovelerLogError("Failed to set memory budget of unknown resource type '%s'.", typeId);
+    return false;
+  }
+
+  typeLoader->memoryBudget = memoryBudget;
+  enforceMemoryBudget(resources, typeLoader);
+  return true;
+}
+
+const ShovelerResourcesStats* shovelerResourcesGetStats(
+    ShovelerResources* resources, const char* typeId) {
+  ShovelerResourcesTypeLoader* typeLoader =
+      (ShovelerResourcesTypeLoader*) g_hash_table_lookup(resources->typeLoaders, typeId);
+  if (typeLoader == NULL) {
+    return NULL;
+  }
+
+  return &typeLoader->stats;
+}
+
+void shovelerResourcesLogStats(ShovelerResources* resources) {
+  GHashTableIter iter;
+  ShovelerResourcesTypeLoader* typeLoader;
+  g_hash_table_iter_init(&iter, resources->typeLoaders);
+  while (g_hash_table_iter_next(&iter, NULL, (gpointer*) &typeLoader)) {
+    const ShovelerResourcesStats* stats = &typeLoader->stats;
+    shovelerLogInfo(
+        "Resources of type '%s' had %lld hits, %lld misses and %lld evictions, with %zu bytes "
+        "resident of a %zu byte budget.",
+        typeLoader->typeId,
+        (long long) stats->numHits,
+        (long long) stats->numMisses,
+        (long long) stats->numEvictions,
+        stats->residentBytes,
+        typeLoader->memoryBudget);
+  }
+}
+
+ShovelerResource* shovelerResourcesGetWithPriority(
+    ShovelerResources* resources, const char* typeId, const char* resourceId, int priority) {
   ShovelerResourcesTypeLoader* typeLoader =
       (ShovelerResourcesTypeLoader*) g_hash_table_lookup(resources->typeLoaders, typeId);
   if (typeLoader == NULL) {
@@ -49,30 +147,36 @@ ShovelerResource* shovelerResourcesGet(
       (ShovelerResource*) g_hash_table_lookup(resources->resources, resourceId);
   if (resource == NULL) {
     shovelerLogTrace(
-        "Requested unloaded resource '%s' of type '%s', loading...", resourceId, typeId);
-
-    resource = malloc(sizeof(ShovelerResource));
-    resource->resources = resources;
-    resource->id = strdup(resourceId);
-    resource->typeId = typeId;
-    resource->data = typeLoader->defaultResourceData;
-
-    g_hash_table_insert(resources->resources, resource->id, resource);
+        "Requested unloaded resource '%s' of type '%s' with priority %d, queueing request...",
+        resourceId,
+        typeId,
+        priority);
 
-    if (resources->request != NULL) {
-      resources->request(resources, typeId, resourceId, resources->requestUserData);
-    }
+    typeLoader->stats.numMisses++;
+    resource = createResource(resources, typeLoader, resourceId, priority);
+    resource->state = SHOVELER_RESOURCE_STATE_REQUEST_QUEUED;
+    resource->referenceCount = 1;
+    queueRequest(resources, resource);
+    dispatchRequests(resources);
+    return resource;
   }
 
   if (strcmp(resource->typeId, typeId) != 0) {
     shovelerLogError(
-        "Requested resource '%s' of type '%s' but it is already loaded as type '%d'.",
+        "Requested resource '%s' of type '%s' but it is already loaded as type '%s'.",
         resourceId,
         typeId,
         resource->typeId);
     return NULL;
   }
 
+  typeLoader->stats.numHits++;
+  shovelerResourceAcquire(resource);
+
+  if (priority > resource->priority) {
+    prioritize(resources, resource, priority);
+  }
+
   return resource;
 }
 
@@ -102,35 +206,64 @@ bool shovelerResourcesSet(
         typeId,
         bufferSize);
 
-    resource = malloc(sizeof(ShovelerResource));
-    resource->resources = resources;
-    resource->id = strdup(resourceId);
-    resource->typeId = typeLoader->typeId;
-    resource->data = typeLoader->defaultResourceData;
-
-    g_hash_table_insert(resources->resources, resource->id, resource);
+    // nobody acquired the resource yet, so it starts out as unreferenced
+    resource =
+        createResource(resources, typeLoader, resourceId, SHOVELER_RESOURCES_DEFAULT_PRIORITY);
+    g_queue_push_tail(typeLoader->unreferencedResources, resource);
+    resource->unreferencedLink = typeLoader->unreferencedResources->tail;
+  } else if (strcmp(resource->typeId, typeId) != 0) {
+    shovelerLogError(
+        "Failed to load resource '%s' of type '%s' because it is already loaded as type '%s'.",
+        resourceId,
+        typeId,
+        resource->typeId);
+    return false;
   } else {
     shovelerLogTrace(
         "Loading previously requested resource '%s' of type '%s' (%d bytes).",
         resourceId,
         typeId,
         bufferSize);
+
+    if (resource->state == SHOVELER_RESOURCE_STATE_REQUEST_QUEUED) {
+      g_queue_remove(resources->queuedRequests, resource);
+    } else if (resource->state == SHOVELER_RESOURCE_STATE_REQUESTED) {
+      resources->numInFlightRequests--;
+    }
   }
 
-  freeResourceData(typeLoader, resource);
+  if (resources->executor == NULL) {
+    void* data = typeLoader->load(typeLoader, buffer, bufferSize);
+    bool loaded = swapResourceData(typeLoader, resource, data, bufferSize);
+    enforceMemoryBudget(resources, typeLoader);
+    dispatchRequests(resources);
+    return loaded;
+  }
 
-  resource->data = typeLoader->load(typeLoader, buffer, bufferSize);
-  if (resource->data == NULL) {
-    shovelerLogWarning(
-        "Failed to load resource '%s' of type '%s' (%d bytes), reverting to default resource data.",
-        resourceId,
-        typeId,
-        bufferSize);
-    resource->data = typeLoader->defaultResourceData;
-    return false;
+  if (resource->load != NULL && resource->load->job == NULL) {
+    // The previous contents are still queued, so they are simply replaced by the new ones.
+    shovelerLogTrace(
+        "Replacing queued contents of resource '%s' of type '%s'.", resourceId, typeId);
+    free(resource->load->buffer);
+    resource->load->buffer = malloc(bufferSize * sizeof(unsigned char));
+    memcpy(resource->load->buffer, buffer, bufferSize * sizeof(unsigned char));
+    resource->load->bufferSize = bufferSize;
+  } else {
+    if (resource->load != NULL) {
+      // The previous contents are already decoding, their result is discarded once they finish.
+      shovelerLogTrace(
+          "Superseding running load of resource '%s' of type '%s'.", resourceId, typeId);
+      resource->load->resource = NULL;
+      shovelerExecutorCancelJob(resource->load->job);
+    }
+
+    resource->load = createLoad(resources, typeLoader, resource, buffer, bufferSize);
+    resource->state = SHOVELER_RESOURCE_STATE_LOAD_QUEUED;
+    queueLoad(resources, resource->load);
   }
 
-  shovelerLogTrace("Loaded resource '%s' of type '%s'.", resourceId, typeId);
+  dispatchLoads(resources);
+  dispatchRequests(resources);
   return true;
 }
 
@@ -139,11 +272,285 @@ void shovelerResourcesFree(ShovelerResources* resources) {
     return;
   }
 
+  ShovelerResourcesLoad* queuedLoad;
+  while ((queuedLoad = g_queue_pop_head(resources->queuedLoads)) != NULL) {
+    freeLoad(queuedLoad);
+  }
+
+  // Running loads are detached from their resources and waited for, so that their decoded data can
+  // still be freed by their type loader.
+  GHashTableIter iter;
+  ShovelerResource* resource;
+  g_hash_table_iter_init(&iter, resources->resources);
+  while (g_hash_table_iter_next(&iter, NULL, (gpointer*) &resource)) {
+    if (resource->load != NULL) {
+      resource->load->resource = NULL;
+      shovelerExecutorCancelJob(resource->load->job);
+      resource->load = NULL;
+    }
+  }
+
+  while (resources->numInFlightLoads > 0) {
+    shovelerExecutorUpdateNow(resources->executor);
+    if (resources->numInFlightLoads > 0) {
+      g_usleep(FREE_POLL_INTERVAL_US);
+    }
+  }
+
+  g_queue_free(resources->queuedLoads);
+  g_queue_free(resources->queuedRequests);
   g_hash_table_destroy(resources->resources);
   g_hash_table_destroy(resources->typeLoaders);
   free(resources);
 }
 
+void shovelerResourceAcquire(ShovelerResource* resource) {
+  if (resource->unreferencedLink != NULL) {
+    ShovelerResourcesTypeLoader* typeLoader = getTypeLoader(resource);
+    g_queue_delete_link(typeLoader->unreferencedResources, resource->unreferencedLink);
+    resource->unreferencedLink = NULL;
+  }
+
+  resource->referenceCount++;
+}
+
+void shovelerResourceRelease(ShovelerResource* resource) {
+  assert(resource->referenceCount > 0);
+
+  resource->referenceCount--;
+  if (resource->referenceCount > 0) {
+    return;
+  }
+
+  ShovelerResourcesTypeLoader* typeLoader = getTypeLoader(resource);
+  g_queue_push_tail(typeLoader->unreferencedResources, resource);
+  resource->unreferencedLink = typeLoader->unreferencedResources->tail;
+  enforceMemoryBudget(resource->resources, typeLoader);
+}
+
+ShovelerResourceCallback* shovelerResourceAddCallback(
+    ShovelerResource* resource, ShovelerResourceCallbackFunction* function, void* userData) {
+  ShovelerResourceCallback* callback = malloc(sizeof(ShovelerResourceCallback));
+  callback->function = function;
+  callback->userData = userData;
+
+  g_hash_table_add(resource->callbacks, callback);
+  return callback;
+}
+
+bool shovelerResourceRemoveCallback(
+    ShovelerResource* resource, ShovelerResourceCallback* callback) {
+  return g_hash_table_remove(resource->callbacks, callback);
+}
+
+static ShovelerResource* createResource(
+    ShovelerResources* resources,
+    ShovelerResourcesTypeLoader* typeLoader,
+    const char* resourceId,
+    int priority) {
+  ShovelerResource* resource = malloc(sizeof(ShovelerResource));
+  resource->resources = resources;
+  resource->id = strdup(resourceId);
+  resource->typeId = typeLoader->typeId;
+  resource->data = typeLoader->defaultResourceData;
+  resource->state = SHOVELER_RESOURCE_STATE_LOADED;
+  resource->priority = priority;
+  resource->callbacks = g_hash_table_new_full(g_direct_hash, g_direct_equal, free, NULL);
+  resource->referenceCount = 0;
+  resource->size = 0;
+  resource->unreferencedLink = NULL;
+  resource->load = NULL;
+
+  g_hash_table_insert(resources->resources, resource->id, resource);
+  return resource;
+}
+
+/** Raises the priority of a resource, moving its queued request or load up its queue. */
+static void prioritize(ShovelerResources* resources, ShovelerResource* resource, int priority) {
+  resource->priority = priority;
+
+  if (resource->state == SHOVELER_RESOURCE_STATE_REQUEST_QUEUED) {
+    g_queue_remove(resources->queuedRequests, resource);
+    queueRequest(resources, resource);
+  } else if (resource->state == SHOVELER_RESOURCE_STATE_LOAD_QUEUED) {
+    g_queue_remove(resources->queuedLoads, resource->load);
+    queueLoad(resources, resource->load);
+  }
+}
+
+/** Inserts after the last request of at least the same priority, keeping equal priorities FIFO. */
+static void queueRequest(ShovelerResources* resources, ShovelerResource* resource) {
+  GList* sibling = resources->queuedRequests->tail;
+  while (sibling != NULL && ((ShovelerResource*) sibling->data)->priority < resource->priority) {
+    sibling = sibling->prev;
+  }
+
+  g_queue_insert_after(resources->queuedRequests, sibling, resource);
+}
+
+static void queueLoad(ShovelerResources* resources, ShovelerResourcesLoad* load) {
+  GList* sibling = resources->queuedLoads->tail;
+  while (sibling != NULL &&
+         ((ShovelerResourcesLoad*) sibling->data)->resource->priority < load->resource->priority) {
+    sibling = sibling->prev;
+  }
+
+  g_queue_insert_after(resources->queuedLoads, sibling, load);
+}
+
+static void dispatchRequests(ShovelerResources* resources) {
+  while (!g_queue_is_empty(resources->queuedRequests) &&
+         (resources->maxInFlightRequests <= 0 ||
+          resources->numInFlightRequests < resources->maxInFlightRequests)) {
+    ShovelerResource* resource = g_queue_pop_head(resources->queuedRequests);
+    resource->state = SHOVELER_RESOURCE_STATE_REQUESTED;
+    resources->numInFlightRequests++;
+
+    // the request function is free to deliver the contents right away
+    if (resources->request != NULL) {
+      resources->request(resources, resource->typeId, resource->id, resources->requestUserData);
+    }
+  }
+}
+
+static void dispatchLoads(ShovelerResources* resources) {
+  while (!g_queue_is_empty(resources->queuedLoads) &&
+         (resources->maxInFlightLoads <= 0 ||
+          resources->numInFlightLoads < resources->maxInFlightLoads)) {
+    ShovelerResourcesLoad* load = g_queue_pop_head(resources->queuedLoads);
+    load->resource->state = SHOVELER_RESOURCE_STATE_LOADING;
+    resources->numInFlightLoads++;
+    load->job = shovelerExecutorSubmit(resources->executor, runLoad, completeLoad, load);
+  }
+}
+
+static ShovelerResourcesLoad* createLoad(
+    ShovelerResources* resources,
+    ShovelerResourcesTypeLoader* typeLoader,
+    ShovelerResource* resource,
+    const unsigned char* buffer,
+    int bufferSize) {
+  ShovelerResourcesLoad* load = malloc(sizeof(ShovelerResourcesLoad));
+  load->resources = resources;
+  load->resource = resource;
+  load->typeLoader = typeLoader;
+  load->buffer = malloc(bufferSize * sizeof(unsigned char));
+  memcpy(load->buffer, buffer, bufferSize * sizeof(unsigned char));
+  load->bufferSize = bufferSize;
+  load->data = NULL;
+  load->job = NULL;
+  return load;
+}
+
+static void runLoad(ShovelerExecutorJob* job, void* loadPointer) {
+  ShovelerResourcesLoad* load = loadPointer;
+  load->data = load->typeLoader->load(load->typeLoader, load->buffer, load->bufferSize);
+}
+
+static void completeLoad(ShovelerExecutorJob* job, bool cancelled, void* loadPointer) {
+  ShovelerResourcesLoad* load = loadPointer;
+  ShovelerResources* resources = load->resources;
+  resources->numInFlightLoads--;
+
+  if (load->resource != NULL) {
+    // detach the load first, since the resource might get evicted right after the swap
+    ShovelerResource* resource = load->resource;
+    assert(resource->load == load);
+    resource->load = NULL;
+    load->resource = NULL;
+    swapResourceData(load->typeLoader, resource, load->data, load->bufferSize);
+    enforceMemoryBudget(resources, load->typeLoader);
+  } else if (load->data != NULL && load->typeLoader->freeResourceData != NULL) {
+    load->typeLoader->freeResourceData(load->typeLoader, load->data);
+  }
+
+  freeLoad(load);
+  dispatchLoads(resources);
+}
+
+static void freeLoad(ShovelerResourcesLoad* load) {
+  if (load->resource != NULL) {
+    load->resource->load = NULL;
+  }
+
+  free(load->buffer);
+  free(load);
+}
+
+/** Swaps newly decoded data into the resource, or keeps its previous data if decoding failed. */
+static bool swapResourceData(
+    ShovelerResourcesTypeLoader* typeLoader,
+    ShovelerResource* resource,
+    void* data,
+    int bufferSize) {
+  if (data == NULL) {
+    shovelerLogWarning(
+        "Failed to load resource '%s' of type '%s' (%d bytes), keeping previous resource data.",
+        resource->id,
+        resource->typeId,
+        bufferSize);
+    resource->state = SHOVELER_RESOURCE_STATE_FAILED;
+    return false;
+  }
+
+  freeResourceData(typeLoader, resource);
+  typeLoader->stats.residentBytes -= resource->size;
+  resource->data = data;
+  resource->size =
+      typeLoader->getResourceSize != NULL ? typeLoader->getResourceSize(typeLoader, data) : 0;
+  typeLoader->stats.residentBytes += resource->size;
+  resource->state = SHOVELER_RESOURCE_STATE_LOADED;
+  shovelerLogTrace("Loaded resource '%s' of type '%s'.", resource->id, resource->typeId);
+
+  GHashTableIter iter;
+  ShovelerResourceCallback* callback;
+  g_hash_table_iter_init(&iter, resource->callbacks);
+  while (g_hash_table_iter_next(&iter, (gpointer*) &callback, NULL)) {
+    callback->function(resource, callback->userData);
+  }
+
+  return true;
+}
+
+static ShovelerResourcesTypeLoader* getTypeLoader(ShovelerResource* resource) {
+  ShovelerResourcesTypeLoader* typeLoader = (ShovelerResourcesTypeLoader*) g_hash_table_lookup(
+      resource->resources->typeLoaders, resource->typeId);
+  assert(typeLoader != NULL);
+  return typeLoader;
+}
+
+/**
+ * Evicts the least recently used unreferenced resources of the type until its resident data fits
+ * into its memory budget. Resources with a pending request or load are skipped, since they don't
+ * hold any resident data besides the default.
+ */
+static void enforceMemoryBudget(
+    ShovelerResources* resources, ShovelerResourcesTypeLoader* typeLoader) {
+  if (typeLoader->memoryBudget == 0) {
+    return;
+  }
+
+  GList* link = typeLoader->unreferencedResources->head;
+  while (link != NULL && typeLoader->stats.residentBytes > typeLoader->memoryBudget) {
+    GList* next = link->next;
+
+    ShovelerResource* resource = link->data;
+    if (resource->state == SHOVELER_RESOURCE_STATE_LOADED ||
+        resource->state == SHOVELER_RESOURCE_STATE_FAILED) {
+      shovelerLogTrace(
+          "Evicting resource '%s' of type '%s' (%zu bytes).",
+          resource->id,
+          resource->typeId,
+          resource->size);
+      typeLoader->stats.numEvictions++;
+      g_queue_delete_link(typeLoader->unreferencedResources, link);
+      g_hash_table_remove(resources->resources, resource->id);
+    }
+
+    link = next;
+  }
+}
+
 static void freeTypeLoader(void* typeLoaderPointer) {
   ShovelerResourcesTypeLoader* typeLoader = (ShovelerResourcesTypeLoader*) typeLoaderPointer;
 
@@ -155,17 +562,17 @@ static void freeTypeLoader(void* typeLoaderPointer) {
     typeLoader->free(typeLoader);
   }
 
+  g_queue_free(typeLoader->unreferencedResources);
   free(typeLoader);
 }
 
 static void freeResource(void* resourcePointer) {
   ShovelerResource* resource = (ShovelerResource*) resourcePointer;
 
-  ShovelerResourcesTypeLoader* typeLoader = (ShovelerResourcesTypeLoader*) g_hash_table_lookup(
-      resource->resources->typeLoaders, resource->typeId);
-  assert(typeLoader != NULL);
-
+  ShovelerResourcesTypeLoader* typeLoader = getTypeLoader(resource);
   freeResourceData(typeLoader, resource);
+  typeLoader->stats.residentBytes -= resource->size;
+  g_hash_table_destroy(resource->callbacks);
   free(resource->id);
   free(resource);
 }
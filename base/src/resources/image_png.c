@@ -5,6 +5,7 @@
 
 static void* loadPng(
     ShovelerResourcesTypeLoader* typeLoader, const unsigned char* buffer, int bufferSize);
+static size_t getPngSize(ShovelerResourcesTypeLoader* typeLoader, void* resourceData);
 static void freePng(ShovelerResourcesTypeLoader* typeLoader, void* resourceData);
 static void freeTypeLoader(ShovelerResourcesTypeLoader* typeLoader);
 static ShovelerImage* createDefaultImage();
@@ -15,8 +16,10 @@ bool shovelerResourcesImagePngRegister(ShovelerResources* resources) {
   imagePngTypeLoader.defaultResourceData = createDefaultImage();
   imagePngTypeLoader.data = NULL;
   imagePngTypeLoader.load = loadPng;
+  imagePngTypeLoader.getResourceSize = getPngSize;
   imagePngTypeLoader.freeResourceData = freePng;
   imagePngTypeLoader.free = freeTypeLoader;
+  imagePngTypeLoader.memoryBudget = 0;
   return shovelerResourcesRegisterTypeLoader(resources, imagePngTypeLoader);
 }
 
@@ -25,6 +28,12 @@ static void* loadPng(
   return shovelerImagePngReadBuffer(buffer, bufferSize);
 }
 
+static size_t getPngSize(ShovelerResourcesTypeLoader* typeLoader, void* resourceData) {
+  ShovelerImage* pngImage = (ShovelerImage*) resourceData;
+  return sizeof(ShovelerImage) +
+      (size_t) pngImage->width * pngImage->height * pngImage->channels * sizeof(unsigned char);
+}
+
 static void freePng(ShovelerResourcesTypeLoader* typeLoader, void* resourceData) {
   ShovelerImage* pngImage = (ShovelerImage*) resourceData;
   shovelerImageFree(pngImage);
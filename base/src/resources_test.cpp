@@ -1,8 +1,11 @@
 #include <gtest/gtest.h>
 
+#include <cstring>
 #include <string>
+#include <vector>
 
 extern "C" {
+#include "shoveler/executor.h"
 #include "shoveler/resources.h"
 }
 
@@ -10,8 +13,10 @@ static void requestResources(
     ShovelerResources* resources, const char* typeId, const char* resourceId, void* testPointer);
 static void* loadResource(
     ShovelerResourcesTypeLoader* typeLoader, const unsigned char* buffer, int bufferSize);
+static size_t getResourceSize(ShovelerResourcesTypeLoader* typeLoader, void* resourceData);
 static void freeResourceData(ShovelerResourcesTypeLoader* typeLoader, void* resourceData);
 static void freeTypeLoader(ShovelerResourcesTypeLoader* typeLoader);
+static void countLoaded(ShovelerResource* resource, void* numLoadedPointer);
 
 class ShovelerResourcesTest : public ::testing::Test {
 public:
@@ -25,14 +30,17 @@ public:
     testTypeLoader.defaultResourceData = (void*) testDefaultResourceData;
     testTypeLoader.data = this;
     testTypeLoader.load = loadResource;
+    testTypeLoader.getResourceSize = getResourceSize;
     testTypeLoader.freeResourceData = freeResourceData;
     testTypeLoader.free = freeTypeLoader;
+    testTypeLoader.memoryBudget = 0;
     bool typeLoaderRegistered = shovelerResourcesRegisterTypeLoader(resources, testTypeLoader);
     ASSERT_TRUE(typeLoaderRegistered) << "test type loader should register correctly";
 
     lastRequestResources = NULL;
     lastRequestTypeId = NULL;
     lastRequestResourceId = NULL;
+    requestedResourceIds.clear();
 
     lastLoadBuffer = NULL;
     lastLoadBufferSize = 0;
@@ -59,6 +67,7 @@ public:
   ShovelerResources* lastRequestResources;
   const char* lastRequestTypeId;
   const char* lastRequestResourceId;
+  std::vector<std::string> requestedResourceIds;
 
   const unsigned char* lastLoadBuffer;
   int lastLoadBufferSize;
@@ -75,7 +84,7 @@ TEST_F(ShovelerResourcesTest, requestUnloaded) {
   ShovelerResource* resource = shovelerResourcesGet(resources, testTypeId, testResourceId);
   ASSERT_EQ(lastRequestResources, resources) << "request should be called with correct resources";
   ASSERT_EQ(lastRequestTypeId, testTypeId) << "request should be called with correct type id";
-  ASSERT_EQ(lastRequestResourceId, testResourceId)
+  ASSERT_STREQ(lastRequestResourceId, testResourceId)
       << "request should be called with correct resource id";
 
   ASSERT_EQ(resource->resources, resources) << "returned resource should have correct resources";
@@ -197,12 +206,188 @@ TEST_F(ShovelerResourcesTest, loadAndRequest) {
       << "resource data should be set to correct loaded data";
 }
 
+TEST_F(ShovelerResourcesTest, requestPriorityAndLimit) {
+  shovelerResourcesSetInFlightLimits(
+      resources, /* maxInFlightRequests */ 1, /* maxInFlightLoads */ 0);
+  unsigned char testResourceBuffer = 42;
+
+  shovelerResourcesGet(resources, testTypeId, "first");
+  shovelerResourcesGet(resources, testTypeId, "second");
+  shovelerResourcesGetWithPriority(resources, testTypeId, "third", /* priority */ 5);
+  shovelerResourcesGet(resources, testTypeId, "first");
+  ASSERT_EQ(requestedResourceIds, std::vector<std::string>{"first"})
+      << "only one request should be in flight and requests should be deduplicated";
+
+  shovelerResourcesSet(resources, testTypeId, "first", &testResourceBuffer, 1);
+  ASSERT_EQ(requestedResourceIds, (std::vector<std::string>{"first", "third"}))
+      << "higher priority request should be dispatched next";
+
+  shovelerResourcesGetWithPriority(resources, testTypeId, "fourth", /* priority */ 1);
+  shovelerResourcesGetWithPriority(resources, testTypeId, "second", /* priority */ 2);
+  shovelerResourcesSet(resources, testTypeId, "third", &testResourceBuffer, 1);
+  shovelerResourcesSet(resources, testTypeId, "second", &testResourceBuffer, 1);
+  ASSERT_EQ(
+      requestedResourceIds, (std::vector<std::string>{"first", "third", "second", "fourth"}))
+      << "raising the priority of a queued request should move it up the queue";
+}
+
+TEST_F(ShovelerResourcesTest, asyncLoad) {
+  ShovelerExecutor* executor = shovelerExecutorCreateDirect();
+  shovelerResourcesSetExecutor(resources, executor);
+  const char* testResourceId = "test resource id";
+  unsigned char testResourceBuffer = 42;
+  const char* testResourceData = "test resource data";
+
+  ShovelerResource* resource = shovelerResourcesGet(resources, testTypeId, testResourceId);
+  int numLoaded = 0;
+  shovelerResourceAddCallback(resource, countLoaded, &numLoaded);
+
+  nextLoadResourceData = (void*) testResourceData;
+  bool queued = shovelerResourcesSet(resources, testTypeId, testResourceId, &testResourceBuffer, 1);
+  ASSERT_TRUE(queued) << "load should have been queued";
+  ASSERT_EQ(resource->state, SHOVELER_RESOURCE_STATE_LOADING);
+  ASSERT_EQ(resource->data, testDefaultResourceData) << "data should only be swapped on update";
+  ASSERT_EQ(numLoaded, 0);
+
+  shovelerExecutorUpdateNow(executor);
+  ASSERT_EQ(resource->state, SHOVELER_RESOURCE_STATE_LOADED);
+  ASSERT_EQ(resource->data, testResourceData) << "data should be swapped in after update";
+  ASSERT_EQ(lastLoadBufferSize, 1);
+  ASSERT_EQ(numLoaded, 1) << "callback should be called after data was swapped in";
+
+  shovelerResourcesFree(resources);
+  resources = NULL;
+  shovelerExecutorFree(executor);
+}
+
+TEST_F(ShovelerResourcesTest, asyncLoadSuperseded) {
+  ShovelerExecutor* executor = shovelerExecutorCreateDirect();
+  shovelerResourcesSetExecutor(resources, executor);
+  shovelerResourcesSetInFlightLimits(
+      resources, /* maxInFlightRequests */ 0, /* maxInFlightLoads */ 1);
+  const unsigned char firstBuffer[] = {1};
+  const unsigned char secondBuffer[] = {1, 2};
+  const unsigned char thirdBuffer[] = {1, 2, 3};
+  const unsigned char otherBuffer[] = {1, 2, 3, 4};
+  const char* testResourceData = "test resource data";
+
+  ShovelerResource* resource = shovelerResourcesGet(resources, testTypeId, "superseded");
+  ShovelerResource* otherResource = shovelerResourcesGet(resources, testTypeId, "other");
+  shovelerResourcesSet(resources, testTypeId, "superseded", firstBuffer, sizeof(firstBuffer));
+  shovelerResourcesSet(resources, testTypeId, "other", otherBuffer, sizeof(otherBuffer));
+  ASSERT_EQ(resource->state, SHOVELER_RESOURCE_STATE_LOADING);
+  ASSERT_EQ(otherResource->state, SHOVELER_RESOURCE_STATE_LOAD_QUEUED)
+      << "second load should wait for an in-flight slot";
+
+  // supersedes the running load of the first resource and queues behind the other resource
+  shovelerResourcesSet(resources, testTypeId, "superseded", secondBuffer, sizeof(secondBuffer));
+  shovelerResourcesSet(resources, testTypeId, "superseded", thirdBuffer, sizeof(thirdBuffer));
+  ASSERT_EQ(resource->state, SHOVELER_RESOURCE_STATE_LOAD_QUEUED);
+
+  nextLoadResourceData = (void*) testResourceData;
+  shovelerExecutorUpdateNow(executor);
+  ASSERT_TRUE(lastLoadBuffer == NULL) << "superseded load should not be decoded";
+  ASSERT_EQ(otherResource->state, SHOVELER_RESOURCE_STATE_LOADING)
+      << "queued load should start once the superseded one completed";
+
+  shovelerExecutorUpdateNow(executor);
+  ASSERT_EQ(lastLoadBufferSize, sizeof(otherBuffer));
+  ASSERT_EQ(otherResource->data, testResourceData);
+
+  shovelerExecutorUpdateNow(executor);
+  ASSERT_EQ(lastLoadBufferSize, sizeof(thirdBuffer))
+      << "queued contents should be replaced by newer ones";
+  ASSERT_EQ(resource->state, SHOVELER_RESOURCE_STATE_LOADED);
+  ASSERT_EQ(resources->numInFlightLoads, 0);
+
+  shovelerResourcesFree(resources);
+  resources = NULL;
+  shovelerExecutorFree(executor);
+}
+
+TEST_F(ShovelerResourcesTest, hitsAndMisses) {
+  const char* testResourceId = "test resource id";
+
+  ShovelerResource* resource = shovelerResourcesGet(resources, testTypeId, testResourceId);
+  ShovelerResource* sameResource = shovelerResourcesGet(resources, testTypeId, testResourceId);
+  ASSERT_EQ(sameResource, resource) << "second get should return the same resource";
+  ASSERT_EQ(resource->referenceCount, 2) << "each get should acquire a reference";
+
+  const ShovelerResourcesStats* stats = shovelerResourcesGetStats(resources, testTypeId);
+  ASSERT_TRUE(stats != NULL);
+  ASSERT_EQ(stats->numMisses, 1) << "first get should be a miss";
+  ASSERT_EQ(stats->numHits, 1) << "second get should be a hit";
+  ASSERT_TRUE(shovelerResourcesGetStats(resources, "foo/bar") == NULL);
+}
+
+TEST_F(ShovelerResourcesTest, evictLeastRecentlyUsed) {
+  unsigned char testResourceBuffer = 42;
+  const char* firstData = "1111";
+  const char* secondData = "2222";
+  const char* thirdData = "3333";
+
+  bool budgetSet = shovelerResourcesSetMemoryBudget(resources, testTypeId, 10);
+  ASSERT_TRUE(budgetSet);
+
+  nextLoadResourceData = (void*) firstData;
+  shovelerResourcesSet(resources, testTypeId, "first", &testResourceBuffer, 1);
+  nextLoadResourceData = (void*) secondData;
+  shovelerResourcesSet(resources, testTypeId, "second", &testResourceBuffer, 1);
+  const ShovelerResourcesStats* stats = shovelerResourcesGetStats(resources, testTypeId);
+  ASSERT_EQ(stats->residentBytes, 8);
+  ASSERT_EQ(stats->numEvictions, 0) << "resources within budget shouldn't be evicted";
+
+  // using the first resource makes the second one the least recently used
+  ShovelerResource* first = shovelerResourcesGet(resources, testTypeId, "first");
+  shovelerResourceRelease(first);
+
+  nextLoadResourceData = (void*) thirdData;
+  shovelerResourcesSet(resources, testTypeId, "third", &testResourceBuffer, 1);
+  ASSERT_EQ(stats->numEvictions, 1);
+  ASSERT_EQ(stats->residentBytes, 8);
+  ASSERT_FALSE(g_hash_table_contains(resources->resources, "second"))
+      << "least recently used resource should be evicted";
+  ASSERT_TRUE(g_hash_table_contains(resources->resources, "first"));
+  ASSERT_TRUE(g_hash_table_contains(resources->resources, "third"));
+  ASSERT_EQ(*freeResourceDataArguments.rbegin(), secondData)
+      << "evicted resource's data should be freed";
+}
+
+TEST_F(ShovelerResourcesTest, keepReferenced) {
+  unsigned char testResourceBuffer = 42;
+  const char* referencedData = "referenced";
+  const char* unreferencedData = "unreferenced";
+
+  ShovelerResource* referenced = shovelerResourcesGet(resources, testTypeId, "referenced");
+  nextLoadResourceData = (void*) referencedData;
+  shovelerResourcesSet(resources, testTypeId, "referenced", &testResourceBuffer, 1);
+  shovelerResourcesSetMemoryBudget(resources, testTypeId, 1);
+  const ShovelerResourcesStats* stats = shovelerResourcesGetStats(resources, testTypeId);
+  ASSERT_EQ(stats->numEvictions, 0) << "referenced resource shouldn't be evicted";
+
+  nextLoadResourceData = (void*) unreferencedData;
+  shovelerResourcesSet(resources, testTypeId, "unreferenced", &testResourceBuffer, 1);
+  ASSERT_EQ(stats->numEvictions, 1) << "unreferenced resource should be evicted right away";
+  ASSERT_FALSE(g_hash_table_contains(resources->resources, "unreferenced"));
+  ASSERT_EQ(referenced->data, referencedData);
+
+  shovelerResourceAcquire(referenced);
+  shovelerResourceRelease(referenced);
+  ASSERT_EQ(stats->numEvictions, 1) << "resource with remaining reference shouldn't be evicted";
+
+  shovelerResourceRelease(referenced);
+  ASSERT_EQ(stats->numEvictions, 2) << "resource should be evicted once released";
+  ASSERT_EQ(stats->residentBytes, 0);
+  ASSERT_FALSE(g_hash_table_contains(resources->resources, "referenced"));
+}
+
 static void requestResources(
     ShovelerResources* resources, const char* typeId, const char* resourceId, void* testPointer) {
   ShovelerResourcesTest* test = (ShovelerResourcesTest*) testPointer;
   test->lastRequestResources = resources;
   test->lastRequestTypeId = typeId;
   test->lastRequestResourceId = resourceId;
+  test->requestedResourceIds.push_back(resourceId);
 }
 
 static void* loadResource(
@@ -214,6 +399,10 @@ static void* loadResource(
   return test->nextLoadResourceData;
 }
 
+static size_t getResourceSize(ShovelerResourcesTypeLoader* typeLoader, void* resourceData) {
+  return strlen((const char*) resourceData);
+}
+
 static void freeResourceData(ShovelerResourcesTypeLoader* typeLoader, void* resourceData) {
   ShovelerResourcesTest* test = (ShovelerResourcesTest*) typeLoader->data;
   test->freeResourceDataArguments.push_back(resourceData);
@@ -223,3 +412,8 @@ static void freeTypeLoader(ShovelerResourcesTypeLoader* typeLoader) {
   ShovelerResourcesTest* test = (ShovelerResourcesTest*) typeLoader->data;
   test->freeTypeLoaderCalled = true;
 }
+
+static void countLoaded(ShovelerResource* resource, void* numLoadedPointer) {
+  int* numLoaded = (int*) numLoadedPointer;
+  (*numLoaded)++;
+}
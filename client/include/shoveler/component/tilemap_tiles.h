@@ -1,7 +1,6 @@
 #ifndef SHOVELER_COMPONENT_TILEMAP_TILES_H
 #define SHOVELER_COMPONENT_TILEMAP_TILES_H
 
-#include <assert.h>
 #include <shoveler/component.h>
 #include <shoveler/component_type.h>
 #include <shoveler/schema/opengl.h>
@@ -11,9 +10,21 @@ typedef struct ShovelerTextureStruct ShovelerTexture;
 
 void shovelerClientSystemAddTilemapTilesSystem(ShovelerClientSystem* clientSystem);
 
-static inline ShovelerTexture* shovelerComponentGetTilemapTiles(ShovelerComponent* component) {
-  assert(component->type->id == shovelerComponentTypeIdTilemapTiles);
-  return component->systemData;
-}
+ShovelerTexture* shovelerComponentGetTilemapTiles(ShovelerComponent* component);
+/**
+ * Writes the tiles of a region of a tilemap defined by configuration options, where each of the
+ * given planes holds width times height tiles row by row. The tiles are written into the existing
+ * field values, and if the component is active, only the written region of its texture is repacked
+ * and uploaded.
+ */
+void shovelerComponentUpdateTilemapTilesRegion(
+    ShovelerComponent* component,
+    unsigned int x,
+    unsigned int y,
+    unsigned int width,
+    unsigned int height,
+    const unsigned char* tilesetColumns,
+    const unsigned char* tilesetRows,
+    const unsigned char* tilesetIds);
 
 #endif
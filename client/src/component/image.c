@@ -8,6 +8,7 @@
 #include "shoveler/image.h"
 #include "shoveler/image/png.h"
 #include "shoveler/image/ppm.h"
+#include "shoveler/image/raw.h"
 #include "shoveler/log.h"
 #include "shoveler/schema.h"
 #include "shoveler/system.h"
@@ -43,6 +44,8 @@ static void* activateImageComponent(ShovelerComponent* component, void* clientSy
     return shovelerImagePngReadBuffer(bufferData, bufferSize);
   case SHOVELER_COMPONENT_IMAGE_FORMAT_PPM:
     return shovelerImagePpmReadBuffer(bufferData, bufferSize);
+  case SHOVELER_COMPONENT_IMAGE_FORMAT_RAW:
+    return shovelerImageRawReadBuffer(bufferData, bufferSize);
   default:
     shovelerLogWarning(
         "Failed to activate entity %lld component image: Unknown format value %d.",
@@ -97,5 +97,19 @@ static void* activateTextureComponent(ShovelerComponent* component, void* client
 static void deactivateTextureComponent(ShovelerComponent* component, void* clientSystemPointer) {
   ShovelerTexture* texture = (ShovelerTexture*) component->systemData;
 
+  ShovelerComponentTextureType type =
+      shovelerComponentGetFieldValueInt(component, SHOVELER_COMPONENT_TEXTURE_FIELD_ID_TYPE);
+  if (type == SHOVELER_COMPONENT_TEXTURE_TYPE_TEXT) {
+    // text textures are shared by the renderer, which is still active while its dependents are
+    // deactivated
+    ShovelerComponent* textTextureRendererComponent = shovelerComponentGetDependency(
+        component, SHOVELER_COMPONENT_TEXTURE_FIELD_ID_TEXT_TEXTURE_RENDERER);
+    assert(textTextureRendererComponent != NULL);
+    ShovelerTextTextureRenderer* textTextureRenderer =
+        shovelerComponentGetTextTextureRenderer(textTextureRendererComponent);
+    shovelerTextTextureRendererRelease(textTextureRenderer, texture);
+    return;
+  }
+
   shovelerTextureFree(texture);
 }
@@ -1,6 +1,8 @@
 #include "shoveler/component/tilemap_tiles.h"
 
 #include <assert.h>
+#include <stdlib.h> // malloc free
+#include <string.h> // memcpy
 
 #include "shoveler/client_system.h"
 #include "shoveler/component/image.h"
@@ -11,6 +13,18 @@
 #include "shoveler/system.h"
 #include "shoveler/texture.h"
 
+typedef struct {
+  ShovelerTexture* texture;
+  /** Bounding rectangle of the tiles written by shovelerComponentUpdateTilemapTilesRegion that
+   * still need to be repacked and uploaded, empty if dirtyWidth is zero. */
+  unsigned int dirtyX;
+  unsigned int dirtyY;
+  unsigned int dirtyWidth;
+  unsigned int dirtyHeight;
+  /** While set, live updates of the tile planes are part of a region write and are deferred. */
+  bool isWritingRegion;
+} TilemapTilesData;
+
 static void* activateTilemapTilesComponent(ShovelerComponent* component, void* clientSystemPointer);
 static void deactivateTilemapTilesComponent(
     ShovelerComponent* component, void* clientSystemPointer);
@@ -21,6 +35,30 @@ static bool liveUpdateTilesField(
     ShovelerComponentFieldValue* fieldValue,
     void* userData);
 static void updateTiles(ShovelerComponent* component, ShovelerTexture* texture);
+static void updateChangedTiles(
+    ShovelerComponent* component, TilemapTilesData* tilemapTiles, int fieldId);
+static void updateDirtyTiles(ShovelerComponent* component, TilemapTilesData* tilemapTiles);
+static void getTilePlanes(
+    ShovelerComponent* component,
+    const unsigned char** outputTilesetColumns,
+    const unsigned char** outputTilesetRows,
+    const unsigned char** outputTilesetIds);
+static bool findChangedRegion(
+    ShovelerImage* image,
+    unsigned int channel,
+    const unsigned char* plane,
+    unsigned int* outputX,
+    unsigned int* outputY,
+    unsigned int* outputWidth,
+    unsigned int* outputHeight);
+static void updateTilePlaneRegion(
+    ShovelerComponent* component,
+    int fieldId,
+    unsigned int x,
+    unsigned int y,
+    unsigned int width,
+    unsigned int height,
+    const unsigned char* regionPlane);
 static bool isComponentImageResourceEntityDefinition(ShovelerComponent* component);
 static bool isComponentConfigurationOptionDefinition(ShovelerComponent* component);
 
@@ -42,6 +80,78 @@ void shovelerClientSystemAddTilemapTilesSystem(ShovelerClientSystem* clientSyste
   componentSystem->callbackUserData = clientSystem;
 }
 
+ShovelerTexture* shovelerComponentGetTilemapTiles(ShovelerComponent* component) {
+  assert(component->type->id == shovelerComponentTypeIdTilemapTiles);
+  TilemapTilesData* tilemapTiles = (TilemapTilesData*) component->systemData;
+  if (tilemapTiles == NULL) {
+    return NULL;
+  }
+
+  return tilemapTiles->texture;
+}
+
+void shovelerComponentUpdateTilemapTilesRegion(
+    ShovelerComponent* component,
+    unsigned int x,
+    unsigned int y,
+    unsigned int width,
+    unsigned int height,
+    const unsigned char* tilesetColumns,
+    const unsigned char* tilesetRows,
+    const unsigned char* tilesetIds) {
+  assert(component->type->id == shovelerComponentTypeIdTilemapTiles);
+  assert(isComponentConfigurationOptionDefinition(component));
+  assert(x + width <=
+         (unsigned int) shovelerComponentGetFieldValueInt(
+             component, SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_NUM_COLUMNS));
+  assert(y + height <=
+         (unsigned int) shovelerComponentGetFieldValueInt(
+             component, SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_NUM_ROWS));
+
+  if (width == 0 || height == 0) {
+    return;
+  }
+
+  TilemapTilesData* tilemapTiles = (TilemapTilesData*) component->systemData;
+  if (tilemapTiles != NULL) {
+    tilemapTiles->dirtyX = x;
+    tilemapTiles->dirtyY = y;
+    tilemapTiles->dirtyWidth = width;
+    tilemapTiles->dirtyHeight = height;
+    tilemapTiles->isWritingRegion = true;
+  }
+
+  updateTilePlaneRegion(
+      component,
+      SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_TILESET_COLUMNS,
+      x,
+      y,
+      width,
+      height,
+      tilesetColumns);
+  updateTilePlaneRegion(
+      component,
+      SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_TILESET_ROWS,
+      x,
+      y,
+      width,
+      height,
+      tilesetRows);
+  updateTilePlaneRegion(
+      component,
+      SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_TILESET_IDS,
+      x,
+      y,
+      width,
+      height,
+      tilesetIds);
+
+  if (tilemapTiles != NULL) {
+    tilemapTiles->isWritingRegion = false;
+    updateDirtyTiles(component, tilemapTiles);
+  }
+}
+
 static void* activateTilemapTilesComponent(
     ShovelerComponent* component, void* clientSystemPointer) {
   bool isImageResourceEntityDefinition = isComponentImageResourceEntityDefinition(component);
@@ -74,28 +184,42 @@ static void* activateTilemapTilesComponent(
     return NULL;
   }
 
-  return texture;
+  TilemapTilesData* tilemapTiles = malloc(sizeof(TilemapTilesData));
+  tilemapTiles->texture = texture;
+  tilemapTiles->dirtyX = 0;
+  tilemapTiles->dirtyY = 0;
+  tilemapTiles->dirtyWidth = 0;
+  tilemapTiles->dirtyHeight = 0;
+  tilemapTiles->isWritingRegion = false;
+
+  return tilemapTiles;
 }
 
 static void deactivateTilemapTilesComponent(
     ShovelerComponent* component, void* clientSystemPointer) {
-  ShovelerTexture* texture = (ShovelerTexture*) component->systemData;
+  TilemapTilesData* tilemapTiles = (TilemapTilesData*) component->systemData;
 
-  shovelerTextureFree(texture);
+  shovelerTextureFree(tilemapTiles->texture);
+  free(tilemapTiles);
 }
 
+/**
+ * Tiles written by shovelerComponentUpdateTilemapTilesRegion only repack and upload their dirty
+ * region once all three planes are written. Any other update of a plane, e.g. from the network,
+ * replaces it as a whole and is diffed against the texture image to find the region to upload.
+ */
 static bool liveUpdateTilesField(
     ShovelerComponent* component,
     int fieldId,
     const ShovelerComponentField* field,
     ShovelerComponentFieldValue* fieldValue,
     void* userData) {
-  ShovelerTexture* texture = (ShovelerTexture*) component->systemData;
-  assert(texture != NULL);
+  TilemapTilesData* tilemapTiles = (TilemapTilesData*) component->systemData;
+  assert(tilemapTiles != NULL);
 
   if (!isComponentImageResourceEntityDefinition(component) &&
-      isComponentConfigurationOptionDefinition(component)) {
-    updateTiles(component, texture);
+      isComponentConfigurationOptionDefinition(component) && !tilemapTiles->isWritingRegion) {
+    updateChangedTiles(component, tilemapTiles, fieldId);
   }
 
   return false; // don't propagate
@@ -105,41 +229,208 @@ static void updateTiles(ShovelerComponent* component, ShovelerTexture* texture)
   const unsigned char* tilesetColumns;
   const unsigned char* tilesetRows;
   const unsigned char* tilesetIds;
+  getTilePlanes(component, &tilesetColumns, &tilesetRows, &tilesetIds);
+
+  ShovelerImage* tilemapImage = texture->image;
+  shovelerImageInterleave3(
+      tilemapImage,
+      /* x */ 0,
+      /* y */ 0,
+      tilemapImage->width,
+      tilemapImage->height,
+      tilesetColumns,
+      tilesetRows,
+      tilesetIds);
+
+  shovelerTextureUpdate(texture);
+}
+
+/**
+ * Since the texture image still holds the previous tiles when a field is live updated, it doubles
+ * as the cache to diff the new field value against. Only the bounding rectangle of the changed
+ * tiles is repacked and uploaded.
+ */
+static void updateChangedTiles(
+    ShovelerComponent* component, TilemapTilesData* tilemapTiles, int fieldId) {
+  const unsigned char* tilesetColumns;
+  const unsigned char* tilesetRows;
+  const unsigned char* tilesetIds;
+  getTilePlanes(component, &tilesetColumns, &tilesetRows, &tilesetIds);
+
+  unsigned int channel;
+  const unsigned char* plane;
+  switch (fieldId) {
+  case SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_TILESET_COLUMNS:
+    channel = 0;
+    plane = tilesetColumns;
+    break;
+  case SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_TILESET_ROWS:
+    channel = 1;
+    plane = tilesetRows;
+    break;
+  case SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_TILESET_IDS:
+    channel = 2;
+    plane = tilesetIds;
+    break;
+  default:
+    updateTiles(component, tilemapTiles->texture);
+    return;
+  }
+
+  if (!findChangedRegion(
+          tilemapTiles->texture->image,
+          channel,
+          plane,
+          &tilemapTiles->dirtyX,
+          &tilemapTiles->dirtyY,
+          &tilemapTiles->dirtyWidth,
+          &tilemapTiles->dirtyHeight)) {
+    return;
+  }
+
+  updateDirtyTiles(component, tilemapTiles);
+}
+
+static void updateDirtyTiles(ShovelerComponent* component, TilemapTilesData* tilemapTiles) {
+  if (tilemapTiles->dirtyWidth == 0 || tilemapTiles->dirtyHeight == 0) {
+    return;
+  }
+
+  const unsigned char* tilesetColumns;
+  const unsigned char* tilesetRows;
+  const unsigned char* tilesetIds;
+  getTilePlanes(component, &tilesetColumns, &tilesetRows, &tilesetIds);
+
+  shovelerImageInterleave3(
+      tilemapTiles->texture->image,
+      tilemapTiles->dirtyX,
+      tilemapTiles->dirtyY,
+      tilemapTiles->dirtyWidth,
+      tilemapTiles->dirtyHeight,
+      tilesetColumns,
+      tilesetRows,
+      tilesetIds);
+  shovelerTextureUpdateRegion(
+      tilemapTiles->texture,
+      tilemapTiles->dirtyX,
+      tilemapTiles->dirtyY,
+      tilemapTiles->dirtyWidth,
+      tilemapTiles->dirtyHeight);
+
+  tilemapTiles->dirtyWidth = 0;
+  tilemapTiles->dirtyHeight = 0;
+}
+
+static void getTilePlanes(
+    ShovelerComponent* component,
+    const unsigned char** outputTilesetColumns,
+    const unsigned char** outputTilesetRows,
+    const unsigned char** outputTilesetIds) {
   shovelerComponentGetFieldValueBytes(
       component,
       SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_TILESET_COLUMNS,
-      &tilesetColumns,
+      outputTilesetColumns,
       /* outputSize */ NULL);
   shovelerComponentGetFieldValueBytes(
       component,
       SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_TILESET_ROWS,
-      &tilesetRows,
+      outputTilesetRows,
       /* outputSize */ NULL);
   shovelerComponentGetFieldValueBytes(
       component,
       SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_TILESET_IDS,
-      &tilesetIds,
+      outputTilesetIds,
       /* outputSize */ NULL);
-  assert(tilesetColumns != NULL);
-  assert(tilesetRows != NULL);
-  assert(tilesetIds != NULL);
+  assert(*outputTilesetColumns != NULL);
+  assert(*outputTilesetRows != NULL);
+  assert(*outputTilesetIds != NULL);
+}
 
-  ShovelerImage* tilemapImage = texture->image;
-  int numColumns = tilemapImage->width;
-  int numRows = tilemapImage->height;
+/** Computes the bounding rectangle of all pixels whose channel differs from the plane, returning
+ * false if there are none. */
+static bool findChangedRegion(
+    ShovelerImage* image,
+    unsigned int channel,
+    const unsigned char* plane,
+    unsigned int* outputX,
+    unsigned int* outputY,
+    unsigned int* outputWidth,
+    unsigned int* outputHeight) {
+  unsigned int minColumn = image->width;
+  unsigned int maxColumn = 0;
+  unsigned int minRow = image->height;
+  unsigned int maxRow = 0;
 
-  for (int row = 0; row < numRows; ++row) {
-    int rowIndex = row * numColumns;
-    for (int column = 0; column < numColumns; ++column) {
-      int columnIndex = rowIndex + column;
+  for (unsigned int row = 0; row < image->height; row++) {
+    const unsigned char* planeRow = plane + (size_t) row * image->width;
+    const unsigned char* imageRow = &shovelerImageGet(image, 0, row, channel);
 
-      shovelerImageGet(tilemapImage, column, row, 0) = tilesetColumns[columnIndex];
-      shovelerImageGet(tilemapImage, column, row, 1) = tilesetRows[columnIndex];
-      shovelerImageGet(tilemapImage, column, row, 2) = tilesetIds[columnIndex];
+    unsigned int first = 0;
+    while (first < image->width && imageRow[3 * first] == planeRow[first]) {
+      first++;
     }
+    if (first == image->width) {
+      continue;
+    }
+
+    unsigned int last = image->width - 1;
+    while (last > first && imageRow[3 * last] == planeRow[last]) {
+      last--;
+    }
+
+    if (first < minColumn) {
+      minColumn = first;
+    }
+    if (last > maxColumn) {
+      maxColumn = last;
+    }
+    if (row < minRow) {
+      minRow = row;
+    }
+    maxRow = row;
   }
 
-  shovelerTextureUpdate(texture);
+  if (minRow > maxRow) {
+    return false;
+  }
+
+  *outputX = minColumn;
+  *outputY = minRow;
+  *outputWidth = maxColumn - minColumn + 1;
+  *outputHeight = maxRow - minRow + 1;
+  return true;
+}
+
+/**
+ * Writes the region's tiles straight into the storage of a plane field and then updates the field
+ * with its own value, which skips the copy on assignment but still notifies the world and system.
+ */
+static void updateTilePlaneRegion(
+    ShovelerComponent* component,
+    int fieldId,
+    unsigned int x,
+    unsigned int y,
+    unsigned int width,
+    unsigned int height,
+    const unsigned char* regionPlane) {
+  unsigned int numColumns = (unsigned int) shovelerComponentGetFieldValueInt(
+      component, SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_NUM_COLUMNS);
+
+  ShovelerComponentFieldValue* fieldValue =
+      (ShovelerComponentFieldValue*) shovelerComponentGetFieldValue(component, fieldId);
+  assert(fieldValue->isSet);
+  assert(fieldValue->type == SHOVELER_COMPONENT_FIELD_TYPE_BYTES);
+  assert(fieldValue->bytesValue.data != NULL);
+
+  unsigned char* plane = fieldValue->bytesValue.data;
+  for (unsigned int row = 0; row < height; row++) {
+    memcpy(
+        plane + (size_t) (y + row) * numColumns + x,
+        regionPlane + (size_t) row * width,
+        width * sizeof(unsigned char));
+  }
+
+  shovelerComponentUpdateField(component, fieldId, fieldValue, /* isCanonical */ true);
 }
 
 static bool isComponentImageResourceEntityDefinition(ShovelerComponent* component) {
@@ -0,0 +1,106 @@
+/**
+ * Wrappers adding streaming compression to any server and client network adapter pair.
+ *
+ * Each connection keeps one long-lived raw deflate stream per direction. Every sent message is
+ * flushed with Z_SYNC_FLUSH so that it can be decompressed on its own as soon as it arrives, while
+ * the history window shared across messages lets the repetitive entity IDs, component indices and
+ * field IDs of later op batches compress against earlier ones. The empty stored block trailing each
+ * flush is stripped before sending and restored on receipt.
+ *
+ * Both sides must use the same dictionary preset, which primes the history window for the first
+ * messages of a connection.
+ *
+ * Since every message depends on the history of the ones before it, a message that fails to
+ * decompress leaves the stream unusable. The connection is then reported as disconnected and ignores
+ * all further traffic, until the underlying adapter reports it disconnected or connected again.
+ */
+
+#ifndef SHOVELER_COMPRESSED_NETWORK_ADAPTER_H
+#define SHOVELER_COMPRESSED_NETWORK_ADAPTER_H
+
+#include <glib.h>
+#include <shoveler/client_network_adapter.h>
+#include <shoveler/server_network_adapter.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct ShovelerCompressionContextStruct
+    ShovelerCompressionContext; // forward declaration: compression.h
+typedef struct ShovelerDecompressionContextStruct
+    ShovelerDecompressionContext; // forward declaration: compression.h
+typedef struct ShovelerComponentTypeIndexerStruct ShovelerComponentTypeIndexer;
+
+typedef struct ShovelerCompressedNetworkAdapterConnectionStruct {
+  /** compresses outgoing messages */
+  ShovelerCompressionContext* compression;
+  /** decompresses incoming messages */
+  ShovelerDecompressionContext* decompression;
+  /** set once an incoming message failed to decompress, after which the connection is unusable */
+  bool failed;
+  int64_t numRawBytesSent;
+  int64_t numCompressedBytesSent;
+  int64_t numRawBytesReceived;
+  int64_t numCompressedBytesReceived;
+} ShovelerCompressedNetworkAdapterConnection;
+
+typedef struct ShovelerCompressedServerNetworkAdapterStruct {
+  ShovelerServerNetworkAdapter* serverNetworkAdapter;
+  /** zlib compression level for new connections */
+  int defaultLevel;
+  /** dictionary preset shared with clients, or NULL */
+  GString* dictionary;
+  /** map from client handle to (ShovelerCompressedNetworkAdapterConnection *) */
+  GHashTable* connections;
+  ShovelerServerNetworkAdapter compressedServerNetworkAdapter;
+} ShovelerCompressedServerNetworkAdapter;
+
+typedef struct ShovelerCompressedClientNetworkAdapterStruct {
+  ShovelerClientNetworkAdapter* clientNetworkAdapter;
+  /** dictionary preset shared with the server, or NULL */
+  GString* dictionary;
+  ShovelerCompressedNetworkAdapterConnection* connection;
+  ShovelerClientNetworkAdapter compressedClientNetworkAdapter;
+} ShovelerCompressedClientNetworkAdapter;
+
+/** Returns a dictionary of the op prefixes common to all components of the indexed types. */
+GString* shovelerCompressedNetworkAdapterCreateDictionary(
+    ShovelerComponentTypeIndexer* componentTypeIndexer);
+
+/** Wraps the passed adapter, which must outlive the wrapper. The dictionary can be NULL. */
+ShovelerCompressedServerNetworkAdapter* shovelerCompressedServerNetworkAdapterCreate(
+    ShovelerServerNetworkAdapter* serverNetworkAdapter,
+    int defaultLevel,
+    const unsigned char* dictionary,
+    size_t dictionarySize);
+ShovelerServerNetworkAdapter* shovelerCompressedServerNetworkAdapterGetServer(
+    ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter);
+/** Returns the connection of a connected client, or NULL if there is none. */
+ShovelerCompressedNetworkAdapterConnection* shovelerCompressedServerNetworkAdapterGetConnection(
+    ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter, void* clientHandle);
+/** Trades CPU time for compression ratio of messages sent to a client from now on. */
+bool shovelerCompressedServerNetworkAdapterSetClientLevel(
+    ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter,
+    void* clientHandle,
+    int level);
+void shovelerCompressedServerNetworkAdapterFree(
+    ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter);
+
+/**
+ * Wraps the passed adapter, which must outlive the wrapper. The dictionary can be NULL.
+ *
+ * Returns NULL if the compression streams couldn't be set up.
+ */
+ShovelerCompressedClientNetworkAdapter* shovelerCompressedClientNetworkAdapterCreate(
+    ShovelerClientNetworkAdapter* clientNetworkAdapter,
+    int level,
+    const unsigned char* dictionary,
+    size_t dictionarySize);
+ShovelerClientNetworkAdapter* shovelerCompressedClientNetworkAdapterGetClient(
+    ShovelerCompressedClientNetworkAdapter* compressedClientNetworkAdapter);
+bool shovelerCompressedClientNetworkAdapterSetLevel(
+    ShovelerCompressedClientNetworkAdapter* compressedClientNetworkAdapter, int level);
+void shovelerCompressedClientNetworkAdapterFree(
+    ShovelerCompressedClientNetworkAdapter* compressedClientNetworkAdapter);
+
+#endif
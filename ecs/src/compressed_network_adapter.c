@@ -0,0 +1,509 @@
+#include "shoveler/compressed_network_adapter.h"
+
+#include <shoveler/client_op.h>
+#include <shoveler/component_type_indexer.h>
+#include <shoveler/compression.h>
+#include <shoveler/log.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter;
+  bool (*receiveEventCallback)(const ShovelerServerNetworkAdapterEvent* event, void* userData);
+  void* callbackUserData;
+} ServerReceiveContext;
+
+typedef struct {
+  ShovelerCompressedClientNetworkAdapter* compressedClientNetworkAdapter;
+  bool (*receiveEventCallback)(const ShovelerClientNetworkAdapterEvent* event, void* userData);
+  void* callbackUserData;
+} ClientReceiveContext;
+
+static bool serverSendMessage(
+    void* clientHandle,
+    const unsigned char* data,
+    int size,
+    void* compressedServerNetworkAdapterPointer);
+static bool serverReceiveEvent(
+    bool (*receiveEventCallback)(const ShovelerServerNetworkAdapterEvent* event, void* userData),
+    void* callbackUserData,
+    void* compressedServerNetworkAdapterPointer);
+static bool serverReceiveWrappedEvent(
+    const ShovelerServerNetworkAdapterEvent* event, void* receiveContextPointer);
+static bool clientSendMessage(
+    const unsigned char* data, int size, void* compressedClientNetworkAdapterPointer);
+static bool clientReceiveEvent(
+    bool (*receiveEventCallback)(const ShovelerClientNetworkAdapterEvent* event, void* userData),
+    void* callbackUserData,
+    void* compressedClientNetworkAdapterPointer);
+static bool clientReceiveWrappedEvent(
+    const ShovelerClientNetworkAdapterEvent* event, void* receiveContextPointer);
+static ShovelerCompressedNetworkAdapterConnection* createConnection(
+    int level, const GString* dictionary);
+static bool resetConnection(ShovelerCompressedNetworkAdapterConnection* connection);
+static void failConnection(ShovelerCompressedNetworkAdapterConnection* connection);
+static bool compressMessage(
+    ShovelerCompressedNetworkAdapterConnection* connection, const unsigned char* data, int size);
+static GString* decompressMessage(
+    ShovelerCompressedNetworkAdapterConnection* connection, const GString* payload);
+static void freeConnection(void* connectionPointer);
+
+/** Empty stored block ending every sync flush, which is implied rather than sent. */
+static const unsigned char syncFlushTrailer[] = {0x00, 0x00, 0xff, 0xff};
+static const char* decompressionFailureReason = "failed to decompress message";
+
+GString* shovelerCompressedNetworkAdapterCreateDictionary(
+    ShovelerComponentTypeIndexer* componentTypeIndexer) {
+  GString* dictionary = g_string_new("");
+
+  // All component ops start with their type, a small entity ID and the component type index.
+  // Ops on the same component type share the latter two, which is what the dictionary captures.
+  ShovelerClientOp clientOp = shovelerClientOp();
+  clientOp.type = SHOVELER_CLIENT_OP_ADD_COMPONENT;
+  clientOp.addComponent.entityId = 1;
+  for (int i = 0; i < (int) componentTypeIndexer->componentTypes->len; i++) {
+    clientOp.addComponent.componentTypeId =
+        shovelerComponentTypeIndexerToId(componentTypeIndexer, i);
+    shovelerClientOpSerialize(&clientOp, componentTypeIndexer, dictionary);
+  }
+
+  return dictionary;
+}
+
+ShovelerCompressedServerNetworkAdapter* shovelerCompressedServerNetworkAdapterCreate(
+    ShovelerServerNetworkAdapter* serverNetworkAdapter,
+    int defaultLevel,
+    const unsigned char* dictionary,
+    size_t dictionarySize) {
+  ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter =
+      malloc(sizeof(ShovelerCompressedServerNetworkAdapter));
+  compressedServerNetworkAdapter->serverNetworkAdapter = serverNetworkAdapter;
+  compressedServerNetworkAdapter->defaultLevel = defaultLevel;
+  compressedServerNetworkAdapter->dictionary = NULL;
+  if (dictionary != NULL && dictionarySize > 0) {
+    compressedServerNetworkAdapter->dictionary =
+        g_string_new_len((const gchar*) dictionary, (gssize) dictionarySize);
+  }
+  compressedServerNetworkAdapter->connections = g_hash_table_new_full(
+      g_direct_hash, g_direct_equal, /* keyDestroyFunc */ NULL, freeConnection);
+  compressedServerNetworkAdapter->compressedServerNetworkAdapter.sendMessage = serverSendMessage;
+  compressedServerNetworkAdapter->compressedServerNetworkAdapter.receiveEvent = serverReceiveEvent;
+  compressedServerNetworkAdapter->compressedServerNetworkAdapter.userData =
+      compressedServerNetworkAdapter;
+  return compressedServerNetworkAdapter;
+}
+
+ShovelerServerNetworkAdapter* shovelerCompressedServerNetworkAdapterGetServer(
+    ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter) {
+  return &compressedServerNetworkAdapter->compressedServerNetworkAdapter;
+}
+
+ShovelerCompressedNetworkAdapterConnection* shovelerCompressedServerNetworkAdapterGetConnection(
+    ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter, void* clientHandle) {
+  return g_hash_table_lookup(compressedServerNetworkAdapter->connections, clientHandle);
+}
+
+bool shovelerCompressedServerNetworkAdapterSetClientLevel(
+    ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter,
+    void* clientHandle,
+    int level) {
+  ShovelerCompressedNetworkAdapterConnection* connection =
+      g_hash_table_lookup(compressedServerNetworkAdapter->connections, clientHandle);
+  if (connection == NULL) {
+    return false;
+  }
+
+  return shovelerCompressionContextSetLevel(connection->compression, level);
+}
+
+void shovelerCompressedServerNetworkAdapterFree(
+    ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter) {
+  g_hash_table_destroy(compressedServerNetworkAdapter->connections);
+  if (compressedServerNetworkAdapter->dictionary != NULL) {
+    g_string_free(compressedServerNetworkAdapter->dictionary, /* freeSegment */ true);
+  }
+  free(compressedServerNetworkAdapter);
+}
+
+ShovelerCompressedClientNetworkAdapter* shovelerCompressedClientNetworkAdapterCreate(
+    ShovelerClientNetworkAdapter* clientNetworkAdapter,
+    int level,
+    const unsigned char* dictionary,
+    size_t dictionarySize) {
+  ShovelerCompressedClientNetworkAdapter* compressedClientNetworkAdapter =
+      malloc(sizeof(ShovelerCompressedClientNetworkAdapter));
+  compressedClientNetworkAdapter->clientNetworkAdapter = clientNetworkAdapter;
+  compressedClientNetworkAdapter->dictionary = NULL;
+  if (dictionary != NULL && dictionarySize > 0) {
+    compressedClientNetworkAdapter->dictionary =
+        g_string_new_len((const gchar*) dictionary, (gssize) dictionarySize);
+  }
+  compressedClientNetworkAdapter->connection =
+      createConnection(level, compressedClientNetworkAdapter->dictionary);
+  if (compressedClientNetworkAdapter->connection == NULL) {
+    if (compressedClientNetworkAdapter->dictionary != NULL) {
+      g_string_free(compressedClientNetworkAdapter->dictionary, /* freeSegment */ true);
+    }
+    free(compressedClientNetworkAdapter);
+    return NULL;
+  }
+  compressedClientNetworkAdapter->compressedClientNetworkAdapter.sendMessage = clientSendMessage;
+  compressedClientNetworkAdapter->compressedClientNetworkAdapter.receiveEvent = clientReceiveEvent;
+  compressedClientNetworkAdapter->compressedClientNetworkAdapter.userData =
+      compressedClientNetworkAdapter;
+  return compressedClientNetworkAdapter;
+}
+
+ShovelerClientNetworkAdapter* shovelerCompressedClientNetworkAdapterGetClient(
+    ShovelerCompressedClientNetworkAdapter* compressedClientNetworkAdapter) {
+  return &compressedClientNetworkAdapter->compressedClientNetworkAdapter;
+}
+
+bool shovelerCompressedClientNetworkAdapterSetLevel(
+    ShovelerCompressedClientNetworkAdapter* compressedClientNetworkAdapter, int level) {
+  return shovelerCompressionContextSetLevel(
+      compressedClientNetworkAdapter->connection->compression, level);
+}
+
+void shovelerCompressedClientNetworkAdapterFree(
+    ShovelerCompressedClientNetworkAdapter* compressedClientNetworkAdapter) {
+  freeConnection(compressedClientNetworkAdapter->connection);
+  if (compressedClientNetworkAdapter->dictionary != NULL) {
+    g_string_free(compressedClientNetworkAdapter->dictionary, /* freeSegment */ true);
+  }
+  free(compressedClientNetworkAdapter);
+}
+
+static bool serverSendMessage(
+    void* clientHandle,
+    const unsigned char* data,
+    int size,
+    void* compressedServerNetworkAdapterPointer) {
+  ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter =
+      compressedServerNetworkAdapterPointer;
+  ShovelerServerNetworkAdapter* serverNetworkAdapter =
+      compressedServerNetworkAdapter->serverNetworkAdapter;
+
+  ShovelerCompressedNetworkAdapterConnection* connection =
+      g_hash_table_lookup(compressedServerNetworkAdapter->connections, clientHandle);
+  if (connection == NULL) {
+    shovelerLogWarning(
+        "Ignoring message of size %d being sent to unknown client %p.", size, clientHandle);
+    return false;
+  }
+
+  if (connection->failed) {
+    return false;
+  }
+
+  if (!compressMessage(connection, data, size)) {
+    return false;
+  }
+
+  GString* compressed = connection->compression->output;
+  bool sent = serverNetworkAdapter->sendMessage(
+      clientHandle,
+      (const unsigned char*) compressed->str,
+      (int) compressed->len,
+      serverNetworkAdapter->userData);
+  shovelerCompressionContextClearOutput(connection->compression);
+  return sent;
+}
+
+static bool serverReceiveEvent(
+    bool (*receiveEventCallback)(const ShovelerServerNetworkAdapterEvent* event, void* userData),
+    void* callbackUserData,
+    void* compressedServerNetworkAdapterPointer) {
+  ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter =
+      compressedServerNetworkAdapterPointer;
+  ShovelerServerNetworkAdapter* serverNetworkAdapter =
+      compressedServerNetworkAdapter->serverNetworkAdapter;
+
+  ServerReceiveContext receiveContext;
+  receiveContext.compressedServerNetworkAdapter = compressedServerNetworkAdapter;
+  receiveContext.receiveEventCallback = receiveEventCallback;
+  receiveContext.callbackUserData = callbackUserData;
+  return serverNetworkAdapter->receiveEvent(
+      serverReceiveWrappedEvent, &receiveContext, serverNetworkAdapter->userData);
+}
+
+static bool serverReceiveWrappedEvent(
+    const ShovelerServerNetworkAdapterEvent* event, void* receiveContextPointer) {
+  ServerReceiveContext* receiveContext = receiveContextPointer;
+  ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter =
+      receiveContext->compressedServerNetworkAdapter;
+
+  switch (event->type) {
+  case SHOVELER_SERVER_NETWORK_ADAPTER_EVENT_TYPE_CLIENT_CONNECTED: {
+    ShovelerCompressedNetworkAdapterConnection* connection = createConnection(
+        compressedServerNetworkAdapter->defaultLevel, compressedServerNetworkAdapter->dictionary);
+    if (connection == NULL) {
+      // the client stays unknown, so its messages are dropped and its disconnect is swallowed
+      shovelerLogError(
+          "Failed to create compressed connection for client %p, ignoring it.",
+          event->clientHandle);
+      g_hash_table_remove(compressedServerNetworkAdapter->connections, event->clientHandle);
+      return true;
+    }
+
+    g_hash_table_replace(
+        compressedServerNetworkAdapter->connections, event->clientHandle, connection);
+    return receiveContext->receiveEventCallback(event, receiveContext->callbackUserData);
+  }
+  case SHOVELER_SERVER_NETWORK_ADAPTER_EVENT_TYPE_CLIENT_DISCONNECTED: {
+    ShovelerCompressedNetworkAdapterConnection* connection =
+        g_hash_table_lookup(compressedServerNetworkAdapter->connections, event->clientHandle);
+    if (connection == NULL || connection->failed) {
+      // the disconnect was already reported when the connection failed, or it was never announced
+      g_hash_table_remove(compressedServerNetworkAdapter->connections, event->clientHandle);
+      return true;
+    }
+
+    bool result = receiveContext->receiveEventCallback(event, receiveContext->callbackUserData);
+    g_hash_table_remove(compressedServerNetworkAdapter->connections, event->clientHandle);
+    return result;
+  }
+  case SHOVELER_SERVER_NETWORK_ADAPTER_EVENT_TYPE_MESSAGE: {
+    ShovelerCompressedNetworkAdapterConnection* connection =
+        g_hash_table_lookup(compressedServerNetworkAdapter->connections, event->clientHandle);
+    if (connection == NULL) {
+      shovelerLogWarning(
+          "Dropping message of size %d received from unknown client %p.",
+          (int) event->payload->len,
+          event->clientHandle);
+      return true;
+    }
+
+    if (connection->failed) {
+      return true;
+    }
+
+    GString* decompressed = decompressMessage(connection, event->payload);
+    if (decompressed == NULL) {
+      // The inflate stream no longer matches the client's deflate history, so no later message
+      // can be decoded either. Report the client as disconnected and ignore it from now on.
+      shovelerLogError(
+          "Failed to decompress message of size %d from client %p, disconnecting it.",
+          (int) event->payload->len,
+          event->clientHandle);
+      failConnection(connection);
+
+      ShovelerServerNetworkAdapterEvent disconnectedEvent =
+          shovelerServerNetworkAdapterEventClientDisconnected(
+              event->clientHandle, decompressionFailureReason);
+      bool result =
+          receiveContext->receiveEventCallback(&disconnectedEvent, receiveContext->callbackUserData);
+      shovelerServerNetworkAdapterEventClear(&disconnectedEvent);
+      return result;
+    }
+
+    ShovelerServerNetworkAdapterEvent decompressedEvent = *event;
+    decompressedEvent.payload = decompressed;
+    return receiveContext->receiveEventCallback(
+        &decompressedEvent, receiveContext->callbackUserData);
+  }
+  default:
+    return receiveContext->receiveEventCallback(event, receiveContext->callbackUserData);
+  }
+}
+
+static bool clientSendMessage(
+    const unsigned char* data, int size, void* compressedClientNetworkAdapterPointer) {
+  ShovelerCompressedClientNetworkAdapter* compressedClientNetworkAdapter =
+      compressedClientNetworkAdapterPointer;
+  ShovelerClientNetworkAdapter* clientNetworkAdapter =
+      compressedClientNetworkAdapter->clientNetworkAdapter;
+
+  ShovelerCompressedNetworkAdapterConnection* connection =
+      compressedClientNetworkAdapter->connection;
+  if (connection->failed || !compressMessage(connection, data, size)) {
+    return false;
+  }
+
+  GString* compressed = connection->compression->output;
+  bool sent = clientNetworkAdapter->sendMessage(
+      (const unsigned char*) compressed->str,
+      (int) compressed->len,
+      clientNetworkAdapter->userData);
+  shovelerCompressionContextClearOutput(connection->compression);
+  return sent;
+}
+
+static bool clientReceiveEvent(
+    bool (*receiveEventCallback)(const ShovelerClientNetworkAdapterEvent* event, void* userData),
+    void* callbackUserData,
+    void* compressedClientNetworkAdapterPointer) {
+  ShovelerCompressedClientNetworkAdapter* compressedClientNetworkAdapter =
+      compressedClientNetworkAdapterPointer;
+  ShovelerClientNetworkAdapter* clientNetworkAdapter =
+      compressedClientNetworkAdapter->clientNetworkAdapter;
+
+  ClientReceiveContext receiveContext;
+  receiveContext.compressedClientNetworkAdapter = compressedClientNetworkAdapter;
+  receiveContext.receiveEventCallback = receiveEventCallback;
+  receiveContext.callbackUserData = callbackUserData;
+  return clientNetworkAdapter->receiveEvent(
+      clientReceiveWrappedEvent, &receiveContext, clientNetworkAdapter->userData);
+}
+
+static bool clientReceiveWrappedEvent(
+    const ShovelerClientNetworkAdapterEvent* event, void* receiveContextPointer) {
+  ClientReceiveContext* receiveContext = receiveContextPointer;
+  ShovelerCompressedNetworkAdapterConnection* connection =
+      receiveContext->compressedClientNetworkAdapter->connection;
+
+  switch (event->type) {
+  case SHOVELER_CLIENT_NETWORK_ADAPTER_EVENT_TYPE_CLIENT_CONNECTED:
+    // the server starts fresh streams for every connection
+    if (!resetConnection(connection)) {
+      shovelerLogError("Failed to reset compressed connection to server, disconnecting.");
+      failConnection(connection);
+
+      ShovelerClientNetworkAdapterEvent disconnectedEvent =
+          shovelerClientNetworkAdapterEventClientDisconnected("failed to reset compression");
+      bool result =
+          receiveContext->receiveEventCallback(&disconnectedEvent, receiveContext->callbackUserData);
+      shovelerClientNetworkAdapterEventClear(&disconnectedEvent);
+      return result;
+    }
+    return receiveContext->receiveEventCallback(event, receiveContext->callbackUserData);
+  case SHOVELER_CLIENT_NETWORK_ADAPTER_EVENT_TYPE_CLIENT_DISCONNECTED:
+    if (connection->failed) {
+      return true; // already reported when the connection failed
+    }
+    return receiveContext->receiveEventCallback(event, receiveContext->callbackUserData);
+  case SHOVELER_CLIENT_NETWORK_ADAPTER_EVENT_TYPE_MESSAGE: {
+    if (connection->failed) {
+      return true;
+    }
+
+    GString* decompressed = decompressMessage(connection, event->payload);
+    if (decompressed == NULL) {
+      // The inflate stream no longer matches the server's deflate history, so no later message
+      // can be decoded either. Report the connection as lost until the next connect.
+      shovelerLogError(
+          "Failed to decompress message of size %d from server, disconnecting.",
+          (int) event->payload->len);
+      failConnection(connection);
+
+      ShovelerClientNetworkAdapterEvent disconnectedEvent =
+          shovelerClientNetworkAdapterEventClientDisconnected(decompressionFailureReason);
+      bool result =
+          receiveContext->receiveEventCallback(&disconnectedEvent, receiveContext->callbackUserData);
+      shovelerClientNetworkAdapterEventClear(&disconnectedEvent);
+      return result;
+    }
+
+    ShovelerClientNetworkAdapterEvent decompressedEvent = *event;
+    decompressedEvent.payload = decompressed;
+    return receiveContext->receiveEventCallback(
+        &decompressedEvent, receiveContext->callbackUserData);
+  }
+  default:
+    return receiveContext->receiveEventCallback(event, receiveContext->callbackUserData);
+  }
+}
+
+/** Returns the new connection, or NULL if its streams couldn't be set up. */
+static ShovelerCompressedNetworkAdapterConnection* createConnection(
+    int level, const GString* dictionary) {
+  ShovelerCompressionContext* compression =
+      shovelerCompressionContextCreate(SHOVELER_COMPRESSION_FORMAT_DEFLATE, level);
+  if (compression == NULL) {
+    return NULL;
+  }
+
+  ShovelerDecompressionContext* decompression =
+      shovelerDecompressionContextCreate(SHOVELER_COMPRESSION_FORMAT_DEFLATE);
+  if (decompression == NULL) {
+    shovelerCompressionContextFree(compression);
+    return NULL;
+  }
+
+  if (dictionary != NULL &&
+      (!shovelerCompressionContextSetDictionary(
+           compression, (const unsigned char*) dictionary->str, dictionary->len) ||
+       !shovelerDecompressionContextSetDictionary(
+           decompression, (const unsigned char*) dictionary->str, dictionary->len))) {
+    shovelerCompressionContextFree(compression);
+    shovelerDecompressionContextFree(decompression);
+    return NULL;
+  }
+
+  ShovelerCompressedNetworkAdapterConnection* connection =
+      malloc(sizeof(ShovelerCompressedNetworkAdapterConnection));
+  connection->compression = compression;
+  connection->decompression = decompression;
+  connection->failed = false;
+  connection->numRawBytesSent = 0;
+  connection->numCompressedBytesSent = 0;
+  connection->numRawBytesReceived = 0;
+  connection->numCompressedBytesReceived = 0;
+  return connection;
+}
+
+static bool resetConnection(ShovelerCompressedNetworkAdapterConnection* connection) {
+  shovelerCompressionContextClearOutput(connection->compression);
+  shovelerDecompressionContextClearOutput(connection->decompression);
+  connection->failed = false;
+  return shovelerCompressionContextReset(connection->compression) &&
+      shovelerDecompressionContextReset(connection->decompression);
+}
+
+/** Marks the connection as failed, after which it neither sends nor receives messages. */
+static void failConnection(ShovelerCompressedNetworkAdapterConnection* connection) {
+  connection->failed = true;
+  shovelerCompressionContextClearOutput(connection->compression);
+  shovelerDecompressionContextClearOutput(connection->decompression);
+}
+
+/**
+ * Compresses a message into the output buffer of the connection's compression context, which
+ * might already contain a block emitted by a level change, and which the caller clears after
+ * sending.
+ */
+static bool compressMessage(
+    ShovelerCompressedNetworkAdapterConnection* connection, const unsigned char* data, int size) {
+  ShovelerCompressionContext* compression = connection->compression;
+  if (!shovelerCompressionContextFeed(compression, data, (size_t) size) ||
+      !shovelerCompressionContextFlush(compression)) {
+    shovelerCompressionContextClearOutput(compression);
+    return false;
+  }
+
+  GString* output = compression->output;
+  size_t trailerSize = sizeof(syncFlushTrailer);
+  if (output->len >= trailerSize &&
+      memcmp(output->str + output->len - trailerSize, syncFlushTrailer, trailerSize) == 0) {
+    g_string_truncate(output, output->len - trailerSize);
+  }
+
+  connection->numRawBytesSent += size;
+  connection->numCompressedBytesSent += (int64_t) output->len;
+  return true;
+}
+
+/** Returns the decompressed message, valid until the next message is decompressed, or NULL. */
+static GString* decompressMessage(
+    ShovelerCompressedNetworkAdapterConnection* connection, const GString* payload) {
+  ShovelerDecompressionContext* decompression = connection->decompression;
+  shovelerDecompressionContextClearOutput(decompression);
+
+  if (!shovelerDecompressionContextFeed(
+          decompression, (const unsigned char*) payload->str, payload->len) ||
+      !shovelerDecompressionContextFeed(
+          decompression, syncFlushTrailer, sizeof(syncFlushTrailer))) {
+    return NULL;
+  }
+
+  connection->numCompressedBytesReceived += (int64_t) payload->len;
+  connection->numRawBytesReceived += (int64_t) decompression->output->len;
+  return decompression->output;
+}
+
+static void freeConnection(void* connectionPointer) {
+  ShovelerCompressedNetworkAdapterConnection* connection = connectionPointer;
+  shovelerCompressionContextFree(connection->compression);
+  shovelerDecompressionContextFree(connection->decompression);
+  free(connection);
+}
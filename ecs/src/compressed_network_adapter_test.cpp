@@ -0,0 +1,245 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "client_network_adapter_event_wrapper.h"
+#include "server_network_adapter_event_wrapper.h"
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <shoveler/component_type_indexer.h>
+#include <shoveler/compressed_network_adapter.h>
+#include <shoveler/in_memory_network_adapter.h>
+#include <zlib.h>
+}
+
+using ::testing::ElementsAre;
+
+namespace {
+const auto* testDisconnectReason = "goodbye";
+/** Final deflate block of the reserved type, which no inflate stream accepts. */
+const unsigned char corruptMessage[] = {0x07, 0xff, 0xff};
+
+static bool receiveServerEvent(
+    const ShovelerServerNetworkAdapterEvent* event, void* resultPointer) {
+  auto& result =
+      *static_cast<std::vector<ShovelerServerNetworkAdapterEventWrapper>*>(resultPointer);
+  result.emplace_back(event);
+  return true;
+}
+
+static bool receiveClientEvent(
+    const ShovelerClientNetworkAdapterEvent* event, void* resultPointer) {
+  auto& result =
+      *static_cast<std::vector<ShovelerClientNetworkAdapterEventWrapper>*>(resultPointer);
+  result.emplace_back(event);
+  return true;
+}
+
+static std::string getTestMessage(int index) {
+  return "update entity 1337 component position field coordinates to (" +
+      std::to_string(index) + ", " + std::to_string(index + 1) + ")";
+}
+
+class ShovelerCompressedNetworkAdapterTest : public ::testing::Test {
+public:
+  virtual void SetUp() {
+    inMemoryNetworkAdapter = shovelerInMemoryNetworkAdapterCreate();
+    compressedServerNetworkAdapter = nullptr;
+    compressedClientNetworkAdapter = nullptr;
+  }
+
+  virtual void TearDown() {
+    if (compressedClientNetworkAdapter != nullptr) {
+      shovelerCompressedClientNetworkAdapterFree(compressedClientNetworkAdapter);
+    }
+    if (compressedServerNetworkAdapter != nullptr) {
+      shovelerCompressedServerNetworkAdapterFree(compressedServerNetworkAdapter);
+    }
+    shovelerInMemoryNetworkAdapterFree(inMemoryNetworkAdapter);
+  }
+
+  void Connect(const GString* dictionary) {
+    const auto* dictionaryData =
+        dictionary != nullptr ? reinterpret_cast<const unsigned char*>(dictionary->str) : nullptr;
+    size_t dictionarySize = dictionary != nullptr ? dictionary->len : 0;
+
+    compressedServerNetworkAdapter = shovelerCompressedServerNetworkAdapterCreate(
+        shovelerInMemoryNetworkAdapterGetServer(inMemoryNetworkAdapter),
+        Z_DEFAULT_COMPRESSION,
+        dictionaryData,
+        dictionarySize);
+    server = shovelerCompressedServerNetworkAdapterGetServer(compressedServerNetworkAdapter);
+
+    clientHandle = shovelerInMemoryNetworkAdapterConnectClient(inMemoryNetworkAdapter);
+    compressedClientNetworkAdapter = shovelerCompressedClientNetworkAdapterCreate(
+        shovelerInMemoryNetworkAdapterGetClient(inMemoryNetworkAdapter, clientHandle),
+        Z_DEFAULT_COMPRESSION,
+        dictionaryData,
+        dictionarySize);
+    client = shovelerCompressedClientNetworkAdapterGetClient(compressedClientNetworkAdapter);
+
+    ASSERT_THAT(ReceiveServerEvents(), ElementsAre(IsClientConnectedServerEvent(clientHandle)));
+    ASSERT_THAT(ReceiveClientEvents(), ElementsAre(IsClientConnectedClientEvent()));
+  }
+
+  bool SendToClient(const std::string& message) {
+    return server->sendMessage(
+        clientHandle,
+        reinterpret_cast<const unsigned char*>(message.c_str()),
+        static_cast<int>(message.length()),
+        server->userData);
+  }
+
+  bool SendToServer(const std::string& message) {
+    return client->sendMessage(
+        reinterpret_cast<const unsigned char*>(message.c_str()),
+        static_cast<int>(message.length()),
+        client->userData);
+  }
+
+  std::vector<ShovelerServerNetworkAdapterEventWrapper> ReceiveServerEvents() {
+    std::vector<ShovelerServerNetworkAdapterEventWrapper> result;
+    while (server->receiveEvent(receiveServerEvent, &result, server->userData)) {
+    }
+    return result;
+  }
+
+  std::vector<ShovelerClientNetworkAdapterEventWrapper> ReceiveClientEvents() {
+    std::vector<ShovelerClientNetworkAdapterEventWrapper> result;
+    while (client->receiveEvent(receiveClientEvent, &result, client->userData)) {
+    }
+    return result;
+  }
+
+  ShovelerInMemoryNetworkAdapter* inMemoryNetworkAdapter;
+  ShovelerCompressedServerNetworkAdapter* compressedServerNetworkAdapter;
+  ShovelerCompressedClientNetworkAdapter* compressedClientNetworkAdapter;
+  ShovelerServerNetworkAdapter* server;
+  ShovelerClientNetworkAdapter* client;
+  void* clientHandle;
+};
+
+} // namespace
+
+TEST_F(ShovelerCompressedNetworkAdapterTest, sendToClient) {
+  Connect(/* dictionary */ nullptr);
+
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(SendToClient(getTestMessage(i)));
+    ASSERT_THAT(ReceiveClientEvents(), ElementsAre(IsMessageClientEvent(getTestMessage(i))));
+  }
+
+  auto* connection = shovelerCompressedServerNetworkAdapterGetConnection(
+      compressedServerNetworkAdapter, clientHandle);
+  ASSERT_NE(connection, nullptr);
+  ASSERT_EQ(
+      connection->numRawBytesSent,
+      compressedClientNetworkAdapter->connection->numRawBytesReceived);
+  ASSERT_EQ(
+      connection->numCompressedBytesSent,
+      compressedClientNetworkAdapter->connection->numCompressedBytesReceived);
+  ASSERT_LT(connection->numCompressedBytesSent, connection->numRawBytesSent / 2)
+      << "repeated messages should compress against the shared history";
+}
+
+TEST_F(ShovelerCompressedNetworkAdapterTest, sendToServer) {
+  Connect(/* dictionary */ nullptr);
+
+  ASSERT_TRUE(SendToServer(getTestMessage(0)));
+  ASSERT_TRUE(SendToServer(getTestMessage(1)));
+  shovelerInMemoryNetworkAdapterDisconnectClient(
+      inMemoryNetworkAdapter, clientHandle, testDisconnectReason);
+  ASSERT_THAT(
+      ReceiveServerEvents(),
+      ElementsAre(
+          IsMessageServerEvent(clientHandle, getTestMessage(0)),
+          IsMessageServerEvent(clientHandle, getTestMessage(1)),
+          IsClientDisconnectedServerEvent(clientHandle, testDisconnectReason)));
+  ASSERT_EQ(
+      shovelerCompressedServerNetworkAdapterGetConnection(
+          compressedServerNetworkAdapter, clientHandle),
+      nullptr)
+      << "disconnected client should no longer have a connection";
+}
+
+TEST_F(ShovelerCompressedNetworkAdapterTest, disconnectClientSendingCorruptMessage) {
+  Connect(/* dictionary */ nullptr);
+
+  auto* rawClient = shovelerInMemoryNetworkAdapterGetClient(inMemoryNetworkAdapter, clientHandle);
+  rawClient->sendMessage(corruptMessage, sizeof(corruptMessage), rawClient->userData);
+  ASSERT_TRUE(SendToServer(getTestMessage(0)));
+  ASSERT_THAT(
+      ReceiveServerEvents(),
+      ElementsAre(IsClientDisconnectedServerEvent(clientHandle, "failed to decompress message")))
+      << "messages after the corrupt one can't be decoded and must be dropped";
+  ASSERT_FALSE(SendToClient(getTestMessage(1)));
+
+  shovelerInMemoryNetworkAdapterDisconnectClient(
+      inMemoryNetworkAdapter, clientHandle, testDisconnectReason);
+  ASSERT_TRUE(ReceiveServerEvents().empty()) << "disconnect should only be reported once";
+  ASSERT_EQ(
+      shovelerCompressedServerNetworkAdapterGetConnection(
+          compressedServerNetworkAdapter, clientHandle),
+      nullptr);
+}
+
+TEST_F(ShovelerCompressedNetworkAdapterTest, disconnectFromServerSendingCorruptMessage) {
+  Connect(/* dictionary */ nullptr);
+
+  auto* rawServer = shovelerInMemoryNetworkAdapterGetServer(inMemoryNetworkAdapter);
+  rawServer->sendMessage(
+      clientHandle, corruptMessage, sizeof(corruptMessage), rawServer->userData);
+  ASSERT_TRUE(SendToClient(getTestMessage(0)));
+  ASSERT_THAT(
+      ReceiveClientEvents(),
+      ElementsAre(IsClientDisconnectedClientEvent("failed to decompress message")))
+      << "messages after the corrupt one can't be decoded and must be dropped";
+  ASSERT_TRUE(compressedClientNetworkAdapter->connection->failed);
+  ASSERT_FALSE(SendToServer(getTestMessage(1)));
+}
+
+TEST_F(ShovelerCompressedNetworkAdapterTest, changeLevel) {
+  Connect(/* dictionary */ nullptr);
+
+  ASSERT_TRUE(SendToClient(getTestMessage(0)));
+  bool levelChanged = shovelerCompressedServerNetworkAdapterSetClientLevel(
+      compressedServerNetworkAdapter, clientHandle, Z_BEST_SPEED);
+  ASSERT_TRUE(levelChanged);
+  ASSERT_TRUE(SendToClient(getTestMessage(1)));
+  levelChanged = shovelerCompressedServerNetworkAdapterSetClientLevel(
+      compressedServerNetworkAdapter, clientHandle, Z_BEST_COMPRESSION);
+  ASSERT_TRUE(levelChanged);
+  ASSERT_TRUE(SendToClient(getTestMessage(2)));
+
+  ASSERT_THAT(
+      ReceiveClientEvents(),
+      ElementsAre(
+          IsMessageClientEvent(getTestMessage(0)),
+          IsMessageClientEvent(getTestMessage(1)),
+          IsMessageClientEvent(getTestMessage(2))));
+}
+
+TEST_F(ShovelerCompressedNetworkAdapterTest, dictionary) {
+  ShovelerComponentTypeIndexer* componentTypeIndexer = shovelerComponentTypeIndexerCreate();
+  shovelerComponentTypeIndexerAddComponentType(componentTypeIndexer, "position");
+  shovelerComponentTypeIndexerAddComponentType(componentTypeIndexer, "sprite");
+  GString* dictionary = shovelerCompressedNetworkAdapterCreateDictionary(componentTypeIndexer);
+  ASSERT_GT(dictionary->len, 0);
+  g_string_append(dictionary, "update entity component position field coordinates to");
+
+  Connect(dictionary);
+  ASSERT_TRUE(SendToClient(getTestMessage(0)));
+  ASSERT_THAT(ReceiveClientEvents(), ElementsAre(IsMessageClientEvent(getTestMessage(0))));
+  ASSERT_TRUE(SendToServer(getTestMessage(1)));
+  ASSERT_THAT(
+      ReceiveServerEvents(), ElementsAre(IsMessageServerEvent(clientHandle, getTestMessage(1))));
+
+  auto* connection = shovelerCompressedServerNetworkAdapterGetConnection(
+      compressedServerNetworkAdapter, clientHandle);
+  ASSERT_LT(connection->numCompressedBytesSent, connection->numRawBytesSent / 2)
+      << "first message should compress against the dictionary";
+
+  g_string_free(dictionary, /* freeSegment */ true);
+  shovelerComponentTypeIndexerFree(componentTypeIndexer);
+}
@@ -94,8 +94,8 @@ int main(int argc, char* argv[]) {
       shovelerMaterialTileSpriteCreate(game->shaderCache, /* screenspace */ false);
   ShovelerSprite* tileSprite = shovelerSpriteTileCreate(
       tileSpriteMaterial, tileset, /* tilesetRow */ 1, /* tilesetColumn */ 1);
-  tileSprite->position = shovelerVector2(-0.3f, -0.2f);
-  tileSprite->size = shovelerVector2(0.25f, 0.4f);
+  shovelerSpriteUpdatePosition(tileSprite, shovelerVector2(-0.3f, -0.2f));
+  shovelerSpriteUpdateSize(tileSprite, shovelerVector2(0.25f, 0.4f));
   shovelerCanvasAddSprite(canvas, /* layerId */ 0, tileSprite);
 
   ShovelerCollider2 tileBoxCollider = shovelerColliderBox2(shovelerBoundingBox2(
@@ -105,8 +105,8 @@ int main(int argc, char* argv[]) {
 
   characterSprite = shovelerSpriteTileCreate(
       tileSpriteMaterial, animationTileset, /* tilesetRow */ 0, /* tilesetColumn */ 0);
-  characterSprite->position = shovelerVector2(0.0f, 0.0f);
-  characterSprite->size = shovelerVector2(0.2f, 0.2f);
+  shovelerSpriteUpdatePosition(characterSprite, shovelerVector2(0.0f, 0.0f));
+  shovelerSpriteUpdateSize(characterSprite, shovelerVector2(0.2f, 0.2f));
   shovelerCanvasAddSprite(canvas, /* layerId */ 0, characterSprite);
 
   animation = shovelerTileSpriteAnimationCreate(characterSprite, shovelerVector2(0.0f, 0.0f), 0.1f);
@@ -156,6 +156,7 @@ static void shovelerSampleUpdate(ShovelerGame* game, double dt) {
   float moveAmountY = controller->frame.position.values[1] - characterSprite->position.values[1];
   shovelerTileSpriteAnimationUpdate(animation, shovelerVector2(moveAmountX, moveAmountY));
 
-  characterSprite->position.values[0] = controller->frame.position.values[0];
-  characterSprite->position.values[1] = controller->frame.position.values[1];
+  shovelerSpriteUpdatePosition(
+      characterSprite,
+      shovelerVector2(controller->frame.position.values[0], controller->frame.position.values[1]));
 }
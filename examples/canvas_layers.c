@@ -94,7 +94,7 @@ int main(int argc, char* argv[]) {
   bool collidingTiles[4] = {false, false, false, true};
   ShovelerTilemap* tilemap = shovelerTilemapCreate(tilesTexture, collidingTiles);
   ShovelerSprite* tilemapSprite = shovelerSpriteTilemapCreate(tilemapMaterial, tilemap);
-  tilemapSprite->size = shovelerVector2(10.0f, 10.0f);
+  shovelerSpriteUpdateSize(tilemapSprite, shovelerVector2(10.0f, 10.0f));
   shovelerCanvasAddSprite(canvas, /* layerId */ 0, tilemapSprite);
   shovelerCollidersAddCollider2(game->colliders, &tilemapSprite->collider);
 
@@ -107,7 +107,7 @@ int main(int argc, char* argv[]) {
   shovelerTextureUpdate(borderTilesTexture);
   ShovelerTilemap* borderTilemap = shovelerTilemapCreate(borderTilesTexture, NULL);
   ShovelerSprite* borderTilemapSprite = shovelerSpriteTilemapCreate(tilemapMaterial, borderTilemap);
-  borderTilemapSprite->size = shovelerVector2(10.0f, 10.0f);
+  shovelerSpriteUpdateSize(borderTilemapSprite, shovelerVector2(10.0f, 10.0f));
   shovelerCanvasAddSprite(canvas, /* layerId */ 2, borderTilemapSprite);
   shovelerCollidersAddCollider2(game->colliders, &borderTilemapSprite->collider);
 
@@ -142,14 +142,14 @@ int main(int argc, char* argv[]) {
       shovelerMaterialTileSpriteCreate(game->shaderCache, /* screenspace */ false);
   ShovelerSprite* tileSprite = shovelerSpriteTileCreate(
       tileSpriteMaterial, tileset, /* tilesetRow */ 0, /* tilesetColumn */ 1);
-  tileSprite->position = shovelerVector2(-1.5f, -1.5f);
-  tileSprite->size = shovelerVector2(5.0f, 5.0f);
+  shovelerSpriteUpdatePosition(tileSprite, shovelerVector2(-1.5f, -1.5f));
+  shovelerSpriteUpdateSize(tileSprite, shovelerVector2(5.0f, 5.0f));
   shovelerCanvasAddSprite(canvas, /* layerId */ 1, tileSprite);
 
   characterSprite = shovelerSpriteTileCreate(
       tileSpriteMaterial, animationTileset, /* tilesetRow */ 0, /* tilesetColumn */ 0);
-  characterSprite->position = shovelerVector2(0.0f, 0.0f);
-  characterSprite->size = shovelerVector2(1.0f, 1.0f);
+  shovelerSpriteUpdatePosition(characterSprite, shovelerVector2(0.0f, 0.0f));
+  shovelerSpriteUpdateSize(characterSprite, shovelerVector2(1.0f, 1.0f));
   shovelerCanvasAddSprite(canvas, /* layerId */ 1, characterSprite);
 
   animation = shovelerTileSpriteAnimationCreate(characterSprite, shovelerVector2(0.0f, 0.0f), 0.1f);
@@ -211,6 +211,7 @@ static void updateGame(ShovelerGame* game, double dt) {
   float moveAmountY = controller->frame.position.values[1] - characterWorldY;
   shovelerTileSpriteAnimationUpdate(animation, shovelerVector2(moveAmountX, moveAmountY));
 
-  characterSprite->position.values[0] = controller->frame.position.values[0];
-  characterSprite->position.values[1] = controller->frame.position.values[1];
+  shovelerSpriteUpdatePosition(
+      characterSprite,
+      shovelerVector2(controller->frame.position.values[0], controller->frame.position.values[1]));
 }
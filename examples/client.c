@@ -1,6 +1,7 @@
 #include <shoveler/camera/perspective.h>
 #include <shoveler/client_system.h>
 #include <shoveler/component.h>
+#include <shoveler/component/tilemap_tiles.h>
 #include <shoveler/component_field.h>
 #include <shoveler/component_type.h>
 #include <shoveler/constants.h>
@@ -20,7 +21,6 @@
 #include <shoveler/types.h>
 #include <shoveler/world.h>
 #include <stdlib.h> // EXIT_FAILURE, EXIT_SUCCESS
-#include <string.h> // memcpy
 
 static double time = 0.0;
 
@@ -935,21 +935,31 @@ static void updateGame(ShovelerGame* game, double dt) {
   ShovelerWorldEntity* tilemapEntity = shovelerWorldGetEntity(world, 8);
   ShovelerComponent* tilemapComponent =
       shovelerWorldEntityGetComponent(tilemapEntity, shovelerComponentTypeIdTilemapTiles);
-  const unsigned char* tilesetColumns;
+  const unsigned char* tilesetRows;
+  const unsigned char* tilesetIds;
   shovelerComponentGetFieldValueBytes(
       tilemapComponent,
-      SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_TILESET_COLUMNS,
-      &tilesetColumns,
+      SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_TILESET_ROWS,
+      &tilesetRows,
+      /* outputSize */ NULL);
+  shovelerComponentGetFieldValueBytes(
+      tilemapComponent,
+      SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_TILESET_IDS,
+      &tilesetIds,
       /* outputSize */ NULL);
-  unsigned char updatedTilesetColumns[4];
-  memcpy(&updatedTilesetColumns, tilesetColumns, 4 * sizeof(unsigned char));
-  updatedTilesetColumns[0] = (unsigned char) ((int) time % 2);
+  unsigned char updatedTilesetColumn = (unsigned char) ((int) time % 2);
+  unsigned char tilesetRow = tilesetRows[0];
+  unsigned char tilesetId = tilesetIds[0];
 
-  shovelerComponentUpdateCanonicalFieldBytes(
+  shovelerComponentUpdateTilemapTilesRegion(
       tilemapComponent,
-      SHOVELER_COMPONENT_TILEMAP_TILES_OPTION_TILESET_COLUMNS,
-      updatedTilesetColumns,
-      4);
+      /* x */ 0,
+      /* y */ 0,
+      /* width */ 1,
+      /* height */ 1,
+      &updatedTilesetColumn,
+      &tilesetRow,
+      &tilesetId);
 }
 
 static void onUpdateComponent(
@@ -154,7 +154,7 @@ int main(int argc, char* argv[]) {
   shovelerSpriteFree(screenspaceTextSprite);
   shovelerSpriteFree(textSprite);
   shovelerSamplerFree(textureSampler);
-  shovelerTextureFree(shovelerTextTexture);
+  shovelerTextTextureRendererRelease(textTextureRenderer, shovelerTextTexture);
   shovelerTextTextureRendererFree(textTextureRenderer);
   shovelerFontAtlasTextureFree(fontAtlasTexture);
   shovelerFontAtlasFree(fontAtlas);
@@ -178,8 +178,8 @@ static void shovelerSampleUpdate(ShovelerGame* game, double dt) {
     g_string_set_size(fpsString, 0);
     g_string_append_printf(fpsString, "FPS: %.1f", exponentialAverageFps);
     shovelerSpriteTextSetContent(screenspaceTextSprite, fpsString->str, /* copyContent */ false);
-    screenspaceTextSprite->position =
-        shovelerVector2(10.0f, game->framebuffer->height - 48.0f - 10.0f);
+    shovelerSpriteUpdatePosition(
+        screenspaceTextSprite, shovelerVector2(10.0f, game->framebuffer->height - 48.0f - 10.0f));
 
     for (const char* c = fpsString->str; *c != '\0'; c++) {
       unsigned char character = *((unsigned char*) c);
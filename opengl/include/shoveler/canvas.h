@@ -3,6 +3,7 @@
 
 #include <glib.h>
 #include <shoveler/collider.h>
+#include <shoveler/sprite_batch.h>
 #include <shoveler/types.h>
 #include <stdbool.h> // bool
 
@@ -16,19 +17,81 @@ typedef struct ShovelerRenderStateStruct ShovelerRenderState; // forward declara
 typedef struct ShovelerSceneStruct ShovelerScene; // forward declaration: scene.h
 typedef struct ShovelerSpriteStruct ShovelerSprite; // forward declaration: sprite.h
 
+#define SHOVELER_CANVAS_DEFAULT_CELL_SIZE 1.0f
+#define SHOVELER_CANVAS_MAX_CELLS_PER_SPRITE 256
+#define SHOVELER_CANVAS_MAX_CELLS_PER_QUERY 4096
+
+typedef struct ShovelerCanvasSpriteEntryStruct {
+  ShovelerSprite* sprite;
+  /** position of the sprite in the draw order of its layer */
+  guint64 order;
+  /** whether the sprite is stored in the unbounded list instead of the grid */
+  bool unbounded;
+  /** inclusive range of grid cells the sprite is referenced from if not unbounded */
+  int minCellX;
+  int minCellY;
+  int maxCellX;
+  int maxCellY;
+  /** id of the last query that visited this entry, used to deduplicate across cells */
+  unsigned int lastQueryId;
+} ShovelerCanvasSpriteEntry;
+
+typedef struct ShovelerCanvasCellStruct {
+  gint64 key;
+  /** list of (ShovelerCanvasSpriteEntry *) */
+  GQueue* entries;
+} ShovelerCanvasCell;
+
+typedef struct ShovelerCanvasLayerStruct {
+  /** list of (ShovelerSprite *) in draw order */
+  GQueue* sprites;
+  /** map from (ShovelerSprite *) to (ShovelerCanvasSpriteEntry *) */
+  /* private */ GHashTable* entries;
+  /** map from cell key to (ShovelerCanvasCell *) */
+  /* private */ GHashTable* cells;
+  /** list of (ShovelerCanvasSpriteEntry *) */
+  /* private */ GQueue* unboundedEntries;
+} ShovelerCanvasLayer;
+
+/**
+ * A canvas draws sprites in layers, where each layer keeps a sparse grid of its sprites so that
+ * rendering a region or intersecting the canvas collider only visits sprites close to it. Changes
+ * to sprite positions and sizes are picked up through shovelerSpriteUpdatePosition and
+ * shovelerSpriteUpdateSize.
+ */
 typedef struct ShovelerCanvasStruct {
   ShovelerCollider2 collider;
+  float cellSize;
   int numLayers;
-  /** array of size numLayers, wher each element is a list of (ShovelerSprite *) */
-  GQueue** layers;
+  /** array of size numLayers */
+  ShovelerCanvasLayer* layers;
+  /* private */ guint64 nextOrder;
+  /* private */ unsigned int queryId;
+  /** array of (ShovelerCanvasSpriteEntry *) reused across queries */
+  /* private */ GArray* queryEntries;
+  /** batcher reused across renders */
+  /* private */ ShovelerSpriteBatcher* batcher;
 } ShovelerCanvas;
 
+/** Creates a canvas using a sprite grid with the default cell size. */
 ShovelerCanvas* shovelerCanvasCreate(int numLayers);
+/** Creates a canvas using a sprite grid with the given cell size, which should roughly match the
+ * size of typical sprites. */
+ShovelerCanvas* shovelerCanvasCreateWithCellSize(int numLayers, float cellSize);
 /** Adds a sprite to the canvas, with the caller retaining ownership over it and changes to it being
- * reflected live. Returns the id of the added sprite. */
+ * reflected live. */
 void shovelerCanvasAddSprite(ShovelerCanvas* canvas, int layerId, ShovelerSprite* sprite);
 /** Removes a sprite from a given layer of the canvas. */
 bool shovelerCanvasRemoveSprite(ShovelerCanvas* canvas, int layerId, ShovelerSprite* sprite);
+/** Reindexes a sprite in all layers of the canvas after its bounding box has changed. */
+void shovelerCanvasUpdateSprite(ShovelerCanvas* canvas, ShovelerSprite* sprite);
+/** Writes all sprites of a layer whose bounding box intersects the region into the given array of
+ * (ShovelerSprite *), in draw order. */
+void shovelerCanvasIntersectLayer(
+    ShovelerCanvas* canvas,
+    int layerId,
+    const ShovelerBoundingBox2* region,
+    GArray* outputSprites);
 bool shovelerCanvasRender(
     ShovelerCanvas* canvas,
     ShovelerVector2 regionPosition,
@@ -1,6 +1,7 @@
 #ifndef SHOVELER_DRAWABLE_H
 #define SHOVELER_DRAWABLE_H
 
+#include <shoveler/types.h>
 #include <stdbool.h> // bool
 
 struct ShovelerDrawableStruct;
@@ -11,6 +12,10 @@ typedef void(ShovelerDrawableFreeFunction)(struct ShovelerDrawableStruct* drawab
 typedef struct ShovelerDrawableStruct {
   ShovelerDrawableDrawFunction* draw;
   ShovelerDrawableFreeFunction* free;
+  /** whether boundingBox encloses all drawn vertices, otherwise models using it are never culled */
+  bool bounded;
+  /** object space bounding box of the drawn vertices */
+  ShovelerBoundingBox3 boundingBox;
   void* data;
 } ShovelerDrawable;
 
@@ -0,0 +1,14 @@
+#ifndef SHOVELER_DRAWABLE_GLYPH_INSTANCES_H
+#define SHOVELER_DRAWABLE_GLYPH_INSTANCES_H
+
+#include <shoveler/drawable.h>
+#include <shoveler/glyph_run.h>
+
+/** Creates a quad drawn once per glyph instance, with per-instance data bound to the glyph shader
+ * program attributes. */
+ShovelerDrawable* shovelerDrawableGlyphInstancesCreate();
+/** Uploads the instances to draw on the next draw call, with the caller retaining ownership. */
+bool shovelerDrawableGlyphInstancesUpdate(
+    ShovelerDrawable* glyphInstances, const ShovelerGlyphInstance* instances, int numInstances);
+
+#endif
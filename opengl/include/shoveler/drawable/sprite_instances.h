@@ -0,0 +1,14 @@
+#ifndef SHOVELER_DRAWABLE_SPRITE_INSTANCES_H
+#define SHOVELER_DRAWABLE_SPRITE_INSTANCES_H
+
+#include <shoveler/drawable.h>
+#include <shoveler/sprite_batch.h>
+
+/** Creates a quad drawn once per sprite instance, with per-instance data bound to the sprite
+ * shader program attributes. */
+ShovelerDrawable* shovelerDrawableSpriteInstancesCreate();
+/** Uploads the instances to draw on the next draw call, with the caller retaining ownership. */
+bool shovelerDrawableSpriteInstancesUpdate(
+    ShovelerDrawable* spriteInstances, const ShovelerSpriteInstance* instances, int numInstances);
+
+#endif
@@ -4,16 +4,28 @@
 #include <stdbool.h>
 
 typedef struct ShovelerFontAtlasStruct ShovelerFontAtlas; // forward declaration: font_atlas.h
+typedef struct ShovelerGlyphRunBuilderStruct
+    ShovelerGlyphRunBuilder; // forward declaration: glyph_run.h
 typedef struct ShovelerTextureStruct ShovelerTexture; // forward declaration: texture.h
 
 typedef struct ShovelerFontAtlasTextureStruct {
   ShovelerFontAtlas* fontAtlas;
   unsigned int atlasImageSize;
   ShovelerTexture* texture;
+  /**
+   * builder laying out text with the font atlas, shared by callers batching strings drawn with the
+   * texture, while materials and renderers lay out their own text with separate builders
+   */
+  ShovelerGlyphRunBuilder* glyphRunBuilder;
+  /** number of font atlas glyphs when the texture was last uploaded */
+  /* private */ unsigned int uploadedNumGlyphs;
 } ShovelerFontAtlasTexture;
 
 ShovelerFontAtlasTexture* shovelerFontAtlasTextureCreate(ShovelerFontAtlas* fontAtlas);
-/* Updates the font atlas texture, returning true if a new texture was generated. */
+/**
+ * Uploads glyphs added to the font atlas since the last update, returning true if a new texture
+ * was generated. Does nothing if no glyphs were added.
+ */
 bool shovelerFontAtlasTextureUpdate(ShovelerFontAtlasTexture* fontAtlasTexture);
 void shovelerFontAtlasTextureFree(ShovelerFontAtlasTexture* fontAtlasTexture);
 
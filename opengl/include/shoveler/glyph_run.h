@@ -0,0 +1,115 @@
+/**
+ * The glyph run builder is the CPU side of direct text rendering. It decodes UTF-8 strings, looks
+ * up their glyphs in a font atlas, applies kerning and lays out one quad per glyph, appending the
+ * quads of many strings to one contiguous instance array that can be drawn with a single instanced
+ * draw call sampling the shared font atlas texture.
+ *
+ * The builder doesn't depend on OpenGL, and since glyphs and kerning are looked up through
+ * callbacks, it can be tested and benchmarked with synthetic glyph metrics instead of a font.
+ */
+
+#ifndef SHOVELER_GLYPH_RUN_H
+#define SHOVELER_GLYPH_RUN_H
+
+#include <glib.h>
+#include <shoveler/types.h>
+#include <stdbool.h> // bool
+#include <stdint.h> // uint32_t
+
+/** Code point drawn in place of invalid UTF-8 sequences. */
+#define SHOVELER_GLYPH_RUN_REPLACEMENT_CHARACTER 0xFFFD
+/** Code points below this are looked up once and then served from a table in the builder. */
+#define SHOVELER_GLYPH_RUN_NUM_CACHED_CODE_POINTS 128
+
+typedef struct ShovelerFontAtlasStruct ShovelerFontAtlas; // forward declaration: font_atlas.h
+typedef struct ShovelerFontAtlasGlyphStruct
+    ShovelerFontAtlasGlyph; // forward declaration: font_atlas.h
+
+/** Returns the glyph of a code point, which must stay valid as long as the builder is used. */
+typedef ShovelerFontAtlasGlyph*(ShovelerGlyphRunGetGlyphFunction)(
+    uint32_t codePoint, void* userData);
+/** Returns the kerning in 26.6 fixed point pixels between two glyphs given by their indices. */
+typedef int(ShovelerGlyphRunGetKerningFunction)(
+    unsigned int leftGlyphIndex, unsigned int rightGlyphIndex, void* userData);
+
+/** Per-instance data of a glyph quad, laid out to be uploaded as an instanced vertex buffer. */
+typedef struct ShovelerGlyphInstanceStruct {
+  /** bottom left corner of the quad */
+  ShovelerVector2 corner;
+  ShovelerVector2 size;
+  ShovelerVector4 color;
+  /** glyph rectangle in the font atlas image in pixels, with the size before rotation */
+  int atlasMinX;
+  int atlasMinY;
+  int atlasWidth;
+  int atlasHeight;
+  int atlasIsRotated;
+} ShovelerGlyphInstance;
+
+/** Glyphs of one string added to the builder, with extents relative to the string's origin. */
+typedef struct ShovelerGlyphRunStruct {
+  guint firstInstance;
+  guint numInstances;
+  /** number of code points decoded, including those without a visible glyph */
+  guint numCodePoints;
+  /** right edge of the rightmost glyph */
+  float width;
+  /** extent above the baseline */
+  float heightTop;
+  /** extent below the baseline */
+  float heightBottom;
+} ShovelerGlyphRun;
+
+typedef struct ShovelerGlyphRunBuilderStruct {
+  ShovelerGlyphRunGetGlyphFunction* getGlyph;
+  /** optional, no kerning is applied if NULL */
+  ShovelerGlyphRunGetKerningFunction* getKerning;
+  void* userData;
+  /** font size in pixels the glyph metrics were rendered at */
+  int fontSize;
+  /** array of (ShovelerGlyphRun) in the order they were added */
+  GArray* runs;
+  /** array of (ShovelerGlyphInstance) of all runs */
+  GArray* instances;
+  /* private */ ShovelerFontAtlasGlyph* cachedGlyphs[SHOVELER_GLYPH_RUN_NUM_CACHED_CODE_POINTS];
+} ShovelerGlyphRunBuilder;
+
+ShovelerGlyphRunBuilder* shovelerGlyphRunBuilderCreate(
+    ShovelerGlyphRunGetGlyphFunction* getGlyph,
+    ShovelerGlyphRunGetKerningFunction* getKerning,
+    int fontSize,
+    void* userData);
+/** Creates a builder looking up glyphs and kerning in the passed font atlas and its font. */
+ShovelerGlyphRunBuilder* shovelerGlyphRunBuilderCreateFontAtlas(ShovelerFontAtlas* fontAtlas);
+/** Removes all runs and instances, keeping their storage for the next batch of strings. */
+void shovelerGlyphRunBuilderClear(ShovelerGlyphRunBuilder* builder);
+/**
+ * Appends the glyph quads of a UTF-8 string with its baseline starting at origin, scaled so that
+ * the font size maps to the given size. Returns the index of the added run.
+ */
+guint shovelerGlyphRunBuilderAdd(
+    ShovelerGlyphRunBuilder* builder,
+    const char* text,
+    ShovelerVector2 origin,
+    float size,
+    ShovelerVector4 color);
+void shovelerGlyphRunBuilderFree(ShovelerGlyphRunBuilder* builder);
+
+/**
+ * Decodes the UTF-8 sequence at the start of the string, writing its code point and returning the
+ * number of bytes it spans. Invalid sequences decode to SHOVELER_GLYPH_RUN_REPLACEMENT_CHARACTER
+ * spanning one byte, so that decoding always makes progress. Must not be called at the terminator.
+ */
+int shovelerGlyphRunDecodeUtf8(const char* string, uint32_t* outputCodePoint);
+
+static inline const ShovelerGlyphRun* shovelerGlyphRunBuilderGetRun(
+    ShovelerGlyphRunBuilder* builder, guint index) {
+  return &g_array_index(builder->runs, ShovelerGlyphRun, index);
+}
+
+static inline const ShovelerGlyphInstance* shovelerGlyphRunGetInstances(
+    ShovelerGlyphRunBuilder* builder, const ShovelerGlyphRun* run) {
+  return &g_array_index(builder->instances, ShovelerGlyphInstance, run->firstInstance);
+}
+
+#endif
@@ -12,13 +12,22 @@
 
 struct ShovelerShaderCacheStruct; // forward declaration: shader_cache.h
 
+/**
+ * Resources shared by spot lights, such as the faces of a point light.
+ *
+ * Each spot light keeps its own filtered shadow map, which is only rendered again if the light
+ * moved or the shadow casters inside its frustum changed. The unfiltered depth map is only needed
+ * while filtering and therefore shared.
+ */
 typedef struct {
   struct ShovelerShaderCacheStruct* shaderCache;
   ShovelerSampler* shadowMapSampler;
   ShovelerFramebuffer* depthFramebuffer;
   ShovelerMaterial* depthMaterial;
-  ShovelerFilter* depthFilter;
   ShovelerSceneRenderPassOptions depthRenderPassOptions;
+  int width;
+  int height;
+  GLsizei samples;
   float ambientFactor;
   float exponentialFactor;
   ShovelerVector3 color;
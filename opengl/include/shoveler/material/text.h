@@ -4,8 +4,17 @@
 #include <shoveler/material.h>
 #include <shoveler/types.h>
 
+typedef struct ShovelerCameraStruct ShovelerCamera; // forward declaration: camera.h
 typedef struct ShovelerFontAtlasTextureStruct
     ShovelerFontAtlasTexture; // forward declaration: font_atlas_texture.h
+typedef struct ShovelerGlyphInstanceStruct
+    ShovelerGlyphInstance; // forward declaration: glyph_run.h
+typedef struct ShovelerGlyphRunBuilderStruct
+    ShovelerGlyphRunBuilder; // forward declaration: glyph_run.h
+typedef struct ShovelerLightStruct ShovelerLight; // forward declaration: light.h
+typedef struct ShovelerModelStruct ShovelerModel; // forward declaration: model.h
+typedef struct ShovelerRenderStateStruct ShovelerRenderState; // forward declaration: render_state.h
+typedef struct ShovelerSceneStruct ShovelerScene; // forward declaration: scene.h
 typedef struct ShovelerShaderCacheStruct ShovelerShaderCache; // forward declaration: shader_cache.h
 
 ShovelerMaterial* shovelerMaterialTextCreate(ShovelerShaderCache* shaderCache, bool screenspace);
@@ -16,5 +25,22 @@ void shovelerMaterialTextSetActiveFontAtlasTexture(
 void shovelerMaterialTextSetActiveText(
     ShovelerMaterial* material, const char* text, ShovelerVector2 corner, float size);
 void shovelerMaterialTextSetActiveColor(ShovelerMaterial* material, ShovelerVector4 color);
+/**
+ * Returns the glyph run builder of the active font atlas texture, which can be used to batch many
+ * strings into the instances of a single shovelerMaterialTextRenderGlyphs call. Rendering the
+ * material's active text doesn't touch it.
+ */
+ShovelerGlyphRunBuilder* shovelerMaterialTextGetGlyphRunBuilder(ShovelerMaterial* material);
+/** Renders all given glyph instances of the active font atlas texture with a single instanced
+ * draw call, using the region previously set with shovelerMaterialTextSetActiveRegion. */
+bool shovelerMaterialTextRenderGlyphs(
+    ShovelerMaterial* material,
+    const ShovelerGlyphInstance* instances,
+    int numInstances,
+    ShovelerScene* scene,
+    ShovelerCamera* camera,
+    ShovelerLight* light,
+    ShovelerModel* model,
+    ShovelerRenderState* renderState);
 
 #endif
@@ -4,9 +4,16 @@
 #include <shoveler/types.h>
 #include <stdbool.h> // bool
 
+typedef struct ShovelerCameraStruct ShovelerCamera; // forward declaration: camera.h
+typedef struct ShovelerLightStruct ShovelerLight; // forward declaration: light.h
 typedef struct ShovelerMaterialStruct ShovelerMaterial; // forward declaration: material.h
+typedef struct ShovelerModelStruct ShovelerModel; // forward declaration: model.h
+typedef struct ShovelerRenderStateStruct ShovelerRenderState; // forward declaration: render_state.h
 typedef struct ShovelerSamplerStruct ShovelerSampler; // forward delcaration: sampler.h
+typedef struct ShovelerSceneStruct ShovelerScene; // forward declaration: scene.h
 typedef struct ShovelerShaderCacheStruct ShovelerShaderCache; // forward declaration: shader_cache.h
+typedef struct ShovelerSpriteInstanceStruct
+    ShovelerSpriteInstance; // forward declaration: sprite_batch.h
 typedef struct ShovelerTextureStruct ShovelerTexture; // forward delcaration: texture.h
 
 typedef enum {
@@ -24,5 +31,18 @@ void shovelerMaterialTextureSpriteSetActiveSprite(
 void shovelerMaterialTextureSpriteSetColor(ShovelerMaterial* material, ShovelerVector4 color);
 void shovelerMaterialTextureSpriteSetActiveTexture(
     ShovelerMaterial* material, ShovelerTexture* texture, ShovelerSampler* sampler);
+/** Renders all given sprite instances of the texture with a single instanced draw call, using the
+ * region and color previously set. Instance tiles are ignored. */
+bool shovelerMaterialTextureSpriteRenderInstances(
+    ShovelerMaterial* material,
+    ShovelerTexture* texture,
+    ShovelerSampler* sampler,
+    const ShovelerSpriteInstance* instances,
+    int numInstances,
+    ShovelerScene* scene,
+    ShovelerCamera* camera,
+    ShovelerLight* light,
+    ShovelerModel* model,
+    ShovelerRenderState* renderState);
 
 #endif
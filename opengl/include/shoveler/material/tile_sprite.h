@@ -4,8 +4,15 @@
 #include <shoveler/types.h>
 #include <stdbool.h> // bool
 
+typedef struct ShovelerCameraStruct ShovelerCamera; // forward declaration: camera.h
+typedef struct ShovelerLightStruct ShovelerLight; // forward declaration: light.h
 typedef struct ShovelerMaterialStruct ShovelerMaterial; // forward declaration: material.h
+typedef struct ShovelerModelStruct ShovelerModel; // forward declaration: model.h
+typedef struct ShovelerRenderStateStruct ShovelerRenderState; // forward declaration: render_state.h
+typedef struct ShovelerSceneStruct ShovelerScene; // forward declaration: scene.h
 typedef struct ShovelerShaderCacheStruct ShovelerShaderCache; // forward declaration: shader_cache.h
+typedef struct ShovelerSpriteInstanceStruct
+    ShovelerSpriteInstance; // forward declaration: sprite_batch.h
 typedef struct ShovelerSpriteTileStruct ShovelerSpriteTile; // forward declaration: sprite/tile.h
 typedef struct ShovelerTilesetStruct ShovelerTileset; // forward delcaration: tileset.h
 
@@ -21,5 +28,17 @@ void shovelerMaterialTileSpriteSetActiveSprite(
     ShovelerMaterial* material, ShovelerVector2 position, ShovelerVector2 size);
 void shovelerMaterialTileSpriteSetActive(
     ShovelerMaterial* material, const ShovelerSpriteTile* spriteTile);
+/** Renders all given sprite instances of the tileset with a single instanced draw call, using the
+ * region previously set with shovelerMaterialTileSpriteSetActiveRegion. */
+bool shovelerMaterialTileSpriteRenderInstances(
+    ShovelerMaterial* material,
+    ShovelerTileset* tileset,
+    const ShovelerSpriteInstance* instances,
+    int numInstances,
+    ShovelerScene* scene,
+    ShovelerCamera* camera,
+    ShovelerLight* light,
+    ShovelerModel* model,
+    ShovelerRenderState* renderState);
 
 #endif
@@ -19,6 +19,13 @@ typedef struct ShovelerModelStruct {
   ShovelerVector3 scale;
   ShovelerMatrix transformation;
   ShovelerMatrix normalTransformation;
+  /** world space bounding box of the drawable, updated by shovelerModelUpdateTransformation */
+  ShovelerBoundingBox3 boundingBox;
+  /**
+   * changes whenever the transformation is updated, and is never shared by two models, so that
+   * renderers can detect that output depending on the model is out of date
+   */
+  guint64 transformationVersion;
   bool visible;
   bool emitter;
   bool castsShadow;
@@ -0,0 +1,91 @@
+/**
+ * A recording OpenGL backend that replaces the glad function pointers with stubs, so that the
+ * rendering code can run headless without a window or GPU.
+ *
+ * The stubs don't render anything, but hand out object names, report shaders and framebuffers as
+ * successfully compiled and complete, assign locations to the uniforms declared in attached shader
+ * sources, and track the bound state to count draw calls, state changes and uploads. This makes
+ * it possible to benchmark and test the CPU side of rendering a frame.
+ *
+ * Only one recorder can be installed at a time, and it must only be used from a single thread.
+ */
+
+#ifndef SHOVELER_OPENGL_RECORDER_H
+#define SHOVELER_OPENGL_RECORDER_H
+
+#include <glad/glad.h>
+#include <glib.h>
+#include <stdbool.h> // bool
+
+#define SHOVELER_OPENGL_RECORDER_NUM_TEXTURE_UNITS 32
+
+typedef struct {
+  /** number of calls to any recorded function */
+  gint64 numCalls;
+  /** number of draw calls, including instanced ones */
+  gint64 numDrawCalls;
+  /** number of calls changing bound objects, capabilities or fixed function state */
+  gint64 numStateChanges;
+  /** number of state changes that set the state to the value it already had */
+  gint64 numRedundantStateChanges;
+  /** number of uniform upload calls */
+  gint64 numUniformUploads;
+  /** number of bytes uploaded to buffers, textures and uniforms */
+  gint64 numBytesUploaded;
+} ShovelerOpenGLRecorderStats;
+
+/** Draw call recorded while draw recording is enabled, with the state it was issued in. */
+typedef struct {
+  GLuint program;
+  bool depthTest;
+  GLenum depthFunction;
+  /** 1 for draw calls that aren't instanced */
+  GLsizei numInstances;
+} ShovelerOpenGLRecorderDraw;
+
+typedef struct ShovelerOpenGLRecorderStruct {
+  ShovelerOpenGLRecorderStats stats;
+  /** if true, draw calls are appended to draws until the stats are reset, disabled by default */
+  bool recordDraws;
+  /** array of (ShovelerOpenGLRecorderDraw) */
+  GArray* draws;
+  /* private */ GLuint nextName;
+  /* private */ GLuint program;
+  /* private */ GLuint vertexArray;
+  /* private */ GLuint framebuffer;
+  /** map from target to bound buffer */
+  /* private */ GHashTable* buffers;
+  /* private */ GLenum activeTexture;
+  /* private */ GLuint textures[SHOVELER_OPENGL_RECORDER_NUM_TEXTURE_UNITS];
+  /* private */ GLuint samplers[SHOVELER_OPENGL_RECORDER_NUM_TEXTURE_UNITS];
+  /** set of enabled capabilities */
+  /* private */ GHashTable* capabilities;
+  /* private */ GLenum blendSourceFactor;
+  /* private */ GLenum blendDestinationFactor;
+  /* private */ GLenum depthFunction;
+  /* private */ GLboolean depthMask;
+  /* private */ GLenum polygonMode;
+  /* private */ GLint viewport[4];
+  /** map from shader to its (char *) source */
+  /* private */ GHashTable* shaderSources;
+  /** map from program to a map from uniform name to location, filled from attached shaders */
+  /* private */ GHashTable* programUniformLocations;
+  /** map from program to a (GString *) concatenating the sources of its attached shaders */
+  /* private */ GHashTable* programSources;
+} ShovelerOpenGLRecorder;
+
+/**
+ * Creates a recorder and binds the glad function pointers to it, remembering the previous ones.
+ * Returns NULL if another recorder is already installed.
+ */
+ShovelerOpenGLRecorder* shovelerOpenGLRecorderCreate();
+void shovelerOpenGLRecorderResetStats(ShovelerOpenGLRecorder* recorder);
+void shovelerOpenGLRecorderLogStats(
+    ShovelerOpenGLRecorder* recorder, const char* label, int numFrames);
+/** Returns the concatenated sources of all shaders attached to a program, or NULL if unknown. */
+const char* shovelerOpenGLRecorderGetProgramSource(
+    ShovelerOpenGLRecorder* recorder, GLuint program);
+/** Frees the recorder and restores the glad function pointers it replaced. */
+void shovelerOpenGLRecorderFree(ShovelerOpenGLRecorder* recorder);
+
+#endif
@@ -9,6 +9,8 @@ typedef struct ShovelerSamplerStruct {
 } ShovelerSampler;
 
 ShovelerSampler* shovelerSamplerCreate(bool interpolate, bool useMipmaps, bool clamp);
+/** Returns a counter that changes whenever a sampler is freed, invalidating tracked bindings. */
+unsigned int shovelerSamplerGetBindingGeneration();
 bool shovelerSamplerUse(ShovelerSampler* sampler, GLuint unit);
 void shovelerSamplerFree(ShovelerSampler* shader);
 
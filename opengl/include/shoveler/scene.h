@@ -2,6 +2,7 @@
 #define SHOVELER_SCENE_H
 
 #include <glib.h>
+#include <shoveler/bounding_volumes.h>
 #include <shoveler/render_state.h>
 #include <shoveler/types.h>
 #include <stdbool.h> // bool
@@ -15,6 +16,51 @@ typedef struct ShovelerShaderStruct ShovelerShader; // forward declaration: shad
 typedef struct ShovelerShaderCacheStruct ShovelerShaderCache; // forward declaration: shader_cache.h
 typedef struct ShovelerUniformMapStruct ShovelerUniformMap; // forward declaration: uniform_map.h
 
+/** Number of render queues, one per combination of the emitter and screenspace model flags. */
+#define SHOVELER_SCENE_NUM_RENDER_QUEUES 4
+
+typedef enum {
+  SHOVELER_SCENE_RENDER_PASS_TYPE_OCCLUDED,
+  SHOVELER_SCENE_RENDER_PASS_TYPE_SHADOW_MAP,
+  SHOVELER_SCENE_RENDER_PASS_TYPE_ADDITIVE_LIGHT,
+  SHOVELER_SCENE_RENDER_PASS_TYPE_EMITTERS,
+  SHOVELER_SCENE_RENDER_PASS_TYPE_SCREENSPACE,
+  SHOVELER_SCENE_RENDER_PASS_TYPE_NUM,
+} ShovelerSceneRenderPassType;
+
+typedef struct {
+  /** number of render passes of this type */
+  gint64 numPasses;
+  /** number of render passes skipped because the output of an earlier one was still up to date */
+  gint64 numSkippedPasses;
+  /** number of models rendered by these passes */
+  gint64 numModels;
+  /** number of models skipped because their bounding box was outside the camera frustum */
+  gint64 numCulledModels;
+  /** number of glUseProgram calls made */
+  gint64 numProgramChanges;
+  /** number of glUseProgram calls avoided because the program was already in use */
+  gint64 numSkippedProgramChanges;
+  /** number of textures bound */
+  gint64 numTextureBinds;
+  /** number of texture binds avoided because the texture was already bound to its unit */
+  gint64 numSkippedTextureBinds;
+} ShovelerSceneRenderPassStats;
+
+/**
+ * Entry of a render queue, which are sorted by key so that models sharing a program, material and
+ * textures are rendered next to each other, and otherwise front to back.
+ *
+ * The key packs, from most to least significant 16 bits: the program, bits of the material
+ * address, the texture name and the quantized distance to the camera.
+ */
+typedef struct {
+  guint64 key;
+  ShovelerModel* model;
+  /** index of the model's bounding box in the scene's bounding volumes */
+  guint boundingVolumeIndex;
+} ShovelerSceneRenderQueueEntry;
+
 typedef struct ShovelerSceneStruct {
   ShovelerShaderCache* shaderCache;
   ShovelerUniformMap* uniforms;
@@ -23,9 +69,19 @@ typedef struct ShovelerSceneStruct {
   /* private */ ShovelerVector2 activeFramebufferSize;
   GHashTable* lights;
   GHashTable* models;
+  /** arrays of ShovelerSceneRenderQueueEntry for visible models, indexed by getRenderQueueIndex */
+  /* private */ GArray* renderQueues[SHOVELER_SCENE_NUM_RENDER_QUEUES];
+  /** whether the render queues were built for the frame currently being rendered */
+  /* private */ bool renderQueuesValid;
+  /** bounding boxes of the models in the render queues, in queue order */
+  /* private */ ShovelerBoundingVolumes* boundingVolumes;
+  /** map from (ShovelerCamera *) to (GArray *) of guint32 visibility bitset words */
+  /* private */ GHashTable* cameraVisibilities;
+  ShovelerSceneRenderPassStats renderPassStats[SHOVELER_SCENE_RENDER_PASS_TYPE_NUM];
 } ShovelerScene;
 
 typedef struct {
+  ShovelerSceneRenderPassType type;
   ShovelerMaterial* overrideMaterial;
   bool emitters;
   bool screenspace;
@@ -39,17 +95,35 @@ bool shovelerSceneAddLight(ShovelerScene* scene, ShovelerLight* light);
 bool shovelerSceneRemoveLight(ShovelerScene* scene, ShovelerLight* light);
 bool shovelerSceneAddModel(ShovelerScene* scene, ShovelerModel* model);
 bool shovelerSceneRemoveModel(ShovelerScene* scene, ShovelerModel* model);
+/**
+ * Renders the visible models matching the pass options in render queue order. Within a frame, the
+ * render queues are built once by shovelerSceneRenderFrame and shared by all passes, while passes
+ * rendered on their own rebuild them first.
+ *
+ * Unless the pass is screenspace, models with bounding boxes outside the camera frustum are
+ * skipped. All models are culled against a camera at most once per render queue build, so that
+ * e.g. the shadow map passes of a light share its culling results.
+ */
 int shovelerSceneRenderPass(
     ShovelerScene* scene,
     ShovelerCamera* camera,
     ShovelerLight* light,
     ShovelerSceneRenderPassOptions options,
     ShovelerRenderState* renderState);
+/**
+ * Hashes the visible shadow casting models inside the camera frustum together with their drawables
+ * and transformation versions, such that the hash changes whenever a shadow map pass rendered with
+ * the camera would produce a different result. Like render passes, this rebuilds the render queues
+ * if called outside of shovelerSceneRenderFrame, and shares the culling results with later passes.
+ */
+guint64 shovelerSceneHashShadowCasters(ShovelerScene* scene, ShovelerCamera* camera);
 int shovelerSceneRenderFrame(
     ShovelerScene* scene,
     ShovelerCamera* camera,
     ShovelerFramebuffer* framebuffer,
     ShovelerRenderState* renderState);
+void shovelerSceneResetRenderPassStats(ShovelerScene* scene);
+void shovelerSceneLogRenderPassStats(ShovelerScene* scene, int numFrames);
 /** Generates a shader, where shaders for calls to this with the same arguments might be cached. */
 ShovelerShader* shovelerSceneGenerateShader(
     ShovelerScene* scene,
@@ -25,8 +25,8 @@ typedef struct ShovelerShaderKeyStruct {
 typedef struct ShovelerShaderStruct {
   ShovelerShaderKey key;
   ShovelerMaterial* material;
-  /** map from (char *) to (ShovelerUniformAttachment *) */
-  GHashTable* attachments;
+  /** array of (ShovelerUniformAttachment) sorted by location */
+  GArray* attachments;
 } ShovelerShader;
 
 /** Computes a hash from a shader key that can be used to add shaders to a hash table. */
@@ -38,6 +38,10 @@ gboolean shovelerShaderKeyEqual(
 ShovelerShader* shovelerShaderCreate(ShovelerShaderKey shaderKey, ShovelerMaterial* material);
 bool shovelerShaderAttachUniform(
     ShovelerShader* shader, const char* name, ShovelerUniform* uniform);
+/**
+ * Uses the shader's program and uploads its attached uniforms, skipping uniforms whose values were
+ * already uploaded to the program if the material has a shader cache.
+ */
 bool shovelerShaderUse(ShovelerShader* shader);
 void shovelerShaderFree(ShovelerShader* shader);
 
@@ -1,7 +1,9 @@
 #ifndef SHOVELER_SHADER_CACHE_H
 #define SHOVELER_SHADER_CACHE_H
 
+#include <glad/glad.h>
 #include <glib.h>
+#include <shoveler/uniform.h>
 #include <stdbool.h>
 
 typedef struct ShovelerCameraStruct ShovelerCamera; // forward declaration: camera.h
@@ -12,25 +14,91 @@ typedef struct ShovelerSceneStruct ShovelerScene; // forward declaration: scene.
 typedef struct ShovelerShaderStruct ShovelerShader; // forward declaration: shader.h
 typedef struct ShovelerShaderKeyStruct ShovelerShaderKey; // forward declaration: shader.h
 
-typedef struct ShovelerShaderCacheStruct {
-  /** map from (ShovelerShaderKey *) to (ShovelerShader *) */
-  GHashTable* shaders;
-  /** map from (ShovelerScene *) to set of (ShovelerShaderKey *) */
-  GHashTable* sceneShaderKeys;
-  /** map from (ShovelerCamera *) to set of (ShovelerShaderKey *) */
-  GHashTable* cameraShaderKeys;
-  /** map from (ShovelerLight *) to set of (ShovelerShaderKey *) */
-  GHashTable* lightShaderKeys;
-  /** map from (ShovelerModel *) to set of (ShovelerShaderKey *) */
-  GHashTable* modelShaderKeys;
-  /** map from (ShovelerMaterial *) to set of (ShovelerShaderKey *) */
-  GHashTable* materialShaderKeys;
-  /** map from (void *) to set of (ShovelerShaderKey *) */
-  GHashTable* userDataShaderKeys;
-} ShovelerShaderCache;
+/**
+ * Component of a shader key. Shaders can be invalidated by the object of any component, which only
+ * affects keys having that object in the same component.
+ */
+typedef enum {
+  SHOVELER_SHADER_CACHE_KEY_COMPONENT_SCENE,
+  SHOVELER_SHADER_CACHE_KEY_COMPONENT_CAMERA,
+  SHOVELER_SHADER_CACHE_KEY_COMPONENT_LIGHT,
+  SHOVELER_SHADER_CACHE_KEY_COMPONENT_MODEL,
+  SHOVELER_SHADER_CACHE_KEY_COMPONENT_MATERIAL,
+  SHOVELER_SHADER_CACHE_KEY_COMPONENT_USER_DATA,
+  SHOVELER_SHADER_CACHE_KEY_COMPONENT_NUM,
+} ShovelerShaderCacheKeyComponent;
+
+struct ShovelerShaderCacheEntryStruct;
+
+/** Object used as a component of cached shader keys, linking the entries of all those keys. */
+typedef struct ShovelerShaderCacheObjectStruct {
+  void* object;
+  ShovelerShaderCacheKeyComponent component;
+  /** incremented when the object is invalidated, making all entries of earlier ones stale */
+  guint generation;
+  /** head of the list of entries linked through their links for this component */
+  struct ShovelerShaderCacheEntryStruct* entries;
+  /** whether the object is queued to have its stale entries removed */
+  bool invalidated;
+  struct ShovelerShaderCacheObjectStruct* nextInvalidated;
+} ShovelerShaderCacheObject;
+
+typedef struct ShovelerShaderCacheEntryStruct {
+  ShovelerShader* shader;
+  guint hash;
+  /** objects of the non-NULL key components */
+  ShovelerShaderCacheObject* objects[SHOVELER_SHADER_CACHE_KEY_COMPONENT_NUM];
+  /** generations of the objects when the entry was inserted */
+  guint generations[SHOVELER_SHADER_CACHE_KEY_COMPONENT_NUM];
+  struct ShovelerShaderCacheEntryStruct* next[SHOVELER_SHADER_CACHE_KEY_COMPONENT_NUM];
+  struct ShovelerShaderCacheEntryStruct* previous[SHOVELER_SHADER_CACHE_KEY_COMPONENT_NUM];
+} ShovelerShaderCacheEntry;
+
+typedef struct {
+  guint hash;
+  /** copied from the entry, so that lookups hitting the slot don't need to access the entry */
+  ShovelerShader* shader;
+  /** NULL if the slot is empty */
+  ShovelerShaderCacheEntry* entry;
+} ShovelerShaderCacheSlot;
 
 typedef void(ShovelerShaderCacheFreeShaderFunction)(void* shaderPointer);
 
+/**
+ * Cache of shaders by key.
+ *
+ * Shaders are stored in an open addressing table probed linearly, so that a lookup usually only
+ * touches one slot and the key of the shader found in it. Invalidating an object only increments
+ * its generation and queues it, after which its stale entries are removed one object at a time by
+ * later lookups and inserts. Until then, lookups of stale keys miss. Shaders of invalidated objects
+ * can therefore be freed after the objects themselves, so a custom free function must not access
+ * them.
+ */
+typedef struct ShovelerShaderCacheStruct {
+  /* private */ ShovelerShaderCacheFreeShaderFunction* freeShader;
+  /** power of two sized array of slots */
+  /* private */ ShovelerShaderCacheSlot* slots;
+  /* private */ guint numSlots;
+  guint numEntries;
+  /** number of slots whose entry was removed, which still need to be probed past */
+  /* private */ guint numTombstones;
+  /** maps from object to (ShovelerShaderCacheObject *), indexed by key component */
+  /* private */ GHashTable* objects[SHOVELER_SHADER_CACHE_KEY_COMPONENT_NUM];
+  /** queue of invalidated objects whose stale entries weren't removed yet */
+  /* private */ ShovelerShaderCacheObject* firstInvalidated;
+  /* private */ ShovelerShaderCacheObject* lastInvalidated;
+  /** map from (GLuint) program to (GArray *) of ShovelerUniformUploadedValue indexed by location */
+  GHashTable* programUploadedUniformValues;
+  ShovelerUniformUploadStats uniformUploadStats;
+  /** program last passed to glUseProgram by a shader, or zero if unknown */
+  GLuint usedProgram;
+  /** number of glUseProgram calls made */
+  gint64 numProgramChanges;
+  /** number of glUseProgram calls skipped because the program was already in use */
+  gint64 numSkippedProgramChanges;
+  ShovelerUniformTextureBindings textureBindings;
+} ShovelerShaderCache;
+
 ShovelerShaderCache* shovelerShaderCacheCreate();
 ShovelerShaderCache* shovelerShaderCacheCreateWithCustomFree(
     ShovelerShaderCacheFreeShaderFunction* freeShader);
@@ -45,6 +113,17 @@ void shovelerShaderCacheInvalidateLight(ShovelerShaderCache* cache, ShovelerLigh
 void shovelerShaderCacheInvalidateModel(ShovelerShaderCache* cache, ShovelerModel* model);
 void shovelerShaderCacheInvalidateMaterial(ShovelerShaderCache* cache, ShovelerMaterial* material);
 void shovelerShaderCacheInvalidateUserData(ShovelerShaderCache* cache, void* userData);
+/**
+ * Returns the values last uploaded to the uniforms of a program, which are shared by all shaders
+ * using it. The returned array is grown to hold at least numLocations locations.
+ */
+GArray* shovelerShaderCacheGetUploadedUniformValues(
+    ShovelerShaderCache* cache, GLuint program, GLint numLocations);
+/**
+ * Forgets the uniform values uploaded to a program and whether it is in use, e.g. because it was
+ * deleted.
+ */
+void shovelerShaderCacheInvalidateProgram(ShovelerShaderCache* cache, GLuint program);
 void shovelerShaderCacheFree(ShovelerShaderCache* cache);
 
 #endif
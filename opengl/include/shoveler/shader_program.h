@@ -7,7 +7,15 @@
 typedef enum {
   SHOVELER_SHADER_PROGRAM_ATTRIBUTE_POSITION = 0,
   SHOVELER_SHADER_PROGRAM_ATTRIBUTE_NORMAL = 1,
-  SHOVELER_SHADER_PROGRAM_ATTRIBUTE_UV = 2
+  SHOVELER_SHADER_PROGRAM_ATTRIBUTE_UV = 2,
+  SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_POSITION = 3,
+  SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_SIZE = 4,
+  SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_TILE = 5,
+  SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_CORNER = 6,
+  SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_SIZE = 7,
+  SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_COLOR = 8,
+  SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_ATLAS_REGION = 9,
+  SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_ATLAS_IS_ROTATED = 10
 } ShovelerShaderProgramAttribute;
 
 GLuint shovelerShaderProgramCompileFromString(const char* source, GLenum type);
@@ -0,0 +1,13 @@
+#ifndef SHOVELER_SHADER_PROGRAM_SPRITE_INSTANCE_VERTEX_H
+#define SHOVELER_SHADER_PROGRAM_SPRITE_INSTANCE_VERTEX_H
+
+#include <glad/glad.h>
+#include <stdbool.h> // bool
+
+/**
+ * Compiles the vertex shader of instanced sprite quads drawn from the sprite instances drawable,
+ * passing each fragment's spriteUv and its instance's tile as fragmentTile.
+ */
+GLuint shovelerShaderProgramSpriteInstanceVertexCreate(bool screenspace);
+
+#endif
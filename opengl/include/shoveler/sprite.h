@@ -2,9 +2,11 @@
 #define SHOVELER_SPRITE_H
 
 #include <shoveler/collider.h>
+#include <shoveler/sprite_batch.h>
 #include <shoveler/types.h>
 
 typedef struct ShovelerCameraStruct ShovelerCamera; // forward declaration: camera.h
+typedef struct ShovelerCanvasStruct ShovelerCanvas; // forward declaration: canvas.h
 typedef struct ShovelerLightStruct ShovelerLight; // forward declaration: light.h
 typedef struct ShovelerMaterialStruct ShovelerMaterial; // forward declaration: material.h
 typedef struct ShovelerModelStruct ShovelerModel; // forward declaration: model.h
@@ -21,6 +23,24 @@ typedef bool(ShovelerSpriteRenderFunction)(
     ShovelerLight* light,
     ShovelerModel* model,
     ShovelerRenderState* renderState);
+/** Writes the batch key and the tile of the sprite, whose position and size are filled in by the
+ * caller. Returns false if the sprite can't currently be batched. */
+typedef bool(ShovelerSpriteBatchFunction)(
+    ShovelerSprite* sprite,
+    ShovelerSpriteBatchKey* outputKey,
+    ShovelerSpriteInstance* outputInstance);
+/** Renders a batch of instances whose first sprite is passed, all sharing the same batch key. */
+typedef bool(ShovelerSpriteRenderBatchFunction)(
+    ShovelerSprite* firstSprite,
+    const ShovelerSpriteInstance* instances,
+    int numInstances,
+    ShovelerVector2 regionPosition,
+    ShovelerVector2 regionSize,
+    ShovelerScene* scene,
+    ShovelerCamera* camera,
+    ShovelerLight* light,
+    ShovelerModel* model,
+    ShovelerRenderState* renderState);
 typedef void(ShovelerSpriteFreeFunction)(ShovelerSprite* sprite);
 
 typedef struct ShovelerSpriteStruct {
@@ -28,8 +48,13 @@ typedef struct ShovelerSpriteStruct {
   ShovelerVector2 size;
   ShovelerCollider2 collider;
   bool enableCollider;
+  /** canvas the sprite was added to, which is notified when its bounding box changes */
+  ShovelerCanvas* canvas;
   ShovelerMaterial* material;
   ShovelerSpriteRenderFunction* render;
+  /** optional, allows the canvas to draw the sprite instanced together with similar sprites */
+  ShovelerSpriteBatchFunction* batch;
+  ShovelerSpriteRenderBatchFunction* renderBatch;
   ShovelerSpriteFreeFunction* free;
   void* data;
 } ShovelerSprite;
@@ -38,6 +63,7 @@ void shovelerSpriteInit(
     ShovelerSprite* sprite,
     ShovelerMaterial* material,
     ShovelerCollider2IntersectFunction* interesect,
+    ShovelerCollider2SweepFunction* sweep,
     ShovelerSpriteRenderFunction* render,
     ShovelerSpriteFreeFunction* free,
     void* data);
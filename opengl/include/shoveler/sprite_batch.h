@@ -0,0 +1,96 @@
+/**
+ * The sprite batcher is the CPU side of instanced sprite rendering. It collects the visible sprites
+ * of a frame layer by layer and groups those sharing a material and resource (e.g. a tileset or a
+ * texture and its sampler) into batches whose instances are packed into one contiguous array, ready
+ * to be uploaded and drawn with a single instanced draw call per batch.
+ *
+ * Since sprites are blended in draw order, a sprite only joins an earlier batch of its layer if it
+ * doesn't overlap any sprite of a batch started after it. Batches never span multiple layers.
+ *
+ * The batcher doesn't depend on OpenGL, so it can be tested and benchmarked without a GPU.
+ */
+
+#ifndef SHOVELER_SPRITE_BATCH_H
+#define SHOVELER_SPRITE_BATCH_H
+
+#include <glib.h>
+#include <shoveler/types.h>
+#include <stdbool.h> // bool
+
+/** Maximum number of batches of the current layer a sprite is checked against before starting a
+ * new batch, bounding the batching cost for layers with many different materials. */
+#define SHOVELER_SPRITE_BATCHER_MAX_LOOKBACK 16
+
+/** Per-instance data of a sprite, laid out to be uploaded as an instanced vertex buffer. */
+typedef struct ShovelerSpriteInstanceStruct {
+  ShovelerVector2 position;
+  ShovelerVector2 size;
+  int tilesetColumn;
+  int tilesetRow;
+} ShovelerSpriteInstance;
+
+/** Sprites can only be batched together if all fields of their keys are equal. */
+typedef struct ShovelerSpriteBatchKeyStruct {
+  const void* material;
+  const void* resource;
+  /** sampler the resource is read with, or NULL if the resource implies it (e.g. a tileset) */
+  const void* sampler;
+} ShovelerSpriteBatchKey;
+
+typedef struct ShovelerSpriteBatchStruct {
+  ShovelerSpriteBatchKey key;
+  /** whether sprites of this batch can be drawn instanced, otherwise it contains a single sprite */
+  bool batchable;
+  int layerId;
+  /** union of the bounding boxes of all instances in the batch */
+  ShovelerBoundingBox2 boundingBox;
+  /** user data passed when adding the first sprite of the batch */
+  void* userData;
+  guint firstInstance;
+  guint numInstances;
+} ShovelerSpriteBatch;
+
+typedef struct ShovelerSpriteBatcherStruct {
+  ShovelerBoundingBox2 region;
+  int layerId;
+  /** index of the first batch of the current layer */
+  guint layerFirstBatch;
+  /** array of (ShovelerSpriteBatch) in draw order */
+  GArray* batches;
+  /** array of (ShovelerSpriteInstance) packed by batch, valid after shovelerSpriteBatcherEnd */
+  GArray* instances;
+  /** array of (guint) batch index for each staged instance */
+  /* private */ GArray* stagedBatchIndices;
+  /** array of (ShovelerSpriteInstance) in the order they were added */
+  /* private */ GArray* stagedInstances;
+} ShovelerSpriteBatcher;
+
+ShovelerSpriteBatcher* shovelerSpriteBatcherCreate();
+/** Starts collecting a new frame, culling all sprites that don't intersect the region. */
+void shovelerSpriteBatcherBegin(ShovelerSpriteBatcher* batcher, const ShovelerBoundingBox2* region);
+/** Starts a new layer, with all sprites added afterwards drawn after those of previous layers. */
+void shovelerSpriteBatcherBeginLayer(ShovelerSpriteBatcher* batcher, int layerId);
+/** Adds a sprite to the current layer, returning false if it was culled. Passing a NULL key means
+ * the sprite can't be batched and will be placed in its own batch. */
+bool shovelerSpriteBatcherAdd(
+    ShovelerSpriteBatcher* batcher,
+    const ShovelerSpriteBatchKey* key,
+    const ShovelerSpriteInstance* instance,
+    void* userData);
+/** Packs the instances of all batches into one contiguous array. */
+void shovelerSpriteBatcherEnd(ShovelerSpriteBatcher* batcher);
+void shovelerSpriteBatcherFree(ShovelerSpriteBatcher* batcher);
+
+static inline ShovelerBoundingBox2 shovelerSpriteInstanceGetBoundingBox(
+    const ShovelerSpriteInstance* instance) {
+  return shovelerBoundingBox2(
+      shovelerVector2LinearCombination(1.0f, instance->position, -0.5f, instance->size),
+      shovelerVector2LinearCombination(1.0f, instance->position, 0.5f, instance->size));
+}
+
+static inline const ShovelerSpriteInstance* shovelerSpriteBatchGetInstances(
+    ShovelerSpriteBatcher* batcher, const ShovelerSpriteBatch* batch) {
+  return &g_array_index(batcher->instances, ShovelerSpriteInstance, batch->firstInstance);
+}
+
+#endif
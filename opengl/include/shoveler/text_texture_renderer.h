@@ -17,11 +17,54 @@ typedef struct ShovelerShaderCacheStruct ShovelerShaderCache; // forward declara
 typedef struct ShovelerSpriteStruct ShovelerSprite; // forward declaration: sprite.h
 typedef struct ShovelerTextureStruct ShovelerTexture; // forward declaration: texture.h
 
+/** Default number of text layouts kept by the layout cache. */
+#define SHOVELER_TEXT_TEXTURE_RENDERER_DEFAULT_LAYOUT_CACHE_SIZE 256
+/** Default number of text textures kept after they were released by all users. */
+#define SHOVELER_TEXT_TEXTURE_RENDERER_DEFAULT_TEXTURE_CACHE_SIZE 32
+
+typedef struct ShovelerFramebufferStruct ShovelerFramebuffer; // forward declaration: framebuffer.h
+typedef struct ShovelerGlyphRunBuilderStruct
+    ShovelerGlyphRunBuilder; // forward declaration: glyph_run.h
+
+/**
+ * Measured extents of a text rendered with a font atlas. The glyph quads aren't kept, since the
+ * text material lays out the glyphs again when drawing.
+ */
+typedef struct ShovelerTextLayoutStruct {
+  char* text;
+  float width;
+  /** extent above the baseline */
+  float heightTop;
+  /** extent below the baseline */
+  float heightBottom;
+  /** links of the least recently used list of the layout cache, the head being the most recent */
+  /* private */ struct ShovelerTextLayoutStruct* previous;
+  /* private */ struct ShovelerTextLayoutStruct* next;
+} ShovelerTextLayout;
+
+/** Cached texture of a text, which is shared by all users rendering the same text. */
 typedef struct ShovelerTextTextureStruct {
   char* text;
   ShovelerTexture* texture;
+  /** framebuffer the texture was rendered with, kept to render other text of the same size */
+  /* private */ ShovelerFramebuffer* framebuffer;
+  /** number of users that haven't released the texture yet */
+  int referenceCount;
+  /** links of the least recently released list of the texture cache, only if unreferenced */
+  /* private */ struct ShovelerTextTextureStruct* previous;
+  /* private */ struct ShovelerTextTextureStruct* next;
 } ShovelerTextTexture;
 
+typedef struct {
+  gint64 numLayoutHits;
+  gint64 numLayoutMisses;
+  gint64 numTextureHits;
+  gint64 numTextureMisses;
+  /** number of texture misses that rendered into the framebuffer of an evicted texture */
+  gint64 numFramebufferReuses;
+  gint64 numTextureEvictions;
+} ShovelerTextTextureRendererStats;
+
 typedef struct ShovelerTextTextureRendererStruct {
   ShovelerFontAtlasTexture* fontAtlasTexture;
   ShovelerScene* textScene;
@@ -31,13 +74,48 @@ typedef struct ShovelerTextTextureRendererStruct {
   ShovelerModel* textModel;
   ShovelerCanvas* textCanvas;
   ShovelerSprite* textSprite;
+  /** measures uncached layouts, leaving the font atlas texture's builder to callers */
+  /* private */ ShovelerGlyphRunBuilder* layoutGlyphRunBuilder;
+  /** map from text (char *) to (ShovelerTextLayout *) */
+  GHashTable* layouts;
+  /* private */ ShovelerTextLayout* mostRecentLayout;
+  /* private */ ShovelerTextLayout* leastRecentLayout;
+  guint layoutCacheSize;
+  /** map from text (char *) to (ShovelerTextTexture *) */
+  GHashTable* textTextures;
+  /** map from (ShovelerTexture *) to (ShovelerTextTexture *) */
+  /* private */ GHashTable* textTexturesByTexture;
+  /* private */ ShovelerTextTexture* mostRecentUnreferencedTextTexture;
+  /* private */ ShovelerTextTexture* leastRecentUnreferencedTextTexture;
+  /* private */ guint numUnreferencedTextTextures;
+  guint textureCacheSize;
+  ShovelerTextTextureRendererStats stats;
 } ShovelerTextTextureRenderer;
 
 /** Create a renderer with the caller retaining ownership over the passed font atlas texture. */
 ShovelerTextTextureRenderer* shovelerTextTextureRendererCreate(
     ShovelerFontAtlasTexture* fontAtlasTexture, ShovelerShaderCache* shaderCache);
+/**
+ * Returns the layout of the text with the renderer's font atlas, which is owned by the renderer and
+ * only valid until the next call to the renderer.
+ */
+const ShovelerTextLayout* shovelerTextTextureRendererGetLayout(
+    ShovelerTextTextureRenderer* renderer, const char* text);
+/**
+ * Returns a texture of the text, which is shared with other users rendering the same text and
+ * remains owned by the renderer. The caller must release it with
+ * shovelerTextTextureRendererRelease once done instead of freeing it.
+ *
+ * Released textures are kept in a cache of the renderer's texture cache size, evicting the least
+ * recently released ones. Rendering a text that isn't cached reuses the framebuffer of the least
+ * recently released texture of the same size if there is one.
+ */
 ShovelerTexture* shovelerTextTextureRendererRender(
     ShovelerTextTextureRenderer* renderer, const char* text, ShovelerRenderState* renderState);
+void shovelerTextTextureRendererRelease(
+    ShovelerTextTextureRenderer* renderer, ShovelerTexture* texture);
+void shovelerTextTextureRendererLogStats(ShovelerTextTextureRenderer* renderer);
+/** Frees the renderer, including all textures it returned whether they were released or not. */
 void shovelerTextTextureRendererFree(ShovelerTextTextureRenderer* renderer);
 
 #endif
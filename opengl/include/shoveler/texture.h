@@ -28,6 +28,25 @@ ShovelerTexture* shovelerTextureCreateRenderTarget(
 ShovelerTexture* shovelerTextureCreateDepthTarget(
     unsigned int width, unsigned int height, GLsizei samples);
 bool shovelerTextureUpdate(ShovelerTexture* texture);
+/**
+ * Uploads only the given region of the texture's image, e.g. after a partial modification.
+ *
+ * Unlike shovelerTextureUpdate, this only writes the base level. Textures sampled with mipmaps need
+ * a call to shovelerTextureUpdateMipmaps once all regions are uploaded.
+ */
+bool shovelerTextureUpdateRegion(
+    ShovelerTexture* texture,
+    unsigned int x,
+    unsigned int y,
+    unsigned int width,
+    unsigned int height);
+/** Regenerates all mipmap levels of the texture from its base level. */
+bool shovelerTextureUpdateMipmaps(ShovelerTexture* texture);
+/**
+ * Returns a counter that changes whenever a texture is bound other than through shovelerTextureUse
+ * or freed, so that callers tracking which textures they bound to which units know when to forget.
+ */
+unsigned int shovelerTextureGetBindingGeneration();
 bool shovelerTextureUse(ShovelerTexture* texture, GLuint unitIndex);
 void shovelerTextureFree(ShovelerTexture* texture);
 
@@ -33,6 +33,15 @@ bool shovelerTilemapIntersect(
     ShovelerTilemap* tilemap,
     const ShovelerBoundingBox2* boundingBox,
     const ShovelerBoundingBox2* object);
+/** Sweeps an object along a displacement against the colliding tiles, writing the earliest time of
+ * impact and contact normal. Only tiles covered by the swept object are visited. */
+bool shovelerTilemapSweep(
+    ShovelerTilemap* tilemap,
+    const ShovelerBoundingBox2* boundingBox,
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    float* outputTime,
+    ShovelerVector2* outputNormal);
 bool shovelerTilemapRender(
     ShovelerTilemap* tilemap,
     ShovelerVector2 regionPosition,
@@ -2,6 +2,7 @@
 #define SHOVELER_UNIFORM_H
 
 #include <glad/glad.h>
+#include <glib.h>
 #include <shoveler/sampler.h>
 #include <shoveler/texture.h>
 #include <shoveler/types.h>
@@ -64,6 +65,42 @@ typedef struct {
   ShovelerUniformValue value;
 } ShovelerUniform;
 
+/**
+ * Value last uploaded to a uniform location of a program, with pointers dereferenced, bools
+ * converted to ints and textures replaced by their texture unit index.
+ */
+typedef struct {
+  bool valid;
+  ShovelerUniformType type;
+  ShovelerUniformValue value;
+} ShovelerUniformUploadedValue;
+
+typedef struct {
+  /** number of glUniform calls made */
+  gint64 numUploads;
+  /** number of glUniform calls skipped because the location already held the value */
+  gint64 numSkippedUploads;
+  /** number of texture and sampler pairs bound to a texture unit */
+  gint64 numTextureBinds;
+  /** number of texture binds skipped because the unit already had the texture and sampler bound */
+  gint64 numSkippedTextureBinds;
+} ShovelerUniformUploadStats;
+
+#define SHOVELER_UNIFORM_MAX_TEXTURE_UNITS 32
+
+/**
+ * Texture and sampler names last bound to each texture unit by texture uniforms. Texture units are
+ * shared by all programs, so one of these should be kept per context. Units with an unknown binding
+ * hold zero, and all units are forgotten whenever a texture or sampler is freed, since its name may
+ * then be reused.
+ */
+typedef struct {
+  unsigned int textureBindingGeneration;
+  unsigned int samplerBindingGeneration;
+  GLuint textures[SHOVELER_UNIFORM_MAX_TEXTURE_UNITS];
+  GLuint samplers[SHOVELER_UNIFORM_MAX_TEXTURE_UNITS];
+} ShovelerUniformTextureBindings;
+
 ShovelerUniform* shovelerUniformCreateBool(bool value);
 ShovelerUniform* shovelerUniformCreateBoolPointer(bool* value);
 ShovelerUniform* shovelerUniformCreateInt(int value);
@@ -84,7 +121,21 @@ ShovelerUniform* shovelerUniformCreateTexture(ShovelerTexture* texture, Shoveler
 ShovelerUniform* shovelerUniformCreateTexturePointer(
     ShovelerTexture** texturePointer, ShovelerSampler** samplerPointer);
 ShovelerUniform* shovelerUniformCopy(const ShovelerUniform* uniform);
+void shovelerUniformTextureBindingsReset(ShovelerUniformTextureBindings* textureBindings);
 bool shovelerUniformUse(ShovelerUniform* uniform, GLint location, GLuint* textureUnitIndexCounter);
+/**
+ * Same as shovelerUniformUse, but skips the glUniform call if the passed value last uploaded to the
+ * location is equal to the uniform's current value, and skips binding a texture if the passed
+ * texture bindings show it is already bound with the same sampler to its texture unit. Passing
+ * NULL for either disables the corresponding check.
+ */
+bool shovelerUniformUseCached(
+    ShovelerUniform* uniform,
+    GLint location,
+    GLuint* textureUnitIndexCounter,
+    ShovelerUniformUploadedValue* uploadedValue,
+    ShovelerUniformTextureBindings* textureBindings,
+    ShovelerUniformUploadStats* stats);
 void shovelerUniformFree(ShovelerUniform* uniform);
 
 #endif
@@ -8,10 +8,23 @@ typedef struct {
   GLint location;
 } ShovelerUniformAttachment;
 
-ShovelerUniformAttachment* shovelerUniformAttachmentCreate(
-    ShovelerUniform* uniform, GLint location);
+/**
+ * Uses the attachment, skipping the upload if uploadedValues holds the attached uniform's value at
+ * its location. uploadedValues may be NULL to always upload.
+ */
 bool shovelerUniformAttachmentUse(
-    ShovelerUniformAttachment* uniformAttachment, GLuint* textureUnitIndexCounter);
-void shovelerUniformAttachmentFree(ShovelerUniformAttachment* uniformAttachment);
+    const ShovelerUniformAttachment* uniformAttachment,
+    GLuint* textureUnitIndexCounter,
+    GArray* uploadedValues,
+    ShovelerUniformTextureBindings* textureBindings,
+    ShovelerUniformUploadStats* stats);
+
+static inline ShovelerUniformAttachment shovelerUniformAttachment(
+    ShovelerUniform* uniform, GLint location) {
+  ShovelerUniformAttachment uniformAttachment;
+  uniformAttachment.uniform = uniform;
+  uniformAttachment.location = location;
+  return uniformAttachment;
+}
 
 #endif
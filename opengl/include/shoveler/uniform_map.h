@@ -14,6 +14,11 @@ ShovelerUniformMap* shovelerUniformMapCreate();
 bool shovelerUniformMapInsert(
     ShovelerUniformMap* uniformMap, const char* name, ShovelerUniform* uniform);
 bool shovelerUniformMapRemove(ShovelerUniformMap* uniformMap, const char* name);
+/**
+ * Returns the smallest texture name currently referenced by a texture uniform in the map, or zero
+ * if there is none. Useful as a sort key to group draws sharing textures.
+ */
+GLuint shovelerUniformMapGetTexture(ShovelerUniformMap* uniformMap);
 int shovelerUniformMapAttach(ShovelerUniformMap* uniformMap, struct ShovelerShaderStruct* shader);
 void shovelerUniformMapFree(ShovelerUniformMap* uniformMap);
 
@@ -1,36 +1,83 @@
 #include "shoveler/canvas.h"
 
 #include <assert.h> // assert
-#include <math.h> // INFINITY
+#include <limits.h> // INT_MIN, INT_MAX
+#include <math.h> // INFINITY, floorf, isfinite
 #include <stdlib.h> // malloc, free
 #include <string.h> // memcpy
 
 #include "shoveler/camera.h"
+#include "shoveler/hash.h"
 #include "shoveler/light.h"
 #include "shoveler/log.h"
 #include "shoveler/model.h"
 #include "shoveler/shader.h"
 #include "shoveler/sprite.h"
 
+#define CELL_KEY(X, Y) ((gint64) (((guint64) (guint32) (X) << 32) | (guint64) (guint32) (Y)))
+
+static bool computeCellRange(
+    ShovelerCanvas* canvas,
+    const ShovelerBoundingBox2* boundingBox,
+    int* outputMinCellX,
+    int* outputMinCellY,
+    int* outputMaxCellX,
+    int* outputMaxCellY);
+static gint64 countCells(int minCellX, int minCellY, int maxCellX, int maxCellY);
+static void indexSprite(
+    ShovelerCanvas* canvas, ShovelerCanvasLayer* layer, ShovelerCanvasSpriteEntry* entry);
+static void unindexSprite(
+    ShovelerCanvas* canvas, ShovelerCanvasLayer* layer, ShovelerCanvasSpriteEntry* entry);
+static GArray* intersectLayerEntries(
+    ShovelerCanvas* canvas, ShovelerCanvasLayer* layer, const ShovelerBoundingBox2* region);
+static gint compareEntryOrder(gconstpointer firstEntryPointer, gconstpointer secondEntryPointer);
 static const ShovelerCollider2* intersectCanvas(
     const ShovelerCollider2* collider,
     const ShovelerBoundingBox2* object,
     ShovelerCollider2FilterCandidateFunction* filterCandidate,
     void* filterCandidateUserData);
+static bool sweepCanvas(
+    const ShovelerCollider2* collider,
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    ShovelerCollider2FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider2Contact* outputContact);
+static guint hashCellKey(gconstpointer cellKeyPointer);
+static gboolean equalCellKeys(gconstpointer firstKeyPointer, gconstpointer secondKeyPointer);
+static void freeCell(void* cellPointer);
 
 ShovelerCanvas* shovelerCanvasCreate(int numLayers) {
+  return shovelerCanvasCreateWithCellSize(numLayers, SHOVELER_CANVAS_DEFAULT_CELL_SIZE);
+}
+
+ShovelerCanvas* shovelerCanvasCreateWithCellSize(int numLayers, float cellSize) {
   assert(numLayers > 0);
+  assert(cellSize > 0.0f);
 
   ShovelerCanvas* canvas = malloc(sizeof(ShovelerCanvas));
   canvas->collider.boundingBox = shovelerBoundingBox2(
       shovelerVector2(-INFINITY, -INFINITY), shovelerVector2(INFINITY, INFINITY));
   canvas->collider.intersect = intersectCanvas;
+  canvas->collider.sweep = sweepCanvas;
   canvas->collider.data = canvas;
+  canvas->cellSize = cellSize;
   canvas->numLayers = numLayers;
-  canvas->layers = malloc((size_t) numLayers * sizeof(GQueue*));
+  canvas->layers = malloc((size_t) numLayers * sizeof(ShovelerCanvasLayer));
+  canvas->nextOrder = 0;
+  canvas->queryId = 0;
+  canvas->queryEntries = g_array_new(
+      /* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerCanvasSpriteEntry*));
+  canvas->batcher = shovelerSpriteBatcherCreate();
 
   for (int layerId = 0; layerId < canvas->numLayers; layerId++) {
-    canvas->layers[layerId] = g_queue_new();
+    ShovelerCanvasLayer* layer = &canvas->layers[layerId];
+    layer->sprites = g_queue_new();
+    layer->entries = g_hash_table_new_full(
+        g_direct_hash, g_direct_equal, /* keyDestroyFunc */ NULL, /* valueDestroyFunc */ free);
+    layer->cells =
+        g_hash_table_new_full(hashCellKey, equalCellKeys, /* keyDestroyFunc */ NULL, freeCell);
+    layer->unboundedEntries = g_queue_new();
   }
 
   return canvas;
@@ -40,18 +87,102 @@ void shovelerCanvasAddSprite(ShovelerCanvas* canvas, int layerId, ShovelerSprite
   assert(layerId >= 0);
   assert(layerId < canvas->numLayers);
 
-  GQueue* layer = canvas->layers[layerId];
+  ShovelerCanvasLayer* layer = &canvas->layers[layerId];
+  if (g_hash_table_contains(layer->entries, sprite)) {
+    shovelerLogWarning(
+        "Sprite %p was already added to layer %d of canvas %p, ignoring.", sprite, layerId, canvas);
+    return;
+  }
 
-  g_queue_push_tail(layer, (gpointer) sprite);
+  if (sprite->canvas != NULL && sprite->canvas != canvas) {
+    shovelerLogWarning(
+        "Sprite %p was already added to canvas %p, only canvas %p will be notified about its "
+        "changes from now on.",
+        sprite,
+        sprite->canvas,
+        canvas);
+  }
+  sprite->canvas = canvas;
+
+  ShovelerCanvasSpriteEntry* entry = malloc(sizeof(ShovelerCanvasSpriteEntry));
+  entry->sprite = sprite;
+  entry->order = canvas->nextOrder++;
+  entry->lastQueryId = canvas->queryId;
+  indexSprite(canvas, layer, entry);
+
+  g_hash_table_insert(layer->entries, sprite, entry);
+  g_queue_push_tail(layer->sprites, (gpointer) sprite);
 }
 
 bool shovelerCanvasRemoveSprite(ShovelerCanvas* canvas, int layerId, ShovelerSprite* sprite) {
   assert(layerId >= 0);
   assert(layerId < canvas->numLayers);
 
-  GQueue* layer = canvas->layers[layerId];
+  ShovelerCanvasLayer* layer = &canvas->layers[layerId];
+  ShovelerCanvasSpriteEntry* entry = g_hash_table_lookup(layer->entries, sprite);
+  if (entry == NULL) {
+    return false;
+  }
+
+  unindexSprite(canvas, layer, entry);
+  g_hash_table_remove(layer->entries, sprite);
+  g_queue_remove(layer->sprites, sprite);
+
+  if (sprite->canvas == canvas) {
+    bool containedInOtherLayer = false;
+    for (int otherLayerId = 0; otherLayerId < canvas->numLayers; otherLayerId++) {
+      if (g_hash_table_contains(canvas->layers[otherLayerId].entries, sprite)) {
+        containedInOtherLayer = true;
+        break;
+      }
+    }
+
+    if (!containedInOtherLayer) {
+      sprite->canvas = NULL;
+    }
+  }
+
+  return true;
+}
+
+void shovelerCanvasUpdateSprite(ShovelerCanvas* canvas, ShovelerSprite* sprite) {
+  for (int layerId = 0; layerId < canvas->numLayers; layerId++) {
+    ShovelerCanvasLayer* layer = &canvas->layers[layerId];
+    ShovelerCanvasSpriteEntry* entry = g_hash_table_lookup(layer->entries, sprite);
+    if (entry == NULL) {
+      continue;
+    }
+
+    int minCellX, minCellY, maxCellX, maxCellY;
+    bool finite = computeCellRange(
+        canvas, &sprite->collider.boundingBox, &minCellX, &minCellY, &maxCellX, &maxCellY);
+    if (finite && !entry->unbounded && minCellX == entry->minCellX &&
+        minCellY == entry->minCellY && maxCellX == entry->maxCellX &&
+        maxCellY == entry->maxCellY) {
+      // still overlapping the same cells, nothing to do
+      continue;
+    }
+
+    unindexSprite(canvas, layer, entry);
+    indexSprite(canvas, layer, entry);
+  }
+}
+
+void shovelerCanvasIntersectLayer(
+    ShovelerCanvas* canvas,
+    int layerId,
+    const ShovelerBoundingBox2* region,
+    GArray* outputSprites) {
+  assert(layerId >= 0);
+  assert(layerId < canvas->numLayers);
+
+  g_array_set_size(outputSprites, 0);
 
-  return g_queue_remove(layer, sprite);
+  GArray* entries = intersectLayerEntries(canvas, &canvas->layers[layerId], region);
+  for (guint i = 0; i < entries->len; i++) {
+    ShovelerCanvasSpriteEntry* entry = g_array_index(entries, ShovelerCanvasSpriteEntry*, i);
+    g_array_append_val(outputSprites, entry->sprite);
+  }
 }
 
 bool shovelerCanvasRender(
@@ -71,36 +202,74 @@ bool shovelerCanvasRender(
 
   shovelerRenderStateEnableBlend(renderState, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+  // Sprites sharing a material and resource are grouped into batches that can be drawn with a
+  // single instanced draw call, as long as this doesn't change the order of overlapping sprites.
+  ShovelerSpriteBatcher* batcher = canvas->batcher;
+  shovelerSpriteBatcherBegin(batcher, &regionBoundingBox);
   for (int layerId = 0; layerId < canvas->numLayers; layerId++) {
-    GQueue* layer = canvas->layers[layerId];
+    shovelerSpriteBatcherBeginLayer(batcher, layerId);
 
-    for (GList* iter = layer->head; iter != NULL; iter = iter->next) {
-      ShovelerSprite* sprite = iter->data;
+    // We're deliberately checking only against the sprites' bounding boxes instead of doing a
+    // full collider check, because we don't care about an actual collision. All we need to
+    // know is if a sprite is close enough to the canvas to be rendered.
+    GArray* entries =
+        intersectLayerEntries(canvas, &canvas->layers[layerId], &regionBoundingBox);
 
-      // We're deliberately checking only against the sprite's bounding box instead of doing a
-      // full collider check, because we don't care about an actual collision. All we need to
-      // know is if a sprite is close enough to the canvas to be rendered.
-      if (!shovelerBoundingBox2Intersect(&regionBoundingBox, &sprite->collider.boundingBox)) {
-        continue;
-      }
+    for (guint i = 0; i < entries->len; i++) {
+      ShovelerSprite* sprite = g_array_index(entries, ShovelerCanvasSpriteEntry*, i)->sprite;
 
-      if (!shovelerSpriteRender(
-              sprite, regionPosition, regionSize, scene, camera, light, model, renderState)) {
-        shovelerLogWarning(
-            "Failed to render sprite %p of canvas %p to scene %p, camera %p, light %p and model "
-            "%p.",
-            sprite,
-            canvas,
-            scene,
-            camera,
-            light,
-            model);
-        return false;
-      }
+      ShovelerSpriteBatchKey key;
+      ShovelerSpriteInstance instance;
+      instance.position = sprite->position;
+      instance.size = sprite->size;
+      instance.tilesetColumn = 0;
+      instance.tilesetRow = 0;
+      bool batchable = sprite->batch != NULL && sprite->renderBatch != NULL &&
+          sprite->batch(sprite, &key, &instance);
 
-      if (!sprite->material->screenspace) {
-        shovelerRenderStateEnableDepthTest(renderState, GL_EQUAL);
-      }
+      shovelerSpriteBatcherAdd(batcher, batchable ? &key : NULL, &instance, sprite);
+    }
+  }
+  shovelerSpriteBatcherEnd(batcher);
+
+  for (guint i = 0; i < batcher->batches->len; i++) {
+    const ShovelerSpriteBatch* batch = &g_array_index(batcher->batches, ShovelerSpriteBatch, i);
+    ShovelerSprite* sprite = batch->userData;
+
+    bool rendered;
+    if (batch->batchable && batch->numInstances > 1) {
+      rendered = sprite->renderBatch(
+          sprite,
+          shovelerSpriteBatchGetInstances(batcher, batch),
+          (int) batch->numInstances,
+          regionPosition,
+          regionSize,
+          scene,
+          camera,
+          light,
+          model,
+          renderState);
+    } else {
+      rendered = shovelerSpriteRender(
+          sprite, regionPosition, regionSize, scene, camera, light, model, renderState);
+    }
+
+    if (!rendered) {
+      shovelerLogWarning(
+          "Failed to render batch of %u sprites starting with sprite %p of canvas %p to scene %p, "
+          "camera %p, light %p and model %p.",
+          batch->numInstances,
+          sprite,
+          canvas,
+          scene,
+          camera,
+          light,
+          model);
+      return false;
+    }
+
+    if (!sprite->material->screenspace) {
+      shovelerRenderStateEnableDepthTest(renderState, GL_EQUAL);
     }
   }
 
@@ -113,13 +282,193 @@ void shovelerCanvasFree(ShovelerCanvas* canvas) {
   }
 
   for (int layerId = 0; layerId < canvas->numLayers; layerId++) {
-    g_queue_free(canvas->layers[layerId]);
+    ShovelerCanvasLayer* layer = &canvas->layers[layerId];
+
+    for (GList* iter = layer->sprites->head; iter != NULL; iter = iter->next) {
+      ShovelerSprite* sprite = iter->data;
+      if (sprite->canvas == canvas) {
+        sprite->canvas = NULL;
+      }
+    }
+
+    g_queue_free(layer->unboundedEntries);
+    g_hash_table_destroy(layer->cells);
+    g_hash_table_destroy(layer->entries);
+    g_queue_free(layer->sprites);
   }
 
+  shovelerSpriteBatcherFree(canvas->batcher);
+  g_array_free(canvas->queryEntries, /* freeSegment */ true);
   free(canvas->layers);
   free(canvas);
 }
 
+/** Computes the cell range of the given bounding box, returning false if it isn't finite. */
+static bool computeCellRange(
+    ShovelerCanvas* canvas,
+    const ShovelerBoundingBox2* boundingBox,
+    int* outputMinCellX,
+    int* outputMinCellY,
+    int* outputMaxCellX,
+    int* outputMaxCellY) {
+  float minCellX = floorf(boundingBox->min.values[0] / canvas->cellSize);
+  float minCellY = floorf(boundingBox->min.values[1] / canvas->cellSize);
+  float maxCellX = floorf(boundingBox->max.values[0] / canvas->cellSize);
+  float maxCellY = floorf(boundingBox->max.values[1] / canvas->cellSize);
+  if (!isfinite(minCellX) || !isfinite(minCellY) || !isfinite(maxCellX) || !isfinite(maxCellY) ||
+      minCellX <= (float) INT_MIN || maxCellX >= (float) INT_MAX || minCellY <= (float) INT_MIN ||
+      maxCellY >= (float) INT_MAX) {
+    return false;
+  }
+
+  *outputMinCellX = (int) minCellX;
+  *outputMinCellY = (int) minCellY;
+  *outputMaxCellX = (int) maxCellX;
+  *outputMaxCellY = (int) maxCellY;
+  return true;
+}
+
+static gint64 countCells(int minCellX, int minCellY, int maxCellX, int maxCellY) {
+  return ((gint64) maxCellX - minCellX + 1) * ((gint64) maxCellY - minCellY + 1);
+}
+
+static void indexSprite(
+    ShovelerCanvas* canvas, ShovelerCanvasLayer* layer, ShovelerCanvasSpriteEntry* entry) {
+  bool finite = computeCellRange(
+      canvas,
+      &entry->sprite->collider.boundingBox,
+      &entry->minCellX,
+      &entry->minCellY,
+      &entry->maxCellX,
+      &entry->maxCellY);
+  entry->unbounded = !finite ||
+      countCells(entry->minCellX, entry->minCellY, entry->maxCellX, entry->maxCellY) >
+          SHOVELER_CANVAS_MAX_CELLS_PER_SPRITE;
+  if (entry->unbounded) {
+    g_queue_push_tail(layer->unboundedEntries, entry);
+    return;
+  }
+
+  for (int cellX = entry->minCellX; cellX <= entry->maxCellX; cellX++) {
+    for (int cellY = entry->minCellY; cellY <= entry->maxCellY; cellY++) {
+      gint64 key = CELL_KEY(cellX, cellY);
+      ShovelerCanvasCell* cell = g_hash_table_lookup(layer->cells, &key);
+      if (cell == NULL) {
+        cell = malloc(sizeof(ShovelerCanvasCell));
+        cell->key = key;
+        cell->entries = g_queue_new();
+        g_hash_table_insert(layer->cells, &cell->key, cell);
+      }
+
+      g_queue_push_tail(cell->entries, entry);
+    }
+  }
+}
+
+/** Removes an entry from the grid using the cell range stored in it. */
+static void unindexSprite(
+    ShovelerCanvas* canvas, ShovelerCanvasLayer* layer, ShovelerCanvasSpriteEntry* entry) {
+  if (entry->unbounded) {
+    g_queue_remove(layer->unboundedEntries, entry);
+    return;
+  }
+
+  for (int cellX = entry->minCellX; cellX <= entry->maxCellX; cellX++) {
+    for (int cellY = entry->minCellY; cellY <= entry->maxCellY; cellY++) {
+      gint64 key = CELL_KEY(cellX, cellY);
+      ShovelerCanvasCell* cell = g_hash_table_lookup(layer->cells, &key);
+      if (cell == NULL) {
+        continue;
+      }
+
+      g_queue_remove(cell->entries, entry);
+      if (g_queue_get_length(cell->entries) == 0) {
+        g_hash_table_remove(layer->cells, &key);
+      }
+    }
+  }
+}
+
+/**
+ * Collects all entries of the layer whose sprite bounding box intersects the region, sorted by draw
+ * order. The returned array is owned by the canvas and only valid until the next query.
+ */
+static GArray* intersectLayerEntries(
+    ShovelerCanvas* canvas, ShovelerCanvasLayer* layer, const ShovelerBoundingBox2* region) {
+  canvas->queryId++;
+  g_array_set_size(canvas->queryEntries, 0);
+
+  int minCellX, minCellY, maxCellX, maxCellY;
+  bool finite = computeCellRange(canvas, region, &minCellX, &minCellY, &maxCellX, &maxCellY);
+  gint64 numCells = finite ? countCells(minCellX, minCellY, maxCellX, maxCellY) : 0;
+  if (!finite ||
+      (numCells > SHOVELER_CANVAS_MAX_CELLS_PER_QUERY &&
+       numCells > (gint64) g_queue_get_length(layer->sprites))) {
+    // The query covers more cells than there are sprites, so it is cheaper to check them all.
+    // Since the sprite list is already in draw order, there is no need to sort either.
+    for (GList* iter = layer->sprites->head; iter != NULL; iter = iter->next) {
+      ShovelerSprite* sprite = iter->data;
+      if (shovelerBoundingBox2Intersect(region, &sprite->collider.boundingBox)) {
+        ShovelerCanvasSpriteEntry* entry = g_hash_table_lookup(layer->entries, sprite);
+        g_array_append_val(canvas->queryEntries, entry);
+      }
+    }
+
+    return canvas->queryEntries;
+  }
+
+  for (GList* iter = layer->unboundedEntries->head; iter != NULL; iter = iter->next) {
+    ShovelerCanvasSpriteEntry* entry = iter->data;
+    entry->lastQueryId = canvas->queryId;
+
+    if (shovelerBoundingBox2Intersect(region, &entry->sprite->collider.boundingBox)) {
+      g_array_append_val(canvas->queryEntries, entry);
+    }
+  }
+
+  for (int cellX = minCellX; cellX <= maxCellX; cellX++) {
+    for (int cellY = minCellY; cellY <= maxCellY; cellY++) {
+      gint64 key = CELL_KEY(cellX, cellY);
+      ShovelerCanvasCell* cell = g_hash_table_lookup(layer->cells, &key);
+      if (cell == NULL) {
+        continue;
+      }
+
+      for (GList* iter = cell->entries->head; iter != NULL; iter = iter->next) {
+        ShovelerCanvasSpriteEntry* entry = iter->data;
+        if (entry->lastQueryId == canvas->queryId) {
+          continue;
+        }
+        entry->lastQueryId = canvas->queryId;
+
+        if (shovelerBoundingBox2Intersect(region, &entry->sprite->collider.boundingBox)) {
+          g_array_append_val(canvas->queryEntries, entry);
+        }
+      }
+    }
+  }
+
+  g_array_sort(canvas->queryEntries, compareEntryOrder);
+  return canvas->queryEntries;
+}
+
+static gint compareEntryOrder(gconstpointer firstEntryPointer, gconstpointer secondEntryPointer) {
+  const ShovelerCanvasSpriteEntry* firstEntry =
+      *(const ShovelerCanvasSpriteEntry* const*) firstEntryPointer;
+  const ShovelerCanvasSpriteEntry* secondEntry =
+      *(const ShovelerCanvasSpriteEntry* const*) secondEntryPointer;
+
+  if (firstEntry->order < secondEntry->order) {
+    return -1;
+  }
+
+  if (firstEntry->order > secondEntry->order) {
+    return 1;
+  }
+
+  return 0;
+}
+
 static const ShovelerCollider2* intersectCanvas(
     const ShovelerCollider2* collider,
     const ShovelerBoundingBox2* object,
@@ -128,10 +477,10 @@ static const ShovelerCollider2* intersectCanvas(
   ShovelerCanvas* canvas = (ShovelerCanvas*) collider->data;
 
   for (int layerId = 0; layerId < canvas->numLayers; layerId++) {
-    GQueue* layer = canvas->layers[layerId];
+    GArray* entries = intersectLayerEntries(canvas, &canvas->layers[layerId], object);
 
-    for (GList* iter = layer->head; iter != NULL; iter = iter->next) {
-      ShovelerSprite* sprite = iter->data;
+    for (guint i = 0; i < entries->len; i++) {
+      ShovelerSprite* sprite = g_array_index(entries, ShovelerCanvasSpriteEntry*, i)->sprite;
 
       if (!sprite->enableCollider) {
         continue;
@@ -147,3 +496,60 @@ static const ShovelerCollider2* intersectCanvas(
 
   return NULL;
 }
+
+static bool sweepCanvas(
+    const ShovelerCollider2* collider,
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    ShovelerCollider2FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider2Contact* outputContact) {
+  ShovelerCanvas* canvas = (ShovelerCanvas*) collider->data;
+  ShovelerBoundingBox2 sweptObject = shovelerBoundingBox2Swept(object, displacement);
+
+  bool hit = false;
+  for (int layerId = 0; layerId < canvas->numLayers; layerId++) {
+    GArray* entries = intersectLayerEntries(canvas, &canvas->layers[layerId], &sweptObject);
+
+    for (guint i = 0; i < entries->len; i++) {
+      ShovelerSprite* sprite = g_array_index(entries, ShovelerCanvasSpriteEntry*, i)->sprite;
+
+      if (!sprite->enableCollider) {
+        continue;
+      }
+
+      ShovelerCollider2Contact contact;
+      if (shovelerCollider2SweepFiltered(
+              &sprite->collider,
+              object,
+              displacement,
+              filterCandidate,
+              filterCandidateUserData,
+              &contact) &&
+          (!hit ||
+           shovelerCollider2ContactPrecedes(
+               contact.time, contact.normal, outputContact->time, outputContact->normal))) {
+        hit = true;
+        *outputContact = contact;
+      }
+    }
+  }
+
+  return hit;
+}
+
+static guint hashCellKey(gconstpointer cellKeyPointer) {
+  // g_int64_hash folds the upper into the lower half, which would collide for nearby cells
+  guint64 cellKey = (guint64) *(const gint64*) cellKeyPointer;
+  return shovelerHashCombine((guint) (cellKey >> 32), (guint) cellKey);
+}
+
+static gboolean equalCellKeys(gconstpointer firstKeyPointer, gconstpointer secondKeyPointer) {
+  return *(const gint64*) firstKeyPointer == *(const gint64*) secondKeyPointer;
+}
+
+static void freeCell(void* cellPointer) {
+  ShovelerCanvasCell* cell = cellPointer;
+  g_queue_free(cell->entries);
+  free(cell);
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+extern "C" {
+#include "shoveler/canvas.h"
+#include "shoveler/sprite.h"
+}
+
+static const int numTestSprites = 3;
+
+static void freeTestSprite(ShovelerSprite* sprite) {}
+
+class ShovelerCanvasTest : public ::testing::Test {
+public:
+  virtual void SetUp() {
+    canvas = shovelerCanvasCreate(/* numLayers */ 2);
+    outputSprites = g_array_new(
+        /* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerSprite*));
+
+    for (int i = 0; i < numTestSprites; i++) {
+      shovelerSpriteInit(
+          &sprites[i],
+          /* material */ NULL,
+          /* intersect */ NULL,
+          /* sweep */ NULL,
+          /* render */ NULL,
+          freeTestSprite,
+          /* data */ NULL);
+    }
+  }
+
+  virtual void TearDown() {
+    g_array_free(outputSprites, /* freeSegment */ true);
+    shovelerCanvasFree(canvas);
+  }
+
+  ShovelerSprite* getOutputSprite(guint index) {
+    return g_array_index(outputSprites, ShovelerSprite*, index);
+  }
+
+  ShovelerCanvas* canvas;
+  ShovelerSprite sprites[numTestSprites];
+  GArray* outputSprites;
+};
+
+TEST_F(ShovelerCanvasTest, intersectLayerInDrawOrder) {
+  shovelerSpriteUpdatePosition(&sprites[0], shovelerVector2(5.0f, 5.0f));
+  shovelerSpriteUpdatePosition(&sprites[1], shovelerVector2(2.0f, 2.0f));
+  shovelerSpriteUpdatePosition(&sprites[2], shovelerVector2(3.0f, 3.0f));
+  for (int i = 0; i < numTestSprites; i++) {
+    shovelerCanvasAddSprite(canvas, /* layerId */ 0, &sprites[i]);
+  }
+
+  // moving the first sprite shouldn't change the draw order
+  shovelerSpriteUpdatePosition(&sprites[0], shovelerVector2(2.5f, 2.5f));
+
+  ShovelerBoundingBox2 region =
+      shovelerBoundingBox2(shovelerVector2(0.0f, 0.0f), shovelerVector2(4.0f, 4.0f));
+  shovelerCanvasIntersectLayer(canvas, /* layerId */ 0, &region, outputSprites);
+  ASSERT_EQ(outputSprites->len, 3);
+  ASSERT_EQ(getOutputSprite(0), &sprites[0]);
+  ASSERT_EQ(getOutputSprite(1), &sprites[1]);
+  ASSERT_EQ(getOutputSprite(2), &sprites[2]);
+
+  shovelerCanvasIntersectLayer(canvas, /* layerId */ 1, &region, outputSprites);
+  ASSERT_EQ(outputSprites->len, 0);
+}
+
+TEST_F(ShovelerCanvasTest, updateSprite) {
+  shovelerCanvasAddSprite(canvas, /* layerId */ 1, &sprites[0]);
+  ASSERT_EQ(sprites[0].canvas, canvas);
+
+  ShovelerBoundingBox2 region =
+      shovelerBoundingBox2(shovelerVector2(9.0f, 9.0f), shovelerVector2(11.0f, 11.0f));
+  shovelerCanvasIntersectLayer(canvas, /* layerId */ 1, &region, outputSprites);
+  ASSERT_EQ(outputSprites->len, 0);
+
+  shovelerSpriteUpdatePosition(&sprites[0], shovelerVector2(10.0f, 10.0f));
+  shovelerCanvasIntersectLayer(canvas, /* layerId */ 1, &region, outputSprites);
+  ASSERT_EQ(outputSprites->len, 1);
+  ASSERT_EQ(getOutputSprite(0), &sprites[0]);
+
+  shovelerSpriteUpdateSize(&sprites[0], shovelerVector2(0.5f, 0.5f));
+  ShovelerBoundingBox2 edgeRegion =
+      shovelerBoundingBox2(shovelerVector2(10.3f, 10.3f), shovelerVector2(11.0f, 11.0f));
+  shovelerCanvasIntersectLayer(canvas, /* layerId */ 1, &edgeRegion, outputSprites);
+  ASSERT_EQ(outputSprites->len, 0);
+
+  bool removed = shovelerCanvasRemoveSprite(canvas, /* layerId */ 1, &sprites[0]);
+  ASSERT_TRUE(removed);
+  ASSERT_EQ(sprites[0].canvas, nullptr);
+  shovelerCanvasIntersectLayer(canvas, /* layerId */ 1, &region, outputSprites);
+  ASSERT_EQ(outputSprites->len, 0);
+}
+
+TEST_F(ShovelerCanvasTest, intersectLargeRegion) {
+  shovelerSpriteUpdatePosition(&sprites[0], shovelerVector2(-500.0f, 0.0f));
+  shovelerSpriteUpdateSize(&sprites[1], shovelerVector2(1000.0f, 1000.0f));
+  shovelerSpriteUpdatePosition(&sprites[2], shovelerVector2(500.0f, 0.0f));
+  for (int i = 0; i < numTestSprites; i++) {
+    shovelerCanvasAddSprite(canvas, /* layerId */ 0, &sprites[i]);
+  }
+
+  ShovelerBoundingBox2 region =
+      shovelerBoundingBox2(shovelerVector2(-1000.0f, -1000.0f), shovelerVector2(1000.0f, 1000.0f));
+  shovelerCanvasIntersectLayer(canvas, /* layerId */ 0, &region, outputSprites);
+  ASSERT_EQ(outputSprites->len, 3);
+  ASSERT_EQ(getOutputSprite(0), &sprites[0]);
+  ASSERT_EQ(getOutputSprite(1), &sprites[1]);
+  ASSERT_EQ(getOutputSprite(2), &sprites[2]);
+}
+
+TEST_F(ShovelerCanvasTest, intersectCollider) {
+  shovelerSpriteUpdatePosition(&sprites[0], shovelerVector2(2.0f, 2.0f));
+  shovelerSpriteUpdatePosition(&sprites[1], shovelerVector2(2.0f, 2.0f));
+  shovelerSpriteSetEnableCollider(&sprites[0], false);
+  shovelerCanvasAddSprite(canvas, /* layerId */ 0, &sprites[0]);
+  shovelerCanvasAddSprite(canvas, /* layerId */ 1, &sprites[1]);
+
+  ShovelerBoundingBox2 object =
+      shovelerBoundingBox2(shovelerVector2(1.0f, 1.0f), shovelerVector2(2.0f, 2.0f));
+  const ShovelerCollider2* collider = shovelerCollider2Intersect(&canvas->collider, &object);
+  ASSERT_EQ(collider, &sprites[1].collider);
+
+  ShovelerBoundingBox2 farObject =
+      shovelerBoundingBox2(shovelerVector2(10.0f, 10.0f), shovelerVector2(11.0f, 11.0f));
+  const ShovelerCollider2* farCollider = shovelerCollider2Intersect(&canvas->collider, &farObject);
+  ASSERT_EQ(farCollider, nullptr);
+}
@@ -2,6 +2,7 @@
 
 #include <GLFW/glfw3.h>
 #include <glad/glad.h>
+#include <math.h> // sqrtf
 #include <stdlib.h> // malloc, free
 #include <string.h> // memcmp
 
@@ -11,6 +12,9 @@
 #include "shoveler/log.h"
 #include "shoveler/types.h"
 
+// distance kept from colliders when moving up to a contact point
+#define CONTACT_SKIN 1e-4f
+
 static void keyHandler(
     ShovelerInput* input, int key, int scancode, int action, int mods, void* controllerPointer);
 static void updatePosition(ShovelerController* controller, float dt);
@@ -22,7 +26,8 @@ static bool tryMoveDirection(
     ShovelerVector3 right,
     float moveAmountRight,
     float moveAmountUp,
-    float moveAmountForward);
+    float moveAmountForward,
+    float* outputContactTime);
 static void windowSizeHandler(
     ShovelerInput* input, unsigned int width, unsigned int height, void* controllerPointer);
 static void triggerTilt(
@@ -274,105 +279,156 @@ static void updateTilt(ShovelerController* controller, float dt) {
 static void shiftPosition(ShovelerController* controller, ShovelerVector3 moveAmount) {
   ShovelerVector3 right = shovelerVector3Cross(controller->frame.direction, controller->frame.up);
 
+  float contactTime;
   if (tryMoveDirection(
-          controller, right, moveAmount.values[0], moveAmount.values[1], moveAmount.values[2])) {
+          controller,
+          right,
+          moveAmount.values[0],
+          moveAmount.values[1],
+          moveAmount.values[2],
+          &contactTime)) {
     return;
   }
 
-  if (tryMoveDirection(controller, right, moveAmount.values[0], 0.0f, 0.0f)) {
+  // Remember how far we could get along the full move, in case sliding along an axis fails too.
+  float fullContactTime = contactTime;
+
+  if (tryMoveDirection(controller, right, moveAmount.values[0], 0.0f, 0.0f, &contactTime)) {
     return;
   }
 
-  if (tryMoveDirection(controller, right, 0.0f, moveAmount.values[1], 0.0f)) {
+  if (tryMoveDirection(controller, right, 0.0f, moveAmount.values[1], 0.0f, &contactTime)) {
     return;
   }
 
-  if (tryMoveDirection(controller, right, 0.0f, 0.0f, moveAmount.values[2])) {
+  if (tryMoveDirection(controller, right, 0.0f, 0.0f, moveAmount.values[2], &contactTime)) {
     return;
   }
+
+  // Move up to the contact point, keeping a small distance to avoid starting the next move in
+  // touching contact.
+  float moveLength = sqrtf(shovelerVector3LengthSquared(moveAmount));
+  float moveFraction = fullContactTime - CONTACT_SKIN / moveLength;
+  if (moveFraction > 0.0f) {
+    tryMoveDirection(
+        controller,
+        right,
+        moveFraction * moveAmount.values[0],
+        moveFraction * moveAmount.values[1],
+        moveFraction * moveAmount.values[2],
+        &contactTime);
+  }
 }
 
+/**
+ * Sweeps the controller's bounding boxes along the given move and performs it if there is no
+ * contact along the way. Otherwise, the earliest time of contact is written to the output.
+ */
 static bool tryMoveDirection(
     ShovelerController* controller,
     ShovelerVector3 right,
     float moveAmountRight,
     float moveAmountUp,
-    float moveAmountForward) {
-  ShovelerVector3 targetPosition;
-  targetPosition = shovelerVector3LinearCombination(
-      1.0, controller->frame.position, moveAmountForward, controller->frame.direction);
-  targetPosition = shovelerVector3LinearCombination(1.0, targetPosition, moveAmountRight, right);
-  targetPosition =
-      shovelerVector3LinearCombination(1.0, targetPosition, moveAmountUp, controller->frame.up);
+    float moveAmountForward,
+    float* outputContactTime) {
+  ShovelerVector3 displacement = shovelerVector3LinearCombination(
+      moveAmountForward, controller->frame.direction, moveAmountRight, right);
+  displacement =
+      shovelerVector3LinearCombination(1.0, displacement, moveAmountUp, controller->frame.up);
+  ShovelerVector3 targetPosition =
+      shovelerVector3LinearCombination(1.0, controller->frame.position, 1.0, displacement);
+
+  bool hit = false;
+  *outputContactTime = 1.0f;
 
   // check for 2d collisions
   if (controller->boundingBoxSize2 > 0.0f) {
-    ShovelerVector2 targetPosition2 =
-        shovelerVector2(targetPosition.values[0], targetPosition.values[1]);
+    ShovelerVector2 position2 =
+        shovelerVector2(controller->frame.position.values[0], controller->frame.position.values[1]);
+    ShovelerVector2 displacement2 =
+        shovelerVector2(displacement.values[0], displacement.values[1]);
 
-    ShovelerBoundingBox2 targetBoundingBox2 = shovelerBoundingBox2(
+    ShovelerBoundingBox2 boundingBox2 = shovelerBoundingBox2(
         shovelerVector2LinearCombination(
-            1.0,
-            targetPosition2,
-            -0.5f * controller->boundingBoxSize2,
-            shovelerVector2(1.0f, 1.0f)),
+            1.0, position2, -0.5f * controller->boundingBoxSize2, shovelerVector2(1.0f, 1.0f)),
         shovelerVector2LinearCombination(
-            1.0,
-            targetPosition2,
-            0.5f * controller->boundingBoxSize2,
-            shovelerVector2(1.0f, 1.0f)));
+            1.0, position2, 0.5f * controller->boundingBoxSize2, shovelerVector2(1.0f, 1.0f)));
 
-    const ShovelerCollider2* collider =
-        shovelerCollidersIntersect2(controller->colliders, &targetBoundingBox2);
-    if (collider != NULL) {
+    ShovelerBoundingBox2 targetBoundingBox2 = shovelerBoundingBox2(
+        shovelerVector2LinearCombination(1.0, boundingBox2.min, 1.0, displacement2),
+        shovelerVector2LinearCombination(1.0, boundingBox2.max, 1.0, displacement2));
+
+    // Contacts without a normal come from colliders we're already overlapping or that can only be
+    // checked at the target position, so they only block if the target position is blocked. They
+    // are only reported if there is no contact with a normal, which can't be hidden behind them.
+    ShovelerCollider2Contact contact;
+    if (shovelerCollidersSweep2(controller->colliders, &boundingBox2, displacement2, &contact) &&
+        (contact.normal.values[0] != 0.0f || contact.normal.values[1] != 0.0f ||
+         shovelerCollidersIntersect2(controller->colliders, &targetBoundingBox2) != NULL)) {
       shovelerLogTrace(
-          "Bumping into 2d collider %p with bounding box (%.2f, %.2f)-(%.2f, %.2f), aborting "
-          "position shift to (%.2f, %.2f).",
-          collider,
-          collider->boundingBox.min.values[0],
-          collider->boundingBox.min.values[1],
-          collider->boundingBox.max.values[0],
-          collider->boundingBox.max.values[1],
-          targetPosition2.values[0],
-          targetPosition2.values[1]);
-      return false;
+          "Bumping into 2d collider %p with bounding box (%.2f, %.2f)-(%.2f, %.2f) at time %.3f, "
+          "aborting position shift to (%.2f, %.2f).",
+          contact.collider,
+          contact.collider->boundingBox.min.values[0],
+          contact.collider->boundingBox.min.values[1],
+          contact.collider->boundingBox.max.values[0],
+          contact.collider->boundingBox.max.values[1],
+          contact.time,
+          targetPosition.values[0],
+          targetPosition.values[1]);
+      hit = true;
+      *outputContactTime = contact.time;
     }
   }
 
   // check for 3d collisions
   if (controller->boundingBoxSize3 > 0.0f) {
-    ShovelerBoundingBox3 targetBoundingBox3 = shovelerBoundingBox3(
+    ShovelerBoundingBox3 boundingBox3 = shovelerBoundingBox3(
         shovelerVector3LinearCombination(
             1.0,
-            targetPosition,
+            controller->frame.position,
             -0.5f * controller->boundingBoxSize3,
             shovelerVector3(1.0f, 1.0f, 1.0f)),
         shovelerVector3LinearCombination(
             1.0,
-            targetPosition,
+            controller->frame.position,
             0.5f * controller->boundingBoxSize3,
             shovelerVector3(1.0f, 1.0f, 1.0f)));
 
-    const ShovelerCollider3* collider =
-        shovelerCollidersIntersect3(controller->colliders, &targetBoundingBox3);
-    if (collider != NULL) {
+    ShovelerBoundingBox3 targetBoundingBox3 = shovelerBoundingBox3(
+        shovelerVector3LinearCombination(1.0, boundingBox3.min, 1.0, displacement),
+        shovelerVector3LinearCombination(1.0, boundingBox3.max, 1.0, displacement));
+
+    ShovelerCollider3Contact contact;
+    if (shovelerCollidersSweep3(controller->colliders, &boundingBox3, displacement, &contact) &&
+        (contact.normal.values[0] != 0.0f || contact.normal.values[1] != 0.0f ||
+         contact.normal.values[2] != 0.0f ||
+         shovelerCollidersIntersect3(controller->colliders, &targetBoundingBox3) != NULL)) {
       shovelerLogTrace(
-          "Bumping into 3d collider %p with bounding box (%.2f, %.2f, %.2f)-(%.2f, %.2f, %.2f), "
-          "aborting position shift to (%.2f, %.2f, %.2f).",
-          collider,
-          collider->boundingBox.min.values[0],
-          collider->boundingBox.min.values[1],
-          collider->boundingBox.min.values[2],
-          collider->boundingBox.max.values[0],
-          collider->boundingBox.max.values[1],
-          collider->boundingBox.max.values[2],
+          "Bumping into 3d collider %p with bounding box (%.2f, %.2f, %.2f)-(%.2f, %.2f, %.2f) at "
+          "time %.3f, aborting position shift to (%.2f, %.2f, %.2f).",
+          contact.collider,
+          contact.collider->boundingBox.min.values[0],
+          contact.collider->boundingBox.min.values[1],
+          contact.collider->boundingBox.min.values[2],
+          contact.collider->boundingBox.max.values[0],
+          contact.collider->boundingBox.max.values[1],
+          contact.collider->boundingBox.max.values[2],
+          contact.time,
           targetPosition.values[0],
           targetPosition.values[1],
           targetPosition.values[2]);
-      return false;
+      hit = true;
+      if (contact.time < *outputContactTime) {
+        *outputContactTime = contact.time;
+      }
     }
   }
 
+  if (hit) {
+    return false;
+  }
+
   controller->frame.position = targetPosition;
   triggerMove(controller, controller->frame.position);
   return true;
@@ -69,6 +69,9 @@ ShovelerDrawable* shovelerDrawableCubeCreate() {
   ShovelerDrawable* cube = malloc(sizeof(ShovelerDrawable));
   cube->draw = drawCube;
   cube->free = freeCube;
+  cube->bounded = true;
+  cube->boundingBox = shovelerBoundingBox3(
+      shovelerVector3(-1.0f, -1.0f, -1.0f), shovelerVector3(1.0f, 1.0f, 1.0f));
   cube->data = cubeData;
 
   glGenVertexArrays(1, &cubeData->vertexArrayObject);
@@ -0,0 +1,179 @@
+#include "shoveler/drawable/glyph_instances.h"
+
+#include <glad/glad.h>
+#include <stdbool.h> // bool
+#include <stdlib.h> // malloc, free
+
+#include "shoveler/opengl.h"
+#include "shoveler/shader_program.h"
+
+typedef struct {
+  char position[3];
+  char normal[3];
+  char uv[2];
+} QuadVertex;
+
+typedef struct {
+  unsigned char indices[3];
+} QuadTriangle;
+
+typedef struct {
+  GLuint vertexArrayObject;
+  GLuint vertexBuffer;
+  GLuint indexBuffer;
+  GLuint instanceBuffer;
+  /** number of instances the instance buffer has storage for */
+  int instanceCapacity;
+  int numInstances;
+} GlyphInstancesData;
+
+static bool drawGlyphInstances(ShovelerDrawable* glyphInstances);
+static void freeGlyphInstances(ShovelerDrawable* glyphInstances);
+
+static QuadVertex quadVertices[] = {
+    {{-1, -1, 0}, {0, 0, 1}, {0, 0}},
+    {{1, -1, 0}, {0, 0, 1}, {1, 0}},
+    {{-1, 1, 0}, {0, 0, 1}, {0, 1}},
+    {{1, 1, 0}, {0, 0, 1}, {1, 1}}};
+
+static QuadTriangle quadTriangles[] = {{{0, 1, 2}}, {{1, 3, 2}}};
+
+ShovelerDrawable* shovelerDrawableGlyphInstancesCreate() {
+  GlyphInstancesData* glyphInstancesData = malloc(sizeof(GlyphInstancesData));
+  glyphInstancesData->instanceCapacity = 0;
+  glyphInstancesData->numInstances = 0;
+  ShovelerDrawable* glyphInstances = malloc(sizeof(ShovelerDrawable));
+  glyphInstances->draw = drawGlyphInstances;
+  glyphInstances->free = freeGlyphInstances;
+  glyphInstances->bounded = false;
+  glyphInstances->data = glyphInstancesData;
+
+  glGenVertexArrays(1, &glyphInstancesData->vertexArrayObject);
+  glBindVertexArray(glyphInstancesData->vertexArrayObject);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_POSITION);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_NORMAL);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_UV);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_CORNER);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_SIZE);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_COLOR);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_ATLAS_REGION);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_ATLAS_IS_ROTATED);
+  glVertexAttribFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_POSITION,
+      3,
+      GL_BYTE,
+      GL_FALSE,
+      offsetof(QuadVertex, position));
+  glVertexAttribFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_NORMAL, 3, GL_BYTE, GL_FALSE, offsetof(QuadVertex, normal));
+  glVertexAttribFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_UV, 2, GL_BYTE, GL_FALSE, offsetof(QuadVertex, uv));
+  glVertexAttribFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_CORNER,
+      2,
+      GL_FLOAT,
+      GL_FALSE,
+      offsetof(ShovelerGlyphInstance, corner));
+  glVertexAttribFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_SIZE,
+      2,
+      GL_FLOAT,
+      GL_FALSE,
+      offsetof(ShovelerGlyphInstance, size));
+  glVertexAttribFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_COLOR,
+      4,
+      GL_FLOAT,
+      GL_FALSE,
+      offsetof(ShovelerGlyphInstance, color));
+  // the four consecutive int fields starting at atlasMinX form the atlas region
+  glVertexAttribIFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_ATLAS_REGION,
+      4,
+      GL_INT,
+      offsetof(ShovelerGlyphInstance, atlasMinX));
+  glVertexAttribIFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_ATLAS_IS_ROTATED,
+      1,
+      GL_INT,
+      offsetof(ShovelerGlyphInstance, atlasIsRotated));
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_POSITION, 0);
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_NORMAL, 0);
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_UV, 0);
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_CORNER, 1);
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_SIZE, 1);
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_COLOR, 1);
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_ATLAS_REGION, 1);
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_ATLAS_IS_ROTATED, 1);
+  // advance the instance attributes once per instance instead of once per vertex
+  glVertexBindingDivisor(1, 1);
+
+  glGenBuffers(1, &glyphInstancesData->vertexBuffer);
+  glGenBuffers(1, &glyphInstancesData->indexBuffer);
+  glGenBuffers(1, &glyphInstancesData->instanceBuffer);
+
+  glBindBuffer(GL_ARRAY_BUFFER, glyphInstancesData->vertexBuffer);
+  glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(QuadVertex), quadVertices, GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glyphInstancesData->indexBuffer);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, 2 * sizeof(QuadTriangle), quadTriangles, GL_STATIC_DRAW);
+
+  if (!shovelerOpenGLCheckSuccess()) {
+    freeGlyphInstances(glyphInstances);
+    return NULL;
+  }
+
+  return glyphInstances;
+}
+
+bool shovelerDrawableGlyphInstancesUpdate(
+    ShovelerDrawable* glyphInstances, const ShovelerGlyphInstance* instances, int numInstances) {
+  GlyphInstancesData* glyphInstancesData = glyphInstances->data;
+
+  glBindBuffer(GL_ARRAY_BUFFER, glyphInstancesData->instanceBuffer);
+  if (numInstances > glyphInstancesData->instanceCapacity) {
+    // grow geometrically so that the orphaned storage below keeps a stable size
+    int instanceCapacity = 2 * glyphInstancesData->instanceCapacity;
+    if (instanceCapacity < numInstances) {
+      instanceCapacity = numInstances;
+    }
+    glyphInstancesData->instanceCapacity = instanceCapacity;
+  }
+
+  // Orphan the storage before writing, since draws of earlier texts or passes may still read the
+  // previous contents. The driver hands out fresh storage instead of stalling until they finished.
+  glBufferData(
+      GL_ARRAY_BUFFER,
+      (GLsizeiptr) glyphInstancesData->instanceCapacity * sizeof(ShovelerGlyphInstance),
+      NULL,
+      GL_STREAM_DRAW);
+  glBufferSubData(
+      GL_ARRAY_BUFFER, 0, (GLsizeiptr) numInstances * sizeof(ShovelerGlyphInstance), instances);
+  glyphInstancesData->numInstances = numInstances;
+
+  return shovelerOpenGLCheckSuccess();
+}
+
+static bool drawGlyphInstances(ShovelerDrawable* glyphInstances) {
+  GlyphInstancesData* glyphInstancesData = glyphInstances->data;
+
+  glBindVertexArray(glyphInstancesData->vertexArrayObject);
+  glBindVertexBuffer(0, glyphInstancesData->vertexBuffer, 0, sizeof(QuadVertex));
+  glBindVertexBuffer(
+      1, glyphInstancesData->instanceBuffer, 0, sizeof(ShovelerGlyphInstance));
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glyphInstancesData->indexBuffer);
+  glDrawElementsInstanced(
+      GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, NULL, glyphInstancesData->numInstances);
+
+  return shovelerOpenGLCheckSuccess();
+}
+
+static void freeGlyphInstances(ShovelerDrawable* glyphInstances) {
+  GlyphInstancesData* glyphInstancesData = glyphInstances->data;
+  glDeleteVertexArrays(1, &glyphInstancesData->vertexArrayObject);
+  glDeleteBuffers(1, &glyphInstancesData->vertexBuffer);
+  glDeleteBuffers(1, &glyphInstancesData->indexBuffer);
+  glDeleteBuffers(1, &glyphInstancesData->instanceBuffer);
+
+  free(glyphInstancesData);
+  free(glyphInstances);
+}
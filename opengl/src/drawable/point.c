@@ -26,6 +26,8 @@ ShovelerDrawable* shovelerDrawablePointCreate() {
   ShovelerDrawable* point = malloc(sizeof(ShovelerDrawable));
   point->draw = drawPoint;
   point->free = freePoint;
+  // points are expanded to particles of material dependent size when drawn
+  point->bounded = false;
   point->data = pointData;
 
   glGenVertexArrays(1, &pointData->vertexArrayObject);
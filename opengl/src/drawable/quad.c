@@ -39,6 +39,9 @@ ShovelerDrawable* shovelerDrawableQuadCreate() {
   ShovelerDrawable* quad = malloc(sizeof(ShovelerDrawable));
   quad->draw = drawQuad;
   quad->free = freeQuad;
+  quad->bounded = true;
+  quad->boundingBox =
+      shovelerBoundingBox3(shovelerVector3(-1.0f, -1.0f, 0.0f), shovelerVector3(1.0f, 1.0f, 0.0f));
   quad->data = quadData;
 
   glGenVertexArrays(1, &quadData->vertexArrayObject);
@@ -0,0 +1,163 @@
+#include "shoveler/drawable/sprite_instances.h"
+
+#include <glad/glad.h>
+#include <stdbool.h> // bool
+#include <stdlib.h> // malloc, free
+
+#include "shoveler/opengl.h"
+#include "shoveler/shader_program.h"
+
+typedef struct {
+  char position[3];
+  char normal[3];
+  char uv[2];
+} QuadVertex;
+
+typedef struct {
+  unsigned char indices[3];
+} QuadTriangle;
+
+typedef struct {
+  GLuint vertexArrayObject;
+  GLuint vertexBuffer;
+  GLuint indexBuffer;
+  GLuint instanceBuffer;
+  /** number of instances the instance buffer has storage for */
+  int instanceCapacity;
+  int numInstances;
+} SpriteInstancesData;
+
+static bool drawSpriteInstances(ShovelerDrawable* spriteInstances);
+static void freeSpriteInstances(ShovelerDrawable* spriteInstances);
+
+static QuadVertex quadVertices[] = {
+    {{-1, -1, 0}, {0, 0, 1}, {0, 0}},
+    {{1, -1, 0}, {0, 0, 1}, {1, 0}},
+    {{-1, 1, 0}, {0, 0, 1}, {0, 1}},
+    {{1, 1, 0}, {0, 0, 1}, {1, 1}}};
+
+static QuadTriangle quadTriangles[] = {{{0, 1, 2}}, {{1, 3, 2}}};
+
+ShovelerDrawable* shovelerDrawableSpriteInstancesCreate() {
+  SpriteInstancesData* spriteInstancesData = malloc(sizeof(SpriteInstancesData));
+  spriteInstancesData->instanceCapacity = 0;
+  spriteInstancesData->numInstances = 0;
+  ShovelerDrawable* spriteInstances = malloc(sizeof(ShovelerDrawable));
+  spriteInstances->draw = drawSpriteInstances;
+  spriteInstances->free = freeSpriteInstances;
+  spriteInstances->bounded = false;
+  spriteInstances->data = spriteInstancesData;
+
+  glGenVertexArrays(1, &spriteInstancesData->vertexArrayObject);
+  glBindVertexArray(spriteInstancesData->vertexArrayObject);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_POSITION);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_NORMAL);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_UV);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_POSITION);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_SIZE);
+  glEnableVertexAttribArray(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_TILE);
+  glVertexAttribFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_POSITION,
+      3,
+      GL_BYTE,
+      GL_FALSE,
+      offsetof(QuadVertex, position));
+  glVertexAttribFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_NORMAL, 3, GL_BYTE, GL_FALSE, offsetof(QuadVertex, normal));
+  glVertexAttribFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_UV, 2, GL_BYTE, GL_FALSE, offsetof(QuadVertex, uv));
+  glVertexAttribFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_POSITION,
+      2,
+      GL_FLOAT,
+      GL_FALSE,
+      offsetof(ShovelerSpriteInstance, position));
+  glVertexAttribFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_SIZE,
+      2,
+      GL_FLOAT,
+      GL_FALSE,
+      offsetof(ShovelerSpriteInstance, size));
+  glVertexAttribIFormat(
+      SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_TILE,
+      2,
+      GL_INT,
+      offsetof(ShovelerSpriteInstance, tilesetColumn));
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_POSITION, 0);
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_NORMAL, 0);
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_UV, 0);
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_POSITION, 1);
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_SIZE, 1);
+  glVertexAttribBinding(SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_TILE, 1);
+  // advance the instance attributes once per instance instead of once per vertex
+  glVertexBindingDivisor(1, 1);
+
+  glGenBuffers(1, &spriteInstancesData->vertexBuffer);
+  glGenBuffers(1, &spriteInstancesData->indexBuffer);
+  glGenBuffers(1, &spriteInstancesData->instanceBuffer);
+
+  glBindBuffer(GL_ARRAY_BUFFER, spriteInstancesData->vertexBuffer);
+  glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(QuadVertex), quadVertices, GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, spriteInstancesData->indexBuffer);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, 2 * sizeof(QuadTriangle), quadTriangles, GL_STATIC_DRAW);
+
+  if (!shovelerOpenGLCheckSuccess()) {
+    freeSpriteInstances(spriteInstances);
+    return NULL;
+  }
+
+  return spriteInstances;
+}
+
+bool shovelerDrawableSpriteInstancesUpdate(
+    ShovelerDrawable* spriteInstances, const ShovelerSpriteInstance* instances, int numInstances) {
+  SpriteInstancesData* spriteInstancesData = spriteInstances->data;
+
+  glBindBuffer(GL_ARRAY_BUFFER, spriteInstancesData->instanceBuffer);
+  if (numInstances > spriteInstancesData->instanceCapacity) {
+    // grow geometrically so that the orphaned storage below keeps a stable size
+    int instanceCapacity = 2 * spriteInstancesData->instanceCapacity;
+    if (instanceCapacity < numInstances) {
+      instanceCapacity = numInstances;
+    }
+    spriteInstancesData->instanceCapacity = instanceCapacity;
+  }
+
+  // Orphan the storage before writing, since draws of earlier batches or passes may still read the
+  // previous contents. The driver hands out fresh storage instead of stalling until they finished.
+  glBufferData(
+      GL_ARRAY_BUFFER,
+      (GLsizeiptr) spriteInstancesData->instanceCapacity * sizeof(ShovelerSpriteInstance),
+      NULL,
+      GL_STREAM_DRAW);
+  glBufferSubData(
+      GL_ARRAY_BUFFER, 0, (GLsizeiptr) numInstances * sizeof(ShovelerSpriteInstance), instances);
+  spriteInstancesData->numInstances = numInstances;
+
+  return shovelerOpenGLCheckSuccess();
+}
+
+static bool drawSpriteInstances(ShovelerDrawable* spriteInstances) {
+  SpriteInstancesData* spriteInstancesData = spriteInstances->data;
+
+  glBindVertexArray(spriteInstancesData->vertexArrayObject);
+  glBindVertexBuffer(0, spriteInstancesData->vertexBuffer, 0, sizeof(QuadVertex));
+  glBindVertexBuffer(
+      1, spriteInstancesData->instanceBuffer, 0, sizeof(ShovelerSpriteInstance));
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, spriteInstancesData->indexBuffer);
+  glDrawElementsInstanced(
+      GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, NULL, spriteInstancesData->numInstances);
+
+  return shovelerOpenGLCheckSuccess();
+}
+
+static void freeSpriteInstances(ShovelerDrawable* spriteInstances) {
+  SpriteInstancesData* spriteInstancesData = spriteInstances->data;
+  glDeleteVertexArrays(1, &spriteInstancesData->vertexArrayObject);
+  glDeleteBuffers(1, &spriteInstancesData->vertexBuffer);
+  glDeleteBuffers(1, &spriteInstancesData->indexBuffer);
+  glDeleteBuffers(1, &spriteInstancesData->instanceBuffer);
+
+  free(spriteInstancesData);
+  free(spriteInstances);
+}
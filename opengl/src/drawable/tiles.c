@@ -39,6 +39,9 @@ ShovelerDrawable* shovelerDrawableTilesCreate(unsigned char width, unsigned char
   tiles->drawable.data = tiles;
   tiles->drawable.draw = drawTiles;
   tiles->drawable.free = freeTiles;
+  tiles->drawable.bounded = true;
+  tiles->drawable.boundingBox = shovelerBoundingBox3(
+      shovelerVector3(0.0f, 0.0f, 0.0f), shovelerVector3((float) width, (float) height, 0.0f));
 
   for (unsigned char x = 0; x < width; x++) {
     for (unsigned char y = 0; y < height; y++) {
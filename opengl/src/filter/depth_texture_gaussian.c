@@ -85,6 +85,8 @@ ShovelerFilter* shovelerFilterDepthTextureGaussianCreate(
   depthTextureGaussianFilter->filterModel->scale.values[1] = 2.0f;
   shovelerModelUpdateTransformation(depthTextureGaussianFilter->filterModel);
 
+  depthTextureGaussianFilter->filterSceneRenderPassOptions.type =
+      SHOVELER_SCENE_RENDER_PASS_TYPE_SCREENSPACE;
   depthTextureGaussianFilter->filterSceneRenderPassOptions.overrideMaterial = NULL;
   depthTextureGaussianFilter->filterSceneRenderPassOptions.emitters = false;
   depthTextureGaussianFilter->filterSceneRenderPassOptions.screenspace = true;
@@ -3,6 +3,7 @@
 #include <stdlib.h> // malloc free
 
 #include "shoveler/font_atlas.h"
+#include "shoveler/glyph_run.h"
 #include "shoveler/image.h"
 #include "shoveler/texture.h"
 
@@ -11,6 +12,8 @@ ShovelerFontAtlasTexture* shovelerFontAtlasTextureCreate(ShovelerFontAtlas* font
   fontAtlasTexture->fontAtlas = fontAtlas;
   fontAtlasTexture->atlasImageSize = 0;
   fontAtlasTexture->texture = NULL;
+  fontAtlasTexture->glyphRunBuilder = shovelerGlyphRunBuilderCreateFontAtlas(fontAtlas);
+  fontAtlasTexture->uploadedNumGlyphs = 0;
 
   return fontAtlasTexture;
 }
@@ -18,6 +21,12 @@ ShovelerFontAtlasTexture* shovelerFontAtlasTextureCreate(ShovelerFontAtlas* font
 bool shovelerFontAtlasTextureUpdate(ShovelerFontAtlasTexture* fontAtlasTexture) {
   bool newTextureGenerated = false;
 
+  // Since glyphs are never removed from a font atlas, its image only changed if glyphs were added.
+  unsigned int numGlyphs = g_hash_table_size(fontAtlasTexture->fontAtlas->glyphs);
+  if (fontAtlasTexture->texture != NULL && numGlyphs == fontAtlasTexture->uploadedNumGlyphs) {
+    return false;
+  }
+
   if (fontAtlasTexture->texture == NULL ||
       fontAtlasTexture->atlasImageSize != fontAtlasTexture->fontAtlas->image->width) {
     shovelerTextureFree(fontAtlasTexture->texture);
@@ -26,13 +35,14 @@ bool shovelerFontAtlasTextureUpdate(ShovelerFontAtlasTexture* fontAtlasTexture)
     newTextureGenerated = true;
   }
 
-  // TODO: only update the texture if the font atlas is "dirty"
   shovelerTextureUpdate(fontAtlasTexture->texture);
+  fontAtlasTexture->uploadedNumGlyphs = numGlyphs;
 
   return newTextureGenerated;
 }
 
 void shovelerFontAtlasTextureFree(ShovelerFontAtlasTexture* fontAtlasTexture) {
+  shovelerGlyphRunBuilderFree(fontAtlasTexture->glyphRunBuilder);
   shovelerTextureFree(fontAtlasTexture->texture);
   free(fontAtlasTexture);
 }
@@ -128,7 +128,9 @@ ShovelerGame* shovelerGameCreate(
       controllerSettings->boundingBoxSize3);
   game->fonts = shovelerFontsCreate();
 
-  game->screenspaceCanvas = shovelerCanvasCreate(/* numLayers */ 1);
+  // screenspace sprites are positioned and sized in pixels
+  game->screenspaceCanvas =
+      shovelerCanvasCreateWithCellSize(/* numLayers */ 1, /* cellSize */ 64.0f);
   game->screenspaceCanvasQuad = shovelerDrawableQuadCreate();
   game->screenspaceCanvasMaterial =
       shovelerMaterialCanvasCreate(game->shaderCache, /* screenspace */ true);
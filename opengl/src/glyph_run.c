@@ -0,0 +1,217 @@
+#include "shoveler/glyph_run.h"
+
+#include <stdlib.h> // malloc, free
+#include <string.h> // strlen
+
+#include "shoveler/font.h"
+#include "shoveler/font_atlas.h"
+
+static inline ShovelerFontAtlasGlyph* lookupGlyph(
+    ShovelerGlyphRunBuilder* builder, uint32_t codePoint);
+static ShovelerFontAtlasGlyph* getFontAtlasGlyph(uint32_t codePoint, void* fontAtlasPointer);
+static int getFontAtlasKerning(
+    unsigned int leftGlyphIndex, unsigned int rightGlyphIndex, void* fontAtlasPointer);
+
+ShovelerGlyphRunBuilder* shovelerGlyphRunBuilderCreate(
+    ShovelerGlyphRunGetGlyphFunction* getGlyph,
+    ShovelerGlyphRunGetKerningFunction* getKerning,
+    int fontSize,
+    void* userData) {
+  ShovelerGlyphRunBuilder* builder = malloc(sizeof(ShovelerGlyphRunBuilder));
+  builder->getGlyph = getGlyph;
+  builder->getKerning = getKerning;
+  builder->userData = userData;
+  builder->fontSize = fontSize;
+  builder->runs =
+      g_array_new(/* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerGlyphRun));
+  builder->instances =
+      g_array_new(/* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerGlyphInstance));
+  for (int i = 0; i < SHOVELER_GLYPH_RUN_NUM_CACHED_CODE_POINTS; i++) {
+    builder->cachedGlyphs[i] = NULL;
+  }
+  return builder;
+}
+
+ShovelerGlyphRunBuilder* shovelerGlyphRunBuilderCreateFontAtlas(ShovelerFontAtlas* fontAtlas) {
+  FT_Face face = fontAtlas->font->face;
+  bool hasKerning = FT_HAS_KERNING(face) && face->units_per_EM > 0;
+  return shovelerGlyphRunBuilderCreate(
+      getFontAtlasGlyph,
+      hasKerning ? getFontAtlasKerning : NULL,
+      fontAtlas->fontSize,
+      fontAtlas);
+}
+
+void shovelerGlyphRunBuilderClear(ShovelerGlyphRunBuilder* builder) {
+  g_array_set_size(builder->runs, 0);
+  g_array_set_size(builder->instances, 0);
+}
+
+guint shovelerGlyphRunBuilderAdd(
+    ShovelerGlyphRunBuilder* builder,
+    const char* text,
+    ShovelerVector2 origin,
+    float size,
+    ShovelerVector4 color) {
+  ShovelerGlyphRun run;
+  run.firstInstance = builder->instances->len;
+  run.numInstances = 0;
+  run.numCodePoints = 0;
+  run.width = 0.0f;
+  run.heightTop = 0.0f;
+  run.heightBottom = 0.0f;
+
+  // Every code point takes at least one byte, so the string length bounds the number of glyphs.
+  // Growing the array once up front lets the loop write instances without bounds checks.
+  g_array_set_size(builder->instances, run.firstInstance + (guint) strlen(text));
+  ShovelerGlyphInstance* instances =
+      &g_array_index(builder->instances, ShovelerGlyphInstance, run.firstInstance);
+
+  float scale = size / (float) builder->fontSize;
+  // pen position in 26.6 fixed point pixels, so that advances and kerning add up exactly
+  int penX = 0;
+  ShovelerFontAtlasGlyph* previousGlyph = NULL;
+  for (const char* c = text; *c != '\0';) {
+    uint32_t codePoint;
+    c += shovelerGlyphRunDecodeUtf8(c, &codePoint);
+    run.numCodePoints++;
+
+    ShovelerFontAtlasGlyph* glyph = lookupGlyph(builder, codePoint);
+    if (glyph == NULL) {
+      continue;
+    }
+
+    if (previousGlyph != NULL && builder->getKerning != NULL) {
+      penX += builder->getKerning(previousGlyph->index, glyph->index, builder->userData);
+    }
+
+    float left = penX / 64.0f + glyph->bearingX;
+    float right = left + glyph->width;
+    float bottom = (float) (glyph->bearingY - glyph->height);
+    if (right > run.width) {
+      run.width = right;
+    }
+    if (glyph->bearingY > run.heightTop) {
+      run.heightTop = glyph->bearingY;
+    }
+    if (-bottom > run.heightBottom) {
+      run.heightBottom = -bottom;
+    }
+
+    // glyphs without pixels such as spaces only advance the pen
+    if (glyph->width > 0 && glyph->height > 0) {
+      ShovelerGlyphInstance* instance = &instances[run.numInstances++];
+      instance->corner = shovelerVector2(
+          origin.values[0] + scale * left, origin.values[1] + scale * bottom);
+      instance->size = shovelerVector2(scale * glyph->width, scale * glyph->height);
+      instance->color = color;
+      instance->atlasMinX = glyph->minX;
+      instance->atlasMinY = glyph->minY;
+      instance->atlasWidth = glyph->width;
+      instance->atlasHeight = glyph->height;
+      instance->atlasIsRotated = glyph->isRotated ? 1 : 0;
+    }
+
+    penX += glyph->advance;
+    previousGlyph = glyph;
+  }
+
+  g_array_set_size(builder->instances, run.firstInstance + run.numInstances);
+
+  run.width *= scale;
+  run.heightTop *= scale;
+  run.heightBottom *= scale;
+  g_array_append_val(builder->runs, run);
+  return builder->runs->len - 1;
+}
+
+void shovelerGlyphRunBuilderFree(ShovelerGlyphRunBuilder* builder) {
+  if (builder == NULL) {
+    return;
+  }
+
+  g_array_free(builder->instances, /* freeSegment */ true);
+  g_array_free(builder->runs, /* freeSegment */ true);
+  free(builder);
+}
+
+int shovelerGlyphRunDecodeUtf8(const char* string, uint32_t* outputCodePoint) {
+  const unsigned char* bytes = (const unsigned char*) string;
+  unsigned char leadByte = bytes[0];
+  if (leadByte < 0x80) {
+    *outputCodePoint = leadByte;
+    return 1;
+  }
+
+  int length;
+  uint32_t codePoint;
+  uint32_t minCodePoint;
+  if ((leadByte & 0xE0) == 0xC0) {
+    length = 2;
+    codePoint = leadByte & 0x1F;
+    minCodePoint = 0x80;
+  } else if ((leadByte & 0xF0) == 0xE0) {
+    length = 3;
+    codePoint = leadByte & 0x0F;
+    minCodePoint = 0x800;
+  } else if ((leadByte & 0xF8) == 0xF0) {
+    length = 4;
+    codePoint = leadByte & 0x07;
+    minCodePoint = 0x10000;
+  } else {
+    *outputCodePoint = SHOVELER_GLYPH_RUN_REPLACEMENT_CHARACTER;
+    return 1;
+  }
+
+  // a truncated sequence stops at the terminator, which isn't a continuation byte
+  for (int i = 1; i < length; i++) {
+    if ((bytes[i] & 0xC0) != 0x80) {
+      *outputCodePoint = SHOVELER_GLYPH_RUN_REPLACEMENT_CHARACTER;
+      return 1;
+    }
+    codePoint = (codePoint << 6) | (bytes[i] & 0x3F);
+  }
+
+  // reject overlong encodings, UTF-16 surrogates and code points beyond the Unicode range
+  if (codePoint < minCodePoint || (codePoint >= 0xD800 && codePoint <= 0xDFFF) ||
+      codePoint > 0x10FFFF) {
+    *outputCodePoint = SHOVELER_GLYPH_RUN_REPLACEMENT_CHARACTER;
+    return 1;
+  }
+
+  *outputCodePoint = codePoint;
+  return length;
+}
+
+static inline ShovelerFontAtlasGlyph* lookupGlyph(
+    ShovelerGlyphRunBuilder* builder, uint32_t codePoint) {
+  if (codePoint >= SHOVELER_GLYPH_RUN_NUM_CACHED_CODE_POINTS) {
+    return builder->getGlyph(codePoint, builder->userData);
+  }
+
+  if (builder->cachedGlyphs[codePoint] == NULL) {
+    builder->cachedGlyphs[codePoint] = builder->getGlyph(codePoint, builder->userData);
+  }
+  return builder->cachedGlyphs[codePoint];
+}
+
+static ShovelerFontAtlasGlyph* getFontAtlasGlyph(uint32_t codePoint, void* fontAtlasPointer) {
+  return shovelerFontAtlasGetGlyph((ShovelerFontAtlas*) fontAtlasPointer, codePoint);
+}
+
+static int getFontAtlasKerning(
+    unsigned int leftGlyphIndex, unsigned int rightGlyphIndex, void* fontAtlasPointer) {
+  ShovelerFontAtlas* fontAtlas = fontAtlasPointer;
+  FT_Face face = fontAtlas->font->face;
+
+  // Other atlases of the same font may have changed the face's pixel size since this one was
+  // created, so the kerning is requested in font units and scaled to the atlas' font size.
+  FT_Vector kerning;
+  FT_Error error =
+      FT_Get_Kerning(face, leftGlyphIndex, rightGlyphIndex, FT_KERNING_UNSCALED, &kerning);
+  if (error != FT_Err_Ok) {
+    return 0;
+  }
+
+  return (int) (kerning.x * 64 * fontAtlas->fontSize / face->units_per_EM);
+}
@@ -0,0 +1,106 @@
+#include <shoveler/font_atlas.h>
+#include <shoveler/glyph_run.h>
+#include <shoveler/log.h>
+#include <shoveler/types.h>
+#include <stdlib.h> // EXIT_SUCCESS, rand
+
+#define NUM_STRINGS 2000
+#define MAX_STRING_LENGTH 48
+#define NUM_FRAMES 200
+#define NUM_GLYPHS 1024
+#define FONT_SIZE 32
+
+static ShovelerFontAtlasGlyph glyphs[NUM_GLYPHS];
+
+static ShovelerFontAtlasGlyph* getGlyph(uint32_t codePoint, void* userData);
+static int getKerning(unsigned int leftGlyphIndex, unsigned int rightGlyphIndex, void* userData);
+static void generateStrings(char strings[][MAX_STRING_LENGTH * 4 + 1], bool multibyte);
+static void runBenchmark(const char* name, char strings[][MAX_STRING_LENGTH * 4 + 1]);
+
+int main(int argc, char* argv[]) {
+  shovelerLogInit("shoveler/", SHOVELER_LOG_LEVEL_INFO_UP, stdout);
+  srand(0);
+
+  // Synthetic metrics stand in for a font, since the builder only sees glyphs through callbacks.
+  for (int i = 0; i < NUM_GLYPHS; i++) {
+    glyphs[i].index = i;
+    glyphs[i].minX = (i % 32) * FONT_SIZE;
+    glyphs[i].minY = (i / 32) * FONT_SIZE;
+    glyphs[i].width = i == ' ' ? 0 : FONT_SIZE / 2 + i % 8;
+    glyphs[i].height = i == ' ' ? 0 : FONT_SIZE - i % 12;
+    glyphs[i].bearingX = 1;
+    glyphs[i].bearingY = FONT_SIZE - FONT_SIZE / 4;
+    glyphs[i].advance = (FONT_SIZE / 2 + 10) * 64;
+    glyphs[i].isRotated = i % 5 == 0;
+  }
+
+  static char strings[NUM_STRINGS][MAX_STRING_LENGTH * 4 + 1];
+  generateStrings(strings, /* multibyte */ false);
+  runBenchmark("ASCII", strings);
+  generateStrings(strings, /* multibyte */ true);
+  runBenchmark("UTF-8", strings);
+
+  shovelerLogTerminate();
+
+  return EXIT_SUCCESS;
+}
+
+static ShovelerFontAtlasGlyph* getGlyph(uint32_t codePoint, void* userData) {
+  return &glyphs[codePoint % NUM_GLYPHS];
+}
+
+static int getKerning(unsigned int leftGlyphIndex, unsigned int rightGlyphIndex, void* userData) {
+  return (leftGlyphIndex + rightGlyphIndex) % 7 == 0 ? -64 : 0;
+}
+
+/** Generates random words of printable ASCII or, if multibyte, a mix with two byte code points. */
+static void generateStrings(char strings[][MAX_STRING_LENGTH * 4 + 1], bool multibyte) {
+  for (int i = 0; i < NUM_STRINGS; i++) {
+    int length = 1 + rand() % MAX_STRING_LENGTH;
+    char* c = strings[i];
+    for (int j = 0; j < length; j++) {
+      if (rand() % 6 == 0) {
+        *c++ = ' ';
+      } else if (multibyte && rand() % 3 == 0) {
+        uint32_t codePoint = 0xC0 + rand() % (NUM_GLYPHS - 0xC0);
+        *c++ = (char) (0xC0 | (codePoint >> 6));
+        *c++ = (char) (0x80 | (codePoint & 0x3F));
+      } else {
+        *c++ = (char) ('a' + rand() % 26);
+      }
+    }
+    *c = '\0';
+  }
+}
+
+static void runBenchmark(const char* name, char strings[][MAX_STRING_LENGTH * 4 + 1]) {
+  ShovelerGlyphRunBuilder* builder =
+      shovelerGlyphRunBuilderCreate(getGlyph, getKerning, FONT_SIZE, /* userData */ NULL);
+
+  gint64 numCodePoints = 0;
+  gint64 startTime = g_get_monotonic_time();
+  for (int frame = 0; frame < NUM_FRAMES; frame++) {
+    shovelerGlyphRunBuilderClear(builder);
+    for (int i = 0; i < NUM_STRINGS; i++) {
+      ShovelerVector2 origin = shovelerVector2((float) (i % 40) * 100.0f, (float) (i / 40) * 20.0f);
+      guint runIndex = shovelerGlyphRunBuilderAdd(
+          builder, strings[i], origin, 16.0f, shovelerVector4(1.0f, 1.0f, 1.0f, 1.0f));
+      numCodePoints += shovelerGlyphRunBuilderGetRun(builder, runIndex)->numCodePoints;
+    }
+  }
+  gint64 buildTimeUs = g_get_monotonic_time() - startTime;
+
+  guint numInstances = builder->instances->len;
+  shovelerLogInfo(
+      "%s: built %u glyph quads of %lld code points in %d strings per frame in %.3fms (%.1f "
+      "million glyphs per second), drawn with one instanced draw call instead of %u.",
+      name,
+      numInstances,
+      (long long) (numCodePoints / NUM_FRAMES),
+      NUM_STRINGS,
+      (double) buildTimeUs / NUM_FRAMES / 1000.0,
+      (double) numInstances * NUM_FRAMES / buildTimeUs,
+      numInstances);
+
+  shovelerGlyphRunBuilderFree(builder);
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include <map>
+
+extern "C" {
+#include "shoveler/font_atlas.h"
+#include "shoveler/glyph_run.h"
+}
+
+static const int testFontSize = 16;
+static const int testKerningA = 'A';
+static const int testKerningV = 'V';
+
+class ShovelerGlyphRunTest : public ::testing::Test {
+public:
+  virtual void SetUp() {
+    numGetGlyphCalls = 0;
+    builder = shovelerGlyphRunBuilderCreate(getGlyph, getKerning, testFontSize, this);
+  }
+
+  virtual void TearDown() { shovelerGlyphRunBuilderFree(builder); }
+
+  const ShovelerGlyphRun* add(const char* text, float x = 0.0f, float size = testFontSize) {
+    guint runIndex = shovelerGlyphRunBuilderAdd(
+        builder, text, shovelerVector2(x, 0.0f), size, shovelerVector4(1.0f, 1.0f, 1.0f, 1.0f));
+    return shovelerGlyphRunBuilderGetRun(builder, runIndex);
+  }
+
+  const ShovelerGlyphInstance* getInstance(guint index) {
+    return &g_array_index(builder->instances, ShovelerGlyphInstance, index);
+  }
+
+  /** Every glyph is 8x10 pixels with a bearing of (1, 8) and an advance of 10 pixels, except for
+   * spaces which have no pixels. The atlas position encodes the code point. */
+  static ShovelerFontAtlasGlyph* getGlyph(uint32_t codePoint, void* testPointer) {
+    ShovelerGlyphRunTest* test = (ShovelerGlyphRunTest*) testPointer;
+    test->numGetGlyphCalls++;
+
+    ShovelerFontAtlasGlyph& glyph = test->glyphs[codePoint];
+    glyph.index = codePoint;
+    glyph.minX = (int) codePoint;
+    glyph.minY = 0;
+    glyph.width = codePoint == ' ' ? 0 : 8;
+    glyph.height = codePoint == ' ' ? 0 : 10;
+    glyph.bearingX = 1;
+    glyph.bearingY = 8;
+    glyph.advance = 10 * 64;
+    glyph.isRotated = false;
+    return &glyph;
+  }
+
+  static int getKerning(unsigned int leftGlyphIndex, unsigned int rightGlyphIndex, void*) {
+    if (leftGlyphIndex == testKerningA && rightGlyphIndex == testKerningV) {
+      return -2 * 64;
+    }
+    return 0;
+  }
+
+  ShovelerGlyphRunBuilder* builder;
+  std::map<uint32_t, ShovelerFontAtlasGlyph> glyphs;
+  int numGetGlyphCalls;
+};
+
+static uint32_t decode(const char* string, int* outputLength = NULL) {
+  uint32_t codePoint;
+  int length = shovelerGlyphRunDecodeUtf8(string, &codePoint);
+  if (outputLength != NULL) {
+    *outputLength = length;
+  }
+  return codePoint;
+}
+
+TEST_F(ShovelerGlyphRunTest, decodeUtf8) {
+  int length;
+  ASSERT_EQ(decode("a", &length), 'a');
+  ASSERT_EQ(length, 1);
+  ASSERT_EQ(decode("\xC3\xA9", &length), 0xE9); // é
+  ASSERT_EQ(length, 2);
+  ASSERT_EQ(decode("\xE2\x82\xAC", &length), 0x20AC); // €
+  ASSERT_EQ(length, 3);
+  ASSERT_EQ(decode("\xF0\x9F\x98\x80", &length), 0x1F600); // 😀
+  ASSERT_EQ(length, 4);
+}
+
+TEST_F(ShovelerGlyphRunTest, decodeInvalidUtf8) {
+  const char* invalidSequences[] = {
+      "\x80", // lone continuation byte
+      "\xFF", // invalid lead byte
+      "\xC0\x80", // overlong encoding of NUL
+      "\xE0\x80\xAF", // overlong encoding of '/'
+      "\xED\xA0\x80", // UTF-16 surrogate
+      "\xF4\x90\x80\x80", // beyond U+10FFFF
+      "\xE2\x82", // truncated by the terminator
+      "\xE2\x82" "a", // truncated by an ASCII character
+  };
+
+  for (const char* invalidSequence : invalidSequences) {
+    int length;
+    ASSERT_EQ(decode(invalidSequence, &length), SHOVELER_GLYPH_RUN_REPLACEMENT_CHARACTER)
+        << invalidSequence;
+    ASSERT_EQ(length, 1) << "decoding must resume at the next byte";
+  }
+}
+
+TEST_F(ShovelerGlyphRunTest, layoutGlyphs) {
+  const ShovelerGlyphRun* run = add("ab", /* x */ 5.0f);
+
+  ASSERT_EQ(run->firstInstance, 0);
+  ASSERT_EQ(run->numInstances, 2);
+  ASSERT_EQ(run->numCodePoints, 2);
+  ASSERT_FLOAT_EQ(getInstance(0)->corner.values[0], 5.0f + 1.0f);
+  ASSERT_FLOAT_EQ(getInstance(0)->corner.values[1], -2.0f);
+  ASSERT_FLOAT_EQ(getInstance(0)->size.values[0], 8.0f);
+  ASSERT_FLOAT_EQ(getInstance(0)->size.values[1], 10.0f);
+  ASSERT_FLOAT_EQ(getInstance(1)->corner.values[0], 5.0f + 10.0f + 1.0f);
+  ASSERT_EQ(getInstance(0)->atlasMinX, 'a');
+  ASSERT_EQ(getInstance(1)->atlasMinX, 'b');
+  ASSERT_FLOAT_EQ(run->width, 10.0f + 1.0f + 8.0f);
+  ASSERT_FLOAT_EQ(run->heightTop, 8.0f);
+  ASSERT_FLOAT_EQ(run->heightBottom, 2.0f);
+}
+
+TEST_F(ShovelerGlyphRunTest, layoutMultibyteCodePoints) {
+  const ShovelerGlyphRun* run = add("\xC3\xA9\xE2\x82\xAC"); // é€
+
+  ASSERT_EQ(run->numInstances, 2) << "each code point should produce one glyph, not each byte";
+  ASSERT_EQ(run->numCodePoints, 2);
+  ASSERT_EQ(getInstance(0)->atlasMinX, 0xE9);
+  ASSERT_EQ(getInstance(1)->atlasMinX, 0x20AC);
+}
+
+TEST_F(ShovelerGlyphRunTest, applyKerning) {
+  add("AB");
+  add("AV");
+
+  float unkernedX = getInstance(1)->corner.values[0];
+  float kernedX = getInstance(3)->corner.values[0];
+  ASSERT_FLOAT_EQ(kernedX, unkernedX - 2.0f);
+}
+
+TEST_F(ShovelerGlyphRunTest, spacesOnlyAdvance) {
+  const ShovelerGlyphRun* run = add("a b");
+
+  ASSERT_EQ(run->numInstances, 2);
+  ASSERT_EQ(run->numCodePoints, 3);
+  ASSERT_FLOAT_EQ(getInstance(1)->corner.values[0], 20.0f + 1.0f);
+}
+
+TEST_F(ShovelerGlyphRunTest, scaleToSize) {
+  const ShovelerGlyphRun* run = add("ab", /* x */ 5.0f, /* size */ 2.0f * testFontSize);
+
+  ASSERT_FLOAT_EQ(getInstance(1)->corner.values[0], 5.0f + 2.0f * (10.0f + 1.0f));
+  ASSERT_FLOAT_EQ(getInstance(1)->size.values[0], 16.0f);
+  ASSERT_FLOAT_EQ(run->width, 2.0f * (10.0f + 1.0f + 8.0f));
+}
+
+TEST_F(ShovelerGlyphRunTest, batchStrings) {
+  add("abc");
+  add("");
+  add("de", /* x */ 100.0f);
+  ASSERT_EQ(builder->runs->len, 3);
+  ASSERT_EQ(builder->instances->len, 5);
+
+  const ShovelerGlyphRun* lastRun = shovelerGlyphRunBuilderGetRun(builder, 2);
+  ASSERT_EQ(lastRun->firstInstance, 3);
+  ASSERT_EQ(lastRun->numInstances, 2);
+  ASSERT_EQ(shovelerGlyphRunGetInstances(builder, lastRun)->atlasMinX, 'd');
+  ASSERT_FLOAT_EQ(shovelerGlyphRunGetInstances(builder, lastRun)->corner.values[0], 101.0f);
+  ASSERT_EQ(shovelerGlyphRunBuilderGetRun(builder, 1)->numInstances, 0);
+
+  shovelerGlyphRunBuilderClear(builder);
+  ASSERT_EQ(builder->runs->len, 0);
+  ASSERT_EQ(builder->instances->len, 0);
+}
+
+TEST_F(ShovelerGlyphRunTest, cacheAsciiGlyphs) {
+  add("aaaa");
+  add("a\xC3\xA9\xC3\xA9");
+
+  ASSERT_EQ(numGetGlyphCalls, 1 + 2) << "only non-ASCII glyphs should be looked up repeatedly";
+}
@@ -14,6 +14,13 @@ typedef struct {
   ShovelerCamera* camera;
   ShovelerLightSpotShared* shared;
   bool manageShared;
+  ShovelerFilter* depthFilter;
+  /** incremented whenever the light moves */
+  guint64 positionVersion;
+  /** scene the current shadow map was rendered for, or NULL if there is none yet */
+  ShovelerScene* shadowMapScene;
+  guint64 shadowMapPositionVersion;
+  guint64 shadowMapCasterHash;
 } ShovelerLightSpot;
 
 static void updatePosition(void* spotlightPointer, ShovelerVector3 position);
@@ -40,8 +47,7 @@ ShovelerLightSpotShared* shovelerLightSpotSharedCreate(
   shared->shadowMapSampler = shovelerSamplerCreate(true, true, true);
   shared->depthFramebuffer = shovelerFramebufferCreateDepthOnly(width, height, samples);
   shared->depthMaterial = shovelerMaterialDepthCreate(shaderCache, /* screenspace */ false);
-  shared->depthFilter = shovelerFilterDepthTextureGaussianCreate(
-      shaderCache, width, height, samples, exponentialFactor);
+  shared->depthRenderPassOptions.type = SHOVELER_SCENE_RENDER_PASS_TYPE_SHADOW_MAP;
   shared->depthRenderPassOptions.overrideMaterial = shared->depthMaterial;
   shared->depthRenderPassOptions.emitters = false;
   shared->depthRenderPassOptions.screenspace = false;
@@ -52,6 +58,9 @@ ShovelerLightSpotShared* shovelerLightSpotSharedCreate(
   shared->depthRenderPassOptions.renderState.depthTest = true;
   shared->depthRenderPassOptions.renderState.depthFunction = GL_LESS;
   shared->depthRenderPassOptions.renderState.depthMask = GL_TRUE;
+  shared->width = width;
+  shared->height = height;
+  shared->samples = samples;
   shared->ambientFactor = ambientFactor;
   shared->exponentialFactor = exponentialFactor;
   shared->color = color;
@@ -71,6 +80,16 @@ ShovelerLight* shovelerLightSpotCreateWithShared(
   spotlight->camera = camera;
   spotlight->shared = shared;
   spotlight->manageShared = managedShared;
+  spotlight->depthFilter = shovelerFilterDepthTextureGaussianCreate(
+      shared->shaderCache,
+      shared->width,
+      shared->height,
+      shared->samples,
+      shared->exponentialFactor);
+  spotlight->positionVersion = 0;
+  spotlight->shadowMapScene = NULL;
+  spotlight->shadowMapPositionVersion = 0;
+  spotlight->shadowMapCasterHash = 0;
 
   shovelerUniformMapInsert(
       spotlight->light.uniforms, "isExponentialLiftedShadowMap", shovelerUniformCreateInt(1));
@@ -102,7 +121,7 @@ ShovelerLight* shovelerLightSpotCreateWithShared(
       spotlight->light.uniforms,
       "shadowMap",
       shovelerUniformCreateTexture(
-          spotlight->shared->depthFilter->outputTexture, spotlight->shared->shadowMapSampler));
+          spotlight->depthFilter->outputTexture, spotlight->shared->shadowMapSampler));
 
   return &spotlight->light;
 }
@@ -112,7 +131,6 @@ void shovelerLightSpotSharedFree(ShovelerLightSpotShared* shared) {
     return;
   }
 
-  shovelerFilterFree(shared->depthFilter);
   shovelerMaterialFree(shared->depthMaterial);
   shovelerFramebufferFree(shared->depthFramebuffer, /* keepTargets */ false);
   shovelerSamplerFree(shared->shadowMapSampler);
@@ -124,6 +142,7 @@ static void updatePosition(void* spotlightPointer, ShovelerVector3 position) {
   ShovelerLightSpot* spotlight = (ShovelerLightSpot*) spotlightPointer;
   spotlight->camera->position = position;
   shovelerCameraUpdateView(spotlight->camera);
+  spotlight->positionVersion++;
 }
 
 static ShovelerVector3 getPosition(void* spotlightPointer) {
@@ -146,18 +165,27 @@ static int renderSpotLight(
 
   int rendered = 0;
 
-  // render depth map
-  shovelerFramebufferUse(spotlight->shared->depthFramebuffer);
-  glClear(GL_DEPTH_BUFFER_BIT);
-
-  rendered += shovelerSceneRenderPass(
-      scene, spotlight->camera, NULL, spotlight->shared->depthRenderPassOptions, renderState);
-
-  // filter depth map
-  rendered += shovelerFilterRender(
-      spotlight->shared->depthFilter,
-      spotlight->shared->depthFramebuffer->depthTarget,
-      renderState);
+  guint64 casterHash = shovelerSceneHashShadowCasters(scene, spotlight->camera);
+  if (spotlight->shadowMapScene == scene &&
+      spotlight->shadowMapPositionVersion == spotlight->positionVersion &&
+      spotlight->shadowMapCasterHash == casterHash) {
+    scene->renderPassStats[SHOVELER_SCENE_RENDER_PASS_TYPE_SHADOW_MAP].numSkippedPasses++;
+  } else {
+    // render depth map
+    shovelerFramebufferUse(spotlight->shared->depthFramebuffer);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    rendered += shovelerSceneRenderPass(
+        scene, spotlight->camera, NULL, spotlight->shared->depthRenderPassOptions, renderState);
+
+    // filter depth map
+    rendered += shovelerFilterRender(
+        spotlight->depthFilter, spotlight->shared->depthFramebuffer->depthTarget, renderState);
+
+    spotlight->shadowMapScene = scene;
+    spotlight->shadowMapPositionVersion = spotlight->positionVersion;
+    spotlight->shadowMapCasterHash = casterHash;
+  }
 
   // render additive light to scene
   shovelerFramebufferUse(framebuffer);
@@ -178,6 +206,7 @@ static void freeSpotLight(void* spotlightPointer) {
 
   shovelerCameraFree(spotlight->camera);
   shovelerUniformMapFree(spotlight->light.uniforms);
+  shovelerFilterFree(spotlight->depthFilter);
 
   if (spotlight->manageShared) {
     shovelerLightSpotSharedFree(spotlight->shared);
@@ -55,6 +55,7 @@ void shovelerMaterialFree(ShovelerMaterial* material) {
   shovelerUniformMapFree(material->uniforms);
 
   if (material->manageProgram) {
+    shovelerShaderCacheInvalidateProgram(material->shaderCache, material->program);
     glDeleteProgram(material->program);
   }
 
@@ -3,8 +3,11 @@
 #include <stdlib.h> // malloc free
 
 #include "shoveler/camera.h"
+#include "shoveler/drawable.h"
+#include "shoveler/drawable/glyph_instances.h"
 #include "shoveler/font_atlas.h"
 #include "shoveler/font_atlas_texture.h"
+#include "shoveler/glyph_run.h"
 #include "shoveler/light.h"
 #include "shoveler/log.h"
 #include "shoveler/material.h"
@@ -14,127 +17,145 @@
 #include "shoveler/shader.h"
 #include "shoveler/shader_cache.h"
 #include "shoveler/shader_program.h"
-#include "shoveler/shader_program/model_vertex.h"
 
-static const char* fragmentShaderSource =
+// Text is drawn directly as one instanced quad per glyph, with the glyph's atlas rectangle passed
+// as per-instance attributes. In screenspace, each quad only covers the glyph's part of the canvas
+// region. Projected canvases are lit in additive passes testing depth for equality with the depth
+// pre-pass of the canvas quad, so there each quad covers the whole region with the canvas quad's
+// exact vertex transform, and fragments outside the glyph are cleared.
+static const char* vertexShaderSourceHeader =
     "#version 400\n"
     "\n"
-    "uniform bool sceneDebugMode;\n"
+    "uniform mat4 model;\n"
+    "uniform mat4 modelNormal;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "uniform mat4 lightView;\n"
+    "uniform mat4 lightProjection;\n"
     "uniform vec2 regionPosition;\n"
     "uniform vec2 regionSize;\n"
-    "uniform sampler2D fontAtlas;\n"
-    "uniform uint fontSize;\n"
-    "uniform vec2 textCorner;\n"
-    "uniform float textSize;\n"
-    "uniform vec4 textColor;\n"
-    "uniform float characterAdvance;\n"
-    "uniform uint glyphMinX;\n"
-    "uniform uint glyphMinY;\n"
-    "uniform uint glyphWidth;\n"
-    "uniform uint glyphHeight;\n"
-    "uniform uint glyphBearingX;\n"
-    "uniform uint glyphBearingY;\n"
-    "uniform bool glyphIsRotated;\n"
     "\n"
-    "flat in vec2 fragmentPosition;\n"
-    "in vec2 fragmentUv;\n"
-    ""
-    "in vec3 worldPosition;\n"
-    "in vec3 worldNormal;\n"
-    "in vec2 worldUv;\n"
-    "in vec4 lightFrustumPosition4;\n"
+    "in vec3 position;\n"
+    "in vec3 normal;\n"
+    "in vec2 uv;\n"
+    "in vec2 glyphCorner;\n"
+    "in vec2 glyphSize;\n"
+    "in vec4 glyphColor;\n"
+    "in ivec4 glyphAtlasRegion;\n"
+    "in int glyphAtlasIsRotated;\n"
     "\n"
-    "out vec4 fragmentColor;\n"
+    "out vec3 worldPosition;\n"
+    "out vec3 worldNormal;\n"
+    "out vec2 worldUv;\n"
+    "out vec4 lightFrustumPosition4;\n"
+    "out vec2 glyphUv;\n"
+    "flat out vec4 fragmentGlyphColor;\n"
+    "flat out ivec4 fragmentGlyphAtlasRegion;\n"
+    "flat out int fragmentGlyphAtlasIsRotated;\n"
     "\n"
-    "vec2 getSpriteUv(vec2 spriteCorner, vec2 spriteSize) {\n"
-    "	// Compute the UV coordinate offset of this fragment from the sprite corner.\n"
-    "	vec2 regionCorner = regionPosition - 0.5 * regionSize;\n"
-    "	vec2 spriteOffset = spriteCorner - regionCorner;\n"
-    "	vec2 spriteCornerRegionUv = spriteOffset / regionSize;\n"
-    "	vec2 spriteWorldUvOffset = worldUv - spriteCornerRegionUv;\n"
+    "void main()\n"
+    "{\n"
+    "	vec2 regionCorner = regionPosition - 0.5 * regionSize;\n";
+
+static const char* vertexShaderSourceProjectedQuad =
+    "	vec4 worldPosition4 = model * vec4(position, 1.0);\n"
+    "	worldUv = uv;\n"
+    "	glyphUv = (regionCorner + uv * regionSize - glyphCorner) / glyphSize;\n";
+
+static const char* vertexShaderSourceScreenspaceQuad =
+    "	vec2 regionUv = (glyphCorner + uv * glyphSize - regionCorner) / regionSize;\n"
+    "	vec4 worldPosition4 = model * vec4(2.0 * regionUv - 1.0, position.z, 1.0);\n"
+    "	worldUv = regionUv;\n"
+    "	glyphUv = uv;\n";
+
+static const char* vertexShaderSourceBody =
+    "	vec4 worldNormal4 = modelNormal * vec4(normal, 1.0);\n"
+    "	worldPosition = worldPosition4.xyz / worldPosition4.w;\n"
+    "	worldNormal = worldNormal4.xyz / worldNormal4.w;\n"
+    "	fragmentGlyphColor = glyphColor;\n"
+    "	fragmentGlyphAtlasRegion = glyphAtlasRegion;\n"
+    "	fragmentGlyphAtlasIsRotated = glyphAtlasIsRotated;\n"
     ""
-    "	// Compute the UV coordinates of the sprite of this fragment within a hypothetical sprite "
-    "texture.\n"
-    "	vec2 spriteUvScale = regionSize / spriteSize;\n"
-    "	vec2 spriteUv = spriteWorldUvOffset * spriteUvScale;\n"
-    "	return spriteUv;\n"
-    "}\n"
+    "	lightFrustumPosition4 = lightProjection * lightView * worldPosition4;\n";
+
+static const char* vertexShaderSourceProjectedFooter =
+    "	gl_Position = projection * view * worldPosition4;\n"
+    "}\n";
+
+static const char* vertexShaderSourceScreenspaceFooter =
+    "	gl_Position = vec4(worldPosition, 1.0);\n"
+    "}\n";
+
+static const char* fragmentShaderSourceHeader =
+    "#version 400\n"
+    "\n"
+    "uniform bool sceneDebugMode;\n"
+    "uniform sampler2D fontAtlas;\n"
+    "\n"
+    "in vec2 glyphUv;\n"
+    "flat in vec4 fragmentGlyphColor;\n"
+    "flat in ivec4 fragmentGlyphAtlasRegion;\n"
+    "flat in int fragmentGlyphAtlasIsRotated;\n"
     "\n"
-    "vec2 getFontAtlasUv(vec2 glyphUv) {\n"
-    "	vec2 fontAtlasGlyphCorner = vec2(glyphMinX, glyphMinY);\n"
+    "out vec4 fragmentColor;\n"
+    "\n"
+    "void main()\n"
+    "{\n";
+
+static const char* fragmentShaderSourceProjectedClip =
+    "	if (glyphUv.x < 0.0 ||\n"
+    "		glyphUv.x > 1.0 ||\n"
+    "		glyphUv.y < 0.0 ||\n"
+    "		glyphUv.y > 1.0) {\n"
+    "		fragmentColor = vec4(0.0);\n"
+    "		return;\n"
+    "	}\n";
+
+static const char* fragmentShaderSourceFooter =
+    "	vec2 uv = clamp(glyphUv, 0.0, 1.0);\n"
+    "	vec2 fontAtlasGlyphCorner = vec2(fragmentGlyphAtlasRegion.xy);\n"
     ""
     "	vec2 glyphRotatedUv;\n"
     "	vec2 fontAtlasGlyphSize;\n"
-    "	if(glyphIsRotated) {;\n"
-    "		glyphRotatedUv = vec2(1.0 - glyphUv.y, glyphUv.x);\n"
-    "		fontAtlasGlyphSize = vec2(glyphHeight, glyphWidth);\n"
+    "	if (fragmentGlyphAtlasIsRotated != 0) {\n"
+    "		glyphRotatedUv = vec2(1.0 - uv.y, uv.x);\n"
+    "		fontAtlasGlyphSize = vec2(fragmentGlyphAtlasRegion.wz);\n"
     "	} else {\n"
-    "		glyphRotatedUv = glyphUv;\n"
-    "		fontAtlasGlyphSize = vec2(glyphWidth, glyphHeight);\n"
+    "		glyphRotatedUv = uv;\n"
+    "		fontAtlasGlyphSize = vec2(fragmentGlyphAtlasRegion.zw);\n"
     "	}\n"
     ""
-    "	vec2 fontAtlasSize = textureSize(fontAtlas, 0);\n"
-    "	vec2 fontAtlasInverseSize = 1.0 / fontAtlasSize;\n"
-    "	vec2 fontAtlasGlyphUvScaleFactor = fontAtlasGlyphSize * fontAtlasInverseSize;\n"
-    "	vec2 fontAtlasGlyphCornerUv = fontAtlasGlyphCorner * fontAtlasInverseSize;\n"
-    "	vec2 fontAtlasUv = fontAtlasGlyphCornerUv + fontAtlasGlyphUvScaleFactor * glyphRotatedUv;\n"
-    "	return fontAtlasUv;\n"
-    "}\n"
-    "\n"
-    "void main()\n"
-    "{\n"
-    "	// Translate glyph metrics into the region's coordinate system.\n"
-    "	float textFactor = textSize / fontSize;\n"
-    "	float characterGlyphAdvance = textFactor * characterAdvance;\n"
-    "	vec2 characterGlyphSize = textFactor * vec2(glyphWidth, glyphHeight);\n"
-    "	vec2 characterGlyphBearing = textFactor * vec2(glyphBearingX, glyphBearingY);\n"
-    ""
-    "	// Compute the corner of the character glyph area to render within the region.\n"
-    "	vec2 characterCorner = textCorner + vec2(characterGlyphAdvance, 0.0);\n"
-    "	vec2 characterGlyphCorner = characterCorner + characterGlyphBearing - vec2(0.0, "
-    "characterGlyphSize.y);\n"
-    ""
-    "	vec2 glyphUv = getSpriteUv(characterGlyphCorner, characterGlyphSize);\n"
-    ""
-    "	if (glyphUv.x >= 0.0 &&\n"
-    "		glyphUv.x <= 1.0 &&\n"
-    "		glyphUv.y >= 0.0 &&\n"
-    "		glyphUv.y <= 1.0) {\n"
-    "		vec2 fontAtlasUv = getFontAtlasUv(glyphUv);\n"
-    "		float fontAtlasValue = texture2D(fontAtlas, fontAtlasUv).r;\n"
+    "	vec2 fontAtlasInverseSize = 1.0 / vec2(textureSize(fontAtlas, 0));\n"
+    "	vec2 fontAtlasUv =\n"
+    "		(fontAtlasGlyphCorner + fontAtlasGlyphSize * glyphRotatedUv) * fontAtlasInverseSize;\n"
+    "	float fontAtlasValue = texture2D(fontAtlas, fontAtlasUv).r;\n"
     ""
-    "		if (sceneDebugMode) {\n"
-    "			fragmentColor = vec4(fontAtlasUv.xy, fontAtlasUv.y, 1.0);\n"
-    "		} else {\n"
-    "			fragmentColor = vec4(textColor.rgb, fontAtlasValue * textColor.a);\n"
-    "		}\n"
+    "	if (sceneDebugMode) {\n"
+    "		fragmentColor = vec4(fontAtlasUv.xy, fontAtlasUv.y, 1.0);\n"
     "	} else {\n"
-    "		fragmentColor = vec4(0.0);\n"
+    "		fragmentColor = vec4(fragmentGlyphColor.rgb, fontAtlasValue * fragmentGlyphColor.a);\n"
     "	}\n"
     "}\n";
 
 typedef struct {
   ShovelerMaterial* material;
   ShovelerSampler* sampler;
+  ShovelerDrawable* glyphInstances;
   ShovelerVector2 activeRegionPosition;
   ShovelerVector2 activeRegionSize;
   ShovelerFontAtlasTexture* activeFontAtlasTexture;
+  /** lays out the active text when rendering, leaving the font atlas texture's builder to callers */
+  ShovelerGlyphRunBuilder* scratchGlyphRunBuilder;
+  /** font atlas the scratch glyph run builder looks up glyphs in */
+  ShovelerFontAtlas* scratchFontAtlas;
   ShovelerTexture* activeTexture;
-  unsigned int activeFontSize;
   const char* activeText;
   ShovelerVector2 activeTextCorner;
   float activeTextSize;
   ShovelerVector4 activeTextColor;
-  float activeCharacterAdvance;
-  unsigned int activeGlyphMinX;
-  unsigned int activeGlyphMinY;
-  unsigned int activeGlyphWidth;
-  unsigned int activeGlyphHeight;
-  unsigned int activeGlyphBearingX;
-  unsigned int activeGlyphBearingY;
-  bool activeGlyphIsRotated;
 } MaterialData;
 
+static GLuint createProgram(bool screenspace);
 static bool render(
     ShovelerMaterial* material,
     ShovelerScene* scene,
@@ -145,31 +166,24 @@ static bool render(
 static void freeMaterialData(ShovelerMaterial* material);
 
 ShovelerMaterial* shovelerMaterialTextCreate(ShovelerShaderCache* shaderCache, bool screenspace) {
-  GLuint vertexShaderObject = shovelerShaderProgramModelVertexCreate(screenspace);
-  GLuint fragmentShaderObject =
-      shovelerShaderProgramCompileFromString(fragmentShaderSource, GL_FRAGMENT_SHADER);
-  GLuint program = shovelerShaderProgramLink(vertexShaderObject, 0, fragmentShaderObject, true);
-
   MaterialData* materialData = malloc(sizeof(MaterialData));
-  materialData->material = shovelerMaterialCreate(shaderCache, screenspace, program);
+  materialData->material =
+      shovelerMaterialCreate(shaderCache, screenspace, createProgram(screenspace));
   materialData->material->data = materialData;
   materialData->material->render = render;
   materialData->material->freeData = freeMaterialData;
   materialData->sampler = shovelerSamplerCreate(true, false, false);
+  materialData->glyphInstances = shovelerDrawableGlyphInstancesCreate();
+  materialData->activeRegionPosition = shovelerVector2(0.0f, 0.0f);
+  materialData->activeRegionSize = shovelerVector2(1.0f, 1.0f);
   materialData->activeFontAtlasTexture = NULL;
+  materialData->scratchGlyphRunBuilder = NULL;
+  materialData->scratchFontAtlas = NULL;
   materialData->activeTexture = NULL;
-  materialData->activeFontSize = 0;
+  materialData->activeText = "";
   materialData->activeTextCorner = shovelerVector2(0.0f, 0.0f);
   materialData->activeTextSize = 0.0f;
   materialData->activeTextColor = shovelerVector4(1.0f, 1.0f, 1.0f, 1.0f);
-  materialData->activeCharacterAdvance = 0.0f;
-  materialData->activeGlyphMinX = 0;
-  materialData->activeGlyphMinY = 0;
-  materialData->activeGlyphWidth = 0;
-  materialData->activeGlyphHeight = 0;
-  materialData->activeGlyphBearingX = 0;
-  materialData->activeGlyphBearingY = 0;
-  materialData->activeGlyphIsRotated = false;
 
   shovelerUniformMapInsert(
       materialData->material->uniforms,
@@ -179,63 +193,10 @@ ShovelerMaterial* shovelerMaterialTextCreate(ShovelerShaderCache* shaderCache, b
       materialData->material->uniforms,
       "regionSize",
       shovelerUniformCreateVector2Pointer(&materialData->activeRegionSize));
-
   shovelerUniformMapInsert(
       materialData->material->uniforms,
       "fontAtlas",
       shovelerUniformCreateTexturePointer(&materialData->activeTexture, &materialData->sampler));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "fontSize",
-      shovelerUniformCreateUnsignedIntPointer(&materialData->activeFontSize));
-
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "textCorner",
-      shovelerUniformCreateVector2Pointer(&materialData->activeTextCorner));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "textSize",
-      shovelerUniformCreateFloatPointer(&materialData->activeTextSize));
-
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "textColor",
-      shovelerUniformCreateVector4Pointer(&materialData->activeTextColor));
-
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "characterAdvance",
-      shovelerUniformCreateFloatPointer(&materialData->activeCharacterAdvance));
-
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "glyphMinX",
-      shovelerUniformCreateUnsignedIntPointer(&materialData->activeGlyphMinX));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "glyphMinY",
-      shovelerUniformCreateUnsignedIntPointer(&materialData->activeGlyphMinY));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "glyphWidth",
-      shovelerUniformCreateUnsignedIntPointer(&materialData->activeGlyphWidth));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "glyphHeight",
-      shovelerUniformCreateUnsignedIntPointer(&materialData->activeGlyphHeight));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "glyphBearingX",
-      shovelerUniformCreateUnsignedIntPointer(&materialData->activeGlyphBearingX));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "glyphBearingY",
-      shovelerUniformCreateUnsignedIntPointer(&materialData->activeGlyphBearingY));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "glyphIsRotated",
-      shovelerUniformCreateBoolPointer(&materialData->activeGlyphIsRotated));
 
   return materialData->material;
 }
@@ -251,7 +212,6 @@ void shovelerMaterialTextSetActiveFontAtlasTexture(
     ShovelerMaterial* material, ShovelerFontAtlasTexture* fontAtlasTexture) {
   MaterialData* materialData = material->data;
   materialData->activeFontAtlasTexture = fontAtlasTexture;
-  materialData->activeFontSize = fontAtlasTexture->fontAtlas->fontSize;
 }
 
 void shovelerMaterialTextSetActiveText(
@@ -267,73 +227,129 @@ void shovelerMaterialTextSetActiveColor(ShovelerMaterial* material, ShovelerVect
   materialData->activeTextColor = color;
 }
 
-static bool render(
+ShovelerGlyphRunBuilder* shovelerMaterialTextGetGlyphRunBuilder(ShovelerMaterial* material) {
+  MaterialData* materialData = material->data;
+  return materialData->activeFontAtlasTexture->glyphRunBuilder;
+}
+
+bool shovelerMaterialTextRenderGlyphs(
     ShovelerMaterial* material,
+    const ShovelerGlyphInstance* instances,
+    int numInstances,
     ShovelerScene* scene,
     ShovelerCamera* camera,
     ShovelerLight* light,
     ShovelerModel* model,
     ShovelerRenderState* renderState) {
   MaterialData* materialData = material->data;
+  if (numInstances == 0) {
+    return true;
+  }
+
+  // building the glyph runs might have added glyphs to the font atlas that need to be uploaded
+  shovelerFontAtlasTextureUpdate(materialData->activeFontAtlasTexture);
+  materialData->activeTexture = materialData->activeFontAtlasTexture->texture;
+
+  if (!shovelerDrawableGlyphInstancesUpdate(
+          materialData->glyphInstances, instances, numInstances)) {
+    shovelerLogWarning(
+        "Failed to upload %d glyph instances of text material %p.", numInstances, material);
+    return false;
+  }
 
-  // since we are only changing uniform pointer values per per glyph, we can reuse the same shader
-  // for all of them
   ShovelerShader* shader = shovelerSceneGenerateShader(scene, camera, light, model, material, NULL);
+  if (!shovelerShaderUse(shader)) {
+    shovelerLogWarning(
+        "Failed to use shader for text material %p, scene %p, camera %p, light %p and model %p.",
+        material,
+        scene,
+        camera,
+        light,
+        model);
+    return false;
+  }
 
   shovelerRenderStateEnableBlend(renderState, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  materialData->activeTexture = materialData->activeFontAtlasTexture->texture;
-  materialData->activeCharacterAdvance = 0.0f;
-
-  for (const char* c = materialData->activeText; *c != '\0'; c++) {
-    unsigned char character = *((unsigned char*) c);
-
-    ShovelerFontAtlasGlyph* glyph =
-        shovelerFontAtlasGetGlyph(materialData->activeFontAtlasTexture->fontAtlas, character);
-    materialData->activeGlyphMinX = glyph->minX;
-    materialData->activeGlyphMinY = glyph->minY;
-    materialData->activeGlyphWidth = glyph->width;
-    materialData->activeGlyphHeight = glyph->height;
-    materialData->activeGlyphBearingX = glyph->bearingX;
-    materialData->activeGlyphBearingY = glyph->bearingY;
-    materialData->activeGlyphIsRotated = glyph->isRotated;
-
-    if (!shovelerShaderUse(shader)) {
-      shovelerLogWarning(
-          "Failed to use shader for character %c when rendering text '%s' with material %p and "
-          "model %p.",
-          character,
-          materialData->activeText,
-          material,
-          model);
-      return false;
-    }
+  if (!shovelerDrawableDraw(materialData->glyphInstances)) {
+    shovelerLogWarning(
+        "Failed to draw %d glyph instances of text material %p.", numInstances, material);
+    return false;
+  }
 
-    if (!shovelerModelRender(model)) {
-      shovelerLogWarning(
-          "Failed to render model %p for character %c when rendering text '%s' with material %p "
-          "and model %p.",
-          model,
-          character,
-          materialData->activeText,
-          material,
-          model);
-      return false;
-    }
+  return true;
+}
 
-    if (!material->screenspace) {
-      shovelerRenderStateEnableDepthTest(renderState, GL_EQUAL);
-    }
+static GLuint createProgram(bool screenspace) {
+  GString* vertexShaderSource = g_string_new(vertexShaderSourceHeader);
+  g_string_append(
+      vertexShaderSource,
+      screenspace ? vertexShaderSourceScreenspaceQuad : vertexShaderSourceProjectedQuad);
+  g_string_append(vertexShaderSource, vertexShaderSourceBody);
+  g_string_append(
+      vertexShaderSource,
+      screenspace ? vertexShaderSourceScreenspaceFooter : vertexShaderSourceProjectedFooter);
+  GLuint vertexShaderObject =
+      shovelerShaderProgramCompileFromString(vertexShaderSource->str, GL_VERTEX_SHADER);
+  g_string_free(vertexShaderSource, /* freeSegment */ true);
 
-    materialData->activeCharacterAdvance += glyph->advance / 64.0f;
+  GString* fragmentShaderSource = g_string_new(fragmentShaderSourceHeader);
+  if (!screenspace) {
+    g_string_append(fragmentShaderSource, fragmentShaderSourceProjectedClip);
   }
+  g_string_append(fragmentShaderSource, fragmentShaderSourceFooter);
+  GLuint fragmentShaderObject =
+      shovelerShaderProgramCompileFromString(fragmentShaderSource->str, GL_FRAGMENT_SHADER);
+  g_string_free(fragmentShaderSource, /* freeSegment */ true);
 
-  return true;
+  return shovelerShaderProgramLink(vertexShaderObject, 0, fragmentShaderObject, true);
+}
+
+static bool render(
+    ShovelerMaterial* material,
+    ShovelerScene* scene,
+    ShovelerCamera* camera,
+    ShovelerLight* light,
+    ShovelerModel* model,
+    ShovelerRenderState* renderState) {
+  MaterialData* materialData = material->data;
+
+  ShovelerFontAtlas* fontAtlas = materialData->activeFontAtlasTexture->fontAtlas;
+  if (materialData->scratchFontAtlas != fontAtlas) {
+    if (materialData->scratchGlyphRunBuilder != NULL) {
+      shovelerGlyphRunBuilderFree(materialData->scratchGlyphRunBuilder);
+    }
+    materialData->scratchGlyphRunBuilder = shovelerGlyphRunBuilderCreateFontAtlas(fontAtlas);
+    materialData->scratchFontAtlas = fontAtlas;
+  }
+
+  ShovelerGlyphRunBuilder* glyphRunBuilder = materialData->scratchGlyphRunBuilder;
+  shovelerGlyphRunBuilderClear(glyphRunBuilder);
+  shovelerGlyphRunBuilderAdd(
+      glyphRunBuilder,
+      materialData->activeText,
+      materialData->activeTextCorner,
+      materialData->activeTextSize,
+      materialData->activeTextColor);
+
+  return shovelerMaterialTextRenderGlyphs(
+      material,
+      (const ShovelerGlyphInstance*) glyphRunBuilder->instances->data,
+      (int) glyphRunBuilder->instances->len,
+      scene,
+      camera,
+      light,
+      model,
+      renderState);
 }
 
 static void freeMaterialData(ShovelerMaterial* material) {
   MaterialData* materialData = material->data;
 
+  if (materialData->scratchGlyphRunBuilder != NULL) {
+    shovelerGlyphRunBuilderFree(materialData->scratchGlyphRunBuilder);
+  }
+  shovelerDrawableFree(materialData->glyphInstances);
   shovelerSamplerFree(materialData->sampler);
   free(materialData);
 }
@@ -2,11 +2,18 @@
 
 #include <stdlib.h> // malloc, free
 
+#include "shoveler/drawable.h"
+#include "shoveler/drawable/sprite_instances.h"
+#include "shoveler/log.h"
 #include "shoveler/material.h"
 #include "shoveler/sampler.h"
+#include "shoveler/scene.h"
+#include "shoveler/shader.h"
 #include "shoveler/shader_cache.h"
 #include "shoveler/shader_program.h"
 #include "shoveler/shader_program/model_vertex.h"
+#include "shoveler/shader_program/sprite_instance_vertex.h"
+#include "shoveler/sprite_batch.h"
 #include "shoveler/texture.h"
 #include "shoveler/types.h"
 #include "shoveler/uniform.h"
@@ -70,8 +77,50 @@ static const char* fragmentShaderSource =
     "	}\n"
     "}\n";
 
+// The instanced variant draws one quad per sprite using the sprite instance vertex shader. On
+// projected canvases, its quads cover the whole region, so fragments outside the sprite are cleared.
+static const char* instancedFragmentShaderSourceHeader =
+    "#version 400\n"
+    "\n"
+    "uniform bool sceneDebugMode;\n"
+    "uniform bool depthOnly;\n"
+    "uniform bool alphaMask;\n"
+    "uniform vec4 color;\n"
+    "uniform sampler2D texture;\n"
+    "\n"
+    "in vec2 spriteUv;\n"
+    "\n"
+    "out vec4 fragmentColor;\n"
+    "\n"
+    "void main()\n"
+    "{\n";
+
+static const char* instancedFragmentShaderSourceProjectedClip =
+    "	if (spriteUv.x < 0.0 ||\n"
+    "		spriteUv.x > 1.0 ||\n"
+    "		spriteUv.y < 0.0 ||\n"
+    "		spriteUv.y > 1.0) {\n"
+    "		fragmentColor = vec4(0.0f);\n"
+    "		return;\n"
+    "	}\n";
+
+static const char* instancedFragmentShaderSourceFooter =
+    "	if(sceneDebugMode) {\n"
+    "		fragmentColor = vec4(spriteUv.xy, spriteUv.y, 1.0);\n"
+    "	} else if(depthOnly) {\n"
+    "		fragmentColor = vec4(texture2D(texture, spriteUv).r);\n"
+    "	} else if(alphaMask) {\n"
+    "		fragmentColor = vec4(color.rgb, color.a * texture2D(texture, spriteUv).r);\n"
+    "	} else {\n"
+    "		fragmentColor = vec4(texture2D(texture, spriteUv).rgb, 1.0);\n"
+    "	}\n"
+    "}\n";
+
 typedef struct {
   ShovelerMaterial* material;
+  /** companion material using the instanced program, sharing the active state below */
+  ShovelerMaterial* instancedMaterial;
+  ShovelerDrawable* instances;
   ShovelerVector2 activeRegionPosition;
   ShovelerVector2 activeRegionSize;
   ShovelerVector2 activeSpritePosition;
@@ -81,6 +130,11 @@ typedef struct {
   ShovelerSampler* activeSampler;
 } MaterialData;
 
+static GLuint createInstancedProgram(bool screenspace);
+static void insertSharedUniforms(
+    ShovelerUniformMap* uniforms,
+    MaterialData* materialData,
+    ShovelerMaterialTextureSpriteType type);
 static void freeMaterialData(ShovelerMaterial* material);
 
 ShovelerMaterial* shovelerMaterialTextureSpriteCreate(
@@ -94,6 +148,8 @@ ShovelerMaterial* shovelerMaterialTextureSpriteCreate(
   materialData->material = shovelerMaterialCreate(shaderCache, screenspace, program);
   materialData->material->data = materialData;
   materialData->material->freeData = freeMaterialData;
+  materialData->instancedMaterial = NULL;
+  materialData->instances = NULL;
   materialData->activeRegionPosition = shovelerVector2(0.0f, 0.0f);
   materialData->activeRegionSize = shovelerVector2(1.0f, 1.0f);
   materialData->activeSpritePosition = shovelerVector2(0.0f, 0.0f);
@@ -102,15 +158,7 @@ ShovelerMaterial* shovelerMaterialTextureSpriteCreate(
   materialData->activeTexture = NULL;
   materialData->activeSampler = NULL;
 
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "regionPosition",
-      shovelerUniformCreateVector2Pointer(&materialData->activeRegionPosition));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "regionSize",
-      shovelerUniformCreateVector2Pointer(&materialData->activeRegionSize));
-
+  insertSharedUniforms(materialData->material->uniforms, materialData, type);
   shovelerUniformMapInsert(
       materialData->material->uniforms,
       "spritePosition",
@@ -120,23 +168,10 @@ ShovelerMaterial* shovelerMaterialTextureSpriteCreate(
       "spriteSize",
       shovelerUniformCreateVector2Pointer(&materialData->activeSpriteSize));
 
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "depthOnly",
-      shovelerUniformCreateInt(type == SHOVELER_MATERIAL_TEXTURE_SPRITE_TYPE_DEPTH));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "alphaMask",
-      shovelerUniformCreateInt(type == SHOVELER_MATERIAL_TEXTURE_SPRITE_TYPE_ALPHA_MASK));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "color",
-      shovelerUniformCreateVector4Pointer(&materialData->activeColor));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "texture",
-      shovelerUniformCreateTexturePointer(
-          &materialData->activeTexture, &materialData->activeSampler));
+  materialData->instancedMaterial =
+      shovelerMaterialCreate(shaderCache, screenspace, createInstancedProgram(screenspace));
+  insertSharedUniforms(materialData->instancedMaterial->uniforms, materialData, type);
+  materialData->instances = shovelerDrawableSpriteInstancesCreate();
 
   return materialData->material;
 }
@@ -167,7 +202,102 @@ void shovelerMaterialTextureSpriteSetActiveTexture(
   materialData->activeSampler = sampler;
 }
 
+bool shovelerMaterialTextureSpriteRenderInstances(
+    ShovelerMaterial* material,
+    ShovelerTexture* texture,
+    ShovelerSampler* sampler,
+    const ShovelerSpriteInstance* instances,
+    int numInstances,
+    ShovelerScene* scene,
+    ShovelerCamera* camera,
+    ShovelerLight* light,
+    ShovelerModel* model,
+    ShovelerRenderState* renderState) {
+  MaterialData* materialData = material->data;
+  shovelerMaterialTextureSpriteSetActiveTexture(material, texture, sampler);
+
+  if (!shovelerDrawableSpriteInstancesUpdate(materialData->instances, instances, numInstances)) {
+    shovelerLogWarning(
+        "Failed to upload %d sprite instances of texture sprite material %p.",
+        numInstances,
+        material);
+    return false;
+  }
+
+  ShovelerShader* shader = shovelerSceneGenerateShader(
+      scene, camera, light, model, materialData->instancedMaterial, NULL);
+  if (!shovelerShaderUse(shader)) {
+    shovelerLogWarning(
+        "Failed to use instanced shader for texture sprite material %p, scene %p, camera %p, "
+        "light %p and model %p.",
+        material,
+        scene,
+        camera,
+        light,
+        model);
+    return false;
+  }
+
+  if (!shovelerDrawableDraw(materialData->instances)) {
+    shovelerLogWarning(
+        "Failed to draw %d sprite instances of texture sprite material %p.",
+        numInstances,
+        material);
+    return false;
+  }
+
+  return true;
+}
+
+static GLuint createInstancedProgram(bool screenspace) {
+  GLuint vertexShaderObject = shovelerShaderProgramSpriteInstanceVertexCreate(screenspace);
+
+  GString* fragmentShaderSource = g_string_new(instancedFragmentShaderSourceHeader);
+  if (!screenspace) {
+    g_string_append(fragmentShaderSource, instancedFragmentShaderSourceProjectedClip);
+  }
+  g_string_append(fragmentShaderSource, instancedFragmentShaderSourceFooter);
+  GLuint fragmentShaderObject =
+      shovelerShaderProgramCompileFromString(fragmentShaderSource->str, GL_FRAGMENT_SHADER);
+  g_string_free(fragmentShaderSource, /* freeSegment */ true);
+
+  return shovelerShaderProgramLink(vertexShaderObject, 0, fragmentShaderObject, true);
+}
+
+/** Inserts the uniforms used by both the regular and the instanced program. */
+static void insertSharedUniforms(
+    ShovelerUniformMap* uniforms,
+    MaterialData* materialData,
+    ShovelerMaterialTextureSpriteType type) {
+  shovelerUniformMapInsert(
+      uniforms,
+      "regionPosition",
+      shovelerUniformCreateVector2Pointer(&materialData->activeRegionPosition));
+  shovelerUniformMapInsert(
+      uniforms,
+      "regionSize",
+      shovelerUniformCreateVector2Pointer(&materialData->activeRegionSize));
+
+  shovelerUniformMapInsert(
+      uniforms,
+      "depthOnly",
+      shovelerUniformCreateInt(type == SHOVELER_MATERIAL_TEXTURE_SPRITE_TYPE_DEPTH));
+  shovelerUniformMapInsert(
+      uniforms,
+      "alphaMask",
+      shovelerUniformCreateInt(type == SHOVELER_MATERIAL_TEXTURE_SPRITE_TYPE_ALPHA_MASK));
+  shovelerUniformMapInsert(
+      uniforms, "color", shovelerUniformCreateVector4Pointer(&materialData->activeColor));
+  shovelerUniformMapInsert(
+      uniforms,
+      "texture",
+      shovelerUniformCreateTexturePointer(
+          &materialData->activeTexture, &materialData->activeSampler));
+}
+
 static void freeMaterialData(ShovelerMaterial* material) {
   MaterialData* materialData = material->data;
+  shovelerDrawableFree(materialData->instances);
+  shovelerMaterialFree(materialData->instancedMaterial);
   free(materialData);
 }
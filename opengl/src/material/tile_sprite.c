@@ -2,10 +2,17 @@
 
 #include <stdlib.h> // malloc, free
 
+#include "shoveler/drawable.h"
+#include "shoveler/drawable/sprite_instances.h"
+#include "shoveler/log.h"
 #include "shoveler/material.h"
+#include "shoveler/scene.h"
+#include "shoveler/shader.h"
 #include "shoveler/shader_cache.h"
 #include "shoveler/shader_program.h"
 #include "shoveler/shader_program/model_vertex.h"
+#include "shoveler/shader_program/sprite_instance_vertex.h"
+#include "shoveler/sprite_batch.h"
 #include "shoveler/sprite/tile.h"
 #include "shoveler/tileset.h"
 #include "shoveler/types.h"
@@ -81,8 +88,60 @@ static const char* fragmentShaderSource =
     "	}\n"
     "}\n";
 
+// The instanced variant draws one quad per sprite using the sprite instance vertex shader. On
+// projected canvases, its quads cover the whole region, so fragments outside the sprite are cleared.
+static const char* instancedFragmentShaderSourceHeader =
+    "#version 400\n"
+    "\n"
+    "uniform bool sceneDebugMode;\n"
+    "uniform int tilesetColumns;\n"
+    "uniform int tilesetRows;\n"
+    "uniform int tilesetPadding;\n"
+    "uniform sampler2D tileset;\n"
+    "\n"
+    "in vec2 spriteUv;\n"
+    "flat in ivec2 fragmentTile;\n"
+    "\n"
+    "out vec4 fragmentColor;\n"
+    ""
+    "void main()\n"
+    "{\n";
+
+static const char* instancedFragmentShaderSourceProjectedClip =
+    "	if (spriteUv.x < 0.0 ||\n"
+    "		spriteUv.x > 1.0 ||\n"
+    "		spriteUv.y < 0.0 ||\n"
+    "		spriteUv.y > 1.0) {\n"
+    "		fragmentColor = vec4(0.0f);\n"
+    "		return;\n"
+    "	}\n";
+
+static const char* instancedFragmentShaderSourceFooter =
+    "	vec2 tile = vec2(fragmentTile);\n"
+    "	vec2 tileUv = clamp(spriteUv, 0.0, 1.0);\n"
+    ""
+    "	vec2 tilesetSize = textureSize(tileset, 0);\n"
+    "	vec2 tilesetInverseDimensions = 1.0 / vec2(tilesetColumns, tilesetRows);\n"
+    "	vec2 paddedTileSize = tilesetSize * tilesetInverseDimensions;\n"
+    "	vec2 paddedTilePaddingFraction = vec2(tilesetPadding) / paddedTileSize;\n"
+    "	vec2 tilePaddingScaleFactor = vec2(1.0) - 2.0 * paddedTilePaddingFraction;"
+    ""
+    "	vec2 tilePaddedUv = paddedTilePaddingFraction + tilePaddingScaleFactor * tileUv;\n"
+    "	vec2 tilesetUv = (tile.xy + tilePaddedUv) * tilesetInverseDimensions;\n"
+    ""
+    "	vec4 color = texture2D(tileset, tilesetUv).rgba;\n"
+    "	if (sceneDebugMode) {\n"
+    "		fragmentColor = vec4(tilesetUv.xy, tilesetUv.y, 1.0);\n"
+    "	} else {\n"
+    "		fragmentColor = color;\n"
+    "	}\n"
+    "}\n";
+
 typedef struct {
   ShovelerMaterial* material;
+  /** companion material using the instanced program, sharing the active state below */
+  ShovelerMaterial* instancedMaterial;
+  ShovelerDrawable* instances;
   ShovelerVector2 activeRegionPosition;
   ShovelerVector2 activeRegionSize;
   int activeSpriteTilesetColumn;
@@ -96,6 +155,8 @@ typedef struct {
   ShovelerSampler* activeTilesetSampler;
 } MaterialData;
 
+static GLuint createInstancedProgram(bool screenspace);
+static void insertSharedUniforms(ShovelerUniformMap* uniforms, MaterialData* materialData);
 static void freeMaterialData(ShovelerMaterial* material);
 
 ShovelerMaterial* shovelerMaterialTileSpriteCreate(
@@ -109,6 +170,8 @@ ShovelerMaterial* shovelerMaterialTileSpriteCreate(
   materialData->material = shovelerMaterialCreate(shaderCache, screenspace, program);
   materialData->material->data = materialData;
   materialData->material->freeData = freeMaterialData;
+  materialData->instancedMaterial = NULL;
+  materialData->instances = NULL;
   materialData->activeRegionPosition = shovelerVector2(0.0f, 0.0f);
   materialData->activeRegionSize = shovelerVector2(1.0f, 1.0f);
   materialData->activeSpriteTilesetColumn = 0;
@@ -121,15 +184,7 @@ ShovelerMaterial* shovelerMaterialTileSpriteCreate(
   materialData->activeTilesetTexture = NULL;
   materialData->activeTilesetSampler = NULL;
 
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "regionPosition",
-      shovelerUniformCreateVector2Pointer(&materialData->activeRegionPosition));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "regionSize",
-      shovelerUniformCreateVector2Pointer(&materialData->activeRegionSize));
-
+  insertSharedUniforms(materialData->material->uniforms, materialData);
   shovelerUniformMapInsert(
       materialData->material->uniforms,
       "tilesetColumn",
@@ -138,7 +193,6 @@ ShovelerMaterial* shovelerMaterialTileSpriteCreate(
       materialData->material->uniforms,
       "tilesetRow",
       shovelerUniformCreateIntPointer(&materialData->activeSpriteTilesetRow));
-
   shovelerUniformMapInsert(
       materialData->material->uniforms,
       "spritePosition",
@@ -148,23 +202,10 @@ ShovelerMaterial* shovelerMaterialTileSpriteCreate(
       "spriteSize",
       shovelerUniformCreateVector2Pointer(&materialData->activeSpriteSize));
 
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "tilesetColumns",
-      shovelerUniformCreateIntPointer(&materialData->activeTilesetColumns));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "tilesetRows",
-      shovelerUniformCreateIntPointer(&materialData->activeTilesetRows));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "tilesetPadding",
-      shovelerUniformCreateIntPointer(&materialData->activeTilesetPadding));
-  shovelerUniformMapInsert(
-      materialData->material->uniforms,
-      "tileset",
-      shovelerUniformCreateTexturePointer(
-          &materialData->activeTilesetTexture, &materialData->activeTilesetSampler));
+  materialData->instancedMaterial =
+      shovelerMaterialCreate(shaderCache, screenspace, createInstancedProgram(screenspace));
+  insertSharedUniforms(materialData->instancedMaterial->uniforms, materialData);
+  materialData->instances = shovelerDrawableSpriteInstancesCreate();
 
   return materialData->material;
 }
@@ -209,7 +250,96 @@ void shovelerMaterialTileSpriteSetActive(
       material, spriteTile->sprite.position, spriteTile->sprite.size);
 }
 
+bool shovelerMaterialTileSpriteRenderInstances(
+    ShovelerMaterial* material,
+    ShovelerTileset* tileset,
+    const ShovelerSpriteInstance* instances,
+    int numInstances,
+    ShovelerScene* scene,
+    ShovelerCamera* camera,
+    ShovelerLight* light,
+    ShovelerModel* model,
+    ShovelerRenderState* renderState) {
+  MaterialData* materialData = material->data;
+  shovelerMaterialTileSpriteSetActiveTileset(material, tileset);
+
+  if (!shovelerDrawableSpriteInstancesUpdate(materialData->instances, instances, numInstances)) {
+    shovelerLogWarning(
+        "Failed to upload %d sprite instances of tile sprite material %p.", numInstances, material);
+    return false;
+  }
+
+  ShovelerShader* shader = shovelerSceneGenerateShader(
+      scene, camera, light, model, materialData->instancedMaterial, NULL);
+  if (!shovelerShaderUse(shader)) {
+    shovelerLogWarning(
+        "Failed to use instanced shader for tile sprite material %p, scene %p, camera %p, light %p "
+        "and model %p.",
+        material,
+        scene,
+        camera,
+        light,
+        model);
+    return false;
+  }
+
+  if (!shovelerDrawableDraw(materialData->instances)) {
+    shovelerLogWarning(
+        "Failed to draw %d sprite instances of tile sprite material %p.", numInstances, material);
+    return false;
+  }
+
+  return true;
+}
+
+static GLuint createInstancedProgram(bool screenspace) {
+  GLuint vertexShaderObject = shovelerShaderProgramSpriteInstanceVertexCreate(screenspace);
+
+  GString* fragmentShaderSource = g_string_new(instancedFragmentShaderSourceHeader);
+  if (!screenspace) {
+    g_string_append(fragmentShaderSource, instancedFragmentShaderSourceProjectedClip);
+  }
+  g_string_append(fragmentShaderSource, instancedFragmentShaderSourceFooter);
+  GLuint fragmentShaderObject =
+      shovelerShaderProgramCompileFromString(fragmentShaderSource->str, GL_FRAGMENT_SHADER);
+  g_string_free(fragmentShaderSource, /* freeSegment */ true);
+
+  return shovelerShaderProgramLink(vertexShaderObject, 0, fragmentShaderObject, true);
+}
+
+/** Inserts the uniforms used by both the regular and the instanced program. */
+static void insertSharedUniforms(ShovelerUniformMap* uniforms, MaterialData* materialData) {
+  shovelerUniformMapInsert(
+      uniforms,
+      "regionPosition",
+      shovelerUniformCreateVector2Pointer(&materialData->activeRegionPosition));
+  shovelerUniformMapInsert(
+      uniforms,
+      "regionSize",
+      shovelerUniformCreateVector2Pointer(&materialData->activeRegionSize));
+
+  shovelerUniformMapInsert(
+      uniforms,
+      "tilesetColumns",
+      shovelerUniformCreateIntPointer(&materialData->activeTilesetColumns));
+  shovelerUniformMapInsert(
+      uniforms,
+      "tilesetRows",
+      shovelerUniformCreateIntPointer(&materialData->activeTilesetRows));
+  shovelerUniformMapInsert(
+      uniforms,
+      "tilesetPadding",
+      shovelerUniformCreateIntPointer(&materialData->activeTilesetPadding));
+  shovelerUniformMapInsert(
+      uniforms,
+      "tileset",
+      shovelerUniformCreateTexturePointer(
+          &materialData->activeTilesetTexture, &materialData->activeTilesetSampler));
+}
+
 static void freeMaterialData(ShovelerMaterial* material) {
   MaterialData* materialData = material->data;
+  shovelerDrawableFree(materialData->instances);
+  shovelerMaterialFree(materialData->instancedMaterial);
   free(materialData);
 }
@@ -1,8 +1,10 @@
 #include "shoveler/model.h"
 
+#include <math.h> // fabsf
 #include <stdbool.h> // bool
 #include <stdlib.h> // malloc, free
 
+#include "shoveler/bounding_volumes.h"
 #include "shoveler/log.h"
 #include "shoveler/material.h"
 #include "shoveler/opengl.h"
@@ -10,6 +12,10 @@
 #include "shoveler/types.h"
 #include "shoveler/uniform.h"
 
+static void updateBoundingBox(ShovelerModel* model);
+
+static guint64 nextTransformationVersion = 1;
+
 ShovelerModel* shovelerModelCreate(ShovelerDrawable* drawable, ShovelerMaterial* material) {
   ShovelerModel* model = malloc(sizeof(ShovelerModel));
   model->shaderCache = material->shaderCache;
@@ -20,6 +26,8 @@ ShovelerModel* shovelerModelCreate(ShovelerDrawable* drawable, ShovelerMaterial*
   model->scale = shovelerVector3(1, 1, 1);
   model->transformation = shovelerMatrixIdentity;
   model->normalTransformation = shovelerMatrixIdentity;
+  updateBoundingBox(model);
+  model->transformationVersion = nextTransformationVersion++;
   model->visible = true;
   model->emitter = false;
   model->castsShadow = true;
@@ -60,6 +68,8 @@ void shovelerModelUpdateTransformation(ShovelerModel* model) {
   model->transformation =
       shovelerMatrixMultiply(translation, shovelerMatrixMultiply(rotation, scale));
   model->normalTransformation = shovelerMatrixMultiply(rotation, scaleInverse);
+  updateBoundingBox(model);
+  model->transformationVersion = nextTransformationVersion++;
 }
 
 bool shovelerModelRender(ShovelerModel* model) {
@@ -83,3 +93,27 @@ void shovelerModelFree(ShovelerModel* model) {
   shovelerUniformMapFree(model->uniforms);
   free(model);
 }
+
+/** Transforms the center and half extents of the drawable's box into an axis aligned world box. */
+static void updateBoundingBox(ShovelerModel* model) {
+  if (!model->drawable->bounded) {
+    model->boundingBox = shovelerBoundingVolumesUnboundedBox();
+    return;
+  }
+
+  const ShovelerBoundingBox3* objectBox = &model->drawable->boundingBox;
+  for (int row = 0; row < 3; row++) {
+    float center = shovelerMatrixGet(model->transformation, row, 3);
+    float extent = 0.0f;
+    for (int column = 0; column < 3; column++) {
+      float factor = shovelerMatrixGet(model->transformation, row, column);
+      float min = objectBox->min.values[column];
+      float max = objectBox->max.values[column];
+      center += factor * 0.5f * (min + max);
+      extent += fabsf(factor) * 0.5f * (max - min);
+    }
+
+    model->boundingBox.min.values[row] = center - extent;
+    model->boundingBox.max.values[row] = center + extent;
+  }
+}
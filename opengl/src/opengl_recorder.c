@@ -0,0 +1,887 @@
+#include "shoveler/opengl_recorder.h"
+
+#include <stdlib.h> // malloc, free
+#include <string.h> // memcmp, memcpy, strchr, strlen, strncmp
+
+#include "shoveler/log.h"
+
+// List of all functions the recorder replaces, as pairs of the glad name suffix and the uppercase
+// name used by glad for their function pointer type.
+#define RECORDED_FUNCTIONS(F) \
+  F(ActiveTexture, ACTIVETEXTURE) \
+  F(AttachShader, ATTACHSHADER) \
+  F(BindAttribLocation, BINDATTRIBLOCATION) \
+  F(BindBuffer, BINDBUFFER) \
+  F(BindFramebuffer, BINDFRAMEBUFFER) \
+  F(BindSampler, BINDSAMPLER) \
+  F(BindTexture, BINDTEXTURE) \
+  F(BindVertexArray, BINDVERTEXARRAY) \
+  F(BindVertexBuffer, BINDVERTEXBUFFER) \
+  F(BlendFunc, BLENDFUNC) \
+  F(BlitFramebuffer, BLITFRAMEBUFFER) \
+  F(BufferData, BUFFERDATA) \
+  F(BufferSubData, BUFFERSUBDATA) \
+  F(CheckFramebufferStatus, CHECKFRAMEBUFFERSTATUS) \
+  F(Clear, CLEAR) \
+  F(ClearColor, CLEARCOLOR) \
+  F(ClearDepth, CLEARDEPTH) \
+  F(CompileShader, COMPILESHADER) \
+  F(CreateProgram, CREATEPROGRAM) \
+  F(CreateShader, CREATESHADER) \
+  F(DeleteBuffers, DELETEBUFFERS) \
+  F(DeleteFramebuffers, DELETEFRAMEBUFFERS) \
+  F(DeleteProgram, DELETEPROGRAM) \
+  F(DeleteSamplers, DELETESAMPLERS) \
+  F(DeleteShader, DELETESHADER) \
+  F(DeleteTextures, DELETETEXTURES) \
+  F(DeleteVertexArrays, DELETEVERTEXARRAYS) \
+  F(DepthFunc, DEPTHFUNC) \
+  F(DepthMask, DEPTHMASK) \
+  F(Disable, DISABLE) \
+  F(DrawArrays, DRAWARRAYS) \
+  F(DrawBuffer, DRAWBUFFER) \
+  F(DrawElements, DRAWELEMENTS) \
+  F(DrawElementsInstanced, DRAWELEMENTSINSTANCED) \
+  F(Enable, ENABLE) \
+  F(EnableVertexAttribArray, ENABLEVERTEXATTRIBARRAY) \
+  F(FramebufferTexture2D, FRAMEBUFFERTEXTURE2D) \
+  F(GenBuffers, GENBUFFERS) \
+  F(GenFramebuffers, GENFRAMEBUFFERS) \
+  F(GenSamplers, GENSAMPLERS) \
+  F(GenTextures, GENTEXTURES) \
+  F(GenVertexArrays, GENVERTEXARRAYS) \
+  F(GenerateMipmap, GENERATEMIPMAP) \
+  F(GetError, GETERROR) \
+  F(GetProgramInfoLog, GETPROGRAMINFOLOG) \
+  F(GetProgramiv, GETPROGRAMIV) \
+  F(GetShaderInfoLog, GETSHADERINFOLOG) \
+  F(GetShaderiv, GETSHADERIV) \
+  F(GetString, GETSTRING) \
+  F(GetUniformLocation, GETUNIFORMLOCATION) \
+  F(LinkProgram, LINKPROGRAM) \
+  F(PixelStorei, PIXELSTOREI) \
+  F(PolygonMode, POLYGONMODE) \
+  F(SamplerParameteri, SAMPLERPARAMETERI) \
+  F(ShaderSource, SHADERSOURCE) \
+  F(TexStorage2D, TEXSTORAGE2D) \
+  F(TexStorage2DMultisample, TEXSTORAGE2DMULTISAMPLE) \
+  F(TexSubImage2D, TEXSUBIMAGE2D) \
+  F(Uniform1f, UNIFORM1F) \
+  F(Uniform1i, UNIFORM1I) \
+  F(Uniform1ui, UNIFORM1UI) \
+  F(Uniform2fv, UNIFORM2FV) \
+  F(Uniform3fv, UNIFORM3FV) \
+  F(Uniform4fv, UNIFORM4FV) \
+  F(UniformMatrix4fv, UNIFORMMATRIX4FV) \
+  F(UseProgram, USEPROGRAM) \
+  F(VertexAttribBinding, VERTEXATTRIBBINDING) \
+  F(VertexAttribFormat, VERTEXATTRIBFORMAT) \
+  F(VertexAttribIFormat, VERTEXATTRIBIFORMAT) \
+  F(VertexBindingDivisor, VERTEXBINDINGDIVISOR) \
+  F(Viewport, VIEWPORT)
+
+#define DECLARE_FUNCTION_POINTER(NAME, UPPERCASE_NAME) PFNGL##UPPERCASE_NAME##PROC NAME;
+#define SAVE_FUNCTION_POINTER(NAME, UPPERCASE_NAME) previousFunctions.NAME = glad_gl##NAME;
+#define INSTALL_FUNCTION_POINTER(NAME, UPPERCASE_NAME) glad_gl##NAME = record##NAME;
+#define RESTORE_FUNCTION_POINTER(NAME, UPPERCASE_NAME) glad_gl##NAME = previousFunctions.NAME;
+
+typedef struct {
+  RECORDED_FUNCTIONS(DECLARE_FUNCTION_POINTER)
+} RecordedFunctions;
+
+static void APIENTRY recordActiveTexture(GLenum texture);
+static void APIENTRY recordAttachShader(GLuint program, GLuint shader);
+static void APIENTRY recordBindAttribLocation(GLuint program, GLuint index, const GLchar* name);
+static void APIENTRY recordBindBuffer(GLenum target, GLuint buffer);
+static void APIENTRY recordBindFramebuffer(GLenum target, GLuint framebuffer);
+static void APIENTRY recordBindSampler(GLuint unit, GLuint sampler);
+static void APIENTRY recordBindTexture(GLenum target, GLuint texture);
+static void APIENTRY recordBindVertexArray(GLuint array);
+static void APIENTRY
+recordBindVertexBuffer(GLuint bindingIndex, GLuint buffer, GLintptr offset, GLsizei stride);
+static void APIENTRY recordBlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+static void APIENTRY recordBlitFramebuffer(
+    GLint srcX0,
+    GLint srcY0,
+    GLint srcX1,
+    GLint srcY1,
+    GLint dstX0,
+    GLint dstY0,
+    GLint dstX1,
+    GLint dstY1,
+    GLbitfield mask,
+    GLenum filter);
+static void APIENTRY
+recordBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+static void APIENTRY
+recordBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+static GLenum APIENTRY recordCheckFramebufferStatus(GLenum target);
+static void APIENTRY recordClear(GLbitfield mask);
+static void APIENTRY recordClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+static void APIENTRY recordClearDepth(GLdouble depth);
+static void APIENTRY recordCompileShader(GLuint shader);
+static GLuint APIENTRY recordCreateProgram();
+static GLuint APIENTRY recordCreateShader(GLenum type);
+static void APIENTRY recordDeleteBuffers(GLsizei n, const GLuint* buffers);
+static void APIENTRY recordDeleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+static void APIENTRY recordDeleteProgram(GLuint program);
+static void APIENTRY recordDeleteSamplers(GLsizei n, const GLuint* samplers);
+static void APIENTRY recordDeleteShader(GLuint shader);
+static void APIENTRY recordDeleteTextures(GLsizei n, const GLuint* textures);
+static void APIENTRY recordDeleteVertexArrays(GLsizei n, const GLuint* arrays);
+static void APIENTRY recordDepthFunc(GLenum function);
+static void APIENTRY recordDepthMask(GLboolean flag);
+static void APIENTRY recordDisable(GLenum capability);
+static void APIENTRY recordDrawArrays(GLenum mode, GLint first, GLsizei count);
+static void APIENTRY recordDrawBuffer(GLenum buffer);
+static void APIENTRY
+recordDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+static void APIENTRY recordDrawElementsInstanced(
+    GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount);
+static void APIENTRY recordEnable(GLenum capability);
+static void APIENTRY recordEnableVertexAttribArray(GLuint index);
+static void APIENTRY recordFramebufferTexture2D(
+    GLenum target, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level);
+static void APIENTRY recordGenBuffers(GLsizei n, GLuint* buffers);
+static void APIENTRY recordGenFramebuffers(GLsizei n, GLuint* framebuffers);
+static void APIENTRY recordGenSamplers(GLsizei n, GLuint* samplers);
+static void APIENTRY recordGenTextures(GLsizei n, GLuint* textures);
+static void APIENTRY recordGenVertexArrays(GLsizei n, GLuint* arrays);
+static void APIENTRY recordGenerateMipmap(GLenum target);
+static GLenum APIENTRY recordGetError();
+static void APIENTRY
+recordGetProgramInfoLog(GLuint program, GLsizei bufferSize, GLsizei* length, GLchar* infoLog);
+static void APIENTRY recordGetProgramiv(GLuint program, GLenum name, GLint* params);
+static void APIENTRY
+recordGetShaderInfoLog(GLuint shader, GLsizei bufferSize, GLsizei* length, GLchar* infoLog);
+static void APIENTRY recordGetShaderiv(GLuint shader, GLenum name, GLint* params);
+static const GLubyte* APIENTRY recordGetString(GLenum name);
+static GLint APIENTRY recordGetUniformLocation(GLuint program, const GLchar* name);
+static void APIENTRY recordLinkProgram(GLuint program);
+static void APIENTRY recordPixelStorei(GLenum name, GLint param);
+static void APIENTRY recordPolygonMode(GLenum face, GLenum mode);
+static void APIENTRY recordSamplerParameteri(GLuint sampler, GLenum name, GLint param);
+static void APIENTRY recordShaderSource(
+    GLuint shader, GLsizei count, const GLchar** strings, const GLint* lengths);
+static void APIENTRY recordTexStorage2D(
+    GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height);
+static void APIENTRY recordTexStorage2DMultisample(
+    GLenum target,
+    GLsizei samples,
+    GLenum internalFormat,
+    GLsizei width,
+    GLsizei height,
+    GLboolean fixedSampleLocations);
+static void APIENTRY recordTexSubImage2D(
+    GLenum target,
+    GLint level,
+    GLint xOffset,
+    GLint yOffset,
+    GLsizei width,
+    GLsizei height,
+    GLenum format,
+    GLenum type,
+    const void* pixels);
+static void APIENTRY recordUniform1f(GLint location, GLfloat value);
+static void APIENTRY recordUniform1i(GLint location, GLint value);
+static void APIENTRY recordUniform1ui(GLint location, GLuint value);
+static void APIENTRY recordUniform2fv(GLint location, GLsizei count, const GLfloat* value);
+static void APIENTRY recordUniform3fv(GLint location, GLsizei count, const GLfloat* value);
+static void APIENTRY recordUniform4fv(GLint location, GLsizei count, const GLfloat* value);
+static void APIENTRY
+recordUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+static void APIENTRY recordUseProgram(GLuint program);
+static void APIENTRY recordVertexAttribBinding(GLuint attributeIndex, GLuint bindingIndex);
+static void APIENTRY recordVertexAttribFormat(
+    GLuint attributeIndex, GLint size, GLenum type, GLboolean normalized, GLuint relativeOffset);
+static void APIENTRY
+recordVertexAttribIFormat(GLuint attributeIndex, GLint size, GLenum type, GLuint relativeOffset);
+static void APIENTRY recordVertexBindingDivisor(GLuint bindingIndex, GLuint divisor);
+static void APIENTRY recordViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+static void recordStateChange(bool changed);
+static void recordDraw(GLsizei numInstances);
+static void recordUniformUpload(GLsizei count, size_t size);
+static void generateNames(GLsizei n, GLuint* names);
+static int getTextureUnit();
+static size_t getPixelSize(GLenum format, GLenum type);
+static void addUniformLocations(GHashTable* uniformLocations, const char* source);
+static void freeUniformLocations(void* uniformLocationsPointer);
+static void freeProgramSource(void* programSourcePointer);
+
+static ShovelerOpenGLRecorder* recorder = NULL;
+static RecordedFunctions previousFunctions;
+
+ShovelerOpenGLRecorder* shovelerOpenGLRecorderCreate() {
+  if (recorder != NULL) {
+    shovelerLogError("Cannot install OpenGL recorder while recorder %p is installed.", recorder);
+    return NULL;
+  }
+
+  recorder = malloc(sizeof(ShovelerOpenGLRecorder));
+  recorder->recordDraws = false;
+  recorder->draws = g_array_new(
+      /* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerOpenGLRecorderDraw));
+  shovelerOpenGLRecorderResetStats(recorder);
+  recorder->nextName = 1;
+  recorder->program = 0;
+  recorder->vertexArray = 0;
+  recorder->framebuffer = 0;
+  recorder->buffers = g_hash_table_new(g_direct_hash, g_direct_equal);
+  recorder->activeTexture = GL_TEXTURE0;
+  for (int i = 0; i < SHOVELER_OPENGL_RECORDER_NUM_TEXTURE_UNITS; i++) {
+    recorder->textures[i] = 0;
+    recorder->samplers[i] = 0;
+  }
+  recorder->capabilities = g_hash_table_new(g_direct_hash, g_direct_equal);
+  recorder->blendSourceFactor = GL_ONE;
+  recorder->blendDestinationFactor = GL_ZERO;
+  recorder->depthFunction = GL_LESS;
+  recorder->depthMask = GL_TRUE;
+  recorder->polygonMode = GL_FILL;
+  for (int i = 0; i < 4; i++) {
+    recorder->viewport[i] = 0;
+  }
+  recorder->shaderSources = g_hash_table_new_full(
+      g_direct_hash, g_direct_equal, /* keyDestroyFunc */ NULL, /* valueDestroyFunc */ g_free);
+  recorder->programUniformLocations = g_hash_table_new_full(
+      g_direct_hash, g_direct_equal, /* keyDestroyFunc */ NULL, freeUniformLocations);
+  recorder->programSources = g_hash_table_new_full(
+      g_direct_hash, g_direct_equal, /* keyDestroyFunc */ NULL, freeProgramSource);
+
+  RECORDED_FUNCTIONS(SAVE_FUNCTION_POINTER)
+  RECORDED_FUNCTIONS(INSTALL_FUNCTION_POINTER)
+
+  return recorder;
+}
+
+void shovelerOpenGLRecorderResetStats(ShovelerOpenGLRecorder* recorder) {
+  recorder->stats.numCalls = 0;
+  recorder->stats.numDrawCalls = 0;
+  recorder->stats.numStateChanges = 0;
+  recorder->stats.numRedundantStateChanges = 0;
+  recorder->stats.numUniformUploads = 0;
+  recorder->stats.numBytesUploaded = 0;
+  g_array_set_size(recorder->draws, 0);
+}
+
+void shovelerOpenGLRecorderLogStats(
+    ShovelerOpenGLRecorder* recorder, const char* label, int numFrames) {
+  double frames = numFrames > 0 ? (double) numFrames : 1.0;
+  shovelerLogInfo(
+      "%s: %.1f OpenGL calls, %.1f draw calls, %.1f state changes (%.1f redundant), %.1f uniform "
+      "uploads and %.1f bytes uploaded per frame.",
+      label,
+      recorder->stats.numCalls / frames,
+      recorder->stats.numDrawCalls / frames,
+      recorder->stats.numStateChanges / frames,
+      recorder->stats.numRedundantStateChanges / frames,
+      recorder->stats.numUniformUploads / frames,
+      recorder->stats.numBytesUploaded / frames);
+}
+
+const char* shovelerOpenGLRecorderGetProgramSource(
+    ShovelerOpenGLRecorder* recorder, GLuint program) {
+  GString* source = g_hash_table_lookup(recorder->programSources, GUINT_TO_POINTER(program));
+  if (source == NULL) {
+    return NULL;
+  }
+
+  return source->str;
+}
+
+void shovelerOpenGLRecorderFree(ShovelerOpenGLRecorder* freedRecorder) {
+  if (freedRecorder == NULL) {
+    return;
+  }
+
+  if (freedRecorder == recorder) {
+    RECORDED_FUNCTIONS(RESTORE_FUNCTION_POINTER)
+    recorder = NULL;
+  }
+
+  g_hash_table_destroy(freedRecorder->programSources);
+  g_hash_table_destroy(freedRecorder->programUniformLocations);
+  g_hash_table_destroy(freedRecorder->shaderSources);
+  g_hash_table_destroy(freedRecorder->capabilities);
+  g_hash_table_destroy(freedRecorder->buffers);
+  g_array_free(freedRecorder->draws, /* freeSegment */ true);
+  free(freedRecorder);
+}
+
+static void APIENTRY recordActiveTexture(GLenum texture) {
+  recorder->stats.numCalls++;
+  recordStateChange(recorder->activeTexture != texture);
+  recorder->activeTexture = texture;
+}
+
+static void APIENTRY recordAttachShader(GLuint program, GLuint shader) {
+  recorder->stats.numCalls++;
+
+  const char* source = g_hash_table_lookup(recorder->shaderSources, GUINT_TO_POINTER(shader));
+  if (source == NULL) {
+    return;
+  }
+
+  GHashTable* uniformLocations =
+      g_hash_table_lookup(recorder->programUniformLocations, GUINT_TO_POINTER(program));
+  if (uniformLocations == NULL) {
+    uniformLocations = g_hash_table_new_full(
+        g_str_hash, g_str_equal, /* keyDestroyFunc */ g_free, /* valueDestroyFunc */ NULL);
+    g_hash_table_insert(
+        recorder->programUniformLocations, GUINT_TO_POINTER(program), uniformLocations);
+  }
+
+  addUniformLocations(uniformLocations, source);
+
+  GString* programSource =
+      g_hash_table_lookup(recorder->programSources, GUINT_TO_POINTER(program));
+  if (programSource == NULL) {
+    programSource = g_string_new("");
+    g_hash_table_insert(recorder->programSources, GUINT_TO_POINTER(program), programSource);
+  }
+  g_string_append(programSource, source);
+}
+
+static void APIENTRY recordBindAttribLocation(GLuint program, GLuint index, const GLchar* name) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordBindBuffer(GLenum target, GLuint buffer) {
+  recorder->stats.numCalls++;
+  GLuint boundBuffer =
+      GPOINTER_TO_UINT(g_hash_table_lookup(recorder->buffers, GUINT_TO_POINTER(target)));
+  recordStateChange(boundBuffer != buffer);
+  g_hash_table_insert(recorder->buffers, GUINT_TO_POINTER(target), GUINT_TO_POINTER(buffer));
+}
+
+static void APIENTRY recordBindFramebuffer(GLenum target, GLuint framebuffer) {
+  recorder->stats.numCalls++;
+  recordStateChange(recorder->framebuffer != framebuffer);
+  recorder->framebuffer = framebuffer;
+}
+
+static void APIENTRY recordBindSampler(GLuint unit, GLuint sampler) {
+  recorder->stats.numCalls++;
+  if (unit >= SHOVELER_OPENGL_RECORDER_NUM_TEXTURE_UNITS) {
+    recordStateChange(/* changed */ true);
+    return;
+  }
+
+  recordStateChange(recorder->samplers[unit] != sampler);
+  recorder->samplers[unit] = sampler;
+}
+
+static void APIENTRY recordBindTexture(GLenum target, GLuint texture) {
+  recorder->stats.numCalls++;
+  int unit = getTextureUnit();
+  if (unit < 0) {
+    recordStateChange(/* changed */ true);
+    return;
+  }
+
+  recordStateChange(recorder->textures[unit] != texture);
+  recorder->textures[unit] = texture;
+}
+
+static void APIENTRY recordBindVertexArray(GLuint array) {
+  recorder->stats.numCalls++;
+  recordStateChange(recorder->vertexArray != array);
+  recorder->vertexArray = array;
+}
+
+static void APIENTRY
+recordBindVertexBuffer(GLuint bindingIndex, GLuint buffer, GLintptr offset, GLsizei stride) {
+  recorder->stats.numCalls++;
+
+  // vertex buffer bindings are part of the vertex array state, which isn't tracked
+  recordStateChange(/* changed */ true);
+}
+
+static void APIENTRY recordBlendFunc(GLenum sourceFactor, GLenum destinationFactor) {
+  recorder->stats.numCalls++;
+  recordStateChange(
+      recorder->blendSourceFactor != sourceFactor ||
+      recorder->blendDestinationFactor != destinationFactor);
+  recorder->blendSourceFactor = sourceFactor;
+  recorder->blendDestinationFactor = destinationFactor;
+}
+
+static void APIENTRY recordBlitFramebuffer(
+    GLint srcX0,
+    GLint srcY0,
+    GLint srcX1,
+    GLint srcY1,
+    GLint dstX0,
+    GLint dstY0,
+    GLint dstX1,
+    GLint dstY1,
+    GLbitfield mask,
+    GLenum filter) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY
+recordBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+  recorder->stats.numCalls++;
+  if (data != NULL) {
+    recorder->stats.numBytesUploaded += size;
+  }
+}
+
+static void APIENTRY
+recordBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+  recorder->stats.numCalls++;
+  recorder->stats.numBytesUploaded += size;
+}
+
+static GLenum APIENTRY recordCheckFramebufferStatus(GLenum target) {
+  recorder->stats.numCalls++;
+  return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void APIENTRY recordClear(GLbitfield mask) { recorder->stats.numCalls++; }
+
+static void APIENTRY recordClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordClearDepth(GLdouble depth) { recorder->stats.numCalls++; }
+
+static void APIENTRY recordCompileShader(GLuint shader) { recorder->stats.numCalls++; }
+
+static GLuint APIENTRY recordCreateProgram() {
+  recorder->stats.numCalls++;
+  return recorder->nextName++;
+}
+
+static GLuint APIENTRY recordCreateShader(GLenum type) {
+  recorder->stats.numCalls++;
+  return recorder->nextName++;
+}
+
+static void APIENTRY recordDeleteBuffers(GLsizei n, const GLuint* buffers) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordDeleteFramebuffers(GLsizei n, const GLuint* framebuffers) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordDeleteProgram(GLuint program) {
+  recorder->stats.numCalls++;
+  g_hash_table_remove(recorder->programUniformLocations, GUINT_TO_POINTER(program));
+}
+
+static void APIENTRY recordDeleteSamplers(GLsizei n, const GLuint* samplers) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordDeleteShader(GLuint shader) {
+  recorder->stats.numCalls++;
+  g_hash_table_remove(recorder->shaderSources, GUINT_TO_POINTER(shader));
+}
+
+static void APIENTRY recordDeleteTextures(GLsizei n, const GLuint* textures) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordDeleteVertexArrays(GLsizei n, const GLuint* arrays) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordDepthFunc(GLenum function) {
+  recorder->stats.numCalls++;
+  recordStateChange(recorder->depthFunction != function);
+  recorder->depthFunction = function;
+}
+
+static void APIENTRY recordDepthMask(GLboolean flag) {
+  recorder->stats.numCalls++;
+  recordStateChange(recorder->depthMask != flag);
+  recorder->depthMask = flag;
+}
+
+static void APIENTRY recordDisable(GLenum capability) {
+  recorder->stats.numCalls++;
+  recordStateChange(g_hash_table_remove(recorder->capabilities, GUINT_TO_POINTER(capability)));
+}
+
+static void APIENTRY recordDrawArrays(GLenum mode, GLint first, GLsizei count) {
+  recorder->stats.numCalls++;
+  recordDraw(/* numInstances */ 1);
+}
+
+static void APIENTRY recordDrawBuffer(GLenum buffer) { recorder->stats.numCalls++; }
+
+static void APIENTRY
+recordDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+  recorder->stats.numCalls++;
+  recordDraw(/* numInstances */ 1);
+}
+
+static void APIENTRY recordDrawElementsInstanced(
+    GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount) {
+  recorder->stats.numCalls++;
+  recordDraw(instanceCount);
+}
+
+static void APIENTRY recordEnable(GLenum capability) {
+  recorder->stats.numCalls++;
+  recordStateChange(g_hash_table_add(recorder->capabilities, GUINT_TO_POINTER(capability)));
+}
+
+static void APIENTRY recordEnableVertexAttribArray(GLuint index) { recorder->stats.numCalls++; }
+
+static void APIENTRY recordFramebufferTexture2D(
+    GLenum target, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordGenBuffers(GLsizei n, GLuint* buffers) {
+  recorder->stats.numCalls++;
+  generateNames(n, buffers);
+}
+
+static void APIENTRY recordGenFramebuffers(GLsizei n, GLuint* framebuffers) {
+  recorder->stats.numCalls++;
+  generateNames(n, framebuffers);
+}
+
+static void APIENTRY recordGenSamplers(GLsizei n, GLuint* samplers) {
+  recorder->stats.numCalls++;
+  generateNames(n, samplers);
+}
+
+static void APIENTRY recordGenTextures(GLsizei n, GLuint* textures) {
+  recorder->stats.numCalls++;
+  generateNames(n, textures);
+}
+
+static void APIENTRY recordGenVertexArrays(GLsizei n, GLuint* arrays) {
+  recorder->stats.numCalls++;
+  generateNames(n, arrays);
+}
+
+static void APIENTRY recordGenerateMipmap(GLenum target) { recorder->stats.numCalls++; }
+
+static GLenum APIENTRY recordGetError() {
+  recorder->stats.numCalls++;
+  return GL_NO_ERROR;
+}
+
+static void APIENTRY
+recordGetProgramInfoLog(GLuint program, GLsizei bufferSize, GLsizei* length, GLchar* infoLog) {
+  recorder->stats.numCalls++;
+  if (length != NULL) {
+    *length = 0;
+  }
+  if (bufferSize > 0) {
+    infoLog[0] = '\0';
+  }
+}
+
+static void APIENTRY recordGetProgramiv(GLuint program, GLenum name, GLint* params) {
+  recorder->stats.numCalls++;
+  *params = name == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+static void APIENTRY
+recordGetShaderInfoLog(GLuint shader, GLsizei bufferSize, GLsizei* length, GLchar* infoLog) {
+  recorder->stats.numCalls++;
+  if (length != NULL) {
+    *length = 0;
+  }
+  if (bufferSize > 0) {
+    infoLog[0] = '\0';
+  }
+}
+
+static void APIENTRY recordGetShaderiv(GLuint shader, GLenum name, GLint* params) {
+  recorder->stats.numCalls++;
+  *params = name == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+static const GLubyte* APIENTRY recordGetString(GLenum name) {
+  recorder->stats.numCalls++;
+  return (const GLubyte*) "shoveler OpenGL recorder";
+}
+
+static GLint APIENTRY recordGetUniformLocation(GLuint program, const GLchar* name) {
+  recorder->stats.numCalls++;
+
+  GHashTable* uniformLocations =
+      g_hash_table_lookup(recorder->programUniformLocations, GUINT_TO_POINTER(program));
+  if (uniformLocations == NULL) {
+    return -1;
+  }
+
+  gpointer location;
+  if (!g_hash_table_lookup_extended(uniformLocations, name, NULL, &location)) {
+    return -1;
+  }
+
+  return GPOINTER_TO_INT(location);
+}
+
+static void APIENTRY recordLinkProgram(GLuint program) { recorder->stats.numCalls++; }
+
+static void APIENTRY recordPixelStorei(GLenum name, GLint param) { recorder->stats.numCalls++; }
+
+static void APIENTRY recordPolygonMode(GLenum face, GLenum mode) {
+  recorder->stats.numCalls++;
+  recordStateChange(recorder->polygonMode != mode);
+  recorder->polygonMode = mode;
+}
+
+static void APIENTRY recordSamplerParameteri(GLuint sampler, GLenum name, GLint param) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordShaderSource(
+    GLuint shader, GLsizei count, const GLchar** strings, const GLint* lengths) {
+  recorder->stats.numCalls++;
+
+  GString* source = g_string_new("");
+  for (GLsizei i = 0; i < count; i++) {
+    if (lengths == NULL || lengths[i] < 0) {
+      g_string_append(source, strings[i]);
+    } else {
+      g_string_append_len(source, strings[i], lengths[i]);
+    }
+  }
+
+  g_hash_table_insert(
+      recorder->shaderSources,
+      GUINT_TO_POINTER(shader),
+      g_string_free(source, /* freeSegment */ false));
+}
+
+static void APIENTRY recordTexStorage2D(
+    GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordTexStorage2DMultisample(
+    GLenum target,
+    GLsizei samples,
+    GLenum internalFormat,
+    GLsizei width,
+    GLsizei height,
+    GLboolean fixedSampleLocations) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordTexSubImage2D(
+    GLenum target,
+    GLint level,
+    GLint xOffset,
+    GLint yOffset,
+    GLsizei width,
+    GLsizei height,
+    GLenum format,
+    GLenum type,
+    const void* pixels) {
+  recorder->stats.numCalls++;
+  recorder->stats.numBytesUploaded += (gint64) width * height * getPixelSize(format, type);
+}
+
+static void APIENTRY recordUniform1f(GLint location, GLfloat value) {
+  recordUniformUpload(1, sizeof(GLfloat));
+}
+
+static void APIENTRY recordUniform1i(GLint location, GLint value) {
+  recordUniformUpload(1, sizeof(GLint));
+}
+
+static void APIENTRY recordUniform1ui(GLint location, GLuint value) {
+  recordUniformUpload(1, sizeof(GLuint));
+}
+
+static void APIENTRY recordUniform2fv(GLint location, GLsizei count, const GLfloat* value) {
+  recordUniformUpload(count, 2 * sizeof(GLfloat));
+}
+
+static void APIENTRY recordUniform3fv(GLint location, GLsizei count, const GLfloat* value) {
+  recordUniformUpload(count, 3 * sizeof(GLfloat));
+}
+
+static void APIENTRY recordUniform4fv(GLint location, GLsizei count, const GLfloat* value) {
+  recordUniformUpload(count, 4 * sizeof(GLfloat));
+}
+
+static void APIENTRY
+recordUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+  recordUniformUpload(count, 16 * sizeof(GLfloat));
+}
+
+static void APIENTRY recordUseProgram(GLuint program) {
+  recorder->stats.numCalls++;
+  recordStateChange(recorder->program != program);
+  recorder->program = program;
+}
+
+static void APIENTRY recordVertexAttribBinding(GLuint attributeIndex, GLuint bindingIndex) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordVertexAttribFormat(
+    GLuint attributeIndex, GLint size, GLenum type, GLboolean normalized, GLuint relativeOffset) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY
+recordVertexAttribIFormat(GLuint attributeIndex, GLint size, GLenum type, GLuint relativeOffset) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordVertexBindingDivisor(GLuint bindingIndex, GLuint divisor) {
+  recorder->stats.numCalls++;
+}
+
+static void APIENTRY recordViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  recorder->stats.numCalls++;
+  GLint viewport[4] = {x, y, width, height};
+  recordStateChange(memcmp(recorder->viewport, viewport, sizeof(viewport)) != 0);
+  memcpy(recorder->viewport, viewport, sizeof(viewport));
+}
+
+static void recordStateChange(bool changed) {
+  recorder->stats.numStateChanges++;
+  if (!changed) {
+    recorder->stats.numRedundantStateChanges++;
+  }
+}
+
+static void recordDraw(GLsizei numInstances) {
+  recorder->stats.numDrawCalls++;
+  if (!recorder->recordDraws) {
+    return;
+  }
+
+  ShovelerOpenGLRecorderDraw draw;
+  draw.program = recorder->program;
+  draw.depthTest = g_hash_table_contains(recorder->capabilities, GUINT_TO_POINTER(GL_DEPTH_TEST));
+  draw.depthFunction = recorder->depthFunction;
+  draw.numInstances = numInstances;
+  g_array_append_val(recorder->draws, draw);
+}
+
+static void recordUniformUpload(GLsizei count, size_t size) {
+  recorder->stats.numCalls++;
+  recorder->stats.numUniformUploads++;
+  recorder->stats.numBytesUploaded += (gint64) count * size;
+}
+
+static void generateNames(GLsizei n, GLuint* names) {
+  for (GLsizei i = 0; i < n; i++) {
+    names[i] = recorder->nextName++;
+  }
+}
+
+static int getTextureUnit() {
+  if (recorder->activeTexture < GL_TEXTURE0) {
+    return -1;
+  }
+
+  int unit = (int) (recorder->activeTexture - GL_TEXTURE0);
+  if (unit >= SHOVELER_OPENGL_RECORDER_NUM_TEXTURE_UNITS) {
+    return -1;
+  }
+
+  return unit;
+}
+
+static size_t getPixelSize(GLenum format, GLenum type) {
+  size_t numComponents;
+  switch (format) {
+  case GL_RG:
+  case GL_RG_INTEGER:
+    numComponents = 2;
+    break;
+  case GL_RGB:
+  case GL_BGR:
+  case GL_RGB_INTEGER:
+    numComponents = 3;
+    break;
+  case GL_RGBA:
+  case GL_BGRA:
+  case GL_RGBA_INTEGER:
+    numComponents = 4;
+    break;
+  default:
+    numComponents = 1;
+    break;
+  }
+
+  switch (type) {
+  case GL_UNSIGNED_SHORT:
+  case GL_SHORT:
+  case GL_HALF_FLOAT:
+    return numComponents * 2;
+  case GL_UNSIGNED_INT:
+  case GL_INT:
+  case GL_FLOAT:
+    return numComponents * 4;
+  default:
+    return numComponents;
+  }
+}
+
+/**
+ * Assigns consecutive locations to all uniforms declared in the given source that don't have one
+ * yet. Only declarations at the start of a line are recognized, which is how all of the sources
+ * in this repository are written.
+ */
+static void addUniformLocations(GHashTable* uniformLocations, const char* source) {
+  static const char* keyword = "uniform ";
+  size_t keywordLength = strlen(keyword);
+
+  for (const char* line = source; line != NULL && *line != '\0';) {
+    const char* position = line;
+    while (*position == ' ' || *position == '\t') {
+      position++;
+    }
+
+    if (strncmp(position, keyword, keywordLength) == 0) {
+      // skip the keyword and the type to arrive at the name
+      position += keywordLength;
+      while (*position == ' ') {
+        position++;
+      }
+      while (*position != ' ' && *position != '\0' && *position != '\n') {
+        position++;
+      }
+      while (*position == ' ') {
+        position++;
+      }
+
+      const char* nameEnd = position;
+      while (g_ascii_isalnum(*nameEnd) || *nameEnd == '_') {
+        nameEnd++;
+      }
+
+      if (nameEnd > position) {
+        char* name = g_strndup(position, nameEnd - position);
+        if (g_hash_table_contains(uniformLocations, name)) {
+          g_free(name);
+        } else {
+          guint location = g_hash_table_size(uniformLocations);
+          g_hash_table_insert(uniformLocations, name, GINT_TO_POINTER(location));
+        }
+      }
+    }
+
+    line = strchr(position, '\n');
+    if (line != NULL) {
+      line++;
+    }
+  }
+}
+
+static void freeUniformLocations(void* uniformLocationsPointer) {
+  g_hash_table_destroy(uniformLocationsPointer);
+}
+
+static void freeProgramSource(void* programSourcePointer) {
+  g_string_free(programSourcePointer, /* freeSegment */ true);
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "shoveler/camera/perspective.h"
+#include "shoveler/constants.h"
+#include "shoveler/drawable/quad.h"
+#include "shoveler/framebuffer.h"
+#include "shoveler/light/point.h"
+#include "shoveler/material.h"
+#include "shoveler/material/color.h"
+#include "shoveler/model.h"
+#include "shoveler/opengl_recorder.h"
+#include "shoveler/render_state.h"
+#include "shoveler/scene.h"
+#include "shoveler/shader_cache.h"
+#include "shoveler/shader_program.h"
+}
+
+static void APIENTRY previousUseProgram(GLuint program) {}
+
+class ShovelerOpenGLRecorderTest : public ::testing::Test {
+public:
+  virtual void SetUp() {
+    glad_glUseProgram = previousUseProgram;
+    recorder = shovelerOpenGLRecorderCreate();
+  }
+
+  virtual void TearDown() {
+    shovelerOpenGLRecorderFree(recorder);
+    glad_glUseProgram = NULL;
+  }
+
+  ShovelerOpenGLRecorder* recorder;
+};
+
+TEST_F(ShovelerOpenGLRecorderTest, installAndRestore) {
+  ASSERT_TRUE(recorder != NULL);
+  ASSERT_NE(glad_glUseProgram, previousUseProgram);
+  ASSERT_TRUE(shovelerOpenGLRecorderCreate() == NULL)
+      << "a second recorder should not be installed at the same time";
+
+  shovelerOpenGLRecorderFree(recorder);
+  recorder = NULL;
+  ASSERT_EQ(glad_glUseProgram, previousUseProgram) << "freeing should restore previous functions";
+}
+
+TEST_F(ShovelerOpenGLRecorderTest, countStateChanges) {
+  glUseProgram(1);
+  glUseProgram(1);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, 2);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, 2);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, 2);
+  glEnable(GL_BLEND);
+  glEnable(GL_BLEND);
+  glDisable(GL_BLEND);
+  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+
+  ASSERT_EQ(recorder->stats.numCalls, 12);
+  ASSERT_EQ(recorder->stats.numDrawCalls, 1);
+  ASSERT_EQ(recorder->stats.numStateChanges, 11);
+  ASSERT_EQ(recorder->stats.numRedundantStateChanges, 4)
+      << "repeated program, texture unit, texture and capability changes should be redundant";
+
+  shovelerOpenGLRecorderResetStats(recorder);
+  ASSERT_EQ(recorder->stats.numCalls, 0);
+}
+
+TEST_F(ShovelerOpenGLRecorderTest, countUploads) {
+  GLfloat matrix[16] = {0};
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  glBufferData(GL_ARRAY_BUFFER, 100, matrix, GL_STATIC_DRAW);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 4, 2, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glUniformMatrix4fv(0, 1, GL_FALSE, matrix);
+  glUniform1i(1, 0);
+
+  ASSERT_NE(buffer, 0);
+  ASSERT_EQ(recorder->stats.numUniformUploads, 2);
+  ASSERT_EQ(recorder->stats.numBytesUploaded, 100 + 4 * 2 * 4 + 16 * 4 + 4);
+}
+
+TEST_F(ShovelerOpenGLRecorderTest, uniformLocations) {
+  GLuint program = shovelerShaderProgramLink(
+      shovelerShaderProgramCompileFromString(
+          "uniform mat4 model;\nuniform vec3 color;\nvoid main() {}\n", GL_VERTEX_SHADER),
+      /* geometryShader */ 0,
+      shovelerShaderProgramCompileFromString(
+          "uniform vec3 color;\n  uniform sampler2D texture;\nvoid main() {}\n",
+          GL_FRAGMENT_SHADER),
+      /* deleteShaders */ true);
+  ASSERT_NE(program, 0);
+
+  GLint modelLocation = glGetUniformLocation(program, "model");
+  GLint colorLocation = glGetUniformLocation(program, "color");
+  GLint textureLocation = glGetUniformLocation(program, "texture");
+  ASSERT_GE(modelLocation, 0);
+  ASSERT_GE(colorLocation, 0);
+  ASSERT_GE(textureLocation, 0);
+  ASSERT_NE(modelLocation, colorLocation);
+  ASSERT_NE(colorLocation, textureLocation);
+  ASSERT_EQ(glGetUniformLocation(program, "missing"), -1);
+
+  glDeleteProgram(program);
+}
+
+TEST_F(ShovelerOpenGLRecorderTest, renderSceneHeadless) {
+  ShovelerShaderCache* shaderCache = shovelerShaderCacheCreate();
+  ShovelerScene* scene = shovelerSceneCreate(shaderCache);
+
+  ShovelerReferenceFrame frame = shovelerReferenceFrame(
+      shovelerVector3(0.0f, 0.0f, 5.0f),
+      shovelerVector3(0.0f, 0.0f, -1.0f),
+      shovelerVector3(0.0f, 1.0f, 0.0f));
+  ShovelerProjectionPerspective projection = {
+      /* fieldOfViewY */ SHOVELER_PI / 2.0f,
+      /* aspectRatio */ 1.0f,
+      /* nearClippingPlane */ 0.01f,
+      /* farClippingPlane */ 100.0f};
+  ShovelerCamera* camera = shovelerCameraPerspectiveCreate(shaderCache, &frame, &projection);
+  ShovelerFramebuffer* framebuffer = shovelerFramebufferCreate(
+      64, 64, /* samples */ 1, /* channels */ 4, /* bitsPerChannel */ 8);
+
+  ShovelerMaterial* material = shovelerMaterialColorCreate(
+      shaderCache, /* screenspace */ false, shovelerVector4(1.0f, 1.0f, 1.0f, 1.0f));
+  ShovelerDrawable* quad = shovelerDrawableQuadCreate();
+  ShovelerModel* model = shovelerModelCreate(quad, material);
+  shovelerSceneAddModel(scene, model);
+
+  ShovelerLight* light = shovelerLightPointCreate(
+      shaderCache,
+      shovelerVector3(0.0f, 0.0f, 2.0f),
+      /* width */ 64,
+      /* height */ 64,
+      /* samples */ 1,
+      /* ambientFactor */ 0.0f,
+      /* exponentialFactor */ 80.0f,
+      shovelerVector3(1.0f, 1.0f, 1.0f));
+  shovelerSceneAddLight(scene, light);
+
+  ShovelerRenderState renderState;
+  renderState.blend = true;
+  renderState.blendSourceFactor = GL_ONE;
+  renderState.blendDestinationFactor = GL_ZERO;
+  renderState.depthTest = true;
+  renderState.depthFunction = GL_LESS;
+  renderState.depthMask = GL_TRUE;
+  shovelerRenderStateReset(&renderState);
+  shovelerOpenGLRecorderResetStats(recorder);
+
+  int rendered = shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+  ASSERT_GT(rendered, 0);
+  ASSERT_GT(recorder->stats.numDrawCalls, 0);
+  ASSERT_GT(recorder->stats.numUniformUploads, 0);
+
+  shovelerSceneFree(scene);
+  shovelerDrawableFree(quad);
+  shovelerMaterialFree(material);
+  shovelerFramebufferFree(framebuffer, /* keepTargets */ false);
+  shovelerCameraFree(camera);
+  shovelerShaderCacheFree(shaderCache);
+}
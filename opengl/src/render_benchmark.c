@@ -0,0 +1,245 @@
+#include <shoveler/camera/perspective.h>
+#include <shoveler/canvas.h>
+#include <shoveler/constants.h>
+#include <shoveler/drawable/quad.h>
+#include <shoveler/framebuffer.h>
+#include <shoveler/image.h>
+#include <shoveler/light/point.h>
+#include <shoveler/log.h>
+#include <shoveler/material.h>
+#include <shoveler/material/canvas.h>
+#include <shoveler/material/tile_sprite.h>
+#include <shoveler/material/tilemap.h>
+#include <shoveler/model.h>
+#include <shoveler/opengl_recorder.h>
+#include <shoveler/render_state.h>
+#include <shoveler/scene.h>
+#include <shoveler/shader_cache.h>
+#include <shoveler/sprite.h>
+#include <shoveler/sprite/tile.h>
+#include <shoveler/sprite/tilemap.h>
+#include <shoveler/texture.h>
+#include <shoveler/tilemap.h>
+#include <shoveler/tileset.h>
+#include <stdlib.h> // EXIT_FAILURE, EXIT_SUCCESS, malloc, free, rand
+
+#define NUM_SPRITES 10000
+#define NUM_TILEMAPS 100
+#define NUM_LIGHTS 50
+#define NUM_TILESETS 4
+#define NUM_LAYERS 3
+#define NUM_CANVAS_FRAMES 100
+#define NUM_SCENE_FRAMES 10
+#define TILEMAP_SIZE 16
+#define WORLD_SIZE 100.0f
+#define FRAMEBUFFER_SIZE 1024
+#define SHADOW_MAP_SIZE 256
+
+static ShovelerTileset* createTileset();
+static ShovelerTilemap* createTilemap(ShovelerTileset* tileset);
+static float randomCoordinate();
+
+int main(int argc, char* argv[]) {
+  shovelerLogInit("shoveler/", SHOVELER_LOG_LEVEL_INFO_UP, stdout);
+  srand(0);
+
+  ShovelerOpenGLRecorder* recorder = shovelerOpenGLRecorderCreate();
+  if (recorder == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  ShovelerShaderCache* shaderCache = shovelerShaderCacheCreate();
+  ShovelerScene* scene = shovelerSceneCreate(shaderCache);
+
+  ShovelerReferenceFrame frame = shovelerReferenceFrame(
+      shovelerVector3(0.0f, 0.0f, WORLD_SIZE),
+      shovelerVector3(0.0f, 0.0f, -1.0f),
+      shovelerVector3(0.0f, 1.0f, 0.0f));
+  ShovelerProjectionPerspective projection;
+  projection.fieldOfViewY = SHOVELER_PI / 2.0f;
+  projection.aspectRatio = 1.0f;
+  projection.nearClippingPlane = 0.01f;
+  projection.farClippingPlane = 1000.0f;
+  ShovelerCamera* camera = shovelerCameraPerspectiveCreate(shaderCache, &frame, &projection);
+  ShovelerFramebuffer* framebuffer = shovelerFramebufferCreate(
+      FRAMEBUFFER_SIZE,
+      FRAMEBUFFER_SIZE,
+      /* samples */ 1,
+      /* channels */ 4,
+      /* bitsPerChannel */ 8);
+
+  ShovelerCanvas* canvas = shovelerCanvasCreate(NUM_LAYERS);
+  ShovelerTileset* tilesets[NUM_TILESETS];
+  for (int i = 0; i < NUM_TILESETS; i++) {
+    tilesets[i] = createTileset();
+  }
+
+  ShovelerMaterial* tileSpriteMaterial =
+      shovelerMaterialTileSpriteCreate(shaderCache, /* screenspace */ false);
+  ShovelerSprite** sprites = malloc(NUM_SPRITES * sizeof(ShovelerSprite*));
+  for (int i = 0; i < NUM_SPRITES; i++) {
+    sprites[i] = shovelerSpriteTileCreate(
+        tileSpriteMaterial, tilesets[rand() % NUM_TILESETS], rand() % 4, rand() % 4);
+    shovelerSpriteUpdatePosition(
+        sprites[i], shovelerVector2(randomCoordinate(), randomCoordinate()));
+    shovelerSpriteUpdateSize(sprites[i], shovelerVector2(1.0f, 1.0f));
+    int layerId = 1 + i * (NUM_LAYERS - 1) / NUM_SPRITES;
+    shovelerCanvasAddSprite(canvas, layerId, sprites[i]);
+  }
+
+  ShovelerMaterial* tilemapMaterial =
+      shovelerMaterialTilemapCreate(shaderCache, /* screenspace */ false);
+  ShovelerTilemap* tilemaps[NUM_TILEMAPS];
+  ShovelerSprite* tilemapSprites[NUM_TILEMAPS];
+  float tilemapSpriteSize = WORLD_SIZE / 10.0f;
+  for (int i = 0; i < NUM_TILEMAPS; i++) {
+    tilemaps[i] = createTilemap(tilesets[i % NUM_TILESETS]);
+    tilemapSprites[i] = shovelerSpriteTilemapCreate(tilemapMaterial, tilemaps[i]);
+    shovelerSpriteUpdatePosition(
+        tilemapSprites[i],
+        shovelerVector2(
+            -0.5f * WORLD_SIZE + ((float) (i % 10) + 0.5f) * tilemapSpriteSize,
+            -0.5f * WORLD_SIZE + ((float) (i / 10) + 0.5f) * tilemapSpriteSize));
+    shovelerSpriteUpdateSize(
+        tilemapSprites[i], shovelerVector2(tilemapSpriteSize, tilemapSpriteSize));
+    shovelerCanvasAddSprite(canvas, /* layerId */ 0, tilemapSprites[i]);
+  }
+
+  ShovelerMaterial* canvasMaterial =
+      shovelerMaterialCanvasCreate(shaderCache, /* screenspace */ false);
+  shovelerMaterialCanvasSetActive(canvasMaterial, canvas);
+  shovelerMaterialCanvasSetActiveRegion(
+      canvasMaterial, shovelerVector2(0.0f, 0.0f), shovelerVector2(WORLD_SIZE, WORLD_SIZE));
+  ShovelerDrawable* quad = shovelerDrawableQuadCreate();
+  ShovelerModel* canvasModel = shovelerModelCreate(quad, canvasMaterial);
+  canvasModel->scale = shovelerVector3(0.5f * WORLD_SIZE, 0.5f * WORLD_SIZE, 1.0f);
+  shovelerModelUpdateTransformation(canvasModel);
+  shovelerSceneAddModel(scene, canvasModel);
+
+  for (int i = 0; i < NUM_LIGHTS; i++) {
+    ShovelerLight* light = shovelerLightPointCreate(
+        shaderCache,
+        shovelerVector3(randomCoordinate(), randomCoordinate(), 10.0f),
+        SHADOW_MAP_SIZE,
+        SHADOW_MAP_SIZE,
+        /* samples */ 1,
+        /* ambientFactor */ 0.0f,
+        /* exponentialFactor */ 80.0f,
+        shovelerVector3(1.0f, 1.0f, 1.0f));
+    shovelerSceneAddLight(scene, light);
+  }
+
+  ShovelerRenderState renderState;
+  renderState.blend = true;
+  renderState.blendSourceFactor = GL_ONE;
+  renderState.blendDestinationFactor = GL_ZERO;
+  renderState.depthTest = true;
+  renderState.depthFunction = GL_LESS;
+  renderState.depthMask = GL_TRUE;
+  shovelerRenderStateReset(&renderState);
+
+  // Render one frame of each kind before measuring, so that all shaders are generated and cached.
+  shovelerCanvasRender(
+      canvas,
+      shovelerVector2(0.0f, 0.0f),
+      shovelerVector2(WORLD_SIZE, WORLD_SIZE),
+      scene,
+      camera,
+      /* light */ NULL,
+      canvasModel,
+      &renderState);
+  shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+
+  shovelerOpenGLRecorderResetStats(recorder);
+  gint64 startTime = g_get_monotonic_time();
+  for (int frame = 0; frame < NUM_CANVAS_FRAMES; frame++) {
+    shovelerCanvasRender(
+        canvas,
+        shovelerVector2(0.0f, 0.0f),
+        shovelerVector2(WORLD_SIZE, WORLD_SIZE),
+        scene,
+        camera,
+        /* light */ NULL,
+        canvasModel,
+        &renderState);
+  }
+  gint64 canvasTimeUs = g_get_monotonic_time() - startTime;
+  shovelerLogInfo(
+      "Rendered canvas with %d sprites and %d tilemaps in %.3fms per frame.",
+      NUM_SPRITES,
+      NUM_TILEMAPS,
+      (double) canvasTimeUs / NUM_CANVAS_FRAMES / 1000.0);
+  shovelerOpenGLRecorderLogStats(recorder, "Canvas", NUM_CANVAS_FRAMES);
+
+  shovelerOpenGLRecorderResetStats(recorder);
+  shovelerSceneResetRenderPassStats(scene);
+  int rendered = 0;
+  startTime = g_get_monotonic_time();
+  for (int frame = 0; frame < NUM_SCENE_FRAMES; frame++) {
+    rendered = shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+  }
+  gint64 sceneTimeUs = g_get_monotonic_time() - startTime;
+  shovelerLogInfo(
+      "Rendered scene with %d lights and %d models in %.3fms per frame.",
+      NUM_LIGHTS,
+      rendered,
+      (double) sceneTimeUs / NUM_SCENE_FRAMES / 1000.0);
+  shovelerOpenGLRecorderLogStats(recorder, "Scene", NUM_SCENE_FRAMES);
+  shovelerSceneLogRenderPassStats(scene, NUM_SCENE_FRAMES);
+
+  shovelerSceneFree(scene);
+  shovelerDrawableFree(quad);
+  shovelerMaterialFree(canvasMaterial);
+  for (int i = 0; i < NUM_TILEMAPS; i++) {
+    shovelerSpriteFree(tilemapSprites[i]);
+    shovelerTextureFree(tilemaps[i]->tiles);
+    shovelerTilemapFree(tilemaps[i]);
+  }
+  shovelerMaterialFree(tilemapMaterial);
+  for (int i = 0; i < NUM_SPRITES; i++) {
+    shovelerSpriteFree(sprites[i]);
+  }
+  free(sprites);
+  shovelerMaterialFree(tileSpriteMaterial);
+  for (int i = 0; i < NUM_TILESETS; i++) {
+    shovelerTilesetFree(tilesets[i]);
+  }
+  shovelerCanvasFree(canvas);
+  shovelerFramebufferFree(framebuffer, /* keepTargets */ false);
+  shovelerCameraFree(camera);
+  shovelerShaderCacheFree(shaderCache);
+  shovelerOpenGLRecorderFree(recorder);
+  shovelerLogTerminate();
+
+  return EXIT_SUCCESS;
+}
+
+static ShovelerTileset* createTileset() {
+  ShovelerImage* image = shovelerImageCreate(4, 4, 4);
+  shovelerImageClear(image);
+  ShovelerTileset* tileset = shovelerTilesetCreate(image, 4, 4, 1);
+  shovelerImageFree(image);
+  return tileset;
+}
+
+static ShovelerTilemap* createTilemap(ShovelerTileset* tileset) {
+  ShovelerImage* tilesImage = shovelerImageCreate(TILEMAP_SIZE, TILEMAP_SIZE, 3);
+  for (int x = 0; x < TILEMAP_SIZE; x++) {
+    for (int y = 0; y < TILEMAP_SIZE; y++) {
+      shovelerImageGet(tilesImage, x, y, 0) = rand() % 4; // column
+      shovelerImageGet(tilesImage, x, y, 1) = rand() % 4; // row
+      shovelerImageGet(tilesImage, x, y, 2) = 1; // first tileset
+    }
+  }
+
+  ShovelerTexture* tiles = shovelerTextureCreate2d(tilesImage, /* manageImage */ true);
+  shovelerTextureUpdate(tiles);
+
+  ShovelerTilemap* tilemap = shovelerTilemapCreate(tiles, /* collidingTiles */ NULL);
+  shovelerTilemapAddTileset(tilemap, tileset);
+  return tilemap;
+}
+
+static float randomCoordinate() {
+  return WORLD_SIZE * ((float) rand() / RAND_MAX - 0.5f);
+}
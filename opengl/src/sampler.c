@@ -4,6 +4,8 @@
 
 #include "shoveler/opengl.h"
 
+static unsigned int bindingGeneration = 0;
+
 ShovelerSampler* shovelerSamplerCreate(bool interpolate, bool useMipmaps, bool clamp) {
   ShovelerSampler* sampler = malloc(sizeof(ShovelerSampler));
   glGenSamplers(1, &sampler->sampler);
@@ -37,12 +39,16 @@ ShovelerSampler* shovelerSamplerCreate(bool interpolate, bool useMipmaps, bool c
   return sampler;
 }
 
+unsigned int shovelerSamplerGetBindingGeneration() { return bindingGeneration; }
+
 bool shovelerSamplerUse(ShovelerSampler* sampler, GLuint unitIndex) {
   glBindSampler(unitIndex, sampler->sampler);
   return shovelerOpenGLCheckSuccess();
 }
 
 void shovelerSamplerFree(ShovelerSampler* sampler) {
+  // the sampler name could be reused by a new sampler, which isn't bound to the units it was
+  bindingGeneration++;
   glDeleteSamplers(1, &sampler->sampler);
   free(sampler);
 }
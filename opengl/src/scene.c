@@ -1,7 +1,9 @@
 #include "shoveler/scene.h"
 
+#include <math.h> // sqrtf
 #include <stdlib.h> // malloc, free
 
+#include "shoveler/camera.h"
 #include "shoveler/light.h"
 #include "shoveler/log.h"
 #include "shoveler/material/depth.h"
@@ -9,16 +11,17 @@
 #include "shoveler/shader.h"
 #include "shoveler/shader_cache.h"
 
-typedef enum {
-  RENDER_MODE_OCCLUDED,
-  RENDER_MODE_EMITTERS,
-  RENDER_MODE_SCREENSPACE,
-  RENDER_MODE_ADDITIVE_LIGHT,
-} RenderMode;
-
-ShovelerSceneRenderPassOptions createRenderPassOptions(ShovelerScene* scene, RenderMode renderMode);
+ShovelerSceneRenderPassOptions createRenderPassOptions(
+    ShovelerScene* scene, ShovelerSceneRenderPassType type);
+static void updateRenderQueues(ShovelerScene* scene, ShovelerCamera* camera);
+static const guint32* getVisibility(ShovelerScene* scene, ShovelerCamera* camera);
+static guint64 computeSortKey(ShovelerModel* model, ShovelerCamera* camera);
+static gint compareRenderQueueEntries(gconstpointer firstPointer, gconstpointer secondPointer);
+static int getRenderQueueIndex(bool emitter, bool screenspace);
+static guint64 mixHash(guint64 value);
 static void freeLight(void* lightPointer);
 static void freeModel(void* modelPointer);
+static void freeVisibility(void* visibilityPointer);
 
 ShovelerScene* shovelerSceneCreate(ShovelerShaderCache* shaderCache) {
   ShovelerScene* scene = malloc(sizeof(ShovelerScene));
@@ -29,6 +32,15 @@ ShovelerScene* shovelerSceneCreate(ShovelerShaderCache* shaderCache) {
   scene->activeFramebufferSize = shovelerVector2(0.0f, 0.0f);
   scene->lights = g_hash_table_new_full(g_direct_hash, g_direct_equal, freeLight, NULL);
   scene->models = g_hash_table_new_full(g_direct_hash, g_direct_equal, freeModel, NULL);
+  for (int i = 0; i < SHOVELER_SCENE_NUM_RENDER_QUEUES; i++) {
+    scene->renderQueues[i] = g_array_new(
+        /* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerSceneRenderQueueEntry));
+  }
+  scene->renderQueuesValid = false;
+  scene->boundingVolumes = shovelerBoundingVolumesCreate();
+  scene->cameraVisibilities =
+      g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, freeVisibility);
+  shovelerSceneResetRenderPassStats(scene);
 
   shovelerUniformMapInsert(
       scene->uniforms, "sceneDebugMode", shovelerUniformCreateBoolPointer(&scene->debugMode));
@@ -64,25 +76,41 @@ int shovelerSceneRenderPass(
     ShovelerLight* light,
     ShovelerSceneRenderPassOptions options,
     ShovelerRenderState* renderState) {
-  int rendered = 0;
+  if (!scene->renderQueuesValid) {
+    updateRenderQueues(scene, camera);
+  }
 
-  GHashTableIter iter;
-  ShovelerModel* model;
-  g_hash_table_iter_init(&iter, scene->models);
-  while (g_hash_table_iter_next(&iter, (gpointer*) &model, NULL)) {
-    if (!model->visible) {
-      continue;
-    }
+  ShovelerShaderCache* shaderCache = scene->shaderCache;
+  gint64 numProgramChanges = shaderCache->numProgramChanges;
+  gint64 numSkippedProgramChanges = shaderCache->numSkippedProgramChanges;
+  gint64 numTextureBinds = shaderCache->uniformUploadStats.numTextureBinds;
+  gint64 numSkippedTextureBinds = shaderCache->uniformUploadStats.numSkippedTextureBinds;
+
+  const guint32* visibility = NULL;
+  if (camera != NULL && !options.screenspace) {
+    visibility = getVisibility(scene, camera);
+  }
 
-    if (model->emitter != options.emitters) {
+  int rendered = 0;
+  int culled = 0;
+
+  GArray* renderQueue =
+      scene->renderQueues[getRenderQueueIndex(options.emitters, options.screenspace)];
+  for (guint i = 0; i < renderQueue->len; i++) {
+    const ShovelerSceneRenderQueueEntry* entry =
+        &g_array_index(renderQueue, ShovelerSceneRenderQueueEntry, i);
+    ShovelerModel* model = entry->model;
+    if (!model->visible) {
       continue;
     }
 
-    if (model->material->screenspace != options.screenspace) {
+    if (options.onlyShadowCasters && !model->material->screenspace && !model->castsShadow) {
       continue;
     }
 
-    if (options.onlyShadowCasters && !model->material->screenspace && !model->castsShadow) {
+    if (visibility != NULL &&
+        !shovelerBoundingVolumesIsVisible(visibility, entry->boundingVolumeIndex)) {
+      culled++;
       continue;
     }
 
@@ -97,9 +125,51 @@ int shovelerSceneRenderPass(
 
     rendered++;
   }
+
+  ShovelerSceneRenderPassStats* stats = &scene->renderPassStats[options.type];
+  stats->numPasses++;
+  stats->numModels += rendered;
+  stats->numCulledModels += culled;
+  stats->numProgramChanges += shaderCache->numProgramChanges - numProgramChanges;
+  stats->numSkippedProgramChanges +=
+      shaderCache->numSkippedProgramChanges - numSkippedProgramChanges;
+  stats->numTextureBinds += shaderCache->uniformUploadStats.numTextureBinds - numTextureBinds;
+  stats->numSkippedTextureBinds +=
+      shaderCache->uniformUploadStats.numSkippedTextureBinds - numSkippedTextureBinds;
+
   return rendered;
 }
 
+guint64 shovelerSceneHashShadowCasters(ShovelerScene* scene, ShovelerCamera* camera) {
+  if (!scene->renderQueuesValid) {
+    updateRenderQueues(scene, camera);
+  }
+
+  const guint32* visibility = getVisibility(scene, camera);
+
+  guint64 hash = 0;
+  GArray* renderQueue = scene->renderQueues[getRenderQueueIndex(
+      /* emitter */ false, /* screenspace */ false)];
+  for (guint i = 0; i < renderQueue->len; i++) {
+    const ShovelerSceneRenderQueueEntry* entry =
+        &g_array_index(renderQueue, ShovelerSceneRenderQueueEntry, i);
+    ShovelerModel* model = entry->model;
+    if (!model->visible || !model->castsShadow ||
+        !shovelerBoundingVolumesIsVisible(visibility, entry->boundingVolumeIndex)) {
+      continue;
+    }
+
+    guint64 modelHash = mixHash((guintptr) model);
+    modelHash = mixHash(modelHash ^ (guintptr) model->drawable);
+    modelHash = mixHash(modelHash ^ model->transformationVersion);
+
+    // summed so that the hash doesn't depend on the queue order, which follows the main camera
+    hash += modelHash;
+  }
+
+  return hash;
+}
+
 int shovelerSceneRenderFrame(
     ShovelerScene* scene,
     ShovelerCamera* camera,
@@ -107,6 +177,10 @@ int shovelerSceneRenderFrame(
     ShovelerRenderState* renderState) {
   int rendered = 0;
 
+  // Sort the models once for all passes of the frame, including the light passes.
+  updateRenderQueues(scene, camera);
+  scene->renderQueuesValid = true;
+
   shovelerFramebufferUse(framebuffer);
   scene->activeFramebufferSize = shovelerVector2(framebuffer->width, framebuffer->height);
 
@@ -114,7 +188,11 @@ int shovelerSceneRenderFrame(
   glClearDepth(1.0f);
   glClear(GL_DEPTH_BUFFER_BIT);
   rendered += shovelerSceneRenderPass(
-      scene, camera, NULL, createRenderPassOptions(scene, RENDER_MODE_OCCLUDED), renderState);
+      scene,
+      camera,
+      NULL,
+      createRenderPassOptions(scene, SHOVELER_SCENE_RENDER_PASS_TYPE_OCCLUDED),
+      renderState);
 
   glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
   glClear(GL_COLOR_BUFFER_BIT);
@@ -128,18 +206,72 @@ int shovelerSceneRenderFrame(
         scene,
         camera,
         framebuffer,
-        createRenderPassOptions(scene, RENDER_MODE_ADDITIVE_LIGHT),
+        createRenderPassOptions(scene, SHOVELER_SCENE_RENDER_PASS_TYPE_ADDITIVE_LIGHT),
         renderState);
   }
 
   rendered += shovelerSceneRenderPass(
-      scene, camera, NULL, createRenderPassOptions(scene, RENDER_MODE_EMITTERS), renderState);
+      scene,
+      camera,
+      NULL,
+      createRenderPassOptions(scene, SHOVELER_SCENE_RENDER_PASS_TYPE_EMITTERS),
+      renderState);
   rendered += shovelerSceneRenderPass(
-      scene, camera, NULL, createRenderPassOptions(scene, RENDER_MODE_SCREENSPACE), renderState);
+      scene,
+      camera,
+      NULL,
+      createRenderPassOptions(scene, SHOVELER_SCENE_RENDER_PASS_TYPE_SCREENSPACE),
+      renderState);
+
+  scene->renderQueuesValid = false;
 
   return rendered;
 }
 
+void shovelerSceneResetRenderPassStats(ShovelerScene* scene) {
+  for (int i = 0; i < SHOVELER_SCENE_RENDER_PASS_TYPE_NUM; i++) {
+    ShovelerSceneRenderPassStats* stats = &scene->renderPassStats[i];
+    stats->numPasses = 0;
+    stats->numSkippedPasses = 0;
+    stats->numModels = 0;
+    stats->numCulledModels = 0;
+    stats->numProgramChanges = 0;
+    stats->numSkippedProgramChanges = 0;
+    stats->numTextureBinds = 0;
+    stats->numSkippedTextureBinds = 0;
+  }
+}
+
+void shovelerSceneLogRenderPassStats(ShovelerScene* scene, int numFrames) {
+  static const char* passNames[SHOVELER_SCENE_RENDER_PASS_TYPE_NUM] = {
+      "occluded", "shadow map", "additive light", "emitters", "screenspace"};
+
+  if (numFrames < 1) {
+    numFrames = 1;
+  }
+
+  for (int i = 0; i < SHOVELER_SCENE_RENDER_PASS_TYPE_NUM; i++) {
+    const ShovelerSceneRenderPassStats* stats = &scene->renderPassStats[i];
+    if (stats->numPasses == 0 && stats->numSkippedPasses == 0) {
+      continue;
+    }
+
+    shovelerLogInfo(
+        "Scene %p %s passes per frame: %.1f passes (%.1f skipped), %.1f models (%.1f culled), "
+        "%.1f program changes (%.1f avoided), %.1f texture binds (%.1f avoided).",
+        scene,
+        passNames[i],
+        (double) stats->numPasses / numFrames,
+        (double) stats->numSkippedPasses / numFrames,
+        (double) stats->numModels / numFrames,
+        (double) stats->numCulledModels / numFrames,
+        (double) stats->numProgramChanges / numFrames,
+        (double) stats->numSkippedProgramChanges / numFrames,
+        (double) stats->numTextureBinds / numFrames,
+        (double) stats->numSkippedTextureBinds / numFrames);
+  }
+}
+
 ShovelerShader* shovelerSceneGenerateShader(
     ShovelerScene* scene,
     ShovelerCamera* camera,
@@ -199,6 +331,11 @@ ShovelerShader* shovelerSceneGenerateShader(
 void shovelerSceneFree(ShovelerScene* scene) {
   shovelerShaderCacheInvalidateScene(scene->shaderCache, scene);
 
+  for (int i = 0; i < SHOVELER_SCENE_NUM_RENDER_QUEUES; i++) {
+    g_array_free(scene->renderQueues[i], /* freeSegment */ true);
+  }
+  g_hash_table_destroy(scene->cameraVisibilities);
+  shovelerBoundingVolumesFree(scene->boundingVolumes);
   g_hash_table_destroy(scene->models);
   g_hash_table_destroy(scene->lights);
   shovelerMaterialFree(scene->depthMaterial);
@@ -207,8 +344,9 @@ void shovelerSceneFree(ShovelerScene* scene) {
 }
 
 ShovelerSceneRenderPassOptions createRenderPassOptions(
-    ShovelerScene* scene, RenderMode renderMode) {
+    ShovelerScene* scene, ShovelerSceneRenderPassType type) {
   ShovelerSceneRenderPassOptions options;
+  options.type = type;
   options.overrideMaterial = NULL;
   options.emitters = false;
   options.screenspace = false;
@@ -219,41 +357,143 @@ ShovelerSceneRenderPassOptions createRenderPassOptions(
   options.renderState.depthTest = true;
   options.renderState.depthFunction = GL_LESS;
   options.renderState.depthMask = GL_TRUE;
-  switch (renderMode) {
-  case RENDER_MODE_OCCLUDED:
+  switch (type) {
+  case SHOVELER_SCENE_RENDER_PASS_TYPE_OCCLUDED:
     options.renderState.blendSourceFactor = GL_ONE;
     options.renderState.blendDestinationFactor = GL_ZERO;
     options.renderState.depthFunction = GL_LESS;
     options.renderState.depthMask = GL_TRUE;
     break;
-  case RENDER_MODE_EMITTERS:
+  case SHOVELER_SCENE_RENDER_PASS_TYPE_EMITTERS:
     options.emitters = true;
     options.renderState.blendSourceFactor = GL_SRC_ALPHA;
     options.renderState.blendDestinationFactor = GL_ONE_MINUS_SRC_ALPHA;
     options.renderState.depthFunction = GL_LESS;
     options.renderState.depthMask = GL_TRUE;
     break;
-  case RENDER_MODE_SCREENSPACE:
+  case SHOVELER_SCENE_RENDER_PASS_TYPE_SCREENSPACE:
     options.screenspace = true;
     options.renderState.blendSourceFactor = GL_ONE;
     options.renderState.blendDestinationFactor = GL_ZERO;
     options.renderState.depthTest = false;
     break;
-  case RENDER_MODE_ADDITIVE_LIGHT:
+  case SHOVELER_SCENE_RENDER_PASS_TYPE_ADDITIVE_LIGHT:
     options.renderState.blendSourceFactor = GL_ONE;
     options.renderState.blendDestinationFactor = GL_ONE;
     options.renderState.depthFunction = GL_EQUAL;
     options.renderState.depthMask = GL_TRUE;
     break;
+  default:
+    break;
   }
 
-  if (renderMode == RENDER_MODE_OCCLUDED) {
+  if (type == SHOVELER_SCENE_RENDER_PASS_TYPE_OCCLUDED) {
     options.overrideMaterial = scene->depthMaterial;
   }
 
   return options;
 }
 
+static void updateRenderQueues(ShovelerScene* scene, ShovelerCamera* camera) {
+  for (int i = 0; i < SHOVELER_SCENE_NUM_RENDER_QUEUES; i++) {
+    g_array_set_size(scene->renderQueues[i], 0);
+  }
+
+  GHashTableIter iter;
+  ShovelerModel* model;
+  g_hash_table_iter_init(&iter, scene->models);
+  while (g_hash_table_iter_next(&iter, (gpointer*) &model, NULL)) {
+    if (!model->visible) {
+      continue;
+    }
+
+    ShovelerSceneRenderQueueEntry entry;
+    entry.key = computeSortKey(model, camera);
+    entry.model = model;
+    g_array_append_val(
+        scene->renderQueues[getRenderQueueIndex(model->emitter, model->material->screenspace)],
+        entry);
+  }
+
+  // Bounding boxes are laid out in queue order, so that passes read the visibility bits in order.
+  shovelerBoundingVolumesClear(scene->boundingVolumes);
+  g_hash_table_iter_init(&iter, scene->cameraVisibilities);
+  while (g_hash_table_iter_next(&iter, NULL, NULL)) {
+    g_hash_table_iter_remove(&iter);
+  }
+  for (int i = 0; i < SHOVELER_SCENE_NUM_RENDER_QUEUES; i++) {
+    GArray* renderQueue = scene->renderQueues[i];
+    g_array_sort(renderQueue, compareRenderQueueEntries);
+
+    for (guint j = 0; j < renderQueue->len; j++) {
+      ShovelerSceneRenderQueueEntry* entry =
+          &g_array_index(renderQueue, ShovelerSceneRenderQueueEntry, j);
+      entry->boundingVolumeIndex =
+          shovelerBoundingVolumesAdd(scene->boundingVolumes, entry->model->boundingBox);
+    }
+  }
+}
+
+static const guint32* getVisibility(ShovelerScene* scene, ShovelerCamera* camera) {
+  GArray* visibility = g_hash_table_lookup(scene->cameraVisibilities, camera);
+  if (visibility == NULL) {
+    visibility = g_array_new(/* zeroTerminated */ false, /* clear */ false, sizeof(guint32));
+    g_array_set_size(
+        visibility, shovelerBoundingVolumesGetNumVisibilityWords(scene->boundingVolumes->size));
+    shovelerBoundingVolumesCullFrustum(
+        scene->boundingVolumes, &camera->frustum, (guint32*) visibility->data);
+    g_hash_table_insert(scene->cameraVisibilities, camera, visibility);
+  }
+
+  return (const guint32*) visibility->data;
+}
+
+static guint64 computeSortKey(ShovelerModel* model, ShovelerCamera* camera) {
+  ShovelerMaterial* material = model->material;
+
+  guint64 depth = 0;
+  if (camera != NULL) {
+    float dx = model->translation.values[0] - camera->position.values[0];
+    float dy = model->translation.values[1] - camera->position.values[1];
+    float dz = model->translation.values[2] - camera->position.values[2];
+    float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+    // maps [0, inf) monotonically to [0, 1) so that no distance overflows the key bits
+    depth = (guint64) (distance / (distance + 1.0f) * 0xFFFF);
+  }
+
+  guint64 program = material->program & 0xFFFF;
+  guint64 materialBits = ((guintptr) material >> 4) & 0xFFFF;
+  guint64 texture = shovelerUniformMapGetTexture(material->uniforms) & 0xFFFF;
+  return program << 48 | materialBits << 32 | texture << 16 | depth;
+}
+
+static gint compareRenderQueueEntries(gconstpointer firstPointer, gconstpointer secondPointer) {
+  const ShovelerSceneRenderQueueEntry* first = firstPointer;
+  const ShovelerSceneRenderQueueEntry* second = secondPointer;
+
+  if (first->key != second->key) {
+    return first->key < second->key ? -1 : 1;
+  }
+
+  // break ties by address to keep the order stable across frames
+  if (first->model != second->model) {
+    return (guintptr) first->model < (guintptr) second->model ? -1 : 1;
+  }
+
+  return 0;
+}
+
+static int getRenderQueueIndex(bool emitter, bool screenspace) {
+  return (emitter ? 1 : 0) | (screenspace ? 2 : 0);
+}
+
+/** Finalizer of the splitmix64 generator, spreading every input bit over the whole output. */
+static guint64 mixHash(guint64 value) {
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+  return value ^ (value >> 31);
+}
+
 static void freeLight(void* lightPointer) {
   ShovelerLight* light = lightPointer;
   shovelerLightFree(light);
@@ -263,3 +503,8 @@ static void freeModel(void* modelPointer) {
   ShovelerModel* model = modelPointer;
   shovelerModelFree(model);
 }
+
+static void freeVisibility(void* visibilityPointer) {
+  GArray* visibility = visibilityPointer;
+  g_array_free(visibility, /* freeSegment */ true);
+}
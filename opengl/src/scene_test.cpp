@@ -0,0 +1,332 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "shoveler/camera/perspective.h"
+#include "shoveler/canvas.h"
+#include "shoveler/constants.h"
+#include "shoveler/drawable/quad.h"
+#include "shoveler/framebuffer.h"
+#include "shoveler/image.h"
+#include "shoveler/light/point.h"
+#include "shoveler/material.h"
+#include "shoveler/material/canvas.h"
+#include "shoveler/material/color.h"
+#include "shoveler/material/tile_sprite.h"
+#include "shoveler/model.h"
+#include "shoveler/opengl_recorder.h"
+#include "shoveler/render_state.h"
+#include "shoveler/scene.h"
+#include "shoveler/shader_cache.h"
+#include "shoveler/sprite.h"
+#include "shoveler/sprite/tile.h"
+#include "shoveler/tileset.h"
+}
+
+static const int numModelsPerMaterial = 3;
+
+class ShovelerSceneTest : public ::testing::Test {
+public:
+  virtual void SetUp() {
+    recorder = shovelerOpenGLRecorderCreate();
+    shaderCache = shovelerShaderCacheCreate();
+    scene = shovelerSceneCreate(shaderCache);
+
+    ShovelerReferenceFrame frame = shovelerReferenceFrame(
+        shovelerVector3(0.0f, 0.0f, 5.0f),
+        shovelerVector3(0.0f, 0.0f, -1.0f),
+        shovelerVector3(0.0f, 1.0f, 0.0f));
+    ShovelerProjectionPerspective projection = {
+        /* fieldOfViewY */ SHOVELER_PI / 2.0f,
+        /* aspectRatio */ 1.0f,
+        /* nearClippingPlane */ 0.01f,
+        /* farClippingPlane */ 100.0f};
+    camera = shovelerCameraPerspectiveCreate(shaderCache, &frame, &projection);
+    framebuffer = shovelerFramebufferCreate(
+        64, 64, /* samples */ 1, /* channels */ 4, /* bitsPerChannel */ 8);
+    quad = shovelerDrawableQuadCreate();
+
+    renderState.blend = true;
+    renderState.blendSourceFactor = GL_ONE;
+    renderState.blendDestinationFactor = GL_ZERO;
+    renderState.depthTest = true;
+    renderState.depthFunction = GL_LESS;
+    renderState.depthMask = GL_TRUE;
+    shovelerRenderStateReset(&renderState);
+  }
+
+  virtual void TearDown() {
+    shovelerSceneFree(scene);
+    shovelerDrawableFree(quad);
+    for (ShovelerMaterial* material : materials) {
+      shovelerMaterialFree(material);
+    }
+    shovelerFramebufferFree(framebuffer, /* keepTargets */ false);
+    shovelerCameraFree(camera);
+    shovelerShaderCacheFree(shaderCache);
+    shovelerOpenGLRecorderFree(recorder);
+  }
+
+  ShovelerMaterial* createMaterial() {
+    ShovelerMaterial* material = shovelerMaterialColorCreate(
+        shaderCache, /* screenspace */ false, shovelerVector4(1.0f, 1.0f, 1.0f, 1.0f));
+    materials.push_back(material);
+    return material;
+  }
+
+  ShovelerModel* addModel(ShovelerMaterial* material, float z) {
+    ShovelerModel* model = shovelerModelCreate(quad, material);
+    model->translation = shovelerVector3(0.0f, 0.0f, z);
+    shovelerModelUpdateTransformation(model);
+    shovelerSceneAddModel(scene, model);
+    return model;
+  }
+
+  ShovelerOpenGLRecorder* recorder;
+  ShovelerShaderCache* shaderCache;
+  ShovelerScene* scene;
+  ShovelerCamera* camera;
+  ShovelerFramebuffer* framebuffer;
+  ShovelerDrawable* quad;
+  std::vector<ShovelerMaterial*> materials;
+  ShovelerRenderState renderState;
+};
+
+TEST_F(ShovelerSceneTest, renderQueueGroupsMaterials) {
+  ShovelerMaterial* first = createMaterial();
+  ShovelerMaterial* second = createMaterial();
+  for (int i = 0; i < numModelsPerMaterial; i++) {
+    addModel(first, (float) -i);
+    addModel(second, (float) -i);
+  }
+  ShovelerModel* invisible = addModel(first, 0.0f);
+  invisible->visible = false;
+
+  int rendered = shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+  ASSERT_EQ(rendered, 2 * numModelsPerMaterial);
+
+  GArray* renderQueue = scene->renderQueues[0];
+  ASSERT_EQ(renderQueue->len, 2 * numModelsPerMaterial) << "invisible models should be skipped";
+  for (guint i = 1; i < renderQueue->len; i++) {
+    const ShovelerSceneRenderQueueEntry* previous =
+        &g_array_index(renderQueue, ShovelerSceneRenderQueueEntry, i - 1);
+    const ShovelerSceneRenderQueueEntry* current =
+        &g_array_index(renderQueue, ShovelerSceneRenderQueueEntry, i);
+    ASSERT_LE(previous->key, current->key);
+    if (previous->model->material == current->model->material) {
+      ASSERT_GE(previous->model->translation.values[2], current->model->translation.values[2])
+          << "models sharing a material should be sorted front to back";
+    }
+  }
+  ShovelerModel* firstModel = g_array_index(renderQueue, ShovelerSceneRenderQueueEntry, 0).model;
+  ShovelerModel* middleModel =
+      g_array_index(renderQueue, ShovelerSceneRenderQueueEntry, numModelsPerMaterial).model;
+  ASSERT_NE(firstModel->material, middleModel->material) << "models should be grouped by material";
+
+  const ShovelerSceneRenderPassStats* occluded =
+      &scene->renderPassStats[SHOVELER_SCENE_RENDER_PASS_TYPE_OCCLUDED];
+  ASSERT_EQ(occluded->numPasses, 1);
+  ASSERT_EQ(occluded->numModels, 2 * numModelsPerMaterial);
+  ASSERT_EQ(occluded->numProgramChanges, 1) << "depth override material should be used once";
+  ASSERT_EQ(occluded->numSkippedProgramChanges, 2 * numModelsPerMaterial - 1);
+}
+
+TEST_F(ShovelerSceneTest, lightPassesSkipStateChanges) {
+  ShovelerMaterial* first = createMaterial();
+  ShovelerMaterial* second = createMaterial();
+  for (int i = 0; i < numModelsPerMaterial; i++) {
+    addModel(first, (float) -i);
+    addModel(second, (float) -i);
+  }
+  ShovelerLight* light = shovelerLightPointCreate(
+      shaderCache,
+      shovelerVector3(0.0f, 0.0f, 2.0f),
+      /* width */ 64,
+      /* height */ 64,
+      /* samples */ 1,
+      /* ambientFactor */ 0.0f,
+      /* exponentialFactor */ 80.0f,
+      shovelerVector3(1.0f, 1.0f, 1.0f));
+  shovelerSceneAddLight(scene, light);
+
+  shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+  shovelerSceneResetRenderPassStats(scene);
+  // moving the light makes it render its shadow maps again
+  shovelerLightUpdatePosition(light, shovelerVector3(0.0f, 0.0f, 2.0f));
+  shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+
+  const ShovelerSceneRenderPassStats* additive =
+      &scene->renderPassStats[SHOVELER_SCENE_RENDER_PASS_TYPE_ADDITIVE_LIGHT];
+  ASSERT_GT(additive->numPasses, 0);
+  ASSERT_EQ(additive->numModels, additive->numPasses * 2 * numModelsPerMaterial);
+  ASSERT_EQ(additive->numProgramChanges, additive->numPasses * 2)
+      << "each material program should only be used once per pass";
+  ASSERT_EQ(
+      additive->numSkippedProgramChanges, additive->numPasses * 2 * (numModelsPerMaterial - 1));
+  ASSERT_GT(additive->numSkippedTextureBinds, 0)
+      << "shadow maps bound by the first model should not be bound again";
+
+  const ShovelerSceneRenderPassStats* shadowMap =
+      &scene->renderPassStats[SHOVELER_SCENE_RENDER_PASS_TYPE_SHADOW_MAP];
+  ASSERT_EQ(shadowMap->numPasses, additive->numPasses);
+  ASSERT_EQ(shadowMap->numSkippedPasses, 0);
+  ASSERT_EQ(
+      shadowMap->numModels + shadowMap->numCulledModels,
+      shadowMap->numPasses * 2 * numModelsPerMaterial);
+  ASSERT_GT(shadowMap->numCulledModels, 0)
+      << "shadow maps facing away from the models should cull them";
+  ASSERT_LE(shadowMap->numProgramChanges, shadowMap->numPasses);
+}
+
+TEST_F(ShovelerSceneTest, cullOutsideFrustum) {
+  ShovelerMaterial* material = createMaterial();
+  ShovelerModel* inside = addModel(material, 0.0f);
+  ShovelerModel* behind = addModel(material, 10.0f);
+  ShovelerModel* moved = addModel(material, 0.0f);
+  moved->translation = shovelerVector3(50.0f, 0.0f, 0.0f);
+  shovelerModelUpdateTransformation(moved);
+
+  int rendered = shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+  ASSERT_EQ(rendered, 1);
+  ASSERT_EQ(scene->renderPassStats[SHOVELER_SCENE_RENDER_PASS_TYPE_OCCLUDED].numCulledModels, 2);
+  ASSERT_GT(inside->boundingBox.max.values[0], inside->boundingBox.min.values[0]);
+  ASSERT_EQ(behind->boundingBox.min.values[2], 10.0f);
+
+  moved->translation = shovelerVector3(0.5f, 0.0f, -1.0f);
+  shovelerModelUpdateTransformation(moved);
+  rendered = shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+  ASSERT_EQ(rendered, 2) << "bounding box should follow the model transformation";
+}
+
+TEST_F(ShovelerSceneTest, skipUnchangedShadowMaps) {
+  ShovelerMaterial* material = createMaterial();
+  ShovelerModel* lit = addModel(material, 0.0f);
+  ShovelerModel* distant = addModel(material, 0.0f);
+  distant->translation = shovelerVector3(500.0f, 0.0f, 0.0f);
+  shovelerModelUpdateTransformation(distant);
+  ShovelerLight* light = shovelerLightPointCreate(
+      shaderCache,
+      shovelerVector3(0.0f, 0.0f, 2.0f),
+      /* width */ 64,
+      /* height */ 64,
+      /* samples */ 1,
+      /* ambientFactor */ 0.0f,
+      /* exponentialFactor */ 80.0f,
+      shovelerVector3(1.0f, 1.0f, 1.0f));
+  shovelerSceneAddLight(scene, light);
+  const ShovelerSceneRenderPassStats* additive =
+      &scene->renderPassStats[SHOVELER_SCENE_RENDER_PASS_TYPE_ADDITIVE_LIGHT];
+  const ShovelerSceneRenderPassStats* shadowMap =
+      &scene->renderPassStats[SHOVELER_SCENE_RENDER_PASS_TYPE_SHADOW_MAP];
+
+  shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+  ASSERT_GT(shadowMap->numPasses, 0);
+  ASSERT_EQ(shadowMap->numSkippedPasses, 0);
+
+  shovelerSceneResetRenderPassStats(scene);
+  shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+  ASSERT_GT(additive->numPasses, 0);
+  ASSERT_EQ(shadowMap->numPasses, 0) << "nothing changed since the last frame";
+  ASSERT_EQ(shadowMap->numSkippedPasses, additive->numPasses);
+
+  shovelerSceneResetRenderPassStats(scene);
+  distant->translation = shovelerVector3(600.0f, 0.0f, 0.0f);
+  shovelerModelUpdateTransformation(distant);
+  shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+  ASSERT_EQ(shadowMap->numPasses, 0) << "models outside of the light frustums don't matter";
+
+  shovelerSceneResetRenderPassStats(scene);
+  lit->translation = shovelerVector3(0.0f, 0.0f, -1.0f);
+  shovelerModelUpdateTransformation(lit);
+  shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+  ASSERT_GT(shadowMap->numPasses, 0) << "faces seeing the moved model should render again";
+  ASSERT_LT(shadowMap->numPasses, additive->numPasses) << "other faces should be skipped";
+  ASSERT_EQ(shadowMap->numPasses + shadowMap->numSkippedPasses, additive->numPasses);
+
+  shovelerSceneResetRenderPassStats(scene);
+  lit->castsShadow = false;
+  shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+  ASSERT_GT(shadowMap->numPasses, 0) << "removing a shadow caster should render again";
+
+  shovelerSceneResetRenderPassStats(scene);
+  shovelerLightUpdatePosition(light, shovelerVector3(0.0f, 0.0f, 3.0f));
+  shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+  ASSERT_EQ(shadowMap->numPasses, additive->numPasses) << "moving the light renders all faces";
+  ASSERT_EQ(shadowMap->numSkippedPasses, 0);
+}
+
+TEST_F(ShovelerSceneTest, litCanvasMatchesDepthPrePass) {
+  static const char* quadTransform = "vec4 worldPosition4 = model * vec4(position, 1.0);";
+  static const char* projectedPosition = "gl_Position = projection * view * worldPosition4;";
+  static const int numSprites = 3;
+
+  ShovelerImage* image = shovelerImageCreate(4, 4, 4);
+  shovelerImageClear(image);
+  ShovelerTileset* tileset = shovelerTilesetCreate(image, 4, 4, 1);
+  shovelerImageFree(image);
+  ShovelerCanvas* canvas = shovelerCanvasCreate(/* numLayers */ 1);
+  ShovelerMaterial* tileSpriteMaterial =
+      shovelerMaterialTileSpriteCreate(shaderCache, /* screenspace */ false);
+  std::vector<ShovelerSprite*> sprites;
+  for (int i = 0; i < numSprites; i++) {
+    ShovelerSprite* sprite = shovelerSpriteTileCreate(tileSpriteMaterial, tileset, 0, i);
+    shovelerSpriteUpdatePosition(sprite, shovelerVector2((float) i - 1.0f, 0.0f));
+    shovelerSpriteUpdateSize(sprite, shovelerVector2(1.0f, 1.0f));
+    shovelerCanvasAddSprite(canvas, /* layerId */ 0, sprite);
+    sprites.push_back(sprite);
+  }
+  ShovelerMaterial* canvasMaterial =
+      shovelerMaterialCanvasCreate(shaderCache, /* screenspace */ false);
+  materials.push_back(canvasMaterial);
+  shovelerMaterialCanvasSetActive(canvasMaterial, canvas);
+  shovelerMaterialCanvasSetActiveRegion(
+      canvasMaterial, shovelerVector2(0.0f, 0.0f), shovelerVector2(4.0f, 4.0f));
+  addModel(canvasMaterial, 0.0f);
+  ShovelerLight* light = shovelerLightPointCreate(
+      shaderCache,
+      shovelerVector3(0.0f, 0.0f, 2.0f),
+      /* width */ 64,
+      /* height */ 64,
+      /* samples */ 1,
+      /* ambientFactor */ 0.0f,
+      /* exponentialFactor */ 80.0f,
+      shovelerVector3(1.0f, 1.0f, 1.0f));
+  shovelerSceneAddLight(scene, light);
+
+  recorder->recordDraws = true;
+  shovelerSceneRenderFrame(scene, camera, framebuffer, &renderState);
+
+  const char* depthSource =
+      shovelerOpenGLRecorderGetProgramSource(recorder, scene->depthMaterial->program);
+  ASSERT_NE(depthSource, nullptr);
+  ASSERT_NE(strstr(depthSource, quadTransform), nullptr);
+  ASSERT_NE(strstr(depthSource, projectedPosition), nullptr);
+
+  // Lit passes only keep fragments whose depth equals the pre-pass depth, which is only
+  // guaranteed if the sprites are drawn with the exact vertices and transform of the canvas quad.
+  int numEqualDepthBatches = 0;
+  for (guint i = 0; i < recorder->draws->len; i++) {
+    const ShovelerOpenGLRecorderDraw* draw =
+        &g_array_index(recorder->draws, ShovelerOpenGLRecorderDraw, i);
+    if (!draw->depthTest || draw->depthFunction != GL_EQUAL || draw->numInstances == 1) {
+      continue;
+    }
+
+    ASSERT_EQ(draw->numInstances, numSprites);
+    const char* source = shovelerOpenGLRecorderGetProgramSource(recorder, draw->program);
+    ASSERT_NE(source, nullptr);
+    ASSERT_NE(strstr(source, quadTransform), nullptr) << source;
+    ASSERT_NE(strstr(source, projectedPosition), nullptr) << source;
+    numEqualDepthBatches++;
+  }
+  ASSERT_GT(numEqualDepthBatches, 0) << "sprites should have been drawn in additive light passes";
+
+  for (ShovelerSprite* sprite : sprites) {
+    shovelerSpriteFree(sprite);
+  }
+  shovelerMaterialFree(tileSpriteMaterial);
+  shovelerCanvasFree(canvas);
+  shovelerTilesetFree(tileset);
+}
@@ -3,7 +3,7 @@
 #include <assert.h> // assert
 #include <stdbool.h> // bool
 #include <stdlib.h> // malloc, free
-#include <string.h> // strdup, memcmp
+#include <string.h> // memcmp
 
 #include "shoveler/camera.h"
 #include "shoveler/hash.h"
@@ -11,9 +11,10 @@
 #include "shoveler/log.h"
 #include "shoveler/opengl.h"
 #include "shoveler/scene.h"
+#include "shoveler/shader_cache.h"
 #include "shoveler/uniform_attachment.h"
 
-static void freeAttachment(void* attachmentPointer);
+static guint findAttachment(ShovelerShader* shader, GLint location);
 
 guint shovelerShaderKeyHash(gconstpointer shaderKeyPointer) {
   ShovelerShaderKey* shaderKey = (ShovelerShaderKey*) shaderKeyPointer;
@@ -43,7 +44,8 @@ ShovelerShader* shovelerShaderCreate(ShovelerShaderKey shaderKey, ShovelerMateri
   ShovelerShader* shader = malloc(sizeof(ShovelerShader));
   shader->key = shaderKey;
   shader->material = material;
-  shader->attachments = g_hash_table_new_full(g_str_hash, g_str_equal, free, freeAttachment);
+  shader->attachments = g_array_new(
+      /* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerUniformAttachment));
   return shader;
 }
 
@@ -60,7 +62,12 @@ bool shovelerShaderAttachUniform(
         shader->material->program,
         name);
     return false;
-  } else if (g_hash_table_contains(shader->attachments, name)) {
+  }
+
+  // a uniform's location is unique within its program, so it identifies the attachment as well
+  guint index = findAttachment(shader, location);
+  if (index < shader->attachments->len &&
+      g_array_index(shader->attachments, ShovelerUniformAttachment, index).location == location) {
     shovelerLogTrace(
         "Material %p with shader program %d already contains an attachment for '%s', skipping.",
         shader->material,
@@ -69,8 +76,13 @@ bool shovelerShaderAttachUniform(
     return false;
   }
 
-  ShovelerUniformAttachment* uniformAttachment = shovelerUniformAttachmentCreate(uniform, location);
-  g_hash_table_insert(shader->attachments, strdup(name), uniformAttachment);
+  ShovelerUniformAttachment uniformAttachment = shovelerUniformAttachment(uniform, location);
+  g_array_insert_val(shader->attachments, index, uniformAttachment);
+
+  if (shader->material->shaderCache != NULL) {
+    shovelerShaderCacheGetUploadedUniformValues(
+        shader->material->shaderCache, shader->material->program, location + 1);
+  }
 
   shovelerLogTrace(
       "Attached uniform '%s' to material %p with shader program %d.",
@@ -81,16 +93,37 @@ bool shovelerShaderAttachUniform(
 }
 
 bool shovelerShaderUse(ShovelerShader* shader) {
-  glUseProgram(shader->material->program);
+  GLuint program = shader->material->program;
+  GArray* uploadedValues = NULL;
+  ShovelerUniformTextureBindings* textureBindings = NULL;
+  ShovelerUniformUploadStats* stats = NULL;
+  ShovelerShaderCache* shaderCache = shader->material->shaderCache;
+  if (shaderCache != NULL) {
+    if (shaderCache->usedProgram == program) {
+      shaderCache->numSkippedProgramChanges++;
+    } else {
+      glUseProgram(program);
+      shaderCache->usedProgram = program;
+      shaderCache->numProgramChanges++;
+    }
+
+    uploadedValues = shovelerShaderCacheGetUploadedUniformValues(
+        shaderCache, program, /* numLocations */ 0);
+    textureBindings = &shaderCache->textureBindings;
+    stats = &shaderCache->uniformUploadStats;
+  } else {
+    glUseProgram(program);
+  }
 
   GLuint textureUnitIndexCounter = 0;
-  GHashTableIter iter;
-  char* name;
-  ShovelerUniformAttachment* uniformAttachment;
-  g_hash_table_iter_init(&iter, shader->attachments);
-  while (g_hash_table_iter_next(&iter, (gpointer*) &name, (gpointer*) &uniformAttachment)) {
-    if (!shovelerUniformAttachmentUse(uniformAttachment, &textureUnitIndexCounter)) {
-      shovelerLogError("Failed to use uniform attachment '%s' when trying to use shader", name);
+  for (guint i = 0; i < shader->attachments->len; i++) {
+    const ShovelerUniformAttachment* uniformAttachment =
+        &g_array_index(shader->attachments, ShovelerUniformAttachment, i);
+    if (!shovelerUniformAttachmentUse(
+            uniformAttachment, &textureUnitIndexCounter, uploadedValues, textureBindings, stats)) {
+      shovelerLogError(
+          "Failed to use uniform attachment at location %d when trying to use shader",
+          uniformAttachment->location);
       return false;
     }
   }
@@ -98,10 +131,21 @@ bool shovelerShaderUse(ShovelerShader* shader) {
 }
 
 void shovelerShaderFree(ShovelerShader* shader) {
-  g_hash_table_destroy(shader->attachments);
+  g_array_free(shader->attachments, true);
   free(shader);
 }
 
-static void freeAttachment(void* attachmentPointer) {
-  shovelerUniformAttachmentFree(attachmentPointer);
+/** Returns the index of the first attachment with a location not less than the given one. */
+static guint findAttachment(ShovelerShader* shader, GLint location) {
+  guint min = 0;
+  guint max = shader->attachments->len;
+  while (min < max) {
+    guint mid = min + (max - min) / 2;
+    if (g_array_index(shader->attachments, ShovelerUniformAttachment, mid).location < location) {
+      min = mid + 1;
+    } else {
+      max = mid;
+    }
+  }
+  return min;
 }
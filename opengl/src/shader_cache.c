@@ -9,8 +9,25 @@
 #include "shoveler/model.h"
 #include "shoveler/shader.h"
 
+#define INITIAL_NUM_SLOTS 64
+
+static void insertEntry(ShovelerShaderCache* cache, ShovelerShaderCacheEntry* entry);
+static void invalidateObject(
+    ShovelerShaderCache* cache, ShovelerShaderCacheKeyComponent component, void* object);
+static void sweepInvalidatedObject(ShovelerShaderCache* cache);
+static guint findSlot(ShovelerShaderCache* cache, const ShovelerShaderKey* shaderKey, guint hash);
+static guint findEntrySlot(ShovelerShaderCache* cache, ShovelerShaderCacheEntry* entry);
+static void removeSlot(ShovelerShaderCache* cache, guint slotIndex);
+static bool isStale(ShovelerShaderCache* cache, ShovelerShaderCacheEntry* entry);
+static void resize(ShovelerShaderCache* cache, guint numSlots);
+static void* getKeyComponent(
+    const ShovelerShaderKey* shaderKey, ShovelerShaderCacheKeyComponent component);
+static guint hashKey(const ShovelerShaderKey* shaderKey);
 static void freeShader(void* shaderPointer);
-static void freeSet(void* setPointer);
+static void freeUploadedUniformValues(void* uploadedUniformValuesPointer);
+
+/** Marks slots whose entry was removed, so that probes continue past them. */
+static ShovelerShaderCacheEntry tombstone;
 
 ShovelerShaderCache* shovelerShaderCacheCreate() {
   return shovelerShaderCacheCreateWithCustomFree(freeShader);
@@ -19,211 +36,394 @@ ShovelerShaderCache* shovelerShaderCacheCreate() {
 ShovelerShaderCache* shovelerShaderCacheCreateWithCustomFree(
     ShovelerShaderCacheFreeShaderFunction* freeShader) {
   ShovelerShaderCache* cache = malloc(sizeof(ShovelerShaderCache));
-  cache->shaders =
-      g_hash_table_new_full(shovelerShaderKeyHash, shovelerShaderKeyEqual, NULL, freeShader);
-  cache->sceneShaderKeys = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, freeSet);
-  cache->cameraShaderKeys = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, freeSet);
-  cache->lightShaderKeys = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, freeSet);
-  cache->modelShaderKeys = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, freeSet);
-  cache->materialShaderKeys = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, freeSet);
-  cache->userDataShaderKeys = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, freeSet);
+  cache->freeShader = freeShader;
+  cache->slots = NULL;
+  cache->numSlots = 0;
+  cache->numEntries = 0;
+  cache->numTombstones = 0;
+  for (int i = 0; i < SHOVELER_SHADER_CACHE_KEY_COMPONENT_NUM; i++) {
+    cache->objects[i] = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free);
+  }
+  cache->firstInvalidated = NULL;
+  cache->lastInvalidated = NULL;
+  cache->programUploadedUniformValues =
+      g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, freeUploadedUniformValues);
+  cache->uniformUploadStats.numUploads = 0;
+  cache->uniformUploadStats.numSkippedUploads = 0;
+  cache->uniformUploadStats.numTextureBinds = 0;
+  cache->uniformUploadStats.numSkippedTextureBinds = 0;
+  cache->usedProgram = 0;
+  cache->numProgramChanges = 0;
+  cache->numSkippedProgramChanges = 0;
+  shovelerUniformTextureBindingsReset(&cache->textureBindings);
+
+  resize(cache, INITIAL_NUM_SLOTS);
 
   return cache;
 }
 
 void shovelerShaderCacheInsert(ShovelerShaderCache* cache, ShovelerShader* shader) {
-  g_hash_table_insert(cache->shaders, &shader->key, shader);
+  sweepInvalidatedObject(cache);
 
-  GHashTable* sceneKeys = g_hash_table_lookup(cache->sceneShaderKeys, shader->key.scene);
-  if (sceneKeys == NULL) {
-    sceneKeys = g_hash_table_new(shovelerShaderKeyHash, shovelerShaderKeyEqual);
-    g_hash_table_insert(cache->sceneShaderKeys, shader->key.scene, sceneKeys);
+  guint hash = hashKey(&shader->key);
+  guint slotIndex = findSlot(cache, &shader->key, hash);
+  if (slotIndex != cache->numSlots) {
+    // replace the shader previously cached for the key
+    removeSlot(cache, slotIndex);
   }
-  g_hash_table_add(sceneKeys, &shader->key);
 
-  GHashTable* cameraKeys = g_hash_table_lookup(cache->cameraShaderKeys, shader->key.camera);
-  if (cameraKeys == NULL) {
-    cameraKeys = g_hash_table_new(shovelerShaderKeyHash, shovelerShaderKeyEqual);
-    g_hash_table_insert(cache->cameraShaderKeys, shader->key.camera, cameraKeys);
+  // keep a quarter of the slots empty, so that probe sequences stay short, and rehash to half full
+  // so that the table stays small enough to be cached
+  if (4 * (cache->numEntries + cache->numTombstones + 1) > 3 * cache->numSlots) {
+    guint numSlots = cache->numSlots;
+    while (2 * (cache->numEntries + 1) > numSlots) {
+      numSlots *= 2;
+    }
+    resize(cache, numSlots);
   }
-  g_hash_table_add(cameraKeys, &shader->key);
 
-  GHashTable* lightKeys = g_hash_table_lookup(cache->lightShaderKeys, shader->key.light);
-  if (lightKeys == NULL) {
-    lightKeys = g_hash_table_new(shovelerShaderKeyHash, shovelerShaderKeyEqual);
-    g_hash_table_insert(cache->lightShaderKeys, shader->key.light, lightKeys);
+  ShovelerShaderCacheEntry* entry = malloc(sizeof(ShovelerShaderCacheEntry));
+  entry->shader = shader;
+  entry->hash = hash;
+  for (int i = 0; i < SHOVELER_SHADER_CACHE_KEY_COMPONENT_NUM; i++) {
+    entry->objects[i] = NULL;
+    entry->generations[i] = 0;
+    entry->next[i] = NULL;
+    entry->previous[i] = NULL;
+
+    void* object = getKeyComponent(&shader->key, i);
+    if (object == NULL) {
+      continue;
+    }
+
+    ShovelerShaderCacheObject* cacheObject = g_hash_table_lookup(cache->objects[i], object);
+    if (cacheObject == NULL) {
+      cacheObject = malloc(sizeof(ShovelerShaderCacheObject));
+      cacheObject->object = object;
+      cacheObject->component = i;
+      cacheObject->generation = 0;
+      cacheObject->entries = NULL;
+      cacheObject->invalidated = false;
+      cacheObject->nextInvalidated = NULL;
+      g_hash_table_insert(cache->objects[i], object, cacheObject);
+    }
+
+    entry->objects[i] = cacheObject;
+    entry->generations[i] = cacheObject->generation;
+    entry->next[i] = cacheObject->entries;
+    if (cacheObject->entries != NULL) {
+      cacheObject->entries->previous[i] = entry;
+    }
+    cacheObject->entries = entry;
   }
-  g_hash_table_add(lightKeys, &shader->key);
 
-  GHashTable* modelKeys = g_hash_table_lookup(cache->modelShaderKeys, shader->key.model);
-  if (modelKeys == NULL) {
-    modelKeys = g_hash_table_new(shovelerShaderKeyHash, shovelerShaderKeyEqual);
-    g_hash_table_insert(cache->modelShaderKeys, shader->key.model, modelKeys);
+  insertEntry(cache, entry);
+}
+
+bool shovelerShaderCacheRemove(ShovelerShaderCache* cache, const ShovelerShaderKey* shaderKey) {
+  guint slotIndex = findSlot(cache, shaderKey, hashKey(shaderKey));
+  if (slotIndex == cache->numSlots) {
+    return false;
   }
-  g_hash_table_add(modelKeys, &shader->key);
 
-  GHashTable* materialKeys = g_hash_table_lookup(cache->materialShaderKeys, shader->key.material);
-  if (materialKeys == NULL) {
-    materialKeys = g_hash_table_new(shovelerShaderKeyHash, shovelerShaderKeyEqual);
-    g_hash_table_insert(cache->materialShaderKeys, shader->key.material, materialKeys);
+  bool stale = isStale(cache, cache->slots[slotIndex].entry);
+  removeSlot(cache, slotIndex);
+  return !stale;
+}
+
+ShovelerShader* shovelerShaderCacheLookup(
+    ShovelerShaderCache* cache, const ShovelerShaderKey* shaderKey) {
+  sweepInvalidatedObject(cache);
+
+  guint slotIndex = findSlot(cache, shaderKey, hashKey(shaderKey));
+  if (slotIndex == cache->numSlots) {
+    return NULL;
   }
-  g_hash_table_add(materialKeys, &shader->key);
 
-  GHashTable* userDataKeys = g_hash_table_lookup(cache->userDataShaderKeys, shader->key.userData);
-  if (userDataKeys == NULL) {
-    userDataKeys = g_hash_table_new(shovelerShaderKeyHash, shovelerShaderKeyEqual);
-    g_hash_table_insert(cache->userDataShaderKeys, shader->key.userData, userDataKeys);
+  const ShovelerShaderCacheSlot* slot = &cache->slots[slotIndex];
+  if (isStale(cache, slot->entry)) {
+    removeSlot(cache, slotIndex);
+    return NULL;
   }
-  g_hash_table_add(userDataKeys, &shader->key);
+
+  return slot->shader;
 }
 
-bool shovelerShaderCacheRemove(ShovelerShaderCache* cache, const ShovelerShaderKey* shaderKey) {
-  ShovelerShader* shader = g_hash_table_lookup(cache->shaders, shaderKey);
-  if (shader == NULL) {
-    return false;
+void shovelerShaderCacheInvalidateScene(ShovelerShaderCache* cache, ShovelerScene* scene) {
+  invalidateObject(cache, SHOVELER_SHADER_CACHE_KEY_COMPONENT_SCENE, scene);
+}
+
+void shovelerShaderCacheInvalidateCamera(ShovelerShaderCache* cache, ShovelerCamera* camera) {
+  invalidateObject(cache, SHOVELER_SHADER_CACHE_KEY_COMPONENT_CAMERA, camera);
+}
+
+void shovelerShaderCacheInvalidateLight(ShovelerShaderCache* cache, ShovelerLight* light) {
+  invalidateObject(cache, SHOVELER_SHADER_CACHE_KEY_COMPONENT_LIGHT, light);
+}
+
+void shovelerShaderCacheInvalidateModel(ShovelerShaderCache* cache, ShovelerModel* model) {
+  invalidateObject(cache, SHOVELER_SHADER_CACHE_KEY_COMPONENT_MODEL, model);
+}
+
+void shovelerShaderCacheInvalidateMaterial(ShovelerShaderCache* cache, ShovelerMaterial* material) {
+  invalidateObject(cache, SHOVELER_SHADER_CACHE_KEY_COMPONENT_MATERIAL, material);
+}
+
+void shovelerShaderCacheInvalidateUserData(ShovelerShaderCache* cache, void* userData) {
+  invalidateObject(cache, SHOVELER_SHADER_CACHE_KEY_COMPONENT_USER_DATA, userData);
+}
+
+GArray* shovelerShaderCacheGetUploadedUniformValues(
+    ShovelerShaderCache* cache, GLuint program, GLint numLocations) {
+  GArray* uploadedValues =
+      g_hash_table_lookup(cache->programUploadedUniformValues, GUINT_TO_POINTER(program));
+  if (uploadedValues == NULL) {
+    uploadedValues = g_array_new(
+        /* zeroTerminated */ false, /* clear */ true, sizeof(ShovelerUniformUploadedValue));
+    g_hash_table_insert(
+        cache->programUploadedUniformValues, GUINT_TO_POINTER(program), uploadedValues);
   }
 
-  GHashTable* sceneKeys = g_hash_table_lookup(cache->sceneShaderKeys, shaderKey->scene);
-  assert(sceneKeys != NULL);
-  bool sceneKeyRemoved = g_hash_table_remove(sceneKeys, shaderKey);
-  assert(sceneKeyRemoved);
+  // new entries are cleared and thus invalid
+  if (numLocations > 0 && (guint) numLocations > uploadedValues->len) {
+    g_array_set_size(uploadedValues, (guint) numLocations);
+  }
 
-  GHashTable* cameraKeys = g_hash_table_lookup(cache->cameraShaderKeys, shaderKey->camera);
-  assert(cameraKeys != NULL);
-  bool cameraKeyRemoved = g_hash_table_remove(cameraKeys, shaderKey);
-  assert(cameraKeyRemoved);
+  return uploadedValues;
+}
 
-  GHashTable* lightKeys = g_hash_table_lookup(cache->lightShaderKeys, shaderKey->light);
-  assert(lightKeys != NULL);
-  bool lightKeyRemoved = g_hash_table_remove(lightKeys, shaderKey);
-  assert(lightKeyRemoved);
+void shovelerShaderCacheInvalidateProgram(ShovelerShaderCache* cache, GLuint program) {
+  g_hash_table_remove(cache->programUploadedUniformValues, GUINT_TO_POINTER(program));
 
-  GHashTable* modelKeys = g_hash_table_lookup(cache->modelShaderKeys, shaderKey->model);
-  assert(modelKeys != NULL);
-  bool modelKeyRemoved = g_hash_table_remove(modelKeys, shaderKey);
-  assert(modelKeyRemoved);
+  if (cache->usedProgram == program) {
+    cache->usedProgram = 0;
+  }
+}
 
-  GHashTable* materialKeys = g_hash_table_lookup(cache->materialShaderKeys, shaderKey->material);
-  assert(materialKeys != NULL);
-  bool materialKeyRemoved = g_hash_table_remove(materialKeys, shaderKey);
-  assert(materialKeyRemoved);
+void shovelerShaderCacheFree(ShovelerShaderCache* cache) {
+  for (guint i = 0; i < cache->numSlots; i++) {
+    ShovelerShaderCacheEntry* entry = cache->slots[i].entry;
+    if (entry == NULL || entry == &tombstone) {
+      continue;
+    }
 
-  GHashTable* userDataKeys = g_hash_table_lookup(cache->userDataShaderKeys, shaderKey->userData);
-  assert(userDataKeys != NULL);
-  bool userDataKeyRemoved = g_hash_table_remove(userDataKeys, shaderKey);
-  assert(userDataKeyRemoved);
+    if (cache->freeShader != NULL) {
+      cache->freeShader(entry->shader);
+    }
+    free(entry);
+  }
+  free(cache->slots);
 
-  // make sure we remove the shader itself last, because the key tables use the shader key from the
-  // stored shader
-  g_hash_table_remove(cache->shaders, shaderKey);
-  return true;
+  g_hash_table_destroy(cache->programUploadedUniformValues);
+  for (int i = 0; i < SHOVELER_SHADER_CACHE_KEY_COMPONENT_NUM; i++) {
+    g_hash_table_destroy(cache->objects[i]);
+  }
+  free(cache);
 }
 
-ShovelerShader* shovelerShaderCacheLookup(
-    ShovelerShaderCache* cache, const ShovelerShaderKey* shaderKey) {
-  return g_hash_table_lookup(cache->shaders, shaderKey);
+static void insertEntry(ShovelerShaderCache* cache, ShovelerShaderCacheEntry* entry) {
+  guint mask = cache->numSlots - 1;
+  for (guint i = entry->hash & mask;; i = (i + 1) & mask) {
+    ShovelerShaderCacheSlot* slot = &cache->slots[i];
+    if (slot->entry == NULL || slot->entry == &tombstone) {
+      if (slot->entry == &tombstone) {
+        cache->numTombstones--;
+      }
+
+      slot->hash = entry->hash;
+      slot->shader = entry->shader;
+      slot->entry = entry;
+      cache->numEntries++;
+      return;
+    }
+  }
 }
 
-void shovelerShaderCacheInvalidateScene(
-    ShovelerShaderCache* cache, struct ShovelerSceneStruct* scene) {
-  GHashTable* sceneKeys = g_hash_table_lookup(cache->sceneShaderKeys, scene);
-  if (sceneKeys != NULL) {
-    // get keys list because the keys set will be modified while we iterate over the list
-    GList* sceneKeysList = g_hash_table_get_keys(sceneKeys);
-    for (GList* iter = sceneKeysList; iter != NULL; iter = iter->next) {
-      const ShovelerShaderKey* shaderKey = iter->data;
-      bool removed = shovelerShaderCacheRemove(cache, shaderKey);
-      assert(removed);
+static void invalidateObject(
+    ShovelerShaderCache* cache, ShovelerShaderCacheKeyComponent component, void* object) {
+  ShovelerShaderCacheObject* cacheObject = g_hash_table_lookup(cache->objects[component], object);
+  if (cacheObject == NULL) {
+    return;
+  }
+
+  cacheObject->generation++;
+  if (!cacheObject->invalidated) {
+    cacheObject->invalidated = true;
+    cacheObject->nextInvalidated = NULL;
+    if (cache->lastInvalidated == NULL) {
+      cache->firstInvalidated = cacheObject;
+    } else {
+      cache->lastInvalidated->nextInvalidated = cacheObject;
     }
-    g_list_free(sceneKeysList);
-    g_hash_table_remove(cache->sceneShaderKeys, scene);
+    cache->lastInvalidated = cacheObject;
   }
 }
 
-void shovelerShaderCacheInvalidateCamera(ShovelerShaderCache* cache, ShovelerCamera* camera) {
-  GHashTable* cameraKeys = g_hash_table_lookup(cache->cameraShaderKeys, camera);
-  if (cameraKeys != NULL) {
-    // get keys list because the keys set will be modified while we iterate over the list
-    GList* cameraKeysList = g_hash_table_get_keys(cameraKeys);
-    for (GList* iter = cameraKeysList; iter != NULL; iter = iter->next) {
-      const ShovelerShaderKey* shaderKey = iter->data;
-      bool removed = shovelerShaderCacheRemove(cache, shaderKey);
-      assert(removed);
+/**
+ * Removes the stale entries of the first queued invalidated object. Entries inserted after its
+ * invalidation are kept, since objects can be invalidated and used again before they are swept.
+ */
+static void sweepInvalidatedObject(ShovelerShaderCache* cache) {
+  ShovelerShaderCacheObject* cacheObject = cache->firstInvalidated;
+  if (cacheObject == NULL) {
+    return;
+  }
+
+  cache->firstInvalidated = cacheObject->nextInvalidated;
+  if (cache->firstInvalidated == NULL) {
+    cache->lastInvalidated = NULL;
+  }
+
+  // the object stays marked as invalidated while sweeping, so that it isn't freed once its last
+  // entry is removed
+  ShovelerShaderCacheKeyComponent component = cacheObject->component;
+  ShovelerShaderCacheEntry* entry = cacheObject->entries;
+  while (entry != NULL) {
+    ShovelerShaderCacheEntry* next = entry->next[component];
+    if (entry->generations[component] != cacheObject->generation) {
+      removeSlot(cache, findEntrySlot(cache, entry));
     }
-    g_list_free(cameraKeysList);
-    g_hash_table_remove(cache->cameraShaderKeys, camera);
+    entry = next;
+  }
+
+  cacheObject->invalidated = false;
+  cacheObject->nextInvalidated = NULL;
+  if (cacheObject->entries == NULL) {
+    g_hash_table_remove(cache->objects[component], cacheObject->object);
   }
 }
 
-void shovelerShaderCacheInvalidateLight(ShovelerShaderCache* cache, ShovelerLight* light) {
-  GHashTable* lightKeys = g_hash_table_lookup(cache->lightShaderKeys, light);
-  if (lightKeys != NULL) {
-    // get keys list because the keys set will be modified while we iterate over the list
-    GList* lightKeysList = g_hash_table_get_keys(lightKeys);
-    for (GList* iter = lightKeysList; iter != NULL; iter = iter->next) {
-      const ShovelerShaderKey* shaderKey = iter->data;
-      bool removed = shovelerShaderCacheRemove(cache, shaderKey);
-      assert(removed);
+/** Returns the index of the slot holding the key, or the number of slots if there is none. */
+static guint findSlot(ShovelerShaderCache* cache, const ShovelerShaderKey* shaderKey, guint hash) {
+  guint mask = cache->numSlots - 1;
+  for (guint i = hash & mask;; i = (i + 1) & mask) {
+    const ShovelerShaderCacheSlot* slot = &cache->slots[i];
+    if (slot->entry == NULL) {
+      return cache->numSlots;
+    }
+
+    if (slot->entry != &tombstone && slot->hash == hash &&
+        shovelerShaderKeyEqual(&slot->shader->key, shaderKey)) {
+      return i;
     }
-    g_list_free(lightKeysList);
-    g_hash_table_remove(cache->lightShaderKeys, light);
   }
 }
 
-void shovelerShaderCacheInvalidateModel(ShovelerShaderCache* cache, ShovelerModel* model) {
-  GHashTable* modelKeys = g_hash_table_lookup(cache->modelShaderKeys, model);
-  if (modelKeys != NULL) {
-    // get keys list because the keys set will be modified while we iterate over the list
-    GList* modelKeysList = g_hash_table_get_keys(modelKeys);
-    for (GList* iter = modelKeysList; iter != NULL; iter = iter->next) {
-      const ShovelerShaderKey* shaderKey = iter->data;
-      bool removed = shovelerShaderCacheRemove(cache, shaderKey);
-      assert(removed);
+static guint findEntrySlot(ShovelerShaderCache* cache, ShovelerShaderCacheEntry* entry) {
+  guint mask = cache->numSlots - 1;
+  for (guint i = entry->hash & mask;; i = (i + 1) & mask) {
+    assert(cache->slots[i].entry != NULL);
+    if (cache->slots[i].entry == entry) {
+      return i;
     }
-    g_list_free(modelKeysList);
-    g_hash_table_remove(cache->modelShaderKeys, model);
   }
 }
 
-void shovelerShaderCacheInvalidateMaterial(ShovelerShaderCache* cache, ShovelerMaterial* material) {
-  GHashTable* materialKeys = g_hash_table_lookup(cache->materialShaderKeys, material);
-  if (materialKeys != NULL) {
-    // get keys list because the keys set will be modified while we iterate over the list
-    GList* materialKeysList = g_hash_table_get_keys(materialKeys);
-    for (GList* iter = materialKeysList; iter != NULL; iter = iter->next) {
-      const ShovelerShaderKey* shaderKey = iter->data;
-      bool removed = shovelerShaderCacheRemove(cache, shaderKey);
-      assert(removed);
+/** Removes an entry from its slot and all object lists, freeing objects without other entries. */
+static void removeSlot(ShovelerShaderCache* cache, guint slotIndex) {
+  ShovelerShaderCacheEntry* entry = cache->slots[slotIndex].entry;
+  cache->slots[slotIndex].shader = NULL;
+  cache->slots[slotIndex].entry = &tombstone;
+  cache->numEntries--;
+  cache->numTombstones++;
+
+  for (int i = 0; i < SHOVELER_SHADER_CACHE_KEY_COMPONENT_NUM; i++) {
+    ShovelerShaderCacheObject* cacheObject = entry->objects[i];
+    if (cacheObject == NULL) {
+      continue;
+    }
+
+    if (entry->previous[i] == NULL) {
+      cacheObject->entries = entry->next[i];
+    } else {
+      entry->previous[i]->next[i] = entry->next[i];
+    }
+    if (entry->next[i] != NULL) {
+      entry->next[i]->previous[i] = entry->previous[i];
+    }
+
+    // invalidated objects are freed when they are swept, since they are still queued until then
+    if (cacheObject->entries == NULL && !cacheObject->invalidated) {
+      g_hash_table_remove(cache->objects[i], cacheObject->object);
     }
-    g_list_free(materialKeysList);
-    g_hash_table_remove(cache->materialShaderKeys, material);
   }
+
+  if (cache->freeShader != NULL) {
+    cache->freeShader(entry->shader);
+  }
+  free(entry);
 }
 
-void shovelerShaderCacheInvalidateUserData(ShovelerShaderCache* cache, void* userData) {
-  GHashTable* userDataKeys = g_hash_table_lookup(cache->userDataShaderKeys, userData);
-  if (userDataKeys != NULL) {
-    // get keys list because the keys set will be modified while we iterate over the list
-    GList* userDataKeysList = g_hash_table_get_keys(userDataKeys);
-    for (GList* iter = userDataKeysList; iter != NULL; iter = iter->next) {
-      const ShovelerShaderKey* shaderKey = iter->data;
-      bool removed = shovelerShaderCacheRemove(cache, shaderKey);
-      assert(removed);
+/** Checks whether one of the entry's objects was invalidated since the entry was inserted. */
+static bool isStale(ShovelerShaderCache* cache, ShovelerShaderCacheEntry* entry) {
+  // stale entries are removed when their object is swept, so there are none if nothing is queued
+  if (cache->firstInvalidated == NULL) {
+    return false;
+  }
+
+  for (int i = 0; i < SHOVELER_SHADER_CACHE_KEY_COMPONENT_NUM; i++) {
+    if (entry->objects[i] != NULL && entry->objects[i]->generation != entry->generations[i]) {
+      return true;
     }
-    g_list_free(userDataKeysList);
-    g_hash_table_remove(cache->userDataShaderKeys, userData);
   }
+
+  return false;
 }
 
-void shovelerShaderCacheFree(ShovelerShaderCache* cache) {
-  g_hash_table_destroy(cache->userDataShaderKeys);
-  g_hash_table_destroy(cache->materialShaderKeys);
-  g_hash_table_destroy(cache->modelShaderKeys);
-  g_hash_table_destroy(cache->lightShaderKeys);
-  g_hash_table_destroy(cache->cameraShaderKeys);
-  g_hash_table_destroy(cache->sceneShaderKeys);
-  g_hash_table_destroy(cache->shaders);
-  free(cache);
+static void resize(ShovelerShaderCache* cache, guint numSlots) {
+  ShovelerShaderCacheSlot* oldSlots = cache->slots;
+  guint oldNumSlots = cache->numSlots;
+
+  cache->slots = malloc(numSlots * sizeof(ShovelerShaderCacheSlot));
+  cache->numSlots = numSlots;
+  cache->numEntries = 0;
+  cache->numTombstones = 0;
+  for (guint i = 0; i < numSlots; i++) {
+    cache->slots[i].hash = 0;
+    cache->slots[i].shader = NULL;
+    cache->slots[i].entry = NULL;
+  }
+
+  for (guint i = 0; i < oldNumSlots; i++) {
+    ShovelerShaderCacheEntry* entry = oldSlots[i].entry;
+    if (entry != NULL && entry != &tombstone) {
+      insertEntry(cache, entry);
+    }
+  }
+  free(oldSlots);
+}
+
+static void* getKeyComponent(
+    const ShovelerShaderKey* shaderKey, ShovelerShaderCacheKeyComponent component) {
+  switch (component) {
+  case SHOVELER_SHADER_CACHE_KEY_COMPONENT_SCENE:
+    return shaderKey->scene;
+  case SHOVELER_SHADER_CACHE_KEY_COMPONENT_CAMERA:
+    return shaderKey->camera;
+  case SHOVELER_SHADER_CACHE_KEY_COMPONENT_LIGHT:
+    return shaderKey->light;
+  case SHOVELER_SHADER_CACHE_KEY_COMPONENT_MODEL:
+    return shaderKey->model;
+  case SHOVELER_SHADER_CACHE_KEY_COMPONENT_MATERIAL:
+    return shaderKey->material;
+  case SHOVELER_SHADER_CACHE_KEY_COMPONENT_USER_DATA:
+    return shaderKey->userData;
+  default:
+    return NULL;
+  }
+}
+
+/**
+ * Hashes the key's pointers by multiplying with the golden ratio, so that all of their bits affect
+ * the high bits of the result, which are folded into the low bits indexing the table's slots. This
+ * avoids the per pointer calls of shovelerShaderKeyHash, which would otherwise dominate lookups.
+ */
+static guint hashKey(const ShovelerShaderKey* shaderKey) {
+  guint64 hash = 0;
+  for (int i = 0; i < SHOVELER_SHADER_CACHE_KEY_COMPONENT_NUM; i++) {
+    hash = (hash ^ (guintptr) getKeyComponent(shaderKey, i)) * 0x9e3779b97f4a7c15ull;
+  }
+  return (guint) (hash ^ (hash >> 32));
 }
 
 static void freeShader(void* shaderPointer) {
@@ -231,7 +431,7 @@ static void freeShader(void* shaderPointer) {
   shovelerShaderFree(shader);
 }
 
-static void freeSet(void* setPointer) {
-  GHashTable* set = setPointer;
-  g_hash_table_destroy(set);
+static void freeUploadedUniformValues(void* uploadedUniformValuesPointer) {
+  GArray* uploadedValues = uploadedUniformValuesPointer;
+  g_array_free(uploadedValues, true);
 }
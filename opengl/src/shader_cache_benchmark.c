@@ -0,0 +1,93 @@
+#include <shoveler/log.h>
+#include <shoveler/shader.h>
+#include <shoveler/shader_cache.h>
+#include <stdlib.h> // EXIT_SUCCESS, malloc, free
+
+#define NUM_MODELS 5000
+#define NUM_LIGHTS 8
+#define NUM_MATERIALS 4
+#define NUM_LOOKUPS_PER_ROUND 10
+#define NUM_ROUNDS 20
+
+int main(int argc, char* argv[]) {
+  shovelerLogInit("shoveler/", SHOVELER_LOG_LEVEL_INFO_UP, stdout);
+
+  // The cache only compares key objects by address, so any distinct pointers will do.
+  static char scene;
+  static char camera;
+  static char lights[NUM_LIGHTS];
+  static char models[NUM_MODELS];
+  static char materials[NUM_MATERIALS];
+
+  // Each model has a shader for the occluded pass without a light and one per light.
+  int numShaders = NUM_MODELS * (NUM_LIGHTS + 1);
+  ShovelerShader* shaders = malloc(numShaders * sizeof(ShovelerShader));
+  for (int i = 0; i < numShaders; i++) {
+    int modelIndex = i / (NUM_LIGHTS + 1);
+    int lightIndex = i % (NUM_LIGHTS + 1);
+    ShovelerShaderKey key = {
+        (ShovelerScene*) &scene,
+        (ShovelerCamera*) &camera,
+        lightIndex == 0 ? NULL : (ShovelerLight*) &lights[lightIndex - 1],
+        (ShovelerModel*) &models[modelIndex],
+        (ShovelerMaterial*) &materials[modelIndex % NUM_MATERIALS],
+        NULL};
+    shaders[i].key = key;
+  }
+
+  // The shaders are owned by the benchmark, so that they can be inserted again after invalidation.
+  ShovelerShaderCache* cache = shovelerShaderCacheCreateWithCustomFree(NULL);
+
+  gint64 insertTimeUs = 0;
+  gint64 lookupTimeUs = 0;
+  gint64 invalidateTimeUs = 0;
+  int numMisses = 0;
+  for (int round = 0; round < NUM_ROUNDS; round++) {
+    gint64 startTime = g_get_monotonic_time();
+    for (int i = 0; i < numShaders; i++) {
+      shovelerShaderCacheInsert(cache, &shaders[i]);
+    }
+    gint64 insertedTime = g_get_monotonic_time();
+
+    for (int lookup = 0; lookup < NUM_LOOKUPS_PER_ROUND; lookup++) {
+      for (int i = 0; i < numShaders; i++) {
+        if (shovelerShaderCacheLookup(cache, &shaders[i].key) != &shaders[i]) {
+          numMisses++;
+        }
+      }
+    }
+    gint64 lookedUpTime = g_get_monotonic_time();
+
+    // Every round replaces all models, as when a client reloads its world.
+    for (int i = 0; i < NUM_MODELS; i++) {
+      shovelerShaderCacheInvalidateModel(cache, (ShovelerModel*) &models[i]);
+    }
+    gint64 invalidatedTime = g_get_monotonic_time();
+
+    insertTimeUs += insertedTime - startTime;
+    lookupTimeUs += lookedUpTime - insertedTime;
+    invalidateTimeUs += invalidatedTime - lookedUpTime;
+  }
+
+  gint64 numInserts = (gint64) NUM_ROUNDS * numShaders;
+  gint64 numLookups = numInserts * NUM_LOOKUPS_PER_ROUND;
+  gint64 numInvalidations = (gint64) NUM_ROUNDS * NUM_MODELS;
+  shovelerLogInfo(
+      "Churned %d shaders of %d models for %d rounds in %.3fms per round (%d lookup misses).",
+      numShaders,
+      NUM_MODELS,
+      NUM_ROUNDS,
+      (double) (insertTimeUs + lookupTimeUs + invalidateTimeUs) / NUM_ROUNDS / 1000.0,
+      numMisses);
+  shovelerLogInfo(
+      "Per operation: %.1fns per insert, %.1fns per lookup, %.1fns per model invalidation.",
+      (double) insertTimeUs * 1000.0 / numInserts,
+      (double) lookupTimeUs * 1000.0 / numLookups,
+      (double) invalidateTimeUs * 1000.0 / numInvalidations);
+
+  shovelerShaderCacheFree(cache);
+  free(shaders);
+  shovelerLogTerminate();
+
+  return EXIT_SUCCESS;
+}
@@ -11,6 +11,10 @@ extern "C" {
 #include "shoveler/shader_cache.h"
 }
 
+static int numFreedShaders = 0;
+
+static void countFreedShader(void* shaderPointer) { numFreedShaders++; }
+
 class ShovelerShaderCacheTest : public ::testing::Test {
 public:
   virtual void SetUp() {
@@ -169,3 +173,40 @@ TEST_F(ShovelerShaderCacheTest, invalidateUserData) {
   ShovelerShader* lookup3 = shovelerShaderCacheLookup(cache, &shaderKey3);
   ASSERT_TRUE(lookup3 == NULL);
 }
+
+TEST_F(ShovelerShaderCacheTest, insertAfterInvalidate) {
+  ShovelerShaderKey shaderKey3 = {&scene2, NULL, NULL, &model, NULL, NULL};
+  ShovelerShader shader3;
+  shader3.key = shaderKey3;
+
+  shovelerShaderCacheInsert(cache, &shader);
+  shovelerShaderCacheInvalidateModel(cache, &model);
+  shovelerShaderCacheInsert(cache, &shader3);
+
+  ShovelerShader* lookup = shovelerShaderCacheLookup(cache, &shaderKey);
+  ASSERT_TRUE(lookup == NULL);
+  ShovelerShader* lookup3 = shovelerShaderCacheLookup(cache, &shaderKey3);
+  ASSERT_EQ(lookup3, &shader3) << "shaders inserted after invalidation should be kept";
+
+  shovelerShaderCacheInsert(cache, &shader);
+  ShovelerShader* lookup4 = shovelerShaderCacheLookup(cache, &shaderKey);
+  ASSERT_EQ(lookup4, &shader) << "invalidated keys can be inserted again";
+}
+
+TEST_F(ShovelerShaderCacheTest, invalidatedShadersAreFreed) {
+  ShovelerShaderCache* countingCache = shovelerShaderCacheCreateWithCustomFree(countFreedShader);
+  numFreedShaders = 0;
+
+  shovelerShaderCacheInsert(countingCache, &shader);
+  shovelerShaderCacheInsert(countingCache, &shader2);
+  shovelerShaderCacheInvalidateLight(countingCache, &light);
+  ASSERT_EQ(countingCache->numEntries, 2) << "invalidation should only mark the shader stale";
+
+  ShovelerShader* lookup2 = shovelerShaderCacheLookup(countingCache, &shaderKey2);
+  ASSERT_EQ(lookup2, &shader2);
+  ASSERT_EQ(countingCache->numEntries, 1) << "lookups should remove stale shaders";
+  ASSERT_EQ(numFreedShaders, 1);
+
+  shovelerShaderCacheFree(countingCache);
+  ASSERT_EQ(numFreedShaders, 2);
+}
@@ -61,6 +61,17 @@ GLuint shovelerShaderProgramLink(
   glBindAttribLocation(program, SHOVELER_SHADER_PROGRAM_ATTRIBUTE_POSITION, "position");
   glBindAttribLocation(program, SHOVELER_SHADER_PROGRAM_ATTRIBUTE_NORMAL, "normal");
   glBindAttribLocation(program, SHOVELER_SHADER_PROGRAM_ATTRIBUTE_UV, "uv");
+  glBindAttribLocation(
+      program, SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_POSITION, "spritePosition");
+  glBindAttribLocation(program, SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_SIZE, "spriteSize");
+  glBindAttribLocation(program, SHOVELER_SHADER_PROGRAM_ATTRIBUTE_SPRITE_TILE, "spriteTile");
+  glBindAttribLocation(program, SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_CORNER, "glyphCorner");
+  glBindAttribLocation(program, SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_SIZE, "glyphSize");
+  glBindAttribLocation(program, SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_COLOR, "glyphColor");
+  glBindAttribLocation(
+      program, SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_ATLAS_REGION, "glyphAtlasRegion");
+  glBindAttribLocation(
+      program, SHOVELER_SHADER_PROGRAM_ATTRIBUTE_GLYPH_ATLAS_IS_ROTATED, "glyphAtlasIsRotated");
 
   glLinkProgram(program);
 
@@ -0,0 +1,84 @@
+#include "shoveler/shader_program/sprite_instance_vertex.h"
+
+#include <glib.h>
+
+#include "shoveler/shader_program.h"
+
+// Draws one quad per sprite instance, with the sprite's data passed as per-instance attributes
+// instead of uniforms. In screenspace, each quad only covers the sprite's part of the canvas region.
+// Projected canvases are lit in additive passes testing depth for equality with the depth pre-pass
+// of the canvas quad, so there each quad covers the whole region with the canvas quad's exact
+// vertex transform, and fragment shaders have to clear fragments whose spriteUv is outside [0, 1].
+static const char* vertexShaderSourceHeader =
+    "#version 400\n"
+    "\n"
+    "uniform mat4 model;\n"
+    "uniform mat4 modelNormal;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "uniform mat4 lightView;\n"
+    "uniform mat4 lightProjection;\n"
+    "uniform vec2 regionPosition;\n"
+    "uniform vec2 regionSize;\n"
+    "\n"
+    "in vec3 position;\n"
+    "in vec3 normal;\n"
+    "in vec2 uv;\n"
+    "in vec2 spritePosition;\n"
+    "in vec2 spriteSize;\n"
+    "in ivec2 spriteTile;\n"
+    "\n"
+    "out vec3 worldPosition;\n"
+    "out vec3 worldNormal;\n"
+    "out vec2 worldUv;\n"
+    "out vec4 lightFrustumPosition4;\n"
+    "out vec2 spriteUv;\n"
+    "flat out ivec2 fragmentTile;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "	vec2 regionCorner = regionPosition - 0.5 * regionSize;\n"
+    "	vec2 spriteCorner = spritePosition - 0.5 * spriteSize;\n";
+
+static const char* vertexShaderSourceProjectedQuad =
+    "	vec4 worldPosition4 = model * vec4(position, 1.0);\n"
+    "	worldUv = uv;\n"
+    "	spriteUv = (regionCorner + uv * regionSize - spriteCorner) / spriteSize;\n";
+
+static const char* vertexShaderSourceScreenspaceQuad =
+    "	vec2 regionUv = (spriteCorner + uv * spriteSize - regionCorner) / regionSize;\n"
+    "	vec4 worldPosition4 = model * vec4(2.0 * regionUv - 1.0, position.z, 1.0);\n"
+    "	worldUv = regionUv;\n"
+    "	spriteUv = uv;\n";
+
+static const char* vertexShaderSourceBody =
+    "	vec4 worldNormal4 = modelNormal * vec4(normal, 1.0);\n"
+    "	worldPosition = worldPosition4.xyz / worldPosition4.w;\n"
+    "	worldNormal = worldNormal4.xyz / worldNormal4.w;\n"
+    "	fragmentTile = spriteTile;\n"
+    ""
+    "	lightFrustumPosition4 = lightProjection * lightView * worldPosition4;\n";
+
+static const char* vertexShaderSourceProjectedFooter =
+    "	gl_Position = projection * view * worldPosition4;\n"
+    "}\n";
+
+static const char* vertexShaderSourceScreenspaceFooter =
+    "	gl_Position = vec4(worldPosition, 1.0);\n"
+    "}\n";
+
+GLuint shovelerShaderProgramSpriteInstanceVertexCreate(bool screenspace) {
+  GString* vertexShaderSource = g_string_new(vertexShaderSourceHeader);
+  g_string_append(
+      vertexShaderSource,
+      screenspace ? vertexShaderSourceScreenspaceQuad : vertexShaderSourceProjectedQuad);
+  g_string_append(vertexShaderSource, vertexShaderSourceBody);
+  g_string_append(
+      vertexShaderSource,
+      screenspace ? vertexShaderSourceScreenspaceFooter : vertexShaderSourceProjectedFooter);
+  GLuint vertexShaderObject =
+      shovelerShaderProgramCompileFromString(vertexShaderSource->str, GL_VERTEX_SHADER);
+  g_string_free(vertexShaderSource, /* freeSegment */ true);
+
+  return vertexShaderObject;
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+
+extern "C" {
+#include "shoveler/material.h"
+#include "shoveler/shader.h"
+#include "shoveler/shader_cache.h"
+#include "shoveler/uniform.h"
+#include "shoveler/uniform_attachment.h"
+}
+
+static GLint APIENTRY getUniformLocation(GLuint program, const GLchar* name);
+static GLenum APIENTRY getError();
+static void APIENTRY useProgram(GLuint program);
+static void APIENTRY uniform1i(GLint location, GLint value);
+static void APIENTRY uniform1f(GLint location, GLfloat value);
+static void APIENTRY uniform3fv(GLint location, GLsizei count, const GLfloat* value);
+
+static std::map<std::string, GLint> uniformLocations;
+static int numUseProgramCalls;
+static int numUniformCalls;
+static std::map<GLint, int> uniformCallsByLocation;
+
+class ShovelerShaderTest : public ::testing::Test {
+public:
+  virtual void SetUp() {
+    glad_glGetUniformLocation = getUniformLocation;
+    glad_glGetError = getError;
+    glad_glUseProgram = useProgram;
+    glad_glUniform1i = uniform1i;
+    glad_glUniform1f = uniform1f;
+    glad_glUniform3fv = uniform3fv;
+
+    uniformLocations = {{"first", 1}, {"second", 2}, {"third", 7}};
+    numUseProgramCalls = 0;
+    numUniformCalls = 0;
+    uniformCallsByLocation.clear();
+
+    shaderCache = shovelerShaderCacheCreate();
+    material = shovelerMaterialCreateUnmanaged(shaderCache, /* screenspace */ false, testProgram);
+  }
+
+  virtual void TearDown() {
+    shovelerMaterialFree(material);
+    shovelerShaderCacheFree(shaderCache);
+
+    glad_glGetUniformLocation = NULL;
+    glad_glGetError = NULL;
+    glad_glUseProgram = NULL;
+    glad_glUniform1i = NULL;
+    glad_glUniform1f = NULL;
+    glad_glUniform3fv = NULL;
+  }
+
+  ShovelerShader* createShader(void* userData) {
+    ShovelerShaderKey shaderKey = {NULL, NULL, NULL, NULL, material, userData};
+    return shovelerShaderCreate(shaderKey, material);
+  }
+
+  static const GLuint testProgram = 42;
+
+  ShovelerShaderCache* shaderCache;
+  ShovelerMaterial* material;
+};
+
+TEST_F(ShovelerShaderTest, attachmentsSortedByLocation) {
+  ShovelerUniform* first = shovelerUniformCreateInt(1);
+  ShovelerUniform* second = shovelerUniformCreateFloat(2.0f);
+  ShovelerUniform* third = shovelerUniformCreateBool(true);
+  ShovelerShader* shader = createShader(NULL);
+
+  ASSERT_TRUE(shovelerShaderAttachUniform(shader, "third", third));
+  ASSERT_TRUE(shovelerShaderAttachUniform(shader, "first", first));
+  ASSERT_TRUE(shovelerShaderAttachUniform(shader, "second", second));
+  ASSERT_FALSE(shovelerShaderAttachUniform(shader, "first", second))
+      << "attaching a uniform name twice should fail";
+  ASSERT_FALSE(shovelerShaderAttachUniform(shader, "missing", second))
+      << "attaching a uniform not in the program should fail";
+
+  ASSERT_EQ(shader->attachments->len, 3);
+  ASSERT_EQ(g_array_index(shader->attachments, ShovelerUniformAttachment, 0).location, 1);
+  ASSERT_EQ(g_array_index(shader->attachments, ShovelerUniformAttachment, 1).location, 2);
+  ASSERT_EQ(g_array_index(shader->attachments, ShovelerUniformAttachment, 2).location, 7);
+  ASSERT_EQ(g_array_index(shader->attachments, ShovelerUniformAttachment, 0).uniform, first);
+
+  shovelerShaderFree(shader);
+  shovelerUniformFree(third);
+  shovelerUniformFree(second);
+  shovelerUniformFree(first);
+}
+
+TEST_F(ShovelerShaderTest, skipUnchangedUniforms) {
+  int intValue = 1;
+  ShovelerVector3 vectorValue = shovelerVector3(1.0f, 2.0f, 3.0f);
+  ShovelerUniform* first = shovelerUniformCreateIntPointer(&intValue);
+  ShovelerUniform* second = shovelerUniformCreateVector3Pointer(&vectorValue);
+  ShovelerUniform* third = shovelerUniformCreateFloat(3.0f);
+  ShovelerShader* shader = createShader(NULL);
+  shovelerShaderAttachUniform(shader, "first", first);
+  shovelerShaderAttachUniform(shader, "second", second);
+  shovelerShaderAttachUniform(shader, "third", third);
+
+  ASSERT_TRUE(shovelerShaderUse(shader));
+  ASSERT_EQ(numUniformCalls, 3) << "first use should upload all uniforms";
+
+  ASSERT_TRUE(shovelerShaderUse(shader));
+  ASSERT_EQ(numUniformCalls, 3) << "unchanged uniforms should not be uploaded again";
+  ASSERT_EQ(shaderCache->uniformUploadStats.numUploads, 3);
+  ASSERT_EQ(shaderCache->uniformUploadStats.numSkippedUploads, 3);
+
+  vectorValue.values[1] = 5.0f;
+  ASSERT_TRUE(shovelerShaderUse(shader));
+  ASSERT_EQ(numUniformCalls, 4) << "changed pointer uniform should be uploaded again";
+  ASSERT_EQ(uniformCallsByLocation[2], 2);
+
+  shovelerShaderFree(shader);
+  shovelerUniformFree(third);
+  shovelerUniformFree(second);
+  shovelerUniformFree(first);
+}
+
+TEST_F(ShovelerShaderTest, sharedProgramLocations) {
+  ShovelerUniform* first = shovelerUniformCreateInt(1);
+  ShovelerUniform* other = shovelerUniformCreateInt(2);
+  ShovelerShader* shader = createShader(NULL);
+  ShovelerShader* otherShader = createShader(&uniformLocations);
+  shovelerShaderAttachUniform(shader, "first", first);
+  shovelerShaderAttachUniform(otherShader, "first", other);
+
+  ASSERT_TRUE(shovelerShaderUse(shader));
+  ASSERT_TRUE(shovelerShaderUse(otherShader));
+  ASSERT_TRUE(shovelerShaderUse(shader));
+  ASSERT_EQ(numUniformCalls, 3)
+      << "shaders sharing a program should reupload values overwritten by the other shader";
+
+  ASSERT_TRUE(shovelerShaderUse(shader));
+  ASSERT_EQ(numUniformCalls, 3);
+
+  shovelerShaderCacheInvalidateProgram(shaderCache, testProgram);
+  ASSERT_TRUE(shovelerShaderUse(shader));
+  ASSERT_EQ(numUniformCalls, 4) << "invalidated program should reupload its uniforms";
+
+  shovelerShaderFree(otherShader);
+  shovelerShaderFree(shader);
+  shovelerUniformFree(other);
+  shovelerUniformFree(first);
+}
+
+TEST_F(ShovelerShaderTest, skipProgramInUse) {
+  ShovelerShader* shader = createShader(NULL);
+  ShovelerShader* otherShader = createShader(&uniformLocations);
+
+  ASSERT_TRUE(shovelerShaderUse(shader));
+  ASSERT_TRUE(shovelerShaderUse(otherShader));
+  ASSERT_EQ(numUseProgramCalls, 1) << "shaders sharing a program should only use it once";
+  ASSERT_EQ(shaderCache->numProgramChanges, 1);
+  ASSERT_EQ(shaderCache->numSkippedProgramChanges, 1);
+
+  shovelerShaderCacheInvalidateProgram(shaderCache, testProgram);
+  ASSERT_TRUE(shovelerShaderUse(shader));
+  ASSERT_EQ(numUseProgramCalls, 2) << "invalidated program should be used again";
+
+  shovelerShaderFree(otherShader);
+  shovelerShaderFree(shader);
+}
+
+static GLint APIENTRY getUniformLocation(GLuint program, const GLchar* name) {
+  auto iter = uniformLocations.find(name);
+  if (iter == uniformLocations.end()) {
+    return -1;
+  }
+  return iter->second;
+}
+
+static GLenum APIENTRY getError() { return GL_NO_ERROR; }
+
+static void APIENTRY useProgram(GLuint program) { numUseProgramCalls++; }
+
+static void APIENTRY uniform1i(GLint location, GLint value) {
+  numUniformCalls++;
+  uniformCallsByLocation[location]++;
+}
+
+static void APIENTRY uniform1f(GLint location, GLfloat value) {
+  numUniformCalls++;
+  uniformCallsByLocation[location]++;
+}
+
+static void APIENTRY uniform3fv(GLint location, GLsizei count, const GLfloat* value) {
+  numUniformCalls++;
+  uniformCallsByLocation[location]++;
+}
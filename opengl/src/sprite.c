@@ -1,9 +1,12 @@
 #include "shoveler/sprite.h"
 
+#include "shoveler/canvas.h"
+
 void shovelerSpriteInit(
     ShovelerSprite* sprite,
     ShovelerMaterial* material,
     ShovelerCollider2IntersectFunction* intersect,
+    ShovelerCollider2SweepFunction* sweep,
     ShovelerSpriteRenderFunction* render,
     ShovelerSpriteFreeFunction* free,
     void* data) {
@@ -13,10 +16,14 @@ void shovelerSpriteInit(
       shovelerVector2LinearCombination(1.0f, sprite->position, -0.5f, sprite->size),
       shovelerVector2LinearCombination(1.0f, sprite->position, 0.5f, sprite->size));
   sprite->collider.intersect = intersect;
+  sprite->collider.sweep = sweep;
   sprite->collider.data = data;
   sprite->enableCollider = true;
+  sprite->canvas = NULL;
   sprite->material = material;
   sprite->render = render;
+  sprite->batch = NULL;
+  sprite->renderBatch = NULL;
   sprite->free = free;
   sprite->data = data;
 }
@@ -26,6 +33,10 @@ void shovelerSpriteUpdatePosition(ShovelerSprite* sprite, ShovelerVector2 positi
   sprite->collider.boundingBox = shovelerBoundingBox2(
       shovelerVector2LinearCombination(1.0f, sprite->position, -0.5f, sprite->size),
       shovelerVector2LinearCombination(1.0f, sprite->position, 0.5f, sprite->size));
+
+  if (sprite->canvas != NULL) {
+    shovelerCanvasUpdateSprite(sprite->canvas, sprite);
+  }
 }
 
 void shovelerSpriteUpdateSize(ShovelerSprite* sprite, ShovelerVector2 size) {
@@ -33,6 +44,10 @@ void shovelerSpriteUpdateSize(ShovelerSprite* sprite, ShovelerVector2 size) {
   sprite->collider.boundingBox = shovelerBoundingBox2(
       shovelerVector2LinearCombination(1.0f, sprite->position, -0.5f, sprite->size),
       shovelerVector2LinearCombination(1.0f, sprite->position, 0.5f, sprite->size));
+
+  if (sprite->canvas != NULL) {
+    shovelerCanvasUpdateSprite(sprite->canvas, sprite);
+  }
 }
 
 void shovelerSpriteSetEnableCollider(ShovelerSprite* sprite, bool enableCollider) {
@@ -27,6 +27,7 @@ ShovelerSprite* shovelerSpriteTextCreate(
       &spriteText->sprite,
       material,
       /* intersect */ NULL,
+      /* sweep */ NULL,
       renderSpriteText,
       freeSpriteText,
       spriteText);
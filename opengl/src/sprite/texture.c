@@ -15,6 +15,21 @@ static bool renderSpriteTexture(
     ShovelerLight* light,
     ShovelerModel* model,
     ShovelerRenderState* renderState);
+static bool batchSpriteTexture(
+    ShovelerSprite* sprite,
+    ShovelerSpriteBatchKey* outputKey,
+    ShovelerSpriteInstance* outputInstance);
+static bool renderSpriteTextureBatch(
+    ShovelerSprite* firstSprite,
+    const ShovelerSpriteInstance* instances,
+    int numInstances,
+    ShovelerVector2 regionPosition,
+    ShovelerVector2 regionSize,
+    ShovelerScene* scene,
+    ShovelerCamera* camera,
+    ShovelerLight* light,
+    ShovelerModel* model,
+    ShovelerRenderState* renderState);
 static void freeSpriteTexture(ShovelerSprite* sprite);
 
 ShovelerSprite* shovelerSpriteTextureCreate(
@@ -24,9 +39,12 @@ ShovelerSprite* shovelerSpriteTextureCreate(
       &spriteTexture->sprite,
       material,
       /* intersect */ NULL,
+      /* sweep */ NULL,
       renderSpriteTexture,
       freeSpriteTexture,
       spriteTexture);
+  spriteTexture->sprite.batch = batchSpriteTexture;
+  spriteTexture->sprite.renderBatch = renderSpriteTextureBatch;
   spriteTexture->texture = texture;
   spriteTexture->sampler = sampler;
 
@@ -52,6 +70,49 @@ static bool renderSpriteTexture(
   return shovelerMaterialRender(sprite->material, scene, camera, light, model, renderState);
 }
 
+static bool batchSpriteTexture(
+    ShovelerSprite* sprite,
+    ShovelerSpriteBatchKey* outputKey,
+    ShovelerSpriteInstance* outputInstance) {
+  ShovelerSpriteTexture* spriteTexture = (ShovelerSpriteTexture*) sprite->data;
+
+  outputKey->material = sprite->material;
+  outputKey->resource = spriteTexture->texture;
+  outputKey->sampler = spriteTexture->sampler;
+  outputInstance->tilesetColumn = 0;
+  outputInstance->tilesetRow = 0;
+
+  return true;
+}
+
+static bool renderSpriteTextureBatch(
+    ShovelerSprite* firstSprite,
+    const ShovelerSpriteInstance* instances,
+    int numInstances,
+    ShovelerVector2 regionPosition,
+    ShovelerVector2 regionSize,
+    ShovelerScene* scene,
+    ShovelerCamera* camera,
+    ShovelerLight* light,
+    ShovelerModel* model,
+    ShovelerRenderState* renderState) {
+  ShovelerSpriteTexture* spriteTexture = (ShovelerSpriteTexture*) firstSprite->data;
+
+  shovelerMaterialTextureSpriteSetActiveRegion(firstSprite->material, regionPosition, regionSize);
+
+  return shovelerMaterialTextureSpriteRenderInstances(
+      firstSprite->material,
+      spriteTexture->texture,
+      spriteTexture->sampler,
+      instances,
+      numInstances,
+      scene,
+      camera,
+      light,
+      model,
+      renderState);
+}
+
 static void freeSpriteTexture(ShovelerSprite* sprite) {
   ShovelerSpriteTexture* spriteTexture = (ShovelerSpriteTexture*) sprite->data;
 
@@ -15,6 +15,21 @@ static bool renderSpriteTile(
     ShovelerLight* light,
     ShovelerModel* model,
     ShovelerRenderState* renderState);
+static bool batchSpriteTile(
+    ShovelerSprite* sprite,
+    ShovelerSpriteBatchKey* outputKey,
+    ShovelerSpriteInstance* outputInstance);
+static bool renderSpriteTileBatch(
+    ShovelerSprite* firstSprite,
+    const ShovelerSpriteInstance* instances,
+    int numInstances,
+    ShovelerVector2 regionPosition,
+    ShovelerVector2 regionSize,
+    ShovelerScene* scene,
+    ShovelerCamera* camera,
+    ShovelerLight* light,
+    ShovelerModel* model,
+    ShovelerRenderState* renderState);
 static void freeSpriteTile(ShovelerSprite* sprite);
 
 ShovelerSprite* shovelerSpriteTileCreate(
@@ -24,9 +39,12 @@ ShovelerSprite* shovelerSpriteTileCreate(
       &spriteTile->sprite,
       material,
       /* intersect */ NULL,
+      /* sweep */ NULL,
       renderSpriteTile,
       freeSpriteTile,
       spriteTile);
+  spriteTile->sprite.batch = batchSpriteTile;
+  spriteTile->sprite.renderBatch = renderSpriteTileBatch;
   spriteTile->tileset = tileset;
   spriteTile->tilesetRow = tilesetRow;
   spriteTile->tilesetColumn = tilesetColumn;
@@ -64,6 +82,48 @@ static bool renderSpriteTile(
   return shovelerMaterialRender(sprite->material, scene, camera, light, model, renderState);
 }
 
+static bool batchSpriteTile(
+    ShovelerSprite* sprite,
+    ShovelerSpriteBatchKey* outputKey,
+    ShovelerSpriteInstance* outputInstance) {
+  ShovelerSpriteTile* spriteTile = (ShovelerSpriteTile*) sprite->data;
+
+  outputKey->material = sprite->material;
+  outputKey->resource = spriteTile->tileset;
+  outputKey->sampler = NULL;
+  outputInstance->tilesetColumn = spriteTile->tilesetColumn;
+  outputInstance->tilesetRow = spriteTile->tilesetRow;
+
+  return true;
+}
+
+static bool renderSpriteTileBatch(
+    ShovelerSprite* firstSprite,
+    const ShovelerSpriteInstance* instances,
+    int numInstances,
+    ShovelerVector2 regionPosition,
+    ShovelerVector2 regionSize,
+    ShovelerScene* scene,
+    ShovelerCamera* camera,
+    ShovelerLight* light,
+    ShovelerModel* model,
+    ShovelerRenderState* renderState) {
+  ShovelerSpriteTile* spriteTile = (ShovelerSpriteTile*) firstSprite->data;
+
+  shovelerMaterialTileSpriteSetActiveRegion(firstSprite->material, regionPosition, regionSize);
+
+  return shovelerMaterialTileSpriteRenderInstances(
+      firstSprite->material,
+      spriteTile->tileset,
+      instances,
+      numInstances,
+      scene,
+      camera,
+      light,
+      model,
+      renderState);
+}
+
 static void freeSpriteTile(ShovelerSprite* sprite) {
   ShovelerSpriteTile* spriteTile = (ShovelerSpriteTile*) sprite->data;
 
@@ -12,6 +12,13 @@ static const ShovelerCollider2* intersectTilemapSpriteCollider(
     const ShovelerBoundingBox2* object,
     ShovelerCollider2FilterCandidateFunction* filterCandidate,
     void* filterCandidateUserData);
+static bool sweepTilemapSpriteCollider(
+    const ShovelerCollider2* collider,
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    ShovelerCollider2FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider2Contact* outputContact);
 static bool renderTilemapSprite(
     ShovelerSprite* sprite,
     ShovelerVector2 regionPosition,
@@ -29,6 +36,7 @@ ShovelerSprite* shovelerSpriteTilemapCreate(ShovelerMaterial* material, Shoveler
       &tilemapSprite->sprite,
       material,
       intersectTilemapSpriteCollider,
+      sweepTilemapSpriteCollider,
       renderTilemapSprite,
       freeTilemapSprite,
       tilemapSprite);
@@ -51,6 +59,29 @@ static const ShovelerCollider2* intersectTilemapSpriteCollider(
   return NULL;
 }
 
+static bool sweepTilemapSpriteCollider(
+    const ShovelerCollider2* collider,
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    ShovelerCollider2FilterCandidateFunction* filterCandidate,
+    void* filterCandidateUserData,
+    ShovelerCollider2Contact* outputContact) {
+  ShovelerSpriteTilemap* tilemapSprite = collider->data;
+
+  if (!shovelerTilemapSweep(
+          tilemapSprite->tilemap,
+          &collider->boundingBox,
+          object,
+          displacement,
+          &outputContact->time,
+          &outputContact->normal)) {
+    return false;
+  }
+
+  outputContact->collider = collider;
+  return true;
+}
+
 static bool renderTilemapSprite(
     ShovelerSprite* sprite,
     ShovelerVector2 regionPosition,
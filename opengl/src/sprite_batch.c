@@ -0,0 +1,170 @@
+#include "shoveler/sprite_batch.h"
+
+#include <math.h> // fminf, fmaxf
+#include <stdlib.h> // malloc, free
+
+static guint findBatch(
+    ShovelerSpriteBatcher* batcher,
+    const ShovelerSpriteBatchKey* key,
+    const ShovelerBoundingBox2* boundingBox);
+static void appendBatch(
+    ShovelerSpriteBatcher* batcher,
+    const ShovelerSpriteBatchKey* key,
+    const ShovelerBoundingBox2* boundingBox,
+    void* userData);
+static void extendBoundingBox(
+    ShovelerBoundingBox2* boundingBox, const ShovelerBoundingBox2* otherBoundingBox);
+
+ShovelerSpriteBatcher* shovelerSpriteBatcherCreate() {
+  ShovelerSpriteBatcher* batcher = malloc(sizeof(ShovelerSpriteBatcher));
+  batcher->region = shovelerBoundingBox2(shovelerVector2(0.0f, 0.0f), shovelerVector2(0.0f, 0.0f));
+  batcher->layerId = 0;
+  batcher->layerFirstBatch = 0;
+  batcher->batches =
+      g_array_new(/* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerSpriteBatch));
+  batcher->instances =
+      g_array_new(/* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerSpriteInstance));
+  batcher->stagedBatchIndices =
+      g_array_new(/* zeroTerminated */ false, /* clear */ false, sizeof(guint));
+  batcher->stagedInstances =
+      g_array_new(/* zeroTerminated */ false, /* clear */ false, sizeof(ShovelerSpriteInstance));
+  return batcher;
+}
+
+void shovelerSpriteBatcherBegin(
+    ShovelerSpriteBatcher* batcher, const ShovelerBoundingBox2* region) {
+  batcher->region = *region;
+  batcher->layerId = 0;
+  batcher->layerFirstBatch = 0;
+  g_array_set_size(batcher->batches, 0);
+  g_array_set_size(batcher->instances, 0);
+  g_array_set_size(batcher->stagedBatchIndices, 0);
+  g_array_set_size(batcher->stagedInstances, 0);
+}
+
+void shovelerSpriteBatcherBeginLayer(ShovelerSpriteBatcher* batcher, int layerId) {
+  batcher->layerId = layerId;
+  batcher->layerFirstBatch = batcher->batches->len;
+}
+
+bool shovelerSpriteBatcherAdd(
+    ShovelerSpriteBatcher* batcher,
+    const ShovelerSpriteBatchKey* key,
+    const ShovelerSpriteInstance* instance,
+    void* userData) {
+  ShovelerBoundingBox2 boundingBox = shovelerSpriteInstanceGetBoundingBox(instance);
+  if (!shovelerBoundingBox2Intersect(&batcher->region, &boundingBox)) {
+    return false;
+  }
+
+  guint batchIndex = findBatch(batcher, key, &boundingBox);
+  if (batchIndex == batcher->batches->len) {
+    appendBatch(batcher, key, &boundingBox, userData);
+  } else {
+    ShovelerSpriteBatch* batch = &g_array_index(batcher->batches, ShovelerSpriteBatch, batchIndex);
+    extendBoundingBox(&batch->boundingBox, &boundingBox);
+    batch->numInstances++;
+  }
+
+  g_array_append_val(batcher->stagedBatchIndices, batchIndex);
+  g_array_append_vals(batcher->stagedInstances, instance, 1);
+  return true;
+}
+
+void shovelerSpriteBatcherEnd(ShovelerSpriteBatcher* batcher) {
+  // Assign each batch its range in the packed array, then scatter the staged instances into it.
+  // Since staged instances are visited in the order they were added, the draw order within each
+  // batch is preserved.
+  guint numInstances = 0;
+  for (guint i = 0; i < batcher->batches->len; i++) {
+    ShovelerSpriteBatch* batch = &g_array_index(batcher->batches, ShovelerSpriteBatch, i);
+    batch->firstInstance = numInstances;
+    numInstances += batch->numInstances;
+    // reused as the write cursor below
+    batch->numInstances = 0;
+  }
+
+  g_array_set_size(batcher->instances, numInstances);
+  ShovelerSpriteInstance* instances = (ShovelerSpriteInstance*) batcher->instances->data;
+  const ShovelerSpriteInstance* stagedInstances =
+      (const ShovelerSpriteInstance*) batcher->stagedInstances->data;
+  const guint* stagedBatchIndices = (const guint*) batcher->stagedBatchIndices->data;
+  for (guint i = 0; i < batcher->stagedInstances->len; i++) {
+    ShovelerSpriteBatch* batch =
+        &g_array_index(batcher->batches, ShovelerSpriteBatch, stagedBatchIndices[i]);
+    instances[batch->firstInstance + batch->numInstances] = stagedInstances[i];
+    batch->numInstances++;
+  }
+}
+
+void shovelerSpriteBatcherFree(ShovelerSpriteBatcher* batcher) {
+  if (batcher == NULL) {
+    return;
+  }
+
+  g_array_free(batcher->stagedInstances, /* freeSegment */ true);
+  g_array_free(batcher->stagedBatchIndices, /* freeSegment */ true);
+  g_array_free(batcher->instances, /* freeSegment */ true);
+  g_array_free(batcher->batches, /* freeSegment */ true);
+  free(batcher);
+}
+
+/**
+ * Returns the index of the batch of the current layer the sprite can join, or the number of batches
+ * if a new one has to be started. Walking backwards, a sprite can skip over batches it doesn't
+ * overlap, since drawing it earlier than them doesn't change the blended result.
+ */
+static guint findBatch(
+    ShovelerSpriteBatcher* batcher,
+    const ShovelerSpriteBatchKey* key,
+    const ShovelerBoundingBox2* boundingBox) {
+  guint numBatches = batcher->batches->len;
+  if (key == NULL) {
+    return numBatches;
+  }
+
+  guint lookback = 0;
+  for (guint i = numBatches; i > batcher->layerFirstBatch; i--) {
+    if (lookback++ >= SHOVELER_SPRITE_BATCHER_MAX_LOOKBACK) {
+      break;
+    }
+
+    const ShovelerSpriteBatch* batch = &g_array_index(batcher->batches, ShovelerSpriteBatch, i - 1);
+    if (batch->batchable && batch->key.material == key->material &&
+        batch->key.resource == key->resource && batch->key.sampler == key->sampler) {
+      return i - 1;
+    }
+
+    if (shovelerBoundingBox2Intersect(&batch->boundingBox, boundingBox)) {
+      break;
+    }
+  }
+
+  return numBatches;
+}
+
+static void appendBatch(
+    ShovelerSpriteBatcher* batcher,
+    const ShovelerSpriteBatchKey* key,
+    const ShovelerBoundingBox2* boundingBox,
+    void* userData) {
+  ShovelerSpriteBatch batch;
+  batch.key.material = key != NULL ? key->material : NULL;
+  batch.key.resource = key != NULL ? key->resource : NULL;
+  batch.key.sampler = key != NULL ? key->sampler : NULL;
+  batch.batchable = key != NULL;
+  batch.layerId = batcher->layerId;
+  batch.boundingBox = *boundingBox;
+  batch.userData = userData;
+  batch.firstInstance = 0;
+  batch.numInstances = 1;
+  g_array_append_val(batcher->batches, batch);
+}
+
+static void extendBoundingBox(
+    ShovelerBoundingBox2* boundingBox, const ShovelerBoundingBox2* otherBoundingBox) {
+  for (int i = 0; i < 2; i++) {
+    boundingBox->min.values[i] = fminf(boundingBox->min.values[i], otherBoundingBox->min.values[i]);
+    boundingBox->max.values[i] = fmaxf(boundingBox->max.values[i], otherBoundingBox->max.values[i]);
+  }
+}
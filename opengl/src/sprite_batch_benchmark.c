@@ -0,0 +1,81 @@
+#include <shoveler/log.h>
+#include <shoveler/sprite_batch.h>
+#include <shoveler/types.h>
+#include <stdlib.h> // EXIT_SUCCESS, malloc, free, rand
+
+#define NUM_SPRITES 20000
+#define NUM_MATERIALS 2
+#define NUM_TILESETS 4
+#define NUM_LAYERS 3
+#define NUM_FRAMES 100
+#define WORLD_SIZE 500.0f
+
+typedef struct {
+  ShovelerSpriteBatchKey key;
+  ShovelerSpriteInstance instance;
+  int layerId;
+} Sprite;
+
+int main(int argc, char* argv[]) {
+  shovelerLogInit("shoveler/", SHOVELER_LOG_LEVEL_INFO_UP, stdout);
+  srand(0);
+
+  // The materials and tilesets are only compared by address, so any distinct pointers will do.
+  static int materials[NUM_MATERIALS];
+  static int tilesets[NUM_TILESETS];
+
+  Sprite* sprites = malloc(NUM_SPRITES * sizeof(Sprite));
+  for (int i = 0; i < NUM_SPRITES; i++) {
+    Sprite* sprite = &sprites[i];
+    sprite->key.material = &materials[rand() % NUM_MATERIALS];
+    sprite->key.resource = &tilesets[rand() % NUM_TILESETS];
+    sprite->key.sampler = NULL;
+    sprite->instance.position = shovelerVector2(
+        WORLD_SIZE * ((float) rand() / RAND_MAX), WORLD_SIZE * ((float) rand() / RAND_MAX));
+    sprite->instance.size = shovelerVector2(1.0f, 1.0f);
+    sprite->instance.tilesetColumn = rand() % 8;
+    sprite->instance.tilesetRow = rand() % 8;
+    sprite->layerId = i * NUM_LAYERS / NUM_SPRITES;
+  }
+
+  ShovelerBoundingBox2 region =
+      shovelerBoundingBox2(shovelerVector2(0.0f, 0.0f), shovelerVector2(WORLD_SIZE, WORLD_SIZE));
+  ShovelerSpriteBatcher* batcher = shovelerSpriteBatcherCreate();
+
+  int numVisible = 0;
+  gint64 startTime = g_get_monotonic_time();
+  for (int frame = 0; frame < NUM_FRAMES; frame++) {
+    numVisible = 0;
+    shovelerSpriteBatcherBegin(batcher, &region);
+    int layerId = -1;
+    for (int i = 0; i < NUM_SPRITES; i++) {
+      Sprite* sprite = &sprites[i];
+      if (sprite->layerId != layerId) {
+        layerId = sprite->layerId;
+        shovelerSpriteBatcherBeginLayer(batcher, layerId);
+      }
+
+      if (shovelerSpriteBatcherAdd(batcher, &sprite->key, &sprite->instance, sprite)) {
+        numVisible++;
+      }
+    }
+    shovelerSpriteBatcherEnd(batcher);
+  }
+  gint64 batchTimeUs = g_get_monotonic_time() - startTime;
+
+  shovelerLogInfo(
+      "Batched %d visible sprites in %d layers into %u batches (%.1f sprites per batch, %d draw "
+      "calls saved) in %.3fms per frame.",
+      numVisible,
+      NUM_LAYERS,
+      batcher->batches->len,
+      (double) numVisible / batcher->batches->len,
+      numVisible - (int) batcher->batches->len,
+      (double) batchTimeUs / NUM_FRAMES / 1000.0);
+
+  shovelerSpriteBatcherFree(batcher);
+  free(sprites);
+  shovelerLogTerminate();
+
+  return EXIT_SUCCESS;
+}
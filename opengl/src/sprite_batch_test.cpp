@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "shoveler/sprite_batch.h"
+}
+
+static int testMaterialA = 0;
+static int testMaterialB = 0;
+static int testTileset = 0;
+
+class ShovelerSpriteBatchTest : public ::testing::Test {
+public:
+  virtual void SetUp() {
+    batcher = shovelerSpriteBatcherCreate();
+    ShovelerBoundingBox2 region =
+        shovelerBoundingBox2(shovelerVector2(0.0f, 0.0f), shovelerVector2(100.0f, 100.0f));
+    shovelerSpriteBatcherBegin(batcher, &region);
+    shovelerSpriteBatcherBeginLayer(batcher, /* layerId */ 0);
+  }
+
+  virtual void TearDown() { shovelerSpriteBatcherFree(batcher); }
+
+  bool add(const ShovelerSpriteBatchKey* key, float x, float y, int tilesetColumn = 0) {
+    ShovelerSpriteInstance instance;
+    instance.position = shovelerVector2(x, y);
+    instance.size = shovelerVector2(1.0f, 1.0f);
+    instance.tilesetColumn = tilesetColumn;
+    instance.tilesetRow = 0;
+    return shovelerSpriteBatcherAdd(batcher, key, &instance, /* userData */ NULL);
+  }
+
+  const ShovelerSpriteBatch* getBatch(guint index) {
+    return &g_array_index(batcher->batches, ShovelerSpriteBatch, index);
+  }
+
+  ShovelerSpriteBatcher* batcher;
+};
+
+static ShovelerSpriteBatchKey createKey(const void* material, const void* resource) {
+  ShovelerSpriteBatchKey key;
+  key.material = material;
+  key.resource = resource;
+  key.sampler = NULL;
+  return key;
+}
+
+TEST_F(ShovelerSpriteBatchTest, batchSameKey) {
+  ShovelerSpriteBatchKey key = createKey(&testMaterialA, &testTileset);
+  ASSERT_TRUE(add(&key, 10.0f, 10.0f));
+  ASSERT_TRUE(add(&key, 10.5f, 10.0f));
+  ASSERT_TRUE(add(&key, 20.0f, 10.0f));
+  shovelerSpriteBatcherEnd(batcher);
+
+  ASSERT_EQ(batcher->batches->len, 1);
+  ASSERT_TRUE(getBatch(0)->batchable);
+  ASSERT_EQ(getBatch(0)->numInstances, 3);
+  ASSERT_EQ(batcher->instances->len, 3);
+}
+
+TEST_F(ShovelerSpriteBatchTest, skipNonOverlappingBatches) {
+  ShovelerSpriteBatchKey keyA = createKey(&testMaterialA, &testTileset);
+  ShovelerSpriteBatchKey keyB = createKey(&testMaterialB, &testTileset);
+  ASSERT_TRUE(add(&keyA, 10.0f, 10.0f, /* tilesetColumn */ 0));
+  ASSERT_TRUE(add(&keyB, 20.0f, 10.0f, /* tilesetColumn */ 1));
+  ASSERT_TRUE(add(&keyA, 30.0f, 10.0f, /* tilesetColumn */ 2));
+  shovelerSpriteBatcherEnd(batcher);
+
+  ASSERT_EQ(batcher->batches->len, 2);
+  ASSERT_EQ(getBatch(0)->key.material, &testMaterialA);
+  ASSERT_EQ(getBatch(0)->numInstances, 2);
+  ASSERT_EQ(getBatch(1)->key.material, &testMaterialB);
+  ASSERT_EQ(getBatch(1)->numInstances, 1);
+
+  const ShovelerSpriteInstance* instances = shovelerSpriteBatchGetInstances(batcher, getBatch(0));
+  ASSERT_EQ(instances[0].tilesetColumn, 0);
+  ASSERT_EQ(instances[1].tilesetColumn, 2);
+  instances = shovelerSpriteBatchGetInstances(batcher, getBatch(1));
+  ASSERT_EQ(instances[0].tilesetColumn, 1);
+}
+
+TEST_F(ShovelerSpriteBatchTest, overlapPreservesOrder) {
+  ShovelerSpriteBatchKey keyA = createKey(&testMaterialA, &testTileset);
+  ShovelerSpriteBatchKey keyB = createKey(&testMaterialB, &testTileset);
+  ASSERT_TRUE(add(&keyA, 10.0f, 10.0f));
+  ASSERT_TRUE(add(&keyB, 10.5f, 10.0f));
+  ASSERT_TRUE(add(&keyA, 11.0f, 10.0f));
+  shovelerSpriteBatcherEnd(batcher);
+
+  ASSERT_EQ(batcher->batches->len, 3);
+  ASSERT_EQ(getBatch(0)->key.material, &testMaterialA);
+  ASSERT_EQ(getBatch(1)->key.material, &testMaterialB);
+  ASSERT_EQ(getBatch(2)->key.material, &testMaterialA);
+}
+
+TEST_F(ShovelerSpriteBatchTest, differentResourcesDontBatch) {
+  int otherTileset = 0;
+  ShovelerSpriteBatchKey key = createKey(&testMaterialA, &testTileset);
+  ShovelerSpriteBatchKey otherKey = createKey(&testMaterialA, &otherTileset);
+  ASSERT_TRUE(add(&key, 10.0f, 10.0f));
+  ASSERT_TRUE(add(&otherKey, 20.0f, 10.0f));
+  shovelerSpriteBatcherEnd(batcher);
+
+  ASSERT_EQ(batcher->batches->len, 2);
+}
+
+TEST_F(ShovelerSpriteBatchTest, differentSamplersDontBatch) {
+  int sampler = 0;
+  int otherSampler = 0;
+  ShovelerSpriteBatchKey key = createKey(&testMaterialA, &testTileset);
+  key.sampler = &sampler;
+  ShovelerSpriteBatchKey otherKey = createKey(&testMaterialA, &testTileset);
+  otherKey.sampler = &otherSampler;
+  ASSERT_TRUE(add(&key, 10.0f, 10.0f));
+  ASSERT_TRUE(add(&otherKey, 20.0f, 10.0f));
+  ASSERT_TRUE(add(&key, 30.0f, 10.0f));
+  shovelerSpriteBatcherEnd(batcher);
+
+  ASSERT_EQ(batcher->batches->len, 2);
+  ASSERT_EQ(getBatch(0)->key.sampler, &sampler);
+  ASSERT_EQ(getBatch(0)->numInstances, 2);
+  ASSERT_EQ(getBatch(1)->key.sampler, &otherSampler);
+}
+
+TEST_F(ShovelerSpriteBatchTest, layersDontBatch) {
+  ShovelerSpriteBatchKey key = createKey(&testMaterialA, &testTileset);
+  ASSERT_TRUE(add(&key, 10.0f, 10.0f));
+  shovelerSpriteBatcherBeginLayer(batcher, /* layerId */ 1);
+  ASSERT_TRUE(add(&key, 20.0f, 10.0f));
+  shovelerSpriteBatcherEnd(batcher);
+
+  ASSERT_EQ(batcher->batches->len, 2);
+  ASSERT_EQ(getBatch(0)->layerId, 0);
+  ASSERT_EQ(getBatch(1)->layerId, 1);
+}
+
+TEST_F(ShovelerSpriteBatchTest, unbatchable) {
+  ASSERT_TRUE(add(/* key */ NULL, 10.0f, 10.0f));
+  ASSERT_TRUE(add(/* key */ NULL, 20.0f, 10.0f));
+  shovelerSpriteBatcherEnd(batcher);
+
+  ASSERT_EQ(batcher->batches->len, 2);
+  ASSERT_FALSE(getBatch(0)->batchable);
+  ASSERT_FALSE(getBatch(1)->batchable);
+}
+
+TEST_F(ShovelerSpriteBatchTest, cull) {
+  ShovelerSpriteBatchKey key = createKey(&testMaterialA, &testTileset);
+  ASSERT_FALSE(add(&key, -10.0f, 10.0f));
+  ASSERT_TRUE(add(&key, 0.0f, 10.0f));
+  ASSERT_FALSE(add(&key, 150.0f, 150.0f));
+  shovelerSpriteBatcherEnd(batcher);
+
+  ASSERT_EQ(batcher->batches->len, 1);
+  ASSERT_EQ(getBatch(0)->numInstances, 1);
+}
+
+TEST_F(ShovelerSpriteBatchTest, reuseAcrossFrames) {
+  ShovelerSpriteBatchKey key = createKey(&testMaterialA, &testTileset);
+  ASSERT_TRUE(add(&key, 10.0f, 10.0f));
+  shovelerSpriteBatcherEnd(batcher);
+
+  ShovelerBoundingBox2 region =
+      shovelerBoundingBox2(shovelerVector2(0.0f, 0.0f), shovelerVector2(100.0f, 100.0f));
+  shovelerSpriteBatcherBegin(batcher, &region);
+  shovelerSpriteBatcherBeginLayer(batcher, /* layerId */ 0);
+  ASSERT_TRUE(add(&key, 10.0f, 10.0f));
+  ASSERT_TRUE(add(&key, 20.0f, 10.0f));
+  shovelerSpriteBatcherEnd(batcher);
+
+  ASSERT_EQ(batcher->batches->len, 1);
+  ASSERT_EQ(getBatch(0)->firstInstance, 0);
+  ASSERT_EQ(getBatch(0)->numInstances, 2);
+  ASSERT_EQ(batcher->instances->len, 2);
+}
@@ -8,6 +8,8 @@
 #include "shoveler/font_atlas.h"
 #include "shoveler/font_atlas_texture.h"
 #include "shoveler/framebuffer.h"
+#include "shoveler/glyph_run.h"
+#include "shoveler/log.h"
 #include "shoveler/material/canvas.h"
 #include "shoveler/material/text.h"
 #include "shoveler/model.h"
@@ -16,6 +18,19 @@
 #include "shoveler/sprite/text.h"
 #include "shoveler/texture.h"
 
+static ShovelerTextLayout* computeLayout(ShovelerTextTextureRenderer* renderer, const char* text);
+static void removeLayout(ShovelerTextTextureRenderer* renderer, ShovelerTextLayout* layout);
+static void pushLayout(ShovelerTextTextureRenderer* renderer, ShovelerTextLayout* layout);
+static ShovelerTextTexture* findReusableTextTexture(
+    ShovelerTextTextureRenderer* renderer, unsigned int width, unsigned int height);
+static void evictTextTextures(ShovelerTextTextureRenderer* renderer);
+static void removeUnreferencedTextTexture(
+    ShovelerTextTextureRenderer* renderer, ShovelerTextTexture* textTexture);
+static void pushUnreferencedTextTexture(
+    ShovelerTextTextureRenderer* renderer, ShovelerTextTexture* textTexture);
+static void freeLayout(void* layoutPointer);
+static void freeTextTexture(ShovelerTextTexture* textTexture);
+
 ShovelerTextTextureRenderer* shovelerTextTextureRendererCreate(
     ShovelerFontAtlasTexture* fontAtlasTexture, ShovelerShaderCache* shaderCache) {
   ShovelerTextTextureRenderer* renderer = malloc(sizeof(ShovelerTextTextureRenderer));
@@ -36,60 +51,146 @@ ShovelerTextTextureRenderer* shovelerTextTextureRendererCreate(
   shovelerCanvasAddSprite(renderer->textCanvas, /* layerId */ 0, renderer->textSprite);
   shovelerMaterialCanvasSetActive(renderer->canvasMaterial, renderer->textCanvas);
 
+  renderer->layoutGlyphRunBuilder =
+      shovelerGlyphRunBuilderCreateFontAtlas(fontAtlasTexture->fontAtlas);
+  renderer->layouts = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, freeLayout);
+  renderer->mostRecentLayout = NULL;
+  renderer->leastRecentLayout = NULL;
+  renderer->layoutCacheSize = SHOVELER_TEXT_TEXTURE_RENDERER_DEFAULT_LAYOUT_CACHE_SIZE;
+  renderer->textTextures = g_hash_table_new(g_str_hash, g_str_equal);
+  renderer->textTexturesByTexture = g_hash_table_new(g_direct_hash, g_direct_equal);
+  renderer->mostRecentUnreferencedTextTexture = NULL;
+  renderer->leastRecentUnreferencedTextTexture = NULL;
+  renderer->numUnreferencedTextTextures = 0;
+  renderer->textureCacheSize = SHOVELER_TEXT_TEXTURE_RENDERER_DEFAULT_TEXTURE_CACHE_SIZE;
+  renderer->stats.numLayoutHits = 0;
+  renderer->stats.numLayoutMisses = 0;
+  renderer->stats.numTextureHits = 0;
+  renderer->stats.numTextureMisses = 0;
+  renderer->stats.numFramebufferReuses = 0;
+  renderer->stats.numTextureEvictions = 0;
+
   return renderer;
 }
 
-ShovelerTexture* shovelerTextTextureRendererRender(
-    ShovelerTextTextureRenderer* renderer, const char* text, ShovelerRenderState* renderState) {
-  float currentWidth = 0.0f;
-  float currentHeightTop = 0.0f;
-  float currentHeightBottom = 0.0f;
-  float currentOriginX = 0.0f;
-
-  for (const char* c = text; *c != '\0'; c++) {
-    unsigned char character = *((unsigned char*) c);
+const ShovelerTextLayout* shovelerTextTextureRendererGetLayout(
+    ShovelerTextTextureRenderer* renderer, const char* text) {
+  ShovelerTextLayout* layout = g_hash_table_lookup(renderer->layouts, text);
+  if (layout != NULL) {
+    renderer->stats.numLayoutHits++;
+    removeLayout(renderer, layout);
+    pushLayout(renderer, layout);
+    return layout;
+  }
 
-    currentWidth = currentOriginX;
+  renderer->stats.numLayoutMisses++;
+  layout = computeLayout(renderer, text);
+  g_hash_table_insert(renderer->layouts, layout->text, layout);
+  pushLayout(renderer, layout);
 
-    ShovelerFontAtlasGlyph* glyph =
-        shovelerFontAtlasGetGlyph(renderer->fontAtlasTexture->fontAtlas, character);
+  // never evict the layout just computed, even if the cache size is zero
+  while (g_hash_table_size(renderer->layouts) > renderer->layoutCacheSize &&
+         renderer->leastRecentLayout != layout) {
+    ShovelerTextLayout* leastRecentLayout = renderer->leastRecentLayout;
+    removeLayout(renderer, leastRecentLayout);
+    g_hash_table_remove(renderer->layouts, leastRecentLayout->text);
+  }
 
-    currentWidth += glyph->bearingX;
-    currentWidth += glyph->width;
+  return layout;
+}
 
-    if (glyph->bearingY > currentHeightTop) {
-      currentHeightTop = glyph->bearingY;
+ShovelerTexture* shovelerTextTextureRendererRender(
+    ShovelerTextTextureRenderer* renderer, const char* text, ShovelerRenderState* renderState) {
+  ShovelerTextTexture* textTexture = g_hash_table_lookup(renderer->textTextures, text);
+  if (textTexture != NULL) {
+    renderer->stats.numTextureHits++;
+    if (textTexture->referenceCount == 0) {
+      removeUnreferencedTextTexture(renderer, textTexture);
     }
+    textTexture->referenceCount++;
+    return textTexture->texture;
+  }
 
-    float bottomExtent = glyph->height - glyph->bearingY;
-    if (bottomExtent > currentHeightBottom) {
-      currentHeightBottom = bottomExtent;
-    }
+  renderer->stats.numTextureMisses++;
+  const ShovelerTextLayout* layout = shovelerTextTextureRendererGetLayout(renderer, text);
+  unsigned int width = (unsigned int) ceilf(layout->width);
+  unsigned int height = (unsigned int) ceilf(layout->heightBottom + layout->heightTop);
 
-    currentOriginX += glyph->advance / 64.0f;
+  textTexture = findReusableTextTexture(renderer, width, height);
+  if (textTexture != NULL) {
+    // steal the framebuffer of a released texture and render over its previous contents
+    renderer->stats.numFramebufferReuses++;
+    removeUnreferencedTextTexture(renderer, textTexture);
+    g_hash_table_remove(renderer->textTextures, textTexture->text);
+    free(textTexture->text);
+  } else {
+    textTexture = malloc(sizeof(ShovelerTextTexture));
+    textTexture->framebuffer = shovelerFramebufferCreateColorOnly(width, height, 1, 1, 8);
+    textTexture->texture = textTexture->framebuffer->renderTarget;
+    textTexture->previous = NULL;
+    textTexture->next = NULL;
+    g_hash_table_insert(renderer->textTexturesByTexture, textTexture->texture, textTexture);
   }
+  textTexture->text = strdup(text);
+  textTexture->referenceCount = 1;
+  g_hash_table_insert(renderer->textTextures, textTexture->text, textTexture);
 
-  unsigned int width = (unsigned int) ceilf(currentWidth);
-  unsigned int height = (unsigned int) ceilf(currentHeightBottom + currentHeightTop);
-
-  shovelerFontAtlasTextureUpdate(renderer->fontAtlasTexture);
-  shovelerSpriteTextSetContent(renderer->textSprite, text, false);
-  renderer->textSprite->position = shovelerVector2(0.0f, currentHeightBottom);
+  shovelerSpriteTextSetContent(renderer->textSprite, textTexture->text, false);
+  shovelerSpriteUpdatePosition(renderer->textSprite, shovelerVector2(0.0f, layout->heightBottom));
 
   shovelerMaterialCanvasSetActiveRegion(
       renderer->canvasMaterial,
       shovelerVector2(0.5f * width, 0.5f * height),
       shovelerVector2(width, height));
 
-  ShovelerFramebuffer* framebuffer = shovelerFramebufferCreateColorOnly(width, height, 1, 1, 8);
-  shovelerSceneRenderFrame(renderer->textScene, NULL, framebuffer, renderState);
+  shovelerSceneRenderFrame(renderer->textScene, NULL, textTexture->framebuffer, renderState);
+
+  return textTexture->texture;
+}
+
+void shovelerTextTextureRendererRelease(
+    ShovelerTextTextureRenderer* renderer, ShovelerTexture* texture) {
+  ShovelerTextTexture* textTexture = g_hash_table_lookup(renderer->textTexturesByTexture, texture);
+  if (textTexture == NULL || textTexture->referenceCount == 0) {
+    shovelerLogWarning("Ignoring release of text texture %p not rendered by renderer.", texture);
+    return;
+  }
 
-  ShovelerTexture* texture = framebuffer->renderTarget;
-  shovelerFramebufferFree(framebuffer, /* keepTargets */ true);
-  return texture;
+  textTexture->referenceCount--;
+  if (textTexture->referenceCount == 0) {
+    pushUnreferencedTextTexture(renderer, textTexture);
+    evictTextTextures(renderer);
+  }
+}
+
+void shovelerTextTextureRendererLogStats(ShovelerTextTextureRenderer* renderer) {
+  const ShovelerTextTextureRendererStats* stats = &renderer->stats;
+  shovelerLogInfo(
+      "Text texture renderer had %lld layout hits and %lld misses, %lld texture hits and %lld "
+      "misses with %lld framebuffer reuses and %lld evictions, with %u layouts and %u textures "
+      "(%u released) cached.",
+      (long long) stats->numLayoutHits,
+      (long long) stats->numLayoutMisses,
+      (long long) stats->numTextureHits,
+      (long long) stats->numTextureMisses,
+      (long long) stats->numFramebufferReuses,
+      (long long) stats->numTextureEvictions,
+      g_hash_table_size(renderer->layouts),
+      g_hash_table_size(renderer->textTextures),
+      renderer->numUnreferencedTextTextures);
 }
 
 void shovelerTextTextureRendererFree(ShovelerTextTextureRenderer* renderer) {
+  GHashTableIter iter;
+  ShovelerTextTexture* textTexture;
+  g_hash_table_iter_init(&iter, renderer->textTexturesByTexture);
+  while (g_hash_table_iter_next(&iter, NULL, (gpointer*) &textTexture)) {
+    freeTextTexture(textTexture);
+  }
+  g_hash_table_destroy(renderer->textTexturesByTexture);
+  g_hash_table_destroy(renderer->textTextures);
+  g_hash_table_destroy(renderer->layouts);
+  shovelerGlyphRunBuilderFree(renderer->layoutGlyphRunBuilder);
   shovelerSpriteFree(renderer->textSprite);
   shovelerCanvasFree(renderer->textCanvas);
   shovelerSceneRemoveModel(renderer->textScene, renderer->textModel);
@@ -99,3 +200,126 @@ void shovelerTextTextureRendererFree(ShovelerTextTextureRenderer* renderer) {
   shovelerSceneFree(renderer->textScene);
   free(renderer);
 }
+
+static ShovelerTextLayout* computeLayout(ShovelerTextTextureRenderer* renderer, const char* text) {
+  ShovelerGlyphRunBuilder* builder = renderer->layoutGlyphRunBuilder;
+  shovelerGlyphRunBuilderClear(builder);
+  guint runIndex = shovelerGlyphRunBuilderAdd(
+      builder,
+      text,
+      /* origin */ shovelerVector2(0.0f, 0.0f),
+      /* size */ (float) builder->fontSize,
+      /* color */ shovelerVector4(1.0f, 1.0f, 1.0f, 1.0f));
+  const ShovelerGlyphRun* run = shovelerGlyphRunBuilderGetRun(builder, runIndex);
+
+  ShovelerTextLayout* layout = malloc(sizeof(ShovelerTextLayout));
+  layout->text = strdup(text);
+  layout->width = run->width;
+  layout->heightTop = run->heightTop;
+  layout->heightBottom = run->heightBottom;
+  layout->previous = NULL;
+  layout->next = NULL;
+
+  return layout;
+}
+
+static void removeLayout(ShovelerTextTextureRenderer* renderer, ShovelerTextLayout* layout) {
+  if (layout->previous != NULL) {
+    layout->previous->next = layout->next;
+  } else {
+    renderer->mostRecentLayout = layout->next;
+  }
+
+  if (layout->next != NULL) {
+    layout->next->previous = layout->previous;
+  } else {
+    renderer->leastRecentLayout = layout->previous;
+  }
+
+  layout->previous = NULL;
+  layout->next = NULL;
+}
+
+static void pushLayout(ShovelerTextTextureRenderer* renderer, ShovelerTextLayout* layout) {
+  layout->previous = NULL;
+  layout->next = renderer->mostRecentLayout;
+  if (renderer->mostRecentLayout != NULL) {
+    renderer->mostRecentLayout->previous = layout;
+  } else {
+    renderer->leastRecentLayout = layout;
+  }
+  renderer->mostRecentLayout = layout;
+}
+
+/**
+ * Texture sizes are matched exactly rather than rounded up to a size class, since users stretch the
+ * whole texture over their sprites and a larger framebuffer would add padding to the text.
+ */
+static ShovelerTextTexture* findReusableTextTexture(
+    ShovelerTextTextureRenderer* renderer, unsigned int width, unsigned int height) {
+  for (ShovelerTextTexture* textTexture = renderer->leastRecentUnreferencedTextTexture;
+       textTexture != NULL;
+       textTexture = textTexture->previous) {
+    if (textTexture->framebuffer->width == (GLsizei) width &&
+        textTexture->framebuffer->height == (GLsizei) height) {
+      return textTexture;
+    }
+  }
+
+  return NULL;
+}
+
+static void evictTextTextures(ShovelerTextTextureRenderer* renderer) {
+  while (renderer->numUnreferencedTextTextures > renderer->textureCacheSize) {
+    ShovelerTextTexture* textTexture = renderer->leastRecentUnreferencedTextTexture;
+    removeUnreferencedTextTexture(renderer, textTexture);
+    g_hash_table_remove(renderer->textTexturesByTexture, textTexture->texture);
+    g_hash_table_remove(renderer->textTextures, textTexture->text);
+    freeTextTexture(textTexture);
+    renderer->stats.numTextureEvictions++;
+  }
+}
+
+static void removeUnreferencedTextTexture(
+    ShovelerTextTextureRenderer* renderer, ShovelerTextTexture* textTexture) {
+  if (textTexture->previous != NULL) {
+    textTexture->previous->next = textTexture->next;
+  } else {
+    renderer->mostRecentUnreferencedTextTexture = textTexture->next;
+  }
+
+  if (textTexture->next != NULL) {
+    textTexture->next->previous = textTexture->previous;
+  } else {
+    renderer->leastRecentUnreferencedTextTexture = textTexture->previous;
+  }
+
+  textTexture->previous = NULL;
+  textTexture->next = NULL;
+  renderer->numUnreferencedTextTextures--;
+}
+
+static void pushUnreferencedTextTexture(
+    ShovelerTextTextureRenderer* renderer, ShovelerTextTexture* textTexture) {
+  textTexture->previous = NULL;
+  textTexture->next = renderer->mostRecentUnreferencedTextTexture;
+  if (renderer->mostRecentUnreferencedTextTexture != NULL) {
+    renderer->mostRecentUnreferencedTextTexture->previous = textTexture;
+  } else {
+    renderer->leastRecentUnreferencedTextTexture = textTexture;
+  }
+  renderer->mostRecentUnreferencedTextTexture = textTexture;
+  renderer->numUnreferencedTextTextures++;
+}
+
+static void freeLayout(void* layoutPointer) {
+  ShovelerTextLayout* layout = layoutPointer;
+  free(layout->text);
+  free(layout);
+}
+
+static void freeTextTexture(ShovelerTextTexture* textTexture) {
+  shovelerFramebufferFree(textTexture->framebuffer, /* keepTargets */ false);
+  free(textTexture->text);
+  free(textTexture);
+}
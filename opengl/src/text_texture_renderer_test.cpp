@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "shoveler/font.h"
+#include "shoveler/font_atlas.h"
+#include "shoveler/font_atlas_texture.h"
+#include "shoveler/glyph_run.h"
+#include "shoveler/log.h"
+#include "shoveler/material/text.h"
+#include "shoveler/opengl_recorder.h"
+#include "shoveler/render_state.h"
+#include "shoveler/shader_cache.h"
+#include "shoveler/text_texture_renderer.h"
+}
+
+static const int testFontSize = 8;
+
+/** Bitmap font where every glyph is 6x6 pixels with a bearing of (1, 6) and an advance of 8. */
+static const char* testFont =
+    "STARTFONT 2.1\n"
+    "FONT -shoveler-test-medium-r-normal--8-80-75-75-c-80-iso10646-1\n"
+    "SIZE 8 75 75\n"
+    "FONTBOUNDINGBOX 8 8 0 -2\n"
+    "STARTPROPERTIES 4\n"
+    "FONT_ASCENT 6\n"
+    "FONT_DESCENT 2\n"
+    "CHARSET_REGISTRY \"ISO10646\"\n"
+    "CHARSET_ENCODING \"1\"\n"
+    "ENDPROPERTIES\n"
+    "CHARS 3\n"
+    "STARTCHAR a\n"
+    "ENCODING 97\n"
+    "SWIDTH 500 0\n"
+    "DWIDTH 8 0\n"
+    "BBX 6 6 1 0\n"
+    "BITMAP\n"
+    "FC\nFC\nFC\nFC\nFC\nFC\n"
+    "ENDCHAR\n"
+    "STARTCHAR b\n"
+    "ENCODING 98\n"
+    "SWIDTH 500 0\n"
+    "DWIDTH 8 0\n"
+    "BBX 6 6 1 0\n"
+    "BITMAP\n"
+    "FC\n84\n84\n84\n84\nFC\n"
+    "ENDCHAR\n"
+    "STARTCHAR c\n"
+    "ENCODING 99\n"
+    "SWIDTH 500 0\n"
+    "DWIDTH 8 0\n"
+    "BBX 6 6 1 0\n"
+    "BITMAP\n"
+    "FC\n80\n80\n80\n80\nFC\n"
+    "ENDCHAR\n"
+    "ENDFONT\n";
+
+static void logMessage(const char* file, int line, ShovelerLogLevel level, const char* message);
+
+static std::vector<std::string> loggedWarnings;
+
+class ShovelerTextTextureRendererTest : public ::testing::Test {
+public:
+  virtual void SetUp() {
+    loggedWarnings.clear();
+    shovelerLogInitWithCallback(SHOVELER_LOG_LEVEL_WARNING_UP, logMessage);
+
+    recorder = shovelerOpenGLRecorderCreate();
+    shaderCache = shovelerShaderCacheCreate();
+    fonts = shovelerFontsCreate();
+    ShovelerFont* font = shovelerFontsLoadFontBuffer(
+        fonts, "test", (const unsigned char*) testFont, (int) strlen(testFont));
+    ASSERT_TRUE(font != NULL);
+    fontAtlas = shovelerFontAtlasCreate(font, testFontSize, /* padding */ 1);
+    fontAtlasTexture = shovelerFontAtlasTextureCreate(fontAtlas);
+    renderer = shovelerTextTextureRendererCreate(fontAtlasTexture, shaderCache);
+
+    renderState.blend = true;
+    renderState.blendSourceFactor = GL_ONE;
+    renderState.blendDestinationFactor = GL_ZERO;
+    renderState.depthTest = true;
+    renderState.depthFunction = GL_LESS;
+    renderState.depthMask = GL_TRUE;
+    shovelerRenderStateReset(&renderState);
+  }
+
+  virtual void TearDown() {
+    shovelerTextTextureRendererFree(renderer);
+    shovelerFontAtlasTextureFree(fontAtlasTexture);
+    shovelerFontAtlasFree(fontAtlas);
+    shovelerFontsFree(fonts);
+    shovelerShaderCacheFree(shaderCache);
+    shovelerOpenGLRecorderFree(recorder);
+
+    shovelerLogInit("shoveler/", SHOVELER_LOG_LEVEL_ALL, stdout);
+  }
+
+  ShovelerTexture* render(const char* text) {
+    return shovelerTextTextureRendererRender(renderer, text, &renderState);
+  }
+
+  void release(ShovelerTexture* texture) { shovelerTextTextureRendererRelease(renderer, texture); }
+
+  ShovelerTextTexture* getTextTexture(const char* text) {
+    return (ShovelerTextTexture*) g_hash_table_lookup(renderer->textTextures, text);
+  }
+
+  ShovelerOpenGLRecorder* recorder;
+  ShovelerShaderCache* shaderCache;
+  ShovelerFonts* fonts;
+  ShovelerFontAtlas* fontAtlas;
+  ShovelerFontAtlasTexture* fontAtlasTexture;
+  ShovelerTextTextureRenderer* renderer;
+  ShovelerRenderState renderState;
+};
+
+TEST_F(ShovelerTextTextureRendererTest, cacheLayouts) {
+  const ShovelerTextLayout* layout = shovelerTextTextureRendererGetLayout(renderer, "ab");
+  ASSERT_FLOAT_EQ(layout->width, 8.0f + 1.0f + 6.0f);
+  ASSERT_FLOAT_EQ(layout->heightTop, 6.0f);
+  ASSERT_FLOAT_EQ(layout->heightBottom, 0.0f);
+
+  const ShovelerTextLayout* cachedLayout = shovelerTextTextureRendererGetLayout(renderer, "ab");
+  ASSERT_EQ(cachedLayout, layout);
+  ASSERT_EQ(renderer->stats.numLayoutHits, 1);
+  ASSERT_EQ(renderer->stats.numLayoutMisses, 1);
+}
+
+TEST_F(ShovelerTextTextureRendererTest, shareTextures) {
+  ShovelerTexture* texture = render("ab");
+  ASSERT_TRUE(texture != NULL);
+  ASSERT_GT(recorder->stats.numDrawCalls, 0) << "a missed text should be rendered";
+
+  shovelerOpenGLRecorderResetStats(recorder);
+  ShovelerTexture* sharedTexture = render("ab");
+  ASSERT_EQ(sharedTexture, texture);
+  ASSERT_EQ(recorder->stats.numDrawCalls, 0) << "a cached text should not be rendered again";
+  ASSERT_EQ(renderer->stats.numTextureHits, 1);
+  ASSERT_EQ(renderer->stats.numTextureMisses, 1);
+
+  ShovelerTextTexture* textTexture = getTextTexture("ab");
+  ASSERT_EQ(textTexture->referenceCount, 2);
+  release(texture);
+  ASSERT_EQ(textTexture->referenceCount, 1);
+  ASSERT_EQ(renderer->numUnreferencedTextTextures, 0);
+  release(sharedTexture);
+  ASSERT_EQ(textTexture->referenceCount, 0);
+  ASSERT_EQ(renderer->numUnreferencedTextTextures, 1);
+
+  ASSERT_EQ(render("ab"), texture) << "released textures should stay cached";
+  ASSERT_EQ(textTexture->referenceCount, 1);
+  ASSERT_EQ(renderer->numUnreferencedTextTextures, 0);
+  ASSERT_EQ(renderer->stats.numTextureHits, 2);
+}
+
+TEST_F(ShovelerTextTextureRendererTest, evictAtTextureCacheSize) {
+  renderer->textureCacheSize = 2;
+
+  // texts of different sizes, so that none of them reuses the framebuffer of another
+  release(render("a"));
+  release(render("ab"));
+  ASSERT_EQ(renderer->stats.numTextureEvictions, 0);
+  release(render("abc"));
+
+  ASSERT_EQ(renderer->stats.numTextureEvictions, 1);
+  ASSERT_EQ(renderer->stats.numFramebufferReuses, 0);
+  ASSERT_EQ(renderer->numUnreferencedTextTextures, 2);
+  ASSERT_EQ(g_hash_table_size(renderer->textTextures), 2);
+  ASSERT_TRUE(getTextTexture("a") == NULL) << "the least recently released text is evicted";
+  ASSERT_TRUE(getTextTexture("ab") != NULL);
+  ASSERT_TRUE(getTextTexture("abc") != NULL);
+}
+
+TEST_F(ShovelerTextTextureRendererTest, reuseFramebufferOfSameSize) {
+  ShovelerTexture* texture = render("ab");
+  ShovelerTexture* otherSizeTexture = render("abc");
+  release(texture);
+  release(otherSizeTexture);
+
+  shovelerOpenGLRecorderResetStats(recorder);
+  ShovelerTexture* reusedTexture = render("ba");
+
+  ASSERT_EQ(reusedTexture, texture);
+  ASSERT_GT(recorder->stats.numDrawCalls, 0) << "the new text should be rendered over the old one";
+  ASSERT_EQ(renderer->stats.numFramebufferReuses, 1);
+  ASSERT_TRUE(getTextTexture("ab") == NULL) << "the replaced text must no longer be cached";
+  ASSERT_EQ(getTextTexture("ba")->referenceCount, 1);
+  ASSERT_TRUE(getTextTexture("abc") != NULL) << "textures of other sizes should stay cached";
+  ASSERT_EQ(renderer->numUnreferencedTextTextures, 1);
+}
+
+TEST_F(ShovelerTextTextureRendererTest, warnOnDoubleRelease) {
+  ShovelerTexture* texture = render("ab");
+  release(texture);
+  ASSERT_TRUE(loggedWarnings.empty());
+
+  release(texture);
+  ASSERT_EQ(loggedWarnings.size(), 1);
+  ASSERT_NE(loggedWarnings[0].find("Ignoring release"), std::string::npos);
+  ASSERT_EQ(getTextTexture("ab")->referenceCount, 0);
+  ASSERT_EQ(renderer->numUnreferencedTextTextures, 1)
+      << "the texture must not be released twice into the cache";
+}
+
+TEST_F(ShovelerTextTextureRendererTest, uploadFontAtlasOnlyWithNewGlyphs) {
+  release(render("ab"));
+
+  shovelerOpenGLRecorderResetStats(recorder);
+  ASSERT_FALSE(shovelerFontAtlasTextureUpdate(fontAtlasTexture));
+  ASSERT_EQ(recorder->stats.numBytesUploaded, 0) << "an unchanged atlas should not be uploaded";
+
+  shovelerFontAtlasGetGlyph(fontAtlas, 'c');
+  shovelerFontAtlasTextureUpdate(fontAtlasTexture);
+  ASSERT_GT(recorder->stats.numBytesUploaded, 0) << "added glyphs should be uploaded";
+}
+
+TEST_F(ShovelerTextTextureRendererTest, shareGlyphRunBuilderOfFontAtlas) {
+  ShovelerGlyphRunBuilder* builder = fontAtlasTexture->glyphRunBuilder;
+  release(render("ab"));
+
+  ASSERT_EQ(shovelerMaterialTextGetGlyphRunBuilder(renderer->textMaterial), builder);
+  ASSERT_EQ(fontAtlasTexture->glyphRunBuilder, builder) << "the builder should never be recreated";
+}
+
+TEST_F(ShovelerTextTextureRendererTest, keepBatchOfSharedGlyphRunBuilder) {
+  ShovelerGlyphRunBuilder* builder = fontAtlasTexture->glyphRunBuilder;
+  shovelerGlyphRunBuilderClear(builder);
+  shovelerGlyphRunBuilderAdd(
+      builder,
+      "abc",
+      /* origin */ shovelerVector2(0.0f, 0.0f),
+      /* size */ 1.0f,
+      /* color */ shovelerVector4(1.0f, 1.0f, 1.0f, 1.0f));
+
+  shovelerTextTextureRendererGetLayout(renderer, "de");
+  release(render("fg"));
+
+  ASSERT_EQ(builder->runs->len, 1) << "rendering must not clear batches of callers";
+  ASSERT_EQ(shovelerGlyphRunBuilderGetRun(builder, 0)->numCodePoints, 3);
+}
+
+static void logMessage(const char* file, int line, ShovelerLogLevel level, const char* message) {
+  if (level == SHOVELER_LOG_LEVEL_WARNING) {
+    loggedWarnings.push_back(message);
+  }
+}
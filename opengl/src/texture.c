@@ -8,8 +8,11 @@
 #include "shoveler/log.h"
 #include "shoveler/opengl.h"
 
+static void bindTextureForUpdate(ShovelerTexture* texture);
 static int getNumMipmapLevels(int width, int height);
 
+static unsigned int bindingGeneration = 0;
+
 ShovelerTexture* shovelerTextureCreate2d(ShovelerImage* image, bool manageImage) {
   assert(image->channels >= 1);
   assert(image->channels <= 4);
@@ -22,7 +25,7 @@ ShovelerTexture* shovelerTextureCreate2d(ShovelerImage* image, bool manageImage)
   texture->manageImage = manageImage;
   texture->target = GL_TEXTURE_2D;
   glGenTextures(1, &texture->texture);
-  glBindTexture(texture->target, texture->texture);
+  bindTextureForUpdate(texture);
 
   switch (image->channels) {
   case 1:
@@ -72,7 +75,7 @@ ShovelerTexture* shovelerTextureCreateRenderTarget(
   texture->image = NULL;
   texture->target = samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
   glGenTextures(1, &texture->texture);
-  glBindTexture(texture->target, texture->texture);
+  bindTextureForUpdate(texture);
 
   if (bitsPerChannel == 8) {
     if (channels == 1) {
@@ -137,7 +140,7 @@ ShovelerTexture* shovelerTextureCreateDepthTarget(
   texture->image = NULL;
   texture->target = samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
   glGenTextures(1, &texture->texture);
-  glBindTexture(texture->target, texture->texture);
+  bindTextureForUpdate(texture);
 
   texture->internalFormat = GL_DEPTH_COMPONENT32F;
   texture->format = GL_DEPTH_COMPONENT;
@@ -157,7 +160,7 @@ bool shovelerTextureUpdate(ShovelerTexture* texture) {
     return false;
   }
 
-  glBindTexture(texture->target, texture->texture);
+  bindTextureForUpdate(texture);
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
   glTexSubImage2D(
       texture->target,
@@ -173,6 +176,50 @@ bool shovelerTextureUpdate(ShovelerTexture* texture) {
   return shovelerOpenGLCheckSuccess();
 }
 
+bool shovelerTextureUpdateRegion(
+    ShovelerTexture* texture,
+    unsigned int x,
+    unsigned int y,
+    unsigned int width,
+    unsigned int height) {
+  if (texture->image == NULL) {
+    return false;
+  }
+
+  assert(x + width <= texture->width);
+  assert(y + height <= texture->height);
+
+  if (width == 0 || height == 0) {
+    return true;
+  }
+
+  // Rows of the region are strided by the full image width, which GL_UNPACK_ROW_LENGTH tells the
+  // driver so that the region can be uploaded straight from the image without repacking it.
+  bindTextureForUpdate(texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, texture->width);
+  glTexSubImage2D(
+      texture->target,
+      0,
+      x,
+      y,
+      width,
+      height,
+      texture->format,
+      GL_UNSIGNED_BYTE,
+      &shovelerImageGet(texture->image, x, y, 0));
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  return shovelerOpenGLCheckSuccess();
+}
+
+bool shovelerTextureUpdateMipmaps(ShovelerTexture* texture) {
+  bindTextureForUpdate(texture);
+  glGenerateMipmap(texture->target);
+  return shovelerOpenGLCheckSuccess();
+}
+
+unsigned int shovelerTextureGetBindingGeneration() { return bindingGeneration; }
+
 bool shovelerTextureUse(ShovelerTexture* texture, GLuint unitIndex) {
   glActiveTexture(GL_TEXTURE0 + unitIndex);
   glBindTexture(texture->target, texture->texture);
@@ -188,10 +235,18 @@ void shovelerTextureFree(ShovelerTexture* texture) {
     shovelerImageFree(texture->image);
   }
 
+  // the texture name could be reused by a new texture, which isn't bound to the units it was
+  bindingGeneration++;
   glDeleteTextures(1, &texture->texture);
   free(texture);
 }
 
+/** Binds a texture to whichever unit is active, which invalidates bindings tracked by callers. */
+static void bindTextureForUpdate(ShovelerTexture* texture) {
+  bindingGeneration++;
+  glBindTexture(texture->target, texture->texture);
+}
+
 static int getNumMipmapLevels(int width, int height) {
   return floor(log2(fmax(width, height))) + 1;
 }
@@ -1,9 +1,11 @@
 #include "shoveler/material/tilemap.h"
 
+#include <math.h> // floorf, fmaxf, fminf
 #include <stdlib.h> // malloc, free
 #include <string.h> // memmove
 
 #include "shoveler/camera.h"
+#include "shoveler/collider.h"
 #include "shoveler/light.h"
 #include "shoveler/log.h"
 #include "shoveler/material.h"
@@ -69,6 +71,70 @@ bool shovelerTilemapIntersect(
   return false;
 }
 
+bool shovelerTilemapSweep(
+    ShovelerTilemap* tilemap,
+    const ShovelerBoundingBox2* boundingBox,
+    const ShovelerBoundingBox2* object,
+    ShovelerVector2 displacement,
+    float* outputTime,
+    ShovelerVector2* outputNormal) {
+  if (tilemap->collidingTiles == NULL) {
+    return false;
+  }
+
+  ShovelerVector2 size =
+      shovelerVector2LinearCombination(1.0f, boundingBox->max, -1.0f, boundingBox->min);
+
+  int numColumns = (int) tilemap->tiles->width;
+  int numRows = (int) tilemap->tiles->height;
+
+  float columnStride = size.values[0] / numColumns;
+  float rowStride = size.values[1] / numRows;
+
+  // only visit the tiles covered by the swept object instead of the whole tilemap
+  ShovelerBoundingBox2 sweptObject = shovelerBoundingBox2Swept(object, displacement);
+  if (!shovelerBoundingBox2Intersect(boundingBox, &sweptObject)) {
+    return false;
+  }
+
+  ShovelerVector2 sweptMin =
+      shovelerVector2LinearCombination(1.0f, sweptObject.min, -1.0f, boundingBox->min);
+  ShovelerVector2 sweptMax =
+      shovelerVector2LinearCombination(1.0f, sweptObject.max, -1.0f, boundingBox->min);
+  int minColumn = (int) fmaxf(floorf(sweptMin.values[0] / columnStride), 0.0f);
+  int maxColumn = (int) fminf(floorf(sweptMax.values[0] / columnStride), numColumns - 1);
+  int minRow = (int) fmaxf(floorf(sweptMin.values[1] / rowStride), 0.0f);
+  int maxRow = (int) fminf(floorf(sweptMax.values[1] / rowStride), numRows - 1);
+
+  bool hit = false;
+  for (int row = minRow; row <= maxRow; row++) {
+    float rowCoordinate = boundingBox->min.values[1] + row * rowStride;
+
+    for (int column = minColumn; column <= maxColumn; column++) {
+      if (!tilemap->collidingTiles[row * numColumns + column]) {
+        continue;
+      }
+
+      float columnCoordinate = boundingBox->min.values[0] + column * columnStride;
+
+      ShovelerBoundingBox2 tileBoundingBox = shovelerBoundingBox2(
+          shovelerVector2(columnCoordinate, rowCoordinate),
+          shovelerVector2(columnCoordinate + columnStride, rowCoordinate + rowStride));
+
+      float time;
+      ShovelerVector2 normal;
+      if (shovelerBoundingBox2Sweep(object, displacement, &tileBoundingBox, &time, &normal) &&
+          (!hit || shovelerCollider2ContactPrecedes(time, normal, *outputTime, *outputNormal))) {
+        hit = true;
+        *outputTime = time;
+        *outputNormal = normal;
+      }
+    }
+  }
+
+  return hit;
+}
+
 bool shovelerTilemapRender(
     ShovelerTilemap* tilemap,
     ShovelerVector2 regionPosition,
@@ -76,3 +76,22 @@ TEST_F(ShovelerTilemapTest, disableThenIntersect) {
   bool intersects = shovelerTilemapIntersect(tilemap, &boundingBox, &noLongerIntersectingBox);
   ASSERT_FALSE(intersects);
 }
+
+TEST_F(ShovelerTilemapTest, sweep) {
+  ShovelerBoundingBox2 object =
+      shovelerBoundingBox2(shovelerVector2(2.5f, 1.2f), shovelerVector2(3.5f, 1.8f));
+  float time;
+  ShovelerVector2 normal;
+  bool hit = shovelerTilemapSweep(
+      tilemap, &boundingBox, &object, shovelerVector2(-5.0f, 0.0f), &time, &normal);
+  ASSERT_TRUE(hit);
+  ASSERT_FLOAT_EQ(time, 0.1f);
+  ASSERT_EQ(normal.values[0], 1.0f);
+  ASSERT_EQ(normal.values[1], 0.0f);
+
+  ShovelerBoundingBox2 missingObject =
+      shovelerBoundingBox2(shovelerVector2(2.5f, 2.5f), shovelerVector2(3.5f, 3.5f));
+  bool missingHit = shovelerTilemapSweep(
+      tilemap, &boundingBox, &missingObject, shovelerVector2(4.0f, 0.0f), &time, &normal);
+  ASSERT_FALSE(missingHit);
+}
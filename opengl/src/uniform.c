@@ -1,10 +1,28 @@
 #include "shoveler/uniform.h"
 
+#include <assert.h> // assert
 #include <stdlib.h> // malloc, free
+#include <string.h> // memcmp, memset
 
 #include "shoveler/log.h"
 #include "shoveler/opengl.h"
 
+static bool useTexture(
+    ShovelerUniform* uniform,
+    GLint location,
+    GLuint textureUnitIndex,
+    ShovelerUniformTextureBindings* textureBindings,
+    ShovelerUniformUploadStats* stats);
+static void resolveValue(
+    const ShovelerUniform* uniform,
+    GLuint textureUnitIndex,
+    ShovelerUniformType* outputType,
+    ShovelerUniformValue* outputValue);
+static bool valuesEqual(
+    ShovelerUniformType type,
+    const ShovelerUniformValue* first,
+    const ShovelerUniformValue* second);
+
 ShovelerUniform* shovelerUniformCreateBool(bool value) {
   ShovelerUniform* uniform = malloc(sizeof(ShovelerUniform));
   uniform->type = SHOVELER_UNIFORM_TYPE_BOOL;
@@ -141,113 +159,277 @@ ShovelerUniform* shovelerUniformCopy(const ShovelerUniform* uniform) {
   return newUniform;
 }
 
+void shovelerUniformTextureBindingsReset(ShovelerUniformTextureBindings* textureBindings) {
+  textureBindings->textureBindingGeneration = shovelerTextureGetBindingGeneration();
+  textureBindings->samplerBindingGeneration = shovelerSamplerGetBindingGeneration();
+  memset(textureBindings->textures, 0, sizeof(textureBindings->textures));
+  memset(textureBindings->samplers, 0, sizeof(textureBindings->samplers));
+}
+
 bool shovelerUniformUse(ShovelerUniform* uniform, GLint location, GLuint* textureUnitIndexCounter) {
+  return shovelerUniformUseCached(
+      uniform,
+      location,
+      textureUnitIndexCounter,
+      /* uploadedValue */ NULL,
+      /* textureBindings */ NULL,
+      /* stats */ NULL);
+}
+
+bool shovelerUniformUseCached(
+    ShovelerUniform* uniform,
+    GLint location,
+    GLuint* textureUnitIndexCounter,
+    ShovelerUniformUploadedValue* uploadedValue,
+    ShovelerUniformTextureBindings* textureBindings,
+    ShovelerUniformUploadStats* stats) {
+  GLuint textureUnitIndex = 0;
+  if (uniform->type == SHOVELER_UNIFORM_TYPE_TEXTURE ||
+      uniform->type == SHOVELER_UNIFORM_TYPE_TEXTURE_POINTER) {
+    textureUnitIndex = (*textureUnitIndexCounter)++;
+    if (!useTexture(uniform, location, textureUnitIndex, textureBindings, stats)) {
+      return false;
+    }
+  }
+
+  ShovelerUniformType type;
+  ShovelerUniformValue value;
+  resolveValue(uniform, textureUnitIndex, &type, &value);
+
+  if (uploadedValue != NULL && uploadedValue->valid && uploadedValue->type == type &&
+      valuesEqual(type, &uploadedValue->value, &value)) {
+    if (stats != NULL) {
+      stats->numSkippedUploads++;
+    }
+    return true;
+  }
+
+  switch (type) {
+  case SHOVELER_UNIFORM_TYPE_INT:
+    glUniform1i(location, value.intValue);
+    break;
+  case SHOVELER_UNIFORM_TYPE_UNSIGNED_INT:
+    glUniform1ui(location, value.unsignedIntValue);
+    break;
+  case SHOVELER_UNIFORM_TYPE_FLOAT:
+    glUniform1f(location, value.floatValue);
+    break;
+  case SHOVELER_UNIFORM_TYPE_VECTOR2:
+    glUniform2fv(location, 1, value.vector2Value.values);
+    break;
+  case SHOVELER_UNIFORM_TYPE_VECTOR3:
+    glUniform3fv(location, 1, value.vector3Value.values);
+    break;
+  case SHOVELER_UNIFORM_TYPE_VECTOR4:
+    glUniform4fv(location, 1, value.vector4Value.values);
+    break;
+  case SHOVELER_UNIFORM_TYPE_MATRIX:
+    glUniformMatrix4fv(location, 1, GL_TRUE, value.matrixValue.values);
+    break;
+  default:
+    assert(false);
+    break;
+  }
+
+  if (stats != NULL) {
+    stats->numUploads++;
+  }
+
+  if (!shovelerOpenGLCheckSuccess()) {
+    if (uploadedValue != NULL) {
+      uploadedValue->valid = false;
+    }
+    return false;
+  }
+
+  if (uploadedValue != NULL) {
+    uploadedValue->valid = true;
+    uploadedValue->type = type;
+    uploadedValue->value = value;
+  }
+
+  return true;
+}
+
+void shovelerUniformFree(ShovelerUniform* uniform) { free(uniform); }
+
+static bool useTexture(
+    ShovelerUniform* uniform,
+    GLint location,
+    GLuint textureUnitIndex,
+    ShovelerUniformTextureBindings* textureBindings,
+    ShovelerUniformUploadStats* stats) {
+  ShovelerTexture* texture;
+  ShovelerSampler* sampler;
+  if (uniform->type == SHOVELER_UNIFORM_TYPE_TEXTURE) {
+    texture = uniform->value.textureValue.texture;
+    sampler = uniform->value.textureValue.sampler;
+  } else {
+    texture = *uniform->value.texturePointerValue.texturePointer;
+    sampler = *uniform->value.texturePointerValue.samplerPointer;
+  }
+
+  if (textureUnitIndex >= SHOVELER_UNIFORM_MAX_TEXTURE_UNITS) {
+    textureBindings = NULL;
+  }
+
+  if (textureBindings != NULL) {
+    if (textureBindings->textureBindingGeneration != shovelerTextureGetBindingGeneration() ||
+        textureBindings->samplerBindingGeneration != shovelerSamplerGetBindingGeneration()) {
+      shovelerUniformTextureBindingsReset(textureBindings);
+    }
+
+    if (textureBindings->textures[textureUnitIndex] == texture->texture &&
+        textureBindings->samplers[textureUnitIndex] == sampler->sampler) {
+      if (stats != NULL) {
+        stats->numSkippedTextureBinds++;
+      }
+      return true;
+    }
+
+    // forget the previous binding in case binding the new one fails halfway
+    textureBindings->textures[textureUnitIndex] = 0;
+    textureBindings->samplers[textureUnitIndex] = 0;
+  }
+
+  if (!shovelerTextureUse(texture, textureUnitIndex)) {
+    shovelerLogError(
+        "Failed to use texture %p at unit index %d when trying to use texture uniform %p at "
+        "location %d.",
+        texture,
+        textureUnitIndex,
+        uniform,
+        location);
+    return false;
+  }
+
+  if (!shovelerSamplerUse(sampler, textureUnitIndex)) {
+    shovelerLogError(
+        "Failed to use sampler %p at unit index %d when trying to use texture uniform %p at "
+        "location %d.",
+        sampler,
+        textureUnitIndex,
+        uniform,
+        location);
+    return false;
+  }
+
+  if (stats != NULL) {
+    stats->numTextureBinds++;
+  }
+
+  if (textureBindings != NULL) {
+    textureBindings->textures[textureUnitIndex] = texture->texture;
+    textureBindings->samplers[textureUnitIndex] = sampler->sampler;
+  }
+
+  return true;
+}
+
+/** Resolves a uniform into the type and value actually passed to glUniform. */
+static void resolveValue(
+    const ShovelerUniform* uniform,
+    GLuint textureUnitIndex,
+    ShovelerUniformType* outputType,
+    ShovelerUniformValue* outputValue) {
   switch (uniform->type) {
   case SHOVELER_UNIFORM_TYPE_BOOL:
-    glUniform1i(location, uniform->value.boolValue ? 1 : 0);
+    *outputType = SHOVELER_UNIFORM_TYPE_INT;
+    outputValue->intValue = uniform->value.boolValue ? 1 : 0;
     break;
   case SHOVELER_UNIFORM_TYPE_BOOL_POINTER:
-    glUniform1i(location, *uniform->value.boolPointerValue ? 1 : 0);
+    *outputType = SHOVELER_UNIFORM_TYPE_INT;
+    outputValue->intValue = *uniform->value.boolPointerValue ? 1 : 0;
     break;
   case SHOVELER_UNIFORM_TYPE_INT:
-    glUniform1i(location, uniform->value.intValue);
+    *outputType = SHOVELER_UNIFORM_TYPE_INT;
+    outputValue->intValue = uniform->value.intValue;
     break;
   case SHOVELER_UNIFORM_TYPE_INT_POINTER:
-    glUniform1i(location, *uniform->value.intPointerValue);
+    *outputType = SHOVELER_UNIFORM_TYPE_INT;
+    outputValue->intValue = *uniform->value.intPointerValue;
     break;
   case SHOVELER_UNIFORM_TYPE_UNSIGNED_INT:
-    glUniform1ui(location, uniform->value.unsignedIntValue);
+    *outputType = SHOVELER_UNIFORM_TYPE_UNSIGNED_INT;
+    outputValue->unsignedIntValue = uniform->value.unsignedIntValue;
     break;
   case SHOVELER_UNIFORM_TYPE_UNSIGNED_INT_POINTER:
-    glUniform1ui(location, *uniform->value.unsignedIntPointerValue);
+    *outputType = SHOVELER_UNIFORM_TYPE_UNSIGNED_INT;
+    outputValue->unsignedIntValue = *uniform->value.unsignedIntPointerValue;
     break;
   case SHOVELER_UNIFORM_TYPE_FLOAT:
-    glUniform1f(location, uniform->value.floatValue);
+    *outputType = SHOVELER_UNIFORM_TYPE_FLOAT;
+    outputValue->floatValue = uniform->value.floatValue;
     break;
   case SHOVELER_UNIFORM_TYPE_FLOAT_POINTER:
-    glUniform1f(location, *uniform->value.floatPointerValue);
+    *outputType = SHOVELER_UNIFORM_TYPE_FLOAT;
+    outputValue->floatValue = *uniform->value.floatPointerValue;
     break;
   case SHOVELER_UNIFORM_TYPE_VECTOR2:
-    glUniform2fv(location, 1, uniform->value.vector2Value.values);
+    *outputType = SHOVELER_UNIFORM_TYPE_VECTOR2;
+    outputValue->vector2Value = uniform->value.vector2Value;
     break;
   case SHOVELER_UNIFORM_TYPE_VECTOR2_POINTER:
-    glUniform2fv(location, 1, uniform->value.vector2PointerValue->values);
+    *outputType = SHOVELER_UNIFORM_TYPE_VECTOR2;
+    outputValue->vector2Value = *uniform->value.vector2PointerValue;
     break;
   case SHOVELER_UNIFORM_TYPE_VECTOR3:
-    glUniform3fv(location, 1, uniform->value.vector3Value.values);
+    *outputType = SHOVELER_UNIFORM_TYPE_VECTOR3;
+    outputValue->vector3Value = uniform->value.vector3Value;
     break;
   case SHOVELER_UNIFORM_TYPE_VECTOR3_POINTER:
-    glUniform3fv(location, 1, uniform->value.vector3PointerValue->values);
+    *outputType = SHOVELER_UNIFORM_TYPE_VECTOR3;
+    outputValue->vector3Value = *uniform->value.vector3PointerValue;
     break;
   case SHOVELER_UNIFORM_TYPE_VECTOR4:
-    glUniform4fv(location, 1, uniform->value.vector4Value.values);
+    *outputType = SHOVELER_UNIFORM_TYPE_VECTOR4;
+    outputValue->vector4Value = uniform->value.vector4Value;
     break;
   case SHOVELER_UNIFORM_TYPE_VECTOR4_POINTER:
-    glUniform4fv(location, 1, uniform->value.vector4PointerValue->values);
+    *outputType = SHOVELER_UNIFORM_TYPE_VECTOR4;
+    outputValue->vector4Value = *uniform->value.vector4PointerValue;
     break;
   case SHOVELER_UNIFORM_TYPE_MATRIX:
-    glUniformMatrix4fv(location, 1, GL_TRUE, uniform->value.matrixValue.values);
+    *outputType = SHOVELER_UNIFORM_TYPE_MATRIX;
+    outputValue->matrixValue = uniform->value.matrixValue;
     break;
   case SHOVELER_UNIFORM_TYPE_MATRIX_POINTER:
-    glUniformMatrix4fv(location, 1, GL_TRUE, uniform->value.matrixPointerValue->values);
-    break;
-  case SHOVELER_UNIFORM_TYPE_TEXTURE: {
-    GLuint textureUnitIndex = (*textureUnitIndexCounter)++;
-
-    if (!shovelerTextureUse(uniform->value.textureValue.texture, textureUnitIndex)) {
-      shovelerLogError(
-          "Failed to use texture %p at unit index %d when trying to use texture uniform %d at "
-          "location %d.",
-          uniform->value.textureValue.texture,
-          textureUnitIndex,
-          uniform,
-          location);
-      return false;
-    }
-
-    if (!shovelerSamplerUse(uniform->value.textureValue.sampler, textureUnitIndex)) {
-      shovelerLogError(
-          "Failed to use sampler %p at unit index %d when trying to use texture uniform %d at "
-          "location %d.",
-          uniform->value.textureValue.sampler,
-          textureUnitIndex,
-          uniform,
-          location);
-      return false;
-    }
-
-    glUniform1i(location, textureUnitIndex);
-  } break;
-  case SHOVELER_UNIFORM_TYPE_TEXTURE_POINTER: {
-    GLuint textureUnitIndex = (*textureUnitIndexCounter)++;
-
-    if (!shovelerTextureUse(*uniform->value.texturePointerValue.texturePointer, textureUnitIndex)) {
-      shovelerLogError(
-          "Failed to use texture pointer %p at unit index %d when trying to use texture pointer "
-          "uniform %d at location %d.",
-          uniform->value.texturePointerValue.texturePointer,
-          textureUnitIndex,
-          uniform,
-          location);
-      return false;
-    }
-
-    if (!shovelerSamplerUse(*uniform->value.texturePointerValue.samplerPointer, textureUnitIndex)) {
-      shovelerLogError(
-          "Failed to use sampler pointer %p at unit index %d when trying to use texture pointer "
-          "uniform %d at location %d.",
-          uniform->value.texturePointerValue.samplerPointer,
-          textureUnitIndex,
-          uniform,
-          location);
-      return false;
-    }
-
-    glUniform1i(location, textureUnitIndex);
-  } break;
+    *outputType = SHOVELER_UNIFORM_TYPE_MATRIX;
+    outputValue->matrixValue = *uniform->value.matrixPointerValue;
+    break;
+  case SHOVELER_UNIFORM_TYPE_TEXTURE:
+  case SHOVELER_UNIFORM_TYPE_TEXTURE_POINTER:
+    *outputType = SHOVELER_UNIFORM_TYPE_INT;
+    outputValue->intValue = (int) textureUnitIndex;
+    break;
+  default:
+    assert(false);
+    *outputType = uniform->type;
+    *outputValue = uniform->value;
+    break;
   }
-
-  return shovelerOpenGLCheckSuccess();
 }
 
-void shovelerUniformFree(ShovelerUniform* uniform) { free(uniform); }
+static bool valuesEqual(
+    ShovelerUniformType type,
+    const ShovelerUniformValue* first,
+    const ShovelerUniformValue* second) {
+  switch (type) {
+  case SHOVELER_UNIFORM_TYPE_INT:
+    return first->intValue == second->intValue;
+  case SHOVELER_UNIFORM_TYPE_UNSIGNED_INT:
+    return first->unsignedIntValue == second->unsignedIntValue;
+  case SHOVELER_UNIFORM_TYPE_FLOAT:
+    return memcmp(&first->floatValue, &second->floatValue, sizeof(float)) == 0;
+  case SHOVELER_UNIFORM_TYPE_VECTOR2:
+    return memcmp(&first->vector2Value, &second->vector2Value, sizeof(ShovelerVector2)) == 0;
+  case SHOVELER_UNIFORM_TYPE_VECTOR3:
+    return memcmp(&first->vector3Value, &second->vector3Value, sizeof(ShovelerVector3)) == 0;
+  case SHOVELER_UNIFORM_TYPE_VECTOR4:
+    return memcmp(&first->vector4Value, &second->vector4Value, sizeof(ShovelerVector4)) == 0;
+  case SHOVELER_UNIFORM_TYPE_MATRIX:
+    return memcmp(&first->matrixValue, &second->matrixValue, sizeof(ShovelerMatrix)) == 0;
+  default:
+    return false;
+  }
+}
@@ -1,22 +1,24 @@
 #include "shoveler/uniform_attachment.h"
 
 #include <stdbool.h> // bool
-#include <stdlib.h> // malloc, free
-
-ShovelerUniformAttachment* shovelerUniformAttachmentCreate(
-    ShovelerUniform* uniform, GLint location) {
-  ShovelerUniformAttachment* uniformAttachment = malloc(sizeof(ShovelerUniformAttachment));
-  uniformAttachment->uniform = uniform;
-  uniformAttachment->location = location;
-  return uniformAttachment;
-}
 
 bool shovelerUniformAttachmentUse(
-    ShovelerUniformAttachment* uniformAttachment, GLuint* textureUnitIndexCounter) {
-  return shovelerUniformUse(
-      uniformAttachment->uniform, uniformAttachment->location, textureUnitIndexCounter);
-}
+    const ShovelerUniformAttachment* uniformAttachment,
+    GLuint* textureUnitIndexCounter,
+    GArray* uploadedValues,
+    ShovelerUniformTextureBindings* textureBindings,
+    ShovelerUniformUploadStats* stats) {
+  ShovelerUniformUploadedValue* uploadedValue = NULL;
+  if (uploadedValues != NULL && (guint) uniformAttachment->location < uploadedValues->len) {
+    uploadedValue = &g_array_index(
+        uploadedValues, ShovelerUniformUploadedValue, uniformAttachment->location);
+  }
 
-void shovelerUniformAttachmentFree(ShovelerUniformAttachment* uniformAttachment) {
-  free(uniformAttachment);
+  return shovelerUniformUseCached(
+      uniformAttachment->uniform,
+      uniformAttachment->location,
+      textureUnitIndexCounter,
+      uploadedValue,
+      textureBindings,
+      stats);
 }
@@ -27,6 +27,28 @@ bool shovelerUniformMapRemove(ShovelerUniformMap* uniformMap, const char* name)
   return g_hash_table_remove(uniformMap->uniforms, name);
 }
 
+GLuint shovelerUniformMapGetTexture(ShovelerUniformMap* uniformMap) {
+  GLuint minTexture = 0;
+
+  GHashTableIter iter;
+  ShovelerUniform* uniform;
+  g_hash_table_iter_init(&iter, uniformMap->uniforms);
+  while (g_hash_table_iter_next(&iter, NULL, (gpointer*) &uniform)) {
+    ShovelerTexture* texture = NULL;
+    if (uniform->type == SHOVELER_UNIFORM_TYPE_TEXTURE) {
+      texture = uniform->value.textureValue.texture;
+    } else if (uniform->type == SHOVELER_UNIFORM_TYPE_TEXTURE_POINTER) {
+      texture = *uniform->value.texturePointerValue.texturePointer;
+    }
+
+    if (texture != NULL && (minTexture == 0 || texture->texture < minTexture)) {
+      minTexture = texture->texture;
+    }
+  }
+
+  return minTexture;
+}
+
 int shovelerUniformMapAttach(ShovelerUniformMap* uniformMap, ShovelerShader* shader) {
   int attached = 0;
 
@@ -23,6 +23,7 @@ typedef enum {
 typedef enum {
   SHOVELER_COMPONENT_IMAGE_FORMAT_PNG,
   SHOVELER_COMPONENT_IMAGE_FORMAT_PPM,
+  SHOVELER_COMPONENT_IMAGE_FORMAT_RAW,
 } ShovelerComponentImageFormat;
 
 typedef enum {
@@ -0,0 +1,157 @@
+#include <glib.h>
+#include <shoveler/image.h>
+#include <shoveler/image/png.h>
+#include <shoveler/image/raw.h>
+#include <shoveler/log.h>
+#include <shoveler/tiles/tileset.h>
+#include <stdlib.h> // EXIT_SUCCESS, EXIT_FAILURE, free
+
+#define NUM_ITERATIONS 20
+#define CHARACTER_SHIFT_AMOUNT 4
+
+typedef struct {
+  const char* name;
+  size_t size;
+  double encodeTimeMs;
+  double decodeTimeMs;
+} FormatResult;
+
+static FormatResult measurePng(ShovelerImage* image);
+static FormatResult measureRaw(
+    ShovelerImage* image, const char* name, ShovelerImageRawCompression compression, int level);
+static void logResult(const char* imageName, ShovelerImage* image, const FormatResult* result);
+
+/**
+ * Compares the formats tileset images can be shipped in, on the generated tileset and on the
+ * animation tilesets of the character PNG files passed as arguments.
+ */
+int main(int argc, char* argv[]) {
+  // decoders log every image they read, so only report once all measurements are done
+  shovelerLogInit("shoveler/", SHOVELER_LOG_LEVEL_WARNING_UP, stdout);
+
+  int numImages = 1 + (argc - 1);
+  ShovelerImage** images = malloc(numImages * sizeof(ShovelerImage*));
+  const char** imageNames = malloc(numImages * sizeof(const char*));
+
+  int tilesetColumns;
+  int tilesetRows;
+  shovelerTilesCreateTileset(&images[0], &tilesetColumns, &tilesetRows);
+  imageNames[0] = "generated tileset";
+
+  for (int i = 1; i < argc; i++) {
+    ShovelerImage* characterImage = shovelerImagePngReadFile(argv[i]);
+    if (characterImage == NULL) {
+      return EXIT_FAILURE;
+    }
+
+    images[i] = shovelerImageCreateAnimationTileset(characterImage, CHARACTER_SHIFT_AMOUNT);
+    imageNames[i] = argv[i];
+    shovelerImageFree(characterImage);
+  }
+
+  int numFormats = 4;
+  FormatResult* results = malloc(numImages * numFormats * sizeof(FormatResult));
+  for (int i = 0; i < numImages; i++) {
+    FormatResult* imageResults = &results[i * numFormats];
+    imageResults[0] = measurePng(images[i]);
+    imageResults[1] =
+        measureRaw(images[i], "raw", SHOVELER_IMAGE_RAW_COMPRESSION_NONE, /* level */ 0);
+    imageResults[2] =
+        measureRaw(images[i], "raw deflate 1", SHOVELER_IMAGE_RAW_COMPRESSION_DEFLATE, 1);
+    imageResults[3] =
+        measureRaw(images[i], "raw deflate 9", SHOVELER_IMAGE_RAW_COMPRESSION_DEFLATE, 9);
+  }
+
+  shovelerLogTerminate();
+  shovelerLogInit("shoveler/", SHOVELER_LOG_LEVEL_INFO_UP, stdout);
+
+  for (int i = 0; i < numImages; i++) {
+    for (int j = 0; j < numFormats; j++) {
+      logResult(imageNames[i], images[i], &results[i * numFormats + j]);
+    }
+    shovelerImageFree(images[i]);
+  }
+
+  free(results);
+  free(imageNames);
+  free(images);
+  shovelerLogTerminate();
+
+  return EXIT_SUCCESS;
+}
+
+/** Measures PNG encoded in memory, so that it is compared to the raw formats without disk I/O. */
+static FormatResult measurePng(ShovelerImage* image) {
+  GString* data = NULL;
+  gint64 startTime = g_get_monotonic_time();
+  for (int i = 0; i < NUM_ITERATIONS; i++) {
+    if (data != NULL) {
+      g_string_free(data, true);
+    }
+    data = g_string_new("");
+    shovelerImagePngWrite(image, data);
+  }
+  gint64 encodeTimeUs = g_get_monotonic_time() - startTime;
+
+  startTime = g_get_monotonic_time();
+  for (int i = 0; i < NUM_ITERATIONS; i++) {
+    ShovelerImage* decoded =
+        shovelerImagePngReadBuffer((const unsigned char*) data->str, (int) data->len);
+    shovelerImageFree(decoded);
+  }
+  gint64 decodeTimeUs = g_get_monotonic_time() - startTime;
+
+  FormatResult result;
+  result.name = "png";
+  result.size = data->len;
+  result.encodeTimeMs = (double) encodeTimeUs / NUM_ITERATIONS / 1000.0;
+  result.decodeTimeMs = (double) decodeTimeUs / NUM_ITERATIONS / 1000.0;
+
+  g_string_free(data, true);
+  return result;
+}
+
+static FormatResult measureRaw(
+    ShovelerImage* image, const char* name, ShovelerImageRawCompression compression, int level) {
+  // like the PNG measurement, every iteration allocates its own output
+  GString* data = NULL;
+  gint64 startTime = g_get_monotonic_time();
+  for (int i = 0; i < NUM_ITERATIONS; i++) {
+    if (data != NULL) {
+      g_string_free(data, true);
+    }
+    data = g_string_new("");
+    shovelerImageRawWrite(image, compression, level, data);
+  }
+  gint64 encodeTimeUs = g_get_monotonic_time() - startTime;
+
+  startTime = g_get_monotonic_time();
+  for (int i = 0; i < NUM_ITERATIONS; i++) {
+    ShovelerImage* decoded =
+        shovelerImageRawReadBuffer((const unsigned char*) data->str, (int) data->len);
+    shovelerImageFree(decoded);
+  }
+  gint64 decodeTimeUs = g_get_monotonic_time() - startTime;
+
+  FormatResult result;
+  result.name = name;
+  result.size = data->len;
+  result.encodeTimeMs = (double) encodeTimeUs / NUM_ITERATIONS / 1000.0;
+  result.decodeTimeMs = (double) decodeTimeUs / NUM_ITERATIONS / 1000.0;
+
+  g_string_free(data, true);
+  return result;
+}
+
+static void logResult(const char* imageName, ShovelerImage* image, const FormatResult* result) {
+  shovelerLogInfo(
+      "%s (%ux%u, %u channels) as %s: %zu bytes, encode %.3fms, decode %.3fms.",
+      imageName,
+      image->width,
+      image->height,
+      image->channels,
+      result->name,
+      result->size,
+      result->encodeTimeMs,
+      result->decodeTimeMs);
+}
@@ -4,8 +4,9 @@
 #include <string.h>
 
 #include "shoveler/entity_id_allocator.h"
-#include "shoveler/file.h"
 #include "shoveler/image/png.h"
+#include "shoveler/image/raw.h"
+#include "shoveler/log.h"
 #include "shoveler/map.h"
 #include "shoveler/schema/components.h"
 #include "shoveler/tiles/tileset.h"
@@ -55,7 +56,7 @@ ShovelerTilesSeeder shovelerTilesSeederInit(
     shovelerWorldEntityAddResourceComponent(
         entity, (const unsigned char*) imageData->str, (int) imageData->len);
     shovelerWorldEntityAddImageComponent(
-        entity, SHOVELER_COMPONENT_IMAGE_FORMAT_PNG, /* resource */ 0);
+        entity, SHOVELER_COMPONENT_IMAGE_FORMAT_RAW, /* resource */ 0);
     shovelerWorldEntityAddSamplerComponent(
         entity, /* interpolate */ true, /* useMipmaps */ false, /* clamp */ true);
     shovelerWorldEntityAddTextureImageComponent(entity, /* image */ 0);
@@ -68,15 +69,15 @@ ShovelerTilesSeeder shovelerTilesSeederInit(
   seeder.tilesetPngEntityId = shovelerEntityIdAllocatorAllocate(entityIdAllocator);
   { // tileset png
     ShovelerImage* tilesetPngImage = shovelerImagePngReadFile(tilesetPngFilename);
-    GString* tilesetPngData = getImageData(tilesetPngImage);
+    GString* tilesetRawData = getImageData(tilesetPngImage);
     shovelerImageFree(tilesetPngImage);
 
     ShovelerWorldEntity* entity = shovelerWorldAddEntity(world, seeder.tilesetPngEntityId);
     entity->label = strdup("tileset");
     shovelerWorldEntityAddResourceComponent(
-        entity, (const unsigned char*) tilesetPngData->str, (int) tilesetPngData->len);
+        entity, (const unsigned char*) tilesetRawData->str, (int) tilesetRawData->len);
     shovelerWorldEntityAddImageComponent(
-        entity, SHOVELER_COMPONENT_IMAGE_FORMAT_PNG, /* resourceEntityId */ 0);
+        entity, SHOVELER_COMPONENT_IMAGE_FORMAT_RAW, /* resourceEntityId */ 0);
     shovelerWorldEntityAddSamplerComponent(
         entity,
         /* interpolate */ true,
@@ -90,7 +91,7 @@ ShovelerTilesSeeder shovelerTilesSeederInit(
         tilesetPngRows,
         /* padding */ 1);
 
-    g_string_free(tilesetPngData, true);
+    g_string_free(tilesetRawData, true);
   }
 
   seeder.characterTilesetEntityIds[0] = addCharacterAnimationTilesetEntity(
@@ -276,17 +277,15 @@ void shovelerTilesSeederSpawnPlayer(ShovelerTilesSeeder* seeder, ShovelerVector2
 }
 
 static GString* getImageData(ShovelerImage* image) {
-  const char* tempImageFilename = "temp.png";
-  shovelerImagePngWriteFile(image, tempImageFilename);
-
-  unsigned char* contents;
-  size_t contentsSize;
-  shovelerFileRead(tempImageFilename, &contents, &contentsSize);
-
+  // Raw images inflate straight into the image on clients, which is much cheaper than PNG decoding.
   GString* data = g_string_new("");
-  g_string_append_len(data, (gchar*) contents, (gssize) contentsSize);
-  free(contents);
-
+  if (!shovelerImageRawWrite(image, SHOVELER_IMAGE_RAW_COMPRESSION_DEFLATE, /* level */ 9, data)) {
+    shovelerLogError(
+        "Failed to encode %ux%u image with %u channels as raw image data.",
+        image->width,
+        image->height,
+        image->channels);
+  }
   return data;
 }
 
@@ -298,7 +297,7 @@ static long long int addCharacterAnimationTilesetEntity(
   ShovelerImage* characterPngImage = shovelerImagePngReadFile(filename);
   ShovelerImage* characterAnimationTilesetImage =
       shovelerImageCreateAnimationTileset(characterPngImage, shiftAmount);
-  GString* characterAnimationTilesetPngData = getImageData(characterAnimationTilesetImage);
+  GString* characterAnimationTilesetRawData = getImageData(characterAnimationTilesetImage);
   shovelerImageFree(characterPngImage);
   shovelerImageFree(characterAnimationTilesetImage);
 
@@ -307,10 +306,10 @@ static long long int addCharacterAnimationTilesetEntity(
   entity->label = strdup("tileset");
   shovelerWorldEntityAddResourceComponent(
       entity,
-      (const unsigned char*) characterAnimationTilesetPngData->str,
-      (int) characterAnimationTilesetPngData->len);
+      (const unsigned char*) characterAnimationTilesetRawData->str,
+      (int) characterAnimationTilesetRawData->len);
   shovelerWorldEntityAddImageComponent(
-      entity, SHOVELER_COMPONENT_IMAGE_FORMAT_PNG, /* resourceEntityId */ 0);
+      entity, SHOVELER_COMPONENT_IMAGE_FORMAT_RAW, /* resourceEntityId */ 0);
   shovelerWorldEntityAddSamplerComponent(
       entity,
       /* interpolate */ true,
@@ -324,7 +323,7 @@ static long long int addCharacterAnimationTilesetEntity(
       /* rows */ 3,
       /* padding */ 1);
 
-  g_string_free(characterAnimationTilesetPngData, true);
+  g_string_free(characterAnimationTilesetRawData, true);
 
   return tilesetEntityId;
 }